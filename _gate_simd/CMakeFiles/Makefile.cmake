@@ -0,0 +1,87 @@
+# CMAKE generated file: DO NOT EDIT!
+# Generated by "Unix Makefiles" Generator, CMake Version 3.25
+
+# The generator used is:
+set(CMAKE_DEPENDS_GENERATOR "Unix Makefiles")
+
+# The top level Makefile was generated from the following files:
+set(CMAKE_MAKEFILE_DEPENDS
+  "CMakeCache.txt"
+  "/root/repo/CMakeLists.txt"
+  "CMakeFiles/3.25.1/CMakeCCompiler.cmake"
+  "CMakeFiles/3.25.1/CMakeCXXCompiler.cmake"
+  "CMakeFiles/3.25.1/CMakeSystem.cmake"
+  "/root/repo/libs/CMakeLists.txt"
+  "/root/repo/libs/v8/CMakeLists.txt"
+  "/root/repo/libs/v8/base/CMakeLists.txt"
+  "/root/repo/libs/v8/math/CMakeLists.txt"
+  "/root/repo/libs/v8/utility/CMakeLists.txt"
+  "/root/repo/sample_projects/CMakeLists.txt"
+  "/root/repo/sample_projects/benchmarks/CMakeLists.txt"
+  "/root/repo/sample_projects/julia_fractal/CMakeLists.txt"
+  "/usr/share/cmake-3.25/Modules/BundleUtilities.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCXXInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeCommonLanguageInclude.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeGenericSystem.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeInitializeConfigs.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeLanguageInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInformation.cmake"
+  "/usr/share/cmake-3.25/Modules/CMakeSystemSpecificInitialize.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/CMakeCommonCompilerMacros.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU-C.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Compiler/GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/GetPrerequisites.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU-C.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU-CXX.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux-GNU.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/Linux.cmake"
+  "/usr/share/cmake-3.25/Modules/Platform/UnixPaths.cmake"
+  )
+
+# The corresponding makefile is:
+set(CMAKE_MAKEFILE_OUTPUTS
+  "Makefile"
+  "CMakeFiles/cmake.check_cache"
+  )
+
+# Byproducts of CMake generate step:
+set(CMAKE_MAKEFILE_PRODUCTS
+  "CMakeFiles/CMakeDirectoryInformation.cmake"
+  "libs/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "libs/v8/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "libs/v8/base/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "libs/v8/math/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "libs/v8/utility/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "sample_projects/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "sample_projects/benchmarks/CMakeFiles/CMakeDirectoryInformation.cmake"
+  "sample_projects/julia_fractal/CMakeFiles/CMakeDirectoryInformation.cmake"
+  )
+
+# Dependency information for all targets:
+set(CMAKE_DEPEND_INFO_FILES
+  "libs/v8/base/CMakeFiles/v8_base.dir/DependInfo.cmake"
+  "libs/v8/math/CMakeFiles/v8_math.dir/DependInfo.cmake"
+  "libs/v8/utility/CMakeFiles/v8_utility.dir/DependInfo.cmake"
+  "sample_projects/benchmarks/CMakeFiles/aabb_tree_benchmark.dir/DependInfo.cmake"
+  "sample_projects/benchmarks/CMakeFiles/ifs_load_benchmark.dir/DependInfo.cmake"
+  "sample_projects/benchmarks/CMakeFiles/transform_hierarchy_benchmark.dir/DependInfo.cmake"
+  "sample_projects/benchmarks/CMakeFiles/mesh_closest_point_benchmark.dir/DependInfo.cmake"
+  "sample_projects/benchmarks/CMakeFiles/sweep_and_prune_benchmark.dir/DependInfo.cmake"
+  "sample_projects/benchmarks/CMakeFiles/matrix4X4_simd_benchmark.dir/DependInfo.cmake"
+  "sample_projects/benchmarks/CMakeFiles/radix_sort_benchmark.dir/DependInfo.cmake"
+  "sample_projects/benchmarks/CMakeFiles/job_system_benchmark.dir/DependInfo.cmake"
+  "sample_projects/benchmarks/CMakeFiles/random_benchmark.dir/DependInfo.cmake"
+  "sample_projects/benchmarks/CMakeFiles/geosphere_benchmark.dir/DependInfo.cmake"
+  "sample_projects/benchmarks/CMakeFiles/mesh_normals_benchmark.dir/DependInfo.cmake"
+  "sample_projects/benchmarks/CMakeFiles/transform_batch_benchmark.dir/DependInfo.cmake"
+  "sample_projects/benchmarks/CMakeFiles/quaternion_batch_benchmark.dir/DependInfo.cmake"
+  "sample_projects/benchmarks/CMakeFiles/dense_matrix_benchmark.dir/DependInfo.cmake"
+  "sample_projects/benchmarks/CMakeFiles/mesh_bvh_ray_benchmark.dir/DependInfo.cmake"
+  "sample_projects/benchmarks/CMakeFiles/bounding_sphere_benchmark.dir/DependInfo.cmake"
+  "sample_projects/benchmarks/CMakeFiles/color_batch_benchmark.dir/DependInfo.cmake"
+  "sample_projects/benchmarks/CMakeFiles/fractal_cpu_benchmark.dir/DependInfo.cmake"
+  "sample_projects/benchmarks/CMakeFiles/color_quantizer_benchmark.dir/DependInfo.cmake"
+  "sample_projects/julia_fractal/CMakeFiles/julia_fractal_cpu.dir/DependInfo.cmake"
+  )
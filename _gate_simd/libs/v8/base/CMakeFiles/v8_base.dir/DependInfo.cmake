@@ -0,0 +1,23 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/libs/v8/base/debug_helpers_posix.cc" "libs/v8/base/CMakeFiles/v8_base.dir/debug_helpers_posix.cc.o" "gcc" "libs/v8/base/CMakeFiles/v8_base.dir/debug_helpers_posix.cc.o.d"
+  "/root/repo/libs/v8/base/job_system.cc" "libs/v8/base/CMakeFiles/v8_base.dir/job_system.cc.o" "gcc" "libs/v8/base/CMakeFiles/v8_base.dir/job_system.cc.o.d"
+  "/root/repo/libs/v8/base/memory_mapped_file_posix.cc" "libs/v8/base/CMakeFiles/v8_base.dir/memory_mapped_file_posix.cc.o" "gcc" "libs/v8/base/CMakeFiles/v8_base.dir/memory_mapped_file_posix.cc.o.d"
+  "/root/repo/libs/v8/base/pch_hdr.cc" "libs/v8/base/CMakeFiles/v8_base.dir/pch_hdr.cc.o" "gcc" "libs/v8/base/CMakeFiles/v8_base.dir/pch_hdr.cc.o.d"
+  "/root/repo/libs/v8/base/ref_link_base.cc" "libs/v8/base/CMakeFiles/v8_base.dir/ref_link_base.cc.o" "gcc" "libs/v8/base/CMakeFiles/v8_base.dir/ref_link_base.cc.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,19 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/v8_base.dir/debug_helpers_posix.cc.o"
+  "CMakeFiles/v8_base.dir/debug_helpers_posix.cc.o.d"
+  "CMakeFiles/v8_base.dir/job_system.cc.o"
+  "CMakeFiles/v8_base.dir/job_system.cc.o.d"
+  "CMakeFiles/v8_base.dir/memory_mapped_file_posix.cc.o"
+  "CMakeFiles/v8_base.dir/memory_mapped_file_posix.cc.o.d"
+  "CMakeFiles/v8_base.dir/pch_hdr.cc.o"
+  "CMakeFiles/v8_base.dir/pch_hdr.cc.o.d"
+  "CMakeFiles/v8_base.dir/ref_link_base.cc.o"
+  "CMakeFiles/v8_base.dir/ref_link_base.cc.o.d"
+  "libv8_base.a"
+  "libv8_base.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/v8_base.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,41 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/libs/v8/math/aabb_tree.cc" "libs/v8/math/CMakeFiles/v8_math.dir/aabb_tree.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/aabb_tree.cc.o.d"
+  "/root/repo/libs/v8/math/camera.cc" "libs/v8/math/CMakeFiles/v8_math.dir/camera.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/camera.cc.o.d"
+  "/root/repo/libs/v8/math/color.cc" "libs/v8/math/CMakeFiles/v8_math.dir/color.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/color.cc.o.d"
+  "/root/repo/libs/v8/math/color_batch.cc" "libs/v8/math/CMakeFiles/v8_math.dir/color_batch.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/color_batch.cc.o.d"
+  "/root/repo/libs/v8/math/color_palette_generator.cc" "libs/v8/math/CMakeFiles/v8_math.dir/color_palette_generator.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/color_palette_generator.cc.o.d"
+  "/root/repo/libs/v8/math/color_quantizer.cc" "libs/v8/math/CMakeFiles/v8_math.dir/color_quantizer.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/color_quantizer.cc.o.d"
+  "/root/repo/libs/v8/math/containment_obb.cc" "libs/v8/math/CMakeFiles/v8_math.dir/containment_obb.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/containment_obb.cc.o.d"
+  "/root/repo/libs/v8/math/containment_sphere.cc" "libs/v8/math/CMakeFiles/v8_math.dir/containment_sphere.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/containment_sphere.cc.o.d"
+  "/root/repo/libs/v8/math/culler.cc" "libs/v8/math/CMakeFiles/v8_math.dir/culler.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/culler.cc.o.d"
+  "/root/repo/libs/v8/math/dense_kernels.cc" "libs/v8/math/CMakeFiles/v8_math.dir/dense_kernels.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/dense_kernels.cc.o.d"
+  "/root/repo/libs/v8/math/geometry_generators.cc" "libs/v8/math/CMakeFiles/v8_math.dir/geometry_generators.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/geometry_generators.cc.o.d"
+  "/root/repo/libs/v8/math/light.cc" "libs/v8/math/CMakeFiles/v8_math.dir/light.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/light.cc.o.d"
+  "/root/repo/libs/v8/math/mesh_bvh.cc" "libs/v8/math/CMakeFiles/v8_math.dir/mesh_bvh.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/mesh_bvh.cc.o.d"
+  "/root/repo/libs/v8/math/mesh_normals.cc" "libs/v8/math/CMakeFiles/v8_math.dir/mesh_normals.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/mesh_normals.cc.o.d"
+  "/root/repo/libs/v8/math/mesh_streams.cc" "libs/v8/math/CMakeFiles/v8_math.dir/mesh_streams.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/mesh_streams.cc.o.d"
+  "/root/repo/libs/v8/math/pch_hdr.cc" "libs/v8/math/CMakeFiles/v8_math.dir/pch_hdr.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/pch_hdr.cc.o.d"
+  "/root/repo/libs/v8/math/quaternion_batch.cc" "libs/v8/math/CMakeFiles/v8_math.dir/quaternion_batch.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/quaternion_batch.cc.o.d"
+  "/root/repo/libs/v8/math/random/mtrand.cpp" "libs/v8/math/CMakeFiles/v8_math.dir/random/mtrand.cpp.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/random/mtrand.cpp.o.d"
+  "/root/repo/libs/v8/math/random/random.cc" "libs/v8/math/CMakeFiles/v8_math.dir/random/random.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/random/random.cc.o.d"
+  "/root/repo/libs/v8/math/sweep_and_prune.cc" "libs/v8/math/CMakeFiles/v8_math.dir/sweep_and_prune.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/sweep_and_prune.cc.o.d"
+  "/root/repo/libs/v8/math/symmetric_eigen.cc" "libs/v8/math/CMakeFiles/v8_math.dir/symmetric_eigen.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/symmetric_eigen.cc.o.d"
+  "/root/repo/libs/v8/math/transform_batch.cc" "libs/v8/math/CMakeFiles/v8_math.dir/transform_batch.cc.o" "gcc" "libs/v8/math/CMakeFiles/v8_math.dir/transform_batch.cc.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_gate_simd/libs/v8/base/CMakeFiles/v8_base.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
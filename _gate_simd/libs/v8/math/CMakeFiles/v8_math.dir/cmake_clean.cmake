@@ -0,0 +1,53 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/v8_math.dir/aabb_tree.cc.o"
+  "CMakeFiles/v8_math.dir/aabb_tree.cc.o.d"
+  "CMakeFiles/v8_math.dir/camera.cc.o"
+  "CMakeFiles/v8_math.dir/camera.cc.o.d"
+  "CMakeFiles/v8_math.dir/color.cc.o"
+  "CMakeFiles/v8_math.dir/color.cc.o.d"
+  "CMakeFiles/v8_math.dir/color_batch.cc.o"
+  "CMakeFiles/v8_math.dir/color_batch.cc.o.d"
+  "CMakeFiles/v8_math.dir/color_palette_generator.cc.o"
+  "CMakeFiles/v8_math.dir/color_palette_generator.cc.o.d"
+  "CMakeFiles/v8_math.dir/color_quantizer.cc.o"
+  "CMakeFiles/v8_math.dir/color_quantizer.cc.o.d"
+  "CMakeFiles/v8_math.dir/containment_obb.cc.o"
+  "CMakeFiles/v8_math.dir/containment_obb.cc.o.d"
+  "CMakeFiles/v8_math.dir/containment_sphere.cc.o"
+  "CMakeFiles/v8_math.dir/containment_sphere.cc.o.d"
+  "CMakeFiles/v8_math.dir/culler.cc.o"
+  "CMakeFiles/v8_math.dir/culler.cc.o.d"
+  "CMakeFiles/v8_math.dir/dense_kernels.cc.o"
+  "CMakeFiles/v8_math.dir/dense_kernels.cc.o.d"
+  "CMakeFiles/v8_math.dir/geometry_generators.cc.o"
+  "CMakeFiles/v8_math.dir/geometry_generators.cc.o.d"
+  "CMakeFiles/v8_math.dir/light.cc.o"
+  "CMakeFiles/v8_math.dir/light.cc.o.d"
+  "CMakeFiles/v8_math.dir/mesh_bvh.cc.o"
+  "CMakeFiles/v8_math.dir/mesh_bvh.cc.o.d"
+  "CMakeFiles/v8_math.dir/mesh_normals.cc.o"
+  "CMakeFiles/v8_math.dir/mesh_normals.cc.o.d"
+  "CMakeFiles/v8_math.dir/mesh_streams.cc.o"
+  "CMakeFiles/v8_math.dir/mesh_streams.cc.o.d"
+  "CMakeFiles/v8_math.dir/pch_hdr.cc.o"
+  "CMakeFiles/v8_math.dir/pch_hdr.cc.o.d"
+  "CMakeFiles/v8_math.dir/quaternion_batch.cc.o"
+  "CMakeFiles/v8_math.dir/quaternion_batch.cc.o.d"
+  "CMakeFiles/v8_math.dir/random/mtrand.cpp.o"
+  "CMakeFiles/v8_math.dir/random/mtrand.cpp.o.d"
+  "CMakeFiles/v8_math.dir/random/random.cc.o"
+  "CMakeFiles/v8_math.dir/random/random.cc.o.d"
+  "CMakeFiles/v8_math.dir/sweep_and_prune.cc.o"
+  "CMakeFiles/v8_math.dir/sweep_and_prune.cc.o.d"
+  "CMakeFiles/v8_math.dir/symmetric_eigen.cc.o"
+  "CMakeFiles/v8_math.dir/symmetric_eigen.cc.o.d"
+  "CMakeFiles/v8_math.dir/transform_batch.cc.o"
+  "CMakeFiles/v8_math.dir/transform_batch.cc.o.d"
+  "libv8_math.a"
+  "libv8_math.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/v8_math.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,23 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/libs/v8/utility/hash_spooky.cc" "libs/v8/utility/CMakeFiles/v8_utility.dir/hash_spooky.cc.o" "gcc" "libs/v8/utility/CMakeFiles/v8_utility.dir/hash_spooky.cc.o.d"
+  "/root/repo/libs/v8/utility/ifs_loader.cc" "libs/v8/utility/CMakeFiles/v8_utility.dir/ifs_loader.cc.o" "gcc" "libs/v8/utility/CMakeFiles/v8_utility.dir/ifs_loader.cc.o.d"
+  "/root/repo/libs/v8/utility/string_ext.cc" "libs/v8/utility/CMakeFiles/v8_utility.dir/string_ext.cc.o" "gcc" "libs/v8/utility/CMakeFiles/v8_utility.dir/string_ext.cc.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_gate_simd/libs/v8/math/CMakeFiles/v8_math.dir/DependInfo.cmake"
+  "/root/repo/_gate_simd/libs/v8/base/CMakeFiles/v8_base.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,15 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/v8_utility.dir/hash_spooky.cc.o"
+  "CMakeFiles/v8_utility.dir/hash_spooky.cc.o.d"
+  "CMakeFiles/v8_utility.dir/ifs_loader.cc.o"
+  "CMakeFiles/v8_utility.dir/ifs_loader.cc.o.d"
+  "CMakeFiles/v8_utility.dir/string_ext.cc.o"
+  "CMakeFiles/v8_utility.dir/string_ext.cc.o.d"
+  "libv8_utility.a"
+  "libv8_utility.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/v8_utility.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,3 @@
+file(REMOVE_RECURSE
+  "libv8_utility.a"
+)
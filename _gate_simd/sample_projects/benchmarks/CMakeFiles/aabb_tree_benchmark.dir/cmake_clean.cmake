@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/aabb_tree_benchmark.dir/aabb_tree_benchmark.cc.o"
+  "CMakeFiles/aabb_tree_benchmark.dir/aabb_tree_benchmark.cc.o.d"
+  "aabb_tree_benchmark"
+  "aabb_tree_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/aabb_tree_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/bounding_sphere_benchmark.dir/bounding_sphere_benchmark.cc.o"
+  "CMakeFiles/bounding_sphere_benchmark.dir/bounding_sphere_benchmark.cc.o.d"
+  "bounding_sphere_benchmark"
+  "bounding_sphere_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/bounding_sphere_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
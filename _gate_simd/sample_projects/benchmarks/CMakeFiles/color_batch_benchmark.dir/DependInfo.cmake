@@ -0,0 +1,21 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/sample_projects/benchmarks/color_batch_benchmark.cc" "sample_projects/benchmarks/CMakeFiles/color_batch_benchmark.dir/color_batch_benchmark.cc.o" "gcc" "sample_projects/benchmarks/CMakeFiles/color_batch_benchmark.dir/color_batch_benchmark.cc.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_gate_simd/libs/v8/math/CMakeFiles/v8_math.dir/DependInfo.cmake"
+  "/root/repo/_gate_simd/libs/v8/base/CMakeFiles/v8_base.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/color_batch_benchmark.dir/color_batch_benchmark.cc.o"
+  "CMakeFiles/color_batch_benchmark.dir/color_batch_benchmark.cc.o.d"
+  "color_batch_benchmark"
+  "color_batch_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/color_batch_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
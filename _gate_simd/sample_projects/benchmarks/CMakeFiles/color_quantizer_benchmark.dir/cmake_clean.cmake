@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/color_quantizer_benchmark.dir/color_quantizer_benchmark.cc.o"
+  "CMakeFiles/color_quantizer_benchmark.dir/color_quantizer_benchmark.cc.o.d"
+  "color_quantizer_benchmark"
+  "color_quantizer_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/color_quantizer_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
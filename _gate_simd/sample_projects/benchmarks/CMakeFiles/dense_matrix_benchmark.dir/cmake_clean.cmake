@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/dense_matrix_benchmark.dir/dense_matrix_benchmark.cc.o"
+  "CMakeFiles/dense_matrix_benchmark.dir/dense_matrix_benchmark.cc.o.d"
+  "dense_matrix_benchmark"
+  "dense_matrix_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/dense_matrix_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/fractal_cpu_benchmark.dir/fractal_cpu_benchmark.cc.o"
+  "CMakeFiles/fractal_cpu_benchmark.dir/fractal_cpu_benchmark.cc.o.d"
+  "fractal_cpu_benchmark"
+  "fractal_cpu_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/fractal_cpu_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
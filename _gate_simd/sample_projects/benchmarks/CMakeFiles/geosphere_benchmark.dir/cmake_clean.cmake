@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/geosphere_benchmark.dir/geosphere_benchmark.cc.o"
+  "CMakeFiles/geosphere_benchmark.dir/geosphere_benchmark.cc.o.d"
+  "geosphere_benchmark"
+  "geosphere_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/geosphere_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
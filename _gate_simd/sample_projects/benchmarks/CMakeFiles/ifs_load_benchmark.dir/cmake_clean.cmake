@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/ifs_load_benchmark.dir/ifs_load_benchmark.cc.o"
+  "CMakeFiles/ifs_load_benchmark.dir/ifs_load_benchmark.cc.o.d"
+  "ifs_load_benchmark"
+  "ifs_load_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/ifs_load_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
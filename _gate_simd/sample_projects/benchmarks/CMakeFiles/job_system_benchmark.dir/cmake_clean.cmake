@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/job_system_benchmark.dir/job_system_benchmark.cc.o"
+  "CMakeFiles/job_system_benchmark.dir/job_system_benchmark.cc.o.d"
+  "job_system_benchmark"
+  "job_system_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/job_system_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/matrix4X4_simd_benchmark.dir/matrix4X4_simd_benchmark.cc.o"
+  "CMakeFiles/matrix4X4_simd_benchmark.dir/matrix4X4_simd_benchmark.cc.o.d"
+  "matrix4X4_simd_benchmark"
+  "matrix4X4_simd_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/matrix4X4_simd_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
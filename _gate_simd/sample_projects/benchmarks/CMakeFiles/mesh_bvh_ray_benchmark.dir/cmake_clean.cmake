@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/mesh_bvh_ray_benchmark.dir/mesh_bvh_ray_benchmark.cc.o"
+  "CMakeFiles/mesh_bvh_ray_benchmark.dir/mesh_bvh_ray_benchmark.cc.o.d"
+  "mesh_bvh_ray_benchmark"
+  "mesh_bvh_ray_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/mesh_bvh_ray_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
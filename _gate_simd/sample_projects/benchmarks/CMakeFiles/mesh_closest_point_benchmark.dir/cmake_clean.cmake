@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/mesh_closest_point_benchmark.dir/mesh_closest_point_benchmark.cc.o"
+  "CMakeFiles/mesh_closest_point_benchmark.dir/mesh_closest_point_benchmark.cc.o.d"
+  "mesh_closest_point_benchmark"
+  "mesh_closest_point_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/mesh_closest_point_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/mesh_normals_benchmark.dir/mesh_normals_benchmark.cc.o"
+  "CMakeFiles/mesh_normals_benchmark.dir/mesh_normals_benchmark.cc.o.d"
+  "mesh_normals_benchmark"
+  "mesh_normals_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/mesh_normals_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
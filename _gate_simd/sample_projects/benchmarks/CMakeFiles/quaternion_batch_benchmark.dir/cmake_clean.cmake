@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/quaternion_batch_benchmark.dir/quaternion_batch_benchmark.cc.o"
+  "CMakeFiles/quaternion_batch_benchmark.dir/quaternion_batch_benchmark.cc.o.d"
+  "quaternion_batch_benchmark"
+  "quaternion_batch_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/quaternion_batch_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/radix_sort_benchmark.dir/radix_sort_benchmark.cc.o"
+  "CMakeFiles/radix_sort_benchmark.dir/radix_sort_benchmark.cc.o.d"
+  "radix_sort_benchmark"
+  "radix_sort_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/radix_sort_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/random_benchmark.dir/random_benchmark.cc.o"
+  "CMakeFiles/random_benchmark.dir/random_benchmark.cc.o.d"
+  "random_benchmark"
+  "random_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/random_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
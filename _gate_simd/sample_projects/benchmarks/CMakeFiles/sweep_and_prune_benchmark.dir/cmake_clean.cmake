@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/sweep_and_prune_benchmark.dir/sweep_and_prune_benchmark.cc.o"
+  "CMakeFiles/sweep_and_prune_benchmark.dir/sweep_and_prune_benchmark.cc.o.d"
+  "sweep_and_prune_benchmark"
+  "sweep_and_prune_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/sweep_and_prune_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,11 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/transform_batch_benchmark.dir/transform_batch_benchmark.cc.o"
+  "CMakeFiles/transform_batch_benchmark.dir/transform_batch_benchmark.cc.o.d"
+  "transform_batch_benchmark"
+  "transform_batch_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/transform_batch_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
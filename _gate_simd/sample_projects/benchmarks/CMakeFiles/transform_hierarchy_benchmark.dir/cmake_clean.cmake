@@ -0,0 +1,13 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/transform_hierarchy_benchmark.dir/__/__/libs/v8/scene/transform_hierarchy.cc.o"
+  "CMakeFiles/transform_hierarchy_benchmark.dir/__/__/libs/v8/scene/transform_hierarchy.cc.o.d"
+  "CMakeFiles/transform_hierarchy_benchmark.dir/transform_hierarchy_benchmark.cc.o"
+  "CMakeFiles/transform_hierarchy_benchmark.dir/transform_hierarchy_benchmark.cc.o.d"
+  "transform_hierarchy_benchmark"
+  "transform_hierarchy_benchmark.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/transform_hierarchy_benchmark.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,23 @@
+
+# Consider dependencies only in project.
+set(CMAKE_DEPENDS_IN_PROJECT_ONLY OFF)
+
+# The set of languages for which implicit dependencies are needed:
+set(CMAKE_DEPENDS_LANGUAGES
+  )
+
+# The set of dependency files which are needed:
+set(CMAKE_DEPENDS_DEPENDENCY_FILES
+  "/root/repo/sample_projects/julia_fractal/fractal_cpu_renderer.cc" "sample_projects/julia_fractal/CMakeFiles/julia_fractal_cpu.dir/fractal_cpu_renderer.cc.o" "gcc" "sample_projects/julia_fractal/CMakeFiles/julia_fractal_cpu.dir/fractal_cpu_renderer.cc.o.d"
+  "/root/repo/sample_projects/julia_fractal/fractal_deep_zoom.cc" "sample_projects/julia_fractal/CMakeFiles/julia_fractal_cpu.dir/fractal_deep_zoom.cc.o" "gcc" "sample_projects/julia_fractal/CMakeFiles/julia_fractal_cpu.dir/fractal_deep_zoom.cc.o.d"
+  "/root/repo/sample_projects/julia_fractal/fractal_view_cache.cc" "sample_projects/julia_fractal/CMakeFiles/julia_fractal_cpu.dir/fractal_view_cache.cc.o" "gcc" "sample_projects/julia_fractal/CMakeFiles/julia_fractal_cpu.dir/fractal_view_cache.cc.o.d"
+  )
+
+# Targets to which this target links.
+set(CMAKE_TARGET_LINKED_INFO_FILES
+  "/root/repo/_gate_simd/libs/v8/math/CMakeFiles/v8_math.dir/DependInfo.cmake"
+  "/root/repo/_gate_simd/libs/v8/base/CMakeFiles/v8_base.dir/DependInfo.cmake"
+  )
+
+# Fortran module output directory.
+set(CMAKE_Fortran_TARGET_MODULE_DIR "")
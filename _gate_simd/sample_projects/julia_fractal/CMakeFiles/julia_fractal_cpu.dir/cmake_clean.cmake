@@ -0,0 +1,15 @@
+file(REMOVE_RECURSE
+  "CMakeFiles/julia_fractal_cpu.dir/fractal_cpu_renderer.cc.o"
+  "CMakeFiles/julia_fractal_cpu.dir/fractal_cpu_renderer.cc.o.d"
+  "CMakeFiles/julia_fractal_cpu.dir/fractal_deep_zoom.cc.o"
+  "CMakeFiles/julia_fractal_cpu.dir/fractal_deep_zoom.cc.o.d"
+  "CMakeFiles/julia_fractal_cpu.dir/fractal_view_cache.cc.o"
+  "CMakeFiles/julia_fractal_cpu.dir/fractal_view_cache.cc.o.d"
+  "libjulia_fractal_cpu.a"
+  "libjulia_fractal_cpu.pdb"
+)
+
+# Per-language clean rules from dependency scanning.
+foreach(lang CXX)
+  include(CMakeFiles/julia_fractal_cpu.dir/cmake_clean_${lang}.cmake OPTIONAL)
+endforeach()
@@ -0,0 +1,3 @@
+file(REMOVE_RECURSE
+  "libjulia_fractal_cpu.a"
+)
@@ -0,0 +1,239 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+/*!
+ * \file job_system.hpp
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <v8/v8.hpp>
+
+namespace v8 { namespace base {
+
+/*! \addtogroup synchronization
+ * @{
+ */
+
+/**
+ * \brief A job scheduler with a pool of worker threads and work stealing.
+ *      Every thread (the workers and the thread that owns the job system)
+ *      has a queue of jobs. A thread runs the jobs from its own queue, newest
+ *      first, and when it runs out of work it steals the oldest jobs from the
+ *      other queues.
+ *
+ *      Jobs support two kinds of relations :
+ *      - parent/child : a job is finished only after it has run and all of 
+ *        its children are finished. Children must be created before the 
+ *        parent finishes (eg: before the parent is submitted, or from within 
+ *        the parent's function).
+ *      - dependencies : a job is started only after all its dependencies
+ *        have finished (see add_dependency).
+ *
+ *      Waiting for a job (see wait) runs other jobs on the calling thread
+ *      until the job is finished, so waiting from inside a job is allowed.
+ * \remarks Job functions must not throw.
+ */
+class job_system {
+private :
+    struct job;
+
+public :
+
+    /**
+     * \brief Handle to a job. Handles can be freely copied and stay valid
+     *      after the job has finished.
+     */
+    typedef std::shared_ptr<job>        job_handle;
+
+    typedef std::function<void ()>      job_function;
+
+    /**
+     * \brief Creates the job system and starts the worker threads.
+     * \param worker_count Number of worker threads. If zero, one less than 
+     *      the number of hardware threads is used. The thread that creates
+     *      the job system also runs jobs, while waiting.
+     */
+    explicit job_system(v8_uint32_t worker_count = 0);
+
+    /**
+     * \brief Stops the worker threads. Jobs that were not started are not run.
+     */
+    ~job_system();
+
+    /**
+     * \brief Number of threads that run jobs (workers + owner thread).
+     */
+    v8_uint32_t get_thread_count() const {
+        return static_cast<v8_uint32_t>(queues_.size());
+    }
+
+    /**
+     * \brief Creates a job. The job does not run until it is submitted.
+     * \param fn Function to run.
+     * \param parent Optional parent job. The parent will not finish before 
+     *      this job finishes.
+     */
+    job_handle create_job(
+        const job_function& fn, 
+        const job_handle& parent = job_handle()
+        );
+
+    /**
+     * \brief Makes a job wait for another job to finish before starting.
+     *      Must be called before the job is submitted.
+     */
+    void add_dependency(const job_handle& job, const job_handle& prerequisite);
+
+    /**
+     * \brief Schedules a job for execution. The job runs as soon as all its
+     *      dependencies are finished.
+     */
+    void submit(const job_handle& job);
+
+    /**
+     * \brief Runs other jobs on the calling thread, until the specified job
+     *      is finished.
+     */
+    void wait(const job_handle& job);
+
+    /**
+     * \brief Returns true if the job (and all its children) has finished.
+     */
+    static bool is_finished(const job_handle& job);
+
+    /**
+     * \brief Splits the [first, last) range into chunks of at most 
+     *      grain_size elements and calls body(chunk_first, chunk_last) for 
+     *      each chunk, in parallel. Returns after all chunks have been 
+     *      processed.
+     */
+    template<typename range_function>
+    void parallel_for(
+        v8_size_t first, 
+        v8_size_t last, 
+        v8_size_t grain_size,
+        range_function body
+        );
+
+private :
+
+    struct job {
+        job_function                fn;
+        job_handle                  parent;
+        //! 1 for the job itself + 1 for each unfinished child.
+        std::atomic<v8_int32_t>     unfinished;
+        //! 1 until the job is submitted + 1 for each unfinished dependency.
+        std::atomic<v8_int32_t>     pending;
+        //! Jobs that depend on this one. Guarded by continuation_lock.
+        std::vector<job_handle>     continuations;
+        std::mutex                  continuation_lock;
+        bool                        finished;
+    };
+
+    struct job_queue {
+        std::deque<job_handle>      jobs;
+        std::mutex                  lock;
+    };
+
+    NO_CC_ASSIGN(job_system);
+
+    void worker_main(v8_uint32_t queue_index);
+
+    //! Index of the calling thread's queue (the owner's queue for threads 
+    //! that do not belong to this job system).
+    v8_uint32_t current_queue_index() const;
+
+    void enqueue(const job_handle& job);
+
+    job_handle get_job(v8_uint32_t queue_index);
+
+    void execute(const job_handle& job);
+
+    void finish(const job_handle& job);
+
+    std::vector<std::unique_ptr<job_queue>>     queues_;
+    std::vector<std::thread>                    workers_;
+    std::atomic<v8_int32_t>                     queued_jobs_;
+    std::atomic<bool>                           stop_;
+    std::mutex                                  wake_lock_;
+    std::condition_variable                     wake_event_;
+};
+
+/** @} */
+
+} // namespace base
+} // namespace v8
+
+template<typename range_function>
+void v8::base::job_system::parallel_for(
+    v8_size_t       first, 
+    v8_size_t       last, 
+    v8_size_t       grain_size,
+    range_function  body
+    ) {
+    if (first >= last) {
+        return;
+    }
+
+    if (!grain_size) {
+        grain_size = 1;
+    }
+
+    if (last - first <= grain_size) {
+        body(first, last);
+        return;
+    }
+
+    //
+    // The chunks are children of a root job, so waiting on the root waits 
+    // for all of them. The root is submitted last, since children can only
+    // be added to a job that has not finished.
+    job_handle root = create_job(job_function());
+
+    for (v8_size_t chunk_first = first; chunk_first < last; 
+         chunk_first += grain_size) {
+        const v8_size_t chunk_last = 
+            chunk_first + grain_size < last ? chunk_first + grain_size : last;
+
+        submit(create_job([&body, chunk_first, chunk_last]() {
+            body(chunk_first, chunk_last);
+        }, root));
+    }
+
+    submit(root);
+    wait(root);
+}
@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+/*!
+ * \file memory_mapped_file.hpp
+ * \brief Read only view of a file mapped into memory.
+ */
+
+#include <v8/v8.hpp>
+
+namespace v8 { namespace base {
+
+/*! \addtogroup v8_base_lib
+ * @{
+ */
+
+/**
+ * \brief   Maps a whole file, read only, into the address space of the 
+ *          process. Uses mmap() on POSIX systems and a file mapping object 
+ *          on Windows. The view stays valid until the object is destroyed.
+ *          An empty file or a file that could not be opened or mapped gives
+ *          an object with a null memory() pointer.
+ */
+class memory_mapped_file {
+public :
+    explicit memory_mapped_file(const char* file_name);
+
+    ~memory_mapped_file();
+
+    const void* memory() const NOEXCEPT {
+        return mapping_;
+    }
+
+    v8_size_t size() const NOEXCEPT {
+        return size_;
+    }
+
+private :
+    void*       mapping_;
+    v8_size_t   size_;
+
+private :
+    NO_CC_ASSIGN(memory_mapped_file);
+};
+
+/*! @} */
+
+} // namespace base
+} // namespace v8
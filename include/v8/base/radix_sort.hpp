@@ -0,0 +1,111 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <cassert>
+#include <cstring>
+
+#include <v8/v8.hpp>
+
+namespace v8 { namespace base {
+
+///
+/// \brief Sorts a range of elements in ascending order of their 64 bit keys,
+/// using a least significant digit radix sort (8 bits per pass).
+/// \param first Pointer to the first element.
+/// \param last Pointer to one past the last element.
+/// \param scratch Buffer with room for (last - first) elements, used to 
+/// ping-pong between passes.
+/// \param get_key Callable object that returns the v8_uint64_t key for an 
+/// element.
+/// \remarks The sort is stable. Passes for digits that are the same in all
+/// keys are skipped, so keys that only use some of the bits are cheaper to 
+/// sort. The sorted elements are always left in [first, last).
+/// Elements are copied with memcpy, so T must be a POD type.
+template<typename T, typename key_extractor>
+void radix_sort(T* first, T* last, T* scratch, key_extractor get_key) {
+    assert(first <= last);
+    const v8_size_t count = static_cast<v8_size_t>(last - first);
+    if (count < 2) {
+        return;
+    }
+
+    const v8_size_t k_digit_count = sizeof(v8_uint64_t);
+    const v8_size_t k_radix = 256;
+
+    //
+    // Histograms for all digits are built in a single pass over the input.
+    v8_size_t histograms[k_digit_count][k_radix];
+    memset(histograms, 0, sizeof(histograms));
+
+    for (v8_size_t i = 0; i < count; ++i) {
+        v8_uint64_t key = get_key(first[i]);
+        for (v8_size_t digit = 0; digit < k_digit_count; ++digit) {
+            ++histograms[digit][key & 0xFF];
+            key >>= 8;
+        }
+    }
+
+    T* src = first;
+    T* dst = scratch;
+
+    for (v8_size_t digit = 0; digit < k_digit_count; ++digit) {
+        v8_size_t* bucket_offsets = histograms[digit];
+
+        //
+        // All keys share this digit, the pass would not move anything.
+        const v8_size_t first_digit = (get_key(src[0]) >> (digit * 8)) & 0xFF;
+        if (bucket_offsets[first_digit] == count) {
+            continue;
+        }
+
+        v8_size_t offset = 0;
+        for (v8_size_t bucket = 0; bucket < k_radix; ++bucket) {
+            const v8_size_t bucket_count = bucket_offsets[bucket];
+            bucket_offsets[bucket] = offset;
+            offset += bucket_count;
+        }
+
+        for (v8_size_t i = 0; i < count; ++i) {
+            const v8_size_t bucket = 
+                (get_key(src[i]) >> (digit * 8)) & 0xFF;
+            memcpy(dst + bucket_offsets[bucket]++, src + i, sizeof(T));
+        }
+
+        T* tmp = src;
+        src = dst;
+        dst = tmp;
+    }
+
+    if (src != first) {
+        memcpy(first, src, count * sizeof(T));
+    }
+}
+
+} // namespace base
+} // namespace v8
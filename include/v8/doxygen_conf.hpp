@@ -31,3 +31,11 @@
 ///
 /// \defgroup   __grp_v8_base   Basic utilities.
 
+///
+/// \defgroup   __grp_v8_math_simd  Vectorized kernels and SIMD abstractions.
+
+///
+/// \defgroup   __grp_v8_math_spatial  Spatial indexing structures.
+
+///
+/// \defgroup   __grp_v8_math_mesh  Mesh processing utilities.
@@ -0,0 +1,157 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+/*!
+ * \file color_batch.hpp
+ * \brief Color space conversion of whole pixel buffers (planar or 
+ *      interleaved float, interleaved 8 bit RGBA).
+ */
+
+#include <v8/v8.hpp>
+
+namespace v8 { namespace base {
+class job_system;
+} // namespace base
+} // namespace v8
+
+namespace v8 { namespace math {
+
+/** \addtogroup __grp_v8_math_simd
+ *  @{
+ */
+
+/**
+ * \brief Color spaces understood by the batch conversion functions. The 
+ *        components and their ranges are those of the scalar conversion 
+ *        functions in color.hpp.
+ */
+enum Color_Space {
+    //! sRGB encoded red, green, blue in [0, 1] (like rgb_color).
+    Color_Space_Rgb,
+    //! Linear (decoded) red, green, blue in [0, 1].
+    Color_Space_Linear_Rgb,
+    //! Hue in degrees [0, 360), saturation, value (like color_hsv).
+    Color_Space_Hsv,
+    //! Hue in degrees [0, 360), lightness, saturation (like color_hls).
+    Color_Space_Hls,
+    //! CIE XYZ, computed from linear sRGB (like color_xyz).
+    Color_Space_Xyz,
+    //! CIE L*a*b*, L in [0, 1], relative to the D50 white (like color_lab).
+    Color_Space_Lab
+};
+
+/**
+ * \brief   Converts count colors stored as 4 consecutive floats (3 color
+ *          components followed by alpha, the layout of rgb_color).
+ * \param   src_space   Color space of the input.
+ * \param   src         Input colors.
+ * \param   dst_space   Color space of the output.
+ * \param   dst         Output colors; may be the same buffer as src.
+ * \param   jobs        Optional, when not null large buffers are split 
+ *                      across the threads of the job system.
+ * \remarks Alpha is copied unchanged. Hue is set to 
+ *          std::numeric_limits<float>::max() when it is undefined 
+ *          (achromatic colors), as by rgb_to_hsv() and rgb_to_hls().
+ *          Conversions to Rgb, Hsv or Hls from Linear_Rgb, Xyz or Lab clamp 
+ *          the linear components to [0, 1], as xyz_to_rgb() does.
+ *          The transfer functions and cube roots are evaluated with 
+ *          polynomial approximations. Measured against the scalar 
+ *          functions over random colors in [0, 1], the largest absolute 
+ *          difference is 5.0e-7 for Hsv/Hls -> Rgb (Rgb -> Hsv/Hls gives the
+ *          same results), 3.0e-7 for Xyz and 2.1e-6 for Lab.
+ */
+void convert_colors(
+    Color_Space         src_space,
+    const float*        src,
+    Color_Space         dst_space,
+    float*              dst,
+    v8_size_t           count,
+    base::job_system*   jobs = nullptr
+    );
+
+/**
+ * \brief   Converts count colors stored in three planes, one per component.
+ * \remarks See convert_colors(). The output planes may be the input planes.
+ */
+void convert_colors_planar(
+    Color_Space         src_space,
+    const float* const  src[3],
+    Color_Space         dst_space,
+    float* const        dst[3],
+    v8_size_t           count,
+    base::job_system*   jobs = nullptr
+    );
+
+/**
+ * \brief   Converts an image of sRGB encoded 8 bit pixels (bytes R, G, B, A
+ *          in memory order) to colors of 4 floats, in the layout of 
+ *          convert_colors().
+ * \param   src_pitch   Distance in bytes between two rows of src.
+ * \param   dst_pitch   Distance in bytes between two rows of dst.
+ * \param   jobs        Optional, when not null the rows of large images are 
+ *                      split across the threads of the job system.
+ * \remarks The 8 bit values are decoded with lookup tables.
+ */
+void convert_colors_from_rgba8(
+    const v8_uint8_t*   src,
+    v8_size_t           src_pitch,
+    Color_Space         dst_space,
+    float*              dst,
+    v8_size_t           dst_pitch,
+    v8_size_t           width,
+    v8_size_t           height,
+    base::job_system*   jobs = nullptr
+    );
+
+/**
+ * \brief   Converts an image of colors of 4 floats to sRGB encoded 8 bit 
+ *          pixels (bytes R, G, B, A in memory order). Components are 
+ *          clamped to [0, 1] and rounded to the nearest 8 bit value.
+ * \remarks See convert_colors_from_rgba8().
+ */
+void convert_colors_to_rgba8(
+    Color_Space         src_space,
+    const float*        src,
+    v8_size_t           src_pitch,
+    v8_uint8_t*         dst,
+    v8_size_t           dst_pitch,
+    v8_size_t           width,
+    v8_size_t           height,
+    base::job_system*   jobs = nullptr
+    );
+
+/**
+ * \brief Pixels per task, when a buffer is split across threads.
+ */
+const v8_size_t C_Color_Batch_Grain = 16384;
+
+/** @} */
+
+} // namespace math
+} // namespace v8
@@ -0,0 +1,164 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+/*!
+ * \file color_quantizer.hpp
+ * \brief Reduction of 8 bit RGBA images to small palettes (median cut 
+ *      seeding refined by k-means in CIE L*a*b*), for indexed textures and
+ *      color tables.
+ */
+
+#include <v8/v8.hpp>
+#include <v8/math/color.hpp>
+
+namespace v8 { namespace base {
+class job_system;
+} // namespace base
+} // namespace v8
+
+namespace v8 { namespace math {
+
+/** \addtogroup __grp_v8_math_simd
+ *  @{
+ */
+
+/**
+ * \brief How pixels are mapped to the palette.
+ */
+enum Dither_Mode {
+    //! Each pixel gets the palette entry nearest to its color.
+    Dither_Mode_None,
+    //! Floyd-Steinberg error diffusion, in serpentine order.
+    Dither_Mode_Floyd_Steinberg
+};
+
+/**
+ * \brief Largest palette, indices are stored in bytes.
+ */
+const v8_size_t C_Quantizer_Max_Colors = 256;
+
+/**
+ * \brief Default number of k-means passes run after the median cut.
+ */
+const v8_int32_t C_Quantizer_Refine_Passes = 8;
+
+/**
+ * \brief Rows of the bands that are dithered independently.
+ */
+const v8_size_t C_Quantizer_Dither_Rows = 128;
+
+/**
+ * \brief   Builds a palette of at most max_colors colors for an image of 
+ *          sRGB encoded 8 bit pixels (bytes R, G, B, A in memory order).
+ * \param   src_pitch       Distance in bytes between two rows of src.
+ * \param   max_colors      Palette size, at most C_Quantizer_Max_Colors.
+ * \param   palette         Receives the colors, max_colors entries.
+ * \param   refine_passes   Maximum number of k-means passes; the 
+ *                          refinement stops early once no color changes 
+ *                          cluster.
+ * \param   jobs            Optional, when not null the histogram and the 
+ *                          k-means assignments are split across the 
+ *                          threads of the job system.
+ * \returns Number of palette entries written; less than max_colors only
+ *          when the image has fewer distinct colors (histogram bins, see
+ *          below) than max_colors.
+ * \remarks The pixels are first binned in a histogram of 5 bits per 
+ *          channel; each bin stands for the mean color of its pixels, 
+ *          converted with rgb_to_lab(). The bins are split by median cut 
+ *          (the box with the largest squared error is cut at the weighted 
+ *          median of its widest axis) and the box means seed a weighted 
+ *          k-means. The distances are euclidean in L*a*b*. A cluster left 
+ *          empty by a pass is seeded again with the bin of largest 
+ *          weighted error (a different one for each empty cluster).
+ *          Alpha does not take part in the clustering, each entry gets the 
+ *          mean alpha of its pixels.
+ */
+v8_size_t build_color_palette(
+    const v8_uint8_t*   src,
+    v8_size_t           src_pitch,
+    v8_size_t           width,
+    v8_size_t           height,
+    v8_size_t           max_colors,
+    rgb_color*          palette,
+    v8_int32_t          refine_passes = C_Quantizer_Refine_Passes,
+    base::job_system*   jobs = nullptr
+    );
+
+/**
+ * \brief   Maps the pixels of an image to the nearest colors (in L*a*b*) of
+ *          a palette.
+ * \param   palette_size    Number of palette entries, in 
+ *                          [1, C_Quantizer_Max_Colors].
+ * \param   indices         Receives one palette index per pixel.
+ * \param   indices_pitch   Distance in bytes between two rows of indices.
+ * \param   jobs            Optional, when not null the lookup table and the
+ *                          rows of large images are split across the 
+ *                          threads of the job system.
+ * \remarks Colors are looked up in a table of 6 bits per channel, that 
+ *          holds the entry nearest to the center of each cell. Error 
+ *          diffusion is done on the 8 bit sRGB values, in bands of 
+ *          C_Quantizer_Dither_Rows rows that start without error, so the 
+ *          result does not depend on the number of threads. Alpha is 
+ *          ignored.
+ */
+void map_colors_to_palette(
+    const v8_uint8_t*   src,
+    v8_size_t           src_pitch,
+    v8_size_t           width,
+    v8_size_t           height,
+    const rgb_color*    palette,
+    v8_size_t           palette_size,
+    Dither_Mode         dither,
+    v8_uint8_t*         indices,
+    v8_size_t           indices_pitch,
+    base::job_system*   jobs = nullptr
+    );
+
+/**
+ * \brief   Builds a palette for an image (see build_color_palette()) and 
+ *          maps the image to it (see map_colors_to_palette()).
+ * \returns Number of palette entries.
+ */
+v8_size_t quantize_colors(
+    const v8_uint8_t*   src,
+    v8_size_t           src_pitch,
+    v8_size_t           width,
+    v8_size_t           height,
+    v8_size_t           max_colors,
+    Dither_Mode         dither,
+    rgb_color*          palette,
+    v8_uint8_t*         indices,
+    v8_size_t           indices_pitch,
+    base::job_system*   jobs = nullptr
+    );
+
+/** @} */
+
+} // namespace math
+} // namespace v8
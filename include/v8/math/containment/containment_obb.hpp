@@ -0,0 +1,129 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+/*!
+ * \file containment_obb.hpp
+ * \brief Oriented bounding boxes fitted to point sets.
+ */
+
+#include <cstddef>
+
+#include <v8/v8.hpp>
+#include <v8/math/vector3.hpp>
+#include <v8/math/objects/oriented_bounding_box.hpp>
+
+namespace v8 { namespace base {
+class job_system;
+} // namespace base
+} // namespace v8
+
+namespace v8 { namespace math {
+
+/** \addtogroup Containment
+ *  @{
+ */
+
+/**
+ * \brief How the axes of a fitted oriented bounding box are chosen.
+ */
+enum Obb_Fit_Mode {
+    /**
+     * The eigenvectors of the covariance matrix of the points (principal 
+     * component analysis). One pass over the points for the covariance, 
+     * one for the extents.
+     */
+    Obb_Fit_Covariance,
+
+    /**
+     * Starts from the covariance axes; for each of them, the points are 
+     * projected on the plane orthogonal to the axis and the minimum area 
+     * rectangle enclosing their 2D convex hull is found. The box with the 
+     * smallest volume is kept. Several times slower than 
+     * Obb_Fit_Covariance, but much tighter for shapes whose covariance 
+     * is a poor guide (boxes with uneven vertex density, nearly symmetric 
+     * shapes with repeated eigenvalues).
+     */
+    Obb_Fit_Hull_Refined
+};
+
+/**
+ * \brief   Computes an oriented bounding box for a set of points. The 
+ *          axes (vec_R_, vec_U_, vec_D_) are ordered by decreasing 
+ *          extent, with vec_R_ = vec_U_ x vec_D_; extents_ are the half 
+ *          widths along them and origin_ is the center of the box.
+ * \param   pt_set      Set of points.
+ * \param   pt_count    Number of points in the set. For an empty set, 
+ *                      the box is degenerate (zero extents, at the origin).
+ * \param   pt_stride   The point stride, in bytes.
+ * \param   obb         Receives the box. Must not be null.
+ * \param   jobs        Optional (can be null); large sets are reduced in 
+ *                      parallel.
+ */
+void obb_from_points(
+    const vector3F*             pt_set,
+    size_t                      pt_count,
+    size_t                      pt_stride,
+    oriented_bounding_box3F*    obb,
+    Obb_Fit_Mode                fit_mode = Obb_Fit_Covariance,
+    base::job_system*           jobs = nullptr
+    );
+
+/**
+ * \brief A point set, for obb_from_point_sets.
+ */
+struct obb_fit_input_t {
+    const vector3F*     ofi_points;
+    size_t              ofi_count;
+    /* Stride, in bytes. */
+    size_t              ofi_stride;
+};
+
+/**
+ * \brief   Fits an oriented bounding box to each set of points, as 
+ *          obb_from_points. Meant for many small sets (one per mesh of a 
+ *          scene) : the covariance matrices are computed first, then 
+ *          decomposed together with eigen_decompose_symmetric_batch, four 
+ *          at a time.
+ * \param   sets        Point sets.
+ * \param   set_count   Number of sets.
+ * \param   obbs        Receives set_count boxes.
+ * \param   jobs        Optional (can be null); distributes the sets.
+ */
+void obb_from_point_sets(
+    const obb_fit_input_t*      sets,
+    size_t                      set_count,
+    oriented_bounding_box3F*    obbs,
+    Obb_Fit_Mode                fit_mode = Obb_Fit_Covariance,
+    base::job_system*           jobs = nullptr
+    );
+
+/** @} */
+
+} // namespace math
+} // namespace v8
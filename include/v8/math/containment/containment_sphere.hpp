@@ -139,6 +139,69 @@ void sphere_from_points_by_average(
     bounding_sphere->radius_ = sqrt(radius_squared);
 }
 
+/**
+ * \brief   Single precision version of sphere_from_points_by_aabb; the box 
+ *          is computed with SIMD min/max reductions.
+ */
+void sphere_from_points_by_aabb(
+    const vector3F*         pt_set,
+    size_t                  pt_count,
+    size_t                  pt_stride,
+    sphereF*                bounding_sphere
+    );
+
+/**
+ * \brief   Single precision version of sphere_from_points_by_average; the 
+ *          sum and the farthest point are SIMD reductions.
+ */
+void sphere_from_points_by_average(
+    const vector3F*         pt_set,
+    size_t                  pt_count,
+    size_t                  pt_stride,
+    sphereF*                bounding_sphere
+    );
+
+/**
+ * \brief   Computes a near optimal bounding sphere (Ritter). The initial 
+ *          sphere has as diameter two points that are far apart (the 
+ *          point farthest from the first point and the point farthest 
+ *          from that one). The sphere is then grown, towards the point 
+ *          farthest from the center, until it contains all the points. 
+ *          Each step is a SIMD reduction over the points. The result is 
+ *          usually within a few percent of the minimum sphere.
+ * \param   pt_set                  Set of points.
+ * \param   pt_count                Number of points in the set.
+ * \param   pt_stride               The point stride, in bytes.
+ * \param [in,out]  bounding_sphere Pointer to a sphere object. Must not be null.
+ */
+void sphere_from_points_ritter(
+    const vector3F*         pt_set,
+    size_t                  pt_count,
+    size_t                  pt_stride,
+    sphereF*                bounding_sphere
+    );
+
+/**
+ * \brief   Computes the minimum enclosing sphere of a set of points. 
+ *          The exact sphere of a small subset of the points is computed 
+ *          with Welzl's algorithm, using the move to front heuristic; while 
+ *          some point lies outside, the farthest one (found by a SIMD 
+ *          reduction over all the points) is moved to the front of the 
+ *          subset. The subset rarely grows beyond a few dozen points.
+ * \param   pt_set                  Set of points.
+ * \param   pt_count                Number of points in the set.
+ * \param   pt_stride               The point stride, in bytes.
+ * \param [in,out]  bounding_sphere Pointer to a sphere object. Must not be null.
+ * \see     <b>Bernd Gartner, Fast and robust smallest enclosing balls 
+ *          (1999)</b>.
+ */
+void sphere_from_points_minimal(
+    const vector3F*         pt_set,
+    size_t                  pt_count,
+    size_t                  pt_stride,
+    sphereF*                bounding_sphere
+    );
+
 /**
  * \brief   Merges two spheres.
  * \param   s0              Reference to the first sphere.
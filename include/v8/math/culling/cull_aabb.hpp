@@ -93,6 +93,47 @@ inline bool cull_object(
     return P.which_side(vmax) == plane_t::Plane_Negative_Side;
 }
 
+/**
+ * \brief Classifies an axis aligned bounding box with respect to a plane.
+ * \param Classification plane.
+ * \param AABB to classify.
+ * \return Plane_Negative_Side if the AABB is entirely on the negative side of
+ *         the plane, Plane_Positive_Side if it is entirely on the positive
+ *         side and Plane_Contained if the plane intersects the AABB.
+ * \remarks Used by hierarchical culling. A node that is entirely on the 
+ *          positive side of a plane does not need to test its children
+ *          against that plane again.
+ */
+template<typename real_t>
+inline int classify_object(
+    const plane<real_t>& P,
+    const axis_aligned_bounding_box<real_t, Space_Tridimensional>& aabb) {
+
+    typedef plane<real_t> plane_t;
+
+    real_t dist_min = P.offset_;
+    real_t dist_max = P.offset_;
+
+    for (int i = 0; i < 3; ++i) {
+        const real_t n = P.normal_.elements_[i];
+        if (n >= real_t(0)) {
+            dist_min += n * aabb.min_point_.elements_[i];
+            dist_max += n * aabb.max_point_.elements_[i];
+        } else {
+            dist_min += n * aabb.max_point_.elements_[i];
+            dist_max += n * aabb.min_point_.elements_[i];
+        }
+    }
+
+    if (dist_max < real_t(0))
+        return plane_t::Plane_Negative_Side;
+
+    if (dist_min > real_t(0))
+        return plane_t::Plane_Positive_Side;
+
+    return plane_t::Plane_Contained;
+}
+
 /** @} */
 
 } // namespace math
@@ -26,6 +26,8 @@
 
 #pragma once
 
+#include <cmath>
+
 #include <v8/math/objects/oriented_bounding_box.hpp>
 #include <v8/math/objects/plane.hpp>
 
@@ -45,14 +47,13 @@ template<typename real_t>
 inline bool cull_object(
     const plane<real_t>& cull_plane,
     const oriented_bounding_box3<real_t>& obb) {
-    typedef plane<real_t> plane_t;
-
     const real_t r =
-            obb.extents_[0] * abs(dot_product(cull_plane.normal_, obb.vec_D_))
-            + obb.extents_[1] * abs(dot_product(cull_plane.normal_, obb.vec_R_))
-            + obb.extents_[2] * abs(dot_product(cull_plane.normal_, obb.vec_U_));
+            obb.extents_[0] * std::abs(dot_product(cull_plane.normal_, obb.vec_R_))
+            + obb.extents_[1] * std::abs(dot_product(cull_plane.normal_, obb.vec_U_))
+            + obb.extents_[2] * std::abs(dot_product(cull_plane.normal_, obb.vec_D_));
 
-    return (dot_product(obb.origin_, cull_plane.normal_) + r) < cull_plane.offset_;
+    return (dot_product(obb.origin_, cull_plane.normal_) + cull_plane.offset_ + r)
+           < real_t(0);
 }
 
 /** @} */
@@ -46,8 +46,8 @@ inline bool cull_object(
     const plane<real_t>& cull_plane,
     const sphere<real_t>& sph
     ) {
-    return (dot_product(cull_plane.normal_, sph.center_) + sph.radius_)
-            < cull_plane.offset_;
+    return (dot_product(cull_plane.normal_, sph.center_) + cull_plane.offset_)
+            < -sph.radius_;
 }
 
 /** @} */
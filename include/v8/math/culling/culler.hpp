@@ -41,6 +41,31 @@ class camera;
  *  @{
  */
 
+/**
+ * \brief A batch of bounding spheres, stored as a structure of arrays.
+ */
+struct bounding_sphere_soa_t {
+    const float*    bs_center_x;
+    const float*    bs_center_y;
+    const float*    bs_center_z;
+    const float*    bs_radius;
+    v8_size_t       bs_count;
+};
+
+/**
+ * \brief A batch of axis aligned bounding boxes, stored as a structure of 
+ *        arrays.
+ */
+struct bounding_box_soa_t {
+    const float*    bb_min_x;
+    const float*    bb_min_y;
+    const float*    bb_min_z;
+    const float*    bb_max_x;
+    const float*    bb_max_y;
+    const float*    bb_max_z;
+    v8_size_t       bb_count;
+};
+
 /**
  * \brief Supports culling of objects in relation to the view frustrum 
  *      and user defined culling planes. Before using this class, a camera
@@ -78,6 +103,12 @@ private :
 
 public :
 
+    /**
+     * \brief Value stored in a plane cache entry when no plane has culled
+     *        the object.
+     */
+    static const v8_uint8_t C_No_Cached_Plane = 0xFF;
+
     /**
      * \brief   Default constructor. Before using any object of this class,
      * 			make sure to call set_camera.
@@ -91,6 +122,60 @@ public :
      */
     bool cull(const bounded_volume* bound_object) const;
 
+    /**
+     * \brief   Culls a batch of spheres against all the active planes.
+     * \param   spheres         Sphere data.
+     * \param   plane_cache     Optional (can be null). One entry per sphere,
+     *                          holding the index of the last plane that culled
+     *                          it. That plane is tested first, so objects that
+     *                          stay culled between frames are rejected after 
+     *                          a single test. Initialize the entries to
+     *                          C_No_Cached_Plane before the first call.
+     * \param   visible_mask    Receives one bit per sphere (bit i % 32 of word
+     *                          i / 32), set if the sphere is visible. Must
+     *                          have room for (count + 31) / 32 words.
+     * \return  Number of visible spheres.
+     */
+    v8_size_t cull_spheres(
+        const bounding_sphere_soa_t&    spheres,
+        v8_uint8_t*                     plane_cache,
+        v8_uint32_t*                    visible_mask
+        ) const;
+
+    /**
+     * \brief   Culls a batch of axis aligned bounding boxes against all the 
+     *          active planes.
+     * \sa      cull_spheres
+     */
+    v8_size_t cull_boxes(
+        const bounding_box_soa_t&       boxes,
+        v8_uint8_t*                     plane_cache,
+        v8_uint32_t*                    visible_mask
+        ) const;
+
+    /**
+     * \brief   Converts a visibility mask produced by cull_spheres/cull_boxes
+     *          into a list with the indices of the visible objects.
+     * \param   visible_mask    Visibility mask.
+     * \param   count           Number of objects described by the mask.
+     * \param   visible_indices Receives the indices, in increasing order.
+     *                          Must have room for count entries.
+     * \return  Number of indices written.
+     */
+    static v8_size_t compact_visible_set(
+        const v8_uint32_t*  visible_mask,
+        v8_size_t           count,
+        v8_uint32_t*        visible_indices
+        );
+
+    /**
+     * \brief   Copies the active culling planes.
+     * \param   planes  Receives the planes. Must have room for 
+     *                  32 entries.
+     * \return  Number of planes copied.
+     */
+    v8_uint32_t get_active_planes(plane3F* planes) const;
+
     /**
      * \brief   Toggle a plane's state (active/inactive).
      * \param   plane_id    Identifier for the plane. Must be > 6.
@@ -0,0 +1,511 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+/*!
+ * \file dense_expr.hpp
+ * \brief Expression templates for the element wise arithmetic of vector_N 
+ *      and matrix_NxM. An expression like a + b * k - c is evaluated in a 
+ *      single loop, directly into its destination, without temporaries.
+ *
+ * \remarks The expressions keep pointers to the data of their operands, so 
+ *      they must be evaluated (assigned to a vector_N/matrix_NxM) before the 
+ *      operands are destroyed or resized. Do not store them in auto 
+ *      variables.
+ */
+
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+
+#include <v8/v8.hpp>
+#include <v8/base/fundamental_types.hpp>
+#include <v8/math/simd/float4.hpp>
+
+namespace v8 { namespace math {
+
+/** \addtogroup Algebra
+ *  @{
+ */
+
+/** \brief Shape of vector_N and of the expressions built from vectors. */
+struct dense_vector_tag {};
+
+/** \brief Shape of matrix_NxM and of the expressions built from matrices. */
+struct dense_matrix_tag {};
+
+/**
+ * \brief   Maps a type to the expression that reads it. Specialized for 
+ *          vector_N and matrix_NxM; expressions map to themselves. 
+ *          is_dense is false for every other type.
+ */
+template<typename T, typename = void>
+struct dense_traits {
+    enum { is_dense = false };
+};
+
+template<typename T>
+struct dense_traits<T, typename std::enable_if<T::is_dense_expr>::type> {
+    enum { is_dense = true };
+    typedef T                               expr_type;
+    typedef typename T::value_type          value_type;
+    typedef typename T::shape_tag           shape_tag;
+
+    static const expr_type& as_expr(const T& val) {
+        return val;
+    }
+};
+
+/**
+ * \brief   Reads the elements of a vector_N or matrix_NxM.
+ */
+template<typename real_t, typename tag>
+class dense_leaf {
+public :
+    enum { is_dense_expr = true };
+    typedef real_t      value_type;
+    typedef tag         shape_tag;
+
+    dense_leaf(const real_t* data, size_t rows, size_t columns)
+        : data_(data), rows_(rows), columns_(columns) {}
+
+    size_t rows() const { return rows_; }
+
+    size_t columns() const { return columns_; }
+
+    size_t size() const { return rows_ * columns_; }
+
+    real_t element(size_t idx) const { return data_[idx]; }
+
+    simd::float4_t packet(size_t idx) const { 
+        return simd::load_float4(data_ + idx); 
+    }
+
+private :
+    const real_t*   data_;
+    size_t          rows_;
+    size_t          columns_;
+};
+
+namespace internals {
+
+struct dense_op_add {
+    template<typename T>
+    static T apply(T lhs, T rhs) { return lhs + rhs; }
+
+    static simd::float4_t apply(simd::float4_t lhs, simd::float4_t rhs) {
+        return simd::add(lhs, rhs);
+    }
+};
+
+struct dense_op_sub {
+    template<typename T>
+    static T apply(T lhs, T rhs) { return lhs - rhs; }
+
+    static simd::float4_t apply(simd::float4_t lhs, simd::float4_t rhs) {
+        return simd::sub(lhs, rhs);
+    }
+};
+
+struct dense_op_mul {
+    template<typename T>
+    static T apply(T lhs, T rhs) { return lhs * rhs; }
+
+    static simd::float4_t apply(simd::float4_t lhs, simd::float4_t rhs) {
+        return simd::mul(lhs, rhs);
+    }
+};
+
+struct dense_op_div {
+    template<typename T>
+    static T apply(T lhs, T rhs) { return lhs / rhs; }
+
+    static simd::float4_t apply(simd::float4_t lhs, simd::float4_t rhs) {
+        return simd::div(lhs, rhs);
+    }
+};
+
+} // namespace internals
+
+/**
+ * \brief   Element wise operation between two expressions of the same shape
+ *          and size.
+ */
+template<typename op, typename lhs_expr, typename rhs_expr>
+class dense_binary {
+public :
+    enum { is_dense_expr = true };
+    typedef typename lhs_expr::value_type   value_type;
+    typedef typename lhs_expr::shape_tag    shape_tag;
+
+    dense_binary(const lhs_expr& lhs, const rhs_expr& rhs)
+        : lhs_(lhs), rhs_(rhs) {
+        assert(lhs.rows() == rhs.rows());
+        assert(lhs.columns() == rhs.columns());
+    }
+
+    size_t rows() const { return lhs_.rows(); }
+
+    size_t columns() const { return lhs_.columns(); }
+
+    size_t size() const { return lhs_.size(); }
+
+    value_type element(size_t idx) const {
+        return op::apply(lhs_.element(idx), rhs_.element(idx));
+    }
+
+    simd::float4_t packet(size_t idx) const {
+        return op::apply(lhs_.packet(idx), rhs_.packet(idx));
+    }
+
+private :
+    lhs_expr    lhs_;
+    rhs_expr    rhs_;
+};
+
+/**
+ * \brief   Operation between every element of an expression and a scalar.
+ */
+template<typename op, typename expr>
+class dense_scalar {
+public :
+    enum { is_dense_expr = true };
+    typedef typename expr::value_type   value_type;
+    typedef typename expr::shape_tag    shape_tag;
+
+    dense_scalar(const expr& e, value_type k) : expr_(e), k_(k) {}
+
+    size_t rows() const { return expr_.rows(); }
+
+    size_t columns() const { return expr_.columns(); }
+
+    size_t size() const { return expr_.size(); }
+
+    value_type element(size_t idx) const {
+        return op::apply(expr_.element(idx), k_);
+    }
+
+    simd::float4_t packet(size_t idx) const {
+        return op::apply(expr_.packet(idx), simd::splat_float4(k_));
+    }
+
+private :
+    expr        expr_;
+    value_type  k_;
+};
+
+/**
+ * \brief   Negates every element of an expression.
+ */
+template<typename expr>
+class dense_negate {
+public :
+    enum { is_dense_expr = true };
+    typedef typename expr::value_type   value_type;
+    typedef typename expr::shape_tag    shape_tag;
+
+    explicit dense_negate(const expr& e) : expr_(e) {}
+
+    size_t rows() const { return expr_.rows(); }
+
+    size_t columns() const { return expr_.columns(); }
+
+    size_t size() const { return expr_.size(); }
+
+    value_type element(size_t idx) const {
+        return -expr_.element(idx);
+    }
+
+    simd::float4_t packet(size_t idx) const {
+        return simd::negate(expr_.packet(idx));
+    }
+
+private :
+    expr    expr_;
+};
+
+namespace internals {
+
+template<typename T>
+struct is_dense {
+    enum { Yes = dense_traits<T>::is_dense };
+};
+
+template<typename L, typename R, typename = void>
+struct dense_pair {
+    enum { Yes = false };
+};
+
+template<typename L, typename R>
+struct dense_pair<L, R, typename std::enable_if<
+    is_dense<L>::Yes && is_dense<R>::Yes>::type> {
+    enum { 
+        Yes = base::types_eq<
+            typename dense_traits<L>::value_type, 
+            typename dense_traits<R>::value_type>::Yes
+            && base::types_eq<
+            typename dense_traits<L>::shape_tag, 
+            typename dense_traits<R>::shape_tag>::Yes
+    };
+};
+
+template<typename T, typename tag, bool = is_dense<T>::Yes>
+struct is_dense_shape {
+    enum { Yes = false };
+};
+
+template<typename T, typename tag>
+struct is_dense_shape<T, tag, true> {
+    enum { 
+        Yes = base::types_eq<typename dense_traits<T>::shape_tag, tag>::Yes 
+    };
+};
+
+//
+// Division by a scalar multiplies with the reciprocal for floating point
+// types, like div_helper.
+template<typename real_t, bool is_floating_point>
+struct dense_scalar_div {
+    typedef dense_op_div    op;
+
+    static real_t divisor(real_t k) { return k; }
+};
+
+template<typename real_t>
+struct dense_scalar_div<real_t, true> {
+    typedef dense_op_mul    op;
+
+    static real_t divisor(real_t k) { return real_t(1) / k; }
+};
+
+/**
+ * \brief   Evaluates an expression into an array of expr.size() elements. 
+ *          Float expressions are evaluated four elements at a time when 
+ *          V8_MATH_ENABLE_SIMD is defined.
+ */
+template<typename real_t, typename expr>
+inline void dense_evaluate(real_t* dst, const expr& e) {
+    const size_t count = e.size();
+    for (size_t i = 0; i < count; ++i)
+        dst[i] = e.element(i);
+}
+
+#if defined(V8_MATH_SIMD_ENABLED)
+
+template<typename expr>
+inline void dense_evaluate(float* dst, const expr& e) {
+    const size_t count = e.size();
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+        simd::store_float4(dst + i, e.packet(i));
+
+    for (; i < count; ++i)
+        dst[i] = e.element(i);
+}
+
+#endif /* V8_MATH_SIMD_ENABLED */
+
+/**
+ * \brief   Sum of lhs[i] * rhs[i].
+ */
+template<typename lhs_expr, typename rhs_expr>
+inline typename std::enable_if<
+#if defined(V8_MATH_SIMD_ENABLED)
+    !base::types_eq<typename lhs_expr::value_type, float>::Yes,
+#else
+    true,
+#endif
+    typename lhs_expr::value_type
+>::type
+dense_dot(const lhs_expr& lhs, const rhs_expr& rhs) {
+    typedef typename lhs_expr::value_type value_type;
+    assert(lhs.size() == rhs.size());
+
+    value_type sum = value_type(0);
+    const size_t count = lhs.size();
+    for (size_t i = 0; i < count; ++i)
+        sum += lhs.element(i) * rhs.element(i);
+    return sum;
+}
+
+#if defined(V8_MATH_SIMD_ENABLED)
+
+template<typename lhs_expr, typename rhs_expr>
+inline typename std::enable_if<
+    base::types_eq<typename lhs_expr::value_type, float>::Yes, float
+>::type
+dense_dot(const lhs_expr& lhs, const rhs_expr& rhs) {
+    using namespace simd;
+    assert(lhs.size() == rhs.size());
+
+    //
+    // Two accumulators, to hide the latency of the additions.
+    const size_t count = lhs.size();
+    float4_t acc0 = zero_float4();
+    float4_t acc1 = zero_float4();
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        acc0 = add(acc0, mul(lhs.packet(i), rhs.packet(i)));
+        acc1 = add(acc1, mul(lhs.packet(i + 4), rhs.packet(i + 4)));
+    }
+
+    for (; i + 4 <= count; i += 4)
+        acc0 = add(acc0, mul(lhs.packet(i), rhs.packet(i)));
+
+    const float4_t acc = add(acc0, acc1);
+    float sum = (extract_lane<0>(acc) + extract_lane<1>(acc)) 
+        + (extract_lane<2>(acc) + extract_lane<3>(acc));
+
+    for (; i < count; ++i)
+        sum += lhs.element(i) * rhs.element(i);
+    return sum;
+}
+
+#endif /* V8_MATH_SIMD_ENABLED */
+
+} // namespace internals
+
+/**
+ * \brief   Element wise sum of two vector or matrix expressions.
+ */
+template<typename L, typename R>
+inline typename std::enable_if<
+    internals::dense_pair<L, R>::Yes,
+    dense_binary<
+        internals::dense_op_add, 
+        typename dense_traits<L>::expr_type, 
+        typename dense_traits<R>::expr_type>
+>::type
+operator+(const L& lhs, const R& rhs) {
+    typedef dense_binary<
+        internals::dense_op_add, 
+        typename dense_traits<L>::expr_type, 
+        typename dense_traits<R>::expr_type> result_type;
+    return result_type(dense_traits<L>::as_expr(lhs), 
+                       dense_traits<R>::as_expr(rhs));
+}
+
+/**
+ * \brief   Element wise difference of two vector or matrix expressions.
+ */
+template<typename L, typename R>
+inline typename std::enable_if<
+    internals::dense_pair<L, R>::Yes,
+    dense_binary<
+        internals::dense_op_sub, 
+        typename dense_traits<L>::expr_type, 
+        typename dense_traits<R>::expr_type>
+>::type
+operator-(const L& lhs, const R& rhs) {
+    typedef dense_binary<
+        internals::dense_op_sub, 
+        typename dense_traits<L>::expr_type, 
+        typename dense_traits<R>::expr_type> result_type;
+    return result_type(dense_traits<L>::as_expr(lhs), 
+                       dense_traits<R>::as_expr(rhs));
+}
+
+/**
+ * \brief   Element wise (Hadamard) product of two vector expressions.
+ */
+template<typename L, typename R>
+inline typename std::enable_if<
+    internals::dense_pair<L, R>::Yes 
+        && internals::is_dense_shape<L, dense_vector_tag>::Yes,
+    dense_binary<
+        internals::dense_op_mul, 
+        typename dense_traits<L>::expr_type, 
+        typename dense_traits<R>::expr_type>
+>::type
+operator^(const L& lhs, const R& rhs) {
+    typedef dense_binary<
+        internals::dense_op_mul, 
+        typename dense_traits<L>::expr_type, 
+        typename dense_traits<R>::expr_type> result_type;
+    return result_type(dense_traits<L>::as_expr(lhs), 
+                       dense_traits<R>::as_expr(rhs));
+}
+
+template<typename E>
+inline typename std::enable_if<
+    internals::is_dense<E>::Yes,
+    dense_negate<typename dense_traits<E>::expr_type>
+>::type
+operator-(const E& e) {
+    return dense_negate<typename dense_traits<E>::expr_type>(
+        dense_traits<E>::as_expr(e));
+}
+
+template<typename E>
+inline typename std::enable_if<
+    internals::is_dense<E>::Yes,
+    dense_scalar<internals::dense_op_mul, typename dense_traits<E>::expr_type>
+>::type
+operator*(const E& e, typename dense_traits<E>::value_type k) {
+    return dense_scalar<
+        internals::dense_op_mul, typename dense_traits<E>::expr_type
+    >(dense_traits<E>::as_expr(e), k);
+}
+
+template<typename E>
+inline typename std::enable_if<
+    internals::is_dense<E>::Yes,
+    dense_scalar<internals::dense_op_mul, typename dense_traits<E>::expr_type>
+>::type
+operator*(typename dense_traits<E>::value_type k, const E& e) {
+    return e * k;
+}
+
+template<typename E>
+inline typename std::enable_if<
+    internals::is_dense<E>::Yes,
+    dense_scalar<
+        typename internals::dense_scalar_div<
+            typename dense_traits<E>::value_type,
+            base::is_floating_point_type<
+                typename dense_traits<E>::value_type>::Yes
+        >::op, 
+        typename dense_traits<E>::expr_type>
+>::type
+operator/(const E& e, typename dense_traits<E>::value_type k) {
+    typedef typename dense_traits<E>::value_type value_type;
+    typedef internals::dense_scalar_div<
+        value_type, base::is_floating_point_type<value_type>::Yes
+    > div_type;
+
+    return dense_scalar<
+        typename div_type::op, typename dense_traits<E>::expr_type
+    >(dense_traits<E>::as_expr(e), div_type::divisor(k));
+}
+
+/** @} */
+
+} // namespace math
+} // namespace v8
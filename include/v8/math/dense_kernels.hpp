@@ -0,0 +1,243 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+/*!
+ * \file dense_kernels.hpp
+ * \brief Matrix-matrix and matrix-vector products on row major arrays, used
+ *      by matrix_NxM and vector_N.
+ */
+
+#include <algorithm>
+#include <cstddef>
+
+#include <v8/v8.hpp>
+#include <v8/base/job_system.hpp>
+
+namespace v8 { namespace math {
+
+/** \addtogroup Algebra
+ *  @{
+ */
+
+/**
+ * \brief   Computes c = a * b, where a is rows x inner, b is inner x columns
+ *          and c is rows x columns. All matrices are row major.
+ * \param   jobs    Optional, when not null and the product is large enough, 
+ *                  blocks of rows are computed in parallel.
+ * \remarks c must not overlap a or b. The loops are blocked, so that the
+ *          blocks of b being read stay in cache. The float version packs the 
+ *          blocks and computes 4x8 tiles of c in registers when 
+ *          V8_MATH_ENABLE_SIMD is defined.
+ */
+template<typename real_t>
+void dense_matrix_multiply(
+    const real_t*       a,
+    const real_t*       b,
+    real_t*             c,
+    size_t              rows,
+    size_t              inner,
+    size_t              columns,
+    base::job_system*   jobs = nullptr
+    );
+
+void dense_matrix_multiply(
+    const float*        a,
+    const float*        b,
+    float*              c,
+    size_t              rows,
+    size_t              inner,
+    size_t              columns,
+    base::job_system*   jobs = nullptr
+    );
+
+/**
+ * \brief   Computes y = a * x, where a is a rows x columns row major matrix.
+ * \remarks y must not overlap a or x.
+ */
+template<typename real_t>
+void dense_matrix_vector_multiply(
+    const real_t*       a,
+    const real_t*       x,
+    real_t*             y,
+    size_t              rows,
+    size_t              columns,
+    base::job_system*   jobs = nullptr
+    );
+
+void dense_matrix_vector_multiply(
+    const float*        a,
+    const float*        x,
+    float*              y,
+    size_t              rows,
+    size_t              columns,
+    base::job_system*   jobs = nullptr
+    );
+
+/**
+ * \brief   Products with fewer multiply-adds than this run on the calling 
+ *          thread, even when a job system is given.
+ */
+const size_t C_Dense_Parallel_Threshold = size_t(1) << 21;
+
+/**
+ * \brief   Minimum number of rows computed by a task.
+ */
+const size_t C_Dense_Min_Task_Rows = 32;
+
+/** @} */
+
+namespace internals {
+
+//
+// Blocking of the generic product : a C_Dense_Block_Inner x 
+// C_Dense_Block_Columns block of b (256 KB of floats) is reused for 
+// C_Dense_Block_Rows rows of a and c.
+const size_t C_Dense_Block_Rows = 64;
+const size_t C_Dense_Block_Inner = 128;
+const size_t C_Dense_Block_Columns = 512;
+
+template<typename real_t>
+void dense_matrix_multiply_rows(
+    const real_t*   a,
+    const real_t*   b,
+    real_t*         c,
+    size_t          inner,
+    size_t          columns,
+    size_t          row_first,
+    size_t          row_last
+    ) {
+    for (size_t i = row_first; i < row_last; ++i) {
+        real_t* c_row = c + i * columns;
+        for (size_t j = 0; j < columns; ++j)
+            c_row[j] = real_t(0);
+    }
+
+    for (size_t ii = row_first; ii < row_last; ii += C_Dense_Block_Rows) {
+        const size_t i_last = std::min(row_last, ii + C_Dense_Block_Rows);
+
+        for (size_t jj = 0; jj < columns; jj += C_Dense_Block_Columns) {
+            const size_t j_last = std::min(columns, jj + C_Dense_Block_Columns);
+
+            for (size_t kk = 0; kk < inner; kk += C_Dense_Block_Inner) {
+                const size_t k_last = std::min(inner, kk + C_Dense_Block_Inner);
+
+                for (size_t i = ii; i < i_last; ++i) {
+                    const real_t* a_row = a + i * inner;
+                    real_t* c_row = c + i * columns;
+
+                    for (size_t k = kk; k < k_last; ++k) {
+                        const real_t a_ik = a_row[k];
+                        const real_t* b_row = b + k * columns;
+                        for (size_t j = jj; j < j_last; ++j)
+                            c_row[j] += a_ik * b_row[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+template<typename real_t>
+void dense_matrix_vector_rows(
+    const real_t*   a,
+    const real_t*   x,
+    real_t*         y,
+    size_t          columns,
+    size_t          row_first,
+    size_t          row_last
+    ) {
+    for (size_t i = row_first; i < row_last; ++i) {
+        const real_t* a_row = a + i * columns;
+        real_t sum = real_t(0);
+        for (size_t j = 0; j < columns; ++j)
+            sum += a_row[j] * x[j];
+        y[i] = sum;
+    }
+}
+
+//
+// Runs body(row_first, row_last) over [0, rows), in parallel if there is
+// enough work (work_per_row multiply-adds for each row).
+template<typename range_function>
+inline void run_dense_rows(
+    base::job_system*   jobs,
+    size_t              rows,
+    size_t              work_per_row,
+    range_function      body
+    ) {
+    if (!jobs || rows * work_per_row < C_Dense_Parallel_Threshold 
+        || rows < 2 * C_Dense_Min_Task_Rows) {
+        body(0, rows);
+        return;
+    }
+
+    //
+    // About four tasks per thread, for load balancing.
+    const size_t tasks = jobs->get_thread_count() * 4;
+    size_t grain = std::max(C_Dense_Min_Task_Rows, (rows + tasks - 1) / tasks);
+    grain = (grain + 3) & ~size_t(3);
+    jobs->parallel_for(0, rows, grain, body);
+}
+
+} // namespace internals
+
+} // namespace math
+} // namespace v8
+
+template<typename real_t>
+void v8::math::dense_matrix_multiply(
+    const real_t*       a,
+    const real_t*       b,
+    real_t*             c,
+    size_t              rows,
+    size_t              inner,
+    size_t              columns,
+    base::job_system*   jobs
+    ) {
+    internals::run_dense_rows(jobs, rows, inner * columns,
+        [=](size_t first, size_t last) {
+        internals::dense_matrix_multiply_rows(
+            a, b, c, inner, columns, first, last);
+    });
+}
+
+template<typename real_t>
+void v8::math::dense_matrix_vector_multiply(
+    const real_t*       a,
+    const real_t*       x,
+    real_t*             y,
+    size_t              rows,
+    size_t              columns,
+    base::job_system*   jobs
+    ) {
+    internals::run_dense_rows(jobs, rows, columns,
+        [=](size_t first, size_t last) {
+        internals::dense_matrix_vector_rows(a, x, y, columns, first, last);
+    });
+}
@@ -26,6 +26,8 @@
 
 #pragma once
 
+#include <cmath>
+
 #include <v8/math/math_utils.hpp>
 #include <v8/math/objects/triangle.hpp>
 #include <v8/math/space_traits.hpp>
@@ -38,15 +40,23 @@ namespace v8 { namespace math {
 
 /**
  * \brief Returns the square of the distance between a point and a triangle.
- * \param pt    The point.
- * \param tri   The triangle.
+ * \param pt        The point.
+ * \param tri       The triangle.
+ * \param s_param   Receives the parameters of the closest point of the 
+ * \param t_param   triangle : v0 + s * (v1 - v0) + t * (v2 - v0). 
+ *                  Its barycentric coordinates are (1 - s - t, s, t).
+ * \remarks The regions are selected with exact comparisons, as in the 
+ *          original algorithm; an absolute epsilon would misclassify the 
+ *          points of small triangles, whose determinant is tiny.
  * \see   <b>David Eberly, Geometric tools for Computer Graphics (2003)</b>
  *        for the point to triangle distance algorithm.
  */
 template<typename real_t, int space_dim>
 real_t distance_squared(
         const typename space_traits<real_t, space_dim>::vector_t& pt,
-        const triangle<real_t, space_dim>& tri
+        const triangle<real_t, space_dim>& tri,
+        real_t* s_param,
+        real_t* t_param
         ) {
     typedef typename space_traits<real_t, space_dim>::vector_t vector_t;
 
@@ -55,18 +65,18 @@ real_t distance_squared(
     const vector_t edge1 = tri.v2_ - tri.v0_;
     const real_t a00 = edge0.length_squared();
     const real_t a01 = dot_product(edge0, edge1);
-    const real_t a11 = edge1.square_length();
+    const real_t a11 = edge1.length_squared();
     const real_t b0 = dot_product(edge0, diff);
     const real_t b1 = dot_product(edge1, diff);
     const real_t c = diff.length_squared();
-    const real_t det = abs(a00 * a11 - a01 * a01);
+    const real_t det = std::abs(a00 * a11 - a01 * a01);
     real_t s = a01 * b1 - a11 * b0;
     real_t t = a01 * b0 - a00 * b1;
 
     real_t sqr_dist;
 
     const real_t sum = s + t;
-    if (operands_eq(sum, det) || sum < det) {
+    if (sum <= det) {
         if (s < real_t(0)) {
             if (t < real_t(0)) {
                 //
@@ -75,7 +85,7 @@ real_t distance_squared(
                 if (b0 < real_t(0)) {
                     t = real_t(0);
 
-                    if (-b0 > a00 || operands_eq(-b0, a00)) {
+                    if (-b0 >= a00) {
                         s = real_t(1);
                         sqr_dist = a00 + real_t(2) * b0 + c;
                     } else {
@@ -84,10 +94,10 @@ real_t distance_squared(
                     }
                 } else {
                     s = real_t(0);
-                    if (b1 > real_t(0) || is_zero(b1)) {
+                    if (b1 >= real_t(0)) {
                         t = real_t(0);
                         sqr_dist = c;
-                    } else if (-b1 > a11 || operands_eq(-b1, a11)) {
+                    } else if (-b1 >= a11) {
                         t = real_t(1);
                         sqr_dist = a11 + real_t(2) * b1 + c;
                     } else {
@@ -99,10 +109,10 @@ real_t distance_squared(
                 //
                 // region 3
                 s = real_t(0);
-                if (b1 > real_t(0) || is_zero(b1)) {
+                if (b1 >= real_t(0)) {
                     t = real_t(0);
                     sqr_dist = c;
-                } else if (-b1 > a11 || operands_eq(-b1, a11)) {
+                } else if (-b1 >= a11) {
                     t = real_t(1);
                     sqr_dist = a11 + real_t(2) * b1 + c;
                 } else {
@@ -114,10 +124,10 @@ real_t distance_squared(
             //
             // region 5
             t = real_t(0);
-            if (b0 > real_t(0) || is_zero(b0)) {
+            if (b0 >= real_t(0)) {
                 s = real_t(0);
                 sqr_dist = c;
-            } else if (-b0 > a00 || operands_eq(-b0, a00)) {
+            } else if (-b0 >= a00) {
                 s = real_t(1);
                 sqr_dist = a00 + real_t(2) * b0 + c;
             } else {
@@ -127,10 +137,13 @@ real_t distance_squared(
         } else {
             //
             // region 0
-            // minimum at interior point
-            typename div_wrap_t<real_t>::div_helper_t div_op(det);
-            s = div_op(s);
-            t = div_op(t);
+            // minimum at interior point (s = t = 0 for a degenerate 
+            // triangle, since s + t <= det).
+            if (det > real_t(0)) {
+                typename internals::div_wrap_t<real_t>::div_helper_t div_op(det);
+                s = div_op(s);
+                t = div_op(t);
+            }
             sqr_dist = s * (a00 * s + a01 * t + real_t(2) * b0)
                        + t * (a01 * s + a11 * t + real_t(2) * b1)
                        + c;
@@ -146,7 +159,7 @@ real_t distance_squared(
             if (tmp1 > tmp0) {
                 numer = tmp1 - tmp0;
                 denom = a00 - real_t(2) * a01 + a11;
-                if (numer > denom || operands_eq(numer, denom)) {
+                if (numer >= denom) {
                     s = real_t(1);
                     t = real_t(0);
                     sqr_dist = a00 + real_t(2) * b0 + c;
@@ -159,10 +172,10 @@ real_t distance_squared(
                 }
             } else {
                 s = real_t(0);
-                if (tmp1 < real_t(0) || is_zero(tmp)) {
+                if (tmp1 <= real_t(0)) {
                     t = real_t(1);
                     sqr_dist = a11 + real_t(2) * b1 + c;
-                } else if (is_zero(b1) || b1 > real_t(0)) {
+                } else if (b1 >= real_t(0)) {
                     t = real_t(0);
                     sqr_dist = c;
                 } else {
@@ -178,7 +191,7 @@ real_t distance_squared(
             if (tmp1 > tmp0) {
                 numer = tmp1 - tmp0;
                 denom = a00 - real_t(2) * a01 + a11;
-                if (operands_eq(numer, denom) || numer > denom) {
+                if (numer >= denom) {
                     t = real_t(1);
                     s = real_t(0);
                     sqr_dist = a11 + real_t(2) * b1 + c;
@@ -190,10 +203,10 @@ real_t distance_squared(
                 }
             } else {
                 t = real_t(0);
-                if (is_zero(tmp1) || tmp1 < real_t(0)) {
+                if (tmp1 <= real_t(0)) {
                     s = real_t(1);
                     sqr_dist = a00 + real_t(2) * b0 + c;
-                } else if (is_zero(b0) || b0 > real_t(0)) {
+                } else if (b0 >= real_t(0)) {
                     s = real_t(0);
                     sqr_dist = c;
                 } else {
@@ -205,13 +218,13 @@ real_t distance_squared(
             //
             // region 1
             numer = a11 + b1 - a01 - b0;
-            if (is_zero(numer) || numer < real_t(0)) {
+            if (numer <= real_t(0)) {
                 s = real_t(0);
                 t = real_t(1);
                 sqr_dist = a11 + real_t(2) * b1 + c;
             } else {
                 denom = a00 - real_t(2) * a01 + a11;
-                if (numer > denom || operands_eq(numer, denom)) {
+                if (numer >= denom) {
                     s = real_t(1);
                     t = real_t(0);
                     sqr_dist = a00 + real_t(2) * b0 + c;
@@ -232,9 +245,26 @@ real_t distance_squared(
         sqr_dist = real_t(0);
     }
 
+    *s_param = s;
+    *t_param = t;
     return sqr_dist;
 }
 
+/**
+ * \brief Returns the square of the distance between a point and a triangle.
+ * \param pt    The point.
+ * \param tri   The triangle.
+ */
+template<typename real_t, int space_dim>
+real_t distance_squared(
+        const typename space_traits<real_t, space_dim>::vector_t& pt,
+        const triangle<real_t, space_dim>& tri
+        ) {
+    real_t s;
+    real_t t;
+    return distance_squared(pt, tri, &s, &t);
+}
+
 /** @} */
 
 } // namespace math
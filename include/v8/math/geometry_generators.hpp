@@ -29,6 +29,7 @@
 #include <cstdint>
 #include <vector>
 
+#include <v8/math/mesh_streams.hpp>
 #include <v8/math/vector2.hpp>
 #include <v8/math/vector3.hpp>
 
@@ -62,6 +63,24 @@ struct mesh_data_t {
     std::vector<uint32_t>   md_indices;
 };
 
+//
+// Same as mesh_data_t, with the vertex attributes stored in separate 
+// streams. Every generator has an overload that fills one. The geosphere
+// writes the streams directly, the other generators build interleaved
+// vertices and split them with mesh_streams::deinterleave().
+struct mesh_streams_data_t {
+    mesh_streams            msd_vertices;
+    std::vector<uint32_t>   msd_indices;
+};
+
+//
+// Layout of vertex_pntt, for mesh_streams::interleave()/deinterleave().
+inline vertex_layout_t vertex_pntt_layout() {
+    return make_vertex_layout(
+        &vertex_pntt::vt_position, &vertex_pntt::vt_normal, 
+        &vertex_pntt::vt_tangent, &vertex_pntt::vt_texcoord);
+}
+
 void create_box(
     float width, 
     float height, 
@@ -69,6 +88,13 @@ void create_box(
     mesh_data_t* mesh_data
     );
 
+void create_box(
+    float width, 
+    float height, 
+    float depth, 
+    mesh_streams_data_t* mesh_data
+    );
+
 void create_sphere(
     float radius,
     size_t slice_count,
@@ -76,12 +102,34 @@ void create_sphere(
     mesh_data_t* mesh_data
     );
 
+void create_sphere(
+    float radius,
+    size_t slice_count,
+    size_t stack_count,
+    mesh_streams_data_t* mesh_data
+    );
+
+//
+// Upper bound for the subdivisions argument of create_geosphere().
+const size_t C_Max_Geosphere_Subdivisions = 9;
+
+//
+// Approximates a sphere by recursively subdividing an icosahedron. Vertices
+// are shared between adjacent triangles; subdivision level n produces
+// 10 * 4^n + 2 vertices and 20 * 4^n triangles. Values above
+// C_Max_Geosphere_Subdivisions are clamped.
 void create_geosphere(
     float radius,
     size_t subdivisions,
     mesh_data_t* mesh_data
     );
 
+void create_geosphere(
+    float radius,
+    size_t subdivisions,
+    mesh_streams_data_t* mesh_data
+    );
+
 void create_cylinder(
     float bottom_radius,
     float top_radius,
@@ -91,6 +139,15 @@ void create_cylinder(
     mesh_data_t* mesh_data
     );
 
+void create_cylinder(
+    float bottom_radius,
+    float top_radius,
+    float height,
+    size_t slice_count,
+    size_t stack_count,
+    mesh_streams_data_t* mesh_data
+    );
+
 void create_grid(
     const float grid_width,
     const float grid_depth,
@@ -99,10 +156,22 @@ void create_grid(
     mesh_data_t* mesh
     );
 
+void create_grid(
+    const float grid_width,
+    const float grid_depth,
+    const v8_int_t row_count,
+    const v8_int_t column_count,
+    mesh_streams_data_t* mesh
+    );
+
 void create_fullscreen_quad(
     mesh_data_t* mesh_data
     );
 
+void create_fullscreen_quad(
+    mesh_streams_data_t* mesh_data
+    );
+
 } // namespace geometry_gen
 } // namespace math
 } // namespace v8
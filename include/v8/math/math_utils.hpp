@@ -44,7 +44,7 @@ struct op_eq_helper {
 template<typename real_type>
 struct op_eq_helper<real_type, true> {
     static bool result(real_type left, real_type right) {
-        return abs(left - right) < numerics<real_type>::epsilon();
+        return std::fabs(left - right) < numerics<real_type>::epsilon();
     }
 };
 
@@ -200,16 +200,16 @@ void v8::math::matrix_3X3<real_t>::get_transpose(v8::math::matrix_3X3<real_t>* m
 template<typename real_t>
 void v8::math::matrix_3X3<real_t>::get_adjoint(v8::math::matrix_3X3<real_t>* mx) const {
     mx->a11_ = a22_ * a33_ - a32_ * a23_;
-    mx->a12_ = a23_ * a31_ - a21_ * a33_;
-    mx->a13_ = a21_ * a32_ - a22_ * a31_;
+    mx->a12_ = a13_ * a32_ - a12_ * a33_;
+    mx->a13_ = a12_ * a23_ - a13_ * a22_;
 
-    mx->a21_ = a13_ * a32_ - a12_ * a33_;
+    mx->a21_ = a23_ * a31_ - a21_ * a33_;
     mx->a22_ = a11_ * a33_ - a13_ * a31_;
-    mx->a23_ = a12_ * a31_ - a11_ * a32_;
+    mx->a23_ = a13_ * a21_ - a11_ * a23_;
 
-    mx->a31_ = a12_ * a23_ - a13_ * a22_;
-    mx->a32_ = a13_ * a21_ - a11_ * a23_;
-    mx->a33_ = a12_ * a22_ - a12_ * a21_;
+    mx->a31_ = a21_ * a32_ - a22_ * a31_;
+    mx->a32_ = a12_ * a31_ - a11_ * a32_;
+    mx->a33_ = a11_ * a22_ - a12_ * a21_;
 }
 
 template<typename real_t>
@@ -561,6 +561,8 @@ v8::math::matrix_3X3<real_t>::make_rotation_xyz(
     a31_ = -siny;
     a32_ = cosy * sinx;
     a33_ = cosx * cosy;
+
+    return *this;
 }
 
 template<typename real_t>
@@ -35,6 +35,7 @@
 #include <v8/base/fundamental_types.hpp>
 #include <v8/math/math_utils.hpp>
 #include <v8/math/matrix3X3.hpp>
+#include <v8/math/simd/simd_config.hpp>
 #include <v8/math/vector4.hpp>
 
 namespace v8 { namespace math {
@@ -523,6 +524,17 @@ operator*(
     const math::matrix_4X4<real_t>& lhs, const math::matrix_4X4<real_t>& rhs
     );
 
+/**
+ * \brief   Matrix -> vector multiplication operator. Transforms a homogeneous
+ *          point (column vector).
+ */
+template<typename real_t>
+inline
+vector4<real_t>
+operator*(
+    const math::matrix_4X4<real_t>& mtx, const math::vector4<real_t>& vec
+    );
+
 /**
  * \brief   scalar -> matrix multiplication operator.
  */
@@ -564,3 +576,7 @@ typedef matrix_4X4<double>   matrix_4X4D;
 } // namespace v8
 
 #include "matrix4X4.inl"
+
+#if defined(V8_MATH_SIMD_ENABLED)
+#include "matrix4X4_simd.inl"
+#endif
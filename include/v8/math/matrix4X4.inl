@@ -168,7 +168,7 @@ v8::math::matrix_4X4<real_t>::determinant() const {
     const real_t l3 = a32_ * a43_ - a33_ * a42_;
 
     const real_t k4 = a12_ * a23_ - a13_ * a22_;
-    const real_t l4 = a31_ * a44_ - a43_ * a41_;
+    const real_t l4 = a31_ * a44_ - a34_ * a41_;
 
     const real_t k5 = a12_ * a24_ - a14_ * a22_;
     const real_t l5 = a31_ * a43_ - a33_ * a41_;
@@ -363,9 +363,13 @@ v8::math::matrix_4X4<Real_Ty>::transform_affine_vector(
     v8::math::vector3<Real_Ty2>* pvec
     ) const
 {
-    pvec->x_ = a11_ * pvec->x_ + a12_ * pvec->y_ + a13_ * pvec->z_;
-    pvec->y_ = a21_ * pvec->x_ + a22_ * pvec->y_ + a23_ * pvec->z_;
-    pvec->z_ = a31_ * pvec->x_ + a32_ * pvec->y_ + a33_ * pvec->z_;
+    const Real_Ty2 x = pvec->x_;
+    const Real_Ty2 y = pvec->y_;
+    const Real_Ty2 z = pvec->z_;
+
+    pvec->x_ = a11_ * x + a12_ * y + a13_ * z;
+    pvec->y_ = a21_ * x + a22_ * y + a23_ * z;
+    pvec->z_ = a31_ * x + a32_ * y + a33_ * z;
     return *this;
 }
 
@@ -376,9 +380,13 @@ v8::math::matrix_4X4<Real_Ty>::transform_affine_point(
     v8::math::vector3<Real_Ty2>* point
     ) const
 {
-    point->x_ = a11_ * point->x_ + a12_ * point->y_ + a13_ * point->z_ + a14_;
-    point->y_ = a21_ * point->x_ + a22_ * point->y_ + a23_ * point->z_ + a24_;
-    point->z_ = a31_ * point->x_ + a32_ * point->y_ + a33_ * point->z_ + a34_;
+    const Real_Ty2 x = point->x_;
+    const Real_Ty2 y = point->y_;
+    const Real_Ty2 z = point->z_;
+
+    point->x_ = a11_ * x + a12_ * y + a13_ * z + a14_;
+    point->y_ = a21_ * x + a22_ * y + a23_ * z + a24_;
+    point->z_ = a31_ * x + a32_ * y + a33_ * z + a34_;
     return *this;
 }
 
@@ -388,9 +396,13 @@ v8::math::matrix_4X4<real_t>::transform_affine_vector(
     v8::math::vector4<real_t>* pvec
     ) const
 {
-    pvec->x_ = a11_ * pvec->x_ + a12_ * pvec->y_ + a13_ * pvec->z_;
-    pvec->y_ = a21_ * pvec->x_ + a22_ * pvec->y_ + a23_ * pvec->z_;
-    pvec->z_ = a31_ * pvec->x_ + a32_ * pvec->y_ + a33_ * pvec->z_;
+    const real_t x = pvec->x_;
+    const real_t y = pvec->y_;
+    const real_t z = pvec->z_;
+
+    pvec->x_ = a11_ * x + a12_ * y + a13_ * z;
+    pvec->y_ = a21_ * x + a22_ * y + a23_ * z;
+    pvec->z_ = a31_ * x + a32_ * y + a33_ * z;
 
     return *this;
 }
@@ -401,9 +413,13 @@ v8::math::matrix_4X4<real_t>::transform_affine_point(
     v8::math::vector4<real_t>* apt
     ) const
 {
-    apt->x_ = a11_ * apt->x_ + a12_ * apt->y_ + a13_ * apt->z_ + a14_;
-    apt->y_ = a21_ * apt->x_ + a22_ * apt->y_ + a23_ * apt->z_ + a24_;
-    apt->z_ = a31_ * apt->x_ + a32_ * apt->y_ + a33_ * apt->z_ + a34_;
+    const real_t x = apt->x_;
+    const real_t y = apt->y_;
+    const real_t z = apt->z_;
+
+    apt->x_ = a11_ * x + a12_ * y + a13_ * z + a14_;
+    apt->y_ = a21_ * x + a22_ * y + a23_ * z + a24_;
+    apt->z_ = a31_ * x + a32_ * y + a33_ * z + a34_;
 
     return *this;
 }
@@ -414,11 +430,7 @@ v8::math::matrix_4X4<real_t>::transform_homogeneous_point(
     v8::math::vector4<real_t>* hpt
     ) const
 {
-    hpt->x_ = a11_ * hpt->x_ + a12_ * hpt->y_ + a13_ * hpt->z_ + a14_ * hpt->w_;
-    hpt->y_ = a21_ * hpt->x_ + a22_ * hpt->y_ + a23_ * hpt->z_ + a24_ * hpt->w_;
-    hpt->z_ = a31_ * hpt->x_ + a32_ * hpt->y_ + a33_ * hpt->z_ + a34_ * hpt->w_;
-    hpt->w_ = a41_ * hpt->x_ + a42_ * hpt->y_ + a43_ * hpt->z_ + a44_ * hpt->w_;
-
+    *hpt = *this * *hpt;
     return *this;
 }
 
@@ -536,6 +548,22 @@ v8::math::operator*(
     return res;
 }
 
+template<typename real_t>
+inline
+v8::math::vector4<real_t>
+v8::math::operator*(
+    const v8::math::matrix_4X4<real_t>& mtx,
+    const v8::math::vector4<real_t>& vec
+    )
+{
+    return v8::math::vector4<real_t>(
+        mtx.a11_ * vec.x_ + mtx.a12_ * vec.y_ + mtx.a13_ * vec.z_ + mtx.a14_ * vec.w_,
+        mtx.a21_ * vec.x_ + mtx.a22_ * vec.y_ + mtx.a23_ * vec.z_ + mtx.a24_ * vec.w_,
+        mtx.a31_ * vec.x_ + mtx.a32_ * vec.y_ + mtx.a33_ * vec.z_ + mtx.a34_ * vec.w_,
+        mtx.a41_ * vec.x_ + mtx.a42_ * vec.y_ + mtx.a43_ * vec.z_ + mtx.a44_ * vec.w_
+        );
+}
+
 template<typename real_t>
 inline
 v8::math::matrix_4X4<real_t>
@@ -0,0 +1,403 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+//
+// Vectorized specializations of the matrix_4X4<float> operations. 
+// Only included when the SIMD kernels are enabled (see simd/simd_config.hpp).
+// Every kernel performs the same multiplications, additions and 
+// subtractions, in the same order, as the generic code from matrix4X4.inl, 
+// so the results are identical to the last bit.
+
+#include <v8/math/simd/float4.hpp>
+
+namespace v8 { namespace math {
+
+namespace internals {
+
+struct matrix4X4F_rows {
+    simd::float4_t  r1;
+    simd::float4_t  r2;
+    simd::float4_t  r3;
+    simd::float4_t  r4;
+
+    explicit matrix4X4F_rows(const float* elements)
+        :   r1(simd::load_float4(elements)),
+            r2(simd::load_float4(elements + 4)),
+            r3(simd::load_float4(elements + 8)),
+            r4(simd::load_float4(elements + 12)) {}
+
+    void store(float* elements) const {
+        simd::store_float4(elements, r1);
+        simd::store_float4(elements + 4, r2);
+        simd::store_float4(elements + 8, r3);
+        simd::store_float4(elements + 12, r4);
+    }
+};
+
+/**
+ * \brief Computes (a * b - c * d) for every lane. This is the shape of all
+ * the 2x2 minors used by the determinant and the adjoint.
+ */
+inline simd::float4_t minor2x2(
+    simd::float4_t a, simd::float4_t b, simd::float4_t c, simd::float4_t d
+    ) {
+    return simd::sub(simd::mul(a, b), simd::mul(c, d));
+}
+
+/**
+ * \brief Computes (a1 * b1 + a2 * b2) + a3 * b3 for every lane.
+ */
+inline simd::float4_t cofactor_sum(
+    simd::float4_t a1, simd::float4_t b1,
+    simd::float4_t a2, simd::float4_t b2,
+    simd::float4_t a3, simd::float4_t b3
+    ) {
+    return simd::add(simd::add(simd::mul(a1, b1), simd::mul(a2, b2)),
+                     simd::mul(a3, b3));
+}
+
+/**
+ * \brief Computes lhs_row * rhs, where lhs_row is a row of the left operand
+ * and rhs is the right operand, stored by rows.
+ */
+inline simd::float4_t row_times_matrix(
+    simd::float4_t lhs_row, const matrix4X4F_rows& rhs
+    ) {
+    using namespace simd;
+    float4_t res = mul(broadcast_lane<0>(lhs_row), rhs.r1);
+    res = add(res, mul(broadcast_lane<1>(lhs_row), rhs.r2));
+    res = add(res, mul(broadcast_lane<2>(lhs_row), rhs.r3));
+    return add(res, mul(broadcast_lane<3>(lhs_row), rhs.r4));
+}
+
+#if defined(V8_MATH_SIMD_IS_AVX)
+
+/**
+ * \brief Same as row_times_matrix, for the two rows of the left operand
+ * in lhs_rows; r1 to r4 hold each row of the right operand twice.
+ */
+inline __m256 rows_times_matrix(
+    __m256 lhs_rows, __m256 r1, __m256 r2, __m256 r3, __m256 r4
+    ) {
+    __m256 res = _mm256_mul_ps(_mm256_shuffle_ps(lhs_rows, lhs_rows, 0x00), r1);
+    res = _mm256_add_ps(res, _mm256_mul_ps(
+        _mm256_shuffle_ps(lhs_rows, lhs_rows, 0x55), r2));
+    res = _mm256_add_ps(res, _mm256_mul_ps(
+        _mm256_shuffle_ps(lhs_rows, lhs_rows, 0xAA), r3));
+    return _mm256_add_ps(res, _mm256_mul_ps(
+        _mm256_shuffle_ps(lhs_rows, lhs_rows, 0xFF), r4));
+}
+
+#endif /* V8_MATH_SIMD_IS_AVX */
+
+} // namespace internals
+
+template<>
+inline
+matrix_4X4<float>&
+matrix_4X4<float>::operator+=(const matrix_4X4<float>& rhs) {
+    using namespace simd;
+    for (size_t i = 0; i < 16; i += 4) {
+        store_float4(elements_ + i, add(load_float4(elements_ + i),
+                                        load_float4(rhs.elements_ + i)));
+    }
+    return *this;
+}
+
+template<>
+inline
+matrix_4X4<float>&
+matrix_4X4<float>::operator-=(const matrix_4X4<float>& rhs) {
+    using namespace simd;
+    for (size_t i = 0; i < 16; i += 4) {
+        store_float4(elements_ + i, sub(load_float4(elements_ + i),
+                                        load_float4(rhs.elements_ + i)));
+    }
+    return *this;
+}
+
+template<>
+inline
+matrix_4X4<float>&
+matrix_4X4<float>::operator*=(float k) {
+    using namespace simd;
+    const float4_t scale = splat_float4(k);
+    for (size_t i = 0; i < 16; i += 4)
+        store_float4(elements_ + i, mul(load_float4(elements_ + i), scale));
+    return *this;
+}
+
+template<>
+inline
+matrix_4X4<float>&
+matrix_4X4<float>::operator/=(float k) {
+    using namespace simd;
+    //
+    // Same as internals::div_helper : multiply with the reciprocal.
+    const float4_t inv_k = splat_float4(1.0f / k);
+    for (size_t i = 0; i < 16; i += 4)
+        store_float4(elements_ + i, mul(load_float4(elements_ + i), inv_k));
+    return *this;
+}
+
+template<>
+inline
+float
+matrix_4X4<float>::determinant() const {
+    using namespace simd;
+    using internals::minor2x2;
+
+    const internals::matrix4X4F_rows rows(elements_);
+
+    //
+    // (k1, k2, k3, k4) and (k5, k6) - minors formed with the first two rows.
+    const float4_t k1234 = minor2x2(
+        swizzle<0, 0, 0, 1>(rows.r1), swizzle<1, 2, 3, 2>(rows.r2),
+        swizzle<1, 2, 3, 2>(rows.r1), swizzle<0, 0, 0, 1>(rows.r2));
+    const float4_t k56 = minor2x2(
+        swizzle<1, 2, 1, 2>(rows.r1), swizzle<3, 3, 3, 3>(rows.r2),
+        swizzle<3, 3, 3, 3>(rows.r1), swizzle<1, 2, 1, 2>(rows.r2));
+
+    //
+    // (l1, l2, l3, l4) and (l5, l6) - their algebraic complements.
+    const float4_t l1234 = minor2x2(
+        swizzle<2, 1, 1, 0>(rows.r3), swizzle<3, 3, 2, 3>(rows.r4),
+        swizzle<3, 3, 2, 3>(rows.r3), swizzle<2, 1, 1, 0>(rows.r4));
+    const float4_t l56 = minor2x2(
+        swizzle<0, 0, 0, 0>(rows.r3), swizzle<2, 1, 2, 1>(rows.r4),
+        swizzle<2, 1, 2, 1>(rows.r3), swizzle<0, 0, 0, 0>(rows.r4));
+
+    const float4_t p1234 = mul(k1234, l1234);
+    const float4_t p56 = mul(k56, l56);
+
+    return extract_lane<0>(p1234) - extract_lane<1>(p1234) 
+           + extract_lane<2>(p1234) + extract_lane<3>(p1234)
+           - extract_lane<0>(p56) + extract_lane<1>(p56);
+}
+
+template<>
+inline
+matrix_4X4<float>&
+matrix_4X4<float>::transpose() {
+    internals::matrix4X4F_rows rows(elements_);
+    simd::transpose(rows.r1, rows.r2, rows.r3, rows.r4);
+    rows.store(elements_);
+    return *this;
+}
+
+template<>
+inline
+void
+matrix_4X4<float>::get_transpose(matrix_4X4<float>* mx) const {
+    internals::matrix4X4F_rows rows(elements_);
+    simd::transpose(rows.r1, rows.r2, rows.r3, rows.r4);
+    rows.store(mx->elements_);
+}
+
+template<>
+inline
+void
+matrix_4X4<float>::get_adjoint(matrix_4X4<float>* mx) const {
+    using namespace simd;
+    using internals::minor2x2;
+    using internals::cofactor_sum;
+
+    const internals::matrix4X4F_rows rows(elements_);
+
+    //
+    // 2x2 minors, named as in the generic implementation.
+    // (m1, m2, m3, m7) and (m8, m14) from rows 3 and 4.
+    const float4_t m1_2_3_7 = minor2x2(
+        swizzle<2, 1, 1, 0>(rows.r3), swizzle<3, 3, 2, 3>(rows.r4),
+        swizzle<3, 3, 2, 3>(rows.r3), swizzle<2, 1, 1, 0>(rows.r4));
+    const float4_t m8_14 = minor2x2(
+        swizzle<0, 0, 0, 0>(rows.r3), swizzle<2, 1, 2, 1>(rows.r4),
+        swizzle<2, 1, 2, 1>(rows.r3), swizzle<0, 0, 0, 0>(rows.r4));
+    //
+    // (m4, m5, m6, m12) and (m13, m15) from rows 1 and 2.
+    const float4_t m4_5_6_12 = minor2x2(
+        swizzle<2, 1, 1, 0>(rows.r1), swizzle<3, 3, 2, 3>(rows.r2),
+        swizzle<3, 3, 2, 3>(rows.r1), swizzle<2, 1, 1, 0>(rows.r2));
+    const float4_t m13_15 = minor2x2(
+        swizzle<0, 0, 0, 0>(rows.r1), swizzle<2, 1, 2, 1>(rows.r2),
+        swizzle<2, 1, 2, 1>(rows.r1), swizzle<0, 0, 0, 0>(rows.r2));
+    //
+    // (m9, m10, m11) from rows 2 and 4.
+    const float4_t m9_10_11 = minor2x2(
+        swizzle<2, 0, 0, 0>(rows.r2), swizzle<3, 3, 2, 3>(rows.r4),
+        swizzle<3, 3, 2, 3>(rows.r2), swizzle<2, 0, 0, 0>(rows.r4));
+
+    //
+    // Every cofactor has the form x1 * m1 +/- x2 * m2 +/- x3 * m3. The x 
+    // factors come from the columns of the matrix and the signs are folded
+    // into them (multiplying by -1 is exact).
+    internals::matrix4X4F_rows cols(rows);
+    simd::transpose(cols.r1, cols.r2, cols.r3, cols.r4);
+
+    const float4_t sign_pm = set_float4(1.0f, -1.0f, 1.0f, -1.0f);
+    const float4_t sign_mp = set_float4(-1.0f, 1.0f, -1.0f, 1.0f);
+
+    const float4_t m14_14_15_15 = shuffle<1, 1, 1, 1>(m8_14, m13_15);
+
+    //
+    // (a22, -a12, a42, -a32) * (m1, m1, m4, m4) 
+    // + (-a23, a13, -a43, a33) * (m2, m2, m5, m5) 
+    // + (a24, -a14, a44, -a34) * (m3, m3, m6, m6)
+    const float4_t adj_r1 = cofactor_sum(
+        mul(swizzle<1, 0, 3, 2>(cols.r2), sign_pm), 
+        shuffle<0, 0, 0, 0>(m1_2_3_7, m4_5_6_12),
+        mul(swizzle<1, 0, 3, 2>(cols.r3), sign_mp), 
+        shuffle<1, 1, 1, 1>(m1_2_3_7, m4_5_6_12),
+        mul(swizzle<1, 0, 3, 2>(cols.r4), sign_pm), 
+        shuffle<2, 2, 2, 2>(m1_2_3_7, m4_5_6_12));
+
+    //
+    // (-a21, a11, -a11, a31) * (m1, m1, m9, m4)
+    // + (a23, -a13, a13, -a33) * (m7, m7, m10, m12)
+    // + (-a24, a14, -a14, a34) * (m8, m8, m11, m13)
+    const float4_t adj_r2 = cofactor_sum(
+        mul(swizzle<1, 0, 0, 2>(cols.r1), sign_mp),
+        shuffle<0, 0, 1, 2>(
+            m1_2_3_7, shuffle<0, 0, 0, 0>(m9_10_11, m4_5_6_12)),
+        mul(swizzle<1, 0, 0, 2>(cols.r3), sign_pm),
+        shuffle<3, 3, 1, 2>(
+            m1_2_3_7, shuffle<1, 1, 3, 3>(m9_10_11, m4_5_6_12)),
+        mul(swizzle<1, 0, 0, 2>(cols.r4), sign_mp),
+        shuffle<0, 0, 1, 2>(
+            m8_14, shuffle<2, 2, 0, 0>(m9_10_11, m13_15)));
+
+    //
+    // (a21, -a11, a41, -a31) * (m2, m2, m5, m5)
+    // + (-a22, a12, -a42, a32) * (m7, m7, m12, m12)
+    // + (a24, -a14, a44, -a34) * (m14, m14, m15, m15)
+    const float4_t adj_r3 = cofactor_sum(
+        mul(swizzle<1, 0, 3, 2>(cols.r1), sign_pm),
+        shuffle<1, 1, 1, 1>(m1_2_3_7, m4_5_6_12),
+        mul(swizzle<1, 0, 3, 2>(cols.r2), sign_mp),
+        shuffle<3, 3, 3, 3>(m1_2_3_7, m4_5_6_12),
+        mul(swizzle<1, 0, 3, 2>(cols.r4), sign_pm),
+        m14_14_15_15);
+
+    //
+    // (-a21, a11, -a41, a31) * (m3, m3, m6, m6)
+    // + (a22, -a12, a42, -a32) * (m8, m8, m13, m13)
+    // + (-a23, a13, -a43, a33) * (m14, m14, m15, m15)
+    const float4_t adj_r4 = cofactor_sum(
+        mul(swizzle<1, 0, 3, 2>(cols.r1), sign_mp),
+        shuffle<2, 2, 2, 2>(m1_2_3_7, m4_5_6_12),
+        mul(swizzle<1, 0, 3, 2>(cols.r2), sign_pm),
+        shuffle<0, 0, 0, 0>(m8_14, m13_15),
+        mul(swizzle<1, 0, 3, 2>(cols.r3), sign_mp),
+        m14_14_15_15);
+
+    store_float4(mx->elements_, adj_r1);
+    store_float4(mx->elements_ + 4, adj_r2);
+    store_float4(mx->elements_ + 8, adj_r3);
+    store_float4(mx->elements_ + 12, adj_r4);
+}
+
+template<>
+inline
+void
+matrix_4X4<float>::get_inverse(matrix_4X4<float>* mx) const {
+    const float det = determinant();
+    assert(!math::operands_eq(0.0f, det));
+
+    get_adjoint(mx);
+    *mx /= det;
+}
+
+template<>
+inline
+matrix_4X4<float>
+operator*(const matrix_4X4<float>& lhs, const matrix_4X4<float>& rhs) {
+    using namespace simd;
+
+    matrix_4X4<float> res;
+
+#if defined(V8_MATH_SIMD_IS_AVX)
+    //
+    // Two rows of the result per register, each row of rhs in both halves
+    // (vbroadcastf128 has no alignment requirement).
+    const __m128* rhs_rows = reinterpret_cast<const __m128*>(rhs.elements_);
+    const __m256 r1 = _mm256_broadcast_ps(rhs_rows);
+    const __m256 r2 = _mm256_broadcast_ps(rhs_rows + 1);
+    const __m256 r3 = _mm256_broadcast_ps(rhs_rows + 2);
+    const __m256 r4 = _mm256_broadcast_ps(rhs_rows + 3);
+
+    const __m256 res12 = internals::rows_times_matrix(
+        _mm256_loadu_ps(lhs.elements_), r1, r2, r3, r4);
+    const __m256 res34 = internals::rows_times_matrix(
+        _mm256_loadu_ps(lhs.elements_ + 8), r1, r2, r3, r4);
+    _mm256_storeu_ps(res.elements_, res12);
+    _mm256_storeu_ps(res.elements_ + 8, res34);
+#else
+    const internals::matrix4X4F_rows rhs_rows(rhs.elements_);
+
+    //
+    // Unrolled, so that the four rows are computed in registers before the
+    // stores.
+    const float4_t res1 = internals::row_times_matrix(
+        load_float4(lhs.elements_), rhs_rows);
+    const float4_t res2 = internals::row_times_matrix(
+        load_float4(lhs.elements_ + 4), rhs_rows);
+    const float4_t res3 = internals::row_times_matrix(
+        load_float4(lhs.elements_ + 8), rhs_rows);
+    const float4_t res4 = internals::row_times_matrix(
+        load_float4(lhs.elements_ + 12), rhs_rows);
+    store_float4(res.elements_, res1);
+    store_float4(res.elements_ + 4, res2);
+    store_float4(res.elements_ + 8, res3);
+    store_float4(res.elements_ + 12, res4);
+#endif
+
+    return res;
+}
+
+template<>
+inline
+vector4<float>
+operator*(const matrix_4X4<float>& mtx, const vector4<float>& vec) {
+    using namespace simd;
+
+    internals::matrix4X4F_rows cols(mtx.elements_);
+    simd::transpose(cols.r1, cols.r2, cols.r3, cols.r4);
+
+    const float4_t v = load_float4(vec.elements_);
+    float4_t res = mul(cols.r1, broadcast_lane<0>(v));
+    res = add(res, mul(cols.r2, broadcast_lane<1>(v)));
+    res = add(res, mul(cols.r3, broadcast_lane<2>(v)));
+    res = add(res, mul(cols.r4, broadcast_lane<3>(v)));
+
+    vector4<float> out;
+    store_float4(out.elements_, res);
+    return out;
+}
+
+} // namespace math
+} // namespace v8
@@ -29,6 +29,7 @@
 #include <cassert>
 #include <cmath>
 #include <cstring>
+#include <type_traits>
 
 #include <v8/v8.hpp>
 
@@ -37,6 +38,9 @@
 #include <initializer_list>
 #endif
 
+#include <v8/base/job_system.hpp>
+#include <v8/math/dense_expr.hpp>
+#include <v8/math/dense_kernels.hpp>
 #include <v8/math/math_utils.hpp>
 #include <v8/math/vector_N.hpp>
 
@@ -52,6 +56,11 @@ namespace v8 { namespace math {
  *          constructor, make sure to call the resize() member function before
  *          using it. Element access using the m(i,j) syntax uses
  *          1 based indexing</b>.
+ *          Element wise arithmetic returns expressions (see dense_expr.hpp), 
+ *          evaluated without temporaries when assigned to a matrix. 
+ *          Products are computed by the blocked kernels of 
+ *          dense_kernels.hpp; use matrix_product() and 
+ *          matrix_vector_product() to reuse the storage of the result.
  */
 template<typename real_t>
 class matrix_NxM {
@@ -74,6 +83,15 @@ private :
         return m_rows_ * m_columns_;
     }
 
+    template<typename expr>
+    struct enable_for_expr : public std::enable_if<
+        internals::is_dense_shape<expr, dense_matrix_tag>::Yes> {};
+
+    dense_leaf<real_t, dense_matrix_tag> as_expr() const {
+        return dense_leaf<real_t, dense_matrix_tag>(
+            m_data_, m_rows_, m_columns_);
+    }
+
 public :
     typedef matrix_NxM<real_t>   matrix_NxM_t;
 
@@ -120,6 +138,21 @@ public :
         : m_rows_(rhs_tmp.m_rows_), m_columns_(rhs_tmp.m_columns_),
           m_data_(rhs_tmp.m_data_) {
         rhs_tmp.m_data_ = nullptr;
+        rhs_tmp.m_rows_ = rhs_tmp.m_columns_ = 0;
+    }
+
+    /*!
+     * \brief Constructs the matrix by evaluating an expression.
+     */
+    template<typename expr>
+    matrix_NxM(
+        const expr& e, 
+        typename enable_for_expr<expr>::type* = nullptr
+        )
+        : m_rows_(dense_traits<expr>::as_expr(e).rows()), 
+          m_columns_(dense_traits<expr>::as_expr(e).columns()),
+          m_data_(new real_t[m_rows_ * m_columns_]) {
+        internals::dense_evaluate(m_data_, dense_traits<expr>::as_expr(e));
     }
 
     ~matrix_NxM() {
@@ -143,8 +176,8 @@ public :
      *        matrices that have the same number of rows and columns.
      */
     matrix_NxM_t& operator=(matrix_NxM_t&& rhs_tmp) {
-        assert(m_rows_ == rhs.m_rows_);
-        assert(m_columns_ == rhs.m_columns_);
+        assert(m_rows_ == rhs_tmp.m_rows_);
+        assert(m_columns_ == rhs_tmp.m_columns_);
 
         real_t* data_ptr = rhs_tmp.m_data_;
         rhs_tmp.m_data_ = m_data_;
@@ -154,17 +187,32 @@ public :
         return *this;
     }
 
+    /*!
+     * \brief Evaluates an expression into this matrix. Only valid if the 
+     *        expression has the same number of rows and columns. The 
+     *        expression may reference this matrix.
+     */
+    template<typename expr>
+    typename std::enable_if<
+        internals::is_dense_shape<expr, dense_matrix_tag>::Yes, matrix_NxM_t&
+    >::type
+    operator=(const expr& e) {
+        assert(m_rows_ == dense_traits<expr>::as_expr(e).rows());
+        assert(m_columns_ == dense_traits<expr>::as_expr(e).columns());
+        internals::dense_evaluate(m_data_, dense_traits<expr>::as_expr(e));
+        return *this;
+    }
+
     /*!
      * \brief Self assign add. Only valid between matrices with the same number
      *        of rows and columns.
      */
-    matrix_NxM_t& operator+=(const matrix_NxM_t& rhs) {
-        assert(m_rows_ == rhs.m_rows_);
-        assert(m_columns_ == rhs.m_columns_);
-
-        const size_t dim = dimension();
-        for (size_t i = 0; i < dim; ++i)
-            m_data_[i] += rhs.m_data_[i];
+    template<typename expr>
+    typename std::enable_if<
+        internals::is_dense_shape<expr, dense_matrix_tag>::Yes, matrix_NxM_t&
+    >::type
+    operator+=(const expr& rhs) {
+        internals::dense_evaluate(m_data_, as_expr() + rhs);
         return *this;
     }
 
@@ -172,13 +220,12 @@ public :
      * \brief Self assign substract. Only valid between matrices with the same
      *        number of rows and columns.
      */
-    matrix_NxM_t& operator-=(const matrix_NxM_t& rhs) {
-        assert(m_rows_ == rhs.m_rows_);
-        assert(m_columns_ == rhs.m_columns_);
-
-        const size_t dim = dimension();
-        for (size_t i = 0; i < dim; ++i)
-            m_data_[i] -= rhs.m_data_[i];
+    template<typename expr>
+    typename std::enable_if<
+        internals::is_dense_shape<expr, dense_matrix_tag>::Yes, matrix_NxM_t&
+    >::type
+    operator-=(const expr& rhs) {
+        internals::dense_evaluate(m_data_, as_expr() - rhs);
         return *this;
     }
 
@@ -186,9 +233,7 @@ public :
      * \brief Self assign scalar multiply.
      */
     matrix_NxM_t& operator*=(real_t k) {
-        const size_t mtx_dim = dimension();
-        for (size_t i = 0; i < mtx_dim; ++i)
-            m_data_[i] *= k;
+        internals::dense_evaluate(m_data_, as_expr() * k);
         return *this;
     }
 
@@ -196,10 +241,7 @@ public :
      * \brief Self assign scalar division.
      */
     matrix_NxM_t& operator/=(real_t k) {
-        const size_t dim = dimension();
-        typename internals::div_wrap_t<real_t>::div_helper_t div_val(k);
-        for (size_t i = 0; i < dim; ++i)
-            m_data_[i] = div_val(m_data_[i]);
+        internals::dense_evaluate(m_data_, as_expr() / k);
         return *this;
     }
 
@@ -351,7 +393,7 @@ public :
         matrix_NxM_t transp_mtx(m_columns_, m_rows_);
         for (size_t i = 0; i < m_rows_; ++i) {
             for (size_t j = 0; j < m_columns_; ++j) {
-                transp_mtx(j + 1, i + 1) = m_data_(i + 1, j + 1);
+                transp_mtx(j + 1, i + 1) = (*this)(i + 1, j + 1);
             }
         }
         return transp_mtx;
@@ -434,7 +476,7 @@ matrix_NxM<real_t>& matrix_NxM<real_t>::make_tensor_product(
     const real_t* w_ptr = w.get_data();
     const real_t* u_ptr = u.get_data();
     for (size_t i = 0; i < m_rows_; ++i) {
-        for (size_t j = 0; j < m_columns_; ++i) {
+        for (size_t j = 0; j < m_columns_; ++j) {
             m_data_[i * m_columns_ + j] = w_ptr[i] * u_ptr[j];
         }
     }
@@ -442,7 +484,7 @@ matrix_NxM<real_t>& matrix_NxM<real_t>::make_tensor_product(
 }
 
 template<typename real_t>
-matrix_NxM_t& matrix_NxM<real_t>::resize(size_t rows, size_t columns) {
+matrix_NxM<real_t>& matrix_NxM<real_t>::resize(size_t rows, size_t columns) {
     const size_t old_dimension = dimension();
     const size_t new_dimension = rows * columns;
     if (old_dimension < new_dimension) {
@@ -481,97 +523,139 @@ inline bool operator!=(const matrix_NxM<real_t>& lhs,
 }
 
 template<typename real_t>
-matrix_NxM<real_t> operator-(const matrix_NxM<real_t>& mtx) {
-    matrix_NxM<real_t> negated(mtx.get_row_count(), mtx.get_column_count());
-    for (size_t i = 0; i < mtx.get_data_size(); ++i)
-        negated.get_data()[i] = -(mtx.get_data()[i]);
+struct dense_traits<matrix_NxM<real_t>, void> {
+    enum { is_dense = true };
+    typedef dense_leaf<real_t, dense_matrix_tag>    expr_type;
+    typedef real_t                                  value_type;
+    typedef dense_matrix_tag                        shape_tag;
 
-    return negated;
-}
+    static expr_type as_expr(const matrix_NxM<real_t>& mtx) {
+        return expr_type(
+            mtx.get_data(), mtx.get_row_count(), mtx.get_column_count());
+    }
+};
 
+/*!
+ * \brief   Computes result = lhs * rhs. The result is resized if needed, 
+ *          its storage is reallocated only when it grows.
+ * \param   jobs    Optional, large products are computed in parallel.
+ * \remarks The result must not be one of the operands.
+ */
 template<typename real_t>
-inline matrix_NxM<real_t> operator+(const matrix_NxM<real_t>& lhs,
-                                    const matrix_NxM<real_t>& rhs) {
-    assert(lhs.get_row_count() == rhs.get_row_count());
-    assert(lhs.get_column_count() == rhs.get_column_count());
+void matrix_product(
+    const matrix_NxM<real_t>&   lhs,
+    const matrix_NxM<real_t>&   rhs,
+    matrix_NxM<real_t>*         result,
+    base::job_system*           jobs = nullptr
+    ) {
+    assert(lhs.get_column_count() == rhs.get_row_count());
+    assert(result != &lhs && result != &rhs);
 
-    matrix_NxM<real_t> result(lhs);
-    result += rhs;
-    return result;
+    result->resize(lhs.get_row_count(), rhs.get_column_count());
+    dense_matrix_multiply(
+        lhs.get_data(), rhs.get_data(), result->get_data(),
+        lhs.get_row_count(), lhs.get_column_count(), rhs.get_column_count(),
+        jobs);
 }
 
+/*!
+ * \brief   Computes result = mtx * vec. The result is resized if needed, 
+ *          its storage is reallocated only when it grows.
+ * \remarks The result must not be the input vector.
+ */
 template<typename real_t>
-inline matrix_NxM<real_t> operator-(const matrix_NxM<real_t>& lhs,
-                                    const matrix_NxM<real_t>& rhs) {
-    assert(lhs.get_row_count() == rhs.get_row_count());
-    assert(lhs.get_column_count() == rhs.get_column_count());
+void matrix_vector_product(
+    const matrix_NxM<real_t>&   mtx,
+    const vector_N<real_t>&     vec,
+    vector_N<real_t>*           result,
+    base::job_system*           jobs = nullptr
+    ) {
+    assert(mtx.get_column_count() == vec.get_dimension());
+    assert(result != &vec);
 
-    matrix_NxM<real_t> result(lhs);
-    result -= rhs;
-    return result;
+    result->set_dimension(mtx.get_row_count());
+    dense_matrix_vector_multiply(
+        mtx.get_data(), vec.get_data(), result->get_data(),
+        mtx.get_row_count(), mtx.get_column_count(), jobs);
 }
 
+namespace internals {
+
+//
+// Operands of a product : matrices and vectors are used in place,
+// expressions are evaluated first.
 template<typename real_t>
-inline matrix_NxM<real_t> operator*(const matrix_NxM<real_t>& lhs,
-                                    real_t k) {
-    matrix_NxM<real_t> result(lhs);
-    result *= k;
-    return result;
+inline const matrix_NxM<real_t>& dense_product_operand(
+    const matrix_NxM<real_t>& mtx
+    ) {
+    return mtx;
 }
 
 template<typename real_t>
-inline matrix_NxM<real_t> operator*(real_t k,
-                                    const matrix_NxM<real_t>& rhs,
-                                    ) {
-    return rhs * k;
+inline const vector_N<real_t>& dense_product_operand(
+    const vector_N<real_t>& vec
+    ) {
+    return vec;
 }
 
-template<typename real_t>
-inline matrix_NxM<real_t> operator/(const matrix_NxM<real_t>& lhs,
-                                    real_t k) {
-    matrix_NxM<real_t> result(lhs);
-    result /= k;
-    return result;
+template<typename expr>
+inline typename std::enable_if<
+    is_dense_shape<expr, dense_matrix_tag>::Yes && expr::is_dense_expr,
+    matrix_NxM<typename expr::value_type>
+>::type
+dense_product_operand(const expr& e) {
+    return matrix_NxM<typename expr::value_type>(e);
 }
 
-template<typename real_t>
-inline matrix_NxM<real_t> operator*(const matrix_NxM<real_t>& lhs,
-                                    const matrix_NxM<real_t>& rhs) {
-    assert(lhs.get_column_count() == rhs.get_row_count());
+template<typename expr>
+inline typename std::enable_if<
+    is_dense_shape<expr, dense_vector_tag>::Yes && expr::is_dense_expr,
+    vector_N<typename expr::value_type>
+>::type
+dense_product_operand(const expr& e) {
+    return vector_N<typename expr::value_type>(e);
+}
 
-    matrix_NxM<real_t> result(lhs.get_row_count(), rhs.get_column_count());
-    real_t* mat_C = result.get_data();
-
-    for (size_t i = 0; i < lhs.get_row_count(); ++i) {
-        for (size_t j = 0; j < rhs.get_column_count(); ++j) {
-            const size_t idx = i * result.get_column_count() + j;
-            mat_C[idx] = real_t(0);
-            for (size_t k = 0; k < lhs.get_row_count(); ++k) {
-                mat_C[idx] += lhs(i + 1, k + 1) * rhs(k + 1, j + 1);
-            }
-        }
-    }
+} // namespace internals
 
+/*!
+ * \brief   Matrix product. Operands that are expressions are evaluated 
+ *          first.
+ */
+template<typename L, typename R>
+inline typename std::enable_if<
+    internals::dense_pair<L, R>::Yes 
+        && internals::is_dense_shape<L, dense_matrix_tag>::Yes,
+    matrix_NxM<typename dense_traits<L>::value_type>
+>::type
+operator*(const L& lhs, const R& rhs) {
+    typedef typename dense_traits<L>::value_type real_t;
+    const matrix_NxM<real_t>& lhs_mtx = internals::dense_product_operand(lhs);
+    const matrix_NxM<real_t>& rhs_mtx = internals::dense_product_operand(rhs);
+
+    matrix_NxM<real_t> result;
+    matrix_product(lhs_mtx, rhs_mtx, &result);
     return result;
 }
 
-template<typename real_t>
-inline vector_N<real_t> operator*(const matrix_NxM<real_t>& mtx,
-                                  const vector_N<real_t>& vec) {
-    assert(mtx.get_column_count() == vec.get_dimension());
-
-    vector_N<real_t> vec_out(vec.get_dimension());
-    const real_t* in_data = vec.get_data();
-    real_t* out_data = vec_out.get_data();
-
-    for (size_t i = 0; i < mtx.get_row_count(); ++i) {
-        vec_out[i] = real_t(0);
-        for (size_t j = 0; j < mtx.get_column_count(); ++j) {
-            out_data[i] += mtx(i + 1, j + 1) * in_data[j];
-        }
-    }
-
-    return vec_out;
+/*!
+ * \brief   Matrix - vector product. Operands that are expressions are 
+ *          evaluated first.
+ */
+template<typename L, typename R>
+inline typename std::enable_if<
+    internals::is_dense_shape<L, dense_matrix_tag>::Yes 
+        && internals::is_dense_shape<R, dense_vector_tag>::Yes,
+    vector_N<typename dense_traits<L>::value_type>
+>::type
+operator*(const L& lhs, const R& rhs) {
+    typedef typename dense_traits<L>::value_type real_t;
+    const matrix_NxM<real_t>& mtx = internals::dense_product_operand(lhs);
+    const vector_N<real_t>& vec = internals::dense_product_operand(rhs);
+
+    vector_N<real_t> result(mtx.get_row_count());
+    matrix_vector_product(mtx, vec, &result);
+    return result;
 }
 
 /** @} */
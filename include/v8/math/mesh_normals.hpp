@@ -0,0 +1,189 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+/*!
+ * \file mesh_normals.hpp
+ * \brief Smooth vertex normals and tangents for indexed triangle meshes.
+ */
+
+#include <v8/v8.hpp>
+#include <v8/math/vector2.hpp>
+#include <v8/math/vector3.hpp>
+
+namespace v8 { namespace base {
+class job_system;
+} // namespace base
+} // namespace v8
+
+namespace v8 { namespace math {
+
+/** \addtogroup __grp_v8_math_mesh
+ *  @{
+ */
+
+/**
+ * \brief How the normals of the faces sharing a vertex are weighted when 
+ *      computing the vertex normal.
+ */
+enum Normal_Weight {
+    /**
+     * Faces contribute proportionally to their area. Cheapest, but long
+     * thin triangles dominate their neighbours.
+     */
+    Normal_Weight_Area,
+
+    /**
+     * Faces contribute proportionally to the angle of the triangle at the
+     * vertex. Independent of how the surface around the vertex is 
+     * tessellated.
+     */
+    Normal_Weight_Angle
+};
+
+/**
+ * \brief   Computes smooth (averaged) vertex normals for an indexed
+ *          triangle list.
+ * \param   positions           Pointer to the position of the first vertex.
+ * \param   position_stride     Distance in bytes between two positions.
+ * \param   normals             Pointer to the normal of the first vertex.
+ * \param   normal_stride       Distance in bytes between two normals.
+ * \param   vertex_count        Number of vertices.
+ * \param   indices             Vertex indices, three per face. Must be
+ *                              smaller than vertex_count.
+ * \param   face_count          Number of faces.
+ * \param   weighting           Face weighting scheme.
+ * \param   jobs                Optional, when not null the work is split 
+ *                              across the threads of the job system.
+ * \remarks When running on multiple threads, face corners are first 
+ *          partitioned by vertex range, so that each range is summed by a 
+ *          single task and no two threads write the same vertex. Faces are 
+ *          summed in the same order either way, so the result does not 
+ *          depend on the number of threads. Vertices that are not 
+ *          referenced by a non degenerate face get a zero normal. Normals 
+ *          and positions may be interleaved in the same vertex buffer.
+ */
+void compute_vertex_normals(
+    const vector3F*         positions,
+    v8_size_t               position_stride,
+    vector3F*               normals,
+    v8_size_t               normal_stride,
+    v8_size_t               vertex_count,
+    const v8_uint32_t*      indices,
+    v8_size_t               face_count,
+    Normal_Weight           weighting = Normal_Weight_Area,
+    base::job_system*       jobs = nullptr
+    );
+
+/**
+ * \brief   Computes per vertex tangents (direction of increasing u texture
+ *          coordinate), orthogonalized against the vertex normals.
+ * \param   normals     Vertex normals, must be unit length (eg: computed 
+ *                      with compute_vertex_normals).
+ * \remarks See compute_vertex_normals for the meaning of the other 
+ *          parameters. The face tangents (Lengyel's method) of the faces
+ *          sharing a vertex are summed, then made orthogonal to the vertex
+ *          normal. Vertices with no usable texture mapping get a zero 
+ *          tangent.
+ */
+void compute_vertex_tangents(
+    const vector3F*         positions,
+    v8_size_t               position_stride,
+    const vector3F*         normals,
+    v8_size_t               normal_stride,
+    const vector2F*         texcoords,
+    v8_size_t               texcoord_stride,
+    vector3F*               tangents,
+    v8_size_t               tangent_stride,
+    v8_size_t               vertex_count,
+    const v8_uint32_t*      indices,
+    v8_size_t               face_count,
+    base::job_system*       jobs = nullptr
+    );
+
+/**
+ * \brief   Computes vertex normals for an array of vertex structures.
+ *          Usage :
+ *  \code
+ *  std::vector<rendering::vertex_pn> vertices;
+ *  compute_vertex_normals(&vertices[0], vertices.size(), &indices[0], 
+ *                         indices.size() / 3, &rendering::vertex_pn::position,
+ *                         &rendering::vertex_pn::normal);
+ *  \endcode
+ */
+template<typename vertex_type>
+inline void compute_vertex_normals(
+    vertex_type*                vertices,
+    v8_size_t                   vertex_count,
+    const v8_uint32_t*          indices,
+    v8_size_t                   face_count,
+    vector3F vertex_type::*     position,
+    vector3F vertex_type::*     normal,
+    Normal_Weight               weighting = Normal_Weight_Area,
+    base::job_system*           jobs = nullptr
+    ) {
+    if (!vertex_count)
+        return;
+
+    compute_vertex_normals(
+        &(vertices[0].*position), sizeof(vertex_type), 
+        &(vertices[0].*normal), sizeof(vertex_type),
+        vertex_count, indices, face_count, weighting, jobs);
+}
+
+/**
+ * \brief   Computes vertex tangents for an array of vertex structures.
+ *          Normals must have been computed.
+ */
+template<typename vertex_type>
+inline void compute_vertex_tangents(
+    vertex_type*                vertices,
+    v8_size_t                   vertex_count,
+    const v8_uint32_t*          indices,
+    v8_size_t                   face_count,
+    vector3F vertex_type::*     position,
+    vector3F vertex_type::*     normal,
+    vector2F vertex_type::*     texcoord,
+    vector3F vertex_type::*     tangent,
+    base::job_system*           jobs = nullptr
+    ) {
+    if (!vertex_count)
+        return;
+
+    compute_vertex_tangents(
+        &(vertices[0].*position), sizeof(vertex_type), 
+        &(vertices[0].*normal), sizeof(vertex_type),
+        &(vertices[0].*texcoord), sizeof(vertex_type),
+        &(vertices[0].*tangent), sizeof(vertex_type),
+        vertex_count, indices, face_count, jobs);
+}
+
+/** @} */
+
+} // namespace math
+} // namespace v8
@@ -0,0 +1,272 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+/*!
+ * \file mesh_streams.hpp
+ * \brief Vertex data stored as one array per attribute.
+ */
+
+#include <memory>
+
+#include <v8/v8.hpp>
+#include <v8/math/vector2.hpp>
+#include <v8/math/vector3.hpp>
+
+namespace v8 { namespace math {
+
+/** \addtogroup __grp_v8_math_mesh
+ *  @{
+ */
+
+/**
+ * \brief Vertex attributes that can be stored by a mesh_streams object.
+ *      Values can be combined to form a stream mask.
+ */
+enum Mesh_Stream {
+    Mesh_Stream_Position    = 1 << 0,
+    Mesh_Stream_Normal      = 1 << 1,
+    Mesh_Stream_Tangent     = 1 << 2,
+    Mesh_Stream_Texcoord    = 1 << 3,
+    Mesh_Stream_All         = 0x0F
+};
+
+/**
+ * \brief Offset value for attributes that are not part of a vertex layout.
+ */
+const v8_int32_t C_No_Attribute = -1;
+
+/**
+ * \brief Describes where the attributes are stored inside an interleaved
+ *      vertex (eg : rendering::vertex_pn). Offsets are in bytes, from the 
+ *      start of the vertex.
+ */
+struct vertex_layout_t {
+    v8_size_t   vl_stride;
+    v8_int32_t  vl_position;
+    v8_int32_t  vl_normal;
+    v8_int32_t  vl_tangent;
+    v8_int32_t  vl_texcoord;
+};
+
+namespace internals {
+
+//
+// Only the position member deduces the vertex type, so that absent 
+// attributes can be passed as nullptr.
+template<typename vertex_type, typename attribute_type>
+struct vertex_member {
+    typedef attribute_type vertex_type::* type;
+};
+
+} // namespace internals
+
+/**
+ * \brief Builds the layout of a vertex structure. Usage :
+ *  \code
+ *  const vertex_layout_t layout(make_vertex_layout(
+ *      &rendering::vertex_pnt::position, &rendering::vertex_pnt::normal,
+ *      nullptr, &rendering::vertex_pnt::texcoord));
+ *  \endcode
+ */
+template<typename vertex_type>
+vertex_layout_t make_vertex_layout(
+    vector3F vertex_type::*     position,
+    typename internals::vertex_member<vertex_type, vector3F>::type 
+                                normal = nullptr,
+    typename internals::vertex_member<vertex_type, vector3F>::type 
+                                tangent = nullptr,
+    typename internals::vertex_member<vertex_type, vector2F>::type 
+                                texcoord = nullptr
+    ) {
+    const vertex_type vertex;
+    const char* base = reinterpret_cast<const char*>(&vertex);
+
+    vertex_layout_t layout;
+    layout.vl_stride = sizeof(vertex_type);
+    layout.vl_position = position ? static_cast<v8_int32_t>(
+        reinterpret_cast<const char*>(&(vertex.*position)) - base) : C_No_Attribute;
+    layout.vl_normal = normal ? static_cast<v8_int32_t>(
+        reinterpret_cast<const char*>(&(vertex.*normal)) - base) : C_No_Attribute;
+    layout.vl_tangent = tangent ? static_cast<v8_int32_t>(
+        reinterpret_cast<const char*>(&(vertex.*tangent)) - base) : C_No_Attribute;
+    layout.vl_texcoord = texcoord ? static_cast<v8_int32_t>(
+        reinterpret_cast<const char*>(&(vertex.*texcoord)) - base) : C_No_Attribute;
+    return layout;
+}
+
+/**
+ * \brief Mesh vertices, with each attribute stored in its own array 
+ *      (stream), so that a pass that only needs positions (culling, 
+ *      depth/shadow rendering, bounding volumes) only reads positions.
+ * \remarks Streams are aligned to C_Stream_Alignment bytes and padded, so
+ *      that kernels may read and write up to C_Stream_Alignment bytes past 
+ *      the last element. Converting to and from interleaved vertices is done
+ *      with interleave() and deinterleave().
+ */
+class mesh_streams {
+public :
+    /**
+     * \brief Alignment (in bytes) of the start of every stream.
+     */
+    static const v8_size_t C_Stream_Alignment = 16;
+
+    explicit mesh_streams(v8_uint32_t stream_mask = Mesh_Stream_All);
+
+    /**
+     * \brief Selects the stored attributes. Data of the streams that are 
+     *      kept is preserved, new streams are zero filled.
+     */
+    void set_stream_mask(v8_uint32_t stream_mask);
+
+    v8_uint32_t get_stream_mask() const {
+        return stream_mask_;
+    }
+
+    v8_bool_t has_stream(Mesh_Stream stream) const {
+        return (stream_mask_ & stream) != 0;
+    }
+
+    v8_size_t get_vertex_count() const {
+        return vertex_count_;
+    }
+
+    /**
+     * \brief Changes the number of vertices. Existing values are preserved,
+     *      new vertices are zero filled.
+     */
+    void resize(v8_size_t vertex_count);
+
+    void reserve(v8_size_t vertex_count);
+
+    void clear() {
+        vertex_count_ = 0;
+    }
+
+    /**
+     * \name Stream access. Return null for streams that are not stored.
+     *  @{
+     */
+
+    vector3F* positions() {
+        return static_cast<vector3F*>(streams_[k_position].sb_data);
+    }
+
+    const vector3F* positions() const {
+        return static_cast<const vector3F*>(streams_[k_position].sb_data);
+    }
+
+    vector3F* normals() {
+        return static_cast<vector3F*>(streams_[k_normal].sb_data);
+    }
+
+    const vector3F* normals() const {
+        return static_cast<const vector3F*>(streams_[k_normal].sb_data);
+    }
+
+    vector3F* tangents() {
+        return static_cast<vector3F*>(streams_[k_tangent].sb_data);
+    }
+
+    const vector3F* tangents() const {
+        return static_cast<const vector3F*>(streams_[k_tangent].sb_data);
+    }
+
+    vector2F* texcoords() {
+        return static_cast<vector2F*>(streams_[k_texcoord].sb_data);
+    }
+
+    const vector2F* texcoords() const {
+        return static_cast<const vector2F*>(streams_[k_texcoord].sb_data);
+    }
+
+    /**
+     * \brief Raw data of a single stream, eg: to upload the positions alone
+     *      into a vertex buffer for a depth only pass. The stream holds 
+     *      get_vertex_count() elements of get_stream_element_size() bytes.
+     */
+    const void* get_stream_data(Mesh_Stream stream) const;
+
+    static v8_size_t get_stream_element_size(Mesh_Stream stream);
+
+    /** @} */
+
+    /**
+     * \brief Writes the attributes of vertices [first, first + count) to
+     *      an array of interleaved vertices. Attributes that are not part of
+     *      the layout, or not stored, are skipped.
+     * \param vertices  Receives vertex first at vertices[0].
+     */
+    void interleave(
+        void*                   vertices,
+        const vertex_layout_t&  layout,
+        v8_size_t               first,
+        v8_size_t               count
+        ) const;
+
+    /**
+     * \brief Replaces the content of the streams with count interleaved 
+     *      vertices. Stored attributes that are missing from the layout are
+     *      zero filled.
+     */
+    void deinterleave(
+        const void*             vertices,
+        const vertex_layout_t&  layout,
+        v8_size_t               count
+        );
+
+    void swap(mesh_streams& rhs);
+
+private :
+    enum {
+        k_position,
+        k_normal,
+        k_tangent,
+        k_texcoord,
+        k_stream_count
+    };
+
+    struct stream_buffer_t {
+        std::unique_ptr<v8_uint8_t[]>   sb_storage;
+        void*                           sb_data;
+    };
+
+    void reallocate(v8_size_t capacity);
+
+    stream_buffer_t     streams_[k_stream_count];
+    v8_uint32_t         stream_mask_;
+    v8_size_t           vertex_count_;
+    v8_size_t           capacity_;
+
+    NO_CC_ASSIGN(mesh_streams);
+};
+
+/** @} */
+
+} // namespace math
+} // namespace v8
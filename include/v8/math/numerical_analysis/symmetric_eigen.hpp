@@ -0,0 +1,220 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+/*!
+ * \file symmetric_eigen.hpp
+ * \brief Eigenvalues and eigenvectors of symmetric 3x3 matrices.
+ */
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+
+#include <v8/v8.hpp>
+#include <v8/math/matrix3X3.hpp>
+#include <v8/math/vector3.hpp>
+
+namespace v8 { namespace base {
+class job_system;
+} // namespace base
+} // namespace v8
+
+namespace v8 { namespace math {
+
+/*! \addtogroup Algebra
+ *  @{
+ */
+
+/**
+ * \brief Upper bound on the number of Jacobi sweeps. A sweep annihilates 
+ *        each off diagonal element once; convergence is quadratic, so 
+ *        well under 10 sweeps are needed in practice.
+ */
+const int C_Jacobi_Max_Sweeps = 32;
+
+/**
+ * \brief   Computes the eigenvalues and eigenvectors of a symmetric matrix, 
+ *          using the cyclic Jacobi method. Only the upper triangle of the 
+ *          matrix is read.
+ * \param   mtx             Symmetric matrix.
+ * \param   eigenvalues     Receives the eigenvalues, in decreasing order.
+ * \param   eigenvectors    Receives the unit eigenvectors, as columns, in 
+ *                          the same order as the eigenvalues. The columns 
+ *                          form a right handed orthonormal basis.
+ * \remarks Jacobi rotations are slower than the closed form (cubic root) 
+ *          solution, but stay accurate for nearly repeated eigenvalues, 
+ *          which are common for covariance matrices of symmetric shapes.
+ */
+template<typename real_t>
+void eigen_decompose_symmetric(
+    const matrix_3X3<real_t>&   mtx,
+    vector3<real_t>*            eigenvalues,
+    matrix_3X3<real_t>*         eigenvectors
+    );
+
+/**
+ * \brief   Decomposes an array of symmetric matrices, as 
+ *          eigen_decompose_symmetric. With V8_MATH_SIMD_ENABLED, four 
+ *          matrices are decomposed at a time, one per SIMD lane.
+ * \param   jobs    Optional (can be null); distributes the matrices.
+ */
+void eigen_decompose_symmetric_batch(
+    const matrix_3X3<float>*    matrices,
+    size_t                      count,
+    vector3<float>*             eigenvalues,
+    matrix_3X3<float>*          eigenvectors,
+    base::job_system*           jobs = nullptr
+    );
+
+/** @} */
+
+namespace internals {
+
+/**
+ * \brief   Sorts the eigenpairs by decreasing eigenvalue and makes the 
+ *          eigenvectors (the columns of v, row major) a right handed basis.
+ */
+template<typename real_t>
+void sort_eigen_pairs(real_t* values, real_t (&v)[3][3]) {
+    for (int i = 0; i < 2; ++i) {
+        int largest = i;
+        for (int j = i + 1; j < 3; ++j) {
+            if (values[j] > values[largest])
+                largest = j;
+        }
+
+        if (largest == i)
+            continue;
+
+        const real_t tmp = values[i];
+        values[i] = values[largest];
+        values[largest] = tmp;
+        for (int row = 0; row < 3; ++row) {
+            const real_t val = v[row][i];
+            v[row][i] = v[row][largest];
+            v[row][largest] = val;
+        }
+    }
+
+    const real_t det = 
+        v[0][0] * (v[1][1] * v[2][2] - v[1][2] * v[2][1])
+        - v[0][1] * (v[1][0] * v[2][2] - v[1][2] * v[2][0])
+        + v[0][2] * (v[1][0] * v[2][1] - v[1][1] * v[2][0]);
+
+    if (det < real_t(0)) {
+        for (int row = 0; row < 3; ++row)
+            v[row][2] = -v[row][2];
+    }
+}
+
+} // namespace internals
+
+} // namespace math
+} // namespace v8
+
+template<typename real_t>
+void v8::math::eigen_decompose_symmetric(
+    const matrix_3X3<real_t>&   mtx,
+    vector3<real_t>*            eigenvalues,
+    matrix_3X3<real_t>*         eigenvectors
+    ) {
+    real_t a[3][3] = {
+        { mtx.a11_, mtx.a12_, mtx.a13_ },
+        { mtx.a12_, mtx.a22_, mtx.a23_ },
+        { mtx.a13_, mtx.a23_, mtx.a33_ }
+    };
+
+    real_t v[3][3] = {
+        { real_t(1), real_t(0), real_t(0) },
+        { real_t(0), real_t(1), real_t(0) },
+        { real_t(0), real_t(0), real_t(1) }
+    };
+
+    const real_t epsilon = std::numeric_limits<real_t>::epsilon();
+
+    for (int sweep = 0; sweep < C_Jacobi_Max_Sweeps; ++sweep) {
+        const real_t off_diagonal = 
+            a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+        const real_t diagonal = 
+            a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+
+        if (off_diagonal <= epsilon * epsilon * diagonal)
+            break;
+
+        for (int p = 0; p < 2; ++p) {
+            for (int q = p + 1; q < 3; ++q) {
+                const real_t apq = a[p][q];
+                if (apq == real_t(0))
+                    continue;
+
+                //
+                // Rotation in the (p, q) plane that zeroes a[p][q]; t is the
+                // smaller root of t^2 + 2 * theta * t - 1 = 0.
+                const real_t theta = (a[q][q] - a[p][p]) / (real_t(2) * apq);
+                real_t t = real_t(1) 
+                    / (std::abs(theta) + std::sqrt(theta * theta + real_t(1)));
+                if (theta < real_t(0))
+                    t = -t;
+
+                const real_t c = real_t(1) / std::sqrt(t * t + real_t(1));
+                const real_t s = t * c;
+
+                for (int k = 0; k < 3; ++k) {
+                    const real_t akp = a[k][p];
+                    const real_t akq = a[k][q];
+                    a[k][p] = c * akp - s * akq;
+                    a[k][q] = s * akp + c * akq;
+                }
+
+                for (int k = 0; k < 3; ++k) {
+                    const real_t apk = a[p][k];
+                    const real_t aqk = a[q][k];
+                    a[p][k] = c * apk - s * aqk;
+                    a[q][k] = s * apk + c * aqk;
+                }
+
+                for (int k = 0; k < 3; ++k) {
+                    const real_t vkp = v[k][p];
+                    const real_t vkq = v[k][q];
+                    v[k][p] = c * vkp - s * vkq;
+                    v[k][q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+
+    real_t values[3] = { a[0][0], a[1][1], a[2][2] };
+    internals::sort_eigen_pairs(values, v);
+
+    for (int i = 0; i < 3; ++i) {
+        eigenvalues->elements_[i] = values[i];
+        for (int j = 0; j < 3; ++j)
+            eigenvectors->elements_[i * 3 + j] = v[i][j];
+    }
+}
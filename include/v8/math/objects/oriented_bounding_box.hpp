@@ -26,6 +26,8 @@
 
 #pragma once
 
+#include <cmath>
+
 #include <v8/math/vector3.hpp>
 
 namespace v8 { namespace math {
@@ -56,7 +58,7 @@ public :
 public :
     oriented_bounding_box3() {}
 
-    oriented_bounding_box(
+    oriented_bounding_box3(
         const vector3_t& origin,
         const vector3_t& x_axis,
         const vector3_t& y_axis,
@@ -74,24 +76,30 @@ public :
         extents_[2] = extent_z_axis;
     }
 
+    /**
+     * \brief   Computes the corners of the smallest axis aligned box that
+     *          encloses the oriented box.
+     */
     void get_min_max_points(
-        vector_t* minpt,
-        vector_t* maxpt
-        );
+        vector3_t* minpt,
+        vector3_t* maxpt
+        ) const;
 };
 
 template<typename real_t>
 void oriented_bounding_box3<real_t>::get_min_max_points(
     vector3<real_t>* minpt,
     vector3<real_t>* maxpt
-    ) {
-    minpt->x_ = -extents_[0] * vec_R_;
-    minpt->y_ = -extents_[1] * vec_U_;
-    minpt->z_ = -extents_[2] * vec_D_;
+    ) const {
+    for (int i = 0; i < 3; ++i) {
+        const real_t half_width = 
+            extents_[0] * std::abs(vec_R_.elements_[i])
+            + extents_[1] * std::abs(vec_U_.elements_[i])
+            + extents_[2] * std::abs(vec_D_.elements_[i]);
 
-    maxpt->x_ = extents_[0] * vec_R_;
-    maxpt->y_ = extents_[1] * vec_U_;
-    maxpt->z_ = extents_[2] * vec_D_;
+        minpt->elements_[i] = origin_.elements_[i] - half_width;
+        maxpt->elements_[i] = origin_.elements_[i] + half_width;
+    }
 }
 
 /**
@@ -106,8 +114,5 @@ typedef oriented_bounding_box3<float>   oriented_bounding_box3F;
  */
 typedef oriented_bounding_box3<double>  oriented_bounding_box3D;
 
-//
-// TODO : add functions to construct OOBB from a set of points.
-
 } // namespace math
 } // namespace v8
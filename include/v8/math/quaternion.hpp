@@ -49,6 +49,10 @@ namespace v8 { namespace math {
 template<typename real_t>
 class quaternion {
 public :
+    enum { 
+        is_floating_point = base::is_floating_point_type<real_t>::Yes
+    };
+
     /** Type of components. */
     typedef real_t              element_type;
 
@@ -362,6 +366,36 @@ operator/(
     const real_t scalar    
     );
 
+/**
+ \brief Normalized linear interpolation between two unit quaternions, along
+        the shortest arc. Cheaper than slerp, but the angular velocity is not
+        constant.
+ \param t   Interpolation parameter, in the [0, 1] range.
+ */
+template<typename real_t>
+math::quaternion<real_t>
+nlerp(
+    const math::quaternion<real_t>& q0,
+    const math::quaternion<real_t>& q1,
+    const real_t t
+    );
+
+/**
+ \brief Spherical linear interpolation between two unit quaternions, along
+        the shortest arc.
+ \param t   Interpolation parameter, in the [0, 1] range.
+ \remarks   When the quaternions are almost parallel, nlerp is used, to 
+            avoid a division by a sine close to zero. See quaternion_batch.hpp
+            for a version that interpolates arrays of quaternions.
+ */
+template<typename real_t>
+math::quaternion<real_t>
+slerp(
+    const math::quaternion<real_t>& q0,
+    const math::quaternion<real_t>& q1,
+    const real_t t
+    );
+
 typedef quaternion<float>       quaternionF;
 
 typedef quaternion<double>      quaternionD;
@@ -232,7 +232,7 @@ v8::math::quaternion<real_t>::normalize() {
     if (math::operands_eq(real_t(0), len_sq))
         return make_zero();
 
-    const real_t scale_factor = real_t(1) / len_sq;
+    const real_t scale_factor = real_t(1) / std::sqrt(len_sq);
     w_ *= scale_factor;
     x_ *= scale_factor;
     y_ *= scale_factor;
@@ -492,7 +492,7 @@ v8::math::operator*(
     const real_t scalar
     ) {
     quaternion<real_t> result(lhs);
-    return lhs *= scalar;
+    return result *= scalar;
 }
 
 template<typename real_t>
@@ -514,3 +514,47 @@ v8::math::operator/(
     quaternion<real_t> result(lhs);
     return result /= scalar;
 }
+
+template<typename real_t>
+v8::math::quaternion<real_t>
+v8::math::nlerp(
+    const v8::math::quaternion<real_t>& q0,
+    const v8::math::quaternion<real_t>& q1,
+    const real_t t
+    ) {
+    const real_t s1 = dot_product(q0, q1) < real_t(0) ? -t : t;
+    const real_t s0 = real_t(1) - t;
+
+    quaternion<real_t> result(
+        s0 * q0.w_ + s1 * q1.w_, s0 * q0.x_ + s1 * q1.x_,
+        s0 * q0.y_ + s1 * q1.y_, s0 * q0.z_ + s1 * q1.z_);
+    return result.normalize();
+}
+
+template<typename real_t>
+v8::math::quaternion<real_t>
+v8::math::slerp(
+    const v8::math::quaternion<real_t>& q0,
+    const v8::math::quaternion<real_t>& q1,
+    const real_t t
+    ) {
+    real_t cos_theta = dot_product(q0, q1);
+    real_t sign = real_t(1);
+
+    if (cos_theta < real_t(0)) {
+        cos_theta = -cos_theta;
+        sign = real_t(-1);
+    }
+
+    if (cos_theta > real_t(0.9995))
+        return nlerp(q0, q1, t);
+
+    const real_t theta = std::acos(cos_theta);
+    const real_t inv_sin_theta = real_t(1) / std::sin(theta);
+    const real_t s0 = std::sin((real_t(1) - t) * theta) * inv_sin_theta;
+    const real_t s1 = sign * std::sin(t * theta) * inv_sin_theta;
+
+    return quaternion<real_t>(
+        s0 * q0.w_ + s1 * q1.w_, s0 * q0.x_ + s1 * q1.x_,
+        s0 * q0.y_ + s1 * q1.y_, s0 * q0.z_ + s1 * q1.z_);
+}
@@ -0,0 +1,212 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+/*!
+ * \file quaternion_batch.hpp
+ * \brief Quaternion operations on arrays stored in SoA layout 
+ *      (interpolation, composition, vector rotation, conversion to matrix).
+ *      Four elements are processed at a time when V8_MATH_ENABLE_SIMD is 
+ *      defined, otherwise the functions are plain loops over the scalar 
+ *      code.
+ */
+
+#include <v8/v8.hpp>
+#include <v8/math/matrix3X3.hpp>
+
+namespace v8 { namespace math {
+
+/** \addtogroup __grp_v8_math_simd
+ *  @{
+ */
+
+/**
+ * \brief   An array of quaternions, one array per component.
+ */
+struct quaternion_soa_t {
+    float*  qs_w;
+    float*  qs_x;
+    float*  qs_y;
+    float*  qs_z;
+};
+
+/**
+ * \brief   Read only array of quaternions, one array per component.
+ */
+struct const_quaternion_soa_t {
+    const float*    qs_w;
+    const float*    qs_x;
+    const float*    qs_y;
+    const float*    qs_z;
+
+    const_quaternion_soa_t() {}
+
+    const_quaternion_soa_t(
+        const float* w, const float* x, const float* y, const float* z
+        )
+        : qs_w(w), qs_x(x), qs_y(y), qs_z(z) {}
+
+    const_quaternion_soa_t(const quaternion_soa_t& q)
+        : qs_w(q.qs_w), qs_x(q.qs_x), qs_y(q.qs_y), qs_z(q.qs_z) {}
+};
+
+/**
+ * \brief   An array of 3 component vectors, one array per component.
+ */
+struct vector3_soa_t {
+    float*  vs_x;
+    float*  vs_y;
+    float*  vs_z;
+};
+
+/**
+ * \brief   Read only array of 3 component vectors, one array per component.
+ */
+struct const_vector3_soa_t {
+    const float*    vs_x;
+    const float*    vs_y;
+    const float*    vs_z;
+
+    const_vector3_soa_t() {}
+
+    const_vector3_soa_t(const float* x, const float* y, const float* z)
+        : vs_x(x), vs_y(y), vs_z(z) {}
+
+    const_vector3_soa_t(const vector3_soa_t& v)
+        : vs_x(v.vs_x), vs_y(v.vs_y), vs_z(v.vs_z) {}
+};
+
+/**
+ * \brief   How quaternion_slerp_batch evaluates the interpolation weights.
+ */
+enum Slerp_Mode {
+    /**
+     * \brief   sin((1 - t)A) / sin(A) and sin(tA) / sin(A), with 
+     *          polynomial approximations of acos and sin. Max error versus 
+     *          a double precision slerp is 5.2e-7 per component. Falls back 
+     *          to nlerp for angles below ~1.8 degrees, like slerp().
+     */
+    Slerp_Mode_Exact,
+
+    /**
+     * \brief   Eberly's polynomial approximation of the weights 
+     *          ("A Fast and Accurate Algorithm for Computing SLERP"), 
+     *          no division, no branches, no transcendental functions. 
+     *          The weights are within 1.9e-5 of the exact ones; max error 
+     *          versus a double precision slerp is 2.9e-5 per component, 
+     *          the result is not renormalized.
+     */
+    Slerp_Mode_Fast
+};
+
+/**
+ * \brief   out[i] = nlerp(a[i], b[i], t[i]), along the shortest arc.
+ * \remarks Inputs must be unit quaternions. The output may be one of the 
+ *          inputs.
+ */
+void quaternion_nlerp_batch(
+    const const_quaternion_soa_t&   a,
+    const const_quaternion_soa_t&   b,
+    const float*                    t,
+    const quaternion_soa_t&         out,
+    v8_size_t                       count
+    );
+
+/**
+ * \brief   out[i] = nlerp(a[i], b[i], t), same parameter for all elements.
+ */
+void quaternion_nlerp_batch(
+    const const_quaternion_soa_t&   a,
+    const const_quaternion_soa_t&   b,
+    float                           t,
+    const quaternion_soa_t&         out,
+    v8_size_t                       count
+    );
+
+/**
+ * \brief   out[i] = slerp(a[i], b[i], t[i]), along the shortest arc.
+ * \remarks Inputs must be unit quaternions. The output may be one of the 
+ *          inputs. See Slerp_Mode for the accuracy of each mode.
+ */
+void quaternion_slerp_batch(
+    const const_quaternion_soa_t&   a,
+    const const_quaternion_soa_t&   b,
+    const float*                    t,
+    const quaternion_soa_t&         out,
+    v8_size_t                       count,
+    Slerp_Mode                      mode = Slerp_Mode_Exact
+    );
+
+/**
+ * \brief   out[i] = slerp(a[i], b[i], t), same parameter for all elements.
+ */
+void quaternion_slerp_batch(
+    const const_quaternion_soa_t&   a,
+    const const_quaternion_soa_t&   b,
+    float                           t,
+    const quaternion_soa_t&         out,
+    v8_size_t                       count,
+    Slerp_Mode                      mode = Slerp_Mode_Exact
+    );
+
+/**
+ * \brief   out[i] = a[i] * b[i]. The output may be one of the inputs.
+ */
+void quaternion_multiply_batch(
+    const const_quaternion_soa_t&   a,
+    const const_quaternion_soa_t&   b,
+    const quaternion_soa_t&         out,
+    v8_size_t                       count
+    );
+
+/**
+ * \brief   Rotates v[i] by the unit quaternion q[i] (same formula as 
+ *          quaternion::rotate_vector). The output may be the input.
+ */
+void quaternion_rotate_batch(
+    const const_quaternion_soa_t&   q,
+    const const_vector3_soa_t&      v,
+    const vector3_soa_t&            out,
+    v8_size_t                       count
+    );
+
+/**
+ * \brief   Converts each quaternion to a rotation matrix (same result as 
+ *          the upper 3x3 block of quaternion::extract_rotation_matrix).
+ * \remarks The quaternions need not be unit length.
+ */
+void quaternion_to_matrix_batch(
+    const const_quaternion_soa_t&   q,
+    matrix_3X3F*                    out,
+    v8_size_t                       count
+    );
+
+/** @} */
+
+} // namespace math
+} // namespace v8
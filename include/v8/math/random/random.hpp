@@ -30,27 +30,66 @@
 /// \file random.hpp    Random number generators.
 
 #include <v8/v8.hpp>
-#include <v8/math/random/mtrand.h>
+#include <v8/math/random/random_engines.hpp>
+#include <v8/math/simd/float4.hpp>
 
 namespace v8 { namespace math {
 
+namespace internals {
+
+///
+/// \brief Returns a different seed on every call (thread safe). Used to seed
+/// default constructed generators, so that they produce different sequences.
+v8_uint64_t next_default_seed();
+
+} // namespace internals
+
 ///
-/// \brief  Random number generator class.
-class random {
+/// \brief  Random number generator class. 
+/// \remarks The engine_type parameter selects the algorithm used to 
+/// generate random bits (see random_engines.hpp). All state is per instance,
+/// an instance must not be used from multiple threads at the same time, 
+/// but separate instances can. For deterministic parallel generation, give 
+/// each thread its own stream with split().
+template<typename engine_type>
+class random_generator {
 public :
-    random()
-        :   rng_()
+    typedef engine_type     engine_t;
+
+    ///
+    /// Each default constructed generator gets a different seed.
+    random_generator()
+        :   rng_(internals::next_default_seed())
     {}
 
-    random(const v8_uint32_t seed)
+    random_generator(const v8_uint32_t seed)
         :   rng_(seed)
     {}
 
+    explicit random_generator(const engine_type& engine)
+        :   rng_(engine)
+    {}
+
 public :
 
+    ///
+    /// Returns a generator for the specified stream. The result only 
+    /// depends on this generator's state and the stream index.
+    random_generator<engine_type> split(const v8_uint32_t stream_index) const {
+        return random_generator<engine_type>(rng_.split(stream_index));
+    }
+
+    engine_type& engine() { 
+        return rng_; 
+    }
+
+    const engine_type& engine() const { 
+        return rng_; 
+    }
+
     ///
     /// Returns a non negative random number.
-    v8_uint32_t next() { return rng_(); }
+    v8_uint32_t next() { return rng_.next_uint32(); }
 
     ///
     /// Returns a random non negative integer, in the [0, max) range.
@@ -80,8 +119,9 @@ public :
 
     ///
     /// Returns a random floating point number in the [0, 1) range.
+    /// Only the upper 24 bits are used, since a float cannot represent more.
     float next_float() {
-        return static_cast<float>(next()) * (1.f / 4294967296.f);
+        return static_cast<float>(next() >> 8) * (1.f / 16777216.f); // divided by 2^24
     }
 
     ///
@@ -90,14 +130,68 @@ public :
         return static_cast<float>(next()) * (1.f / 4294967295.f);
     }
 
-private :
-    ///< Mersenne twister rng.
-    MTRand_int32    rng_;
+    ///
+    /// Fills an array with random numbers.
+    void fill(v8_uint32_t* dst, const v8_size_t count) {
+        for (v8_size_t i = 0; i < count; ++i) {
+            dst[i] = next();
+        }
+    }
+
+    ///
+    /// Fills an array with random numbers in the [0, 1) range. Gives the 
+    /// same values as count calls to next_float(). 
+    void fill(float* dst, const v8_size_t count) {
+        fill(dst, count, 0.0f, 1.0f);
+    }
+
+    ///
+    /// Fills an array with random numbers in the [min, max) range.
+    /// \remarks The random bits are generated in batches and converted to 
+    /// floats four at a time.
+    void fill(float* dst, v8_size_t count, const float min, const float max) {
+        const v8_size_t k_batch_size = 64;
+        v8_uint32_t bits[k_batch_size];
+
+        const simd::float4_t scale = simd::splat_float4(max - min);
+        const simd::float4_t offset = simd::splat_float4(min);
+
+        while (count) {
+            const v8_size_t batch = count < k_batch_size ? count : k_batch_size;
+            fill(bits, batch);
+
+            v8_size_t i = 0;
+            for (; i + 4 <= batch; i += 4) {
+                simd::store_float4(dst + i, simd::add(
+                    simd::mul(simd::unit_float4_from_bits(bits + i), scale), 
+                    offset));
+            }
+
+            for (; i < batch; ++i) {
+                dst[i] = static_cast<float>(bits[i] >> 8) * (1.f / 16777216.f)
+                         * (max - min) + min;
+            }
+
+            dst += batch;
+            count -= batch;
+        }
+    }
 
 private :
-    NO_CC_ASSIGN(random);    
+    engine_type     rng_;
 };    
 
+///
+/// \brief Mersenne twister based generator.
+typedef random_generator<mt19937_engine>        random;
+
+///
+/// \brief Fast generator with small state and non overlapping streams.
+typedef random_generator<xoshiro256ss_engine>   random_xoshiro;
+
+///
+/// \brief Fast generator with the smallest state and O(log n) jump ahead.
+typedef random_generator<pcg32_engine>          random_pcg;
+
 } // namespace math
 } // namespace v8
-
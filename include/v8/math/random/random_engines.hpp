@@ -0,0 +1,274 @@
+//
+// Copyright (c) 2011, 2012, 2013 Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+///
+/// \file random_engines.hpp    Uniform random bit generators, used by the 
+/// random_generator class. Every engine has per instance state, so separate
+/// instances can be used from separate threads without locking. 
+/// An engine provides :
+///     - a constructor and a seed() function taking a 64 bit seed;
+///     - next_uint32(), returning 32 uniformly distributed random bits;
+///     - split(stream_index), returning an engine for the specified stream.
+///       Streams derived from the same engine are deterministic, so work
+///       can be split across threads and still give repeatable results.
+
+#include <v8/v8.hpp>
+#include <v8/math/random/mtrand.h>
+
+namespace v8 { namespace math {
+
+///
+/// \brief SplitMix64 step. Used to expand 64 bit seeds into engine state.
+inline v8_uint64_t splitmix64_next(v8_uint64_t* state) {
+    v8_uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+///
+/// \brief Mersenne twister (MT19937). Long period, but a large state (624
+/// unsigned long words in MTRand_int32 : 2.5KB with 32 bit longs, 5KB on LP64
+/// targets) and no cheap jump ahead. Streams are derived by reseeding, so they are 
+/// statistically independent, but not guaranteed not to overlap.
+class mt19937_engine {
+public :
+    explicit mt19937_engine(const v8_uint64_t seed_val = 5489ULL) {
+        seed(seed_val);
+    }
+
+    ///
+    /// \brief The whole 64 bit seed is expanded with SplitMix64 into the
+    /// initialization array of the generator (init_by_array), so seeds that
+    /// differ only in their upper 32 bits give different sequences.
+    void seed(const v8_uint64_t seed_val) {
+        seed_ = seed_val;
+
+        v8_uint64_t sm_state = seed_val;
+        unsigned long init_array[k_init_words];
+        for (int i = 0; i < k_init_words; i += 2) {
+            const v8_uint64_t bits = splitmix64_next(&sm_state);
+            init_array[i] = static_cast<unsigned long>(bits & 0xFFFFFFFFULL);
+            init_array[i + 1] = static_cast<unsigned long>(bits >> 32);
+        }
+
+        rng_.seed(init_array, k_init_words);
+    }
+
+    v8_uint32_t next_uint32() {
+        return static_cast<v8_uint32_t>(rng_());
+    }
+
+    mt19937_engine split(const v8_uint32_t stream_index) const {
+        v8_uint64_t sm_state = seed_ ^ (static_cast<v8_uint64_t>(stream_index) 
+                                        << 32);
+        return mt19937_engine(splitmix64_next(&sm_state));
+    }
+
+private :
+    //! 32 bit words of the initialization array.
+    static const int k_init_words = 4;
+
+    MTRand_int32    rng_;
+    v8_uint64_t     seed_;
+};
+
+///
+/// \brief xoshiro256** (Blackman, Vigna). 256 bits of state, period 2^256 - 1.
+/// jump() advances the sequence by 2^128 steps and long_jump() by 2^192, 
+/// so streams obtained with split() never overlap.
+class xoshiro256ss_engine {
+public :
+    explicit xoshiro256ss_engine(const v8_uint64_t seed_val = 5489ULL) {
+        seed(seed_val);
+    }
+
+    void seed(const v8_uint64_t seed_val) {
+        v8_uint64_t sm_state = seed_val;
+        for (int i = 0; i < 4; ++i) {
+            s_[i] = splitmix64_next(&sm_state);
+        }
+    }
+
+    v8_uint64_t next_uint64() {
+        const v8_uint64_t result = rotl(s_[1] * 5, 7) * 9;
+        const v8_uint64_t t = s_[1] << 17;
+
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = rotl(s_[3], 45);
+
+        return result;
+    }
+
+    ///
+    /// The upper bits are the ones with the best statistical quality.
+    v8_uint32_t next_uint32() {
+        return static_cast<v8_uint32_t>(next_uint64() >> 32);
+    }
+
+    ///
+    /// \brief Equivalent to 2^128 calls to next_uint64().
+    void jump() {
+        static const v8_uint64_t k_jump[] = {
+            0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL, 
+            0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL
+        };
+        apply_jump(k_jump);
+    }
+
+    ///
+    /// \brief Equivalent to 2^192 calls to next_uint64().
+    void long_jump() {
+        static const v8_uint64_t k_long_jump[] = {
+            0x76E15D3EFEFDCBBFULL, 0xC5004E441C522FB3ULL, 
+            0x77710069854EE241ULL, 0x39109BB02ACBE635ULL
+        };
+        apply_jump(k_long_jump);
+    }
+
+    ///
+    /// \brief Stream i starts (i + 1) * 2^128 steps ahead of this engine.
+    /// \remarks Costs one jump per stream index, call with small indices or
+    /// split incrementally (split(0) of split(0) ...).
+    xoshiro256ss_engine split(const v8_uint32_t stream_index) const {
+        xoshiro256ss_engine stream(*this);
+        for (v8_uint32_t i = 0; i <= stream_index; ++i) {
+            stream.jump();
+        }
+        return stream;
+    }
+
+private :
+    static v8_uint64_t rotl(const v8_uint64_t x, const int k) {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    void apply_jump(const v8_uint64_t (&poly)[4]) {
+        v8_uint64_t s0 = 0;
+        v8_uint64_t s1 = 0;
+        v8_uint64_t s2 = 0;
+        v8_uint64_t s3 = 0;
+
+        for (int i = 0; i < 4; ++i) {
+            for (int b = 0; b < 64; ++b) {
+                if (poly[i] & (1ULL << b)) {
+                    s0 ^= s_[0];
+                    s1 ^= s_[1];
+                    s2 ^= s_[2];
+                    s3 ^= s_[3];
+                }
+                next_uint64();
+            }
+        }
+
+        s_[0] = s0;
+        s_[1] = s1;
+        s_[2] = s2;
+        s_[3] = s3;
+    }
+
+    v8_uint64_t     s_[4];
+};
+
+///
+/// \brief PCG32 (O'Neill), XSH-RR variant. 64 bits of state, 2^63 
+/// selectable streams and O(log n) jump ahead (see advance()). 
+/// split() selects a different stream, starting from the same state.
+class pcg32_engine {
+public :
+    explicit pcg32_engine(
+        const v8_uint64_t seed_val = 5489ULL, 
+        const v8_uint64_t stream = 0xDA3E39CB94B95BDBULL
+        ) {
+        seed(seed_val, stream);
+    }
+
+    void seed(const v8_uint64_t seed_val) {
+        seed(seed_val, inc_ >> 1);
+    }
+
+    void seed(const v8_uint64_t seed_val, const v8_uint64_t stream) {
+        state_ = 0;
+        inc_ = (stream << 1) | 1;
+        next_uint32();
+        state_ += seed_val;
+        next_uint32();
+    }
+
+    v8_uint32_t next_uint32() {
+        const v8_uint64_t old_state = state_;
+        state_ = old_state * k_multiplier + inc_;
+
+        const v8_uint32_t xor_shifted = 
+            static_cast<v8_uint32_t>(((old_state >> 18) ^ old_state) >> 27);
+        const v8_uint32_t rot = static_cast<v8_uint32_t>(old_state >> 59);
+        return (xor_shifted >> rot) | (xor_shifted << ((32 - rot) & 31));
+    }
+
+    ///
+    /// \brief Advances the sequence by delta steps, in O(log(delta)) time
+    /// (Brown, "Random Number Generation with Arbitrary Stride").
+    void advance(v8_uint64_t delta) {
+        v8_uint64_t cur_mult = k_multiplier;
+        v8_uint64_t cur_plus = inc_;
+        v8_uint64_t acc_mult = 1;
+        v8_uint64_t acc_plus = 0;
+
+        while (delta) {
+            if (delta & 1) {
+                acc_mult *= cur_mult;
+                acc_plus = acc_plus * cur_mult + cur_plus;
+            }
+            cur_plus = (cur_mult + 1) * cur_plus;
+            cur_mult *= cur_mult;
+            delta >>= 1;
+        }
+
+        state_ = acc_mult * state_ + acc_plus;
+    }
+
+    pcg32_engine split(const v8_uint32_t stream_index) const {
+        v8_uint64_t sm_state = (inc_ >> 1) + stream_index + 1;
+        pcg32_engine stream(*this);
+        stream.inc_ = (splitmix64_next(&sm_state) << 1) | 1;
+        return stream;
+    }
+
+private :
+    static const v8_uint64_t k_multiplier = 6364136223846793005ULL;
+
+    v8_uint64_t     state_;
+    v8_uint64_t     inc_;
+};
+
+} // namespace math
+} // namespace v8
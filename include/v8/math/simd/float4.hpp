@@ -0,0 +1,584 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+/*!
+ * \file float4.hpp
+ * \brief A thin abstraction over a four lane single precision SIMD register.
+ * The functions map one to one to SSE and NEON instructions. When no
+ * instruction set is selected (see simd_config.hpp) a portable scalar 
+ * implementation with the same interface is used.
+ */
+
+#include <cmath>
+#include <cstring>
+
+#include <v8/v8.hpp>
+#include <v8/math/simd/simd_config.hpp>
+
+#if defined(V8_MATH_SIMD_IS_SSE)
+#include <xmmintrin.h>
+#include <emmintrin.h>
+#if defined(V8_MATH_SIMD_IS_AVX)
+#include <immintrin.h>
+#endif
+#elif defined(V8_MATH_SIMD_IS_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace v8 { namespace math { namespace simd {
+
+/** \addtogroup __grp_v8_math_simd
+ *  @{
+ */
+
+#if defined(V8_MATH_SIMD_IS_SSE)
+
+typedef __m128      float4_t;
+
+/** \brief Loads four floats from an unaligned address. */
+inline float4_t load_float4(const float* src) {
+    return _mm_loadu_ps(src);
+}
+
+/** \brief Loads four floats from a 16 byte aligned address. */
+inline float4_t load_float4_aligned(const float* src) {
+    return _mm_load_ps(src);
+}
+
+/** \brief Stores four floats to an unaligned address. */
+inline void store_float4(float* dst, float4_t val) {
+    _mm_storeu_ps(dst, val);
+}
+
+/** \brief Stores four floats to a 16 byte aligned address. */
+inline void store_float4_aligned(float* dst, float4_t val) {
+    _mm_store_ps(dst, val);
+}
+
+/** \brief Returns (val, val, val, val). */
+inline float4_t splat_float4(float val) {
+    return _mm_set1_ps(val);
+}
+
+/** \brief Returns (x, y, z, w), x in the lowest lane. */
+inline float4_t set_float4(float x, float y, float z, float w) {
+    return _mm_setr_ps(x, y, z, w);
+}
+
+inline float4_t zero_float4() {
+    return _mm_setzero_ps();
+}
+
+inline float4_t add(float4_t lhs, float4_t rhs) {
+    return _mm_add_ps(lhs, rhs);
+}
+
+inline float4_t sub(float4_t lhs, float4_t rhs) {
+    return _mm_sub_ps(lhs, rhs);
+}
+
+inline float4_t mul(float4_t lhs, float4_t rhs) {
+    return _mm_mul_ps(lhs, rhs);
+}
+
+inline float4_t div(float4_t lhs, float4_t rhs) {
+    return _mm_div_ps(lhs, rhs);
+}
+
+inline float4_t negate(float4_t val) {
+    return _mm_xor_ps(val, _mm_set1_ps(-0.0f));
+}
+
+inline float4_t minimum(float4_t lhs, float4_t rhs) {
+    return _mm_min_ps(lhs, rhs);
+}
+
+inline float4_t maximum(float4_t lhs, float4_t rhs) {
+    return _mm_max_ps(lhs, rhs);
+}
+
+inline float4_t square_root(float4_t val) {
+    return _mm_sqrt_ps(val);
+}
+
+/** \brief Lane wise lhs < rhs. Lanes are set to all ones if true. */
+inline float4_t cmp_lt(float4_t lhs, float4_t rhs) {
+    return _mm_cmplt_ps(lhs, rhs);
+}
+
+inline float4_t cmp_le(float4_t lhs, float4_t rhs) {
+    return _mm_cmple_ps(lhs, rhs);
+}
+
+inline float4_t cmp_gt(float4_t lhs, float4_t rhs) {
+    return _mm_cmpgt_ps(lhs, rhs);
+}
+
+inline float4_t bit_and(float4_t lhs, float4_t rhs) {
+    return _mm_and_ps(lhs, rhs);
+}
+
+inline float4_t bit_or(float4_t lhs, float4_t rhs) {
+    return _mm_or_ps(lhs, rhs);
+}
+
+/** \brief Returns (mask & if_true) | (~mask & if_false). */
+inline float4_t select(float4_t mask, float4_t if_true, float4_t if_false) {
+    return _mm_or_ps(_mm_and_ps(mask, if_true), 
+                     _mm_andnot_ps(mask, if_false));
+}
+
+/** 
+ * \brief Interprets the bits of every lane as a 32 bit signed integer and
+ *        converts it to float.
+ */
+inline float4_t convert_int_to_float(float4_t bits) {
+    return _mm_cvtepi32_ps(_mm_castps_si128(bits));
+}
+
+/** 
+ * \brief Converts every lane to a 32 bit signed integer, rounding toward 
+ *        zero. The lanes of the result hold the bits of the integers.
+ */
+inline float4_t convert_float_to_int(float4_t val) {
+    return _mm_castsi128_ps(_mm_cvttps_epi32(val));
+}
+
+/** \brief Packs the sign bit of every lane into the low 4 bits of an int. */
+inline v8_int_t move_mask(float4_t val) {
+    return _mm_movemask_ps(val);
+}
+
+/** \brief Returns a register with all lanes equal to lane N of val. */
+template<int N>
+inline float4_t broadcast_lane(float4_t val) {
+    return _mm_shuffle_ps(val, val, _MM_SHUFFLE(N, N, N, N));
+}
+
+template<int N>
+inline float extract_lane(float4_t val) {
+    return _mm_cvtss_f32(broadcast_lane<N>(val));
+}
+
+/** \brief Returns (val[X], val[Y], val[Z], val[W]). */
+template<int X, int Y, int Z, int W>
+inline float4_t swizzle(float4_t val) {
+    return _mm_shuffle_ps(val, val, _MM_SHUFFLE(W, Z, Y, X));
+}
+
+/** \brief Returns (lo[X], lo[Y], hi[Z], hi[W]). */
+template<int X, int Y, int Z, int W>
+inline float4_t shuffle(float4_t lo, float4_t hi) {
+    return _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(W, Z, Y, X));
+}
+
+/** \brief In place transpose of a 4x4 block stored in four registers. */
+inline void transpose(float4_t& r0, float4_t& r1, float4_t& r2, float4_t& r3) {
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+}
+
+/** 
+ * \brief Converts four 32 bit integers to floats in the [0, 1) range, using
+ *        their upper 24 bits (bits * 2^-32, rounded down to float precision).
+ */
+inline float4_t unit_float4_from_bits(const v8_uint32_t* bits) {
+    const __m128i mantissa = _mm_srli_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(bits)), 8);
+    return _mm_mul_ps(_mm_cvtepi32_ps(mantissa), 
+                      _mm_set1_ps(1.0f / 16777216.0f));
+}
+
+#elif defined(V8_MATH_SIMD_IS_NEON)
+
+typedef float32x4_t     float4_t;
+
+inline float4_t load_float4(const float* src) {
+    return vld1q_f32(src);
+}
+
+inline float4_t load_float4_aligned(const float* src) {
+    return vld1q_f32(src);
+}
+
+inline void store_float4(float* dst, float4_t val) {
+    vst1q_f32(dst, val);
+}
+
+inline void store_float4_aligned(float* dst, float4_t val) {
+    vst1q_f32(dst, val);
+}
+
+inline float4_t splat_float4(float val) {
+    return vdupq_n_f32(val);
+}
+
+inline float4_t set_float4(float x, float y, float z, float w) {
+    const float values[4] = { x, y, z, w };
+    return vld1q_f32(values);
+}
+
+inline float4_t zero_float4() {
+    return vdupq_n_f32(0.0f);
+}
+
+inline float4_t add(float4_t lhs, float4_t rhs) {
+    return vaddq_f32(lhs, rhs);
+}
+
+inline float4_t sub(float4_t lhs, float4_t rhs) {
+    return vsubq_f32(lhs, rhs);
+}
+
+inline float4_t mul(float4_t lhs, float4_t rhs) {
+    return vmulq_f32(lhs, rhs);
+}
+
+inline float4_t div(float4_t lhs, float4_t rhs) {
+#if defined(__aarch64__)
+    return vdivq_f32(lhs, rhs);
+#else
+    float l[4], r[4];
+    vst1q_f32(l, lhs);
+    vst1q_f32(r, rhs);
+    for (int i = 0; i < 4; ++i)
+        l[i] /= r[i];
+    return vld1q_f32(l);
+#endif
+}
+
+inline float4_t negate(float4_t val) {
+    return vnegq_f32(val);
+}
+
+inline float4_t minimum(float4_t lhs, float4_t rhs) {
+    return vminq_f32(lhs, rhs);
+}
+
+inline float4_t maximum(float4_t lhs, float4_t rhs) {
+    return vmaxq_f32(lhs, rhs);
+}
+
+inline float4_t square_root(float4_t val) {
+#if defined(__aarch64__)
+    return vsqrtq_f32(val);
+#else
+    float v[4];
+    vst1q_f32(v, val);
+    for (int i = 0; i < 4; ++i)
+        v[i] = sqrtf(v[i]);
+    return vld1q_f32(v);
+#endif
+}
+
+inline float4_t cmp_lt(float4_t lhs, float4_t rhs) {
+    return vreinterpretq_f32_u32(vcltq_f32(lhs, rhs));
+}
+
+inline float4_t cmp_le(float4_t lhs, float4_t rhs) {
+    return vreinterpretq_f32_u32(vcleq_f32(lhs, rhs));
+}
+
+inline float4_t cmp_gt(float4_t lhs, float4_t rhs) {
+    return vreinterpretq_f32_u32(vcgtq_f32(lhs, rhs));
+}
+
+inline float4_t bit_and(float4_t lhs, float4_t rhs) {
+    return vreinterpretq_f32_u32(vandq_u32(vreinterpretq_u32_f32(lhs),
+                                           vreinterpretq_u32_f32(rhs)));
+}
+
+inline float4_t bit_or(float4_t lhs, float4_t rhs) {
+    return vreinterpretq_f32_u32(vorrq_u32(vreinterpretq_u32_f32(lhs),
+                                           vreinterpretq_u32_f32(rhs)));
+}
+
+inline float4_t select(float4_t mask, float4_t if_true, float4_t if_false) {
+    return vbslq_f32(vreinterpretq_u32_f32(mask), if_true, if_false);
+}
+
+inline float4_t convert_int_to_float(float4_t bits) {
+    return vcvtq_f32_s32(vreinterpretq_s32_f32(bits));
+}
+
+inline float4_t convert_float_to_int(float4_t val) {
+    return vreinterpretq_f32_s32(vcvtq_s32_f32(val));
+}
+
+inline v8_int_t move_mask(float4_t val) {
+    static const v8_int32_t shifts[4] = { 0, 1, 2, 3 };
+    const uint32x4_t sign_bits = vshrq_n_u32(vreinterpretq_u32_f32(val), 31);
+    const uint32x4_t lane_bits = vshlq_u32(sign_bits, vld1q_s32(shifts));
+    v8_uint32_t bits[4];
+    vst1q_u32(bits, lane_bits);
+    return static_cast<v8_int_t>(bits[0] | bits[1] | bits[2] | bits[3]);
+}
+
+template<int N>
+inline float4_t broadcast_lane(float4_t val) {
+    return vdupq_n_f32(vgetq_lane_f32(val, N));
+}
+
+template<int N>
+inline float extract_lane(float4_t val) {
+    return vgetq_lane_f32(val, N);
+}
+
+template<int X, int Y, int Z, int W>
+inline float4_t swizzle(float4_t val) {
+    float4_t res = vdupq_n_f32(vgetq_lane_f32(val, X));
+    res = vsetq_lane_f32(vgetq_lane_f32(val, Y), res, 1);
+    res = vsetq_lane_f32(vgetq_lane_f32(val, Z), res, 2);
+    return vsetq_lane_f32(vgetq_lane_f32(val, W), res, 3);
+}
+
+template<int X, int Y, int Z, int W>
+inline float4_t shuffle(float4_t lo, float4_t hi) {
+    float4_t res = vdupq_n_f32(vgetq_lane_f32(lo, X));
+    res = vsetq_lane_f32(vgetq_lane_f32(lo, Y), res, 1);
+    res = vsetq_lane_f32(vgetq_lane_f32(hi, Z), res, 2);
+    return vsetq_lane_f32(vgetq_lane_f32(hi, W), res, 3);
+}
+
+inline void transpose(float4_t& r0, float4_t& r1, float4_t& r2, float4_t& r3) {
+    const float32x4x2_t t01 = vtrnq_f32(r0, r1);
+    const float32x4x2_t t23 = vtrnq_f32(r2, r3);
+    r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+    r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+    r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+
+inline float4_t unit_float4_from_bits(const v8_uint32_t* bits) {
+    const uint32x4_t mantissa = vshrq_n_u32(vld1q_u32(bits), 8);
+    return vmulq_n_f32(vcvtq_f32_u32(mantissa), 1.0f / 16777216.0f);
+}
+
+#else /* scalar fallback */
+
+struct float4_t {
+    float lanes_[4];
+};
+
+namespace fallback {
+
+inline float mask_from_bool(bool val) {
+    const v8_uint32_t bits = val ? 0xFFFFFFFFU : 0U;
+    float mask;
+    memcpy(&mask, &bits, sizeof(mask));
+    return mask;
+}
+
+inline v8_uint32_t bits_of(float val) {
+    v8_uint32_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    return bits;
+}
+
+inline float float_of(v8_uint32_t bits) {
+    float val;
+    memcpy(&val, &bits, sizeof(val));
+    return val;
+}
+
+} // namespace fallback
+
+inline float4_t load_float4(const float* src) {
+    float4_t res;
+    memcpy(res.lanes_, src, sizeof(res.lanes_));
+    return res;
+}
+
+inline float4_t load_float4_aligned(const float* src) {
+    return load_float4(src);
+}
+
+inline void store_float4(float* dst, float4_t val) {
+    memcpy(dst, val.lanes_, sizeof(val.lanes_));
+}
+
+inline void store_float4_aligned(float* dst, float4_t val) {
+    store_float4(dst, val);
+}
+
+inline float4_t set_float4(float x, float y, float z, float w) {
+    float4_t res = { { x, y, z, w } };
+    return res;
+}
+
+inline float4_t splat_float4(float val) {
+    return set_float4(val, val, val, val);
+}
+
+inline float4_t zero_float4() {
+    return splat_float4(0.0f);
+}
+
+#define V8_MATH_SIMD_SCALAR_BINARY_OP(name, expr)                       \
+    inline float4_t name(float4_t lhs, float4_t rhs) {                  \
+        float4_t res;                                                   \
+        for (int i = 0; i < 4; ++i) {                                   \
+            const float l = lhs.lanes_[i];                              \
+            const float r = rhs.lanes_[i];                              \
+            res.lanes_[i] = (expr);                                     \
+        }                                                               \
+        return res;                                                     \
+    }
+
+V8_MATH_SIMD_SCALAR_BINARY_OP(add, l + r)
+V8_MATH_SIMD_SCALAR_BINARY_OP(sub, l - r)
+V8_MATH_SIMD_SCALAR_BINARY_OP(mul, l * r)
+V8_MATH_SIMD_SCALAR_BINARY_OP(div, l / r)
+V8_MATH_SIMD_SCALAR_BINARY_OP(minimum, l < r ? l : r)
+V8_MATH_SIMD_SCALAR_BINARY_OP(maximum, l > r ? l : r)
+V8_MATH_SIMD_SCALAR_BINARY_OP(cmp_lt, fallback::mask_from_bool(l < r))
+V8_MATH_SIMD_SCALAR_BINARY_OP(cmp_le, fallback::mask_from_bool(l <= r))
+V8_MATH_SIMD_SCALAR_BINARY_OP(cmp_gt, fallback::mask_from_bool(l > r))
+V8_MATH_SIMD_SCALAR_BINARY_OP(bit_and, fallback::float_of(
+    fallback::bits_of(l) & fallback::bits_of(r)))
+V8_MATH_SIMD_SCALAR_BINARY_OP(bit_or, fallback::float_of(
+    fallback::bits_of(l) | fallback::bits_of(r)))
+
+#undef V8_MATH_SIMD_SCALAR_BINARY_OP
+
+inline float4_t negate(float4_t val) {
+    return set_float4(-val.lanes_[0], -val.lanes_[1], 
+                      -val.lanes_[2], -val.lanes_[3]);
+}
+
+inline float4_t square_root(float4_t val) {
+    return set_float4(sqrtf(val.lanes_[0]), sqrtf(val.lanes_[1]),
+                      sqrtf(val.lanes_[2]), sqrtf(val.lanes_[3]));
+}
+
+inline float4_t select(float4_t mask, float4_t if_true, float4_t if_false) {
+    float4_t res;
+    for (int i = 0; i < 4; ++i) {
+        const v8_uint32_t m = fallback::bits_of(mask.lanes_[i]);
+        res.lanes_[i] = fallback::float_of(
+            (m & fallback::bits_of(if_true.lanes_[i])) 
+            | (~m & fallback::bits_of(if_false.lanes_[i])));
+    }
+    return res;
+}
+
+inline float4_t convert_int_to_float(float4_t bits) {
+    float4_t res;
+    for (int i = 0; i < 4; ++i) {
+        const v8_int32_t ival = 
+            static_cast<v8_int32_t>(fallback::bits_of(bits.lanes_[i]));
+        res.lanes_[i] = static_cast<float>(ival);
+    }
+    return res;
+}
+
+inline float4_t convert_float_to_int(float4_t val) {
+    float4_t res;
+    for (int i = 0; i < 4; ++i) {
+        const v8_int32_t ival = static_cast<v8_int32_t>(val.lanes_[i]);
+        res.lanes_[i] = fallback::float_of(static_cast<v8_uint32_t>(ival));
+    }
+    return res;
+}
+
+inline v8_int_t move_mask(float4_t val) {
+    v8_int_t mask = 0;
+    for (int i = 0; i < 4; ++i)
+        mask |= static_cast<v8_int_t>(fallback::bits_of(val.lanes_[i]) >> 31) << i;
+    return mask;
+}
+
+template<int N>
+inline float4_t broadcast_lane(float4_t val) {
+    return splat_float4(val.lanes_[N]);
+}
+
+template<int N>
+inline float extract_lane(float4_t val) {
+    return val.lanes_[N];
+}
+
+template<int X, int Y, int Z, int W>
+inline float4_t swizzle(float4_t val) {
+    return set_float4(val.lanes_[X], val.lanes_[Y], 
+                      val.lanes_[Z], val.lanes_[W]);
+}
+
+template<int X, int Y, int Z, int W>
+inline float4_t shuffle(float4_t lo, float4_t hi) {
+    return set_float4(lo.lanes_[X], lo.lanes_[Y], 
+                      hi.lanes_[Z], hi.lanes_[W]);
+}
+
+inline void transpose(float4_t& r0, float4_t& r1, float4_t& r2, float4_t& r3) {
+    const float4_t c0 = set_float4(r0.lanes_[0], r1.lanes_[0], r2.lanes_[0], r3.lanes_[0]);
+    const float4_t c1 = set_float4(r0.lanes_[1], r1.lanes_[1], r2.lanes_[1], r3.lanes_[1]);
+    const float4_t c2 = set_float4(r0.lanes_[2], r1.lanes_[2], r2.lanes_[2], r3.lanes_[2]);
+    const float4_t c3 = set_float4(r0.lanes_[3], r1.lanes_[3], r2.lanes_[3], r3.lanes_[3]);
+    r0 = c0; r1 = c1; r2 = c2; r3 = c3;
+}
+
+inline float4_t unit_float4_from_bits(const v8_uint32_t* bits) {
+    return set_float4(static_cast<float>(bits[0] >> 8) * (1.0f / 16777216.0f),
+                      static_cast<float>(bits[1] >> 8) * (1.0f / 16777216.0f),
+                      static_cast<float>(bits[2] >> 8) * (1.0f / 16777216.0f),
+                      static_cast<float>(bits[3] >> 8) * (1.0f / 16777216.0f));
+}
+
+#endif
+
+//
+// Four packed xyz points, loaded as a = (x0 y0 z0 x1), b = (y1 z1 x2 y2),
+// c = (z2 x3 y3 z3), to SoA form and back.
+inline void deinterleave_xyz(
+    float4_t a, float4_t b, float4_t c, float4_t* x, float4_t* y, float4_t* z
+    ) {
+    *x = shuffle<0, 2, 0, 2>(shuffle<0, 0, 3, 3>(a, a), shuffle<2, 2, 1, 1>(b, c));
+    *y = shuffle<0, 2, 0, 2>(shuffle<1, 1, 0, 0>(a, b), shuffle<3, 3, 2, 2>(b, c));
+    *z = shuffle<0, 2, 0, 2>(shuffle<2, 2, 1, 1>(a, b), shuffle<0, 0, 3, 3>(c, c));
+}
+
+inline void interleave_xyz(
+    float4_t x, float4_t y, float4_t z, float4_t* a, float4_t* b, float4_t* c
+    ) {
+    *a = shuffle<0, 2, 0, 2>(shuffle<0, 0, 0, 0>(x, y), shuffle<0, 0, 1, 1>(z, x));
+    *b = shuffle<0, 2, 0, 2>(shuffle<1, 1, 1, 1>(y, z), shuffle<2, 2, 2, 2>(x, y));
+    *c = shuffle<0, 2, 0, 2>(shuffle<2, 2, 3, 3>(z, x), shuffle<3, 3, 3, 3>(y, z));
+}
+
+//
+// Loads twelve consecutive floats (four packed xyz points) in SoA form.
+inline void load_xyz4(const float* src, float4_t* x, float4_t* y, float4_t* z) {
+    deinterleave_xyz(
+        load_float4(src), load_float4(src + 4), load_float4(src + 8), x, y, z);
+}
+
+/** @} */
+
+} // namespace simd
+} // namespace math
+} // namespace v8
@@ -0,0 +1,123 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+/*!
+ * \file float4_math.hpp
+ * \brief Polynomial approximations of transcendental functions, evaluated
+ * on the four lanes of a float4_t.
+ */
+
+#include <cstring>
+
+#include <v8/v8.hpp>
+#include <v8/math/simd/float4.hpp>
+
+namespace v8 { namespace math { namespace simd {
+
+/** \addtogroup __grp_v8_math_simd
+ *  @{
+ */
+
+/** \brief Returns a register with all lanes set to the given bit pattern. */
+inline float4_t splat_bits(v8_uint32_t bits) {
+    float val;
+    memcpy(&val, &bits, sizeof(val));
+    return splat_float4(val);
+}
+
+/**
+ * \brief log2(x), for positive normal x (absolute error about 1.0e-7).
+ * \remarks The mantissa is brought to [sqrt(1/2), sqrt(2)) and 
+ *          log(m) = 2 * atanh((m - 1) / (m + 1)) is evaluated with its 
+ *          series to the u^9 term.
+ */
+inline float4_t log2_approx(float4_t x) {
+    const float4_t one = splat_float4(1.0f);
+    const float4_t exponent_bits = bit_and(x, splat_bits(0x7F800000U));
+    float4_t e = sub(mul(convert_int_to_float(exponent_bits),
+                         splat_float4(1.0f / 8388608.0f)),
+                     splat_float4(127.0f));
+    float4_t m = bit_or(bit_and(x, splat_bits(0x007FFFFFU)), one);
+
+    const float4_t big = cmp_gt(m, splat_float4(1.41421356f));
+    m = select(big, mul(m, splat_float4(0.5f)), m);
+    e = add(e, bit_and(big, one));
+
+    const float4_t u = div(sub(m, one), add(m, one));
+    const float4_t u2 = mul(u, u);
+    float4_t p = splat_float4(1.0f / 9.0f);
+    p = add(mul(p, u2), splat_float4(1.0f / 7.0f));
+    p = add(mul(p, u2), splat_float4(1.0f / 5.0f));
+    p = add(mul(p, u2), splat_float4(1.0f / 3.0f));
+    p = add(mul(p, u2), one);
+
+    //
+    // 2 / ln(2)
+    return add(e, mul(mul(u, p), splat_float4(2.88539008f)));
+}
+
+/**
+ * \brief 2^x, for x in [-126, 126] (clamped), relative error about 1.0e-7.
+ * \remarks x = n + f, with n integral and |f| <= 1/2; 2^f is evaluated 
+ *          with the Taylor series of exp(f * ln(2)) to the 7th power and 
+ *          2^n is built in the exponent field.
+ */
+inline float4_t exp2_approx(float4_t x) {
+    x = minimum(maximum(x, splat_float4(-126.0f)), splat_float4(126.0f));
+
+    //
+    // Round to nearest : adding 1.5 * 2^23 drops the fraction bits.
+    const float4_t magic = splat_float4(12582912.0f);
+    const float4_t n = sub(add(x, magic), magic);
+    const float4_t f = sub(x, n);
+
+    float4_t p = splat_float4(1.52527338e-5f);
+    p = add(mul(p, f), splat_float4(1.54035304e-4f));
+    p = add(mul(p, f), splat_float4(1.33335581e-3f));
+    p = add(mul(p, f), splat_float4(9.61812911e-3f));
+    p = add(mul(p, f), splat_float4(5.55041087e-2f));
+    p = add(mul(p, f), splat_float4(2.40226507e-1f));
+    p = add(mul(p, f), splat_float4(6.93147181e-1f));
+    p = add(mul(p, f), splat_float4(1.0f));
+
+    const float4_t scale = convert_float_to_int(
+        mul(add(n, splat_float4(127.0f)), splat_float4(8388608.0f)));
+    return mul(p, scale);
+}
+
+/** \brief x^exponent = 2^(exponent * log2(x)), for positive normal x. */
+inline float4_t pow_approx(float4_t x, float exponent) {
+    return exp2_approx(mul(log2_approx(x), splat_float4(exponent)));
+}
+
+/** @} */
+
+} // namespace simd
+} // namespace math
+} // namespace v8
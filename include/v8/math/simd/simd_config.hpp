@@ -0,0 +1,109 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+/*!
+ * \file simd_config.hpp
+ * \brief Compile time selection of the instruction set used by the
+ * vectorized kernels of the math library.
+ *
+ * Vectorized kernels are opt-in. Define V8_MATH_ENABLE_SIMD (or configure
+ * with -DV8_MATH_ENABLE_SIMD=ON) to enable them. When enabled, one of the
+ * following macros is defined, except for AVX builds that define both
+ * V8_MATH_SIMD_IS_AVX and V8_MATH_SIMD_IS_SSE :
+ *  - V8_MATH_SIMD_IS_AVX   : AVX is available; V8_MATH_SIMD_IS_SSE is
+ *    defined too, the SSE kernels are used where there is no AVX one.
+ *  - V8_MATH_SIMD_IS_SSE   : SSE2 is available.
+ *  - V8_MATH_SIMD_IS_NEON  : ARM NEON is available.
+ *  - V8_MATH_SIMD_IS_SCALAR : no supported instruction set, the kernels
+ *    are compiled using the portable scalar fallback.
+ * Define V8_MATH_SIMD_FORCE_SCALAR to select the scalar fallback regardless
+ * of the target. 
+ *
+ * \remarks The kernels perform the same floating point operations, in the
+ * same order, as the scalar code they replace, so the results are bit for
+ * bit identical. This does not hold if the compiler is allowed to contract
+ * multiplications and additions into fused multiply-add instructions
+ * (-ffp-contract=fast with FMA enabled targets, /fp:fast).
+ */
+
+#include <v8/v8.hpp>
+
+#if defined(V8_MATH_SIMD_ENABLED)
+#undef V8_MATH_SIMD_ENABLED
+#endif
+
+#if defined(V8_MATH_SIMD_IS_AVX)
+#undef V8_MATH_SIMD_IS_AVX
+#endif
+
+#if defined(V8_MATH_SIMD_IS_SSE)
+#undef V8_MATH_SIMD_IS_SSE
+#endif
+
+#if defined(V8_MATH_SIMD_IS_NEON)
+#undef V8_MATH_SIMD_IS_NEON
+#endif
+
+#if defined(V8_MATH_SIMD_IS_SCALAR)
+#undef V8_MATH_SIMD_IS_SCALAR
+#endif
+
+#if defined(V8_MATH_ENABLE_SIMD)
+
+#define V8_MATH_SIMD_ENABLED
+
+#if defined(V8_MATH_SIMD_FORCE_SCALAR)
+
+#define V8_MATH_SIMD_IS_SCALAR
+#define V8_MATH_SIMD_STRING             "scalar"
+
+#elif defined(__AVX__)
+
+#define V8_MATH_SIMD_IS_AVX
+#define V8_MATH_SIMD_IS_SSE
+#define V8_MATH_SIMD_STRING             "AVX"
+
+#elif defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+
+#define V8_MATH_SIMD_IS_SSE
+#define V8_MATH_SIMD_STRING             "SSE2"
+
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#define V8_MATH_SIMD_IS_NEON
+#define V8_MATH_SIMD_STRING             "NEON"
+
+#else
+
+#define V8_MATH_SIMD_IS_SCALAR
+#define V8_MATH_SIMD_STRING             "scalar"
+
+#endif
+
+#endif /* V8_MATH_ENABLE_SIMD */
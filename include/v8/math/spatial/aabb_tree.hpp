@@ -0,0 +1,528 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+/*!
+ * \file aabb_tree.hpp
+ * \brief Dynamic bounding volume hierarchy of axis aligned bounding boxes.
+ */
+
+#include <cassert>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/math/math_utils.hpp>
+#include <v8/math/vector3.hpp>
+#include <v8/math/objects/axis_aligned_bounding_box3.hpp>
+#include <v8/math/objects/plane.hpp>
+#include <v8/math/objects/ray3.hpp>
+#include <v8/math/culling/cull_aabb.hpp>
+
+namespace v8 { namespace math {
+
+/** \addtogroup __grp_v8_math_spatial
+ *  @{
+ */
+
+/**
+ * \brief   A bounding volume hierarchy, with one leaf per object (proxy).
+ *          Static sets of objects are best added with build(), which
+ *          performs a top down construction using the surface area 
+ *          heuristic. Moving objects are inserted, removed and refitted
+ *          incrementally; the tree is kept balanced with tree rotations.
+ *          Leaves store enlarged ("fat") boxes, so that objects moving by a 
+ *          small amount do not need to be reinserted.
+ * \remarks Proxy ids remain valid until the proxy is removed or the tree is 
+ *          cleared/rebuilt.
+ */
+class aabb_tree {
+public :
+
+    /**
+     * \brief Id of a non existent node.
+     */
+    static const v8_int32_t C_Null_Node = -1;
+
+    /**
+     * \brief Maximum number of planes accepted by query_planes.
+     */
+    static const v8_uint32_t C_Max_Query_Planes = 32;
+
+    /**
+     * \brief Work done by a query.
+     */
+    struct query_stats_t {
+        //! Nodes popped from the traversal stack (internal nodes and leaves).
+        v8_uint32_t     qs_nodes_visited;
+        //! Leaves whose box was tested against the query. Leaves of subtrees
+        //! accepted as a whole are reported without a test.
+        v8_uint32_t     qs_leaves_tested;
+    };
+
+    aabb_tree();
+
+    /**
+     * \brief   Builds the tree from a set of objects, using the surface area 
+     *          heuristic. Any existing proxies are removed.
+     * \param   boxes       Bounding boxes of the objects.
+     * \param   user_data   Optional (can be null), user data for each object.
+     * \param   count       Number of objects.
+     * \param   proxy_ids   Receives the proxy id for each object. 
+     *                      Must have room for count entries.
+     * \remarks The boxes are not enlarged, since static objects never need
+     *          to be reinserted.
+     */
+    void build(
+        const aabb3F*   boxes,
+        void* const*    user_data,
+        v8_size_t       count,
+        v8_int32_t*     proxy_ids
+        );
+
+    /**
+     * \brief   Inserts an object in the tree.
+     * \return  The proxy id.
+     */
+    v8_int32_t insert_proxy(const aabb3F& box, void* user_data);
+
+    /**
+     * \brief   Removes an object from the tree.
+     */
+    void remove_proxy(v8_int32_t proxy_id);
+
+    /**
+     * \brief   Updates the bounding box of an object. The leaf is reinserted
+     *          only if the new box is not contained in the fat box.
+     * \return  True if the proxy was reinserted.
+     */
+    bool move_proxy(v8_int32_t proxy_id, const aabb3F& box);
+
+    /**
+     * \brief   Removes all proxies.
+     */
+    void clear();
+
+    void* get_user_data(v8_int32_t proxy_id) const {
+        assert(is_valid_proxy(proxy_id));
+        return nodes_[proxy_id].nd_user_data;
+    }
+
+    /**
+     * \brief   Returns the (enlarged) box stored for a proxy.
+     */
+    const aabb3F& get_fat_bound(v8_int32_t proxy_id) const {
+        assert(is_valid_proxy(proxy_id));
+        return nodes_[proxy_id].nd_bound;
+    }
+
+    v8_size_t get_proxy_count() const {
+        return proxy_count_;
+    }
+
+    /**
+     * \brief   Height of the tree (0 for an empty tree or a single leaf).
+     */
+    v8_int32_t get_height() const {
+        return root_ == C_Null_Node ? 0 : nodes_[root_].nd_height;
+    }
+
+    /**
+     * \brief   Sets the amount by which the boxes of dynamic proxies are 
+     *          enlarged, on each side. Affects proxies inserted after the 
+     *          call.
+     */
+    void set_fat_margin(float margin) {
+        assert(margin >= 0.0f);
+        fat_margin_ = margin;
+    }
+
+    float get_fat_margin() const {
+        return fat_margin_;
+    }
+
+    /**
+     * \brief   Reports all the proxies whose boxes are not entirely on the 
+     *          negative side of any of the planes (eg: the objects that
+     *          are not culled by a view frustrum with inward facing normals).
+     *          Subtrees that are entirely on the positive side of all planes 
+     *          are reported without further tests.
+     * \param   planes      Culling planes.
+     * \param   plane_count Number of planes (at most C_Max_Query_Planes).
+     * \param   callback    Invoked as callback(proxy_id, user_data).
+     * \param   stats       Optional, receives the number of nodes visited.
+     */
+    template<typename query_callback>
+    void query_planes(
+        const plane3F*  planes,
+        v8_uint32_t     plane_count,
+        query_callback& callback,
+        query_stats_t*  stats = nullptr
+        ) const;
+
+    /**
+     * \brief   Reports all the proxies whose boxes overlap the specified box.
+     * \param   callback    Invoked as callback(proxy_id, user_data).
+     */
+    template<typename query_callback>
+    void query_aabb(const aabb3F& box, query_callback& callback) const;
+
+    /**
+     * \brief   Reports the proxies whose boxes are hit by a ray, in roughly 
+     *          front to back order.
+     * \param   ray_query       The ray.
+     * \param   max_distance    Only hits in the [0, max_distance] range of the
+     *                          ray's parameter are reported.
+     * \param   callback        Invoked as 
+     *                          callback(proxy_id, user_data, max_distance).
+     *                          Must return the new maximum distance : 
+     *                          the distance to an exact hit clips the query,
+     *                          the max_distance argument continues it 
+     *                          unchanged and 0 terminates it.
+     */
+    template<typename ray_callback>
+    void query_ray(
+        const ray3F&    ray_query,
+        float           max_distance,
+        ray_callback&   callback
+        ) const;
+
+private :
+
+    struct node_t {
+        aabb3F      nd_bound;
+        void*       nd_user_data;
+        //! Parent node, or the next free node, if the node is not in use.
+        v8_int32_t  nd_parent;
+        v8_int32_t  nd_child1;
+        v8_int32_t  nd_child2;
+        //! 0 for leaves, -1 for nodes that are not in use.
+        v8_int32_t  nd_height;
+
+        bool is_leaf() const {
+            return nd_child1 == C_Null_Node;
+        }
+    };
+
+    struct build_item_t;
+
+    /**
+     * \brief Traversal stack, that only allocates for very deep trees.
+     */
+    template<typename value_type>
+    class traversal_stack {
+    public :
+        traversal_stack() : top_(0) {}
+
+        void push(const value_type& val) {
+            if (top_ < C_Fixed_Size) {
+                fixed_[top_] = val;
+            } else {
+                spill_.push_back(val);
+            }
+            ++top_;
+        }
+
+        value_type pop() {
+            assert(top_ > 0);
+            --top_;
+            if (top_ < C_Fixed_Size)
+                return fixed_[top_];
+
+            const value_type val = spill_.back();
+            spill_.pop_back();
+            return val;
+        }
+
+        bool empty() const {
+            return top_ == 0;
+        }
+
+    private :
+        static const v8_size_t C_Fixed_Size = 128;
+
+        value_type              fixed_[C_Fixed_Size];
+        std::vector<value_type> spill_;
+        v8_size_t               top_;
+    };
+
+    bool is_valid_proxy(v8_int32_t proxy_id) const {
+        return proxy_id >= 0 
+               && static_cast<v8_size_t>(proxy_id) < nodes_.size()
+               && nodes_[proxy_id].is_leaf()
+               && nodes_[proxy_id].nd_height == 0;
+    }
+
+    static bool overlaps(const aabb3F& a, const aabb3F& b) {
+        return a.min_point_.x_ <= b.max_point_.x_ 
+               && a.max_point_.x_ >= b.min_point_.x_
+               && a.min_point_.y_ <= b.max_point_.y_ 
+               && a.max_point_.y_ >= b.min_point_.y_
+               && a.min_point_.z_ <= b.max_point_.z_ 
+               && a.max_point_.z_ >= b.min_point_.z_;
+    }
+
+    /**
+     * \brief Slab test. Returns the distance at which the ray enters the box
+     *        or a negative value if the box is missed within max_distance.
+     */
+    static float ray_enter_distance(
+        const vector3F& origin,
+        const vector3F& inv_direction,
+        const aabb3F&   box,
+        float           max_distance
+        );
+
+    v8_int32_t allocate_node();
+
+    void free_node(v8_int32_t node_id);
+
+    void insert_leaf(v8_int32_t leaf);
+
+    void remove_leaf(v8_int32_t leaf);
+
+    v8_int32_t balance(v8_int32_t node_id);
+
+    void refit_ancestors(v8_int32_t node_id);
+
+    v8_int32_t build_subtree(build_item_t* items, v8_size_t count);
+
+    std::vector<node_t>     nodes_;
+    v8_int32_t              root_;
+    v8_int32_t              free_list_;
+    v8_size_t               proxy_count_;
+    float                   fat_margin_;
+};
+
+/** @} */
+
+} // namespace math
+} // namespace v8
+
+inline float v8::math::aabb_tree::ray_enter_distance(
+    const vector3F& origin,
+    const vector3F& inv_direction,
+    const aabb3F&   box,
+    float           max_distance
+    ) {
+    float t_enter = 0.0f;
+    float t_exit = max_distance;
+
+    for (int i = 0; i < 3; ++i) {
+        float t0 = (box.min_point_.elements_[i] - origin.elements_[i]) 
+                   * inv_direction.elements_[i];
+        float t1 = (box.max_point_.elements_[i] - origin.elements_[i]) 
+                   * inv_direction.elements_[i];
+        if (t0 > t1) {
+            const float tmp = t0; t0 = t1; t1 = tmp;
+        }
+
+        t_enter = t0 > t_enter ? t0 : t_enter;
+        t_exit = t1 < t_exit ? t1 : t_exit;
+        if (t_enter > t_exit)
+            return -1.0f;
+    }
+
+    return t_enter;
+}
+
+template<typename query_callback>
+void v8::math::aabb_tree::query_planes(
+    const plane3F*  planes,
+    v8_uint32_t     plane_count,
+    query_callback& callback,
+    query_stats_t*  stats
+    ) const {
+    assert(plane_count <= C_Max_Query_Planes);
+
+    query_stats_t counters = { 0, 0 };
+    if (stats)
+        *stats = counters;
+
+    if (root_ == C_Null_Node)
+        return;
+
+    //
+    // Each stack entry holds a node and the planes that its parent 
+    // straddles. A node inside all the planes has its whole subtree accepted.
+    struct stack_entry_t {
+        v8_int32_t  se_node;
+        v8_uint32_t se_planes;
+    };
+
+    const v8_uint32_t all_planes = plane_count == 32 
+        ? 0xFFFFFFFFU : ((1U << plane_count) - 1);
+
+    traversal_stack<stack_entry_t> stack;
+    stack_entry_t entry = { root_, all_planes };
+    stack.push(entry);
+
+    while (!stack.empty()) {
+        entry = stack.pop();
+        const node_t& node = nodes_[entry.se_node];
+
+        ++counters.qs_nodes_visited;
+        if (node.is_leaf() && entry.se_planes)
+            ++counters.qs_leaves_tested;
+
+        v8_uint32_t straddled = 0;
+        bool culled = false;
+        for (v8_uint32_t i = 0; i < plane_count; ++i) {
+            if (!(entry.se_planes & (1U << i)))
+                continue;
+
+            const int side = classify_object(planes[i], node.nd_bound);
+            if (side == plane3F::Plane_Negative_Side) {
+                culled = true;
+                break;
+            }
+            if (side == plane3F::Plane_Contained)
+                straddled |= 1U << i;
+        }
+
+        if (culled)
+            continue;
+
+        if (node.is_leaf()) {
+            callback(entry.se_node, node.nd_user_data);
+            continue;
+        }
+
+        stack_entry_t child1 = { node.nd_child1, straddled };
+        stack_entry_t child2 = { node.nd_child2, straddled };
+        stack.push(child2);
+        stack.push(child1);
+    }
+
+    if (stats)
+        *stats = counters;
+}
+
+template<typename query_callback>
+void v8::math::aabb_tree::query_aabb(
+    const aabb3F&   box,
+    query_callback& callback
+    ) const {
+    if (root_ == C_Null_Node)
+        return;
+
+    traversal_stack<v8_int32_t> stack;
+    stack.push(root_);
+
+    while (!stack.empty()) {
+        const v8_int32_t node_id = stack.pop();
+        const node_t& node = nodes_[node_id];
+
+        if (!overlaps(node.nd_bound, box))
+            continue;
+
+        if (node.is_leaf()) {
+            callback(node_id, node.nd_user_data);
+        } else {
+            stack.push(node.nd_child2);
+            stack.push(node.nd_child1);
+        }
+    }
+}
+
+template<typename ray_callback>
+void v8::math::aabb_tree::query_ray(
+    const ray3F&    ray_query,
+    float           max_distance,
+    ray_callback&   callback
+    ) const {
+    if (root_ == C_Null_Node)
+        return;
+
+    //
+    // Division by zero yields +/- infinity, which the slab test handles.
+    const vector3F inv_dir(1.0f / ray_query.direction_.x_, 
+                           1.0f / ray_query.direction_.y_,
+                           1.0f / ray_query.direction_.z_);
+
+    //
+    // Each stack entry holds a node and the distance at which the ray enters
+    // its box. The distance is checked again when the entry is popped, since
+    // the query may have been clipped in the meantime.
+    struct stack_entry_t {
+        v8_int32_t  se_node;
+        float       se_enter;
+    };
+
+    traversal_stack<stack_entry_t> stack;
+    stack_entry_t entry = { 
+        root_, 
+        ray_enter_distance(ray_query.origin_, inv_dir, nodes_[root_].nd_bound,
+                           max_distance)
+    };
+
+    if (entry.se_enter >= 0.0f)
+        stack.push(entry);
+
+    while (!stack.empty()) {
+        entry = stack.pop();
+        if (entry.se_enter > max_distance)
+            continue;
+
+        const node_t& node = nodes_[entry.se_node];
+
+        if (node.is_leaf()) {
+            max_distance = callback(entry.se_node, node.nd_user_data, 
+                                    max_distance);
+            if (max_distance <= 0.0f)
+                return;
+
+            continue;
+        }
+
+        stack_entry_t near_child = {
+            node.nd_child1,
+            ray_enter_distance(ray_query.origin_, inv_dir, 
+                               nodes_[node.nd_child1].nd_bound, max_distance)
+        };
+        stack_entry_t far_child = {
+            node.nd_child2,
+            ray_enter_distance(ray_query.origin_, inv_dir, 
+                               nodes_[node.nd_child2].nd_bound, max_distance)
+        };
+
+        if (far_child.se_enter >= 0.0f && near_child.se_enter >= 0.0f 
+            && far_child.se_enter < near_child.se_enter) {
+            const stack_entry_t tmp = near_child;
+            near_child = far_child;
+            far_child = tmp;
+        }
+
+        //
+        // Push the far child first, so that the near one is visited first.
+        if (far_child.se_enter >= 0.0f)
+            stack.push(far_child);
+        if (near_child.se_enter >= 0.0f)
+            stack.push(near_child);
+    }
+}
+
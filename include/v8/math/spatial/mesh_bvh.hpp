@@ -0,0 +1,329 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+/*!
+ * \file mesh_bvh.hpp
+ * \brief Static bounding volume hierarchy over the triangles of a mesh.
+ */
+
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/math/vector3.hpp>
+#include <v8/math/objects/axis_aligned_bounding_box3.hpp>
+#include <v8/math/objects/ray3.hpp>
+
+namespace v8 { namespace base {
+    class job_system;
+} }
+
+namespace v8 { namespace math {
+
+namespace geometry_gen {
+    struct mesh_data_t;
+}
+
+class mesh_streams;
+
+/** \addtogroup __grp_v8_math_spatial
+ *  @{
+ */
+
+/**
+ * \brief Result of a ray query against a mesh_bvh.
+ */
+struct mesh_ray_hit_t {
+    //! Ray parameter of the hit (max_distance if there is no hit).
+    float       rh_distance;
+    //! Index of the triangle that was hit, or mesh_bvh::C_No_Triangle.
+    v8_uint32_t rh_triangle;
+    //! Barycentric coordinates of the hit point : 
+    //! p = (1 - u - v) * v0 + u * v1 + v * v2.
+    float       rh_u;
+    float       rh_v;
+};
+
+/**
+ * \brief Result of a closest point query against a mesh_bvh.
+ */
+struct mesh_closest_point_t {
+    //! Closest point of the mesh.
+    vector3F    cp_point;
+    //! Square of the distance from the query point (max_distance squared 
+    //! if nothing was found).
+    float       cp_distance_squared;
+    //! Index of the closest triangle, or mesh_bvh::C_No_Triangle.
+    v8_uint32_t cp_triangle;
+    //! Barycentric coordinates of the closest point : 
+    //! p = (1 - u - v) * v0 + u * v1 + v * v2.
+    float       cp_u;
+    float       cp_v;
+};
+
+/**
+ * \brief   Bounding volume hierarchy over the triangles of a static mesh, 
+ *          for ray casting. The tree is built top down with the binned 
+ *          surface area heuristic and stored flattened in depth first 
+ *          order (the first child of a node immediately follows it). 
+ *          Leaves hold up to four triangles, that are tested against a ray 
+ *          in one pass (Moller-Trumbore). Packets of 4 or 8 coherent rays 
+ *          (camera rays, shadow rays towards an area light) can be traced 
+ *          together, sharing the node fetches and box tests.
+ * \remarks The triangle vertices are copied in the tree, so the mesh need 
+ *          not outlive it. Triangles are tested from both sides.
+ */
+class mesh_bvh {
+public :
+
+    /**
+     * \brief Triangle index reported when a ray misses the mesh.
+     */
+    static const v8_uint32_t C_No_Triangle = 0xFFFFFFFFU;
+
+    /**
+     * \brief Maximum number of triangles in a leaf.
+     */
+    static const v8_uint32_t C_Max_Leaf_Triangles = 4;
+
+    /**
+     * \brief Meshes with fewer triangles are built on the calling thread, 
+     *        even when a job system is available.
+     */
+    static const v8_size_t C_Parallel_Build_Threshold = 1 << 16;
+
+    mesh_bvh();
+
+    /**
+     * \brief   Builds the tree. Any existing tree is discarded.
+     * \param   positions           Vertex positions.
+     * \param   position_stride     Distance, in bytes, between two positions.
+     * \param   indices             Three vertex indices per triangle.
+     * \param   triangle_count      Number of triangles.
+     * \param   jobs                Optional (can be null). Used for meshes 
+     *                              with at least C_Parallel_Build_Threshold 
+     *                              triangles; independent subtrees are built
+     *                              in parallel.
+     */
+    void build(
+        const vector3F*     positions,
+        v8_size_t           position_stride,
+        const v8_uint32_t*  indices,
+        v8_size_t           triangle_count,
+        base::job_system*   jobs = nullptr
+        );
+
+    /**
+     * \brief   Builds the tree from the output of a geometry generator.
+     */
+    void build(
+        const geometry_gen::mesh_data_t&    mesh,
+        base::job_system*                   jobs = nullptr
+        );
+
+    /**
+     * \brief   Builds the tree from the positions of a mesh_streams 
+     *          container (as filled by the model loaders).
+     */
+    void build(
+        const mesh_streams& mesh,
+        const v8_uint32_t*  indices,
+        v8_size_t           triangle_count,
+        base::job_system*   jobs = nullptr
+        );
+
+    void clear();
+
+    bool is_empty() const {
+        return nodes_.empty();
+    }
+
+    v8_size_t get_triangle_count() const {
+        return triangles_.size();
+    }
+
+    v8_size_t get_node_count() const {
+        return nodes_.size();
+    }
+
+    /**
+     * \brief   Bytes used by the nodes and the triangle copies.
+     */
+    v8_size_t get_memory_size() const {
+        return nodes_.size() * sizeof(node_t) 
+               + triangles_.size() * sizeof(triangle_t);
+    }
+
+    /**
+     * \brief   Bounding box of the mesh. Undefined if the tree is empty.
+     */
+    aabb3F get_bound() const;
+
+    /**
+     * \brief   Finds the closest hit in the [0, max_distance] range of the 
+     *          ray's parameter.
+     * \param   hit     Receives the hit. Must not be null. On a miss,
+     *                  rh_triangle is C_No_Triangle.
+     * \return  True if the ray hits the mesh.
+     * \remarks The direction of the ray need not have unit length; the 
+     *          distances are then in multiples of its length.
+     */
+    bool intersect(
+        const ray3F&        ray_query,
+        float               max_distance,
+        mesh_ray_hit_t*     hit
+        ) const;
+
+    /**
+     * \brief   Returns true if the mesh is hit anywhere in the 
+     *          [0, max_distance] range. Stops at the first hit found.
+     */
+    bool occluded(const ray3F& ray_query, float max_distance) const;
+
+    /**
+     * \brief   Closest hits for a packet of 4 rays.
+     * \param   rays            4 rays.
+     * \param   max_distances   4 maximum distances.
+     * \param   hits            Receives 4 hits.
+     * \return  Bit i is set if ray i hits the mesh.
+     * \remarks Packets pay off for coherent rays (same origin, or close 
+     *          directions); incoherent rays are better traced one by one.
+     */
+    v8_uint32_t intersect_packet4(
+        const ray3F*        rays,
+        const float*        max_distances,
+        mesh_ray_hit_t*     hits
+        ) const;
+
+    /**
+     * \brief   Closest hits for a packet of 8 rays.
+     */
+    v8_uint32_t intersect_packet8(
+        const ray3F*        rays,
+        const float*        max_distances,
+        mesh_ray_hit_t*     hits
+        ) const;
+
+    /**
+     * \brief   Occlusion test for a packet of 4 rays.
+     * \return  Bit i is set if ray i is occluded.
+     */
+    v8_uint32_t occluded_packet4(
+        const ray3F*        rays,
+        const float*        max_distances
+        ) const;
+
+    /**
+     * \brief   Occlusion test for a packet of 8 rays.
+     */
+    v8_uint32_t occluded_packet8(
+        const ray3F*        rays,
+        const float*        max_distances
+        ) const;
+
+    /**
+     * \brief   Closest hits for an array of rays, traced in packets of 8. 
+     *          Consecutive rays should be coherent (e.g. tiles of a 
+     *          camera's image).
+     * \param   jobs    Optional (can be null); distributes the rays.
+     */
+    void intersect_rays(
+        const ray3F*        rays,
+        v8_size_t           count,
+        float               max_distance,
+        mesh_ray_hit_t*     hits,
+        base::job_system*   jobs = nullptr
+        ) const;
+
+    /**
+     * \brief   Finds the point of the mesh closest to a point. Subtrees 
+     *          whose boxes are farther than the best distance found so far 
+     *          are skipped; the triangles are tested with the point/triangle 
+     *          distance_squared routine.
+     * \param   max_distance    Only points closer than this are reported.
+     * \param   result          Receives the closest point. Must not be null.
+     * \return  True if a point was found within max_distance.
+     */
+    bool closest_point(
+        const vector3F&         point,
+        float                   max_distance,
+        mesh_closest_point_t*   result
+        ) const;
+
+    /**
+     * \brief   Closest points for an array of query points.
+     * \param   jobs    Optional (can be null); distributes the points.
+     */
+    void closest_points(
+        const vector3F*         points,
+        v8_size_t               count,
+        float                   max_distance,
+        mesh_closest_point_t*   results,
+        base::job_system*       jobs = nullptr
+        ) const;
+
+private :
+
+    //
+    // 32 bytes, two nodes per cache line.
+    struct node_t {
+        float       nd_min[3];
+        //! Inner node : index of the second child. 
+        //! Leaf : index of the first triangle.
+        v8_uint32_t nd_offset;
+        float       nd_max[3];
+        //! Number of triangles, 0 for inner nodes.
+        v8_uint16_t nd_count;
+        //! Split axis of inner nodes.
+        v8_uint16_t nd_axis;
+    };
+
+    //
+    // First vertex and edges, as consumed by the intersection test, padded 
+    // to 16 bytes each so they can be loaded directly into registers.
+    struct triangle_t {
+        float       tr_v0[3];
+        v8_uint32_t tr_index;
+        float       tr_edge1[4];
+        float       tr_edge2[4];
+    };
+
+    //
+    // Defined in the implementation file.
+    struct builder_t;
+    struct tracer_t;
+    struct proximity_t;
+
+    std::vector<node_t>     nodes_;
+    std::vector<triangle_t> triangles_;
+};
+
+/** @} */
+
+} // namespace math
+} // namespace v8
@@ -0,0 +1,276 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+/*!
+ * \file sweep_and_prune.hpp
+ * \brief Sweep and prune broadphase over axis aligned boxes.
+ */
+
+#include <cassert>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/math/vector3.hpp>
+#include <v8/math/objects/axis_aligned_bounding_box3.hpp>
+
+namespace v8 { namespace math {
+
+/** \addtogroup __grp_v8_math_spatial
+ *  @{
+ */
+
+/**
+ * \brief Two proxies with overlapping boxes; pp_proxy1 < pp_proxy2.
+ */
+struct proxy_pair_t {
+    v8_int32_t  pp_proxy1;
+    v8_int32_t  pp_proxy2;
+};
+
+/**
+ * \brief   Broadphase that keeps the set of overlapping pairs among a set
+ *          of moving boxes (touching boxes overlap). Each update() collects
+ *          the pairs from scratch and compares them with the previous ones :
+ *          the boxes are kept sorted on their min along a single axis, the
+ *          one where they are sparsest, binned in that order in a grid on
+ *          the two other axes, and each cell is swept along the sorted axis,
+ *          testing the other intervals of four boxes at a time (SIMD).
+ *          Temporal coherence is exploited by the sort only : the boxes are
+ *          sorted by insertion from the order of the previous update, and
+ *          from scratch after insertions or when the motion is incoherent.
+ *          Endpoints sorted incrementally on all three axes (reporting the
+ *          pair changes from the swaps) were measured to be slower than
+ *          this past a few thousand boxes : the projections of many boxes
+ *          on an axis are dense, so even slow coherent motion swaps several
+ *          times per endpoint, each swap a cache miss on the proxies.
+ * \remarks Inserted, moved and removed proxies take effect on the next
+ *          update(). The ids of removed proxies are reused after that update.
+ */
+class sweep_and_prune {
+public :
+
+    /**
+     * \brief Id of a non existent proxy.
+     */
+    static const v8_int32_t C_Null_Proxy = -1;
+
+    sweep_and_prune();
+
+    /**
+     * \brief   Adds an object. Its pairs are reported by the next update(),
+     *          which sorts the boxes from scratch.
+     * \return  The proxy id.
+     */
+    v8_int32_t insert_proxy(const aabb3F& box, void* user_data);
+
+    /**
+     * \brief   Removes an object. Its pairs are reported as removed by the
+     *          next update().
+     */
+    void remove_proxy(v8_int32_t proxy_id);
+
+    /**
+     * \brief   Sets the bounding box of an object. Cheap (the boxes are
+     *          only sorted by update()), so all the moving objects can be
+     *          moved every frame.
+     */
+    void move_proxy(v8_int32_t proxy_id, const aabb3F& box);
+
+    /**
+     * \brief   Sorts the boxes and updates the overlapping pairs. The
+     *          changes since the previous update are available from
+     *          get_added_pairs() and get_removed_pairs().
+     */
+    void update();
+
+    /**
+     * \brief   Removes all proxies and pairs, without reporting them.
+     */
+    void clear();
+
+    /**
+     * \brief   Pairs that started to overlap during the last update(),
+     *          sorted by (pp_proxy1, pp_proxy2).
+     */
+    const std::vector<proxy_pair_t>& get_added_pairs() const {
+        return added_pairs_;
+    }
+
+    /**
+     * \brief   Pairs that stopped overlapping, or had a proxy removed,
+     *          during the last update(), sorted by (pp_proxy1, pp_proxy2).
+     */
+    const std::vector<proxy_pair_t>& get_removed_pairs() const {
+        return removed_pairs_;
+    }
+
+    /**
+     * \brief   True if the last update() sorted the boxes from scratch,
+     *          instead of by insertion from the order of the previous one.
+     */
+    bool was_sorted_from_scratch() const {
+        return sorted_from_scratch_;
+    }
+
+    v8_size_t get_pair_count() const {
+        return pairs_.size();
+    }
+
+    v8_size_t get_proxy_count() const {
+        return proxy_count_;
+    }
+
+    void* get_user_data(v8_int32_t proxy_id) const {
+        assert(is_valid_proxy(proxy_id));
+        return proxies_[proxy_id].px_user_data;
+    }
+
+    /**
+     * \brief   Returns the current box of a proxy.
+     */
+    const aabb3F& get_bound(v8_int32_t proxy_id) const {
+        assert(is_valid_proxy(proxy_id));
+        return bounds_[proxy_id];
+    }
+
+    /**
+     * \brief   Reports all the overlapping pairs, as of the last update().
+     * \param   callback    Invoked as callback(proxy_pair_t).
+     */
+    template<typename pair_callback>
+    void for_each_pair(pair_callback& callback) const {
+        for (v8_size_t i = 0; i < pairs_.size(); ++i)
+            callback(pair_from_key(pairs_[i]));
+    }
+
+private :
+
+    enum Proxy_State {
+        Proxy_State_Free,
+        Proxy_State_Active,
+        Proxy_State_Removed
+    };
+
+    struct proxy_t {
+        void*       px_user_data;
+        v8_int32_t  px_state;
+    };
+
+    /**
+     * \brief   A box, as gathered by update_sweep_order().
+     */
+    struct sweep_box_t {
+        float       sb_min[3];
+        float       sb_max[3];
+        v8_uint32_t sb_id;
+    };
+
+    bool is_valid_proxy(v8_int32_t proxy_id) const {
+        return proxy_id >= 0
+               && static_cast<v8_size_t>(proxy_id) < proxies_.size()
+               && proxies_[proxy_id].px_state == Proxy_State_Active;
+    }
+
+    static v8_uint64_t pair_key(v8_uint32_t proxy1, v8_uint32_t proxy2) {
+        return proxy1 < proxy2
+            ? (static_cast<v8_uint64_t>(proxy1) << 32) | proxy2
+            : (static_cast<v8_uint64_t>(proxy2) << 32) | proxy1;
+    }
+
+    static proxy_pair_t pair_from_key(v8_uint64_t key) {
+        const proxy_pair_t pair = {
+            static_cast<v8_int32_t>(key >> 32),
+            static_cast<v8_int32_t>(key & 0xFFFFFFFFU)
+        };
+        return pair;
+    }
+
+    /**
+     * \brief   Drops the pairs of the removed proxies and frees their ids.
+     */
+    void remove_pending_proxies(std::vector<v8_uint64_t>* dropped_pairs);
+
+    /**
+     * \brief   Gathers the boxes and sorts them on their min along the sweep
+     *          axis : by insertion from the order of the previous update, or
+     *          from scratch (picking the axis where the boxes are sparsest)
+     *          when that order is gone or the insertion sort exceeds its
+     *          budget.
+     * \return  The moves made by the insertion sort, or the maximum
+     *          v8_size_t if the boxes were sorted from scratch.
+     */
+    v8_size_t update_sweep_order();
+
+    /**
+     * \brief   All the overlapping pairs, sorted.
+     * \return  The result of update_sweep_order().
+     */
+    v8_size_t collect_pairs(std::vector<v8_uint64_t>* pairs);
+
+    void apply_pair_changes(
+        const std::vector<v8_uint64_t>& added,
+        const std::vector<v8_uint64_t>& removed
+        );
+
+    std::vector<proxy_t>        proxies_;
+    //! Current boxes, by proxy id.
+    std::vector<aabb3F>         bounds_;
+    std::vector<v8_int32_t>     free_ids_;
+    std::vector<v8_int32_t>     removed_ids_;
+    //! Overlapping pairs, as sorted keys.
+    std::vector<v8_uint64_t>    pairs_;
+    std::vector<proxy_pair_t>   added_pairs_;
+    std::vector<proxy_pair_t>   removed_pairs_;
+    //! Proxy ids, in the sweep order of the last collect_pairs().
+    std::vector<v8_uint32_t>    sweep_ids_;
+    std::vector<sweep_box_t>    sweep_boxes_;
+    //! (sortable min on the sweep axis, index in sweep_boxes_).
+    std::vector<v8_uint64_t>    sweep_keys_;
+    std::vector<v8_uint64_t>    sort_scratch_;
+    //! Extent of the boxes and sum of their sizes, on each axis.
+    float                       sweep_lo_[3];
+    float                       sweep_hi_[3];
+    double                      sweep_size_sum_[3];
+    //! Boxes binned in the grid cells, and the boxes of the cell being
+    //! swept as a structure of arrays : min and max on the sweep axis,
+    //! then on the two grid axes.
+    std::vector<std::vector<sweep_box_t> >  cells_;
+    std::vector<float>          cell_bounds_[6];
+    std::vector<v8_uint32_t>    cell_ids_;
+    v8_size_t                   proxy_count_;
+    //! False after insertions : the sweep order is rebuilt from scratch.
+    bool                        sweep_order_valid_;
+    int                         sweep_axis_;
+    bool                        sorted_from_scratch_;
+};
+
+/** @} */
+
+} // namespace math
+} // namespace v8
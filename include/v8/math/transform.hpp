@@ -28,8 +28,10 @@
 
 #include <utility>
 
+#include <v8/base/job_system.hpp>
 #include <v8/math/matrix3X3.hpp>
 #include <v8/math/matrix4X4.hpp>
+#include <v8/math/transform_batch.hpp>
 #include <v8/math/vector3.hpp>
 
 namespace v8 { namespace math {
@@ -159,25 +161,10 @@ public :
         const vector3<real_t>* first,
         const vector3<real_t>* last,
         vector3<real_t>* out
-        ) {
-
-        vector_tf_matrix_t tf_data(compute_vec_tf_matrix());
-
-        while (first != last) {
-
-            if (tf_data.first) {
-
-                *out = *first;
-
-            } else {
-
-                *out = tf_data.second * (*first);
-
-            }
-
-            ++out;
-            ++first;
-        }
+        ) const {
+        transform_vector_sequence(
+            first, sizeof(*first), out, sizeof(*out), 
+            static_cast<v8_size_t>(last - first));
     }
 
     //!
@@ -192,27 +179,121 @@ public :
         const vector3<real_t>* first,
         const vector3<real_t>* last,
         vector3<real_t>* out
-        ) {
+        ) const {
+        const vector_tf_matrix_t tf_data(compute_vec_tf_inverse_matrix());
 
-        vector_tf_matrix_t tf_data(compute_vec_tf_inverse_matrix());
+        affine_transform_strided(
+            tf_data.second, vector3<real_t>::zero, first, sizeof(*first), 
+            out, sizeof(*out), static_cast<v8_size_t>(last - first));
+    }
 
-        while (first != last) {
+    //! @}
+
+    //! \name Batch transform functions.
+    //! These work on count elements, stored either strided (src_stride and 
+    //! dst_stride are the distances in bytes between two consecutive 
+    //! elements, so positions can be transformed in place inside a vertex 
+    //! buffer) or as separate x/y/z arrays (the _soa versions). The kind of
+    //! transform (identity, rotation, scale) is resolved once per call. 
+    //! When jobs is not null, large batches are split across its threads.
+    //! Output may alias input only when both have the same layout.
+    //! @{
 
-            if (tf_data.first) {
+    //!
+    //! \brief Points : P' = R * S * P + T.
+    void transform_point_sequence(
+        const vector3<real_t>*  src,
+        v8_size_t               src_stride,
+        vector3<real_t>*        dst,
+        v8_size_t               dst_stride,
+        v8_size_t               count,
+        base::job_system*       jobs = nullptr
+        ) const {
+        const vector_tf_matrix_t tf_data(compute_vec_tf_matrix());
 
-                *out = *first;
+        affine_transform_strided(
+            tf_data.second, translation_component_, src, src_stride, 
+            dst, dst_stride, count, jobs);
+    }
 
-            } else {
+    //!
+    //! \brief Vectors (directions) : V' = R * S * V.
+    void transform_vector_sequence(
+        const vector3<real_t>*  src,
+        v8_size_t               src_stride,
+        vector3<real_t>*        dst,
+        v8_size_t               dst_stride,
+        v8_size_t               count,
+        base::job_system*       jobs = nullptr
+        ) const {
+        const vector_tf_matrix_t tf_data(compute_vec_tf_matrix());
 
-                *out = tf_data.second * (*first);
+        affine_transform_strided(
+            tf_data.second, vector3<real_t>::zero, src, src_stride, 
+            dst, dst_stride, count, jobs);
+    }
 
-            }
+    //!
+    //! \brief Normals : N' = ((R * S)^-1)^T * N.
+    //! \note Output normals are not renormalized, they are scaled by 1/S 
+    //! when the transform has a scale component (or by arbitrary amounts,
+    //! when the matrix component is not a rotation/reflection).
+    void transform_normal_sequence(
+        const vector3<real_t>*  src,
+        v8_size_t               src_stride,
+        vector3<real_t>*        dst,
+        v8_size_t               dst_stride,
+        v8_size_t               count,
+        base::job_system*       jobs = nullptr
+        ) const {
+        const vector_tf_matrix_t tf_data(compute_normal_tf_matrix());
 
-            ++out;
-            ++first;
-        }
+        affine_transform_strided(
+            tf_data.second, vector3<real_t>::zero, src, src_stride, 
+            dst, dst_stride, count, jobs);
+    }
+
+    void transform_point_sequence_soa(
+        const real_t* src_x, const real_t* src_y, const real_t* src_z,
+        real_t* dst_x, real_t* dst_y, real_t* dst_z,
+        v8_size_t count,
+        base::job_system* jobs = nullptr
+        ) const {
+        const vector_tf_matrix_t tf_data(compute_vec_tf_matrix());
+
+        affine_transform_soa(
+            tf_data.second, translation_component_, src_x, src_y, src_z, 
+            dst_x, dst_y, dst_z, count, jobs);
+    }
+
+    void transform_vector_sequence_soa(
+        const real_t* src_x, const real_t* src_y, const real_t* src_z,
+        real_t* dst_x, real_t* dst_y, real_t* dst_z,
+        v8_size_t count,
+        base::job_system* jobs = nullptr
+        ) const {
+        const vector_tf_matrix_t tf_data(compute_vec_tf_matrix());
+
+        affine_transform_soa(
+            tf_data.second, vector3<real_t>::zero, src_x, src_y, src_z, 
+            dst_x, dst_y, dst_z, count, jobs);
+    }
+
+    void transform_normal_sequence_soa(
+        const real_t* src_x, const real_t* src_y, const real_t* src_z,
+        real_t* dst_x, real_t* dst_y, real_t* dst_z,
+        v8_size_t count,
+        base::job_system* jobs = nullptr
+        ) const {
+        const vector_tf_matrix_t tf_data(compute_normal_tf_matrix());
+
+        affine_transform_soa(
+            tf_data.second, vector3<real_t>::zero, src_x, src_y, src_z, 
+            dst_x, dst_y, dst_z, count, jobs);
     }
 
+    //! @}
+
 private :
 
     //!
@@ -225,7 +306,8 @@ private :
         tf_matrix.first = false;
 
         if (is_identity()) {
-            tf_matrix.first = false;
+            tf_matrix.first = true;
+            tf_matrix.second = matrix_3X3<real_t>::identity;
         } else {
             tf_matrix.second = matrix_component_;
 
@@ -242,7 +324,8 @@ private :
         tf_matrix.first = false;
 
         if (is_identity()) {
-            tf_matrix.first = false;
+            tf_matrix.first = true;
+            tf_matrix.second = matrix_3X3<real_t>::identity;
         } else {
 
             if (is_rotation_or_reflection()) {
@@ -259,7 +342,32 @@ private :
         return tf_matrix;
     }
 
-    //! @}
+    //!
+    //! \brief Inverse transpose of R * S.
+    vector_tf_matrix_t compute_normal_tf_matrix() const {
+        vector_tf_matrix_t tf_matrix;
+        tf_matrix.first = false;
+
+        if (is_identity()) {
+            tf_matrix.first = true;
+            tf_matrix.second = matrix_3X3<real_t>::identity;
+        } else {
+
+            if (is_rotation_or_reflection()) {
+                tf_matrix.second = matrix_component_;
+            } else {
+                matrix_3X3<real_t> inverse;
+                matrix_component_.get_inverse(&inverse);
+                inverse.get_transpose(&tf_matrix.second);
+            }
+
+            if (is_scaling()) {
+                tf_matrix.second /= scale_factor_component_;
+            }
+        }
+
+        return tf_matrix;
+    }
 
 public :
 };
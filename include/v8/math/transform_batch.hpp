@@ -0,0 +1,232 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+/*!
+ * \file transform_batch.hpp
+ * \brief Affine transformation of large point/vector streams, in strided
+ *      (array of structures) or SoA layout.
+ */
+
+#include <v8/v8.hpp>
+#include <v8/base/job_system.hpp>
+#include <v8/math/matrix3X3.hpp>
+#include <v8/math/vector3.hpp>
+
+namespace v8 { namespace math {
+
+/** \addtogroup __grp_v8_math_simd
+ *  @{
+ */
+
+/**
+ * \brief   Computes dst[i] = linear * src[i] + translation, for count 
+ *          elements.
+ * \param   src         Pointer to the first input element.
+ * \param   src_stride  Distance in bytes between two input elements.
+ * \param   dst         Pointer to the first output element.
+ * \param   dst_stride  Distance in bytes between two output elements.
+ * \param   jobs        Optional, when not null large ranges are split across
+ *                      the threads of the job system.
+ * \remarks Input and output may be the same array (with the same stride),
+ *          but must not otherwise overlap. The float version is vectorized 
+ *          when the elements are tightly packed (both strides equal 
+ *          sizeof(vector3F)). 
+ *          If linear is the identity, only the translation is applied.
+ */
+template<typename real_t>
+void affine_transform_strided(
+    const matrix_3X3<real_t>&   linear,
+    const vector3<real_t>&      translation,
+    const vector3<real_t>*      src,
+    v8_size_t                   src_stride,
+    vector3<real_t>*            dst,
+    v8_size_t                   dst_stride,
+    v8_size_t                   count,
+    base::job_system*           jobs = nullptr
+    );
+
+void affine_transform_strided(
+    const matrix_3X3<float>&    linear,
+    const vector3<float>&       translation,
+    const vector3<float>*       src,
+    v8_size_t                   src_stride,
+    vector3<float>*             dst,
+    v8_size_t                   dst_stride,
+    v8_size_t                   count,
+    base::job_system*           jobs = nullptr
+    );
+
+/**
+ * \brief   SoA version of affine_transform_strided. Components are stored in 
+ *          separate arrays; output arrays may be the input arrays.
+ */
+template<typename real_t>
+void affine_transform_soa(
+    const matrix_3X3<real_t>&   linear,
+    const vector3<real_t>&      translation,
+    const real_t*               src_x,
+    const real_t*               src_y,
+    const real_t*               src_z,
+    real_t*                     dst_x,
+    real_t*                     dst_y,
+    real_t*                     dst_z,
+    v8_size_t                   count,
+    base::job_system*           jobs = nullptr
+    );
+
+void affine_transform_soa(
+    const matrix_3X3<float>&    linear,
+    const vector3<float>&       translation,
+    const float*                src_x,
+    const float*                src_y,
+    const float*                src_z,
+    float*                      dst_x,
+    float*                      dst_y,
+    float*                      dst_z,
+    v8_size_t                   count,
+    base::job_system*           jobs = nullptr
+    );
+
+/**
+ * \brief Elements per task, when a range is split across threads.
+ */
+const v8_size_t C_Transform_Batch_Grain = 65536;
+
+/** @} */
+
+namespace internals {
+
+template<typename real_t>
+inline void affine_transform_strided_range(
+    const matrix_3X3<real_t>&   m,
+    const vector3<real_t>&      t,
+    const vector3<real_t>*      src,
+    v8_size_t                   src_stride,
+    vector3<real_t>*            dst,
+    v8_size_t                   dst_stride,
+    v8_size_t                   first,
+    v8_size_t                   last
+    ) {
+    const char* src_bytes = reinterpret_cast<const char*>(src);
+    char* dst_bytes = reinterpret_cast<char*>(dst);
+
+    for (v8_size_t i = first; i < last; ++i) {
+        const vector3<real_t>& in = 
+            *reinterpret_cast<const vector3<real_t>*>(src_bytes + i * src_stride);
+        const real_t x = in.x_;
+        const real_t y = in.y_;
+        const real_t z = in.z_;
+
+        vector3<real_t>& out = 
+            *reinterpret_cast<vector3<real_t>*>(dst_bytes + i * dst_stride);
+        out.x_ = m.a11_ * x + m.a12_ * y + m.a13_ * z + t.x_;
+        out.y_ = m.a21_ * x + m.a22_ * y + m.a23_ * z + t.y_;
+        out.z_ = m.a31_ * x + m.a32_ * y + m.a33_ * z + t.z_;
+    }
+}
+
+template<typename real_t>
+inline void affine_transform_soa_range(
+    const matrix_3X3<real_t>&   m,
+    const vector3<real_t>&      t,
+    const real_t*               src_x,
+    const real_t*               src_y,
+    const real_t*               src_z,
+    real_t*                     dst_x,
+    real_t*                     dst_y,
+    real_t*                     dst_z,
+    v8_size_t                   first,
+    v8_size_t                   last
+    ) {
+    for (v8_size_t i = first; i < last; ++i) {
+        const real_t x = src_x[i];
+        const real_t y = src_y[i];
+        const real_t z = src_z[i];
+
+        dst_x[i] = m.a11_ * x + m.a12_ * y + m.a13_ * z + t.x_;
+        dst_y[i] = m.a21_ * x + m.a22_ * y + m.a23_ * z + t.y_;
+        dst_z[i] = m.a31_ * x + m.a32_ * y + m.a33_ * z + t.z_;
+    }
+}
+
+template<typename range_function>
+inline void run_transform_batch(
+    base::job_system*   jobs,
+    v8_size_t           count,
+    range_function      body
+    ) {
+    if (jobs && count > C_Transform_Batch_Grain)
+        jobs->parallel_for(0, count, C_Transform_Batch_Grain, body);
+    else
+        body(0, count);
+}
+
+} // namespace internals
+
+} // namespace math
+} // namespace v8
+
+template<typename real_t>
+void v8::math::affine_transform_strided(
+    const matrix_3X3<real_t>&   linear,
+    const vector3<real_t>&      translation,
+    const vector3<real_t>*      src,
+    v8_size_t                   src_stride,
+    vector3<real_t>*            dst,
+    v8_size_t                   dst_stride,
+    v8_size_t                   count,
+    base::job_system*           jobs
+    ) {
+    internals::run_transform_batch(jobs, count,
+        [&](v8_size_t first, v8_size_t last) {
+        internals::affine_transform_strided_range(
+            linear, translation, src, src_stride, dst, dst_stride, first, last);
+    });
+}
+
+template<typename real_t>
+void v8::math::affine_transform_soa(
+    const matrix_3X3<real_t>&   linear,
+    const vector3<real_t>&      translation,
+    const real_t*               src_x,
+    const real_t*               src_y,
+    const real_t*               src_z,
+    real_t*                     dst_x,
+    real_t*                     dst_y,
+    real_t*                     dst_z,
+    v8_size_t                   count,
+    base::job_system*           jobs
+    ) {
+    internals::run_transform_batch(jobs, count,
+        [&](v8_size_t first, v8_size_t last) {
+        internals::affine_transform_soa_range(
+            linear, translation, src_x, src_y, src_z, 
+            dst_x, dst_y, dst_z, first, last);
+    });
+}
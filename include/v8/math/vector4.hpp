@@ -33,6 +33,7 @@
 
 #include <v8/base/fundamental_types.hpp>
 #include <v8/math/math_utils.hpp>
+#include <v8/math/simd/simd_config.hpp>
 #include <v8/math/vector3.hpp>
 
 namespace v8 { namespace math {
@@ -352,3 +353,7 @@ typedef vector4<double>     vector4D;
 } // namespace v8
 
 #include "vector4.inl"
+
+#if defined(V8_MATH_SIMD_ENABLED)
+#include "vector4_simd.inl"
+#endif
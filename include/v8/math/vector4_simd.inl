@@ -0,0 +1,113 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+//
+// Vectorized specializations of the vector4<float> arithmetic operators.
+// Only included when the SIMD kernels are enabled (see simd/simd_config.hpp).
+// The results are identical to the ones produced by the generic code.
+
+#include <v8/math/simd/float4.hpp>
+
+namespace v8 { namespace math {
+
+template<>
+template<>
+inline
+vector4<float>&
+vector4<float>::operator+=(const vector4<float>& rhs) {
+    simd::store_float4(elements_, simd::add(simd::load_float4(elements_),
+                                            simd::load_float4(rhs.elements_)));
+    return *this;
+}
+
+template<>
+template<>
+inline
+vector4<float>&
+vector4<float>::operator-=(const vector4<float>& rhs) {
+    simd::store_float4(elements_, simd::sub(simd::load_float4(elements_),
+                                            simd::load_float4(rhs.elements_)));
+    return *this;
+}
+
+template<>
+template<>
+inline
+vector4<float>&
+vector4<float>::operator*=(float k) {
+    simd::store_float4(elements_, simd::mul(simd::load_float4(elements_),
+                                            simd::splat_float4(k)));
+    return *this;
+}
+
+template<>
+template<>
+inline
+vector4<float>&
+vector4<float>::operator/=(float k) {
+    //
+    // Same as internals::div_helper : multiply with the reciprocal.
+    simd::store_float4(elements_, simd::mul(simd::load_float4(elements_),
+                                            simd::splat_float4(1.0f / k)));
+    return *this;
+}
+
+template<>
+inline
+vector4<float>
+operator-(const vector4<float>& vec) {
+    vector4<float> res;
+    simd::store_float4(res.elements_, 
+                       simd::negate(simd::load_float4(vec.elements_)));
+    return res;
+}
+
+template<>
+inline
+vector4<float>
+operator+(const vector4<float>& lhs, const vector4<float>& rhs) {
+    vector4<float> res;
+    simd::store_float4(res.elements_, 
+                       simd::add(simd::load_float4(lhs.elements_),
+                                 simd::load_float4(rhs.elements_)));
+    return res;
+}
+
+template<>
+inline
+vector4<float>
+operator-(const vector4<float>& lhs, const vector4<float>& rhs) {
+    vector4<float> res;
+    simd::store_float4(res.elements_, 
+                       simd::sub(simd::load_float4(lhs.elements_),
+                                 simd::load_float4(rhs.elements_)));
+    return res;
+}
+
+} // namespace math
+} // namespace v8
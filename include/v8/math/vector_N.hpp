@@ -30,6 +30,7 @@
 #include <cmath>
 #include <cstdint>
 #include <cstring>
+#include <type_traits>
 
 #include <v8/v8.hpp>
 
@@ -38,6 +39,7 @@
 #include <initializer_list>
 #endif
 
+#include <v8/math/dense_expr.hpp>
 #include <v8/math/math_utils.hpp>
 
 namespace v8 { namespace math {
@@ -49,11 +51,26 @@ namespace v8 { namespace math {
  *  @{
  */
 
+/**
+ * \brief   An N dimensional vector, with heap allocated storage. Element 
+ *          access with operator[] uses 1 based indexing.
+ *          Arithmetic operators return expressions (see dense_expr.hpp), 
+ *          evaluated without temporaries when assigned to a vector.
+ */
 template<typename real_t>
 class vector_N {
 private :
     size_t      v_dimension_;
     real_t*     v_data_;
+
+    template<typename expr>
+    struct enable_for_expr : public std::enable_if<
+        internals::is_dense_shape<expr, dense_vector_tag>::Yes> {};
+
+    dense_leaf<real_t, dense_vector_tag> as_expr() const {
+        return dense_leaf<real_t, dense_vector_tag>(v_data_, v_dimension_, 1);
+    }
+
 public :
     typedef vector_N<real_t> vector_N_t;
 
@@ -76,6 +93,20 @@ public :
         : v_dimension_(other.v_dimension_),
           v_data_(other.v_data_) {
         other.v_data_ = nullptr;
+        other.v_dimension_ = 0;
+    }
+
+    /**
+     * \brief   Constructs the vector by evaluating an expression.
+     */
+    template<typename expr>
+    vector_N(
+        const expr& e, 
+        typename enable_for_expr<expr>::type* = nullptr
+        )
+        : v_dimension_(dense_traits<expr>::as_expr(e).size()),
+          v_data_(new real_t[v_dimension_]) {
+        internals::dense_evaluate(v_data_, dense_traits<expr>::as_expr(e));
     }
 
 #if defined(V8_COMPILER_IS_GCC) || defined(V8_COMPILER_IS_CLANG) \
@@ -106,48 +137,62 @@ public :
         return *this;
     }
 
-    vector_N_t& operator+=(const vector_N_t& rhs) {
-        assert(v_dimension_ == rhs.v_dimension_);
-
-        for (size_t i = 0; i < v_dimension_; ++i)
-            v_data_[i] += rhs.v_data_[i];
+    /**
+     * \brief   Evaluates an expression into this vector. The expression may 
+     *          reference this vector.
+     */
+    template<typename expr>
+    typename std::enable_if<
+        internals::is_dense_shape<expr, dense_vector_tag>::Yes, vector_N_t&
+    >::type
+    operator=(const expr& e) {
+        assert(v_dimension_ == dense_traits<expr>::as_expr(e).size());
+        internals::dense_evaluate(v_data_, dense_traits<expr>::as_expr(e));
         return *this;
     }
 
-    vector_N_t& operator-=(const vector_N_t& rhs) {
-        assert(v_dimension_ == rhs.v_dimension_);
+    template<typename expr>
+    typename std::enable_if<
+        internals::is_dense_shape<expr, dense_vector_tag>::Yes, vector_N_t&
+    >::type
+    operator+=(const expr& rhs) {
+        internals::dense_evaluate(v_data_, as_expr() + rhs);
+        return *this;
+    }
 
-        for (size_t i = 0; i < v_dimension_; ++i)
-            v_data_[i] -= rhs.v_data_[i];
+    template<typename expr>
+    typename std::enable_if<
+        internals::is_dense_shape<expr, dense_vector_tag>::Yes, vector_N_t&
+    >::type
+    operator-=(const expr& rhs) {
+        internals::dense_evaluate(v_data_, as_expr() - rhs);
         return *this;
     }
 
     vector_N_t& operator*=(real_t k) {
-        for (size_t i = 0; i < v_dimension_; ++i)
-            v_data_[i] *= k;
+        internals::dense_evaluate(v_data_, as_expr() * k);
         return *this;
     }
 
     vector_N_t& operator/=(real_t k) {
-        typename internals::div_wrap_t<real_t>::div_helper_t div_val(k);
-        for (size_t i = 0; i < v_dimension_; ++i)
-            v_data_[i] = div_val(v_data_[i]);
+        internals::dense_evaluate(v_data_, as_expr() / k);
         return *this;
     }
 
-    vector_N_t& operator^=(const vector_N_t& rhs) {
-        assert(v_dimension_ == rhs.v_dimension_);
-
-        for (size_t i = 0; i < v_dimension_; ++i)
-            v_data_[i] *= rhs.v_data_[i];
+    /**
+     * \brief   Component wise multiplication.
+     */
+    template<typename expr>
+    typename std::enable_if<
+        internals::is_dense_shape<expr, dense_vector_tag>::Yes, vector_N_t&
+    >::type
+    operator^=(const expr& rhs) {
+        internals::dense_evaluate(v_data_, as_expr() ^ rhs);
         return *this;
     }
 
     real_t length_squared() const {
-        real_t len_sq = real_t(0);
-        for (size_t i = 0; i < v_dimension_; ++i)
-            len_sq += v_data_[i] * v_data_[i];
-        return len_sq;
+        return internals::dense_dot(as_expr(), as_expr());
     }
 
     real_t length() const {
@@ -159,10 +204,7 @@ public :
         if (is_zero(vec_mag)) {
             memset(v_data_, 0, sizeof(real_t) * v_dimension_);
         } else {
-            typename internals::div_wrap_t<real_t>::div_helper_t div_val(vec_mag);
-            for (size_t i = 0; i < v_dimension_; ++i) {
-                v_data_[i] = div_val(v_data_[i]);
-            }
+            *this /= vec_mag;
         }
         return *this;
     }
@@ -206,6 +248,18 @@ public :
     }
 };
 
+template<typename real_t>
+struct dense_traits<vector_N<real_t>, void> {
+    enum { is_dense = true };
+    typedef dense_leaf<real_t, dense_vector_tag>    expr_type;
+    typedef real_t                                  value_type;
+    typedef dense_vector_tag                        shape_tag;
+
+    static expr_type as_expr(const vector_N<real_t>& vec) {
+        return expr_type(vec.get_data(), vec.get_dimension(), 1);
+    }
+};
+
 template<typename real_t>
 inline bool operator==(const vector_N<real_t>& v0, const vector_N<real_t>& v1) {
     assert(v0.get_dimension() == v1.get_dimension());
@@ -224,72 +278,13 @@ inline bool operator!=(const vector_N<real_t>& v0, const vector_N<real_t>& v1) {
     return !(v0 == v1);
 }
 
-template<typename real_t>
-inline vector_N<real_t> operator-(const vector_N<real_t>& in_vec) {
-    vector_N<real_t> out_vec(in_vec.get_dimension());
-    const real_t* in_data = in_vec.get_data();
-    real_t* out_data = out_vec.get_data();
-
-    for (size_t i = 0; i < in_vec.get_dimension(); ++i)
-        out_data[i] = -in_data[i];
-    return out_vec;
-}
-
-template<typename real_t>
-inline vector_N<real_t>
-operator+(const vector_N<real_t>& v0, const vector_N<real_t>& v1) {
-    vector_N<real_t> result(v0);
-    result += v1;
-    return result;
-}
-
-template<typename real_t>
-inline vector_N<real_t>
-operator-(const vector_N<real_t>& v0, const vector_N<real_t>& v1) {
-    vector_N<real_t> result(v0);
-    result -= v1;
-    return result;
-}
-
-template<typename real_t>
-inline vector_N<real_t> operator*(const vector_N<real_t>& v0, real_t k) {
-    vector_N<real_t> result(v0);
-    result *= k;
-    return result;
-}
-
-template<typename real_t>
-inline vector_N<real_t> operator*(real_t k, const vector_N<real_t>& v0) {
-    return v0 * k;
-}
-
-template<typename real_t>
-inline vector_N<real_t> operator/(const vector_N<real_t>& v0, real_t k) {
-    vector_N<real_t> result(v0);
-    result /= k;
-    return result;
-}
-
-template<typename real_t>
-inline vector_N<real_t> operator^(const vector_N<real_t>& v0,
-                                  const vector_N<real_t>& v1) {
-    vector_N<real_t> result(v0);
-    result ^= v1;
-    return result;
-}
-
 template<typename real_t>
 inline real_t dot_product(const vector_N<real_t>& v0,
                           const vector_N<real_t>& v1) {
     assert(v0.get_dimension() == v1.get_dimension());
-    const real_t* v0_data = v0.get_data();
-    const real_t* v1_data = v1.get_data();
-    real_t dotp_value = real_t(0);
-
-    for (size_t i = 0; i < v0.get_dimension(); ++i) {
-        dotp_value += v0_data[i] * v1_data[i];
-    }
-    return dotp_value;
+    return internals::dense_dot(
+        dense_traits<vector_N<real_t>>::as_expr(v0),
+        dense_traits<vector_N<real_t>>::as_expr(v1));
 }
 
 /** @} */
@@ -0,0 +1,93 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <v8/v8.hpp>
+
+namespace v8 { namespace scene {
+
+///
+/// \brief Packs the state used to order draw calls into a 64 bit key. 
+/// Sorting the keys in ascending order gives the draw order : 
+/// opaque objects first, grouped by technique and material and drawn front 
+/// to back inside a group, then translucent objects, back to front.
+/// \remarks Layout (most significant bit first) :
+///   - opaque : 0 | technique (12) | material (16) | unused (11) | depth (24)
+///   - translucent : 1 | inverted depth (24) | technique (12) | 
+///     material (16) | unused (11)
+struct draw_key {
+    static const v8_uint32_t k_technique_bits = 12;
+    static const v8_uint32_t k_material_bits = 16;
+    static const v8_uint32_t k_depth_bits = 24;
+
+    static const v8_uint32_t k_max_technique = (1U << k_technique_bits) - 1;
+    static const v8_uint32_t k_max_material = (1U << k_material_bits) - 1;
+    static const v8_uint32_t k_max_depth = (1U << k_depth_bits) - 1;
+
+    ///
+    /// \brief Maps a view space depth to the [0, k_max_depth] range.
+    static v8_uint32_t quantize_depth(
+        float view_depth, 
+        float near_plane, 
+        float far_plane
+        ) {
+        const float t = (view_depth - near_plane) / (far_plane - near_plane);
+        if (!(t > 0.0f)) {
+            return 0;
+        }
+        if (t >= 1.0f) {
+            return k_max_depth;
+        }
+        return static_cast<v8_uint32_t>(t * static_cast<float>(k_max_depth));
+    }
+
+    static v8_uint64_t make_opaque(
+        v8_uint32_t technique_id,
+        v8_uint32_t material_id,
+        v8_uint32_t depth
+        ) {
+        return (static_cast<v8_uint64_t>(technique_id & k_max_technique) << 51)
+               | (static_cast<v8_uint64_t>(material_id & k_max_material) << 35)
+               | static_cast<v8_uint64_t>(depth & k_max_depth);
+    }
+
+    static v8_uint64_t make_translucent(
+        v8_uint32_t technique_id,
+        v8_uint32_t material_id,
+        v8_uint32_t depth
+        ) {
+        return (static_cast<v8_uint64_t>(1) << 63)
+               | (static_cast<v8_uint64_t>(k_max_depth - (depth & k_max_depth)) 
+                  << 39)
+               | (static_cast<v8_uint64_t>(technique_id & k_max_technique) << 27)
+               | (static_cast<v8_uint64_t>(material_id & k_max_material) << 11);
+    }
+};
+
+} // namespace scene
+} // namespace v8
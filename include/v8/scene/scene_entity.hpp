@@ -3,11 +3,13 @@
 #include <v8/v8.hpp>
 #include <v8/math/vector3.hpp>
 #include <v8/math/transform.hpp>
+#include <v8/math/objects/sphere.hpp>
 
 #include <v8/rendering/fwd_renderer.hpp>
 #include <v8/rendering/fwd_effect.hpp>
 #include <v8/rendering/fwd_effect_technique.hpp>
 #include <v8/scene/fwd_scene_system.hpp>
+#include <v8/scene/transform_hierarchy.hpp>
 
 namespace v8 { namespace scene {
 
@@ -19,7 +21,13 @@ public :
 
     scene_entity()
         :   attached_effect_(nullptr),
-            technique_(nullptr)
+            technique_(nullptr),
+            local_bound_(v8::math::vector3F::zero, 0.0f),
+            has_local_bound_(false),
+            sort_material_id_(0),
+            translucent_(false),
+            update_thread_safe_(false),
+            transform_node_(transform_hierarchy::C_Null_Node)
     {}
 
     virtual ~scene_entity() {}
@@ -74,6 +82,67 @@ public :
         return world_transform_;
     }
 
+    //! \brief Links the entity to a node of the scene's transform_hierarchy
+    //! (C_Null_Node to unlink it). The world transform of a linked entity 
+    //! is overwritten with the world transform of the node on every 
+    //! scene_system::update().
+    void set_transform_node(transform_hierarchy::node_handle node) {
+        transform_node_ = node;
+    }
+
+    transform_hierarchy::node_handle get_transform_node() const {
+        return transform_node_;
+    }
+
+    //! \brief Sets the bounding sphere of the entity, in model space.
+    //! Entities without a bounding sphere are never culled.
+    void set_local_bound(const v8::math::sphereF& bound) {
+        local_bound_ = bound;
+        has_local_bound_ = true;
+    }
+
+    const v8::math::sphereF& get_local_bound() const {
+        return local_bound_;
+    }
+
+    v8_bool_t has_local_bound() const {
+        return has_local_bound_;
+    }
+
+    //! \brief Returns the bounding sphere of the entity, in world space.
+    //! The sphere is derived from the local bound and the world transform.
+    v8::math::sphereF get_world_bound() const;
+
+    //! \brief Sets the identifier used to group entities that share a 
+    //! material when sorting the draw calls.
+    void set_sort_material_id(v8_uint32_t material_id) {
+        sort_material_id_ = material_id;
+    }
+
+    v8_uint32_t get_sort_material_id() const {
+        return sort_material_id_;
+    }
+
+    //! \brief Translucent entities are drawn after the opaque ones, 
+    //! back to front.
+    void set_translucent(v8_bool_t translucent) {
+        translucent_ = translucent;
+    }
+
+    v8_bool_t is_translucent() const {
+        return translucent_;
+    }
+
+    //! \brief Declares that update() only touches the entity's own data, so
+    //! it can be called concurrently with the update of other entities.
+    void set_update_thread_safe(v8_bool_t thread_safe) {
+        update_thread_safe_ = thread_safe;
+    }
+
+    v8_bool_t is_update_thread_safe() const {
+        return update_thread_safe_;
+    }
+
 /// @}
 
 /// \name Members.
@@ -91,6 +160,24 @@ protected :
     ///< Stores the world transform for this entity.
     v8::math::transformF                                    world_transform_;
 
+    ///< Bounding sphere, in model space.
+    v8::math::sphereF                                       local_bound_;
+
+    ///< True if a bounding sphere was assigned to the entity.
+    v8_bool_t                                               has_local_bound_;
+
+    ///< Material identifier, used to sort draw calls.
+    v8_uint32_t                                             sort_material_id_;
+
+    ///< True if the entity must be blended with what is behind it.
+    v8_bool_t                                               translucent_;
+
+    ///< True if update() can run in parallel with other entities' updates.
+    v8_bool_t                                               update_thread_safe_;
+
+    ///< Node that supplies the world transform, or C_Null_Node.
+    transform_hierarchy::node_handle                        transform_node_;
+
 /// @}
 };
 
@@ -12,13 +12,18 @@
 #include <v8/base/scoped_pointer.hpp>
 #include <v8/base/sequence_container_veneer.hpp>
 #include <v8/base/fixed_pod_vector.hpp>
+#include <v8/base/job_system.hpp>
 
 #include <v8/math/camera.hpp>
+#include <v8/math/culling/culler.hpp>
+#include <v8/math/objects/ray3.hpp>
+#include <v8/math/spatial/aabb_tree.hpp>
 #include <v8/math/light.hpp>
 #include <v8/io/config_file_reader.hpp>
 #include <v8/rendering/fwd_renderer.hpp>
 #include <v8/scene/scene_entity.hpp>
 #include <v8/scene/camera_controller.hpp>
+#include <v8/scene/transform_hierarchy.hpp>
 #include <v8/scene/fwd_scene_loading_info.hpp>
 
 namespace v8 { namespace scene {
@@ -36,6 +41,33 @@ public :
 
 /// @}
 
+//! \name Frame statistics.
+//! @{
+
+public :
+
+    //! \brief Counters collected while culling and drawing the last frame.
+    struct frame_stats_t {
+        //! Number of entities whose bound was tested against the view 
+        //! frustrum. Entities in subtrees of the spatial index that are
+        //! entirely inside the frustrum are accepted without a test.
+        v8_uint32_t     entities_tested;
+        //! Number of spatial index nodes (internal nodes and leaves) 
+        //! visited by the culling query.
+        v8_uint32_t     nodes_visited;
+        //! Number of entities rejected by the culler.
+        v8_uint32_t     entities_culled;
+        //! Number of entities that were drawn.
+        v8_uint32_t     entities_drawn;
+    };
+
+    //! \brief Returns the counters for the last drawn frame.
+    const frame_stats_t& get_frame_stats() const {
+        return m_frame_stats;
+    }
+
+//! @}
+
 //! \name Construction/initialisation
 //! @{
 
@@ -54,19 +86,46 @@ public :
 
     //! \brief Adds a new entity to the scene.
     //! \remarks The scene_system takes ownership of the entity.
-    void add_entity(scene_entity* new_entity) {
-        m_entity_list.push_back(new_entity);
-    }
+    void add_entity(scene_entity* new_entity);
 
     //! \brief Removes the specified entity from the list. 
     //! The entity is destroyed.
-    void remove_entity(scene_entity* entity) {
-        auto itr_entity = std::find(std::begin(m_entity_list), 
-                                    std::end(m_entity_list), entity);
-        if (itr_entity != std::end(m_entity_list)) {
-            delete entity;
-            m_entity_list.erase(itr_entity);
-        }
+    void remove_entity(scene_entity* entity);
+
+    //! \brief Returns the closest entity whose bounding sphere is hit by
+    //! the ray, or null.
+    //! \param[in] ray Ray, in world space.
+    //! \param[out] hit_distance Optional. Receives the distance along the 
+    //! ray, to the hit point.
+    //! \remarks Entities added since the last update() or draw() are not
+    //! indexed yet and cannot be picked.
+    scene_entity* pick_entity(
+        const v8::math::ray3F& ray,
+        float* hit_distance = nullptr
+        ) const;
+
+    //! \brief Rebuilds the spatial index of the entities from scratch, 
+    //! with a top down (surface area heuristic) construction.
+    //! \remarks Entities added to the scene are indexed on the next update
+    //! or draw. When they outnumber the entities already indexed (for 
+    //! example all the entities of a newly loaded scene), the index is 
+    //! rebuilt this way rather than grown one insertion at a time. Call it 
+    //! directly after large changes to the scene.
+    void rebuild_spatial_index();
+
+    //! \brief Local and world transforms of the scene nodes. World 
+    //! transforms are recomputed by update(), after the entities are 
+    //! updated, and copied to the entities linked to a node (see 
+    //! scene_entity::set_transform_node()).
+    //! \remarks Entities updated in parallel may call set_local_transform()
+    //! for distinct nodes. Adding, removing or reparenting nodes must be 
+    //! done on a single thread.
+    transform_hierarchy* get_transform_hierarchy() {
+        return &m_transform_hierarchy;
+    }
+
+    const transform_hierarchy* get_transform_hierarchy() const {
+        return &m_transform_hierarchy;
     }
 
 //! @}
@@ -164,8 +223,21 @@ public :
 public :
 
     //! \brief Updates the state of all entities.
+    //! \remarks If a job system is set, the entities that declare their 
+    //! update thread safe are updated in parallel.
     virtual void update(float delta_ms);
 
+    //! \brief Sets the job system used to update entities in parallel. 
+    //! Pass null to update all entities on the calling thread.
+    //! \remarks The scene_system does not take ownership of the job system.
+    void set_job_system(v8::base::job_system* job_sys) {
+        m_job_system = job_sys;
+    }
+
+    v8::base::job_system* get_job_system() const {
+        return m_job_system;
+    }
+
     //! \brief Draws all (visible) entities in the scene.
     virtual void draw(v8::rendering::renderer*);
 
@@ -185,8 +257,27 @@ protected :
 
 protected :
 
+    //! \brief Sorts the visible entities by their draw keys (see draw_key).
+    //! Opaque entities are sorted by state and front to back, translucent
+    //! entities back to front.
     void depth_sort_all();
 
+    //! \brief Culls the entities against the camera's frustrum and fills
+    //! the list of visible entities.
+    void build_visible_list();
+
+    //! \brief Brings the spatial index up to date with the entities' 
+    //! world bounds.
+    void update_spatial_index();
+
+    //! \brief Adds the entities that are not indexed yet to the spatial 
+    //! index, rebuilding it if they outnumber the indexed ones.
+    void index_new_entities();
+
+    //! \brief Recomputes the world transforms of the hierarchy and copies 
+    //! them to the entities linked to a node.
+    void update_entity_transforms();
+
 //! @}
 
 //! \name Entity management structures.
@@ -246,6 +337,54 @@ protected :
     v8_int32_t                                  m_light_count;
     v8_int32_t                                  m_active_light_count;
     v8_byte_t                                   m_active_list;
+
+    //! Supplies the frustrum planes of the active camera.
+    v8::math::culler                            m_culler;
+
+    //! Spatial index of the entities that have a bounding volume. The user 
+    //! data of every proxy is the entity.
+    v8::math::aabb_tree                         m_entity_tree;
+
+    //! Proxy id of every entity in m_entity_tree (indexed like 
+    //! m_entity_list), or aabb_tree::C_Null_Node for unbounded entities.
+    std::vector<v8_int32_t>                     m_entity_proxies;
+
+    //! Local and world transforms of the scene nodes.
+    transform_hierarchy                         m_transform_hierarchy;
+
+    //! Entities without a bounding volume. They are never culled.
+    std::vector<scene_entity*>                  m_unbounded_ents;
+
+    //! Number of entities added since the spatial index was last updated.
+    v8_size_t                                   m_unindexed_count;
+
+    //! Bounds, entities and proxy ids, scratch buffers for 
+    //! rebuild_spatial_index().
+    std::vector<v8::math::aabb3F>               m_build_boxes;
+    std::vector<void*>                          m_build_entities;
+    std::vector<v8_int32_t>                     m_build_proxies;
+
+    //! Visible entity and its draw key, sorted by depth_sort_all().
+    struct draw_item_t {
+        v8_uint64_t     di_key;
+        scene_entity*   di_entity;
+    };
+
+    //! Draw items and the scratch buffer for the radix sort.
+    std::vector<draw_item_t>                    m_draw_items;
+    std::vector<draw_item_t>                    m_draw_items_scratch;
+
+    //! Maps techniques to small identifiers, for the draw keys.
+    std::unordered_map<const void*, v8_uint32_t> m_technique_ids;
+
+    //! Optional job system for parallel updates (not owned).
+    v8::base::job_system*                       m_job_system;
+
+    //! Entities updated in parallel during the current update.
+    std::vector<scene_entity*>                  m_parallel_update_ents;
+
+    //! Counters for the last frame.
+    frame_stats_t                               m_frame_stats;
 //! @}
 
 //! \name Disabled operations.
@@ -6,6 +6,7 @@
 
 #include <v8/v8.hpp>
 #include <v8/math/light.hpp>
+#include <v8/scene/transform_hierarchy.hpp>
 
 namespace v8 { namespace scene {
 
@@ -15,7 +16,8 @@ public :
     //! @{
 
     simple_node(simple_node* parent = nullptr)
-        : parent_(parent) {
+        : parent_(parent),
+          transform_node_(transform_hierarchy::C_Null_Node) {
     }
 
     virtual ~simple_node() {}
@@ -55,6 +57,17 @@ public :
         parent_ = parent;
     }
 
+    //! Handle of the node's local/world transforms, in the 
+    //! transform_hierarchy owned by the scene_system (see 
+    //! scene_system::get_transform_hierarchy()), or C_Null_Node.
+    transform_hierarchy::node_handle get_transform_node() const {
+        return transform_node_;
+    }
+
+    void set_transform_node(transform_hierarchy::node_handle node) {
+        transform_node_ = node;
+    }
+
     //! @}
 
 protected :
@@ -69,6 +82,9 @@ protected :
     //! Parent of this node (null if the node is the root node).
     simple_node*    parent_;
 
+    //! Transforms of this node, in the scene_system's transform_hierarchy.
+    transform_hierarchy::node_handle    transform_node_;
+
     //! @}
 
 private :
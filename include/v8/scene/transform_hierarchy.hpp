@@ -0,0 +1,176 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+
+#pragma once
+
+#include <cassert>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/math/transform.hpp>
+
+namespace v8 { namespace scene {
+
+//!
+//! \brief Stores the local and world transforms of a node hierarchy.
+//! Nodes are kept in contiguous arrays, ordered so that a parent always
+//! comes before its children. World transforms are then recomputed with a
+//! single forward pass, that only touches the nodes whose local transform
+//! changed since the last update, and their descendants.
+//! Nodes are referenced by handles, which stay valid until the node is
+//! removed, regardless of how the nodes are stored.
+class transform_hierarchy {
+public :
+    //! \name Types and constants.
+    //! @{
+
+    typedef v8_int32_t  node_handle;
+
+    static const node_handle C_Null_Node = -1;
+
+    //! @}
+
+public :
+    //! \name Constructors
+    //! @{
+
+    transform_hierarchy();
+
+    //! @}
+
+public :
+    //! \name Tree operations.
+    //! @{
+
+    void reserve(v8_size_t node_count);
+
+    //!
+    //! \brief Adds a node as a child of parent (C_Null_Node for a root).
+    node_handle add_node(
+        node_handle parent = C_Null_Node, 
+        const v8::math::transformF& local_transform = v8::math::transformF()
+        );
+
+    //!
+    //! \brief Removes a node and all of its descendants.
+    void remove_node(node_handle node);
+
+    //!
+    //! \brief Moves the node (and its subtree) under a different parent.
+    //! The new parent must not be a descendant of the node.
+    void set_parent(node_handle node, node_handle parent);
+
+    node_handle get_parent(node_handle node) const;
+
+    bool is_valid_node(node_handle node) const;
+
+    v8_size_t get_node_count() const {
+        return parent_slot_.size();
+    }
+
+    void clear();
+
+    //! @}
+
+public :
+    //! \name Transforms.
+    //! @{
+
+    void set_local_transform(
+        node_handle node, 
+        const v8::math::transformF& local_transform
+        );
+
+    const v8::math::transformF& get_local_transform(node_handle node) const {
+        return local_transforms_[slot_of(node)];
+    }
+
+    //!
+    //! \brief World transform of the node, as computed by the last call to
+    //! update_world_transforms().
+    const v8::math::transformF& get_world_transform(node_handle node) const {
+        return world_transforms_[slot_of(node)];
+    }
+
+    //!
+    //! \brief Recomputes the world transform of every node whose local 
+    //! transform (or the local transform of one of its ancestors) was 
+    //! changed, or that was added or reparented since the last update.
+    //! \returns Number of world transforms that were recomputed.
+    v8_size_t update_world_transforms();
+
+    //! @}
+
+private :
+
+    v8_int32_t slot_of(node_handle node) const {
+        assert(is_valid_node(node));
+        return handle_slots_[node];
+    }
+
+    void restore_order();
+
+private :
+
+    //! \name Data members
+    //! @{
+
+    //! Per slot data, parent slots always come before child slots.
+    std::vector<v8_int32_t>             parent_slot_;
+    std::vector<node_handle>            slot_handles_;
+    std::vector<v8::math::transformF>   local_transforms_;
+    std::vector<v8::math::transformF>   world_transforms_;
+
+    //! Set when the local transform changed, cleared by the update.
+    std::vector<v8_uint8_t>             local_dirty_;
+
+    //! Set by the update for the nodes whose world transform changed.
+    std::vector<v8_uint8_t>             world_changed_;
+
+    //! Slot of every handle (-1 for free handles).
+    std::vector<v8_int32_t>             handle_slots_;
+
+    //! Handles of removed nodes, reused by add_node().
+    std::vector<node_handle>            free_handles_;
+
+    //! False after a reparenting moved a node before its new parent.
+    bool                                order_valid_;
+
+    //! @}
+
+private :
+
+    //! \name Disabled operations.
+    //! @{
+
+    NO_CC_ASSIGN(transform_hierarchy);
+
+    //! @}
+};
+
+} // namespace scene
+} // namespace v8
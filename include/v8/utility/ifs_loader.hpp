@@ -8,6 +8,16 @@
 
 #include <v8/rendering/vertex_pn.hpp>
 
+namespace v8 { namespace base {
+class job_system;
+} // namespace base
+} // namespace v8
+
+namespace v8 { namespace math {
+class mesh_streams;
+} // namespace math
+} // namespace v8
+
 namespace v8 { namespace utility {
 
 class ifs_loader {
@@ -22,33 +32,35 @@ public :
 
 private :
 
-    v8_bool_t readStringData(HANDLE fptr, std::vector<v8_uint8_t>* str);
-
-    v8_bool_t readFloat(HANDLE fptr, float* outVal);
-
-    v8_bool_t readUint(HANDLE fptr, v8_uint_t* outVal);
+    v8_bool_t readVertices(const v8_uint8_t* src, v8_uint_t howMany);
 
-    v8_bool_t readElementCount(
-        HANDLE fptr, v8_uint_t* vertexCnt, const char* hdrString
-        );
+    v8_bool_t readFaces(const v8_uint8_t* src, v8_uint_t howMany);
 
-    v8_bool_t readVertices(HANDLE fptr, v8_uint_t howMany);
-
-    v8_bool_t readFaces(HANDLE fptr, v8_uint_t howMany);
-
-    v8_bool_t readIFSHeader(HANDLE fptr);
-
-    void compute_mesh_normals();
+    void compute_mesh_normals(base::job_system* jobs);
 
 public :
     ifs_loader() : isValid_(false), invert_z_(false) {}
 
-    v8_bool_t loadModel(const char* modelFile, v8_bool_t invert_z = false);
+    //!
+    //! Loads an IFS model. The file is memory mapped, the header is validated
+    //! once and vertex and index blocks are copied in bulk. Indices are
+    //! checked against the vertex count before normals are computed. When
+    //! jobs is not null, normals of large models are computed on the 
+    //! threads of the job system.
+    v8_bool_t loadModel(const char* modelFile, v8_bool_t invert_z = false,
+                        base::job_system* jobs = nullptr);
 
     v8_size_t getFaceCount() const {
         assert(isValid_);
         return numFaces_;
     }
+
+    //!
+    //! Copies the vertices of the loaded model into separate streams. Only 
+    //! the streams selected by the mask of the destination are filled, so 
+    //! a position only copy can be made with a mesh_streams object 
+    //! constructed with Mesh_Stream_Position.
+    void getVertexStreams(math::mesh_streams* streams) const;
 };
 
 } // namespace utility
@@ -0,0 +1,213 @@
+#include <cassert>
+#include "v8/base/job_system.hpp"
+
+#if defined(V8_COMPILER_IS_MSVC)
+#define V8_THREAD_LOCAL __declspec(thread)
+#else
+#define V8_THREAD_LOCAL __thread
+#endif
+
+namespace {
+
+//
+// Identifies the job system and queue of a worker thread. 
+V8_THREAD_LOCAL const void* tls_job_system = nullptr;
+V8_THREAD_LOCAL v8_uint32_t tls_queue_index = 0;
+
+} // anonymous namespace
+
+v8::base::job_system::job_system(v8_uint32_t worker_count)
+    :       queued_jobs_(0)
+        ,   stop_(false)
+{
+    if (!worker_count) {
+        const v8_uint32_t hw_threads = std::thread::hardware_concurrency();
+        worker_count = hw_threads > 1 ? hw_threads - 1 : 0;
+    }
+
+    //
+    // Queue 0 belongs to the owner thread.
+    for (v8_uint32_t i = 0; i <= worker_count; ++i) {
+        queues_.push_back(std::unique_ptr<job_queue>(new job_queue()));
+    }
+
+    for (v8_uint32_t i = 1; i <= worker_count; ++i) {
+        workers_.push_back(std::thread(&job_system::worker_main, this, i));
+    }
+}
+
+v8::base::job_system::~job_system() {
+    {
+        std::lock_guard<std::mutex> wake_guard(wake_lock_);
+        stop_ = true;
+    }
+    wake_event_.notify_all();
+
+    for (auto itr = workers_.begin(); itr != workers_.end(); ++itr) {
+        itr->join();
+    }
+}
+
+v8::base::job_system::job_handle 
+v8::base::job_system::create_job(
+    const job_function& fn, 
+    const job_handle& parent
+    ) {
+    job_handle new_job(new job());
+    new_job->fn = fn;
+    new_job->parent = parent;
+    new_job->unfinished = 1;
+    new_job->pending = 1;
+    new_job->finished = false;
+
+    if (parent) {
+        assert(!is_finished(parent) && "Parent job has already finished!");
+        ++parent->unfinished;
+    }
+
+    return new_job;
+}
+
+void v8::base::job_system::add_dependency(
+    const job_handle& job, 
+    const job_handle& prerequisite
+    ) {
+    assert(job && prerequisite);
+
+    std::lock_guard<std::mutex> cont_guard(prerequisite->continuation_lock);
+    if (!prerequisite->finished) {
+        ++job->pending;
+        prerequisite->continuations.push_back(job);
+    }
+}
+
+void v8::base::job_system::submit(const job_handle& job) {
+    assert(job);
+    if (--job->pending == 0) {
+        enqueue(job);
+    }
+}
+
+bool v8::base::job_system::is_finished(const job_handle& job) {
+    return job->unfinished.load() == 0;
+}
+
+void v8::base::job_system::wait(const job_handle& job) {
+    const v8_uint32_t queue_index = current_queue_index();
+
+    while (!is_finished(job)) {
+        job_handle next_job(get_job(queue_index));
+        if (next_job) {
+            execute(next_job);
+        } else {
+            std::this_thread::yield();
+        }
+    }
+}
+
+v8_uint32_t v8::base::job_system::current_queue_index() const {
+    return tls_job_system == this ? tls_queue_index : 0;
+}
+
+void v8::base::job_system::enqueue(const job_handle& job) {
+    job_queue& queue = *queues_[current_queue_index()];
+    {
+        std::lock_guard<std::mutex> queue_guard(queue.lock);
+        queue.jobs.push_back(job);
+    }
+
+    ++queued_jobs_;
+
+    //
+    // Taking the lock orders the notification after a sleeping worker's 
+    // check of queued_jobs_, so the wake up cannot be lost.
+    {
+        std::lock_guard<std::mutex> wake_guard(wake_lock_);
+    }
+    wake_event_.notify_one();
+}
+
+v8::base::job_system::job_handle 
+v8::base::job_system::get_job(v8_uint32_t queue_index) {
+    //
+    // Newest job from our own queue (its data is likely still in the cache),
+    // else the oldest job from another queue.
+    {
+        job_queue& own_queue = *queues_[queue_index];
+        std::lock_guard<std::mutex> queue_guard(own_queue.lock);
+        if (!own_queue.jobs.empty()) {
+            job_handle job(own_queue.jobs.back());
+            own_queue.jobs.pop_back();
+            --queued_jobs_;
+            return job;
+        }
+    }
+
+    const v8_uint32_t queue_count = static_cast<v8_uint32_t>(queues_.size());
+    for (v8_uint32_t i = 1; i < queue_count; ++i) {
+        job_queue& victim = *queues_[(queue_index + i) % queue_count];
+        std::lock_guard<std::mutex> queue_guard(victim.lock);
+        if (!victim.jobs.empty()) {
+            job_handle job(victim.jobs.front());
+            victim.jobs.pop_front();
+            --queued_jobs_;
+            return job;
+        }
+    }
+
+    return job_handle();
+}
+
+void v8::base::job_system::execute(const job_handle& job) {
+    if (job->fn) {
+        job->fn();
+    }
+    finish(job);
+}
+
+void v8::base::job_system::finish(const job_handle& job) {
+    if (--job->unfinished != 0) {
+        return;
+    }
+
+    std::vector<job_handle> continuations;
+    {
+        std::lock_guard<std::mutex> cont_guard(job->continuation_lock);
+        job->finished = true;
+        continuations.swap(job->continuations);
+    }
+
+    //
+    // Release the function's captures now, the handle may live on.
+    job->fn = job_function();
+
+    for (auto itr = continuations.begin(); itr != continuations.end(); ++itr) {
+        if (--(*itr)->pending == 0) {
+            enqueue(*itr);
+        }
+    }
+
+    job_handle parent;
+    parent.swap(job->parent);
+    if (parent) {
+        finish(parent);
+    }
+}
+
+void v8::base::job_system::worker_main(v8_uint32_t queue_index) {
+    tls_job_system = this;
+    tls_queue_index = queue_index;
+
+    while (!stop_) {
+        job_handle job(get_job(queue_index));
+        if (job) {
+            execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> wake_guard(wake_lock_);
+        wake_event_.wait(wake_guard, [this]() {
+            return stop_ || queued_jobs_.load() > 0;
+        });
+    }
+}
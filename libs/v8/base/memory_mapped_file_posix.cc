@@ -0,0 +1,40 @@
+#include "pch_hdr.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <v8/base/posix_handle_policies.hpp>
+#include <v8/base/posix_utils.hpp>
+#include <v8/base/scoped_handle.hpp>
+
+#include "v8/base/memory_mapped_file.hpp"
+
+v8::base::memory_mapped_file::memory_mapped_file(const char* file_name)
+    :   mapping_(nullptr), size_(0) {
+    scoped_handle<posix_handle> fd(
+        HANDLE_SYSCALL_EINTR(open(file_name, O_RDONLY)));
+    if (!fd)
+        return;
+
+    struct stat file_info;
+    if (fstat(scoped_handle_get(fd), &file_info) == -1 || 
+        file_info.st_size <= 0)
+        return;
+
+    //
+    // The mapping keeps its own reference to the file, so the descriptor
+    // can be closed once mmap() returns.
+    void* mapping = mmap(nullptr, static_cast<v8_size_t>(file_info.st_size),
+                         PROT_READ, MAP_PRIVATE, scoped_handle_get(fd), 0);
+    if (mapping == MAP_FAILED)
+        return;
+
+    mapping_ = mapping;
+    size_ = static_cast<v8_size_t>(file_info.st_size);
+}
+
+v8::base::memory_mapped_file::~memory_mapped_file() {
+    if (mapping_)
+        munmap(mapping_, size_);
+}
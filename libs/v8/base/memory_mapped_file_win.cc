@@ -0,0 +1,39 @@
+#include "pch_hdr.hpp"
+
+#include <v8/base/scoped_handle.hpp>
+#include <v8/base/win32_handle_traits.hpp>
+
+#include "v8/base/memory_mapped_file.hpp"
+
+v8::base::memory_mapped_file::memory_mapped_file(const char* file_name)
+    :   mapping_(nullptr), size_(0) {
+    scoped_handle<win32_file_handle> file(
+        ::CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                      OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
+    if (!file)
+        return;
+
+    LARGE_INTEGER file_size;
+    if (!::GetFileSizeEx(scoped_handle_get(file), &file_size) || 
+        file_size.QuadPart <= 0)
+        return;
+
+    //
+    // The view keeps the mapping object and the file alive, both handles
+    // can be closed once it is created.
+    scoped_handle<win32_file_mapping> mapping(
+        ::CreateFileMappingA(scoped_handle_get(file), nullptr, PAGE_READONLY,
+                             0, 0, nullptr));
+    if (!mapping)
+        return;
+
+    mapping_ = ::MapViewOfFile(scoped_handle_get(mapping), FILE_MAP_READ,
+                               0, 0, 0);
+    if (mapping_)
+        size_ = static_cast<v8_size_t>(file_size.QuadPart);
+}
+
+v8::base::memory_mapped_file::~memory_mapped_file() {
+    if (mapping_)
+        ::UnmapViewOfFile(mapping_);
+}
@@ -0,0 +1,495 @@
+#include "pch_hdr.hpp"
+
+#include <v8/math/spatial/aabb_tree.hpp>
+
+namespace {
+
+inline v8::math::aabb3F combine(
+    const v8::math::aabb3F& a, const v8::math::aabb3F& b
+    ) {
+    using namespace v8::math;
+    return aabb3F(
+        vector3F(min(a.min_point_.x_, b.min_point_.x_),
+                 min(a.min_point_.y_, b.min_point_.y_),
+                 min(a.min_point_.z_, b.min_point_.z_)),
+        vector3F(max(a.max_point_.x_, b.max_point_.x_),
+                 max(a.max_point_.y_, b.max_point_.y_),
+                 max(a.max_point_.z_, b.max_point_.z_)));
+}
+
+inline float surface_area(const v8::math::aabb3F& box) {
+    const float dx = box.max_point_.x_ - box.min_point_.x_;
+    const float dy = box.max_point_.y_ - box.min_point_.y_;
+    const float dz = box.max_point_.z_ - box.min_point_.z_;
+    return 2.0f * (dx * dy + dy * dz + dz * dx);
+}
+
+inline bool contains(
+    const v8::math::aabb3F& outer, const v8::math::aabb3F& inner
+    ) {
+    return outer.min_point_.x_ <= inner.min_point_.x_
+           && outer.min_point_.y_ <= inner.min_point_.y_
+           && outer.min_point_.z_ <= inner.min_point_.z_
+           && outer.max_point_.x_ >= inner.max_point_.x_
+           && outer.max_point_.y_ >= inner.max_point_.y_
+           && outer.max_point_.z_ >= inner.max_point_.z_;
+}
+
+inline v8::math::aabb3F enlarge(const v8::math::aabb3F& box, float margin) {
+    using namespace v8::math;
+    const vector3F delta(margin, margin, margin);
+    return aabb3F(box.min_point_ - delta, box.max_point_ + delta);
+}
+
+/**
+ * \brief Number of bins used when evaluating the surface area heuristic.
+ */
+const v8_size_t C_Sah_Bin_Count = 16;
+
+} // anonymous namespace
+
+/**
+ * \brief A leaf, with a copy of its box and centroid, so that the build 
+ *        works on contiguous data.
+ */
+struct v8::math::aabb_tree::build_item_t {
+    aabb3F      bi_bound;
+    vector3F    bi_centroid;
+    v8_int32_t  bi_leaf;
+
+    //
+    // Keeps std::partition from picking between std::swap and math::swap.
+    friend void swap(build_item_t& lhs, build_item_t& rhs) {
+        const build_item_t tmp(lhs);
+        lhs = rhs;
+        rhs = tmp;
+    }
+};
+
+v8::math::aabb_tree::aabb_tree()
+    :       root_(C_Null_Node)
+        ,   free_list_(C_Null_Node)
+        ,   proxy_count_(0)
+        ,   fat_margin_(0.1f)
+{}
+
+void v8::math::aabb_tree::clear() {
+    nodes_.clear();
+    root_ = C_Null_Node;
+    free_list_ = C_Null_Node;
+    proxy_count_ = 0;
+}
+
+v8_int32_t v8::math::aabb_tree::allocate_node() {
+    v8_int32_t node_id;
+
+    if (free_list_ != C_Null_Node) {
+        node_id = free_list_;
+        free_list_ = nodes_[node_id].nd_parent;
+    } else {
+        node_id = static_cast<v8_int32_t>(nodes_.size());
+        nodes_.push_back(node_t());
+    }
+
+    node_t& node = nodes_[node_id];
+    node.nd_user_data = nullptr;
+    node.nd_parent = C_Null_Node;
+    node.nd_child1 = C_Null_Node;
+    node.nd_child2 = C_Null_Node;
+    node.nd_height = 0;
+    return node_id;
+}
+
+void v8::math::aabb_tree::free_node(v8_int32_t node_id) {
+    assert(node_id >= 0 && static_cast<v8_size_t>(node_id) < nodes_.size());
+    nodes_[node_id].nd_parent = free_list_;
+    nodes_[node_id].nd_height = -1;
+    free_list_ = node_id;
+}
+
+v8_int32_t v8::math::aabb_tree::insert_proxy(
+    const aabb3F&   box,
+    void*           user_data
+    ) {
+    const v8_int32_t proxy_id = allocate_node();
+    nodes_[proxy_id].nd_bound = enlarge(box, fat_margin_);
+    nodes_[proxy_id].nd_user_data = user_data;
+
+    insert_leaf(proxy_id);
+    ++proxy_count_;
+    return proxy_id;
+}
+
+void v8::math::aabb_tree::remove_proxy(v8_int32_t proxy_id) {
+    assert(is_valid_proxy(proxy_id));
+    remove_leaf(proxy_id);
+    free_node(proxy_id);
+    --proxy_count_;
+}
+
+bool v8::math::aabb_tree::move_proxy(v8_int32_t proxy_id, const aabb3F& box) {
+    assert(is_valid_proxy(proxy_id));
+
+    if (contains(nodes_[proxy_id].nd_bound, box))
+        return false;
+
+    remove_leaf(proxy_id);
+    nodes_[proxy_id].nd_bound = enlarge(box, fat_margin_);
+    insert_leaf(proxy_id);
+    return true;
+}
+
+void v8::math::aabb_tree::insert_leaf(v8_int32_t leaf) {
+    if (root_ == C_Null_Node) {
+        root_ = leaf;
+        nodes_[leaf].nd_parent = C_Null_Node;
+        return;
+    }
+
+    //
+    // Descend towards the sibling that minimizes the surface area cost. 
+    // Every node on the path grows by the leaf's box, so that growth is 
+    // charged to both children (inheritance cost).
+    const aabb3F leaf_box = nodes_[leaf].nd_bound;
+    v8_int32_t index = root_;
+
+    while (!nodes_[index].is_leaf()) {
+        const node_t& node = nodes_[index];
+        const v8_int32_t child1 = node.nd_child1;
+        const v8_int32_t child2 = node.nd_child2;
+
+        const float area = surface_area(node.nd_bound);
+        const float combined_area = surface_area(combine(node.nd_bound, 
+                                                         leaf_box));
+
+        //
+        // Cost of making a new parent for this node and the new leaf.
+        const float cost = 2.0f * combined_area;
+        const float inheritance_cost = 2.0f * (combined_area - area);
+
+        float child_cost[2];
+        const v8_int32_t children[2] = { child1, child2 };
+        for (int i = 0; i < 2; ++i) {
+            const node_t& child = nodes_[children[i]];
+            const float enlarged = surface_area(combine(leaf_box, 
+                                                        child.nd_bound));
+            child_cost[i] = inheritance_cost 
+                + (child.is_leaf() 
+                   ? enlarged : enlarged - surface_area(child.nd_bound));
+        }
+
+        if (cost < child_cost[0] && cost < child_cost[1])
+            break;
+
+        index = child_cost[0] < child_cost[1] ? child1 : child2;
+    }
+
+    const v8_int32_t sibling = index;
+    const v8_int32_t old_parent = nodes_[sibling].nd_parent;
+    const v8_int32_t new_parent = allocate_node();
+
+    node_t& parent_node = nodes_[new_parent];
+    parent_node.nd_parent = old_parent;
+    parent_node.nd_bound = combine(leaf_box, nodes_[sibling].nd_bound);
+    parent_node.nd_height = nodes_[sibling].nd_height + 1;
+    parent_node.nd_child1 = sibling;
+    parent_node.nd_child2 = leaf;
+
+    if (old_parent != C_Null_Node) {
+        if (nodes_[old_parent].nd_child1 == sibling)
+            nodes_[old_parent].nd_child1 = new_parent;
+        else
+            nodes_[old_parent].nd_child2 = new_parent;
+    } else {
+        root_ = new_parent;
+    }
+
+    nodes_[sibling].nd_parent = new_parent;
+    nodes_[leaf].nd_parent = new_parent;
+
+    refit_ancestors(new_parent);
+}
+
+void v8::math::aabb_tree::remove_leaf(v8_int32_t leaf) {
+    if (leaf == root_) {
+        root_ = C_Null_Node;
+        return;
+    }
+
+    //
+    // The parent is destroyed and the sibling takes its place.
+    const v8_int32_t parent = nodes_[leaf].nd_parent;
+    const v8_int32_t grand_parent = nodes_[parent].nd_parent;
+    const v8_int32_t sibling = nodes_[parent].nd_child1 == leaf 
+        ? nodes_[parent].nd_child2 : nodes_[parent].nd_child1;
+
+    free_node(parent);
+
+    if (grand_parent == C_Null_Node) {
+        root_ = sibling;
+        nodes_[sibling].nd_parent = C_Null_Node;
+        return;
+    }
+
+    if (nodes_[grand_parent].nd_child1 == parent)
+        nodes_[grand_parent].nd_child1 = sibling;
+    else
+        nodes_[grand_parent].nd_child2 = sibling;
+
+    nodes_[sibling].nd_parent = grand_parent;
+    refit_ancestors(grand_parent);
+}
+
+void v8::math::aabb_tree::refit_ancestors(v8_int32_t node_id) {
+    while (node_id != C_Null_Node) {
+        node_id = balance(node_id);
+
+        node_t& node = nodes_[node_id];
+        const node_t& child1 = nodes_[node.nd_child1];
+        const node_t& child2 = nodes_[node.nd_child2];
+
+        node.nd_height = 1 + max(child1.nd_height, child2.nd_height);
+        node.nd_bound = combine(child1.nd_bound, child2.nd_bound);
+
+        node_id = node.nd_parent;
+    }
+}
+
+v8_int32_t v8::math::aabb_tree::balance(v8_int32_t a_id) {
+    //
+    // If the heights of the subtrees of A differ by more than one, the 
+    // taller child (C) is rotated up and takes A's place. A adopts the
+    // shorter child of C, C keeps the taller one.
+    //
+    /*
+            A                 C
+           / \               / \
+          B   C     =>      A   F
+             / \           / \
+            F   G         B   G
+    */
+    node_t& a = nodes_[a_id];
+    if (a.is_leaf() || a.nd_height < 2)
+        return a_id;
+
+    const v8_int32_t b_id = a.nd_child1;
+    const v8_int32_t c_id = a.nd_child2;
+    const v8_int32_t height_diff = nodes_[c_id].nd_height 
+                                   - nodes_[b_id].nd_height;
+
+    if (height_diff > 1 || height_diff < -1) {
+        //
+        // Rotate the taller child up. up_id is the child that moves up, 
+        // down_id is the one that stays under A.
+        const bool rotate_c = height_diff > 1;
+        const v8_int32_t up_id = rotate_c ? c_id : b_id;
+        const v8_int32_t down_id = rotate_c ? b_id : c_id;
+
+        node_t& up = nodes_[up_id];
+        const v8_int32_t f_id = up.nd_child1;
+        const v8_int32_t g_id = up.nd_child2;
+
+        up.nd_child1 = a_id;
+        up.nd_parent = a.nd_parent;
+        a.nd_parent = up_id;
+
+        if (up.nd_parent != C_Null_Node) {
+            if (nodes_[up.nd_parent].nd_child1 == a_id)
+                nodes_[up.nd_parent].nd_child1 = up_id;
+            else
+                nodes_[up.nd_parent].nd_child2 = up_id;
+        } else {
+            root_ = up_id;
+        }
+
+        //
+        // The taller grandchild stays under the rotated node.
+        const bool keep_f = nodes_[f_id].nd_height > nodes_[g_id].nd_height;
+        const v8_int32_t kept_id = keep_f ? f_id : g_id;
+        const v8_int32_t moved_id = keep_f ? g_id : f_id;
+
+        up.nd_child2 = kept_id;
+        if (rotate_c) {
+            a.nd_child2 = moved_id;
+        } else {
+            a.nd_child1 = moved_id;
+        }
+        nodes_[moved_id].nd_parent = a_id;
+
+        const node_t& down = nodes_[down_id];
+        const node_t& moved = nodes_[moved_id];
+        a.nd_bound = combine(down.nd_bound, moved.nd_bound);
+        a.nd_height = 1 + max(down.nd_height, moved.nd_height);
+
+        const node_t& kept = nodes_[kept_id];
+        up.nd_bound = combine(a.nd_bound, kept.nd_bound);
+        up.nd_height = 1 + max(a.nd_height, kept.nd_height);
+
+        return up_id;
+    }
+
+    return a_id;
+}
+
+void v8::math::aabb_tree::build(
+    const aabb3F*   boxes,
+    void* const*    user_data,
+    v8_size_t       count,
+    v8_int32_t*     proxy_ids
+    ) {
+    clear();
+    if (!count)
+        return;
+
+    nodes_.reserve(2 * count - 1);
+    std::vector<build_item_t> items(count);
+
+    for (v8_size_t i = 0; i < count; ++i) {
+        const v8_int32_t leaf = allocate_node();
+        nodes_[leaf].nd_bound = boxes[i];
+        nodes_[leaf].nd_user_data = user_data ? user_data[i] : nullptr;
+
+        items[i].bi_bound = boxes[i];
+        items[i].bi_centroid = (boxes[i].min_point_ + boxes[i].max_point_) 
+                               * 0.5f;
+        items[i].bi_leaf = leaf;
+        proxy_ids[i] = leaf;
+    }
+
+    root_ = build_subtree(&items[0], count);
+    nodes_[root_].nd_parent = C_Null_Node;
+    proxy_count_ = count;
+}
+
+v8_int32_t v8::math::aabb_tree::build_subtree(
+    build_item_t*   items,
+    v8_size_t       count
+    ) {
+    if (count == 1)
+        return items[0].bi_leaf;
+
+    aabb3F centroid_bounds(items[0].bi_centroid, items[0].bi_centroid);
+    for (v8_size_t i = 1; i < count; ++i) {
+        for (int axis = 0; axis < 3; ++axis) {
+            const float c = items[i].bi_centroid.elements_[axis];
+            centroid_bounds.min_point_.elements_[axis] = 
+                min(centroid_bounds.min_point_.elements_[axis], c);
+            centroid_bounds.max_point_.elements_[axis] = 
+                max(centroid_bounds.max_point_.elements_[axis], c);
+        }
+    }
+
+    //
+    // Binned surface area heuristic : the centroids are distributed into
+    // bins along each axis and every plane between two bins is evaluated.
+    // The cost of a split is area(left) * count(left) + 
+    // area(right) * count(right).
+    int best_axis = -1;
+    v8_size_t best_split = 0;
+    float best_cost = 0.0f;
+
+    for (int axis = 0; axis < 3; ++axis) {
+        const float axis_min = centroid_bounds.min_point_.elements_[axis];
+        const float extent = centroid_bounds.max_point_.elements_[axis] 
+                             - axis_min;
+        if (extent <= 0.0f)
+            continue;
+
+        const float bin_scale = static_cast<float>(C_Sah_Bin_Count) / extent;
+        aabb3F bin_bounds[C_Sah_Bin_Count];
+        v8_size_t bin_counts[C_Sah_Bin_Count] = { 0 };
+
+        for (v8_size_t i = 0; i < count; ++i) {
+            const v8_size_t bin = min(
+                static_cast<v8_size_t>(
+                    (items[i].bi_centroid.elements_[axis] - axis_min) 
+                    * bin_scale),
+                C_Sah_Bin_Count - 1);
+            bin_bounds[bin] = bin_counts[bin] 
+                ? combine(bin_bounds[bin], items[i].bi_bound) 
+                : items[i].bi_bound;
+            ++bin_counts[bin];
+        }
+
+        //
+        // Sweep from the right to get the cost of each right partition, 
+        // then from the left, evaluating every split.
+        float right_cost[C_Sah_Bin_Count];
+        aabb3F accum;
+        v8_size_t accum_count = 0;
+        for (v8_size_t bin = C_Sah_Bin_Count - 1; bin > 0; --bin) {
+            if (bin_counts[bin]) {
+                accum = accum_count 
+                    ? combine(accum, bin_bounds[bin]) : bin_bounds[bin];
+                accum_count += bin_counts[bin];
+            }
+            right_cost[bin] = accum_count 
+                ? surface_area(accum) * static_cast<float>(accum_count) 
+                : 0.0f;
+        }
+
+        accum_count = 0;
+        for (v8_size_t split = 1; split < C_Sah_Bin_Count; ++split) {
+            const v8_size_t bin = split - 1;
+            if (bin_counts[bin]) {
+                accum = accum_count 
+                    ? combine(accum, bin_bounds[bin]) : bin_bounds[bin];
+                accum_count += bin_counts[bin];
+            }
+
+            if (!accum_count || accum_count == count)
+                continue;
+
+            const float cost = surface_area(accum) 
+                               * static_cast<float>(accum_count) 
+                               + right_cost[split];
+            if (best_axis == -1 || cost < best_cost) {
+                best_axis = axis;
+                best_split = split;
+                best_cost = cost;
+            }
+        }
+    }
+
+    v8_size_t left_count = count / 2;
+
+    if (best_axis != -1) {
+        const float axis_min = centroid_bounds.min_point_.elements_[best_axis];
+        const float bin_scale = static_cast<float>(C_Sah_Bin_Count) 
+            / (centroid_bounds.max_point_.elements_[best_axis] - axis_min);
+
+        build_item_t* middle = std::partition(
+            items, items + count, [=](const build_item_t& item) {
+                const v8_size_t bin = min(
+                    static_cast<v8_size_t>(
+                        (item.bi_centroid.elements_[best_axis] - axis_min) 
+                        * bin_scale),
+                    C_Sah_Bin_Count - 1);
+                return bin < best_split;
+        });
+
+        left_count = static_cast<v8_size_t>(middle - items);
+    }
+
+    //
+    // All the centroids are in the same spot, so any split is as good as
+    // another one.
+    if (!left_count || left_count == count)
+        left_count = count / 2;
+
+    const v8_int32_t child1 = build_subtree(items, left_count);
+    const v8_int32_t child2 = build_subtree(items + left_count, 
+                                            count - left_count);
+
+    const v8_int32_t node_id = allocate_node();
+    node_t& node = nodes_[node_id];
+    node.nd_child1 = child1;
+    node.nd_child2 = child2;
+    node.nd_bound = combine(nodes_[child1].nd_bound, nodes_[child2].nd_bound);
+    node.nd_height = 1 + max(nodes_[child1].nd_height, 
+                             nodes_[child2].nd_height);
+
+    nodes_[child1].nd_parent = node_id;
+    nodes_[child2].nd_parent = node_id;
+    return node_id;
+}
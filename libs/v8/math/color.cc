@@ -171,6 +171,13 @@ void v8::math::rgb_to_hsv(const rgb_color *rgb, color_hsv *hsv) {
 
     const float delta = max - min;
 
+    //
+    // Achromatic case.
+    if (delta == 0.0f) {
+        hsv->Hue = std::numeric_limits<float>::max();
+        return;
+    }
+
     if (rgb->Red == max) {
         hsv->Hue = (rgb->Green - rgb->Blue) / delta;
     } else if (rgb->Green == max) {
@@ -290,12 +297,12 @@ float compute_color_value(float n1, float n2, float hue) {
     if (hue < 0.0f)
         hue += 360.0f;
 
-    if (hue > 60.0f) {
+    if (hue < 60.0f) {
         return n1 + (n2 - n1) * hue / 60.0f;
     } else if (hue < 180.0f) {
         return n2;
     } else if (hue < 240.0f){
-        return n1 + (n2 - 1.0f) * (240.0f - hue) / 60.0f;
+        return n1 + (n2 - n1) * (240.0f - hue) / 60.0f;
     } else {
         return n1;
     }
@@ -307,16 +314,16 @@ void v8::math::hls_to_rgb(
     const color_hls&    hls,
     rgb_color*          rgb) 
 {
-    float m1 = 0.0f;
     float m2 = 0.0f;
 
     if (operands_le(hls.Lightness, 0.5f)) {
         m2 = hls.Lightness * (1.0f + hls.Saturation);
     } else {
         m2 = hls.Lightness + hls.Saturation - hls.Lightness * hls.Saturation;
-        m1 = 2.0f * hls.Lightness - m2;
     }
 
+    const float m1 = 2.0f * hls.Lightness - m2;
+
     if (is_zero(hls.Saturation)) {
         rgb->Red = rgb->Green = rgb->Blue = hls.Lightness;
         return;
@@ -0,0 +1,729 @@
+#include "pch_hdr.hpp"
+
+#include <v8/base/job_system.hpp>
+#include <v8/math/math_constants.hpp>
+#include <v8/math/simd/float4.hpp>
+#include <v8/math/simd/float4_math.hpp>
+#include <v8/math/color_batch.hpp>
+
+namespace {
+
+using v8::math::simd::float4_t;
+
+//
+// Steps of a conversion. The color spaces form a chain
+// (Hsv | Hls) <-> Rgb <-> Linear_Rgb <-> Xyz <-> Lab and a conversion walks
+// it, so that no step is undone by a later one (the rgb <-> xyz matrices
+// are not exact inverses of each other).
+enum conversion_step {
+    step_hsv_to_rgb,
+    step_hls_to_rgb,
+    step_rgb_to_hsv,
+    step_rgb_to_hls,
+    step_srgb_decode,
+    step_srgb_encode,
+    step_linear_to_xyz,
+    step_xyz_to_linear,
+    step_xyz_to_lab,
+    step_lab_to_xyz
+};
+
+const int k_max_steps = 6;
+
+struct conversion_plan_t {
+    conversion_step     cp_steps[k_max_steps];
+    int                 cp_count;
+
+    void append(conversion_step step) {
+        cp_steps[cp_count++] = step;
+    }
+};
+
+int chain_rank(v8::math::Color_Space space) {
+    using namespace v8::math;
+
+    switch (space) {
+    case Color_Space_Linear_Rgb :
+        return 1;
+
+    case Color_Space_Xyz :
+        return 2;
+
+    case Color_Space_Lab :
+        return 3;
+
+    default :
+        return 0;
+    }
+}
+
+conversion_plan_t make_plan(
+    v8::math::Color_Space src_space, v8::math::Color_Space dst_space
+    ) {
+    using namespace v8::math;
+
+    conversion_plan_t plan;
+    plan.cp_count = 0;
+
+    if (src_space == dst_space)
+        return plan;
+
+    if (src_space == Color_Space_Hsv)
+        plan.append(step_hsv_to_rgb);
+    else if (src_space == Color_Space_Hls)
+        plan.append(step_hls_to_rgb);
+
+    const conversion_step steps_up[] = {
+        step_srgb_decode, step_linear_to_xyz, step_xyz_to_lab
+    };
+    const conversion_step steps_down[] = {
+        step_srgb_encode, step_xyz_to_linear, step_lab_to_xyz
+    };
+
+    int rank = chain_rank(src_space);
+    const int dst_rank = chain_rank(dst_space);
+
+    for (; rank < dst_rank; ++rank)
+        plan.append(steps_up[rank]);
+
+    for (; rank > dst_rank; --rank)
+        plan.append(steps_down[rank - 1]);
+
+    if (dst_space == Color_Space_Hsv)
+        plan.append(step_rgb_to_hsv);
+    else if (dst_space == Color_Space_Hls)
+        plan.append(step_rgb_to_hls);
+
+    return plan;
+}
+
+//
+// The three components of four colors.
+struct color_block_t {
+    float4_t    cb_c[3];
+};
+
+inline float4_t srgb_decode(float4_t val) {
+    using namespace v8::math::simd;
+
+    const float4_t threshold = splat_float4(0.04045f);
+    const float4_t linear = mul(val, splat_float4(1.0f / 12.92f));
+    const float4_t t = mul(add(maximum(val, threshold), splat_float4(0.055f)),
+                           splat_float4(1.0f / 1.055f));
+
+    return select(cmp_le(val, threshold), linear, pow_approx(t, 2.4f));
+}
+
+//
+// Linear values are clamped to [0, 1] first, as by xyz_to_rgb().
+inline float4_t srgb_encode(float4_t val) {
+    using namespace v8::math::simd;
+
+    const float4_t threshold = splat_float4(0.0031308f);
+    val = minimum(maximum(val, zero_float4()), splat_float4(1.0f));
+
+    const float4_t linear = mul(val, splat_float4(12.92f));
+    const float4_t curve = sub(
+        mul(splat_float4(1.055f),
+            pow_approx(maximum(val, threshold), 1.0f / 2.4f)),
+        splat_float4(0.055f));
+
+    return select(cmp_le(val, threshold), linear, curve);
+}
+
+//
+// Hue, in degrees, of colors with the given max component and a non zero
+// delta = max - min (rgb_to_hsv()/rgb_to_hls()).
+inline float4_t hue_of(
+    const color_block_t& rgb, float4_t max, float4_t delta
+    ) {
+    using namespace v8::math::simd;
+
+    const float4_t r = rgb.cb_c[0];
+    const float4_t g = rgb.cb_c[1];
+    const float4_t b = rgb.cb_c[2];
+
+    const float4_t hue_r = div(sub(g, b), delta);
+    const float4_t hue_g = add(splat_float4(2.0f), div(sub(b, r), delta));
+    const float4_t hue_b = add(splat_float4(4.0f), div(sub(r, g), delta));
+
+    float4_t hue = select(cmp_le(max, r), hue_r,
+                          select(cmp_le(max, g), hue_g, hue_b));
+    hue = mul(hue, splat_float4(60.0f));
+
+    return add(hue, bit_and(cmp_lt(hue, zero_float4()), splat_float4(360.0f)));
+}
+
+void rgb_to_hsv_block(color_block_t* colors) {
+    using namespace v8::math::simd;
+
+    const float4_t r = colors->cb_c[0];
+    const float4_t g = colors->cb_c[1];
+    const float4_t b = colors->cb_c[2];
+
+    const float4_t max = maximum(maximum(r, g), b);
+    const float4_t min = minimum(minimum(r, g), b);
+    const float4_t delta = sub(max, min);
+
+    const float4_t one = splat_float4(1.0f);
+    const float4_t chromatic = cmp_gt(delta, zero_float4());
+    const float4_t safe_delta = select(chromatic, delta, one);
+    const float4_t safe_max = select(cmp_gt(max, zero_float4()), max, one);
+
+    colors->cb_c[0] = select(chromatic, hue_of(*colors, max, safe_delta),
+                             splat_float4(std::numeric_limits<float>::max()));
+    colors->cb_c[1] = div(delta, safe_max);
+    colors->cb_c[2] = max;
+}
+
+void hsv_to_rgb_block(color_block_t* colors) {
+    using namespace v8::math::simd;
+
+    const float4_t h = colors->cb_c[0];
+    const float4_t s = colors->cb_c[1];
+    const float4_t v = colors->cb_c[2];
+    const float4_t one = splat_float4(1.0f);
+
+    //
+    // Hue in [0, 6). Hues outside [0, 360) (including 360 and the undefined
+    // hue) are taken as 0.
+    float4_t hue = mul(h, splat_float4(1.0f / 60.0f));
+    hue = bit_and(bit_and(cmp_le(zero_float4(), hue),
+                          cmp_lt(hue, splat_float4(6.0f))), hue);
+
+    const float4_t sector = convert_int_to_float(convert_float_to_int(hue));
+    const float4_t frac = sub(hue, sector);
+
+    const float4_t p = mul(v, sub(one, s));
+    const float4_t q = mul(v, sub(one, mul(s, frac)));
+    const float4_t t = mul(v, sub(one, mul(s, sub(one, frac))));
+
+    const float4_t below1 = cmp_lt(sector, splat_float4(0.5f));
+    const float4_t below2 = cmp_lt(sector, splat_float4(1.5f));
+    const float4_t below3 = cmp_lt(sector, splat_float4(2.5f));
+    const float4_t below4 = cmp_lt(sector, splat_float4(3.5f));
+    const float4_t below5 = cmp_lt(sector, splat_float4(4.5f));
+
+    const float4_t r = select(below1, v, select(below2, q,
+        select(below4, p, select(below5, t, v))));
+    const float4_t g = select(below1, t, select(below3, v,
+        select(below4, q, p)));
+    const float4_t b = select(below2, p, select(below3, t,
+        select(below5, v, q)));
+
+    const float4_t eps = splat_float4(v8::math::numerics<float>::epsilon());
+    const float4_t gray = cmp_lt(maximum(s, negate(s)), eps);
+
+    colors->cb_c[0] = select(gray, v, r);
+    colors->cb_c[1] = select(gray, v, g);
+    colors->cb_c[2] = select(gray, v, b);
+}
+
+void rgb_to_hls_block(color_block_t* colors) {
+    using namespace v8::math::simd;
+
+    const float4_t r = colors->cb_c[0];
+    const float4_t g = colors->cb_c[1];
+    const float4_t b = colors->cb_c[2];
+
+    const float4_t max = maximum(maximum(r, g), b);
+    const float4_t min = minimum(minimum(r, g), b);
+    const float4_t delta = sub(max, min);
+    const float4_t sum = add(max, min);
+    const float4_t lightness = mul(sum, splat_float4(0.5f));
+
+    const float4_t one = splat_float4(1.0f);
+    const float4_t eps = splat_float4(v8::math::numerics<float>::epsilon());
+    const float4_t chromatic = cmp_le(eps, delta);
+    const float4_t safe_delta = select(chromatic, delta, one);
+
+    const float4_t denominator = select(
+        cmp_lt(lightness, splat_float4(0.5f)), sum,
+        sub(sub(splat_float4(2.0f), max), min));
+    const float4_t saturation = div(delta, select(chromatic, denominator, one));
+
+    colors->cb_c[0] = select(chromatic, hue_of(*colors, max, safe_delta),
+                             splat_float4(std::numeric_limits<float>::max()));
+    colors->cb_c[1] = lightness;
+    colors->cb_c[2] = bit_and(chromatic, saturation);
+}
+
+//
+// Component of hls_to_rgb() for the given hue.
+inline float4_t hls_component(float4_t n1, float4_t n2, float4_t hue) {
+    using namespace v8::math::simd;
+
+    const float4_t full_turn = splat_float4(360.0f);
+    hue = sub(hue, bit_and(cmp_gt(hue, full_turn), full_turn));
+    hue = add(hue, bit_and(cmp_lt(hue, zero_float4()), full_turn));
+
+    const float4_t slope = mul(sub(n2, n1), splat_float4(1.0f / 60.0f));
+    const float4_t rising = add(n1, mul(slope, hue));
+    const float4_t falling = add(n1, mul(slope, sub(splat_float4(240.0f), hue)));
+
+    return select(cmp_lt(hue, splat_float4(60.0f)), rising,
+        select(cmp_lt(hue, splat_float4(180.0f)), n2,
+            select(cmp_lt(hue, splat_float4(240.0f)), falling, n1)));
+}
+
+void hls_to_rgb_block(color_block_t* colors) {
+    using namespace v8::math::simd;
+
+    const float4_t h = colors->cb_c[0];
+    const float4_t l = colors->cb_c[1];
+    const float4_t s = colors->cb_c[2];
+    const float4_t eps = splat_float4(v8::math::numerics<float>::epsilon());
+
+    const float4_t half = splat_float4(0.5f);
+    const float4_t low = bit_or(
+        cmp_lt(l, half), cmp_lt(maximum(sub(l, half), sub(half, l)), eps));
+    const float4_t m2 = select(low, mul(l, add(splat_float4(1.0f), s)),
+                               sub(add(l, s), mul(l, s)));
+    const float4_t m1 = sub(add(l, l), m2);
+
+    const float4_t third = splat_float4(120.0f);
+    const float4_t gray = cmp_lt(maximum(s, negate(s)), eps);
+
+    colors->cb_c[0] = select(gray, l, hls_component(m1, m2, add(h, third)));
+    colors->cb_c[1] = select(gray, l, hls_component(m1, m2, h));
+    colors->cb_c[2] = select(gray, l, hls_component(m1, m2, sub(h, third)));
+}
+
+//
+// out = m * in, m is a row major 3x3 matrix.
+inline void transform_block(const float* m, color_block_t* colors) {
+    using namespace v8::math::simd;
+
+    const float4_t x = colors->cb_c[0];
+    const float4_t y = colors->cb_c[1];
+    const float4_t z = colors->cb_c[2];
+
+    for (int row = 0; row < 3; ++row) {
+        colors->cb_c[row] = add(add(
+            mul(splat_float4(m[row * 3 + 0]), x),
+            mul(splat_float4(m[row * 3 + 1]), y)),
+            mul(splat_float4(m[row * 3 + 2]), z));
+    }
+}
+
+const float k_linear_to_xyz[9] = {
+    0.4124f, 0.3576f, 0.1805f,
+    0.2126f, 0.7152f, 0.0722f,
+    0.0193f, 0.1192f, 0.9505f
+};
+
+const float k_xyz_to_linear[9] = {
+     3.2406f, -1.5372f, -0.4986f,
+    -0.9689f,  1.8758f,  0.0415f,
+     0.0557f, -0.2040f,  1.0570f
+};
+
+//
+// D50 reference white, as used by xyz_to_lab()/lab_to_xyz().
+const float k_white[3] = { 0.96421f, 1.0f, 0.82519f };
+
+inline float4_t lab_f(float4_t t) {
+    using namespace v8::math::simd;
+
+    //
+    // (6 / 29) ^ 3
+    const float4_t threshold = splat_float4(0.008856451679035631f);
+    const float4_t linear = add(mul(t, splat_float4(7.787037037037035f)),
+                                splat_float4(0.13793103448275862f));
+
+    return select(cmp_gt(t, threshold),
+                  pow_approx(maximum(t, threshold), 1.0f / 3.0f), linear);
+}
+
+inline float4_t lab_f_inverse(float4_t t) {
+    using namespace v8::math::simd;
+
+    const float4_t cube = mul(mul(t, t), t);
+    const float4_t linear = mul(splat_float4(0.12841854934601665f),
+                                sub(t, splat_float4(0.13793103448275862f)));
+
+    //
+    // 6 / 29
+    return select(cmp_gt(t, splat_float4(0.20689655172413793f)), cube, linear);
+}
+
+void xyz_to_lab_block(color_block_t* colors) {
+    using namespace v8::math::simd;
+
+    const float4_t fx = lab_f(mul(colors->cb_c[0], splat_float4(1.0f / k_white[0])));
+    const float4_t fy = lab_f(colors->cb_c[1]);
+    const float4_t fz = lab_f(mul(colors->cb_c[2], splat_float4(1.0f / k_white[2])));
+
+    colors->cb_c[0] = sub(mul(splat_float4(1.16f), fy), splat_float4(0.16f));
+    colors->cb_c[1] = mul(splat_float4(5.0f), sub(fx, fy));
+    colors->cb_c[2] = mul(splat_float4(2.0f), sub(fy, fz));
+}
+
+void lab_to_xyz_block(color_block_t* colors) {
+    using namespace v8::math::simd;
+
+    const float4_t fy = div(add(colors->cb_c[0], splat_float4(0.16f)),
+                            splat_float4(1.16f));
+    const float4_t fx = add(fy, mul(splat_float4(0.2f), colors->cb_c[1]));
+    const float4_t fz = sub(fy, mul(splat_float4(0.5f), colors->cb_c[2]));
+
+    colors->cb_c[0] = mul(splat_float4(k_white[0]), lab_f_inverse(fx));
+    colors->cb_c[1] = mul(splat_float4(k_white[1]), lab_f_inverse(fy));
+    colors->cb_c[2] = mul(splat_float4(k_white[2]), lab_f_inverse(fz));
+}
+
+void convert_block(const conversion_plan_t& plan, color_block_t* colors) {
+    for (int i = 0; i < plan.cp_count; ++i) {
+        switch (plan.cp_steps[i]) {
+        case step_hsv_to_rgb :
+            hsv_to_rgb_block(colors);
+            break;
+
+        case step_hls_to_rgb :
+            hls_to_rgb_block(colors);
+            break;
+
+        case step_rgb_to_hsv :
+            rgb_to_hsv_block(colors);
+            break;
+
+        case step_rgb_to_hls :
+            rgb_to_hls_block(colors);
+            break;
+
+        case step_srgb_decode :
+            for (int c = 0; c < 3; ++c)
+                colors->cb_c[c] = srgb_decode(colors->cb_c[c]);
+            break;
+
+        case step_srgb_encode :
+            for (int c = 0; c < 3; ++c)
+                colors->cb_c[c] = srgb_encode(colors->cb_c[c]);
+            break;
+
+        case step_linear_to_xyz :
+            transform_block(k_linear_to_xyz, colors);
+            break;
+
+        case step_xyz_to_linear :
+            transform_block(k_xyz_to_linear, colors);
+            break;
+
+        case step_xyz_to_lab :
+            xyz_to_lab_block(colors);
+            break;
+
+        case step_lab_to_xyz :
+            lab_to_xyz_block(colors);
+            break;
+
+        default :
+            break;
+        }
+    }
+}
+
+//
+// 8 bit value -> float, either divided by 255 or sRGB decoded. Built once.
+struct rgba8_tables_t {
+    float   rt_unorm[256];
+    float   rt_linear[256];
+
+    rgba8_tables_t() {
+        for (int i = 0; i < 256; ++i) {
+            const double val = i / 255.0;
+            rt_unorm[i] = static_cast<float>(val);
+            rt_linear[i] = static_cast<float>(val <= 0.04045
+                ? val / 12.92 : std::pow((val + 0.055) / 1.055, 2.4));
+        }
+    }
+};
+
+const rgba8_tables_t& rgba8_tables() {
+    static const rgba8_tables_t tables;
+    return tables;
+}
+
+//
+// Four colors of 4 floats; count (at most 4) of them are read/written, the
+// rest of the block is zero.
+inline void load_interleaved(
+    const float* src, v8_size_t count, color_block_t* colors, float4_t* alpha
+    ) {
+    using namespace v8::math::simd;
+
+    float4_t p[4];
+    if (count == 4) {
+        for (int i = 0; i < 4; ++i)
+            p[i] = load_float4(src + i * 4);
+    } else {
+        float padded[16] = { 0.0f };
+        memcpy(padded, src, count * 4 * sizeof(float));
+        for (int i = 0; i < 4; ++i)
+            p[i] = load_float4(padded + i * 4);
+    }
+
+    transpose(p[0], p[1], p[2], p[3]);
+    colors->cb_c[0] = p[0];
+    colors->cb_c[1] = p[1];
+    colors->cb_c[2] = p[2];
+    *alpha = p[3];
+}
+
+inline void store_interleaved(
+    const color_block_t& colors, float4_t alpha, v8_size_t count, float* dst
+    ) {
+    using namespace v8::math::simd;
+
+    float4_t p[4] = { colors.cb_c[0], colors.cb_c[1], colors.cb_c[2], alpha };
+    transpose(p[0], p[1], p[2], p[3]);
+
+    if (count == 4) {
+        for (int i = 0; i < 4; ++i)
+            store_float4(dst + i * 4, p[i]);
+        return;
+    }
+
+    float padded[16];
+    for (int i = 0; i < 4; ++i)
+        store_float4(padded + i * 4, p[i]);
+    memcpy(dst, padded, count * 4 * sizeof(float));
+}
+
+void convert_interleaved_range(
+    const conversion_plan_t&    plan,
+    const float*                src,
+    float*                      dst,
+    v8_size_t                   first,
+    v8_size_t                   last
+    ) {
+    for (v8_size_t i = first; i < last; i += 4) {
+        const v8_size_t count = std::min<v8_size_t>(4, last - i);
+
+        color_block_t colors;
+        float4_t alpha;
+        load_interleaved(src + i * 4, count, &colors, &alpha);
+        convert_block(plan, &colors);
+        store_interleaved(colors, alpha, count, dst + i * 4);
+    }
+}
+
+void convert_planar_range(
+    const conversion_plan_t&    plan,
+    const float* const          src[3],
+    float* const                dst[3],
+    v8_size_t                   first,
+    v8_size_t                   last
+    ) {
+    using namespace v8::math::simd;
+
+    v8_size_t i = first;
+    for (; i + 4 <= last; i += 4) {
+        color_block_t colors;
+        for (int c = 0; c < 3; ++c)
+            colors.cb_c[c] = load_float4(src[c] + i);
+
+        convert_block(plan, &colors);
+
+        for (int c = 0; c < 3; ++c)
+            store_float4(dst[c] + i, colors.cb_c[c]);
+    }
+
+    if (i == last)
+        return;
+
+    const v8_size_t count = last - i;
+    color_block_t colors;
+    for (int c = 0; c < 3; ++c) {
+        float padded[4] = { 0.0f };
+        memcpy(padded, src[c] + i, count * sizeof(float));
+        colors.cb_c[c] = load_float4(padded);
+    }
+
+    convert_block(plan, &colors);
+
+    for (int c = 0; c < 3; ++c) {
+        float padded[4];
+        store_float4(padded, colors.cb_c[c]);
+        memcpy(dst[c] + i, padded, count * sizeof(float));
+    }
+}
+
+void rgba8_row_to_colors(
+    const conversion_plan_t&    plan,
+    const float*                table,
+    const v8_uint8_t*           src,
+    float*                      dst,
+    v8_size_t                   width
+    ) {
+    using namespace v8::math::simd;
+
+    const float* unorm = rgba8_tables().rt_unorm;
+
+    for (v8_size_t x = 0; x < width; x += 4) {
+        const v8_size_t count = std::min<v8_size_t>(4, width - x);
+
+        v8_uint8_t pixels[16] = { 0 };
+        memcpy(pixels, src + x * 4, count * 4);
+
+        color_block_t colors;
+        for (int c = 0; c < 3; ++c) {
+            colors.cb_c[c] = set_float4(
+                table[pixels[c]], table[pixels[4 + c]],
+                table[pixels[8 + c]], table[pixels[12 + c]]);
+        }
+        const float4_t alpha = set_float4(
+            unorm[pixels[3]], unorm[pixels[7]], unorm[pixels[11]], unorm[pixels[15]]);
+
+        convert_block(plan, &colors);
+        store_interleaved(colors, alpha, count, dst + x * 4);
+    }
+}
+
+inline void quantize_unorm8(float4_t val, v8_uint32_t* out) {
+    using namespace v8::math::simd;
+
+    val = minimum(maximum(val, zero_float4()), splat_float4(1.0f));
+    const float4_t bits = convert_float_to_int(
+        add(mul(val, splat_float4(255.0f)), splat_float4(0.5f)));
+
+    float lanes[4];
+    store_float4(lanes, bits);
+    memcpy(out, lanes, sizeof(lanes));
+}
+
+void colors_row_to_rgba8(
+    const conversion_plan_t&    plan,
+    const float*                src,
+    v8_uint8_t*                 dst,
+    v8_size_t                   width
+    ) {
+    for (v8_size_t x = 0; x < width; x += 4) {
+        const v8_size_t count = std::min<v8_size_t>(4, width - x);
+
+        color_block_t colors;
+        float4_t alpha;
+        load_interleaved(src + x * 4, count, &colors, &alpha);
+        convert_block(plan, &colors);
+
+        v8_uint32_t channels[4][4];
+        for (int c = 0; c < 3; ++c)
+            quantize_unorm8(colors.cb_c[c], channels[c]);
+        quantize_unorm8(alpha, channels[3]);
+
+        v8_uint8_t* out = dst + x * 4;
+        for (v8_size_t i = 0; i < count; ++i) {
+            for (int c = 0; c < 4; ++c)
+                out[i * 4 + c] = static_cast<v8_uint8_t>(channels[c][i]);
+        }
+    }
+}
+
+template<typename range_function>
+void run_color_batch(
+    v8::base::job_system*   jobs,
+    v8_size_t               count,
+    v8_size_t               grain,
+    range_function          body
+    ) {
+    if (jobs && count > grain)
+        jobs->parallel_for(0, count, grain, body);
+    else
+        body(0, count);
+}
+
+} // anonymous namespace
+
+void v8::math::convert_colors(
+    Color_Space         src_space,
+    const float*        src,
+    Color_Space         dst_space,
+    float*              dst,
+    v8_size_t           count,
+    base::job_system*   jobs
+    ) {
+    const conversion_plan_t plan = make_plan(src_space, dst_space);
+
+    run_color_batch(jobs, count, C_Color_Batch_Grain,
+        [&](v8_size_t first, v8_size_t last) {
+        convert_interleaved_range(plan, src, dst, first, last);
+    });
+}
+
+void v8::math::convert_colors_planar(
+    Color_Space         src_space,
+    const float* const  src[3],
+    Color_Space         dst_space,
+    float* const        dst[3],
+    v8_size_t           count,
+    base::job_system*   jobs
+    ) {
+    const conversion_plan_t plan = make_plan(src_space, dst_space);
+
+    run_color_batch(jobs, count, C_Color_Batch_Grain,
+        [&](v8_size_t first, v8_size_t last) {
+        convert_planar_range(plan, src, dst, first, last);
+    });
+}
+
+void v8::math::convert_colors_from_rgba8(
+    const v8_uint8_t*   src,
+    v8_size_t           src_pitch,
+    Color_Space         dst_space,
+    float*              dst,
+    v8_size_t           dst_pitch,
+    v8_size_t           width,
+    v8_size_t           height,
+    base::job_system*   jobs
+    ) {
+    //
+    // The lookup table does the sRGB decoding when the destination space
+    // is computed from linear values.
+    const bool decode = dst_space == Color_Space_Linear_Rgb
+        || dst_space == Color_Space_Xyz || dst_space == Color_Space_Lab;
+    const conversion_plan_t plan = make_plan(
+        decode ? Color_Space_Linear_Rgb : Color_Space_Rgb, dst_space);
+    const float* table = decode
+        ? rgba8_tables().rt_linear : rgba8_tables().rt_unorm;
+
+    const v8_size_t row_grain =
+        std::max<v8_size_t>(1, C_Color_Batch_Grain / std::max<v8_size_t>(width, 1));
+
+    run_color_batch(jobs, height, row_grain,
+        [&](v8_size_t first, v8_size_t last) {
+        for (v8_size_t y = first; y < last; ++y) {
+            rgba8_row_to_colors(
+                plan, table, src + y * src_pitch,
+                reinterpret_cast<float*>(
+                    reinterpret_cast<v8_uint8_t*>(dst) + y * dst_pitch),
+                width);
+        }
+    });
+}
+
+void v8::math::convert_colors_to_rgba8(
+    Color_Space         src_space,
+    const float*        src,
+    v8_size_t           src_pitch,
+    v8_uint8_t*         dst,
+    v8_size_t           dst_pitch,
+    v8_size_t           width,
+    v8_size_t           height,
+    base::job_system*   jobs
+    ) {
+    const conversion_plan_t plan = make_plan(src_space, Color_Space_Rgb);
+
+    const v8_size_t row_grain =
+        std::max<v8_size_t>(1, C_Color_Batch_Grain / std::max<v8_size_t>(width, 1));
+
+    run_color_batch(jobs, height, row_grain,
+        [&](v8_size_t first, v8_size_t last) {
+        for (v8_size_t y = first; y < last; ++y) {
+            colors_row_to_rgba8(
+                plan,
+                reinterpret_cast<const float*>(
+                    reinterpret_cast<const v8_uint8_t*>(src) + y * src_pitch),
+                dst + y * dst_pitch, width);
+        }
+    });
+}
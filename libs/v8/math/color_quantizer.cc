@@ -0,0 +1,778 @@
+#include "pch_hdr.hpp"
+
+#include <utility>
+
+#include <v8/base/job_system.hpp>
+#include <v8/math/simd/float4.hpp>
+#include <v8/math/color_batch.hpp>
+#include <v8/math/color_quantizer.hpp>
+
+namespace {
+
+using v8::math::simd::float4_t;
+
+//
+// Histogram used to build the palette, 5 bits per channel.
+const v8_uint32_t k_histogram_bits = 5;
+const v8_uint32_t k_histogram_bins = 1U << (3 * k_histogram_bits);
+
+//
+// Images are split in at most one histogram per thread, each covering at
+// least k_min_histogram_pixels pixels.
+const v8_size_t k_min_histogram_pixels = 65536;
+
+//
+// Lookup table used to map pixels to the palette, 6 bits per channel.
+const v8_uint32_t k_lookup_bits = 6;
+const v8_uint32_t k_lookup_cells = 1U << (3 * k_lookup_bits);
+
+//
+// Colors per task for the nearest entry searches.
+const v8_size_t k_search_grain = 2048;
+
+//
+// Lab coordinate of the padding lanes of the centroid planes, far from
+// any color.
+const float k_padding_coordinate = 1.0e6f;
+
+struct histogram_bin_t {
+    v8_uint32_t     hb_count;
+    v8_uint64_t     hb_sums[4];
+};
+
+//
+// A non empty histogram bin : the L*a*b* coordinates of the mean color of
+// its pixels, their mean alpha and their count.
+struct color_entry_t {
+    float           ce_lab[3];
+    float           ce_alpha;
+    float           ce_weight;
+};
+
+//
+// Entries [mb_first, mb_last) during the median cut, with their weighted
+// squared error and the axis of largest variance.
+struct median_box_t {
+    v8_size_t       mb_first;
+    v8_size_t       mb_last;
+    double          mb_error;
+    v8_int_t        mb_axis;
+};
+
+//
+// L*a*b* coordinates of a set of colors in three planes, padded to a
+// multiple of 8 with colors that are never the nearest.
+struct centroid_planes_t {
+    std::vector<float>  cp_planes[3];
+
+    explicit centroid_planes_t(v8_size_t count) {
+        const v8_size_t padded = (count + 7) & ~static_cast<v8_size_t>(7);
+        for (int c = 0; c < 3; ++c)
+            cp_planes[c].assign(padded, k_padding_coordinate);
+    }
+
+    void set(v8_size_t idx, const float* lab) {
+        for (int c = 0; c < 3; ++c)
+            cp_planes[c][idx] = lab[c];
+    }
+
+    //
+    // Index of the color nearest to lab, the lowest index on ties. Two
+    // groups of 4 colors are searched at a time, to keep two independent
+    // minimum chains in flight.
+    v8_uint32_t nearest(const float* lab) const {
+        using namespace v8::math::simd;
+
+        const float4_t pl = splat_float4(lab[0]);
+        const float4_t pa = splat_float4(lab[1]);
+        const float4_t pb = splat_float4(lab[2]);
+        const float4_t step = splat_float4(8.0f);
+
+        const float* planes_l = &cp_planes[0][0];
+        const float* planes_a = &cp_planes[1][0];
+        const float* planes_b = &cp_planes[2][0];
+
+        float4_t best_dist[2];
+        float4_t best_index[2];
+        float4_t index[2];
+        for (int g = 0; g < 2; ++g) {
+            best_dist[g] = splat_float4(std::numeric_limits<float>::max());
+            best_index[g] = zero_float4();
+            index[g] = set_float4(g * 4.0f, g * 4.0f + 1.0f, g * 4.0f + 2.0f, g * 4.0f + 3.0f);
+        }
+
+        const v8_size_t padded = cp_planes[0].size();
+        for (v8_size_t i = 0; i < padded; i += 8) {
+            for (int g = 0; g < 2; ++g) {
+                const v8_size_t offset = i + g * 4;
+                const float4_t dl = sub(load_float4(planes_l + offset), pl);
+                const float4_t da = sub(load_float4(planes_a + offset), pa);
+                const float4_t db = sub(load_float4(planes_b + offset), pb);
+                const float4_t dist = add(add(mul(dl, dl), mul(da, da)), mul(db, db));
+
+                best_index[g] = select(cmp_lt(dist, best_dist[g]), index[g], best_index[g]);
+                best_dist[g] = minimum(dist, best_dist[g]);
+                index[g] = add(index[g], step);
+            }
+        }
+
+        float dists[8];
+        float indices[8];
+        for (int g = 0; g < 2; ++g) {
+            store_float4(dists + g * 4, best_dist[g]);
+            store_float4(indices + g * 4, best_index[g]);
+        }
+
+        int best = 0;
+        for (int lane = 1; lane < 8; ++lane) {
+            if (dists[lane] < dists[best]
+                || (dists[lane] == dists[best] && indices[lane] < indices[best]))
+                best = lane;
+        }
+
+        return static_cast<v8_uint32_t>(indices[best]);
+    }
+};
+
+template<typename range_function>
+void run_quantizer_batch(
+    v8::base::job_system*   jobs,
+    v8_size_t               count,
+    v8_size_t               grain,
+    range_function          body
+    ) {
+    if (jobs && count > grain)
+        jobs->parallel_for(0, count, grain, body);
+    else
+        body(0, count);
+}
+
+void histogram_rows(
+    const v8_uint8_t*   src,
+    v8_size_t           src_pitch,
+    v8_size_t           width,
+    v8_size_t           first_row,
+    v8_size_t           last_row,
+    histogram_bin_t*    bins
+    ) {
+    const v8_uint32_t shift = 8 - k_histogram_bits;
+
+    for (v8_size_t y = first_row; y < last_row; ++y) {
+        const v8_uint8_t* row = src + y * src_pitch;
+
+        for (v8_size_t x = 0; x < width; ++x) {
+            const v8_uint8_t* pixel = row + x * 4;
+            const v8_uint32_t key =
+                ((pixel[0] >> shift) << (2 * k_histogram_bits))
+                | ((pixel[1] >> shift) << k_histogram_bits)
+                | (pixel[2] >> shift);
+
+            histogram_bin_t& bin = bins[key];
+            ++bin.hb_count;
+            for (int c = 0; c < 4; ++c)
+                bin.hb_sums[c] += pixel[c];
+        }
+    }
+}
+
+void collect_entries(
+    const v8_uint8_t*           src,
+    v8_size_t                   src_pitch,
+    v8_size_t                   width,
+    v8_size_t                   height,
+    v8::base::job_system*       jobs,
+    std::vector<color_entry_t>* entries
+    ) {
+    using namespace v8::math;
+
+    v8_size_t histogram_count = 1;
+    if (jobs) {
+        histogram_count = std::min<v8_size_t>(
+            std::min<v8_size_t>(jobs->get_thread_count(), height),
+            width * height / k_min_histogram_pixels);
+        histogram_count = std::max<v8_size_t>(histogram_count, 1);
+    }
+
+    std::vector<histogram_bin_t> bins(histogram_count * k_histogram_bins);
+    const v8_size_t rows_per_histogram =
+        (height + histogram_count - 1) / histogram_count;
+
+    run_quantizer_batch(jobs, histogram_count, 1,
+        [&](v8_size_t first, v8_size_t last) {
+        for (v8_size_t h = first; h < last; ++h) {
+            histogram_rows(
+                src, src_pitch, width, h * rows_per_histogram,
+                std::min(height, (h + 1) * rows_per_histogram),
+                &bins[h * k_histogram_bins]);
+        }
+    });
+
+    for (v8_size_t h = 1; h < histogram_count; ++h) {
+        const histogram_bin_t* partial = &bins[h * k_histogram_bins];
+
+        for (v8_uint32_t i = 0; i < k_histogram_bins; ++i) {
+            bins[i].hb_count += partial[i].hb_count;
+            for (int c = 0; c < 4; ++c)
+                bins[i].hb_sums[c] += partial[i].hb_sums[c];
+        }
+    }
+
+    entries->clear();
+    for (v8_uint32_t i = 0; i < k_histogram_bins; ++i) {
+        const histogram_bin_t& bin = bins[i];
+        if (!bin.hb_count)
+            continue;
+
+        const double scale = 1.0 / (255.0 * bin.hb_count);
+        const rgb_color mean(
+            static_cast<float>(bin.hb_sums[0] * scale),
+            static_cast<float>(bin.hb_sums[1] * scale),
+            static_cast<float>(bin.hb_sums[2] * scale));
+
+        color_lab lab;
+        rgb_to_lab(&mean, &lab);
+
+        color_entry_t entry;
+        for (int c = 0; c < 3; ++c)
+            entry.ce_lab[c] = lab.Elements[c];
+        entry.ce_alpha = static_cast<float>(bin.hb_sums[3] * scale);
+        entry.ce_weight = static_cast<float>(bin.hb_count);
+        entries->push_back(entry);
+    }
+}
+
+void measure_box(const std::vector<color_entry_t>& entries, median_box_t* box) {
+    double weight = 0.0;
+    double sums[3] = { 0.0, 0.0, 0.0 };
+    double squares[3] = { 0.0, 0.0, 0.0 };
+
+    for (v8_size_t i = box->mb_first; i < box->mb_last; ++i) {
+        const color_entry_t& entry = entries[i];
+        weight += entry.ce_weight;
+
+        for (int c = 0; c < 3; ++c) {
+            sums[c] += entry.ce_weight * entry.ce_lab[c];
+            squares[c] += entry.ce_weight * entry.ce_lab[c] * entry.ce_lab[c];
+        }
+    }
+
+    box->mb_error = 0.0;
+    box->mb_axis = 0;
+
+    double widest = -1.0;
+    for (int c = 0; c < 3; ++c) {
+        const double error = std::max(squares[c] - sums[c] * sums[c] / weight, 0.0);
+        box->mb_error += error;
+
+        if (error > widest) {
+            widest = error;
+            box->mb_axis = c;
+        }
+    }
+
+    if (box->mb_last - box->mb_first < 2)
+        box->mb_error = 0.0;
+}
+
+//
+// Splits the entries in at most max_boxes boxes, returns the boxes.
+std::vector<median_box_t> median_cut(
+    std::vector<color_entry_t>* entries,
+    v8_size_t                   max_boxes
+    ) {
+    std::vector<median_box_t> boxes;
+
+    median_box_t all;
+    all.mb_first = 0;
+    all.mb_last = entries->size();
+    measure_box(*entries, &all);
+    boxes.push_back(all);
+
+    while (boxes.size() < max_boxes) {
+        v8_size_t widest = 0;
+        for (v8_size_t i = 1; i < boxes.size(); ++i) {
+            if (boxes[i].mb_error > boxes[widest].mb_error)
+                widest = i;
+        }
+
+        median_box_t box = boxes[widest];
+        if (box.mb_error <= 0.0)
+            break;
+
+        const v8_int_t axis = box.mb_axis;
+        std::sort(entries->begin() + box.mb_first, entries->begin() + box.mb_last,
+            [axis](const color_entry_t& lhs, const color_entry_t& rhs) {
+            return lhs.ce_lab[axis] < rhs.ce_lab[axis];
+        });
+
+        double total = 0.0;
+        for (v8_size_t i = box.mb_first; i < box.mb_last; ++i)
+            total += (*entries)[i].ce_weight;
+
+        //
+        // Cut after the entry that reaches half of the weight, keeping at
+        // least one entry on each side.
+        v8_size_t cut = box.mb_first + 1;
+        double below = 0.0;
+        for (v8_size_t i = box.mb_first; i < box.mb_last - 1; ++i) {
+            below += (*entries)[i].ce_weight;
+            cut = i + 1;
+            if (below * 2.0 >= total)
+                break;
+        }
+
+        median_box_t upper;
+        upper.mb_first = cut;
+        upper.mb_last = box.mb_last;
+        measure_box(*entries, &upper);
+
+        box.mb_last = cut;
+        measure_box(*entries, &box);
+
+        boxes[widest] = box;
+        boxes.push_back(upper);
+    }
+
+    return boxes;
+}
+
+//
+// Squared distance between two L*a*b* colors.
+double lab_distance_squared(const float* lhs, const float* rhs) {
+    double dist = 0.0;
+    for (int c = 0; c < 3; ++c) {
+        const double diff = static_cast<double>(lhs[c]) - rhs[c];
+        dist += diff * diff;
+    }
+    return dist;
+}
+
+//
+// Moves an entry to each empty cluster, taking the entries with the
+// largest weighted error first. sums holds the weighted Lab sums and the
+// weight of every cluster, members their entry counts; both are updated.
+// An entry with an error is not at the centroid of its cluster, so it
+// differs from every centroid (it is assigned to the nearest one); the
+// entries are also kept distinct from each other, and a cluster never
+// gives away its last entry.
+void reseed_empty_clusters(
+    const std::vector<color_entry_t>&   entries,
+    const std::vector<float>&           centroids,
+    std::vector<v8_uint32_t>*           assignment,
+    std::vector<double>*                sums,
+    std::vector<v8_size_t>*             members
+    ) {
+    const v8_size_t cluster_count = members->size();
+
+    std::vector<std::pair<double, v8_size_t> > errors;
+    for (v8_size_t i = 0; i < entries.size(); ++i) {
+        const color_entry_t& entry = entries[i];
+        const double error = entry.ce_weight * lab_distance_squared(
+            entry.ce_lab, &centroids[(*assignment)[i] * 3]);
+        if (error > 0.0)
+            errors.push_back(std::make_pair(error, i));
+    }
+
+    std::sort(errors.begin(), errors.end(),
+        [](const std::pair<double, v8_size_t>& lhs,
+           const std::pair<double, v8_size_t>& rhs) {
+        return lhs.first > rhs.first
+               || (lhs.first == rhs.first && lhs.second < rhs.second);
+    });
+
+    std::vector<v8_size_t> seeds;
+    v8_size_t candidate = 0;
+
+    for (v8_size_t k = 0; k < cluster_count; ++k) {
+        if ((*members)[k] != 0)
+            continue;
+
+        for (; candidate < errors.size(); ++candidate) {
+            const v8_size_t i = errors[candidate].second;
+            if ((*members)[(*assignment)[i]] < 2)
+                continue;
+
+            bool distinct = true;
+            for (v8_size_t s = 0; s < seeds.size() && distinct; ++s)
+                distinct = lab_distance_squared(
+                    entries[i].ce_lab, entries[seeds[s]].ce_lab) > 0.0;
+            if (distinct)
+                break;
+        }
+
+        if (candidate == errors.size())
+            return;
+
+        const v8_size_t i = errors[candidate++].second;
+        const color_entry_t& entry = entries[i];
+        double* from = &(*sums)[(*assignment)[i] * 4];
+        double* to = &(*sums)[k * 4];
+
+        for (int c = 0; c < 3; ++c) {
+            from[c] -= entry.ce_weight * entry.ce_lab[c];
+            to[c] = entry.ce_weight * entry.ce_lab[c];
+        }
+        from[3] -= entry.ce_weight;
+        to[3] = entry.ce_weight;
+
+        --(*members)[(*assignment)[i]];
+        (*members)[k] = 1;
+        (*assignment)[i] = static_cast<v8_uint32_t>(k);
+        seeds.push_back(i);
+    }
+}
+
+//
+// Weighted k-means over the entries. assignment holds the initial cluster
+// of each entry on input and the final one on output, centroids the Lab
+// coordinates of the clusters.
+void refine_clusters(
+    const std::vector<color_entry_t>&   entries,
+    v8_int32_t                          passes,
+    v8::base::job_system*               jobs,
+    std::vector<v8_uint32_t>*           assignment,
+    std::vector<float>*                 centroids
+    ) {
+    const v8_size_t cluster_count = centroids->size() / 3;
+    std::vector<v8_uint32_t> next(entries.size());
+    std::vector<double> sums(cluster_count * 4);
+    std::vector<v8_size_t> members(cluster_count);
+
+    for (v8_int32_t pass = 0; pass < passes; ++pass) {
+        centroid_planes_t planes(cluster_count);
+        for (v8_size_t k = 0; k < cluster_count; ++k)
+            planes.set(k, &(*centroids)[k * 3]);
+
+        run_quantizer_batch(jobs, entries.size(), k_search_grain,
+            [&](v8_size_t first, v8_size_t last) {
+            for (v8_size_t i = first; i < last; ++i)
+                next[i] = planes.nearest(entries[i].ce_lab);
+        });
+
+        if (next == *assignment)
+            break;
+
+        assignment->swap(next);
+
+        std::fill(sums.begin(), sums.end(), 0.0);
+        std::fill(members.begin(), members.end(), 0);
+        for (v8_size_t i = 0; i < entries.size(); ++i) {
+            const color_entry_t& entry = entries[i];
+            double* cluster = &sums[(*assignment)[i] * 4];
+
+            for (int c = 0; c < 3; ++c)
+                cluster[c] += entry.ce_weight * entry.ce_lab[c];
+            cluster[3] += entry.ce_weight;
+            ++members[(*assignment)[i]];
+        }
+
+        bool has_empty = false;
+        for (v8_size_t k = 0; k < cluster_count; ++k) {
+            const double* cluster = &sums[k * 4];
+            if (!members[k]) {
+                has_empty = true;
+                continue;
+            }
+
+            for (int c = 0; c < 3; ++c)
+                (*centroids)[k * 3 + c] = static_cast<float>(cluster[c] / cluster[3]);
+        }
+
+        if (!has_empty)
+            continue;
+
+        //
+        // Empty clusters are seeded with the worst represented entries,
+        // then the centroids of the clusters that lost them are updated.
+        reseed_empty_clusters(entries, *centroids, assignment, &sums, &members);
+
+        for (v8_size_t k = 0; k < cluster_count; ++k) {
+            const double* cluster = &sums[k * 4];
+            if (!members[k])
+                continue;
+
+            for (int c = 0; c < 3; ++c)
+                (*centroids)[k * 3 + c] = static_cast<float>(cluster[c] / cluster[3]);
+        }
+    }
+}
+
+//
+// Palette entry nearest to the center of each cell of the lookup table.
+void build_lookup(
+    const v8::math::rgb_color*  palette,
+    v8_size_t                   palette_size,
+    v8::base::job_system*       jobs,
+    std::vector<v8_uint8_t>*    table
+    ) {
+    using namespace v8::math;
+
+    centroid_planes_t planes(palette_size);
+    for (v8_size_t i = 0; i < palette_size; ++i) {
+        color_lab lab;
+        rgb_to_lab(&palette[i], &lab);
+        planes.set(i, lab.Elements);
+    }
+
+    const v8_uint32_t mask = (1U << k_lookup_bits) - 1;
+    const float cell_size = static_cast<float>(1U << (8 - k_lookup_bits));
+    const float center = (cell_size - 1.0f) * 0.5f;
+
+    std::vector<float> centers(k_lookup_cells * 4);
+    for (v8_uint32_t cell = 0; cell < k_lookup_cells; ++cell) {
+        float* color = &centers[cell * 4];
+        color[0] = ((cell >> (2 * k_lookup_bits)) * cell_size + center) / 255.0f;
+        color[1] = (((cell >> k_lookup_bits) & mask) * cell_size + center) / 255.0f;
+        color[2] = ((cell & mask) * cell_size + center) / 255.0f;
+        color[3] = 1.0f;
+    }
+
+    convert_colors(
+        Color_Space_Rgb, &centers[0], Color_Space_Lab, &centers[0],
+        k_lookup_cells, jobs);
+
+    table->resize(k_lookup_cells);
+    run_quantizer_batch(jobs, k_lookup_cells, k_search_grain,
+        [&](v8_size_t first, v8_size_t last) {
+        for (v8_size_t cell = first; cell < last; ++cell) {
+            (*table)[cell] = static_cast<v8_uint8_t>(
+                planes.nearest(&centers[cell * 4]));
+        }
+    });
+}
+
+inline v8_uint32_t lookup_key(v8_uint32_t r, v8_uint32_t g, v8_uint32_t b) {
+    const v8_uint32_t shift = 8 - k_lookup_bits;
+
+    return ((r >> shift) << (2 * k_lookup_bits))
+        | ((g >> shift) << k_lookup_bits)
+        | (b >> shift);
+}
+
+//
+// Floyd-Steinberg error diffusion over the rows [first_row, last_row),
+// starting without error. targets holds the palette colors as 8 bit
+// values, 4 floats per entry.
+void dither_rows(
+    const v8_uint8_t*   src,
+    v8_size_t           src_pitch,
+    v8_size_t           width,
+    v8_size_t           first_row,
+    v8_size_t           last_row,
+    const float*        targets,
+    const v8_uint8_t*   table,
+    v8_uint8_t*         indices,
+    v8_size_t           indices_pitch
+    ) {
+    using namespace v8::math::simd;
+
+    //
+    // Errors carried to the current and the next row, with a pixel of
+    // padding on both sides.
+    const v8_size_t row_floats = (width + 2) * 4;
+    std::vector<float> errors(row_floats * 2, 0.0f);
+
+    const float4_t weight_ahead = splat_float4(7.0f / 16.0f);
+    const float4_t weight_behind_below = splat_float4(3.0f / 16.0f);
+    const float4_t weight_below = splat_float4(5.0f / 16.0f);
+    const float4_t weight_ahead_below = splat_float4(1.0f / 16.0f);
+    const float4_t max_value = splat_float4(255.0f);
+    const float4_t half = splat_float4(0.5f);
+
+    for (v8_size_t y = first_row; y < last_row; ++y) {
+        const float* current = &errors[(y & 1) * row_floats + 4];
+        float* below = &errors[((y + 1) & 1) * row_floats + 4];
+
+        const v8_uint8_t* row = src + y * src_pitch;
+        v8_uint8_t* out = indices + y * indices_pitch;
+
+        //
+        // Serpentine order : odd rows run right to left. The error for the
+        // next pixel stays in a register and the errors for the row below
+        // are summed in registers, each stored once.
+        const bool reverse = (y & 1) != 0;
+        const ptrdiff_t dir = reverse ? -4 : 4;
+
+        float4_t ahead = zero_float4();
+        float4_t below_behind = zero_float4();
+        float4_t below_here = zero_float4();
+        v8_size_t x = 0;
+
+        for (v8_size_t i = 0; i < width; ++i) {
+            x = reverse ? width - 1 - i : i;
+            const v8_uint8_t* pixel = row + x * 4;
+
+            float4_t value = add(
+                set_float4(pixel[0], pixel[1], pixel[2], 0.0f),
+                add(load_float4(current + x * 4), ahead));
+            value = minimum(maximum(value, zero_float4()), max_value);
+
+            float lanes[4];
+            store_float4(lanes, convert_float_to_int(add(value, half)));
+            v8_uint32_t channels[4];
+            memcpy(channels, lanes, sizeof(lanes));
+
+            const v8_uint8_t index = table[lookup_key(channels[0], channels[1], channels[2])];
+            out[x] = index;
+
+            const float4_t diff = sub(value, load_float4(targets + index * 4));
+
+            ahead = mul(diff, weight_ahead);
+            store_float4(below + x * 4 - dir,
+                add(below_behind, mul(diff, weight_behind_below)));
+            below_behind = add(below_here, mul(diff, weight_below));
+            below_here = mul(diff, weight_ahead_below);
+        }
+
+        store_float4(below + x * 4, below_behind);
+    }
+}
+
+} // anonymous namespace
+
+v8_size_t v8::math::build_color_palette(
+    const v8_uint8_t*   src,
+    v8_size_t           src_pitch,
+    v8_size_t           width,
+    v8_size_t           height,
+    v8_size_t           max_colors,
+    rgb_color*          palette,
+    v8_int32_t          refine_passes,
+    base::job_system*   jobs
+    ) {
+    assert(max_colors >= 1 && max_colors <= C_Quantizer_Max_Colors);
+
+    if (!width || !height)
+        return 0;
+
+    std::vector<color_entry_t> entries;
+    collect_entries(src, src_pitch, width, height, jobs, &entries);
+
+    const std::vector<median_box_t> boxes = median_cut(&entries, max_colors);
+
+    std::vector<v8_uint32_t> assignment(entries.size());
+    std::vector<float> centroids(boxes.size() * 3);
+
+    for (v8_size_t k = 0; k < boxes.size(); ++k) {
+        double weight = 0.0;
+        double sums[3] = { 0.0, 0.0, 0.0 };
+
+        for (v8_size_t i = boxes[k].mb_first; i < boxes[k].mb_last; ++i) {
+            assignment[i] = static_cast<v8_uint32_t>(k);
+            weight += entries[i].ce_weight;
+            for (int c = 0; c < 3; ++c)
+                sums[c] += entries[i].ce_weight * entries[i].ce_lab[c];
+        }
+
+        for (int c = 0; c < 3; ++c)
+            centroids[k * 3 + c] = static_cast<float>(sums[c] / weight);
+    }
+
+    refine_clusters(entries, refine_passes, jobs, &assignment, &centroids);
+
+    std::vector<double> alphas(boxes.size() * 2, 0.0);
+    for (v8_size_t i = 0; i < entries.size(); ++i) {
+        alphas[assignment[i] * 2] += entries[i].ce_weight * entries[i].ce_alpha;
+        alphas[assignment[i] * 2 + 1] += entries[i].ce_weight;
+    }
+
+    v8_size_t color_count = 0;
+    for (v8_size_t k = 0; k < boxes.size(); ++k) {
+        if (alphas[k * 2 + 1] <= 0.0)
+            continue;
+
+        const float* lab = &centroids[k * 3];
+        rgb_color& color = palette[color_count++];
+        lab_to_rgb(color_lab(lab[0], lab[1], lab[2]), &color);
+        color.Alpha = static_cast<float>(alphas[k * 2] / alphas[k * 2 + 1]);
+    }
+
+    return color_count;
+}
+
+void v8::math::map_colors_to_palette(
+    const v8_uint8_t*   src,
+    v8_size_t           src_pitch,
+    v8_size_t           width,
+    v8_size_t           height,
+    const rgb_color*    palette,
+    v8_size_t           palette_size,
+    Dither_Mode         dither,
+    v8_uint8_t*         indices,
+    v8_size_t           indices_pitch,
+    base::job_system*   jobs
+    ) {
+    assert(palette_size >= 1 && palette_size <= C_Quantizer_Max_Colors);
+
+    if (!width || !height)
+        return;
+
+    std::vector<v8_uint8_t> table;
+    build_lookup(palette, palette_size, jobs, &table);
+
+    if (dither == Dither_Mode_Floyd_Steinberg) {
+        //
+        // Palette colors as the 8 bit values they are stored with.
+        std::vector<float> targets(palette_size * 4, 0.0f);
+        for (v8_size_t i = 0; i < palette_size; ++i) {
+            for (int c = 0; c < 3; ++c) {
+                const float value = std::min(std::max(palette[i].Elements[c], 0.0f), 1.0f);
+                targets[i * 4 + c] = std::floor(value * 255.0f + 0.5f);
+            }
+        }
+
+        const v8_size_t band_count =
+            (height + C_Quantizer_Dither_Rows - 1) / C_Quantizer_Dither_Rows;
+
+        run_quantizer_batch(jobs, band_count, 1,
+            [&](v8_size_t first, v8_size_t last) {
+            for (v8_size_t band = first; band < last; ++band) {
+                dither_rows(
+                    src, src_pitch, width, band * C_Quantizer_Dither_Rows,
+                    std::min(height, (band + 1) * C_Quantizer_Dither_Rows),
+                    &targets[0], &table[0], indices, indices_pitch);
+            }
+        });
+        return;
+    }
+
+    const v8_size_t row_grain =
+        std::max<v8_size_t>(1, C_Color_Batch_Grain / width);
+
+    run_quantizer_batch(jobs, height, row_grain,
+        [&](v8_size_t first, v8_size_t last) {
+        for (v8_size_t y = first; y < last; ++y) {
+            const v8_uint8_t* row = src + y * src_pitch;
+            v8_uint8_t* out = indices + y * indices_pitch;
+
+            for (v8_size_t x = 0; x < width; ++x) {
+                const v8_uint8_t* pixel = row + x * 4;
+                out[x] = table[lookup_key(pixel[0], pixel[1], pixel[2])];
+            }
+        }
+    });
+}
+
+v8_size_t v8::math::quantize_colors(
+    const v8_uint8_t*   src,
+    v8_size_t           src_pitch,
+    v8_size_t           width,
+    v8_size_t           height,
+    v8_size_t           max_colors,
+    Dither_Mode         dither,
+    rgb_color*          palette,
+    v8_uint8_t*         indices,
+    v8_size_t           indices_pitch,
+    base::job_system*   jobs
+    ) {
+    const v8_size_t color_count = build_color_palette(
+        src, src_pitch, width, height, max_colors, palette,
+        C_Quantizer_Refine_Passes, jobs);
+
+    if (color_count)
+        map_colors_to_palette(
+            src, src_pitch, width, height, palette, color_count, dither,
+            indices, indices_pitch, jobs);
+
+    return color_count;
+}
@@ -0,0 +1,660 @@
+#include "pch_hdr.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <v8/base/job_system.hpp>
+#include <v8/math/matrix3X3.hpp>
+#include <v8/math/simd/float4.hpp>
+#include <v8/math/numerical_analysis/symmetric_eigen.hpp>
+#include <v8/math/containment/containment_obb.hpp>
+
+#include "point_array.hpp"
+
+namespace {
+
+using v8::math::vector3F;
+using v8::math::matrix_3X3F;
+using v8::math::oriented_bounding_box3F;
+using v8::math::internals::point_array;
+
+//
+// Points accumulated in single precision (SIMD path) before the block sums
+// are added to the double precision moments.
+const size_t k_moment_block_size = 1024;
+
+//
+// Sets with fewer points are reduced on the calling thread; larger ones are
+// split in chunks of k_parallel_chunk_size points.
+const size_t k_parallel_threshold = 1 << 16;
+const size_t k_parallel_chunk_size = 1 << 14;
+
+//
+// Sets per job, for obb_from_point_sets.
+const size_t k_set_grain = 8;
+
+//
+// First and second order moments of the points, relative to a reference
+// point of the set (which keeps the covariance free of cancellation for
+// sets far from the origin).
+struct moments_t {
+    double      mo_count;
+    double      mo_sum[3];
+    /* xx, xy, xz, yy, yz, zz */
+    double      mo_products[6];
+
+    void clear() {
+        mo_count = 0.0;
+        std::fill(mo_sum, mo_sum + 3, 0.0);
+        std::fill(mo_products, mo_products + 6, 0.0);
+    }
+
+    void merge(const moments_t& other) {
+        mo_count += other.mo_count;
+        for (int i = 0; i < 3; ++i)
+            mo_sum[i] += other.mo_sum[i];
+        for (int i = 0; i < 6; ++i)
+            mo_products[i] += other.mo_products[i];
+    }
+
+    void add_point(double x, double y, double z) {
+        mo_count += 1.0;
+        mo_sum[0] += x;
+        mo_sum[1] += y;
+        mo_sum[2] += z;
+        mo_products[0] += x * x;
+        mo_products[1] += x * y;
+        mo_products[2] += x * z;
+        mo_products[3] += y * y;
+        mo_products[4] += y * z;
+        mo_products[5] += z * z;
+    }
+};
+
+//
+// Range of the projections of the points on the box axes.
+struct extents_t {
+    float       ex_min[3];
+    float       ex_max[3];
+
+    void clear() {
+        std::fill(ex_min, ex_min + 3, std::numeric_limits<float>::max());
+        std::fill(ex_max, ex_max + 3, -std::numeric_limits<float>::max());
+    }
+
+    void merge(const extents_t& other) {
+        for (int i = 0; i < 3; ++i) {
+            ex_min[i] = std::min(ex_min[i], other.ex_min[i]);
+            ex_max[i] = std::max(ex_max[i], other.ex_max[i]);
+        }
+    }
+};
+
+//
+// Box axes (one per row, right handed) and the reference point that the
+// projections are relative to.
+struct frame_t {
+    float       fr_axes[3][3];
+    float       fr_origin[3];
+};
+
+#if defined(V8_MATH_SIMD_ENABLED)
+
+using v8::math::simd::float4_t;
+
+inline double lane_sum(float4_t val) {
+    using namespace v8::math::simd;
+    return (static_cast<double>(extract_lane<0>(val)) + extract_lane<1>(val))
+        + (static_cast<double>(extract_lane<2>(val)) + extract_lane<3>(val));
+}
+
+//
+// Packed points, four at a time. Returns the index of the first point
+// that was not processed.
+size_t accumulate_moments_packed(
+    const point_array&  points,
+    size_t              first,
+    size_t              last,
+    const float*        ref,
+    moments_t*          moments
+    ) {
+    using namespace v8::math::simd;
+
+    const float4_t rx = splat_float4(ref[0]);
+    const float4_t ry = splat_float4(ref[1]);
+    const float4_t rz = splat_float4(ref[2]);
+
+    size_t i = first;
+    while (i + 4 <= last) {
+        const size_t block_last = std::min(last, i + k_moment_block_size);
+
+        float4_t sx = zero_float4(), sy = zero_float4(), sz = zero_float4();
+        float4_t sxx = zero_float4(), sxy = zero_float4(), sxz = zero_float4();
+        float4_t syy = zero_float4(), syz = zero_float4(), szz = zero_float4();
+
+        const size_t block_first = i;
+        for (; i + 4 <= block_last; i += 4) {
+            float4_t x, y, z;
+            load_xyz4(points[i], &x, &y, &z);
+            x = sub(x, rx);
+            y = sub(y, ry);
+            z = sub(z, rz);
+
+            sx = add(sx, x);
+            sy = add(sy, y);
+            sz = add(sz, z);
+            sxx = add(sxx, mul(x, x));
+            sxy = add(sxy, mul(x, y));
+            sxz = add(sxz, mul(x, z));
+            syy = add(syy, mul(y, y));
+            syz = add(syz, mul(y, z));
+            szz = add(szz, mul(z, z));
+        }
+
+        moments->mo_count += static_cast<double>(i - block_first);
+        moments->mo_sum[0] += lane_sum(sx);
+        moments->mo_sum[1] += lane_sum(sy);
+        moments->mo_sum[2] += lane_sum(sz);
+        moments->mo_products[0] += lane_sum(sxx);
+        moments->mo_products[1] += lane_sum(sxy);
+        moments->mo_products[2] += lane_sum(sxz);
+        moments->mo_products[3] += lane_sum(syy);
+        moments->mo_products[4] += lane_sum(syz);
+        moments->mo_products[5] += lane_sum(szz);
+    }
+
+    return i;
+}
+
+size_t project_packed(
+    const point_array&  points,
+    size_t              first,
+    size_t              last,
+    const frame_t&      frame,
+    extents_t*          extents
+    ) {
+    using namespace v8::math::simd;
+
+    float4_t axes[3][3];
+    float4_t lo[3];
+    float4_t hi[3];
+    for (int a = 0; a < 3; ++a) {
+        for (int c = 0; c < 3; ++c)
+            axes[a][c] = splat_float4(frame.fr_axes[a][c]);
+        lo[a] = splat_float4(extents->ex_min[a]);
+        hi[a] = splat_float4(extents->ex_max[a]);
+    }
+
+    const float4_t rx = splat_float4(frame.fr_origin[0]);
+    const float4_t ry = splat_float4(frame.fr_origin[1]);
+    const float4_t rz = splat_float4(frame.fr_origin[2]);
+
+    size_t i = first;
+    for (; i + 4 <= last; i += 4) {
+        float4_t x, y, z;
+        load_xyz4(points[i], &x, &y, &z);
+        x = sub(x, rx);
+        y = sub(y, ry);
+        z = sub(z, rz);
+
+        for (int a = 0; a < 3; ++a) {
+            const float4_t d = add(add(
+                mul(axes[a][0], x), mul(axes[a][1], y)), mul(axes[a][2], z));
+            lo[a] = minimum(lo[a], d);
+            hi[a] = maximum(hi[a], d);
+        }
+    }
+
+    for (int a = 0; a < 3; ++a) {
+        const float4_t lo2 = minimum(lo[a], swizzle<2, 3, 0, 1>(lo[a]));
+        const float4_t hi2 = maximum(hi[a], swizzle<2, 3, 0, 1>(hi[a]));
+        extents->ex_min[a] = std::min(extract_lane<0>(lo2), extract_lane<1>(lo2));
+        extents->ex_max[a] = std::max(extract_lane<0>(hi2), extract_lane<1>(hi2));
+    }
+
+    return i;
+}
+
+#else /* V8_MATH_SIMD_ENABLED */
+
+size_t accumulate_moments_packed(
+    const point_array&, size_t first, size_t, const float*, moments_t*
+    ) {
+    return first;
+}
+
+size_t project_packed(
+    const point_array&, size_t first, size_t, const frame_t&, extents_t*
+    ) {
+    return first;
+}
+
+#endif /* V8_MATH_SIMD_ENABLED */
+
+void accumulate_moments(
+    const point_array&  points,
+    size_t              first,
+    size_t              last,
+    const float*        ref,
+    moments_t*          moments
+    ) {
+    moments->clear();
+
+    size_t i = first;
+    if (points.is_packed())
+        i = accumulate_moments_packed(points, first, last, ref, moments);
+
+    for (; i < last; ++i) {
+        const float* pt = points[i];
+        moments->add_point(
+            static_cast<double>(pt[0]) - ref[0],
+            static_cast<double>(pt[1]) - ref[1],
+            static_cast<double>(pt[2]) - ref[2]);
+    }
+}
+
+void project_points(
+    const point_array&  points,
+    size_t              first,
+    size_t              last,
+    const frame_t&      frame,
+    extents_t*          extents
+    ) {
+    extents->clear();
+
+    size_t i = first;
+    if (points.is_packed())
+        i = project_packed(points, first, last, frame, extents);
+
+    for (; i < last; ++i) {
+        const float* pt = points[i];
+        const float x = pt[0] - frame.fr_origin[0];
+        const float y = pt[1] - frame.fr_origin[1];
+        const float z = pt[2] - frame.fr_origin[2];
+
+        for (int a = 0; a < 3; ++a) {
+            const float d = frame.fr_axes[a][0] * x + frame.fr_axes[a][1] * y 
+                + frame.fr_axes[a][2] * z;
+            extents->ex_min[a] = std::min(extents->ex_min[a], d);
+            extents->ex_max[a] = std::max(extents->ex_max[a], d);
+        }
+    }
+}
+
+//
+// Runs fn(first, last, result_t*) over the points, in chunks when the set 
+// is large and a job system is available; the partial results are merged 
+// in order, so the result does not depend on the number of threads.
+template<typename result_t, typename range_fn>
+void reduce_points(
+    v8::base::job_system*   jobs,
+    size_t                  count,
+    range_fn                fn,
+    result_t*               result
+    ) {
+    if (!jobs || jobs->get_thread_count() < 2 || count < k_parallel_threshold) {
+        fn(0, count, result);
+        return;
+    }
+
+    const size_t chunk_count = 
+        (count + k_parallel_chunk_size - 1) / k_parallel_chunk_size;
+    std::vector<result_t> partial(chunk_count);
+
+    jobs->parallel_for(0, chunk_count, 1, [&](size_t first, size_t last) {
+        for (size_t chunk = first; chunk < last; ++chunk) {
+            const size_t chunk_first = chunk * k_parallel_chunk_size;
+            fn(chunk_first, std::min(count, chunk_first + k_parallel_chunk_size),
+               &partial[chunk]);
+        }
+    });
+
+    *result = partial[0];
+    for (size_t chunk = 1; chunk < chunk_count; ++chunk)
+        result->merge(partial[chunk]);
+}
+
+void covariance_from_moments(const moments_t& moments, matrix_3X3F* cov) {
+    const double inv_count = 1.0 / moments.mo_count;
+    const double mean[3] = {
+        moments.mo_sum[0] * inv_count,
+        moments.mo_sum[1] * inv_count,
+        moments.mo_sum[2] * inv_count
+    };
+
+    const int rows[6] = { 0, 0, 0, 1, 1, 2 };
+    const int cols[6] = { 0, 1, 2, 1, 2, 2 };
+    for (int i = 0; i < 6; ++i) {
+        const float val = static_cast<float>(
+            moments.mo_products[i] * inv_count - mean[rows[i]] * mean[cols[i]]);
+        cov->elements_[rows[i] * 3 + cols[i]] = val;
+        cov->elements_[cols[i] * 3 + rows[i]] = val;
+    }
+}
+
+void frame_from_eigenvectors(
+    const matrix_3X3F& eigenvectors, const float* ref, frame_t* frame
+    ) {
+    for (int a = 0; a < 3; ++a) {
+        for (int c = 0; c < 3; ++c)
+            frame->fr_axes[a][c] = eigenvectors.elements_[c * 3 + a];
+        frame->fr_origin[a] = ref[a];
+    }
+}
+
+struct point2_t {
+    float       pt_x;
+    float       pt_y;
+
+    bool operator<(const point2_t& rhs) const {
+        return pt_x < rhs.pt_x || (pt_x == rhs.pt_x && pt_y < rhs.pt_y);
+    }
+};
+
+inline float cross_2d(const point2_t& o, const point2_t& a, const point2_t& b) {
+    return (a.pt_x - o.pt_x) * (b.pt_y - o.pt_y) 
+        - (a.pt_y - o.pt_y) * (b.pt_x - o.pt_x);
+}
+
+//
+// Convex hull (Andrew's monotone chain), counter clockwise, without
+// collinear points. Sorts pts.
+void convex_hull_2d(std::vector<point2_t>& pts, std::vector<point2_t>* hull) {
+    std::sort(pts.begin(), pts.end());
+    hull->resize(2 * pts.size());
+
+    size_t k = 0;
+    for (size_t i = 0; i < pts.size(); ++i) {
+        while (k >= 2 && cross_2d((*hull)[k - 2], (*hull)[k - 1], pts[i]) <= 0.0f)
+            --k;
+        (*hull)[k++] = pts[i];
+    }
+
+    const size_t lower_size = k + 1;
+    for (size_t i = pts.size() - 1; i-- > 0; ) {
+        while (k >= lower_size 
+               && cross_2d((*hull)[k - 2], (*hull)[k - 1], pts[i]) <= 0.0f)
+            --k;
+        (*hull)[k++] = pts[i];
+    }
+
+    hull->resize(k > 1 ? k - 1 : k);
+}
+
+//
+// Minimum area rectangle enclosing a convex polygon : one of its sides is
+// collinear with an edge of the polygon. Returns the area and the unit
+// direction of that side.
+float min_area_rectangle(
+    const std::vector<point2_t>& hull, float* dir_x, float* dir_y
+    ) {
+    float best_area = std::numeric_limits<float>::max();
+    *dir_x = 1.0f;
+    *dir_y = 0.0f;
+
+    const size_t count = hull.size();
+    for (size_t i = 0; i < count; ++i) {
+        const point2_t& p0 = hull[i];
+        const point2_t& p1 = hull[(i + 1) % count];
+
+        float ex = p1.pt_x - p0.pt_x;
+        float ey = p1.pt_y - p0.pt_y;
+        const float len = std::sqrt(ex * ex + ey * ey);
+        if (len == 0.0f)
+            continue;
+        ex /= len;
+        ey /= len;
+
+        float u_min = 0.0f, u_max = 0.0f, v_max = 0.0f;
+        for (size_t j = 0; j < count; ++j) {
+            const float dx = hull[j].pt_x - p0.pt_x;
+            const float dy = hull[j].pt_y - p0.pt_y;
+            const float u = ex * dx + ey * dy;
+            const float v = ex * dy - ey * dx;
+            u_min = std::min(u_min, u);
+            u_max = std::max(u_max, u);
+            v_max = std::max(v_max, v);
+        }
+
+        const float area = (u_max - u_min) * v_max;
+        if (area < best_area) {
+            best_area = area;
+            *dir_x = ex;
+            *dir_y = ey;
+        }
+    }
+
+    return best_area;
+}
+
+inline float box_volume(const extents_t& ext) {
+    return (ext.ex_max[0] - ext.ex_min[0]) * (ext.ex_max[1] - ext.ex_min[1]) 
+        * (ext.ex_max[2] - ext.ex_min[2]);
+}
+
+//
+// Obb_Fit_Hull_Refined : for each axis, keeps it and rotates the other two
+// about it, to the sides of the minimum area rectangle enclosing the
+// projection of the points. The frame and extents of the smallest box win.
+void refine_with_hulls(
+    const point_array&  points,
+    frame_t*            frame,
+    extents_t*          extents
+    ) {
+    const size_t count = points.size();
+    std::vector<point2_t> projected(count);
+    std::vector<point2_t> hull;
+
+    float best_volume = box_volume(*extents);
+    frame_t best_frame = *frame;
+    bool improved = false;
+
+    for (int k = 0; k < 3; ++k) {
+        const int i = (k + 1) % 3;
+        const int j = (k + 2) % 3;
+        const float* u = frame->fr_axes[i];
+        const float* v = frame->fr_axes[j];
+
+        for (size_t p = 0; p < count; ++p) {
+            const float* pt = points[p];
+            const float x = pt[0] - frame->fr_origin[0];
+            const float y = pt[1] - frame->fr_origin[1];
+            const float z = pt[2] - frame->fr_origin[2];
+            projected[p].pt_x = u[0] * x + u[1] * y + u[2] * z;
+            projected[p].pt_y = v[0] * x + v[1] * y + v[2] * z;
+        }
+
+        convex_hull_2d(projected, &hull);
+        if (hull.size() < 3)
+            continue;
+
+        float c, s;
+        const float area = min_area_rectangle(hull, &c, &s);
+        const float volume = area * (extents->ex_max[k] - extents->ex_min[k]);
+        if (volume >= best_volume)
+            continue;
+
+        //
+        // Rotation about axis k keeps the frame right handed.
+        best_volume = volume;
+        best_frame = *frame;
+        for (int a = 0; a < 3; ++a) {
+            best_frame.fr_axes[i][a] = c * u[a] + s * v[a];
+            best_frame.fr_axes[j][a] = c * v[a] - s * u[a];
+        }
+        improved = true;
+    }
+
+    if (!improved)
+        return;
+
+    *frame = best_frame;
+    project_points(points, 0, count, *frame, extents);
+}
+
+//
+// Axes are stored by decreasing extent; every swap of two axes negates one
+// of them, so vec_R_ = vec_U_ x vec_D_ still holds.
+void make_box(
+    const frame_t& frame, const extents_t& extents, oriented_bounding_box3F* obb
+    ) {
+    float axes[3][3];
+    float half_widths[3];
+    float center[3] = { 
+        frame.fr_origin[0], frame.fr_origin[1], frame.fr_origin[2] 
+    };
+
+    for (int a = 0; a < 3; ++a) {
+        const float mid = 0.5f * (extents.ex_min[a] + extents.ex_max[a]);
+        half_widths[a] = 0.5f * (extents.ex_max[a] - extents.ex_min[a]);
+        for (int c = 0; c < 3; ++c) {
+            axes[a][c] = frame.fr_axes[a][c];
+            center[c] += mid * frame.fr_axes[a][c];
+        }
+    }
+
+    for (int pass = 0; pass < 2; ++pass) {
+        for (int a = 0; a < 2 - pass; ++a) {
+            if (half_widths[a] >= half_widths[a + 1])
+                continue;
+
+            std::swap(half_widths[a], half_widths[a + 1]);
+            for (int c = 0; c < 3; ++c) {
+                std::swap(axes[a][c], axes[a + 1][c]);
+                axes[a + 1][c] = -axes[a + 1][c];
+            }
+        }
+    }
+
+    obb->origin_ = vector3F(center[0], center[1], center[2]);
+    obb->vec_R_ = vector3F(axes[0][0], axes[0][1], axes[0][2]);
+    obb->vec_U_ = vector3F(axes[1][0], axes[1][1], axes[1][2]);
+    obb->vec_D_ = vector3F(axes[2][0], axes[2][1], axes[2][2]);
+    for (int a = 0; a < 3; ++a)
+        obb->extents_[a] = half_widths[a];
+}
+
+void make_empty_box(oriented_bounding_box3F* obb) {
+    obb->origin_ = vector3F(0.0f, 0.0f, 0.0f);
+    obb->vec_R_ = vector3F(1.0f, 0.0f, 0.0f);
+    obb->vec_U_ = vector3F(0.0f, 1.0f, 0.0f);
+    obb->vec_D_ = vector3F(0.0f, 0.0f, 1.0f);
+    std::fill(obb->extents_, obb->extents_ + 3, 0.0f);
+}
+
+//
+// Extents (and refinement) for a set whose covariance has been decomposed.
+void fit_box(
+    const point_array&      points,
+    const matrix_3X3F&      eigenvectors,
+    v8::math::Obb_Fit_Mode  fit_mode,
+    v8::base::job_system*   jobs,
+    oriented_bounding_box3F* obb
+    ) {
+    frame_t frame;
+    frame_from_eigenvectors(eigenvectors, points[0], &frame);
+
+    extents_t extents;
+    reduce_points(jobs, points.size(), 
+        [&](size_t first, size_t last, extents_t* ext) {
+        project_points(points, first, last, frame, ext);
+    }, &extents);
+
+    if (fit_mode == v8::math::Obb_Fit_Hull_Refined)
+        refine_with_hulls(points, &frame, &extents);
+
+    make_box(frame, extents, obb);
+}
+
+} // anonymous namespace
+
+void v8::math::obb_from_points(
+    const vector3F*             pt_set,
+    size_t                      pt_count,
+    size_t                      pt_stride,
+    oriented_bounding_box3F*    obb,
+    Obb_Fit_Mode                fit_mode,
+    base::job_system*           jobs
+    ) {
+    if (!pt_count) {
+        make_empty_box(obb);
+        return;
+    }
+
+    const point_array points(pt_set, pt_count, pt_stride);
+    const float* ref = points[0];
+
+    moments_t moments;
+    reduce_points(jobs, pt_count, 
+        [&](size_t first, size_t last, moments_t* partial) {
+        accumulate_moments(points, first, last, ref, partial);
+    }, &moments);
+
+    matrix_3X3F covariance;
+    covariance_from_moments(moments, &covariance);
+
+    vector3F eigenvalues;
+    matrix_3X3F eigenvectors;
+    eigen_decompose_symmetric(covariance, &eigenvalues, &eigenvectors);
+
+    fit_box(points, eigenvectors, fit_mode, jobs, obb);
+}
+
+void v8::math::obb_from_point_sets(
+    const obb_fit_input_t*      sets,
+    size_t                      set_count,
+    oriented_bounding_box3F*    obbs,
+    Obb_Fit_Mode                fit_mode,
+    base::job_system*           jobs
+    ) {
+    if (!set_count)
+        return;
+
+    std::vector<matrix_3X3F> covariances(set_count);
+    std::vector<vector3F> eigenvalues(set_count);
+    std::vector<matrix_3X3F> eigenvectors(set_count);
+
+    //
+    // Sets are distributed over the threads; each one is reduced on a
+    // single thread.
+    auto for_each_set = [&](const std::function<void(size_t)>& fn) {
+        if (!jobs || jobs->get_thread_count() < 2 || set_count < 2 * k_set_grain) {
+            for (size_t i = 0; i < set_count; ++i)
+                fn(i);
+            return;
+        }
+
+        jobs->parallel_for(0, set_count, k_set_grain, 
+            [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+                fn(i);
+        });
+    };
+
+    for_each_set([&](size_t i) {
+        const obb_fit_input_t& set = sets[i];
+        if (!set.ofi_count) {
+            covariances[i] = matrix_3X3F::identity;
+            return;
+        }
+
+        const point_array points(set.ofi_points, set.ofi_count, set.ofi_stride);
+        moments_t moments;
+        accumulate_moments(points, 0, points.size(), points[0], &moments);
+        covariance_from_moments(moments, &covariances[i]);
+    });
+
+    eigen_decompose_symmetric_batch(
+        &covariances[0], set_count, &eigenvalues[0], &eigenvectors[0], jobs);
+
+    for_each_set([&](size_t i) {
+        const obb_fit_input_t& set = sets[i];
+        if (!set.ofi_count) {
+            make_empty_box(obbs + i);
+            return;
+        }
+
+        const point_array points(set.ofi_points, set.ofi_count, set.ofi_stride);
+        fit_box(points, eigenvectors[i], fit_mode, nullptr, obbs + i);
+    });
+}
@@ -0,0 +1,553 @@
+#include "pch_hdr.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <v8/math/simd/float4.hpp>
+#include <v8/math/containment/containment_sphere.hpp>
+
+#include "point_array.hpp"
+
+namespace {
+
+//
+// Points per block of the farthest point search : the block maximum is a
+// SIMD reduction and only blocks that improve on it are scanned again for
+// the index.
+const size_t k_farthest_block_size = 1024;
+
+//
+// Passes that grow the Ritter sphere towards the farthest point, before
+// falling back to a single sequential growing pass.
+const size_t k_max_ritter_passes = 16;
+
+//
+// Squared distances within this relative tolerance of the squared radius
+// are treated as inside (single precision rounding); the final radius
+// always covers the farthest point.
+const float k_radius_tolerance = 1.0e-6f;
+
+//
+// Bound on the size of the subset used by sphere_from_points_minimal.
+const size_t k_max_support_subset = 256;
+
+using v8::math::internals::point_array;
+
+inline float point_distance_squared(const float* point, const float* center) {
+    const float dx = point[0] - center[0];
+    const float dy = point[1] - center[1];
+    const float dz = point[2] - center[2];
+    return (dx * dx + dy * dy) + dz * dz;
+}
+
+//
+// Index of the point farthest from center, in [first, last), scalar.
+size_t farthest_in_range(
+    const point_array&  points,
+    size_t              first,
+    size_t              last,
+    const float*        center,
+    float*              max_distance_squared
+    ) {
+    size_t best = first;
+    float best_distance = -1.0f;
+    for (size_t i = first; i < last; ++i) {
+        const float dist = point_distance_squared(points[i], center);
+        if (dist > best_distance) {
+            best_distance = dist;
+            best = i;
+        }
+    }
+
+    *max_distance_squared = best_distance;
+    return best;
+}
+
+#if defined(V8_MATH_SIMD_ENABLED)
+
+using v8::math::simd::float4_t;
+using v8::math::internals::load_points;
+
+inline float horizontal_min(float4_t val) {
+    using namespace v8::math::simd;
+    const float4_t m = minimum(val, swizzle<2, 3, 0, 1>(val));
+    return extract_lane<0>(minimum(m, swizzle<1, 0, 3, 2>(m)));
+}
+
+inline float horizontal_max(float4_t val) {
+    using namespace v8::math::simd;
+    const float4_t m = maximum(val, swizzle<2, 3, 0, 1>(val));
+    return extract_lane<0>(maximum(m, swizzle<1, 0, 3, 2>(m)));
+}
+
+inline float horizontal_sum(float4_t val) {
+    using namespace v8::math::simd;
+    return (extract_lane<0>(val) + extract_lane<1>(val))
+           + (extract_lane<2>(val) + extract_lane<3>(val));
+}
+
+void compute_bounds(const point_array& points, float* min_pt, float* max_pt) {
+    using namespace v8::math::simd;
+
+    float4_t min_x = splat_float4(points[0][0]);
+    float4_t min_y = splat_float4(points[0][1]);
+    float4_t min_z = splat_float4(points[0][2]);
+    float4_t max_x = min_x;
+    float4_t max_y = min_y;
+    float4_t max_z = min_z;
+
+    size_t i = 0;
+    for (; i + 4 <= points.size(); i += 4) {
+        float4_t x, y, z;
+        load_points(points, i, &x, &y, &z);
+        min_x = minimum(min_x, x);
+        min_y = minimum(min_y, y);
+        min_z = minimum(min_z, z);
+        max_x = maximum(max_x, x);
+        max_y = maximum(max_y, y);
+        max_z = maximum(max_z, z);
+    }
+
+    min_pt[0] = horizontal_min(min_x);
+    min_pt[1] = horizontal_min(min_y);
+    min_pt[2] = horizontal_min(min_z);
+    max_pt[0] = horizontal_max(max_x);
+    max_pt[1] = horizontal_max(max_y);
+    max_pt[2] = horizontal_max(max_z);
+
+    for (; i < points.size(); ++i) {
+        for (int axis = 0; axis < 3; ++axis) {
+            min_pt[axis] = std::min(min_pt[axis], points[i][axis]);
+            max_pt[axis] = std::max(max_pt[axis], points[i][axis]);
+        }
+    }
+}
+
+//
+// Blocks are summed in single precision, the block sums in double.
+void sum_points(const point_array& points, double* sum) {
+    using namespace v8::math::simd;
+
+    sum[0] = sum[1] = sum[2] = 0.0;
+    for (size_t block = 0; block < points.size(); block += k_farthest_block_size) {
+        const size_t last = std::min(block + k_farthest_block_size, points.size());
+
+        float4_t sum_x = zero_float4();
+        float4_t sum_y = zero_float4();
+        float4_t sum_z = zero_float4();
+
+        size_t i = block;
+        for (; i + 4 <= last; i += 4) {
+            float4_t x, y, z;
+            load_points(points, i, &x, &y, &z);
+            sum_x = add(sum_x, x);
+            sum_y = add(sum_y, y);
+            sum_z = add(sum_z, z);
+        }
+
+        sum[0] += horizontal_sum(sum_x);
+        sum[1] += horizontal_sum(sum_y);
+        sum[2] += horizontal_sum(sum_z);
+
+        for (; i < last; ++i) {
+            sum[0] += points[i][0];
+            sum[1] += points[i][1];
+            sum[2] += points[i][2];
+        }
+    }
+}
+
+size_t farthest_point(
+    const point_array&  points,
+    const float*        center,
+    float*              max_distance_squared
+    ) {
+    using namespace v8::math::simd;
+
+    const float4_t cx = splat_float4(center[0]);
+    const float4_t cy = splat_float4(center[1]);
+    const float4_t cz = splat_float4(center[2]);
+
+    size_t best = 0;
+    float best_distance = -1.0f;
+
+    for (size_t block = 0; block < points.size(); block += k_farthest_block_size) {
+        const size_t last = std::min(block + k_farthest_block_size, points.size());
+
+        float4_t block_max = splat_float4(-1.0f);
+        size_t i = block;
+        for (; i + 4 <= last; i += 4) {
+            float4_t x, y, z;
+            load_points(points, i, &x, &y, &z);
+            const float4_t dx = sub(x, cx);
+            const float4_t dy = sub(y, cy);
+            const float4_t dz = sub(z, cz);
+            block_max = maximum(block_max,
+                add(add(mul(dx, dx), mul(dy, dy)), mul(dz, dz)));
+        }
+
+        float block_distance = horizontal_max(block_max);
+        for (; i < last; ++i)
+            block_distance = std::max(
+                block_distance, point_distance_squared(points[i], center));
+
+        if (block_distance <= best_distance)
+            continue;
+
+        best = farthest_in_range(points, block, last, center, &best_distance);
+    }
+
+    *max_distance_squared = best_distance;
+    return best;
+}
+
+#else /* V8_MATH_SIMD_ENABLED */
+
+void compute_bounds(const point_array& points, float* min_pt, float* max_pt) {
+    for (int axis = 0; axis < 3; ++axis)
+        min_pt[axis] = max_pt[axis] = points[0][axis];
+
+    for (size_t i = 1; i < points.size(); ++i) {
+        const float* pt = points[i];
+        for (int axis = 0; axis < 3; ++axis) {
+            min_pt[axis] = std::min(min_pt[axis], pt[axis]);
+            max_pt[axis] = std::max(max_pt[axis], pt[axis]);
+        }
+    }
+}
+
+void sum_points(const point_array& points, double* sum) {
+    sum[0] = sum[1] = sum[2] = 0.0;
+    for (size_t i = 0; i < points.size(); ++i) {
+        sum[0] += points[i][0];
+        sum[1] += points[i][1];
+        sum[2] += points[i][2];
+    }
+}
+
+size_t farthest_point(
+    const point_array&  points,
+    const float*        center,
+    float*              max_distance_squared
+    ) {
+    return farthest_in_range(points, 0, points.size(), center, max_distance_squared);
+}
+
+#endif /* V8_MATH_SIMD_ENABLED */
+
+//
+// Minimum enclosing ball of a small set of points, in double precision.
+// Welzl's algorithm, with the move to front heuristic and Gartner's
+// support set computation : the ball of the support points is the
+// smallest ball with all of them on its boundary, and its center lies in
+// their affine hull.
+class miniball {
+public :
+    struct point_t {
+        double  pt_coords[3];
+    };
+
+    explicit miniball(std::vector<point_t>* points)
+        :       points_(points)
+            ,   support_count_(0)
+            ,   radius_squared_(-1.0)
+    {
+        center_[0] = center_[1] = center_[2] = 0.0;
+    }
+
+    void compute() {
+        support_count_ = 0;
+        radius_squared_ = -1.0;
+        move_to_front(points_->size());
+    }
+
+    const double* center() const {
+        return center_;
+    }
+
+    double radius_squared() const {
+        return radius_squared_;
+    }
+
+private :
+    static double distance_squared(const double* a, const double* b) {
+        const double dx = a[0] - b[0];
+        const double dy = a[1] - b[1];
+        const double dz = a[2] - b[2];
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    bool is_outside(const point_t& pt) const {
+        return distance_squared(pt.pt_coords, center_) - radius_squared_
+               > radius_squared_ * 1.0e-12;
+    }
+
+    void move_to_front(size_t end) {
+        if (support_count_ == 4)
+            return;
+
+        std::vector<point_t>& pts = *points_;
+        for (size_t i = 0; i < end; ++i) {
+            if (!is_outside(pts[i]) || !push(pts[i]))
+                continue;
+
+            move_to_front(i);
+            --support_count_;
+            std::rotate(pts.begin(), pts.begin() + i, pts.begin() + i + 1);
+        }
+    }
+
+    //
+    // Adds a support point and computes the ball through all the support
+    // points; fails (leaving the ball unchanged) if they are affinely
+    // dependent.
+    bool push(const point_t& pt) {
+        support_[support_count_] = pt;
+        const int count = support_count_ + 1;
+        const double* origin = support_[0].pt_coords;
+
+        if (count == 1) {
+            for (int i = 0; i < 3; ++i)
+                center_[i] = origin[i];
+            radius_squared_ = 0.0;
+            support_count_ = count;
+            return true;
+        }
+
+        //
+        // center = origin + sum(lambda_i * v_i), with v_i = s_i - origin;
+        // equal distances to origin and s_i give
+        // sum_j(2 * (v_i . v_j) * lambda_j) = v_i . v_i.
+        const int n = count - 1;
+        double v[3][3];
+        double a[3][4];
+        double scale = 0.0;
+        for (int i = 0; i < n; ++i) {
+            for (int k = 0; k < 3; ++k)
+                v[i][k] = support_[i + 1].pt_coords[k] - origin[k];
+        }
+
+        for (int i = 0; i < n; ++i) {
+            for (int j = 0; j < n; ++j) {
+                a[i][j] = 2.0 * (v[i][0] * v[j][0] + v[i][1] * v[j][1]
+                                 + v[i][2] * v[j][2]);
+                scale = std::max(scale, std::fabs(a[i][j]));
+            }
+            a[i][n] = 0.5 * a[i][i];
+        }
+
+        //
+        // Gaussian elimination, with partial pivoting.
+        for (int col = 0; col < n; ++col) {
+            int pivot = col;
+            for (int row = col + 1; row < n; ++row) {
+                if (std::fabs(a[row][col]) > std::fabs(a[pivot][col]))
+                    pivot = row;
+            }
+
+            if (std::fabs(a[pivot][col]) <= scale * 1.0e-12)
+                return false;
+
+            if (pivot != col) {
+                for (int k = 0; k <= n; ++k)
+                    std::swap(a[pivot][k], a[col][k]);
+            }
+
+            for (int row = col + 1; row < n; ++row) {
+                const double factor = a[row][col] / a[col][col];
+                for (int k = col; k <= n; ++k)
+                    a[row][k] -= factor * a[col][k];
+            }
+        }
+
+        double lambda[3];
+        for (int row = n - 1; row >= 0; --row) {
+            double val = a[row][n];
+            for (int k = row + 1; k < n; ++k)
+                val -= a[row][k] * lambda[k];
+            lambda[row] = val / a[row][row];
+        }
+
+        for (int k = 0; k < 3; ++k) {
+            center_[k] = origin[k];
+            for (int i = 0; i < n; ++i)
+                center_[k] += lambda[i] * v[i][k];
+        }
+
+        radius_squared_ = distance_squared(center_, origin);
+        support_count_ = count;
+        return true;
+    }
+
+    std::vector<point_t>*   points_;
+    point_t                 support_[4];
+    int                     support_count_;
+    double                  center_[3];
+    double                  radius_squared_;
+};
+
+inline void set_sphere(
+    const float* center, float radius, v8::math::sphereF* bounding_sphere
+    ) {
+    bounding_sphere->center_ = v8::math::vector3F(center[0], center[1], center[2]);
+    bounding_sphere->radius_ = radius;
+}
+
+//
+// The sphere of an empty set of points.
+inline void set_empty_sphere(v8::math::sphereF* bounding_sphere) {
+    const float origin[3] = { 0.0f, 0.0f, 0.0f };
+    set_sphere(origin, 0.0f, bounding_sphere);
+}
+
+inline miniball::point_t to_double(const float* pt) {
+    miniball::point_t result = { { pt[0], pt[1], pt[2] } };
+    return result;
+}
+
+} // anonymous namespace
+
+void v8::math::sphere_from_points_by_aabb(
+    const vector3F*         pt_set,
+    size_t                  pt_count,
+    size_t                  pt_stride,
+    sphereF*                bounding_sphere
+    ) {
+    const point_array points(pt_set, pt_count, pt_stride);
+
+    float min_pt[3];
+    float max_pt[3];
+    compute_bounds(points, min_pt, max_pt);
+
+    const vector3F min_vec(min_pt[0], min_pt[1], min_pt[2]);
+    const vector3F max_vec(max_pt[0], max_pt[1], max_pt[2]);
+    bounding_sphere->center_ = 0.5f * (max_vec + min_vec);
+    bounding_sphere->radius_ = (0.5f * (max_vec - min_vec)).magnitude();
+}
+
+void v8::math::sphere_from_points_by_average(
+    const vector3F*         pt_set,
+    size_t                  pt_count,
+    size_t                  pt_stride,
+    sphereF*                bounding_sphere
+    ) {
+    if (!pt_count) {
+        set_empty_sphere(bounding_sphere);
+        return;
+    }
+
+    const point_array points(pt_set, pt_count, pt_stride);
+
+    double sum[3];
+    sum_points(points, sum);
+
+    const double inv_count = 1.0 / static_cast<double>(pt_count);
+    const float center[3] = {
+        static_cast<float>(sum[0] * inv_count),
+        static_cast<float>(sum[1] * inv_count),
+        static_cast<float>(sum[2] * inv_count)
+    };
+
+    float radius_squared;
+    farthest_point(points, center, &radius_squared);
+    set_sphere(center, std::sqrt(radius_squared), bounding_sphere);
+}
+
+void v8::math::sphere_from_points_ritter(
+    const vector3F*         pt_set,
+    size_t                  pt_count,
+    size_t                  pt_stride,
+    sphereF*                bounding_sphere
+    ) {
+    if (!pt_count) {
+        set_empty_sphere(bounding_sphere);
+        return;
+    }
+
+    const point_array points(pt_set, pt_count, pt_stride);
+
+    float dist_squared;
+    const float* a = points[farthest_point(points, points[0], &dist_squared)];
+    const float* b = points[farthest_point(points, a, &dist_squared)];
+
+    float center[3];
+    for (int i = 0; i < 3; ++i)
+        center[i] = 0.5f * (a[i] + b[i]);
+    float radius = 0.5f * std::sqrt(dist_squared);
+
+    //
+    // Moves the sphere towards a point outside it, just enough to enclose
+    // it along with the sphere.
+    auto grow = [&center, &radius](const float* pt, float pt_dist_squared) {
+        const float dist = std::sqrt(pt_dist_squared);
+        const float new_radius = 0.5f * (radius + dist);
+        const float shift = (new_radius - radius) / dist;
+        for (int i = 0; i < 3; ++i)
+            center[i] += (pt[i] - center[i]) * shift;
+        radius = new_radius;
+    };
+
+    bool contained = false;
+    for (size_t pass = 0; pass < k_max_ritter_passes && !contained; ++pass) {
+        const size_t farthest = farthest_point(points, center, &dist_squared);
+        contained = dist_squared <= radius * radius * (1.0f + k_radius_tolerance);
+        if (!contained)
+            grow(points[farthest], dist_squared);
+    }
+
+    if (!contained) {
+        for (size_t i = 0; i < pt_count; ++i) {
+            const float pt_dist_squared = point_distance_squared(points[i], center);
+            if (pt_dist_squared > radius * radius)
+                grow(points[i], pt_dist_squared);
+        }
+        farthest_point(points, center, &dist_squared);
+    }
+
+    set_sphere(center, std::max(radius, std::sqrt(dist_squared)), bounding_sphere);
+}
+
+void v8::math::sphere_from_points_minimal(
+    const vector3F*         pt_set,
+    size_t                  pt_count,
+    size_t                  pt_stride,
+    sphereF*                bounding_sphere
+    ) {
+    if (!pt_count) {
+        set_empty_sphere(bounding_sphere);
+        return;
+    }
+
+    const point_array points(pt_set, pt_count, pt_stride);
+
+    float dist_squared;
+    const size_t a = farthest_point(points, points[0], &dist_squared);
+    const size_t b = farthest_point(points, points[a], &dist_squared);
+
+    std::vector<miniball::point_t> subset;
+    subset.reserve(32);
+    subset.push_back(to_double(points[a]));
+    subset.push_back(to_double(points[b]));
+
+    miniball ball(&subset);
+    float center[3];
+    float radius_squared;
+
+    for (;;) {
+        ball.compute();
+        for (int i = 0; i < 3; ++i)
+            center[i] = static_cast<float>(ball.center()[i]);
+        radius_squared = static_cast<float>(ball.radius_squared());
+
+        const size_t farthest = farthest_point(points, center, &dist_squared);
+        if (dist_squared <= radius_squared * (1.0f + k_radius_tolerance) ||
+            subset.size() == k_max_support_subset)
+            break;
+
+        subset.insert(subset.begin(), to_double(points[farthest]));
+    }
+
+    set_sphere(center, std::sqrt(std::max(radius_squared, dist_squared)),
+               bounding_sphere);
+}
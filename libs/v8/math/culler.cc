@@ -3,13 +3,119 @@
 #include <v8/math/camera.hpp>
 #include <v8/math/containment/bounded_volume.hpp>
 #include <v8/math/culling/culler.hpp>
+#include <v8/math/simd/float4.hpp>
+
+#if defined(V8_COMPILER_IS_MSVC)
+#include <intrin.h>
+#endif
 
 inline uint32_t set_bit(uint32_t val, int bit, bool bit_val) {
-    uint32_t high = val & (0xffffffff << (32 - bit - 1));
-    uint32_t low = val & (0xffffffff >> (32 - bit));
-    return low | high | ((uint32_t)(bit_val) << bit);
+    const uint32_t bit_mask = 1U << bit;
+    return bit_val ? (val | bit_mask) : (val & ~bit_mask);
 }
 
+namespace {
+
+inline v8_uint32_t lowest_set_bit(v8_uint32_t word) {
+#if defined(V8_COMPILER_IS_MSVC)
+    unsigned long bit_idx;
+    _BitScanForward(&bit_idx, word);
+    return bit_idx;
+#else
+    return static_cast<v8_uint32_t>(__builtin_ctz(word));
+#endif
+}
+
+/**
+ * \brief Plane equation coefficients, broadcast to all lanes.
+ */
+struct splat_plane_t {
+    v8::math::simd::float4_t    sp_nx;
+    v8::math::simd::float4_t    sp_ny;
+    v8::math::simd::float4_t    sp_nz;
+    v8::math::simd::float4_t    sp_offset;
+    v8_uint32_t                 sp_id;
+};
+
+/**
+ * \brief Active planes, in the order they are tested.
+ */
+struct cull_plane_set_t {
+    splat_plane_t   cps_planes[32];
+    v8_uint32_t     cps_count;
+
+    cull_plane_set_t(
+        const v8::math::plane3F*    planes,
+        v8_uint32_t                 plane_count,
+        v8_uint32_t                 active_planes
+        ) : cps_count(0) {
+        using namespace v8::math::simd;
+
+        for (v8_uint32_t i = 0; i < plane_count; ++i) {
+            if (!(active_planes & (1U << i)))
+                continue;
+
+            splat_plane_t& sp = cps_planes[cps_count++];
+            sp.sp_nx = splat_float4(planes[i].normal_.x_);
+            sp.sp_ny = splat_float4(planes[i].normal_.y_);
+            sp.sp_nz = splat_float4(planes[i].normal_.z_);
+            sp.sp_offset = splat_float4(planes[i].offset_);
+            sp.sp_id = i;
+        }
+    }
+};
+
+inline bool plane_is_active(
+    v8_uint8_t plane_id, v8_uint32_t plane_count, v8_uint32_t active_planes
+    ) {
+    return plane_id < plane_count && (active_planes & (1U << plane_id));
+}
+
+/**
+ * \brief Loads up to four consecutive values. Missing lanes are set to 0.
+ */
+inline v8::math::simd::float4_t load_partial(
+    const float* src, v8_size_t count
+    ) {
+    float values[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (v8_size_t i = 0; i < count; ++i)
+        values[i] = src[i];
+    return v8::math::simd::load_float4(values);
+}
+
+/**
+ * \brief Records the plane that culled each lane in newly_culled.
+ */
+inline void update_plane_cache(
+    v8_uint8_t* plane_cache, v8_int_t newly_culled, v8_uint32_t plane_id
+    ) {
+    if (!plane_cache)
+        return;
+
+    for (v8_int_t lane = 0; lane < 4; ++lane) {
+        if (newly_culled & (1 << lane))
+            plane_cache[lane] = static_cast<v8_uint8_t>(plane_id);
+    }
+}
+
+/**
+ * \brief Stores the visibility bits of a group of four objects.
+ */
+inline v8_size_t store_visibility(
+    v8_uint32_t* visible_mask, v8_size_t first_obj, v8_int_t visible_lanes
+    ) {
+    const v8_size_t word = first_obj / 32;
+    const v8_uint32_t shift = static_cast<v8_uint32_t>(first_obj % 32);
+    if (!shift)
+        visible_mask[word] = 0;
+    visible_mask[word] |= static_cast<v8_uint32_t>(visible_lanes) << shift;
+
+    return (visible_lanes & 1) + ((visible_lanes >> 1) & 1)
+           + ((visible_lanes >> 2) & 1) + ((visible_lanes >> 3) & 1);
+}
+
+} // anonymous namespace
+
 v8::math::culler::culler()
     : active_planes_(0), plane_count_(6) {}
 
@@ -23,6 +129,187 @@ bool v8::math::culler::cull(const bounded_volume* bound_object) const {
     return false;
 }
 
+v8_size_t v8::math::culler::cull_spheres(
+    const bounding_sphere_soa_t&    spheres,
+    v8_uint8_t*                     plane_cache,
+    v8_uint32_t*                    visible_mask
+    ) const {
+    using namespace simd;
+
+    const cull_plane_set_t plane_set(cull_plane_stack_, plane_count_, 
+                                     active_planes_);
+    v8_size_t visible_count = 0;
+
+    for (v8_size_t obj = 0; obj < spheres.bs_count; obj += 4) {
+        const v8_size_t lanes = min<v8_size_t>(4, spheres.bs_count - obj);
+        const v8_int_t valid_lanes = (1 << lanes) - 1;
+
+        float4_t cx, cy, cz, neg_r;
+        if (lanes == 4) {
+            cx = load_float4(spheres.bs_center_x + obj);
+            cy = load_float4(spheres.bs_center_y + obj);
+            cz = load_float4(spheres.bs_center_z + obj);
+            neg_r = negate(load_float4(spheres.bs_radius + obj));
+        } else {
+            cx = load_partial(spheres.bs_center_x + obj, lanes);
+            cy = load_partial(spheres.bs_center_y + obj, lanes);
+            cz = load_partial(spheres.bs_center_z + obj, lanes);
+            neg_r = negate(load_partial(spheres.bs_radius + obj, lanes));
+        }
+
+        v8_int_t culled = ~valid_lanes & 0xF;
+
+        //
+        // Planes that culled the objects in the previous call go first.
+        if (plane_cache) {
+            for (v8_size_t lane = 0; lane < lanes; ++lane) {
+                const v8_uint8_t plane_id = plane_cache[obj + lane];
+                if (!plane_is_active(plane_id, plane_count_, active_planes_))
+                    continue;
+
+                const plane3F& P = cull_plane_stack_[plane_id];
+                const v8_size_t idx = obj + lane;
+                const float dist = P.normal_.x_ * spheres.bs_center_x[idx]
+                                   + P.normal_.y_ * spheres.bs_center_y[idx]
+                                   + P.normal_.z_ * spheres.bs_center_z[idx]
+                                   + P.offset_;
+                if (dist < -spheres.bs_radius[idx])
+                    culled |= 1 << lane;
+            }
+        }
+
+        for (v8_uint32_t i = 0; (i < plane_set.cps_count) && (culled != 0xF); 
+             ++i) {
+            const splat_plane_t& P = plane_set.cps_planes[i];
+            const float4_t dist = add(add(add(mul(P.sp_nx, cx), 
+                                              mul(P.sp_ny, cy)),
+                                          mul(P.sp_nz, cz)),
+                                      P.sp_offset);
+            const v8_int_t plane_culled = move_mask(cmp_lt(dist, neg_r));
+            update_plane_cache(plane_cache ? plane_cache + obj : nullptr,
+                               plane_culled & ~culled, P.sp_id);
+            culled |= plane_culled;
+        }
+
+        visible_count += store_visibility(visible_mask, obj, 
+                                          ~culled & valid_lanes);
+    }
+
+    return visible_count;
+}
+
+v8_size_t v8::math::culler::cull_boxes(
+    const bounding_box_soa_t&       boxes,
+    v8_uint8_t*                     plane_cache,
+    v8_uint32_t*                    visible_mask
+    ) const {
+    using namespace simd;
+
+    const cull_plane_set_t plane_set(cull_plane_stack_, plane_count_, 
+                                     active_planes_);
+    v8_size_t visible_count = 0;
+
+    for (v8_size_t obj = 0; obj < boxes.bb_count; obj += 4) {
+        const v8_size_t lanes = min<v8_size_t>(4, boxes.bb_count - obj);
+        const v8_int_t valid_lanes = (1 << lanes) - 1;
+
+        v8_int_t culled = ~valid_lanes & 0xF;
+
+        if (plane_cache) {
+            for (v8_size_t lane = 0; lane < lanes; ++lane) {
+                const v8_uint8_t plane_id = plane_cache[obj + lane];
+                if (!plane_is_active(plane_id, plane_count_, active_planes_))
+                    continue;
+
+                //
+                // Test the box vertex that is farthest along the plane's 
+                // normal. If it is on the negative side, so is the box.
+                const plane3F& P = cull_plane_stack_[plane_id];
+                const v8_size_t idx = obj + lane;
+                const float px = P.normal_.x_ >= 0.0f ? boxes.bb_max_x[idx] 
+                                                      : boxes.bb_min_x[idx];
+                const float py = P.normal_.y_ >= 0.0f ? boxes.bb_max_y[idx] 
+                                                      : boxes.bb_min_y[idx];
+                const float pz = P.normal_.z_ >= 0.0f ? boxes.bb_max_z[idx] 
+                                                      : boxes.bb_min_z[idx];
+                if (P.normal_.x_ * px + P.normal_.y_ * py + P.normal_.z_ * pz
+                    + P.offset_ < 0.0f) {
+                    culled |= 1 << lane;
+                }
+            }
+        }
+
+        for (v8_uint32_t i = 0; (i < plane_set.cps_count) && (culled != 0xF); 
+             ++i) {
+            const splat_plane_t& SP = plane_set.cps_planes[i];
+            const plane3F& P = cull_plane_stack_[SP.sp_id];
+            //
+            // The farthest vertex along the normal is picked per plane, 
+            // by choosing the source arrays.
+            const float* src_x = 
+                (P.normal_.x_ >= 0.0f ? boxes.bb_max_x : boxes.bb_min_x) + obj;
+            const float* src_y = 
+                (P.normal_.y_ >= 0.0f ? boxes.bb_max_y : boxes.bb_min_y) + obj;
+            const float* src_z = 
+                (P.normal_.z_ >= 0.0f ? boxes.bb_max_z : boxes.bb_min_z) + obj;
+
+            float4_t px, py, pz;
+            if (lanes == 4) {
+                px = load_float4(src_x);
+                py = load_float4(src_y);
+                pz = load_float4(src_z);
+            } else {
+                px = load_partial(src_x, lanes);
+                py = load_partial(src_y, lanes);
+                pz = load_partial(src_z, lanes);
+            }
+
+            const float4_t dist = add(add(add(mul(SP.sp_nx, px), 
+                                              mul(SP.sp_ny, py)),
+                                          mul(SP.sp_nz, pz)),
+                                      SP.sp_offset);
+            const v8_int_t plane_culled = move_mask(cmp_lt(dist, 
+                                                           zero_float4()));
+            update_plane_cache(plane_cache ? plane_cache + obj : nullptr,
+                               plane_culled & ~culled, SP.sp_id);
+            culled |= plane_culled;
+        }
+
+        visible_count += store_visibility(visible_mask, obj, 
+                                          ~culled & valid_lanes);
+    }
+
+    return visible_count;
+}
+
+v8_size_t v8::math::culler::compact_visible_set(
+    const v8_uint32_t*  visible_mask,
+    v8_size_t           count,
+    v8_uint32_t*        visible_indices
+    ) {
+    const v8_size_t word_count = (count + 31) / 32;
+    v8_size_t written = 0;
+
+    for (v8_size_t word = 0; word < word_count; ++word) {
+        v8_uint32_t bits = visible_mask[word];
+        if (word == word_count - 1 && (count % 32))
+            bits &= (1U << (count % 32)) - 1;
+
+        while (bits) {
+            visible_indices[written++] = 
+                static_cast<v8_uint32_t>(word * 32 + lowest_set_bit(bits));
+            bits &= bits - 1;
+        }
+    }
+
+    return written;
+}
+
+void v8::math::culler::toggle_plane_state(int plane_id, bool status) {
+    assert(plane_id > 5 && plane_id < static_cast<int>(C_Max_Cull_Planes));
+    active_planes_ = set_bit(active_planes_, plane_id, status);
+}
+
 void v8::math::culler::pop_plane() {
     if (plane_count_ > 6) {
         --plane_count_;
@@ -30,6 +317,17 @@ void v8::math::culler::pop_plane() {
     }
 }
 
+v8_uint32_t v8::math::culler::get_active_planes(
+    v8::math::plane3F* planes
+    ) const {
+    v8_uint32_t active_count = 0;
+    for (uint32_t i = 0; i < plane_count_; ++i) {
+        if (active_planes_ & (1 << i))
+            planes[active_count++] = cull_plane_stack_[i];
+    }
+    return active_count;
+}
+
 void v8::math::culler::set_camera(const v8::math::camera* cam) {
     assert(cam);
     cam_ = cam;
@@ -0,0 +1,338 @@
+#include "pch_hdr.hpp"
+
+#include <memory>
+
+#include <v8/math/simd/float4.hpp>
+#include <v8/math/dense_kernels.hpp>
+
+#if defined(V8_MATH_SIMD_ENABLED)
+
+namespace {
+
+using v8::math::simd::float4_t;
+
+//
+// Register tile of c : 4 rows x 8 columns (8 accumulators).
+const size_t k_tile_rows = 4;
+const size_t k_tile_columns = 8;
+
+//
+// Cache blocking : a k_block_inner x k_tile_columns strip of b (8 KB)
+// stays in L1, a k_block_rows x k_block_inner block of a (96 KB) in L2 and
+// a k_block_inner x k_block_columns panel of b (512 KB) in L3.
+const size_t k_block_inner = 256;
+const size_t k_block_rows = 96;
+const size_t k_block_columns = 512;
+
+inline size_t round_up(size_t val, size_t multiple) {
+    return (val + multiple - 1) / multiple * multiple;
+}
+
+//
+// Copies a depth x width block of b into strips of k_tile_columns columns;
+// each strip stores its rows contiguously. Missing columns are zero.
+void pack_b(
+    const float*    b,
+    size_t          ldb,
+    size_t          depth,
+    size_t          width,
+    float*          packed
+    ) {
+    for (size_t j = 0; j < width; j += k_tile_columns) {
+        const size_t strip_width = std::min(k_tile_columns, width - j);
+
+        for (size_t k = 0; k < depth; ++k) {
+            const float* src = b + k * ldb + j;
+            size_t col = 0;
+            for (; col < strip_width; ++col)
+                packed[col] = src[col];
+            for (; col < k_tile_columns; ++col)
+                packed[col] = 0.0f;
+            packed += k_tile_columns;
+        }
+    }
+}
+
+//
+// Copies a height x depth block of a into strips of k_tile_rows rows; for
+// each k, the elements of the strip's rows are stored contiguously.
+// Missing rows are zero.
+void pack_a(
+    const float*    a,
+    size_t          lda,
+    size_t          height,
+    size_t          depth,
+    float*          packed
+    ) {
+    for (size_t i = 0; i < height; i += k_tile_rows) {
+        const size_t strip_height = std::min(k_tile_rows, height - i);
+
+        for (size_t k = 0; k < depth; ++k) {
+            size_t row = 0;
+            for (; row < strip_height; ++row)
+                packed[row] = a[(i + row) * lda + k];
+            for (; row < k_tile_rows; ++row)
+                packed[row] = 0.0f;
+            packed += k_tile_rows;
+        }
+    }
+}
+
+//
+// c[4 x 8] += packed_a[4 x depth] * packed_b[depth x 8]. Only the first
+// height rows and width columns of the tile are written.
+void multiply_tile(
+    const float*    packed_a,
+    const float*    packed_b,
+    size_t          depth,
+    float*          c,
+    size_t          ldc,
+    size_t          height,
+    size_t          width
+    ) {
+    using namespace v8::math::simd;
+
+    float4_t c00 = zero_float4(), c01 = zero_float4();
+    float4_t c10 = zero_float4(), c11 = zero_float4();
+    float4_t c20 = zero_float4(), c21 = zero_float4();
+    float4_t c30 = zero_float4(), c31 = zero_float4();
+
+    for (size_t k = 0; k < depth; ++k) {
+        const float4_t b0 = load_float4(packed_b);
+        const float4_t b1 = load_float4(packed_b + 4);
+
+        const float4_t a0 = splat_float4(packed_a[0]);
+        c00 = add(c00, mul(a0, b0));
+        c01 = add(c01, mul(a0, b1));
+
+        const float4_t a1 = splat_float4(packed_a[1]);
+        c10 = add(c10, mul(a1, b0));
+        c11 = add(c11, mul(a1, b1));
+
+        const float4_t a2 = splat_float4(packed_a[2]);
+        c20 = add(c20, mul(a2, b0));
+        c21 = add(c21, mul(a2, b1));
+
+        const float4_t a3 = splat_float4(packed_a[3]);
+        c30 = add(c30, mul(a3, b0));
+        c31 = add(c31, mul(a3, b1));
+
+        packed_a += k_tile_rows;
+        packed_b += k_tile_columns;
+    }
+
+    if (height == k_tile_rows && width == k_tile_columns) {
+        float* c0 = c;
+        float* c1 = c + ldc;
+        float* c2 = c + 2 * ldc;
+        float* c3 = c + 3 * ldc;
+        store_float4(c0, add(load_float4(c0), c00));
+        store_float4(c0 + 4, add(load_float4(c0 + 4), c01));
+        store_float4(c1, add(load_float4(c1), c10));
+        store_float4(c1 + 4, add(load_float4(c1 + 4), c11));
+        store_float4(c2, add(load_float4(c2), c20));
+        store_float4(c2 + 4, add(load_float4(c2 + 4), c21));
+        store_float4(c3, add(load_float4(c3), c30));
+        store_float4(c3 + 4, add(load_float4(c3 + 4), c31));
+        return;
+    }
+
+    float tile[k_tile_rows * k_tile_columns];
+    store_float4(tile, c00);
+    store_float4(tile + 4, c01);
+    store_float4(tile + 8, c10);
+    store_float4(tile + 12, c11);
+    store_float4(tile + 16, c20);
+    store_float4(tile + 20, c21);
+    store_float4(tile + 24, c30);
+    store_float4(tile + 28, c31);
+
+    for (size_t i = 0; i < height; ++i) {
+        for (size_t j = 0; j < width; ++j)
+            c[i * ldc + j] += tile[i * k_tile_columns + j];
+    }
+}
+
+void multiply_rows(
+    const float*    a,
+    const float*    b,
+    float*          c,
+    size_t          inner,
+    size_t          columns,
+    size_t          row_first,
+    size_t          row_last
+    ) {
+    for (size_t i = row_first; i < row_last; ++i)
+        memset(c + i * columns, 0, columns * sizeof(float));
+
+    const size_t rows = row_last - row_first;
+    const size_t block_inner = std::min(k_block_inner, inner);
+    const size_t block_rows = std::min(k_block_rows, rows);
+    const size_t block_columns = std::min(k_block_columns, columns);
+
+    std::unique_ptr<float[]> packed_a(
+        new float[round_up(block_rows, k_tile_rows) * block_inner]);
+    std::unique_ptr<float[]> packed_b(
+        new float[block_inner * round_up(block_columns, k_tile_columns)]);
+
+    for (size_t jc = 0; jc < columns; jc += k_block_columns) {
+        const size_t width = std::min(k_block_columns, columns - jc);
+
+        for (size_t pc = 0; pc < inner; pc += k_block_inner) {
+            const size_t depth = std::min(k_block_inner, inner - pc);
+            pack_b(b + pc * columns + jc, columns, depth, width, packed_b.get());
+
+            for (size_t ic = row_first; ic < row_last; ic += k_block_rows) {
+                const size_t height = std::min(k_block_rows, row_last - ic);
+                pack_a(a + ic * inner + pc, inner, height, depth, packed_a.get());
+
+                for (size_t jr = 0; jr < width; jr += k_tile_columns) {
+                    const float* strip_b = packed_b.get() + jr * depth;
+
+                    for (size_t ir = 0; ir < height; ir += k_tile_rows) {
+                        multiply_tile(
+                            packed_a.get() + ir * depth, strip_b, depth,
+                            c + (ic + ir) * columns + jc + jr, columns,
+                            std::min(k_tile_rows, height - ir),
+                            std::min(k_tile_columns, width - jr));
+                    }
+                }
+            }
+        }
+    }
+}
+
+inline float dot_row(const float* a_row, const float* x, size_t columns) {
+    using namespace v8::math::simd;
+
+    float4_t acc = zero_float4();
+    size_t j = 0;
+    for (; j + 4 <= columns; j += 4)
+        acc = add(acc, mul(load_float4(a_row + j), load_float4(x + j)));
+
+    float sum = (extract_lane<0>(acc) + extract_lane<1>(acc))
+        + (extract_lane<2>(acc) + extract_lane<3>(acc));
+    for (; j < columns; ++j)
+        sum += a_row[j] * x[j];
+    return sum;
+}
+
+//
+// Four rows at a time : x is loaded once for the four dot products, which
+// are reduced together with a transpose.
+void matrix_vector_rows(
+    const float*    a,
+    const float*    x,
+    float*          y,
+    size_t          columns,
+    size_t          row_first,
+    size_t          row_last
+    ) {
+    using namespace v8::math::simd;
+
+    size_t i = row_first;
+    for (; i + 4 <= row_last; i += 4) {
+        const float* a0 = a + i * columns;
+        const float* a1 = a0 + columns;
+        const float* a2 = a1 + columns;
+        const float* a3 = a2 + columns;
+
+        float4_t acc0 = zero_float4();
+        float4_t acc1 = zero_float4();
+        float4_t acc2 = zero_float4();
+        float4_t acc3 = zero_float4();
+
+        size_t j = 0;
+        for (; j + 4 <= columns; j += 4) {
+            const float4_t xj = load_float4(x + j);
+            acc0 = add(acc0, mul(load_float4(a0 + j), xj));
+            acc1 = add(acc1, mul(load_float4(a1 + j), xj));
+            acc2 = add(acc2, mul(load_float4(a2 + j), xj));
+            acc3 = add(acc3, mul(load_float4(a3 + j), xj));
+        }
+
+        transpose(acc0, acc1, acc2, acc3);
+        float sums[4];
+        store_float4(sums, add(add(acc0, acc1), add(acc2, acc3)));
+
+        for (; j < columns; ++j) {
+            sums[0] += a0[j] * x[j];
+            sums[1] += a1[j] * x[j];
+            sums[2] += a2[j] * x[j];
+            sums[3] += a3[j] * x[j];
+        }
+
+        y[i] = sums[0];
+        y[i + 1] = sums[1];
+        y[i + 2] = sums[2];
+        y[i + 3] = sums[3];
+    }
+
+    for (; i < row_last; ++i)
+        y[i] = dot_row(a + i * columns, x, columns);
+}
+
+} // anonymous namespace
+
+void v8::math::dense_matrix_multiply(
+    const float*        a,
+    const float*        b,
+    float*              c,
+    size_t              rows,
+    size_t              inner,
+    size_t              columns,
+    base::job_system*   jobs
+    ) {
+    internals::run_dense_rows(jobs, rows, inner * columns,
+        [=](size_t first, size_t last) {
+        multiply_rows(a, b, c, inner, columns, first, last);
+    });
+}
+
+void v8::math::dense_matrix_vector_multiply(
+    const float*        a,
+    const float*        x,
+    float*              y,
+    size_t              rows,
+    size_t              columns,
+    base::job_system*   jobs
+    ) {
+    internals::run_dense_rows(jobs, rows, columns,
+        [=](size_t first, size_t last) {
+        matrix_vector_rows(a, x, y, columns, first, last);
+    });
+}
+
+#else /* V8_MATH_SIMD_ENABLED */
+
+void v8::math::dense_matrix_multiply(
+    const float*        a,
+    const float*        b,
+    float*              c,
+    size_t              rows,
+    size_t              inner,
+    size_t              columns,
+    base::job_system*   jobs
+    ) {
+    internals::run_dense_rows(jobs, rows, inner * columns,
+        [=](size_t first, size_t last) {
+        internals::dense_matrix_multiply_rows(
+            a, b, c, inner, columns, first, last);
+    });
+}
+
+void v8::math::dense_matrix_vector_multiply(
+    const float*        a,
+    const float*        x,
+    float*              y,
+    size_t              rows,
+    size_t              columns,
+    base::job_system*   jobs
+    ) {
+    internals::run_dense_rows(jobs, rows, columns,
+        [=](size_t first, size_t last) {
+        internals::dense_matrix_vector_rows(a, x, y, columns, first, last);
+    });
+}
+
+#endif /* V8_MATH_SIMD_ENABLED */
@@ -5,15 +5,83 @@
 
 namespace {
 
-void subdivide_geometry(v8::math::geometry_gen::mesh_data_t* mesh_data) {
-    // Save a copy of the input geometry.
-    using namespace v8::math::geometry_gen;
-    using namespace v8::math;
+//
+// Maps an undirected edge (pair of vertex indices) to the index of the vertex
+// generated at its midpoint, so that triangles sharing an edge also share the
+// midpoint vertex. Open addressing with linear probing; the table is sized
+// once per subdivision level from the known edge count and never rehashes.
+class edge_midpoint_cache {
+public :
+    edge_midpoint_cache() : mask_(0) {}
+
+    void reset(size_t edge_count) {
+        size_t capacity = 16;
+        while (capacity < edge_count * 2)
+            capacity <<= 1;
+
+        mask_ = capacity - 1;
+        keys_.assign(capacity, C_Empty_Key);
+        values_.resize(capacity);
+    }
 
-    mesh_data_t input_copy = *mesh_data;
+    //
+    // Returns true and stores the cached vertex index in *vertex_index if the
+    // edge was seen before. Otherwise inserts new_index and returns false.
+    bool find_or_insert(
+        uint32_t v0, uint32_t v1, uint32_t new_index, uint32_t* vertex_index
+        ) {
+        const uint64_t key = v0 < v1 ?
+            (static_cast<uint64_t>(v0) << 32) | v1 :
+            (static_cast<uint64_t>(v1) << 32) | v0;
+
+        size_t slot = hash(key) & mask_;
+        for (;;) {
+            if (keys_[slot] == key) {
+                *vertex_index = values_[slot];
+                return true;
+            }
+
+            if (keys_[slot] == C_Empty_Key) {
+                keys_[slot] = key;
+                values_[slot] = new_index;
+                *vertex_index = new_index;
+                return false;
+            }
+
+            slot = (slot + 1) & mask_;
+        }
+    }
+
+private :
+    static const uint64_t C_Empty_Key = ~static_cast<uint64_t>(0);
+
+    static size_t hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdULL;
+        key ^= key >> 33;
+        return static_cast<size_t>(key);
+    }
 
-    mesh_data->md_vertices.resize(0);
-    mesh_data->md_indices.resize(0);
+    std::vector<uint64_t>   keys_;
+    std::vector<uint32_t>   values_;
+    size_t                  mask_;
+};
+
+const uint64_t edge_midpoint_cache::C_Empty_Key;
+
+//
+// Splits every triangle of a closed mesh into four. Midpoint vertices are
+// appended to the existing position buffer and shared between the two 
+// triangles adjacent to an edge, so a closed mesh with V vertices and F faces
+// grows to V + 3F/2 vertices. Only positions are subdivided, the other
+// vertex components are derived from them in create_geosphere.
+void subdivide_geometry(
+    std::vector<v8::math::vector3F>* positions,
+    std::vector<uint32_t>* indices,
+    edge_midpoint_cache* edge_cache,
+    std::vector<uint32_t>* index_scratch
+    ) {
+    using namespace v8::math;
 
     /*
            v1
@@ -27,63 +95,54 @@ void subdivide_geometry(v8::math::geometry_gen::mesh_data_t* mesh_data) {
      v0    m2     v2
      */
 
-    uint32_t numTris = static_cast<uint32_t>(input_copy.md_indices.size() / 3);
-    for(uint32_t i = 0; i < numTris; ++i) {
-        vertex_pntt v0 = input_copy.md_vertices[input_copy.md_indices[i * 3 + 0]];
-        vertex_pntt v1 = input_copy.md_vertices[input_copy.md_indices[i * 3 + 1]];
-        vertex_pntt v2 = input_copy.md_vertices[input_copy.md_indices[i * 3 + 2]];
-
-        //
-        // Generate the midpoints.
-        //
-
-        vertex_pntt m0, m1, m2;
-
-        // For subdivision, we just care about the position component.  We derive the other
-        // vertex_pntt components in CreateGeosphere.
-
-        m0.vt_position = vector3F(
-            0.5f*(v0.vt_position.x_ + v1.vt_position.x_),
-            0.5f*(v0.vt_position.y_ + v1.vt_position.y_),
-            0.5f*(v0.vt_position.z_ + v1.vt_position.z_));
-
-        m1.vt_position = vector3F(
-            0.5f*(v1.vt_position.x_ + v2.vt_position.x_),
-            0.5f*(v1.vt_position.y_ + v2.vt_position.y_),
-            0.5f*(v1.vt_position.z_ + v2.vt_position.z_));
-
-        m2.vt_position = vector3F(
-            0.5f*(v0.vt_position.x_ + v2.vt_position.x_),
-            0.5f*(v0.vt_position.y_ + v2.vt_position.y_),
-            0.5f*(v0.vt_position.z_ + v2.vt_position.z_));
-
-        //
-        // Add new geometry.
-        //
-
-        mesh_data->md_vertices.push_back(v0); // 0
-        mesh_data->md_vertices.push_back(v1); // 1
-        mesh_data->md_vertices.push_back(v2); // 2
-        mesh_data->md_vertices.push_back(m0); // 3
-        mesh_data->md_vertices.push_back(m1); // 4
-        mesh_data->md_vertices.push_back(m2); // 5
- 
-        mesh_data->md_indices.push_back(i*6+0);
-        mesh_data->md_indices.push_back(i*6+3);
-        mesh_data->md_indices.push_back(i*6+5);
+    const std::vector<uint32_t>& in_indices = *indices;
+    std::vector<vector3F>& vertices = *positions;
+
+    const size_t num_tris = in_indices.size() / 3;
+    edge_cache->reset(num_tris * 3 / 2);
+
+    std::vector<uint32_t>& out_indices = *index_scratch;
+    out_indices.resize(num_tris * 12);
 
-        mesh_data->md_indices.push_back(i*6+3);
-        mesh_data->md_indices.push_back(i*6+4);
-        mesh_data->md_indices.push_back(i*6+5);
+    auto midpoint = [&](uint32_t a, uint32_t b) -> uint32_t {
+        uint32_t idx;
+        const uint32_t next_idx = static_cast<uint32_t>(vertices.size());
+
+        if (!edge_cache->find_or_insert(a, b, next_idx, &idx)) {
+            const vector3F& pa = vertices[a];
+            const vector3F& pb = vertices[b];
+            const vector3F mid(
+                0.5f * (pa.x_ + pb.x_),
+                0.5f * (pa.y_ + pb.y_),
+                0.5f * (pa.z_ + pb.z_));
+
+            //
+            // Midpoints go back onto the unit sphere, so every level of
+            // subdivision makes the mesh rounder.
+            vertices.push_back(normal_of(mid));
+        }
 
-        mesh_data->md_indices.push_back(i*6+5);
-        mesh_data->md_indices.push_back(i*6+4);
-        mesh_data->md_indices.push_back(i*6+2);
+        return idx;
+    };
 
-        mesh_data->md_indices.push_back(i*6+3);
-        mesh_data->md_indices.push_back(i*6+1);
-        mesh_data->md_indices.push_back(i*6+4);
+    uint32_t* dst = &out_indices[0];
+    for (size_t i = 0; i < num_tris; ++i) {
+        const uint32_t v0 = in_indices[i * 3 + 0];
+        const uint32_t v1 = in_indices[i * 3 + 1];
+        const uint32_t v2 = in_indices[i * 3 + 2];
+
+        const uint32_t m0 = midpoint(v0, v1);
+        const uint32_t m1 = midpoint(v1, v2);
+        const uint32_t m2 = midpoint(v0, v2);
+
+        dst[0] = v0;  dst[1] = m0;  dst[2]  = m2;
+        dst[3] = m0;  dst[4] = m1;  dst[5]  = m2;
+        dst[6] = m2;  dst[7] = m1;  dst[8]  = v2;
+        dst[9] = m0;  dst[10] = v1; dst[11] = m1;
+        dst += 12;
     }
+
+    indices->swap(out_indices);
 }
 
 void generate_cylinder_top_cap(
@@ -176,6 +235,136 @@ void generate_cylinder_bottom_cap(
     }
 }
 
+//
+// Vertices and faces of an icosahedron subdivided n times, before the 
+// projection onto the sphere.
+void build_geosphere(
+    size_t subdivisions,
+    std::vector<v8::math::vector3F>* positions,
+    std::vector<uint32_t>* indices
+    ) {
+    using namespace v8::math;
+    using namespace v8::math::geometry_gen;
+
+    //
+    // Level n has 10 * 4^n + 2 vertices and 20 * 4^n triangles. Level 9 is
+    // about 2.6 million vertices / 5.2 million triangles, beyond that the
+    // vertex buffer alone goes past 500MB.
+    subdivisions = min(subdivisions, C_Max_Geosphere_Subdivisions);
+
+    // Approximate a sphere by tessellating an icosahedron.
+    const float X = 0.525731f; 
+    const float Z = 0.850651f;
+
+    const vector3F pos[12] = {
+        vector3F(-X, 0.0f, Z),  vector3F(X, 0.0f, Z),  
+        vector3F(-X, 0.0f, -Z), vector3F(X, 0.0f, -Z),    
+        vector3F(0.0f, Z, X),   vector3F(0.0f, Z, -X), 
+        vector3F(0.0f, -Z, X),  vector3F(0.0f, -Z, -X),    
+        vector3F(Z, X, 0.0f),   vector3F(-Z, X, 0.0f), 
+        vector3F(Z, -X, 0.0f),  vector3F(-Z, -X, 0.0f)
+    };
+
+    const uint32_t k[60] = {
+        1,4,0,  4,9,0,  4,5,9,  8,5,4,  1,8,4,    
+        1,10,8, 10,3,8, 8,3,5,  3,2,5,  3,7,2,    
+        3,10,7, 10,6,7, 6,11,7, 6,0,11, 6,1,0, 
+        10,1,6, 11,0,9, 2,11,9, 5,2,9,  11,2,7 
+    };
+
+    size_t final_tri_count = 20;
+    for (size_t i = 0; i < subdivisions; ++i)
+        final_tri_count *= 4;
+
+    positions->clear();
+    indices->clear();
+    positions->reserve(final_tri_count / 2 + 2);
+    indices->reserve(final_tri_count * 3);
+
+    positions->assign(pos, pos + 12);
+    indices->assign(k, k + 60);
+
+    {
+        edge_midpoint_cache edge_cache;
+        std::vector<uint32_t> index_scratch;
+        index_scratch.reserve(final_tri_count * 3);
+
+        for (size_t i = 0; i < subdivisions; ++i)
+            subdivide_geometry(positions, indices, &edge_cache, &index_scratch);
+    }
+}
+
+//
+// Computes the vertex components of the geosphere. Outputs are strided
+// (stride 0 means tightly packed), null outputs are skipped, so the same
+// code fills interleaved vertices and separate streams.
+void fill_geosphere_vertices(
+    float radius,
+    const std::vector<v8::math::vector3F>& positions,
+    size_t stride,
+    v8::math::vector3F* out_positions,
+    v8::math::vector3F* out_normals,
+    v8::math::vector3F* out_tangents,
+    v8::math::vector2F* out_texcoords
+    ) {
+    using namespace v8::math;
+
+    const size_t vec3_stride = stride ? stride : sizeof(vector3F);
+    const size_t vec2_stride = stride ? stride : sizeof(vector2F);
+
+    auto element = [](void* base, size_t step, size_t index) {
+        return static_cast<void*>(static_cast<char*>(base) + index * step);
+    };
+
+    // Project vertices onto sphere and scale.
+    for (size_t i = 0; i < positions.size(); ++i) {
+        const vector3F normal = normal_of(positions[i]);
+        const vector3F position = radius * normal;
+
+        if (out_positions)
+            *static_cast<vector3F*>(element(out_positions, vec3_stride, i)) = position;
+
+        if (out_normals)
+            *static_cast<vector3F*>(element(out_normals, vec3_stride, i)) = normal;
+
+        // Derive texture coordinates from spherical coordinates.
+        const float theta = angle_from_xy(position.x_, position.z_);
+        const float phi = acosf(std::min(std::max(normal.y_, -1.0f), 1.0f));
+
+        if (out_texcoords) {
+            vector2F& texcoord = 
+                *static_cast<vector2F*>(element(out_texcoords, vec2_stride, i));
+            texcoord.x_ = theta / numericsF::two_pi();
+            texcoord.y_ = phi / numericsF::pi();
+        }
+
+        if (out_tangents) {
+            // Partial derivative of P with respect to theta
+            vector3F& tangent = 
+                *static_cast<vector3F*>(element(out_tangents, vec3_stride, i));
+            tangent.x_ = -radius * sinf(phi) * sinf(theta);
+            tangent.y_ = 0.0f;
+            tangent.z_ = +radius * sinf(phi) * cosf(theta);
+            tangent.normalize();
+        }
+    }
+}
+
+//
+// Generators that have no streams specific implementation build the 
+// interleaved mesh, which is then split into streams.
+void split_into_streams(
+    v8::math::geometry_gen::mesh_data_t* mesh_data,
+    v8::math::geometry_gen::mesh_streams_data_t* streams_data
+    ) {
+    using namespace v8::math::geometry_gen;
+
+    streams_data->msd_vertices.deinterleave(
+        mesh_data->md_vertices.data(), vertex_pntt_layout(), 
+        mesh_data->md_vertices.size());
+    streams_data->msd_indices.swap(mesh_data->md_indices);
+}
+
 } // anonymous namespace
 
 void v8::math::geometry_gen::create_box(
@@ -378,61 +567,35 @@ void v8::math::geometry_gen::create_geosphere(
     size_t subdivisions,
     mesh_data_t* mesh_data
     ) {
-    subdivisions = clamp(subdivisions, subdivisions, size_t(5));
-
-    // Approximate a sphere by tessellating an icosahedron.
-    const float X = 0.525731f; 
-    const float Z = 0.850651f;
-
-    const vector3F pos[12] = {
-        vector3F(-X, 0.0f, Z),  vector3F(X, 0.0f, Z),  
-        vector3F(-X, 0.0f, -Z), vector3F(X, 0.0f, -Z),    
-        vector3F(0.0f, Z, X),   vector3F(0.0f, Z, -X), 
-        vector3F(0.0f, -Z, X),  vector3F(0.0f, -Z, -X),    
-        vector3F(Z, X, 0.0f),   vector3F(-Z, X, 0.0f), 
-        vector3F(Z, -X, 0.0f),  vector3F(-Z, -X, 0.0f)
-    };
-
-    const uint32_t k[60] = {
-        1,4,0,  4,9,0,  4,5,9,  8,5,4,  1,8,4,    
-        1,10,8, 10,3,8, 8,3,5,  3,2,5,  3,7,2,    
-        3,10,7, 10,6,7, 6,11,7, 6,0,11, 6,1,0, 
-        10,1,6, 11,0,9, 2,11,9, 5,2,9,  11,2,7 
-    };
-
-    mesh_data->md_vertices.resize(12);
-    mesh_data->md_indices.resize(60);
-
-    for(uint32_t i = 0; i < 12; ++i)
-        mesh_data->md_vertices[i].vt_position = pos[i];
-
-    for(uint32_t i = 0; i < 60; ++i)
-        mesh_data->md_indices[i] = k[i];
-
-    for(uint32_t i = 0; i < subdivisions; ++i)
-        subdivide_geometry(mesh_data);
-
-    // Project md_vertices onto sphere and scale.
-    for(uint32_t i = 0; i < mesh_data->md_vertices.size(); ++i) {
-        mesh_data->md_vertices[i].vt_normal = normal_of(mesh_data->md_vertices[i].vt_position);
-        mesh_data->md_vertices[i].vt_position = radius * mesh_data->md_vertices[i].vt_position;		
-
-        // Derive texture coordinates from spherical coordinates.
-        float theta = angle_from_xy(
-            mesh_data->md_vertices[i].vt_position.x_, 
-            mesh_data->md_vertices[i].vt_position.z_);
+    std::vector<vector3F> positions;
+    build_geosphere(subdivisions, &positions, &mesh_data->md_indices);
+
+    mesh_data->md_vertices.resize(positions.size());
+    if (positions.empty())
+        return;
+
+    vertex_pntt* vertices = &mesh_data->md_vertices[0];
+    fill_geosphere_vertices(
+        radius, positions, sizeof(vertex_pntt), 
+        &vertices->vt_position, &vertices->vt_normal, &vertices->vt_tangent, 
+        &vertices->vt_texcoord);
+}
 
-        float phi = acosf(mesh_data->md_vertices[i].vt_position.y_ / radius);
+void v8::math::geometry_gen::create_geosphere(
+    float radius,
+    size_t subdivisions,
+    mesh_streams_data_t* mesh_data
+    ) {
+    std::vector<vector3F> positions;
+    build_geosphere(subdivisions, &positions, &mesh_data->msd_indices);
 
-        mesh_data->md_vertices[i].vt_texcoord.x_ = theta / numericsF::two_pi();
-        mesh_data->md_vertices[i].vt_texcoord.y_ = phi / numericsF::pi();
+    mesh_streams& streams = mesh_data->msd_vertices;
+    streams.clear();
+    streams.resize(positions.size());
 
-        // Partial derivative of P with respect to theta
-        mesh_data->md_vertices[i].vt_tangent.x_ = -radius * sinf(phi) * sinf(theta);
-        mesh_data->md_vertices[i].vt_tangent.y_ = 0.0f;
-        mesh_data->md_vertices[i].vt_tangent.z_ = +radius * sinf(phi) * cosf(theta);
-        mesh_data->md_vertices[i].vt_tangent.normalize();
-    }
+    fill_geosphere_vertices(
+        radius, positions, 0, streams.positions(), streams.normals(),
+        streams.tangents(), streams.texcoords());
 }
 
 void v8::math::geometry_gen::create_cylinder(
@@ -631,3 +794,59 @@ void v8::math::geometry_gen::create_fullscreen_quad(
     mesh_data->md_indices[4] = 2;
     mesh_data->md_indices[5] = 3;
 }
+
+void v8::math::geometry_gen::create_box(
+    float width, 
+    float height, 
+    float depth, 
+    mesh_streams_data_t* mesh_data
+    ) {
+    mesh_data_t interleaved;
+    create_box(width, height, depth, &interleaved);
+    split_into_streams(&interleaved, mesh_data);
+}
+
+void v8::math::geometry_gen::create_sphere(
+    float radius,
+    size_t slice_count,
+    size_t stack_count,
+    mesh_streams_data_t* mesh_data
+    ) {
+    mesh_data_t interleaved;
+    create_sphere(radius, slice_count, stack_count, &interleaved);
+    split_into_streams(&interleaved, mesh_data);
+}
+
+void v8::math::geometry_gen::create_cylinder(
+    float bottom_radius,
+    float top_radius,
+    float height,
+    size_t slice_count,
+    size_t stack_count,
+    mesh_streams_data_t* mesh_data
+    ) {
+    mesh_data_t interleaved;
+    create_cylinder(bottom_radius, top_radius, height, slice_count, 
+                    stack_count, &interleaved);
+    split_into_streams(&interleaved, mesh_data);
+}
+
+void v8::math::geometry_gen::create_grid(
+    const float grid_width,
+    const float grid_depth,
+    const v8_int_t row_count,
+    const v8_int_t column_count,
+    mesh_streams_data_t* mesh
+    ) {
+    mesh_data_t interleaved;
+    create_grid(grid_width, grid_depth, row_count, column_count, &interleaved);
+    split_into_streams(&interleaved, mesh);
+}
+
+void v8::math::geometry_gen::create_fullscreen_quad(
+    mesh_streams_data_t* mesh_data
+    ) {
+    mesh_data_t interleaved;
+    create_fullscreen_quad(&interleaved);
+    split_into_streams(&interleaved, mesh_data);
+}
@@ -0,0 +1,1257 @@
+#include "pch_hdr.hpp"
+
+#include <algorithm>
+#include <cfloat>
+
+#include <v8/base/job_system.hpp>
+#include <v8/math/distance/distance_point_triangle.hpp>
+#include <v8/math/geometry_generators.hpp>
+#include <v8/math/mesh_streams.hpp>
+#include <v8/math/simd/float4.hpp>
+#include <v8/math/spatial/mesh_bvh.hpp>
+
+namespace {
+
+/**
+ * \brief Number of bins used when evaluating the surface area heuristic.
+ */
+const v8_size_t k_sah_bin_count = 16;
+
+//
+// Past this depth nodes are split at the median, which bounds the height
+// of the tree (48 + log2(2^32 / 4) < 80) for degenerate meshes, so that the
+// traversal stacks have a fixed size.
+const v8_uint32_t k_max_sah_depth = 48;
+const v8_size_t k_stack_size = 128;
+
+//
+// Parallel build : the top of the tree is built on the calling thread, down
+// to subtrees of about count / (threads * k_tasks_per_thread) triangles,
+// which are then built as independent tasks.
+const v8_size_t k_tasks_per_thread = 8;
+const v8_size_t k_min_task_triangles = 4096;
+
+//
+// Marks the placeholder nodes of the subtrees built as tasks.
+const v8_uint16_t k_task_node = 0xFFFF;
+
+//
+// Rays per parallel_for chunk in mesh_bvh::intersect_rays.
+const v8_size_t k_ray_grain_size = 512;
+
+//
+// Points per parallel_for chunk in mesh_bvh::closest_points.
+const v8_size_t k_point_grain_size = 256;
+
+struct bounds_t {
+    float   bd_min[3];
+    float   bd_max[3];
+
+    void reset() {
+        for (int i = 0; i < 3; ++i) {
+            bd_min[i] = FLT_MAX;
+            bd_max[i] = -FLT_MAX;
+        }
+    }
+
+    void grow(const float* point) {
+        for (int i = 0; i < 3; ++i) {
+            bd_min[i] = std::min(bd_min[i], point[i]);
+            bd_max[i] = std::max(bd_max[i], point[i]);
+        }
+    }
+
+    void grow(const bounds_t& other) {
+        for (int i = 0; i < 3; ++i) {
+            bd_min[i] = std::min(bd_min[i], other.bd_min[i]);
+            bd_max[i] = std::max(bd_max[i], other.bd_max[i]);
+        }
+    }
+
+    //
+    // Half the surface area; empty bounds have a zero area.
+    float half_area() const {
+        const float dx = bd_max[0] - bd_min[0];
+        const float dy = bd_max[1] - bd_min[1];
+        const float dz = bd_max[2] - bd_min[2];
+        return dx < 0.0f ? 0.0f : dx * dy + dy * dz + dz * dx;
+    }
+};
+
+//
+// A triangle, as seen by the build.
+struct build_ref_t {
+    bounds_t    br_bound;
+    float       br_centroid[3];
+    v8_uint32_t br_triangle;
+};
+
+inline v8_size_t bin_index(float centroid, float axis_min, float bin_scale) {
+    return std::min(
+        static_cast<v8_size_t>((centroid - axis_min) * bin_scale),
+        k_sah_bin_count - 1);
+}
+
+//
+// Reciprocal of a direction component; zero components are replaced with a
+// tiny value so that the slab tests never compute 0 * infinity.
+inline float safe_inverse(float val) {
+    const float k_tiny = 1.0e-20f;
+    if (std::fabs(val) < k_tiny)
+        val = val < 0.0f ? -k_tiny : k_tiny;
+    return 1.0f / val;
+}
+
+//
+// Per triangle passes of the build, split between the threads when a job
+// system is given.
+template<typename range_function>
+inline void run_build_pass(
+    v8::base::job_system*   jobs,
+    v8_size_t               count,
+    range_function          body
+    ) {
+    if (jobs)
+        jobs->parallel_for(0, count, k_min_task_triangles, body);
+    else
+        body(0, count);
+}
+
+} // anonymous namespace
+
+struct v8::math::mesh_bvh::builder_t {
+    struct task_t {
+        v8_size_t           tk_first;
+        v8_size_t           tk_count;
+        v8_uint32_t         tk_depth;
+        std::vector<node_t> tk_nodes;
+    };
+
+    build_ref_t*            refs;
+    std::vector<node_t>*    nodes;
+    //! Null when building whole subtrees.
+    std::vector<task_t>*    tasks;
+    v8_size_t               task_size;
+
+    void build_node(v8_size_t first, v8_size_t count, v8_uint32_t depth);
+
+    //
+    // Partitions the references and returns the size of the left half.
+    v8_size_t split(
+        v8_size_t           first,
+        v8_size_t           count,
+        const bounds_t&     centroid_bound,
+        v8_uint32_t         depth,
+        v8_uint16_t*        axis
+        );
+
+    //
+    // Copies the subtree rooted at node to out, replacing the task
+    // placeholders with the subtrees built by the tasks.
+    static void splice(
+        const std::vector<node_t>&  top,
+        v8_uint32_t                 node,
+        const std::vector<task_t>&  tasks,
+        std::vector<node_t>*        out
+        );
+};
+
+void v8::math::mesh_bvh::builder_t::build_node(
+    v8_size_t   first,
+    v8_size_t   count,
+    v8_uint32_t depth
+    ) {
+    bounds_t bound;
+    bounds_t centroid_bound;
+    bound.reset();
+    centroid_bound.reset();
+
+    for (v8_size_t i = first; i < first + count; ++i) {
+        bound.grow(refs[i].br_bound);
+        centroid_bound.grow(refs[i].br_centroid);
+    }
+
+    const v8_uint32_t index = static_cast<v8_uint32_t>(nodes->size());
+    node_t node;
+    for (int i = 0; i < 3; ++i) {
+        node.nd_min[i] = bound.bd_min[i];
+        node.nd_max[i] = bound.bd_max[i];
+    }
+    node.nd_offset = static_cast<v8_uint32_t>(first);
+    node.nd_count = 0;
+    node.nd_axis = 0;
+
+    if (count <= C_Max_Leaf_Triangles) {
+        node.nd_count = static_cast<v8_uint16_t>(count);
+        nodes->push_back(node);
+        return;
+    }
+
+    if (tasks && count <= task_size) {
+        node.nd_offset = static_cast<v8_uint32_t>(tasks->size());
+        node.nd_axis = k_task_node;
+        nodes->push_back(node);
+
+        task_t task;
+        task.tk_first = first;
+        task.tk_count = count;
+        task.tk_depth = depth;
+        tasks->push_back(task);
+        return;
+    }
+
+    nodes->push_back(node);
+
+    v8_uint16_t axis;
+    const v8_size_t left_count = split(first, count, centroid_bound, depth, &axis);
+
+    build_node(first, left_count, depth + 1);
+    const v8_uint32_t second_child = static_cast<v8_uint32_t>(nodes->size());
+    build_node(first + left_count, count - left_count, depth + 1);
+
+    (*nodes)[index].nd_offset = second_child;
+    (*nodes)[index].nd_axis = axis;
+}
+
+v8_size_t v8::math::mesh_bvh::builder_t::split(
+    v8_size_t           first,
+    v8_size_t           count,
+    const bounds_t&     centroid_bound,
+    v8_uint32_t         depth,
+    v8_uint16_t*        axis
+    ) {
+    build_ref_t* const begin = refs + first;
+    build_ref_t* const end = begin + count;
+
+    int best_axis = -1;
+    v8_size_t best_split = 0;
+    float best_cost = 0.0f;
+
+    //
+    // Binned surface area heuristic, as in aabb_tree : the cost of a split
+    // is area(left) * count(left) + area(right) * count(right).
+    for (int a = 0; a < 3 && depth < k_max_sah_depth; ++a) {
+        const float axis_min = centroid_bound.bd_min[a];
+        const float extent = centroid_bound.bd_max[a] - axis_min;
+        if (extent <= 0.0f)
+            continue;
+
+        const float bin_scale = static_cast<float>(k_sah_bin_count) / extent;
+        bounds_t bin_bounds[k_sah_bin_count];
+        v8_size_t bin_counts[k_sah_bin_count] = { 0 };
+        for (v8_size_t bin = 0; bin < k_sah_bin_count; ++bin)
+            bin_bounds[bin].reset();
+
+        for (const build_ref_t* ref = begin; ref != end; ++ref) {
+            const v8_size_t bin = bin_index(ref->br_centroid[a], axis_min, bin_scale);
+            bin_bounds[bin].grow(ref->br_bound);
+            ++bin_counts[bin];
+        }
+
+        float right_cost[k_sah_bin_count];
+        bounds_t accum;
+        accum.reset();
+        v8_size_t accum_count = 0;
+        for (v8_size_t bin = k_sah_bin_count - 1; bin > 0; --bin) {
+            accum.grow(bin_bounds[bin]);
+            accum_count += bin_counts[bin];
+            right_cost[bin] = accum.half_area() * static_cast<float>(accum_count);
+        }
+
+        accum.reset();
+        accum_count = 0;
+        for (v8_size_t split = 1; split < k_sah_bin_count; ++split) {
+            accum.grow(bin_bounds[split - 1]);
+            accum_count += bin_counts[split - 1];
+            if (!accum_count || accum_count == count)
+                continue;
+
+            const float cost = accum.half_area() * static_cast<float>(accum_count)
+                               + right_cost[split];
+            if (best_axis == -1 || cost < best_cost) {
+                best_axis = a;
+                best_split = split;
+                best_cost = cost;
+            }
+        }
+    }
+
+    if (best_axis != -1) {
+        const float axis_min = centroid_bound.bd_min[best_axis];
+        const float bin_scale = static_cast<float>(k_sah_bin_count)
+            / (centroid_bound.bd_max[best_axis] - axis_min);
+
+        const build_ref_t* middle = std::partition(
+            begin, end, [=](const build_ref_t& ref) {
+                return bin_index(ref.br_centroid[best_axis], axis_min, bin_scale)
+                       < best_split;
+        });
+
+        *axis = static_cast<v8_uint16_t>(best_axis);
+        return static_cast<v8_size_t>(middle - begin);
+    }
+
+    //
+    // Too deep, or all the centroids are in the same spot : median split
+    // along the longest axis of the centroids.
+    int longest = 0;
+    for (int a = 1; a < 3; ++a) {
+        if (centroid_bound.bd_max[a] - centroid_bound.bd_min[a] >
+            centroid_bound.bd_max[longest] - centroid_bound.bd_min[longest])
+            longest = a;
+    }
+
+    const v8_size_t left_count = count / 2;
+    std::nth_element(begin, begin + left_count, end,
+        [=](const build_ref_t& lhs, const build_ref_t& rhs) {
+            return lhs.br_centroid[longest] < rhs.br_centroid[longest];
+    });
+
+    *axis = static_cast<v8_uint16_t>(longest);
+    return left_count;
+}
+
+void v8::math::mesh_bvh::builder_t::splice(
+    const std::vector<node_t>&  top,
+    v8_uint32_t                 node,
+    const std::vector<task_t>&  tasks,
+    std::vector<node_t>*        out
+    ) {
+    const node_t& src = top[node];
+
+    if (src.nd_axis == k_task_node) {
+        const std::vector<node_t>& subtree = tasks[src.nd_offset].tk_nodes;
+        const v8_uint32_t base = static_cast<v8_uint32_t>(out->size());
+
+        for (v8_size_t i = 0; i < subtree.size(); ++i) {
+            out->push_back(subtree[i]);
+            if (!subtree[i].nd_count)
+                out->back().nd_offset += base;
+        }
+        return;
+    }
+
+    const v8_uint32_t index = static_cast<v8_uint32_t>(out->size());
+    out->push_back(src);
+    if (src.nd_count)
+        return;
+
+    splice(top, node + 1, tasks, out);
+    (*out)[index].nd_offset = static_cast<v8_uint32_t>(out->size());
+    splice(top, src.nd_offset, tasks, out);
+}
+
+v8::math::mesh_bvh::mesh_bvh() {}
+
+void v8::math::mesh_bvh::clear() {
+    nodes_.clear();
+    triangles_.clear();
+}
+
+void v8::math::mesh_bvh::build(
+    const vector3F*     positions,
+    v8_size_t           position_stride,
+    const v8_uint32_t*  indices,
+    v8_size_t           triangle_count,
+    base::job_system*   jobs
+    ) {
+    clear();
+    if (!triangle_count)
+        return;
+
+    const char* position_bytes = reinterpret_cast<const char*>(positions);
+    auto vertex = [=](v8_size_t triangle, int corner) -> const vector3F& {
+        return *reinterpret_cast<const vector3F*>(
+            position_bytes + indices[triangle * 3 + corner] * position_stride);
+    };
+
+    const bool parallel = jobs && triangle_count >= C_Parallel_Build_Threshold;
+    base::job_system* const pass_jobs = parallel ? jobs : nullptr;
+
+    std::vector<build_ref_t> refs(triangle_count);
+    run_build_pass(pass_jobs, triangle_count, [&](v8_size_t first, v8_size_t last) {
+        for (v8_size_t i = first; i < last; ++i) {
+            build_ref_t& ref = refs[i];
+            ref.br_bound.reset();
+            for (int corner = 0; corner < 3; ++corner)
+                ref.br_bound.grow(vertex(i, corner).elements_);
+
+            for (int a = 0; a < 3; ++a) {
+                ref.br_centroid[a] =
+                    0.5f * (ref.br_bound.bd_min[a] + ref.br_bound.bd_max[a]);
+            }
+            ref.br_triangle = static_cast<v8_uint32_t>(i);
+        }
+    });
+
+    builder_t builder;
+    builder.refs = &refs[0];
+
+    if (parallel) {
+        std::vector<node_t> top;
+        std::vector<builder_t::task_t> tasks;
+
+        builder.nodes = &top;
+        builder.tasks = &tasks;
+        builder.task_size = std::max(
+            k_min_task_triangles,
+            triangle_count / (jobs->get_thread_count() * k_tasks_per_thread));
+        builder.build_node(0, triangle_count, 0);
+
+        jobs->parallel_for(0, tasks.size(), 1,
+            [&](v8_size_t first, v8_size_t last) {
+            for (v8_size_t i = first; i < last; ++i) {
+                builder_t subtree_builder;
+                subtree_builder.refs = &refs[0];
+                subtree_builder.nodes = &tasks[i].tk_nodes;
+                subtree_builder.tasks = nullptr;
+                subtree_builder.task_size = 0;
+                subtree_builder.build_node(
+                    tasks[i].tk_first, tasks[i].tk_count, tasks[i].tk_depth);
+            }
+        });
+
+        v8_size_t node_count = top.size();
+        for (v8_size_t i = 0; i < tasks.size(); ++i)
+            node_count += tasks[i].tk_nodes.size();
+
+        nodes_.reserve(node_count);
+        builder_t::splice(top, 0, tasks, &nodes_);
+    } else {
+        builder.nodes = &nodes_;
+        builder.tasks = nullptr;
+        builder.task_size = 0;
+        builder.build_node(0, triangle_count, 0);
+    }
+
+    //
+    // The leaves reference the triangles in the order of the partitioned
+    // references.
+    triangles_.resize(triangle_count);
+    run_build_pass(pass_jobs, triangle_count, [&](v8_size_t first, v8_size_t last) {
+        for (v8_size_t i = first; i < last; ++i) {
+            const v8_uint32_t source = refs[i].br_triangle;
+            const vector3F& v0 = vertex(source, 0);
+            const vector3F edge1 = vertex(source, 1) - v0;
+            const vector3F edge2 = vertex(source, 2) - v0;
+
+            triangle_t& tri = triangles_[i];
+            for (int a = 0; a < 3; ++a) {
+                tri.tr_v0[a] = v0.elements_[a];
+                tri.tr_edge1[a] = edge1.elements_[a];
+                tri.tr_edge2[a] = edge2.elements_[a];
+            }
+            tri.tr_index = source;
+            tri.tr_edge1[3] = 0.0f;
+            tri.tr_edge2[3] = 0.0f;
+        }
+    });
+}
+
+void v8::math::mesh_bvh::build(
+    const geometry_gen::mesh_data_t&    mesh,
+    base::job_system*                   jobs
+    ) {
+    if (mesh.md_vertices.empty() || mesh.md_indices.empty()) {
+        clear();
+        return;
+    }
+
+    build(&mesh.md_vertices[0].vt_position, sizeof(geometry_gen::vertex_pntt),
+          &mesh.md_indices[0], mesh.md_indices.size() / 3, jobs);
+}
+
+void v8::math::mesh_bvh::build(
+    const mesh_streams& mesh,
+    const v8_uint32_t*  indices,
+    v8_size_t           triangle_count,
+    base::job_system*   jobs
+    ) {
+    build(mesh.positions(), sizeof(vector3F), indices, triangle_count, jobs);
+}
+
+v8::math::aabb3F v8::math::mesh_bvh::get_bound() const {
+    assert(!is_empty());
+    const node_t& root = nodes_[0];
+    return aabb3F(vector3F(root.nd_min[0], root.nd_min[1], root.nd_min[2]),
+                  vector3F(root.nd_max[0], root.nd_max[1], root.nd_max[2]));
+}
+
+struct v8::math::mesh_bvh::tracer_t {
+    struct ray_t {
+        float   ry_origin[3];
+        float   ry_direction[3];
+        float   ry_inv_direction[3];
+        //! origin * inv_direction, so that a slab test is one multiply and
+        //! one subtract per plane.
+        float   ry_scaled_origin[3];
+    };
+
+    static void setup(const ray3F& ray_query, ray_t* r) {
+        for (int a = 0; a < 3; ++a) {
+            r->ry_origin[a] = ray_query.origin_.elements_[a];
+            r->ry_direction[a] = ray_query.direction_.elements_[a];
+            r->ry_inv_direction[a] = safe_inverse(r->ry_direction[a]);
+            r->ry_scaled_origin[a] = r->ry_origin[a] * r->ry_inv_direction[a];
+        }
+    }
+
+    static bool enter(
+        const ray_t&    r,
+        const node_t&   node,
+        float           max_distance,
+        float*          t_enter
+        ) {
+        float t_near = 0.0f;
+        float t_far = max_distance;
+        for (int a = 0; a < 3; ++a) {
+            const float t0 = node.nd_min[a] * r.ry_inv_direction[a]
+                             - r.ry_scaled_origin[a];
+            const float t1 = node.nd_max[a] * r.ry_inv_direction[a]
+                             - r.ry_scaled_origin[a];
+            t_near = std::max(t_near, std::min(t0, t1));
+            t_far = std::min(t_far, std::max(t0, t1));
+        }
+
+        *t_enter = t_near;
+        return t_near <= t_far;
+    }
+
+    //
+    // Tests the triangles of a leaf; hit->rh_distance is the current
+    // maximum distance.
+    template<bool any_hit>
+    static bool intersect_leaf(
+        const triangle_t*   tris,
+        v8_uint32_t         count,
+        const ray_t&        r,
+        mesh_ray_hit_t*     hit
+        );
+
+    template<bool any_hit>
+    static bool trace(const mesh_bvh& bvh, const ray_t& r, mesh_ray_hit_t* hit) {
+        const node_t* nodes = &bvh.nodes_[0];
+        const triangle_t* tris = &bvh.triangles_[0];
+
+        float t_enter;
+        if (!enter(r, nodes[0], hit->rh_distance, &t_enter))
+            return false;
+
+        struct stack_entry_t {
+            v8_uint32_t se_node;
+            float       se_distance;
+        };
+
+        stack_entry_t stack[k_stack_size];
+        v8_size_t top = 0;
+        v8_uint32_t node_id = 0;
+        bool found = false;
+
+        for (;;) {
+            const node_t& node = nodes[node_id];
+
+            if (node.nd_count) {
+                if (intersect_leaf<any_hit>(
+                        tris + node.nd_offset, node.nd_count, r, hit)) {
+                    if (any_hit)
+                        return true;
+                    found = true;
+                }
+            } else {
+                v8_uint32_t near_id = node_id + 1;
+                v8_uint32_t far_id = node.nd_offset;
+                float t_near;
+                float t_far;
+                const bool hit_near = enter(r, nodes[near_id], hit->rh_distance, &t_near);
+                const bool hit_far = enter(r, nodes[far_id], hit->rh_distance, &t_far);
+
+                if (hit_near && hit_far) {
+                    if (t_far < t_near) {
+                        std::swap(near_id, far_id);
+                        std::swap(t_near, t_far);
+                    }
+
+                    assert(top < k_stack_size);
+                    stack[top].se_node = far_id;
+                    stack[top].se_distance = t_far;
+                    ++top;
+                    node_id = near_id;
+                    continue;
+                }
+
+                if (hit_near || hit_far) {
+                    node_id = hit_near ? near_id : far_id;
+                    continue;
+                }
+            }
+
+            //
+            // Entries farther than the closest hit found after they were
+            // pushed are skipped.
+            for (;;) {
+                if (!top)
+                    return found;
+
+                --top;
+                if (stack[top].se_distance <= hit->rh_distance)
+                    break;
+            }
+            node_id = stack[top].se_node;
+        }
+    }
+
+    template<int group_count, bool any_hit>
+    static v8_uint32_t trace_packet(
+        const mesh_bvh&     bvh,
+        const ray3F*        rays,
+        const float*        max_distances,
+        mesh_ray_hit_t*     hits
+        );
+};
+
+#if defined(V8_MATH_SIMD_ENABLED)
+
+//
+// One ray against four triangles.
+template<bool any_hit>
+bool v8::math::mesh_bvh::tracer_t::intersect_leaf(
+    const triangle_t*   tris,
+    v8_uint32_t         count,
+    const ray_t&        r,
+    mesh_ray_hit_t*     hit
+    ) {
+    using namespace v8::math::simd;
+
+    //
+    // Stands in for the missing triangles of a leaf; its zero determinant
+    // rejects it.
+    static const triangle_t empty_triangle = {};
+
+    const triangle_t* lanes[4];
+    for (v8_uint32_t i = 0; i < 4; ++i)
+        lanes[i] = i < count ? tris + i : &empty_triangle;
+
+    float4_t v0x = load_float4(lanes[0]->tr_v0);
+    float4_t v0y = load_float4(lanes[1]->tr_v0);
+    float4_t v0z = load_float4(lanes[2]->tr_v0);
+    float4_t v0w = load_float4(lanes[3]->tr_v0);
+    transpose(v0x, v0y, v0z, v0w);
+
+    float4_t e1x = load_float4(lanes[0]->tr_edge1);
+    float4_t e1y = load_float4(lanes[1]->tr_edge1);
+    float4_t e1z = load_float4(lanes[2]->tr_edge1);
+    float4_t e1w = load_float4(lanes[3]->tr_edge1);
+    transpose(e1x, e1y, e1z, e1w);
+
+    float4_t e2x = load_float4(lanes[0]->tr_edge2);
+    float4_t e2y = load_float4(lanes[1]->tr_edge2);
+    float4_t e2z = load_float4(lanes[2]->tr_edge2);
+    float4_t e2w = load_float4(lanes[3]->tr_edge2);
+    transpose(e2x, e2y, e2z, e2w);
+
+    const float4_t dx = splat_float4(r.ry_direction[0]);
+    const float4_t dy = splat_float4(r.ry_direction[1]);
+    const float4_t dz = splat_float4(r.ry_direction[2]);
+
+    const float4_t px = sub(mul(dy, e2z), mul(dz, e2y));
+    const float4_t py = sub(mul(dz, e2x), mul(dx, e2z));
+    const float4_t pz = sub(mul(dx, e2y), mul(dy, e2x));
+    const float4_t det = add(add(mul(e1x, px), mul(e1y, py)), mul(e1z, pz));
+    const float4_t inv_det = div(splat_float4(1.0f), det);
+
+    const float4_t tx = sub(splat_float4(r.ry_origin[0]), v0x);
+    const float4_t ty = sub(splat_float4(r.ry_origin[1]), v0y);
+    const float4_t tz = sub(splat_float4(r.ry_origin[2]), v0z);
+    const float4_t u = mul(add(add(mul(tx, px), mul(ty, py)), mul(tz, pz)), inv_det);
+
+    const float4_t qx = sub(mul(ty, e1z), mul(tz, e1y));
+    const float4_t qy = sub(mul(tz, e1x), mul(tx, e1z));
+    const float4_t qz = sub(mul(tx, e1y), mul(ty, e1x));
+    const float4_t v = mul(add(add(mul(dx, qx), mul(dy, qy)), mul(dz, qz)), inv_det);
+    const float4_t t = mul(add(add(mul(e2x, qx), mul(e2y, qy)), mul(e2z, qz)), inv_det);
+
+    const float4_t zero = zero_float4();
+    float4_t mask = cmp_gt(maximum(det, negate(det)), zero);
+    mask = bit_and(mask, cmp_le(zero, u));
+    mask = bit_and(mask, cmp_le(zero, v));
+    mask = bit_and(mask, cmp_le(add(u, v), splat_float4(1.0f)));
+    mask = bit_and(mask, cmp_le(zero, t));
+    mask = bit_and(mask, cmp_le(t, splat_float4(hit->rh_distance)));
+
+    v8_int_t bits = move_mask(mask);
+    if (!bits)
+        return false;
+
+    if (any_hit)
+        return true;
+
+    float distances[4];
+    float us[4];
+    float vs[4];
+    store_float4(distances, t);
+    store_float4(us, u);
+    store_float4(vs, v);
+
+    for (v8_uint32_t i = 0; bits; ++i, bits >>= 1) {
+        if ((bits & 1) && distances[i] <= hit->rh_distance) {
+            hit->rh_distance = distances[i];
+            hit->rh_triangle = tris[i].tr_index;
+            hit->rh_u = us[i];
+            hit->rh_v = vs[i];
+        }
+    }
+
+    return true;
+}
+
+namespace {
+
+using v8::math::simd::float4_t;
+
+//
+// Groups of four rays, in SoA form.
+template<int group_count>
+struct ray_packet_t {
+    float4_t    rp_origin[group_count][3];
+    float4_t    rp_direction[group_count][3];
+    float4_t    rp_inv_direction[group_count][3];
+    float4_t    rp_scaled_origin[group_count][3];
+    //! Current maximum distance of each ray; -1 for rays that are done.
+    float4_t    rp_distance[group_count];
+    float4_t    rp_u[group_count];
+    float4_t    rp_v[group_count];
+    v8_uint32_t rp_triangle[group_count * 4];
+};
+
+} // anonymous namespace
+
+template<int group_count, bool any_hit>
+v8_uint32_t v8::math::mesh_bvh::tracer_t::trace_packet(
+    const mesh_bvh&     bvh,
+    const ray3F*        rays,
+    const float*        max_distances,
+    mesh_ray_hit_t*     hits
+    ) {
+    using namespace v8::math::simd;
+
+    const v8_uint32_t ray_count = group_count * 4;
+    const v8_uint32_t all_rays = (1U << ray_count) - 1;
+
+    if (!any_hit) {
+        for (v8_uint32_t i = 0; i < ray_count; ++i) {
+            hits[i].rh_distance = max_distances[i];
+            hits[i].rh_triangle = C_No_Triangle;
+            hits[i].rh_u = 0.0f;
+            hits[i].rh_v = 0.0f;
+        }
+    }
+
+    if (bvh.is_empty())
+        return 0;
+
+    ray_packet_t<group_count> packet;
+    for (int g = 0; g < group_count; ++g) {
+        const ray3F* group = rays + g * 4;
+
+        for (int a = 0; a < 3; ++a) {
+            float inv[4];
+            float scaled[4];
+            for (int i = 0; i < 4; ++i) {
+                inv[i] = safe_inverse(group[i].direction_.elements_[a]);
+                scaled[i] = group[i].origin_.elements_[a] * inv[i];
+            }
+
+            packet.rp_origin[g][a] = set_float4(
+                group[0].origin_.elements_[a], group[1].origin_.elements_[a],
+                group[2].origin_.elements_[a], group[3].origin_.elements_[a]);
+            packet.rp_direction[g][a] = set_float4(
+                group[0].direction_.elements_[a], group[1].direction_.elements_[a],
+                group[2].direction_.elements_[a], group[3].direction_.elements_[a]);
+            packet.rp_inv_direction[g][a] = load_float4(inv);
+            packet.rp_scaled_origin[g][a] = load_float4(scaled);
+        }
+
+        packet.rp_distance[g] = load_float4(max_distances + g * 4);
+        packet.rp_u[g] = zero_float4();
+        packet.rp_v[g] = zero_float4();
+    }
+
+    for (v8_uint32_t i = 0; i < ray_count; ++i)
+        packet.rp_triangle[i] = C_No_Triangle;
+
+    //
+    // The children are visited in the order given by the direction of the
+    // first ray, which is good enough for coherent packets.
+    bool far_first[3];
+    for (int a = 0; a < 3; ++a)
+        far_first[a] = rays[0].direction_.elements_[a] < 0.0f;
+
+    const node_t* nodes = &bvh.nodes_[0];
+    const triangle_t* tris = &bvh.triangles_[0];
+    const float4_t zero = zero_float4();
+    const float4_t one = splat_float4(1.0f);
+    const float4_t done = splat_float4(-1.0f);
+
+    v8_uint32_t occluded = 0;
+    v8_uint32_t stack[k_stack_size];
+    v8_size_t top = 0;
+    v8_uint32_t node_id = 0;
+
+    for (;;) {
+        const node_t& node = nodes[node_id];
+
+        bool visit = false;
+        for (int g = 0; g < group_count && !visit; ++g) {
+            float4_t t_near = zero;
+            float4_t t_far = packet.rp_distance[g];
+            for (int a = 0; a < 3; ++a) {
+                const float4_t t0 = sub(
+                    mul(splat_float4(node.nd_min[a]), packet.rp_inv_direction[g][a]),
+                    packet.rp_scaled_origin[g][a]);
+                const float4_t t1 = sub(
+                    mul(splat_float4(node.nd_max[a]), packet.rp_inv_direction[g][a]),
+                    packet.rp_scaled_origin[g][a]);
+                t_near = maximum(t_near, minimum(t0, t1));
+                t_far = minimum(t_far, maximum(t0, t1));
+            }
+            visit = move_mask(cmp_le(t_near, t_far)) != 0;
+        }
+
+        if (visit && !node.nd_count) {
+            v8_uint32_t near_id = node_id + 1;
+            v8_uint32_t far_id = node.nd_offset;
+            if (far_first[node.nd_axis])
+                std::swap(near_id, far_id);
+
+            assert(top < k_stack_size);
+            stack[top++] = far_id;
+            node_id = near_id;
+            continue;
+        }
+
+        if (visit) {
+            for (v8_uint32_t i = 0; i < node.nd_count; ++i) {
+                const triangle_t& tri = tris[node.nd_offset + i];
+                const float4_t v0[3] = {
+                    splat_float4(tri.tr_v0[0]), splat_float4(tri.tr_v0[1]),
+                    splat_float4(tri.tr_v0[2])
+                };
+                const float4_t e1[3] = {
+                    splat_float4(tri.tr_edge1[0]), splat_float4(tri.tr_edge1[1]),
+                    splat_float4(tri.tr_edge1[2])
+                };
+                const float4_t e2[3] = {
+                    splat_float4(tri.tr_edge2[0]), splat_float4(tri.tr_edge2[1]),
+                    splat_float4(tri.tr_edge2[2])
+                };
+
+                for (int g = 0; g < group_count; ++g) {
+                    const float4_t* d = packet.rp_direction[g];
+                    const float4_t* o = packet.rp_origin[g];
+
+                    const float4_t px = sub(mul(d[1], e2[2]), mul(d[2], e2[1]));
+                    const float4_t py = sub(mul(d[2], e2[0]), mul(d[0], e2[2]));
+                    const float4_t pz = sub(mul(d[0], e2[1]), mul(d[1], e2[0]));
+                    const float4_t det = add(add(
+                        mul(e1[0], px), mul(e1[1], py)), mul(e1[2], pz));
+                    const float4_t inv_det = div(one, det);
+
+                    const float4_t tx = sub(o[0], v0[0]);
+                    const float4_t ty = sub(o[1], v0[1]);
+                    const float4_t tz = sub(o[2], v0[2]);
+                    const float4_t u = mul(add(add(
+                        mul(tx, px), mul(ty, py)), mul(tz, pz)), inv_det);
+
+                    const float4_t qx = sub(mul(ty, e1[2]), mul(tz, e1[1]));
+                    const float4_t qy = sub(mul(tz, e1[0]), mul(tx, e1[2]));
+                    const float4_t qz = sub(mul(tx, e1[1]), mul(ty, e1[0]));
+                    const float4_t v = mul(add(add(
+                        mul(d[0], qx), mul(d[1], qy)), mul(d[2], qz)), inv_det);
+                    const float4_t t = mul(add(add(
+                        mul(e2[0], qx), mul(e2[1], qy)), mul(e2[2], qz)), inv_det);
+
+                    float4_t mask = cmp_gt(maximum(det, negate(det)), zero);
+                    mask = bit_and(mask, cmp_le(zero, u));
+                    mask = bit_and(mask, cmp_le(zero, v));
+                    mask = bit_and(mask, cmp_le(add(u, v), one));
+                    mask = bit_and(mask, cmp_le(zero, t));
+                    mask = bit_and(mask, cmp_le(t, packet.rp_distance[g]));
+
+                    v8_int_t bits = move_mask(mask);
+                    if (!bits)
+                        continue;
+
+                    if (any_hit) {
+                        packet.rp_distance[g] = select(mask, done, packet.rp_distance[g]);
+                        occluded |= static_cast<v8_uint32_t>(bits) << (g * 4);
+                        continue;
+                    }
+
+                    packet.rp_distance[g] = select(mask, t, packet.rp_distance[g]);
+                    packet.rp_u[g] = select(mask, u, packet.rp_u[g]);
+                    packet.rp_v[g] = select(mask, v, packet.rp_v[g]);
+                    for (v8_uint32_t lane = 0; bits; ++lane, bits >>= 1) {
+                        if (bits & 1)
+                            packet.rp_triangle[g * 4 + lane] = tri.tr_index;
+                    }
+                }
+
+                if (any_hit && occluded == all_rays)
+                    return occluded;
+            }
+        }
+
+        if (!top)
+            break;
+        node_id = stack[--top];
+    }
+
+    if (any_hit)
+        return occluded;
+
+    v8_uint32_t hit_mask = 0;
+    for (int g = 0; g < group_count; ++g) {
+        float distances[4];
+        float us[4];
+        float vs[4];
+        store_float4(distances, packet.rp_distance[g]);
+        store_float4(us, packet.rp_u[g]);
+        store_float4(vs, packet.rp_v[g]);
+
+        for (int lane = 0; lane < 4; ++lane) {
+            const v8_uint32_t i = g * 4 + lane;
+            if (packet.rp_triangle[i] == C_No_Triangle)
+                continue;
+
+            hits[i].rh_distance = distances[lane];
+            hits[i].rh_triangle = packet.rp_triangle[i];
+            hits[i].rh_u = us[lane];
+            hits[i].rh_v = vs[lane];
+            hit_mask |= 1U << i;
+        }
+    }
+
+    return hit_mask;
+}
+
+#else /* V8_MATH_SIMD_ENABLED */
+
+template<bool any_hit>
+bool v8::math::mesh_bvh::tracer_t::intersect_leaf(
+    const triangle_t*   tris,
+    v8_uint32_t         count,
+    const ray_t&        r,
+    mesh_ray_hit_t*     hit
+    ) {
+    const float* d = r.ry_direction;
+    bool found = false;
+
+    for (v8_uint32_t i = 0; i < count; ++i) {
+        const triangle_t& tri = tris[i];
+        const float* e1 = tri.tr_edge1;
+        const float* e2 = tri.tr_edge2;
+
+        const float px = d[1] * e2[2] - d[2] * e2[1];
+        const float py = d[2] * e2[0] - d[0] * e2[2];
+        const float pz = d[0] * e2[1] - d[1] * e2[0];
+        const float det = e1[0] * px + e1[1] * py + e1[2] * pz;
+        if (det == 0.0f)
+            continue;
+
+        const float inv_det = 1.0f / det;
+        const float tx = r.ry_origin[0] - tri.tr_v0[0];
+        const float ty = r.ry_origin[1] - tri.tr_v0[1];
+        const float tz = r.ry_origin[2] - tri.tr_v0[2];
+        const float u = (tx * px + ty * py + tz * pz) * inv_det;
+        if (u < 0.0f || u > 1.0f)
+            continue;
+
+        const float qx = ty * e1[2] - tz * e1[1];
+        const float qy = tz * e1[0] - tx * e1[2];
+        const float qz = tx * e1[1] - ty * e1[0];
+        const float v = (d[0] * qx + d[1] * qy + d[2] * qz) * inv_det;
+        if (v < 0.0f || u + v > 1.0f)
+            continue;
+
+        const float t = (e2[0] * qx + e2[1] * qy + e2[2] * qz) * inv_det;
+        if (t < 0.0f || t > hit->rh_distance)
+            continue;
+
+        if (any_hit)
+            return true;
+
+        hit->rh_distance = t;
+        hit->rh_triangle = tri.tr_index;
+        hit->rh_u = u;
+        hit->rh_v = v;
+        found = true;
+    }
+
+    return found;
+}
+
+//
+// Without SIMD, there is nothing to share between the rays of a packet.
+template<int group_count, bool any_hit>
+v8_uint32_t v8::math::mesh_bvh::tracer_t::trace_packet(
+    const mesh_bvh&     bvh,
+    const ray3F*        rays,
+    const float*        max_distances,
+    mesh_ray_hit_t*     hits
+    ) {
+    v8_uint32_t mask = 0;
+    for (v8_uint32_t i = 0; i < group_count * 4; ++i) {
+        const bool hit = any_hit
+            ? bvh.occluded(rays[i], max_distances[i])
+            : bvh.intersect(rays[i], max_distances[i], hits + i);
+        if (hit)
+            mask |= 1U << i;
+    }
+    return mask;
+}
+
+#endif /* V8_MATH_SIMD_ENABLED */
+
+bool v8::math::mesh_bvh::intersect(
+    const ray3F&        ray_query,
+    float               max_distance,
+    mesh_ray_hit_t*     hit
+    ) const {
+    hit->rh_distance = max_distance;
+    hit->rh_triangle = C_No_Triangle;
+    hit->rh_u = 0.0f;
+    hit->rh_v = 0.0f;
+
+    if (is_empty())
+        return false;
+
+    tracer_t::ray_t r;
+    tracer_t::setup(ray_query, &r);
+    return tracer_t::trace<false>(*this, r, hit);
+}
+
+bool v8::math::mesh_bvh::occluded(
+    const ray3F&        ray_query,
+    float               max_distance
+    ) const {
+    if (is_empty())
+        return false;
+
+    mesh_ray_hit_t hit;
+    hit.rh_distance = max_distance;
+    hit.rh_triangle = C_No_Triangle;
+
+    tracer_t::ray_t r;
+    tracer_t::setup(ray_query, &r);
+    return tracer_t::trace<true>(*this, r, &hit);
+}
+
+v8_uint32_t v8::math::mesh_bvh::intersect_packet4(
+    const ray3F*        rays,
+    const float*        max_distances,
+    mesh_ray_hit_t*     hits
+    ) const {
+    return tracer_t::trace_packet<1, false>(*this, rays, max_distances, hits);
+}
+
+v8_uint32_t v8::math::mesh_bvh::intersect_packet8(
+    const ray3F*        rays,
+    const float*        max_distances,
+    mesh_ray_hit_t*     hits
+    ) const {
+    return tracer_t::trace_packet<2, false>(*this, rays, max_distances, hits);
+}
+
+v8_uint32_t v8::math::mesh_bvh::occluded_packet4(
+    const ray3F*        rays,
+    const float*        max_distances
+    ) const {
+    return tracer_t::trace_packet<1, true>(*this, rays, max_distances, nullptr);
+}
+
+v8_uint32_t v8::math::mesh_bvh::occluded_packet8(
+    const ray3F*        rays,
+    const float*        max_distances
+    ) const {
+    return tracer_t::trace_packet<2, true>(*this, rays, max_distances, nullptr);
+}
+
+void v8::math::mesh_bvh::intersect_rays(
+    const ray3F*        rays,
+    v8_size_t           count,
+    float               max_distance,
+    mesh_ray_hit_t*     hits,
+    base::job_system*   jobs
+    ) const {
+    const float max_distances[8] = {
+        max_distance, max_distance, max_distance, max_distance,
+        max_distance, max_distance, max_distance, max_distance
+    };
+
+    auto trace_range = [=](v8_size_t first, v8_size_t last) {
+        v8_size_t i = first;
+        for (; i + 8 <= last; i += 8)
+            intersect_packet8(rays + i, max_distances, hits + i);
+        for (; i < last; ++i)
+            intersect(rays[i], max_distance, hits + i);
+    };
+
+    if (jobs && count > k_ray_grain_size)
+        jobs->parallel_for(0, count, k_ray_grain_size, trace_range);
+    else
+        trace_range(0, count);
+}
+
+struct v8::math::mesh_bvh::proximity_t {
+    //
+    // Lower bound of the distance between the point and anything in the
+    // node (0 if the point is inside the box).
+    static float box_distance_squared(const vector3F& point, const node_t& node) {
+        float dist = 0.0f;
+        for (int a = 0; a < 3; ++a) {
+            const float below = node.nd_min[a] - point.elements_[a];
+            const float above = point.elements_[a] - node.nd_max[a];
+            const float outside = std::max(std::max(below, above), 0.0f);
+            dist += outside * outside;
+        }
+        return dist;
+    }
+
+    //
+    // The distance is measured to the point given by the parameters of
+    // distance_squared, which is more accurate in single precision than
+    // the distance it returns for points far from small triangles.
+    static bool test_triangle(
+        const triangle_t&       tri,
+        const vector3F&         point,
+        mesh_closest_point_t*   best
+        ) {
+        const vector3F v0(tri.tr_v0[0], tri.tr_v0[1], tri.tr_v0[2]);
+        const vector3F edge1(tri.tr_edge1[0], tri.tr_edge1[1], tri.tr_edge1[2]);
+        const vector3F edge2(tri.tr_edge2[0], tri.tr_edge2[1], tri.tr_edge2[2]);
+
+        float s;
+        float t;
+        distance_squared(point, triangle3F(v0, v0 + edge1, v0 + edge2), &s, &t);
+
+        const vector3F closest = v0 + edge1 * s + edge2 * t;
+        const float dist = (closest - point).length_squared();
+        if (dist >= best->cp_distance_squared)
+            return false;
+
+        best->cp_point = closest;
+        best->cp_distance_squared = dist;
+        best->cp_triangle = tri.tr_index;
+        best->cp_u = s;
+        best->cp_v = t;
+        return true;
+    }
+
+    //
+    // result->cp_distance_squared holds the square of the maximum distance.
+    static bool query(
+        const mesh_bvh&         bvh,
+        const vector3F&         point,
+        mesh_closest_point_t*   result
+        ) {
+        const node_t* nodes = &bvh.nodes_[0];
+        const triangle_t* tris = &bvh.triangles_[0];
+
+        if (box_distance_squared(point, nodes[0]) >= result->cp_distance_squared)
+            return false;
+
+        struct stack_entry_t {
+            v8_uint32_t se_node;
+            float       se_distance;
+        };
+
+        stack_entry_t stack[k_stack_size];
+        v8_size_t top = 0;
+        v8_uint32_t node_id = 0;
+        bool found = false;
+
+        for (;;) {
+            const node_t& node = nodes[node_id];
+
+            if (node.nd_count) {
+                for (v8_uint32_t i = 0; i < node.nd_count; ++i)
+                    found |= test_triangle(tris[node.nd_offset + i], point, result);
+            } else {
+                v8_uint32_t near_id = node_id + 1;
+                v8_uint32_t far_id = node.nd_offset;
+                float d_near = box_distance_squared(point, nodes[near_id]);
+                float d_far = box_distance_squared(point, nodes[far_id]);
+                if (d_far < d_near) {
+                    std::swap(near_id, far_id);
+                    std::swap(d_near, d_far);
+                }
+
+                if (d_near < result->cp_distance_squared) {
+                    if (d_far < result->cp_distance_squared) {
+                        assert(top < k_stack_size);
+                        stack[top].se_node = far_id;
+                        stack[top].se_distance = d_far;
+                        ++top;
+                    }
+
+                    node_id = near_id;
+                    continue;
+                }
+            }
+
+            for (;;) {
+                if (!top)
+                    return found;
+
+                --top;
+                if (stack[top].se_distance < result->cp_distance_squared)
+                    break;
+            }
+            node_id = stack[top].se_node;
+        }
+    }
+};
+
+bool v8::math::mesh_bvh::closest_point(
+    const vector3F&         point,
+    float                   max_distance,
+    mesh_closest_point_t*   result
+    ) const {
+    result->cp_point = point;
+    result->cp_distance_squared = max_distance * max_distance;
+    result->cp_triangle = C_No_Triangle;
+    result->cp_u = 0.0f;
+    result->cp_v = 0.0f;
+
+    if (is_empty())
+        return false;
+
+    return proximity_t::query(*this, point, result);
+}
+
+void v8::math::mesh_bvh::closest_points(
+    const vector3F*         points,
+    v8_size_t               count,
+    float                   max_distance,
+    mesh_closest_point_t*   results,
+    base::job_system*       jobs
+    ) const {
+    auto query_range = [=](v8_size_t first, v8_size_t last) {
+        for (v8_size_t i = first; i < last; ++i) {
+            mesh_closest_point_t& result = results[i];
+            result.cp_point = points[i];
+            result.cp_distance_squared = max_distance * max_distance;
+            result.cp_triangle = C_No_Triangle;
+            result.cp_u = 0.0f;
+            result.cp_v = 0.0f;
+
+            if (!is_empty())
+                proximity_t::query(*this, points[i], &result);
+        }
+    };
+
+    if (jobs && count > k_point_grain_size)
+        jobs->parallel_for(0, count, k_point_grain_size, query_range);
+    else
+        query_range(0, count);
+}
@@ -0,0 +1,847 @@
+#include "pch_hdr.hpp"
+
+#include <memory>
+#include <type_traits>
+
+#include <v8/base/job_system.hpp>
+#include <v8/math/simd/float4.hpp>
+#include <v8/math/mesh_normals.hpp>
+
+namespace {
+
+//
+// Faces are processed in blocks of this size, so that the per face vectors
+// stay in the L1 cache before being added to the vertices.
+const v8_size_t k_face_block        = 256;
+
+//
+// Faces per chunk, when the work is split across threads.
+const v8_size_t k_face_chunk        = 65536;
+
+//
+// Vertices are partitioned in buckets of 2^k_bucket_shift consecutive
+// vertices. Each bucket is accumulated by a single task, in a private
+// buffer small enough to stay in cache.
+const v8_uint32_t k_bucket_shift    = 12;
+const v8_size_t k_bucket_size       = v8_size_t(1) << k_bucket_shift;
+
+//
+// Minimum number of threads for which the partitioned (multithreaded) 
+// version is faster than the serial one.
+const v8_uint32_t k_min_parallel_threads = 4;
+
+//
+// Vertices are finalized in groups of this size (one SIMD register wide).
+const v8_size_t k_finalize_group    = 4;
+
+template<typename T>
+inline T* strided_at(T* first, v8_size_t stride, v8_size_t idx) {
+    return reinterpret_cast<T*>(
+        reinterpret_cast<typename std::conditional<
+            std::is_const<T>::value, const char*, char*>::type>(first)
+        + idx * stride);
+}
+
+inline void write_vector(
+    v8::math::vector3F* output, v8_size_t stride, v8_size_t idx, 
+    float x, float y, float z
+    ) {
+    v8::math::vector3F* dst = strided_at(output, stride, idx);
+    dst->x_ = x;
+    dst->y_ = y;
+    dst->z_ = z;
+}
+
+#if defined(V8_MATH_SIMD_ENABLED)
+
+using v8::math::simd::float4_t;
+
+inline float4_t dot4(
+    float4_t ax, float4_t ay, float4_t az,
+    float4_t bx, float4_t by, float4_t bz
+    ) {
+    using namespace v8::math::simd;
+    return add(add(mul(ax, bx), mul(ay, by)), mul(az, bz));
+}
+
+//
+// Scales (x, y, z) to unit length, lanes with zero length become zero.
+inline void normalize4(float4_t* x, float4_t* y, float4_t* z) {
+    using namespace v8::math::simd;
+    const float4_t len_sq = dot4(*x, *y, *z, *x, *y, *z);
+    const float4_t inv_len = select(
+        cmp_gt(len_sq, zero_float4()),
+        div(splat_float4(1.0f), square_root(len_sq)),
+        zero_float4());
+
+    *x = mul(*x, inv_len);
+    *y = mul(*y, inv_len);
+    *z = mul(*z, inv_len);
+}
+
+//
+// Stores the first count lanes of four SoA vectors as (x, y, z) rows.
+inline void store_rows(
+    float4_t x, float4_t y, float4_t z, float* rows, v8_size_t count
+    ) {
+    using namespace v8::math::simd;
+
+    float xs[4], ys[4], zs[4];
+    store_float4(xs, x);
+    store_float4(ys, y);
+    store_float4(zs, z);
+
+    for (v8_size_t lane = 0; lane < count; ++lane) {
+        rows[lane * 3 + 0] = xs[lane];
+        rows[lane * 3 + 1] = ys[lane];
+        rows[lane * 3 + 2] = zs[lane];
+    }
+}
+
+//
+// Loads up to four (x, y, z) rows in SoA form. Missing lanes are zero.
+inline void load_rows(
+    const float* rows, v8_size_t count, float4_t* x, float4_t* y, float4_t* z
+    ) {
+    using namespace v8::math::simd;
+
+    float xs[4] = { 0.0f }, ys[4] = { 0.0f }, zs[4] = { 0.0f };
+    for (v8_size_t lane = 0; lane < count; ++lane) {
+        xs[lane] = rows[lane * 3 + 0];
+        ys[lane] = rows[lane * 3 + 1];
+        zs[lane] = rows[lane * 3 + 2];
+    }
+
+    *x = load_float4(xs);
+    *y = load_float4(ys);
+    *z = load_float4(zs);
+}
+
+//
+// Writes the first count lanes of four SoA vectors to consecutive vertices.
+inline void write_vectors4(
+    v8::math::vector3F* output, v8_size_t stride,
+    v8_size_t first_vertex, v8_size_t count,
+    float4_t x, float4_t y, float4_t z
+    ) {
+    float rows[4 * 3];
+    store_rows(x, y, z, rows, count);
+
+    for (v8_size_t lane = 0; lane < count; ++lane) {
+        write_vector(output, stride, first_vertex + lane, 
+                     rows[lane * 3 + 0], rows[lane * 3 + 1], rows[lane * 3 + 2]);
+    }
+}
+
+//
+// Positions of the corners of up to four consecutive faces, in SoA form.
+// Lanes past the last face repeat the last face.
+struct face_block {
+    float4_t    fb_x[3];
+    float4_t    fb_y[3];
+    float4_t    fb_z[3];
+};
+
+inline v8_size_t block_lane_face(
+    v8_size_t first_face, v8_size_t lane, v8_size_t face_count
+    ) {
+    return lane < face_count ? first_face + lane : first_face + face_count - 1;
+}
+
+inline void load_face_block(
+    const v8::math::vector3F*   positions,
+    v8_size_t                   position_stride,
+    const v8_uint32_t*          indices,
+    v8_size_t                   first_face,
+    v8_size_t                   face_count,
+    face_block*                 block
+    ) {
+    using namespace v8::math;
+
+    float x[3][4];
+    float y[3][4];
+    float z[3][4];
+
+    for (v8_size_t lane = 0; lane < 4; ++lane) {
+        const v8_size_t face = block_lane_face(first_face, lane, face_count);
+        for (v8_size_t corner = 0; corner < 3; ++corner) {
+            const vector3F* pos = strided_at(
+                positions, position_stride, indices[face * 3 + corner]);
+            x[corner][lane] = pos->x_;
+            y[corner][lane] = pos->y_;
+            z[corner][lane] = pos->z_;
+        }
+    }
+
+    for (v8_size_t corner = 0; corner < 3; ++corner) {
+        block->fb_x[corner] = simd::load_float4(x[corner]);
+        block->fb_y[corner] = simd::load_float4(y[corner]);
+        block->fb_z[corner] = simd::load_float4(z[corner]);
+    }
+}
+
+#else /* V8_MATH_SIMD_ENABLED */
+
+//
+// Without SIMD, the float4 emulation is slower than plain per element loops.
+inline float dot_rows(const float* a, const float* b) {
+    return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+//
+// Scales the row to unit length, a zero length row stays zero.
+inline void normalize_row(float* row) {
+    const float len_sq = dot_rows(row, row);
+    const float inv_len = len_sq > 0.0f ? 1.0f / std::sqrt(len_sq) : 0.0f;
+
+    row[0] *= inv_len;
+    row[1] *= inv_len;
+    row[2] *= inv_len;
+}
+
+inline void edge_row(
+    const v8::math::vector3F& from, const v8::math::vector3F& to, float* row
+    ) {
+    row[0] = to.x_ - from.x_;
+    row[1] = to.y_ - from.y_;
+    row[2] = to.z_ - from.z_;
+}
+
+#endif /* !V8_MATH_SIMD_ENABLED */
+
+//
+// Face normals. With area weighting the face vector is the unnormalized
+// cross product of two edges (its length is twice the face area). With
+// angle weighting it is the unit normal, weighted at each corner by the
+// angle of the triangle at that corner.
+class face_normal_kernel {
+public :
+    face_normal_kernel(
+        const v8::math::vector3F*   positions,
+        v8_size_t                   position_stride,
+        const v8_uint32_t*          indices,
+        v8::math::Normal_Weight     weighting
+        )
+        :   positions_(positions), position_stride_(position_stride),
+            indices_(indices), weighting_(weighting) {}
+
+    bool has_corner_weights() const {
+        return weighting_ == v8::math::Normal_Weight_Angle;
+    }
+
+    void operator()(
+        v8_size_t first_face, v8_size_t face_count,
+        float* face_rows, float* corner_weights
+        ) const;
+
+private :
+    void angle_weighted(
+        v8_size_t first_face, v8_size_t face_count,
+        float* face_rows, float* corner_weights
+        ) const;
+
+    const v8::math::vector3F*   positions_;
+    v8_size_t                   position_stride_;
+    const v8_uint32_t*          indices_;
+    v8::math::Normal_Weight     weighting_;
+};
+
+void face_normal_kernel::operator()(
+    v8_size_t   first_face,
+    v8_size_t   face_count,
+    float*      face_rows,
+    float*      corner_weights
+    ) const {
+    using namespace v8::math;
+
+    if (has_corner_weights()) {
+        angle_weighted(first_face, face_count, face_rows, corner_weights);
+        return;
+    }
+
+    //
+    // Gathering four faces into SIMD registers costs more than the 
+    // cross product it saves, so the area weighted path stays scalar.
+    for (v8_size_t i = 0; i < face_count; ++i) {
+        const v8_uint32_t* face = indices_ + (first_face + i) * 3;
+        const vector3F& p0 = *strided_at(positions_, position_stride_, face[0]);
+        const vector3F& p1 = *strided_at(positions_, position_stride_, face[1]);
+        const vector3F& p2 = *strided_at(positions_, position_stride_, face[2]);
+
+        const float ax = p1.x_ - p0.x_;
+        const float ay = p1.y_ - p0.y_;
+        const float az = p1.z_ - p0.z_;
+        const float bx = p2.x_ - p0.x_;
+        const float by = p2.y_ - p0.y_;
+        const float bz = p2.z_ - p0.z_;
+
+        float* row = face_rows + i * 3;
+        row[0] = ay * bz - az * by;
+        row[1] = az * bx - ax * bz;
+        row[2] = ax * by - ay * bx;
+    }
+}
+
+//
+// Lengyel's per face tangent : the direction in which the u texture
+// coordinate increases. Faces with a degenerate texture mapping get a zero
+// tangent.
+class face_tangent_kernel {
+public :
+    face_tangent_kernel(
+        const v8::math::vector3F*   positions,
+        v8_size_t                   position_stride,
+        const v8::math::vector2F*   texcoords,
+        v8_size_t                   texcoord_stride,
+        const v8_uint32_t*          indices
+        )
+        :   positions_(positions), position_stride_(position_stride),
+            texcoords_(texcoords), texcoord_stride_(texcoord_stride),
+            indices_(indices) {}
+
+    bool has_corner_weights() const {
+        return false;
+    }
+
+    void operator()(
+        v8_size_t first_face, v8_size_t face_count,
+        float* face_rows, float* corner_weights
+        ) const;
+
+private :
+    const v8::math::vector3F*   positions_;
+    v8_size_t                   position_stride_;
+    const v8::math::vector2F*   texcoords_;
+    v8_size_t                   texcoord_stride_;
+    const v8_uint32_t*          indices_;
+};
+
+//
+// Turns the summed face vectors of (up to) k_finalize_group consecutive
+// vertices, given as (x, y, z) rows, into the final vertex vectors and 
+// writes them.
+class normal_finalizer {
+public :
+    normal_finalizer(v8::math::vector3F* normals, v8_size_t normal_stride)
+        : normals_(normals), normal_stride_(normal_stride) {}
+
+    void operator()(
+        v8_size_t first_vertex, v8_size_t count, const float* rows
+        ) const;
+
+private :
+    v8::math::vector3F*     normals_;
+    v8_size_t               normal_stride_;
+};
+
+class tangent_finalizer {
+public :
+    tangent_finalizer(
+        const v8::math::vector3F*   normals,
+        v8_size_t                   normal_stride,
+        v8::math::vector3F*         tangents,
+        v8_size_t                   tangent_stride
+        )
+        :   normals_(normals), normal_stride_(normal_stride),
+            tangents_(tangents), tangent_stride_(tangent_stride) {}
+
+    void operator()(
+        v8_size_t first_vertex, v8_size_t count, const float* rows
+        ) const;
+
+private :
+    const v8::math::vector3F*   normals_;
+    v8_size_t                   normal_stride_;
+    v8::math::vector3F*         tangents_;
+    v8_size_t                   tangent_stride_;
+};
+
+#if defined(V8_MATH_SIMD_ENABLED)
+
+void face_normal_kernel::angle_weighted(
+    v8_size_t   first_face,
+    v8_size_t   face_count,
+    float*      face_rows,
+    float*      corner_weights
+    ) const {
+    using namespace v8::math;
+    using namespace v8::math::simd;
+
+    for (v8_size_t i = 0; i < face_count; i += 4) {
+        const v8_size_t lanes = min(face_count - i, v8_size_t(4));
+
+        face_block fb;
+        load_face_block(
+            positions_, position_stride_, indices_, first_face + i, lanes, &fb);
+
+        float4_t ax = sub(fb.fb_x[1], fb.fb_x[0]);
+        float4_t ay = sub(fb.fb_y[1], fb.fb_y[0]);
+        float4_t az = sub(fb.fb_z[1], fb.fb_z[0]);
+        float4_t bx = sub(fb.fb_x[2], fb.fb_x[0]);
+        float4_t by = sub(fb.fb_y[2], fb.fb_y[0]);
+        float4_t bz = sub(fb.fb_z[2], fb.fb_z[0]);
+
+        float4_t nx = sub(mul(ay, bz), mul(az, by));
+        float4_t ny = sub(mul(az, bx), mul(ax, bz));
+        float4_t nz = sub(mul(ax, by), mul(ay, bx));
+        normalize4(&nx, &ny, &nz);
+
+        float4_t cx = sub(fb.fb_x[2], fb.fb_x[1]);
+        float4_t cy = sub(fb.fb_y[2], fb.fb_y[1]);
+        float4_t cz = sub(fb.fb_z[2], fb.fb_z[1]);
+        normalize4(&ax, &ay, &az);
+        normalize4(&bx, &by, &bz);
+        normalize4(&cx, &cy, &cz);
+
+        //
+        // Cosines of the angles at corners 0, 1 and 2.
+        float cosines[3][4];
+        store_float4(cosines[0], dot4(ax, ay, az, bx, by, bz));
+        store_float4(cosines[1], negate(dot4(ax, ay, az, cx, cy, cz)));
+        store_float4(cosines[2], dot4(bx, by, bz, cx, cy, cz));
+
+        for (v8_size_t lane = 0; lane < lanes; ++lane) {
+            for (v8_size_t corner = 0; corner < 3; ++corner) {
+                corner_weights[(i + lane) * 3 + corner] =
+                    acosf(clamp(cosines[corner][lane], -1.0f, 1.0f));
+            }
+        }
+
+        store_rows(nx, ny, nz, face_rows + i * 3, lanes);
+    }
+}
+
+void face_tangent_kernel::operator()(
+    v8_size_t   first_face,
+    v8_size_t   face_count,
+    float*      face_rows,
+    float*      /* corner_weights */
+    ) const {
+    using namespace v8::math;
+    using namespace v8::math::simd;
+
+    for (v8_size_t i = 0; i < face_count; i += 4) {
+        const v8_size_t lanes = min(face_count - i, v8_size_t(4));
+
+        face_block fb;
+        load_face_block(
+            positions_, position_stride_, indices_, first_face + i, lanes, &fb);
+
+        float u[3][4];
+        float v[3][4];
+        for (v8_size_t lane = 0; lane < 4; ++lane) {
+            const v8_size_t face = block_lane_face(first_face + i, lane, lanes);
+            for (v8_size_t corner = 0; corner < 3; ++corner) {
+                const vector2F* uv = strided_at(
+                    texcoords_, texcoord_stride_, indices_[face * 3 + corner]);
+                u[corner][lane] = uv->x_;
+                v[corner][lane] = uv->y_;
+            }
+        }
+
+        const float4_t du1 = sub(load_float4(u[1]), load_float4(u[0]));
+        const float4_t dv1 = sub(load_float4(v[1]), load_float4(v[0]));
+        const float4_t du2 = sub(load_float4(u[2]), load_float4(u[0]));
+        const float4_t dv2 = sub(load_float4(v[2]), load_float4(v[0]));
+
+        const float4_t det = sub(mul(du1, dv2), mul(du2, dv1));
+        const float4_t inv_det = select(
+            cmp_gt(maximum(det, negate(det)), splat_float4(1.0e-20f)),
+            div(splat_float4(1.0f), det),
+            zero_float4());
+
+        const float4_t tx = mul(sub(
+            mul(sub(fb.fb_x[1], fb.fb_x[0]), dv2),
+            mul(sub(fb.fb_x[2], fb.fb_x[0]), dv1)), inv_det);
+        const float4_t ty = mul(sub(
+            mul(sub(fb.fb_y[1], fb.fb_y[0]), dv2),
+            mul(sub(fb.fb_y[2], fb.fb_y[0]), dv1)), inv_det);
+        const float4_t tz = mul(sub(
+            mul(sub(fb.fb_z[1], fb.fb_z[0]), dv2),
+            mul(sub(fb.fb_z[2], fb.fb_z[0]), dv1)), inv_det);
+
+        store_rows(tx, ty, tz, face_rows + i * 3, lanes);
+    }
+}
+
+void normal_finalizer::operator()(
+    v8_size_t first_vertex, v8_size_t count, const float* rows
+    ) const {
+    float4_t x, y, z;
+    load_rows(rows, count, &x, &y, &z);
+    normalize4(&x, &y, &z);
+    write_vectors4(normals_, normal_stride_, first_vertex, count, x, y, z);
+}
+
+void tangent_finalizer::operator()(
+    v8_size_t first_vertex, v8_size_t count, const float* rows
+    ) const {
+    using namespace v8::math::simd;
+
+    float normal_rows[4 * 3];
+    for (v8_size_t lane = 0; lane < count; ++lane) {
+        const v8::math::vector3F* n = strided_at(
+            normals_, normal_stride_, first_vertex + lane);
+        normal_rows[lane * 3 + 0] = n->x_;
+        normal_rows[lane * 3 + 1] = n->y_;
+        normal_rows[lane * 3 + 2] = n->z_;
+    }
+
+    float4_t tx, ty, tz;
+    float4_t nx, ny, nz;
+    load_rows(rows, count, &tx, &ty, &tz);
+    load_rows(normal_rows, count, &nx, &ny, &nz);
+
+    //
+    // Gram-Schmidt : t = normalize(t - n * dot(n, t)).
+    const float4_t n_dot_t = dot4(nx, ny, nz, tx, ty, tz);
+
+    tx = sub(tx, mul(nx, n_dot_t));
+    ty = sub(ty, mul(ny, n_dot_t));
+    tz = sub(tz, mul(nz, n_dot_t));
+
+    normalize4(&tx, &ty, &tz);
+    write_vectors4(tangents_, tangent_stride_, first_vertex, count, tx, ty, tz);
+}
+
+#else /* V8_MATH_SIMD_ENABLED */
+
+void face_normal_kernel::angle_weighted(
+    v8_size_t   first_face,
+    v8_size_t   face_count,
+    float*      face_rows,
+    float*      corner_weights
+    ) const {
+    using namespace v8::math;
+
+    for (v8_size_t i = 0; i < face_count; ++i) {
+        const v8_uint32_t* face = indices_ + (first_face + i) * 3;
+        const vector3F& p0 = *strided_at(positions_, position_stride_, face[0]);
+        const vector3F& p1 = *strided_at(positions_, position_stride_, face[1]);
+        const vector3F& p2 = *strided_at(positions_, position_stride_, face[2]);
+
+        float a[3], b[3], c[3];
+        edge_row(p0, p1, a);
+        edge_row(p0, p2, b);
+        edge_row(p1, p2, c);
+
+        float* row = face_rows + i * 3;
+        row[0] = a[1] * b[2] - a[2] * b[1];
+        row[1] = a[2] * b[0] - a[0] * b[2];
+        row[2] = a[0] * b[1] - a[1] * b[0];
+        normalize_row(row);
+
+        normalize_row(a);
+        normalize_row(b);
+        normalize_row(c);
+
+        //
+        // Angles at corners 0, 1 and 2.
+        float* weights = corner_weights + i * 3;
+        weights[0] = acosf(clamp(dot_rows(a, b), -1.0f, 1.0f));
+        weights[1] = acosf(clamp(-dot_rows(a, c), -1.0f, 1.0f));
+        weights[2] = acosf(clamp(dot_rows(b, c), -1.0f, 1.0f));
+    }
+}
+
+void face_tangent_kernel::operator()(
+    v8_size_t   first_face,
+    v8_size_t   face_count,
+    float*      face_rows,
+    float*      /* corner_weights */
+    ) const {
+    using namespace v8::math;
+
+    for (v8_size_t i = 0; i < face_count; ++i) {
+        const v8_uint32_t* face = indices_ + (first_face + i) * 3;
+        const vector3F& p0 = *strided_at(positions_, position_stride_, face[0]);
+        const vector3F& p1 = *strided_at(positions_, position_stride_, face[1]);
+        const vector3F& p2 = *strided_at(positions_, position_stride_, face[2]);
+        const vector2F& uv0 = *strided_at(texcoords_, texcoord_stride_, face[0]);
+        const vector2F& uv1 = *strided_at(texcoords_, texcoord_stride_, face[1]);
+        const vector2F& uv2 = *strided_at(texcoords_, texcoord_stride_, face[2]);
+
+        const float du1 = uv1.x_ - uv0.x_;
+        const float dv1 = uv1.y_ - uv0.y_;
+        const float du2 = uv2.x_ - uv0.x_;
+        const float dv2 = uv2.y_ - uv0.y_;
+
+        const float det = du1 * dv2 - du2 * dv1;
+        const float inv_det = std::fabs(det) > 1.0e-20f ? 1.0f / det : 0.0f;
+
+        float e1[3], e2[3];
+        edge_row(p0, p1, e1);
+        edge_row(p0, p2, e2);
+
+        float* row = face_rows + i * 3;
+        row[0] = (e1[0] * dv2 - e2[0] * dv1) * inv_det;
+        row[1] = (e1[1] * dv2 - e2[1] * dv1) * inv_det;
+        row[2] = (e1[2] * dv2 - e2[2] * dv1) * inv_det;
+    }
+}
+
+void normal_finalizer::operator()(
+    v8_size_t first_vertex, v8_size_t count, const float* rows
+    ) const {
+    for (v8_size_t i = 0; i < count; ++i) {
+        float n[3] = { rows[i * 3 + 0], rows[i * 3 + 1], rows[i * 3 + 2] };
+        normalize_row(n);
+        write_vector(normals_, normal_stride_, first_vertex + i, n[0], n[1], n[2]);
+    }
+}
+
+void tangent_finalizer::operator()(
+    v8_size_t first_vertex, v8_size_t count, const float* rows
+    ) const {
+    for (v8_size_t i = 0; i < count; ++i) {
+        const v8::math::vector3F* normal = strided_at(
+            normals_, normal_stride_, first_vertex + i);
+        const float n[3] = { normal->x_, normal->y_, normal->z_ };
+        float t[3] = { rows[i * 3 + 0], rows[i * 3 + 1], rows[i * 3 + 2] };
+
+        //
+        // Gram-Schmidt : t = normalize(t - n * dot(n, t)).
+        const float n_dot_t = dot_rows(n, t);
+        t[0] -= n[0] * n_dot_t;
+        t[1] -= n[1] * n_dot_t;
+        t[2] -= n[2] * n_dot_t;
+
+        normalize_row(t);
+        write_vector(tangents_, tangent_stride_, first_vertex + i, t[0], t[1], t[2]);
+    }
+}
+
+#endif /* !V8_MATH_SIMD_ENABLED */
+
+//
+// Single threaded version : the face vectors are added straight into the
+// output array, which is then finalized in place.
+template<typename face_kernel, typename finalizer>
+void accumulate_serial(
+    const face_kernel&      kernel,
+    const finalizer&        finish,
+    const v8_uint32_t*      indices,
+    v8_size_t               face_count,
+    v8::math::vector3F*     output,
+    v8_size_t               output_stride,
+    v8_size_t               vertex_count
+    ) {
+    using namespace v8::math;
+
+    for (v8_size_t v = 0; v < vertex_count; ++v)
+        *strided_at(output, output_stride, v) = vector3F::zero;
+
+    float face_rows[k_face_block * 3];
+    float corner_weights[k_face_block * 3];
+
+    for (v8_size_t first = 0; first < face_count; first += k_face_block) {
+        const v8_size_t count = min(face_count - first, k_face_block);
+        kernel(first, count, face_rows, corner_weights);
+
+        for (v8_size_t f = 0; f < count; ++f) {
+            const float* row = face_rows + f * 3;
+            for (v8_size_t corner = 0; corner < 3; ++corner) {
+                const float weight = kernel.has_corner_weights() ?
+                    corner_weights[f * 3 + corner] : 1.0f;
+
+                vector3F* dst = strided_at(
+                    output, output_stride, indices[(first + f) * 3 + corner]);
+                dst->x_ += row[0] * weight;
+                dst->y_ += row[1] * weight;
+                dst->z_ += row[2] * weight;
+            }
+        }
+    }
+
+    for (v8_size_t v = 0; v < vertex_count; v += k_finalize_group) {
+        const v8_size_t lanes = min(vertex_count - v, k_finalize_group);
+
+        float rows[k_finalize_group * 3];
+        for (v8_size_t lane = 0; lane < lanes; ++lane) {
+            const vector3F* src = strided_at(output, output_stride, v + lane);
+            rows[lane * 3 + 0] = src->x_;
+            rows[lane * 3 + 1] = src->y_;
+            rows[lane * 3 + 2] = src->z_;
+        }
+
+        finish(v, lanes, rows);
+    }
+}
+
+//
+// Multithreaded version. Writing to a vertex shared by faces of different
+// chunks would be a data race, so corners are first partitioned by vertex
+// bucket (a counting sort, done per face chunk), then each bucket sums
+// its own corners :
+//  1. (parallel over face chunks) face vectors and per chunk bucket counts.
+//  2. (serial) prefix sums of the counts, bucket major, chunk minor.
+//  3. (parallel over face chunks) each chunk writes its corners into
+//     the slots of its buckets.
+//  4. (parallel over buckets) sum the corners of the bucket into a small
+//     private buffer, finalize and write out.
+// Corners reach each bucket in face order, so every vertex sums its faces
+// in the same order as accumulate_serial and the results are identical.
+template<typename face_kernel, typename finalizer>
+void accumulate_parallel(
+    v8::base::job_system*   jobs,
+    const face_kernel&      kernel,
+    const finalizer&        finish,
+    const v8_uint32_t*      indices,
+    v8_size_t               face_count,
+    v8_size_t               vertex_count
+    ) {
+    using namespace v8::math;
+
+    const v8_size_t chunk_count = (face_count + k_face_chunk - 1) / k_face_chunk;
+    const v8_size_t bucket_count = (vertex_count + k_bucket_size - 1) >> k_bucket_shift;
+
+    //
+    // Scratch arrays are written in full before being read, so they are
+    // left uninitialized.
+    std::unique_ptr<float[]> face_rows(new float[face_count * 3]);
+    std::unique_ptr<float[]> corner_weights(
+        kernel.has_corner_weights() ? new float[face_count * 3] : nullptr);
+    std::vector<v8_uint32_t> slots(chunk_count * bucket_count, 0);
+
+    jobs->parallel_for(0, chunk_count, 1,
+        [&](v8_size_t first_chunk, v8_size_t last_chunk) {
+        for (v8_size_t chunk = first_chunk; chunk < last_chunk; ++chunk) {
+            const v8_size_t first = chunk * k_face_chunk;
+            const v8_size_t count = min(face_count - first, k_face_chunk);
+
+            kernel(first, count, &face_rows[first * 3],
+                   corner_weights ? &corner_weights[first * 3] : nullptr);
+
+            v8_uint32_t* chunk_slots = &slots[chunk * bucket_count];
+            for (v8_size_t c = first * 3; c < (first + count) * 3; ++c)
+                ++chunk_slots[indices[c] >> k_bucket_shift];
+        }
+    });
+
+    std::vector<v8_uint32_t> bucket_first(bucket_count + 1);
+    v8_uint32_t running = 0;
+    for (v8_size_t bucket = 0; bucket < bucket_count; ++bucket) {
+        bucket_first[bucket] = running;
+        for (v8_size_t chunk = 0; chunk < chunk_count; ++chunk) {
+            const v8_uint32_t count = slots[chunk * bucket_count + bucket];
+            slots[chunk * bucket_count + bucket] = running;
+            running += count;
+        }
+    }
+    bucket_first[bucket_count] = running;
+
+    std::unique_ptr<v8_uint32_t[]> sorted_corners(new v8_uint32_t[face_count * 3]);
+    jobs->parallel_for(0, chunk_count, 1,
+        [&](v8_size_t first_chunk, v8_size_t last_chunk) {
+        for (v8_size_t chunk = first_chunk; chunk < last_chunk; ++chunk) {
+            const v8_size_t first = chunk * k_face_chunk;
+            const v8_size_t count = min(face_count - first, k_face_chunk);
+
+            v8_uint32_t* chunk_slots = &slots[chunk * bucket_count];
+            for (v8_size_t c = first * 3; c < (first + count) * 3; ++c) {
+                sorted_corners[chunk_slots[indices[c] >> k_bucket_shift]++] =
+                    static_cast<v8_uint32_t>(c);
+            }
+        }
+    });
+
+    jobs->parallel_for(0, bucket_count, 1,
+        [&](v8_size_t first_bucket, v8_size_t last_bucket) {
+        std::vector<float> sums(k_bucket_size * 3);
+
+        for (v8_size_t bucket = first_bucket; bucket < last_bucket; ++bucket) {
+            const v8_size_t first_vertex = bucket << k_bucket_shift;
+            const v8_size_t bucket_vertices =
+                min(vertex_count - first_vertex, k_bucket_size);
+
+            std::fill(sums.begin(), sums.begin() + bucket_vertices * 3, 0.0f);
+
+            for (v8_uint32_t i = bucket_first[bucket];
+                 i < bucket_first[bucket + 1]; ++i) {
+                const v8_uint32_t corner = sorted_corners[i];
+                const float* row = &face_rows[(corner / 3) * 3];
+                float* sum = &sums[(indices[corner] - first_vertex) * 3];
+                const float weight = corner_weights ? corner_weights[corner] : 1.0f;
+
+                sum[0] += row[0] * weight;
+                sum[1] += row[1] * weight;
+                sum[2] += row[2] * weight;
+            }
+
+            for (v8_size_t v = 0; v < bucket_vertices; v += k_finalize_group) {
+                const v8_size_t lanes = min(bucket_vertices - v, k_finalize_group);
+                finish(first_vertex + v, lanes, &sums[v * 3]);
+            }
+        }
+    });
+}
+
+template<typename face_kernel, typename finalizer>
+void accumulate_vertex_vectors(
+    v8::base::job_system*   jobs,
+    const face_kernel&      kernel,
+    const finalizer&        finish,
+    const v8_uint32_t*      indices,
+    v8_size_t               face_count,
+    v8::math::vector3F*     output,
+    v8_size_t               output_stride,
+    v8_size_t               vertex_count
+    ) {
+    if (!vertex_count)
+        return;
+
+    //
+    // The partitioned version does about three times the work of the serial
+    // one (two extra passes over the corners and the scratch arrays), so it 
+    // is only used with enough threads and enough faces to split.
+    if (!jobs || jobs->get_thread_count() < k_min_parallel_threads 
+        || face_count <= k_face_chunk) {
+        accumulate_serial(kernel, finish, indices, face_count,
+                          output, output_stride, vertex_count);
+        return;
+    }
+
+    accumulate_parallel(jobs, kernel, finish, indices, face_count, vertex_count);
+}
+
+} // anonymous namespace
+
+void v8::math::compute_vertex_normals(
+    const vector3F*         positions,
+    v8_size_t               position_stride,
+    vector3F*               normals,
+    v8_size_t               normal_stride,
+    v8_size_t               vertex_count,
+    const v8_uint32_t*      indices,
+    v8_size_t               face_count,
+    Normal_Weight           weighting,
+    base::job_system*       jobs
+    ) {
+    accumulate_vertex_vectors(
+        jobs,
+        face_normal_kernel(positions, position_stride, indices, weighting),
+        normal_finalizer(normals, normal_stride),
+        indices, face_count, normals, normal_stride, vertex_count);
+}
+
+void v8::math::compute_vertex_tangents(
+    const vector3F*         positions,
+    v8_size_t               position_stride,
+    const vector3F*         normals,
+    v8_size_t               normal_stride,
+    const vector2F*         texcoords,
+    v8_size_t               texcoord_stride,
+    vector3F*               tangents,
+    v8_size_t               tangent_stride,
+    v8_size_t               vertex_count,
+    const v8_uint32_t*      indices,
+    v8_size_t               face_count,
+    base::job_system*       jobs
+    ) {
+    accumulate_vertex_vectors(
+        jobs,
+        face_tangent_kernel(
+            positions, position_stride, texcoords, texcoord_stride, indices),
+        tangent_finalizer(normals, normal_stride, tangents, tangent_stride),
+        indices, face_count, tangents, tangent_stride, vertex_count);
+}
@@ -0,0 +1,356 @@
+#include "pch_hdr.hpp"
+
+#include <v8/math/simd/float4.hpp>
+#include <v8/math/mesh_streams.hpp>
+
+namespace {
+
+const v8_uint32_t k_stream_bits[] = {
+    v8::math::Mesh_Stream_Position, 
+    v8::math::Mesh_Stream_Normal,
+    v8::math::Mesh_Stream_Tangent,
+    v8::math::Mesh_Stream_Texcoord
+};
+
+const v8_size_t k_element_sizes[] = {
+    sizeof(v8::math::vector3F),
+    sizeof(v8::math::vector3F),
+    sizeof(v8::math::vector3F),
+    sizeof(v8::math::vector2F)
+};
+
+const v8_size_t k_max_streams = sizeof(k_stream_bits) / sizeof(k_stream_bits[0]);
+
+v8_int32_t layout_offset(const v8::math::vertex_layout_t& layout, v8_size_t stream) {
+    const v8_int32_t offsets[] = {
+        layout.vl_position, layout.vl_normal, layout.vl_tangent, 
+        layout.vl_texcoord
+    };
+
+    return offsets[stream];
+}
+
+//
+// One attribute copied between a stream and the interleaved vertices.
+struct attribute_copy_t {
+    v8_size_t   ac_offset;
+    v8_size_t   ac_size;
+    v8_uint8_t* ac_stream;
+
+    //
+    // True if vector3F values can be moved with 16 byte loads and stores
+    // (deinterleave() only).
+    bool        ac_wide;
+};
+
+//
+// Vertices are split into streams in blocks, one attribute at a time, so 
+// that the inner loops are simple strided copies and the block stays in 
+// the cache until all its attributes are read.
+const v8_size_t k_block_vertices = 256;
+
+template<v8_size_t attribute_size>
+inline void copy_attribute(
+    const v8_uint8_t*   src,
+    v8_size_t           src_stride,
+    v8_uint8_t*         dst,
+    v8_size_t           dst_stride,
+    v8_size_t           count,
+    bool                wide
+    ) {
+    using namespace v8::math::simd;
+
+    if (attribute_size == sizeof(v8::math::vector3F) && wide) {
+        for (v8_size_t i = 0; i < count; ++i) {
+            store_float4(reinterpret_cast<float*>(dst + i * dst_stride),
+                load_float4(reinterpret_cast<const float*>(src + i * src_stride)));
+        }
+        return;
+    }
+
+    for (v8_size_t i = 0; i < count; ++i)
+        memcpy(dst + i * dst_stride, src + i * src_stride, attribute_size);
+}
+
+inline void copy_attribute(
+    const v8_uint8_t*   src,
+    v8_size_t           src_stride,
+    v8_uint8_t*         dst,
+    v8_size_t           dst_stride,
+    v8_size_t           count,
+    v8_size_t           attribute_size,
+    bool                wide
+    ) {
+    if (attribute_size == sizeof(v8::math::vector3F)) {
+        copy_attribute<sizeof(v8::math::vector3F)>(
+            src, src_stride, dst, dst_stride, count, wide);
+    } else {
+        copy_attribute<sizeof(v8::math::vector2F)>(
+            src, src_stride, dst, dst_stride, count, wide);
+    }
+}
+
+v8_size_t collect_attributes(
+    const v8::math::vertex_layout_t&    layout,
+    v8_uint8_t* const                   (&streams)[k_max_streams],
+    attribute_copy_t                    (&attributes)[k_max_streams]
+    ) {
+    v8_size_t count = 0;
+
+    for (v8_size_t i = 0; i < k_max_streams; ++i) {
+        const v8_int32_t offset = layout_offset(layout, i);
+        if (!streams[i] || offset == v8::math::C_No_Attribute)
+            continue;
+
+        assert(offset + k_element_sizes[i] <= layout.vl_stride);
+
+        attribute_copy_t& attr = attributes[count++];
+        attr.ac_offset = static_cast<v8_size_t>(offset);
+        attr.ac_size = k_element_sizes[i];
+        attr.ac_stream = streams[i];
+        attr.ac_wide = false;
+    }
+
+    std::sort(attributes, attributes + count, 
+              [](const attribute_copy_t& lhs, const attribute_copy_t& rhs) {
+        return lhs.ac_offset < rhs.ac_offset;
+    });
+
+    return count;
+}
+
+} // anonymous namespace
+
+v8::math::mesh_streams::mesh_streams(v8_uint32_t stream_mask)
+    :   stream_mask_(0),
+        vertex_count_(0),
+        capacity_(0) {
+    for (v8_size_t i = 0; i < k_stream_count; ++i)
+        streams_[i].sb_data = nullptr;
+
+    set_stream_mask(stream_mask);
+}
+
+void v8::math::mesh_streams::set_stream_mask(v8_uint32_t stream_mask) {
+    stream_mask &= Mesh_Stream_All;
+    const v8_uint32_t dropped = stream_mask_ & ~stream_mask;
+    const v8_uint32_t added = stream_mask & ~stream_mask_;
+
+    for (v8_size_t i = 0; i < k_stream_count; ++i) {
+        if (dropped & k_stream_bits[i]) {
+            streams_[i].sb_storage.reset();
+            streams_[i].sb_data = nullptr;
+        }
+    }
+
+    stream_mask_ &= ~dropped;
+    if (!added)
+        return;
+
+    //
+    // Streams are always allocated for the current capacity, with zeroed 
+    // content.
+    const v8_size_t capacity = capacity_;
+    for (v8_size_t i = 0; i < k_stream_count; ++i) {
+        if (!(added & k_stream_bits[i]))
+            continue;
+
+        const v8_size_t bytes = capacity * k_element_sizes[i] 
+            + 2 * C_Stream_Alignment;
+        streams_[i].sb_storage.reset(new v8_uint8_t[bytes]());
+
+        const v8_size_t address = 
+            reinterpret_cast<v8_size_t>(streams_[i].sb_storage.get());
+        streams_[i].sb_data = streams_[i].sb_storage.get() + 
+            ((C_Stream_Alignment - address % C_Stream_Alignment) 
+            % C_Stream_Alignment);
+    }
+
+    stream_mask_ |= added;
+}
+
+void v8::math::mesh_streams::reallocate(v8_size_t capacity) {
+    assert(capacity >= vertex_count_);
+
+    for (v8_size_t i = 0; i < k_stream_count; ++i) {
+        if (!(stream_mask_ & k_stream_bits[i]))
+            continue;
+
+        const v8_size_t bytes = capacity * k_element_sizes[i] 
+            + 2 * C_Stream_Alignment;
+        std::unique_ptr<v8_uint8_t[]> storage(new v8_uint8_t[bytes]());
+
+        const v8_size_t address = reinterpret_cast<v8_size_t>(storage.get());
+        v8_uint8_t* data = storage.get() + 
+            ((C_Stream_Alignment - address % C_Stream_Alignment) 
+            % C_Stream_Alignment);
+
+        if (vertex_count_)
+            memcpy(data, streams_[i].sb_data, vertex_count_ * k_element_sizes[i]);
+
+        streams_[i].sb_storage = std::move(storage);
+        streams_[i].sb_data = data;
+    }
+
+    capacity_ = capacity;
+}
+
+void v8::math::mesh_streams::reserve(v8_size_t vertex_count) {
+    if (vertex_count > capacity_)
+        reallocate(vertex_count);
+}
+
+void v8::math::mesh_streams::resize(v8_size_t vertex_count) {
+    if (vertex_count > capacity_)
+        reallocate(std::max(vertex_count, capacity_ * 2));
+
+    if (vertex_count > vertex_count_) {
+        for (v8_size_t i = 0; i < k_stream_count; ++i) {
+            if (!(stream_mask_ & k_stream_bits[i]))
+                continue;
+
+            v8_uint8_t* data = static_cast<v8_uint8_t*>(streams_[i].sb_data);
+            memset(data + vertex_count_ * k_element_sizes[i], 0, 
+                   (vertex_count - vertex_count_) * k_element_sizes[i]);
+        }
+    }
+
+    vertex_count_ = vertex_count;
+}
+
+const void* 
+v8::math::mesh_streams::get_stream_data(Mesh_Stream stream) const {
+    for (v8_size_t i = 0; i < k_stream_count; ++i) {
+        if (k_stream_bits[i] == static_cast<v8_uint32_t>(stream))
+            return streams_[i].sb_data;
+    }
+
+    return nullptr;
+}
+
+v8_size_t 
+v8::math::mesh_streams::get_stream_element_size(Mesh_Stream stream) {
+    for (v8_size_t i = 0; i < k_max_streams; ++i) {
+        if (k_stream_bits[i] == static_cast<v8_uint32_t>(stream))
+            return k_element_sizes[i];
+    }
+
+    return 0;
+}
+
+void v8::math::mesh_streams::swap(mesh_streams& rhs) {
+    using std::swap;
+
+    for (v8_size_t i = 0; i < k_stream_count; ++i) {
+        swap(streams_[i].sb_storage, rhs.streams_[i].sb_storage);
+        swap(streams_[i].sb_data, rhs.streams_[i].sb_data);
+    }
+
+    swap(stream_mask_, rhs.stream_mask_);
+    swap(vertex_count_, rhs.vertex_count_);
+    swap(capacity_, rhs.capacity_);
+}
+
+void v8::math::mesh_streams::interleave(
+    void*                   vertices,
+    const vertex_layout_t&  layout,
+    v8_size_t               first,
+    v8_size_t               count
+    ) const {
+    assert(first + count <= vertex_count_);
+    if (!count)
+        return;
+
+    v8_uint8_t* const streams[k_max_streams] = {
+        static_cast<v8_uint8_t*>(streams_[k_position].sb_data),
+        static_cast<v8_uint8_t*>(streams_[k_normal].sb_data),
+        static_cast<v8_uint8_t*>(streams_[k_tangent].sb_data),
+        static_cast<v8_uint8_t*>(streams_[k_texcoord].sb_data)
+    };
+
+    attribute_copy_t attributes[k_max_streams];
+    const v8_size_t attribute_count = collect_attributes(
+        layout, streams, attributes);
+
+    for (v8_size_t i = 0; i < attribute_count; ++i)
+        attributes[i].ac_stream += first * attributes[i].ac_size;
+
+    //
+    // The destination is written sequentially, one whole vertex at a time.
+    // This plain loop is faster than blocked, per attribute, wide copies.
+    v8_uint8_t* dst = static_cast<v8_uint8_t*>(vertices);
+
+    for (v8_size_t v = 0; v < count; ++v) {
+        v8_uint8_t* vertex = dst + v * layout.vl_stride;
+
+        for (v8_size_t i = 0; i < attribute_count; ++i) {
+            const attribute_copy_t& attr = attributes[i];
+            if (attr.ac_size == sizeof(vector3F)) {
+                memcpy(vertex + attr.ac_offset, 
+                       attr.ac_stream + v * sizeof(vector3F), sizeof(vector3F));
+            } else {
+                memcpy(vertex + attr.ac_offset, 
+                       attr.ac_stream + v * sizeof(vector2F), sizeof(vector2F));
+            }
+        }
+    }
+}
+
+void v8::math::mesh_streams::deinterleave(
+    const void*             vertices,
+    const vertex_layout_t&  layout,
+    v8_size_t               count
+    ) {
+    vertex_count_ = 0;
+    reserve(count);
+    vertex_count_ = count;
+    if (!count)
+        return;
+
+    for (v8_size_t i = 0; i < k_stream_count; ++i) {
+        if (streams_[i].sb_data && layout_offset(layout, i) == C_No_Attribute)
+            memset(streams_[i].sb_data, 0, count * k_element_sizes[i]);
+    }
+
+    v8_uint8_t* const streams[k_max_streams] = {
+        static_cast<v8_uint8_t*>(streams_[k_position].sb_data),
+        static_cast<v8_uint8_t*>(streams_[k_normal].sb_data),
+        static_cast<v8_uint8_t*>(streams_[k_tangent].sb_data),
+        static_cast<v8_uint8_t*>(streams_[k_texcoord].sb_data)
+    };
+
+    attribute_copy_t attributes[k_max_streams];
+    const v8_size_t attribute_count = collect_attributes(
+        layout, streams, attributes);
+
+    //
+    // Loads past the end of an attribute stay inside the vertex buffer, 
+    // except possibly for the last vertex, which is copied separately. 
+    // Stores past the end of a stream element are overwritten by the next
+    // element, or land in the padding.
+    for (v8_size_t i = 0; i < attribute_count; ++i)
+        attributes[i].ac_wide = attributes[i].ac_size == sizeof(vector3F);
+
+    const v8_uint8_t* src = static_cast<const v8_uint8_t*>(vertices);
+    const v8_size_t wide_count = count - 1;
+
+    for (v8_size_t block = 0; block < wide_count; block += k_block_vertices) {
+        const v8_size_t block_count = 
+            std::min(k_block_vertices, wide_count - block);
+
+        for (v8_size_t i = 0; i < attribute_count; ++i) {
+            const attribute_copy_t& attr = attributes[i];
+            copy_attribute(
+                src + block * layout.vl_stride + attr.ac_offset, layout.vl_stride,
+                attr.ac_stream + block * attr.ac_size, attr.ac_size,
+                block_count, attr.ac_size, attr.ac_wide);
+        }
+    }
+
+    for (v8_size_t i = 0; i < attribute_count; ++i) {
+        const attribute_copy_t& attr = attributes[i];
+        memcpy(attr.ac_stream + wide_count * attr.ac_size, 
+               src + wide_count * layout.vl_stride + attr.ac_offset, 
+               attr.ac_size);
+    }
+}
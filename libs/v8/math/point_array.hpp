@@ -0,0 +1,95 @@
+//
+// Copyright (c) 2011, 2012, Adrian Hodos
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//     * Redistributions of source code must retain the above copyright
+//       notice, this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of the author nor the
+//       names of its contributors may be used to endorse or promote products
+//       derived from this software without specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+// ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+// WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE AUTHOR OR THE CONTRIBUTORS BE LIABLE FOR ANY
+// DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+// ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#pragma once
+
+/*!
+ * \file point_array.hpp
+ * \brief Strided view over vector3F points, shared by the containment
+ * builders. Internal to the library.
+ */
+
+#include <cstddef>
+
+#include <v8/math/vector3.hpp>
+#include <v8/math/simd/float4.hpp>
+
+namespace v8 { namespace math { namespace internals {
+
+class point_array {
+public :
+    point_array(const vector3F* points, size_t count, size_t stride)
+        :       base_(reinterpret_cast<const char*>(points))
+            ,   count_(count)
+            ,   stride_(stride)
+    {}
+
+    const float* operator[](size_t index) const {
+        return reinterpret_cast<const float*>(base_ + index * stride_);
+    }
+
+    size_t size() const {
+        return count_;
+    }
+
+    bool is_packed() const {
+        return stride_ == sizeof(vector3F);
+    }
+
+private :
+    const char* base_;
+    size_t      count_;
+    size_t      stride_;
+};
+
+//
+// Loads points [index, index + 4) in SoA form.
+inline void load_points(
+    const point_array&  points,
+    size_t              index,
+    simd::float4_t*     x,
+    simd::float4_t*     y,
+    simd::float4_t*     z
+    ) {
+    using namespace v8::math::simd;
+
+    if (points.is_packed()) {
+        load_xyz4(points[index], x, y, z);
+        return;
+    }
+
+    const float* p0 = points[index];
+    const float* p1 = points[index + 1];
+    const float* p2 = points[index + 2];
+    const float* p3 = points[index + 3];
+    *x = set_float4(p0[0], p1[0], p2[0], p3[0]);
+    *y = set_float4(p0[1], p1[1], p2[1], p3[1]);
+    *z = set_float4(p0[2], p1[2], p2[2], p3[2]);
+}
+
+} // namespace internals
+} // namespace math
+} // namespace v8
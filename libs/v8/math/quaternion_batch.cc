@@ -0,0 +1,646 @@
+#include "pch_hdr.hpp"
+
+#include <v8/math/simd/float4.hpp>
+#include <v8/math/quaternion.hpp>
+#include <v8/math/quaternion_batch.hpp>
+
+namespace {
+
+//
+// Eberly's slerp approximation, n = 8 terms. For i < 7 :
+// u[i] = 1 / ((i + 1) * (2i + 3)), v[i] = (i + 1) / (2i + 3); the last
+// pair is scaled by mu = 1.85298109240830, which minimizes the max error
+// of the weights over cos in [0, 1], t in [0, 1] (1.9e-5).
+const float k_slerp_u[8] = {
+    1.0f / (1.0f * 3.0f), 1.0f / (2.0f * 5.0f), 1.0f / (3.0f * 7.0f),
+    1.0f / (4.0f * 9.0f), 1.0f / (5.0f * 11.0f), 1.0f / (6.0f * 13.0f),
+    1.0f / (7.0f * 15.0f), 1.85298109240830f / (8.0f * 17.0f)
+};
+
+const float k_slerp_v[8] = {
+    1.0f / 3.0f, 2.0f / 5.0f, 3.0f / 7.0f, 4.0f / 9.0f, 5.0f / 11.0f,
+    6.0f / 13.0f, 7.0f / 15.0f, 1.85298109240830f * 8.0f / 17.0f
+};
+
+} // anonymous namespace
+
+#if defined(V8_MATH_SIMD_ENABLED)
+
+namespace {
+
+using v8::math::simd::float4_t;
+
+//
+// Above this cosine slerp degenerates to nlerp (same threshold as the
+// scalar slerp in quaternion.inl).
+const float k_slerp_nlerp_threshold = 0.9995f;
+
+//
+// Loads/stores of the last, incomplete, group of lanes go through a
+// temporary; unused lanes are zero and their results are discarded.
+inline float4_t load_lanes(const float* src, v8_size_t lanes) {
+    if (lanes == 4)
+        return v8::math::simd::load_float4(src);
+
+    float tmp[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+    for (v8_size_t i = 0; i < lanes; ++i)
+        tmp[i] = src[i];
+    return v8::math::simd::load_float4(tmp);
+}
+
+inline void store_lanes(float* dst, float4_t val, v8_size_t lanes) {
+    if (lanes == 4) {
+        v8::math::simd::store_float4(dst, val);
+        return;
+    }
+
+    float tmp[4];
+    v8::math::simd::store_float4(tmp, val);
+    for (v8_size_t i = 0; i < lanes; ++i)
+        dst[i] = tmp[i];
+}
+
+struct quat4 {
+    float4_t    w;
+    float4_t    x;
+    float4_t    y;
+    float4_t    z;
+
+    void load(
+        const v8::math::const_quaternion_soa_t& q, v8_size_t idx, v8_size_t lanes
+        ) {
+        w = load_lanes(q.qs_w + idx, lanes);
+        x = load_lanes(q.qs_x + idx, lanes);
+        y = load_lanes(q.qs_y + idx, lanes);
+        z = load_lanes(q.qs_z + idx, lanes);
+    }
+
+    void store(
+        const v8::math::quaternion_soa_t& q, v8_size_t idx, v8_size_t lanes
+        ) const {
+        store_lanes(q.qs_w + idx, w, lanes);
+        store_lanes(q.qs_x + idx, x, lanes);
+        store_lanes(q.qs_y + idx, y, lanes);
+        store_lanes(q.qs_z + idx, z, lanes);
+    }
+};
+
+inline float4_t dot(const quat4& a, const quat4& b) {
+    using namespace v8::math::simd;
+    return add(add(mul(a.w, b.w), mul(a.x, b.x)), add(mul(a.y, b.y), mul(a.z, b.z)));
+}
+
+//
+// Flips b, where needed, so that a and b are on the same hemisphere.
+// Returns the (now non negative) cosine of the angle between them.
+inline float4_t shortest_arc(const quat4& a, quat4* b) {
+    using namespace v8::math::simd;
+    const float4_t cos_theta = dot(a, *b);
+    const float4_t flip = cmp_lt(cos_theta, zero_float4());
+
+    b->w = select(flip, negate(b->w), b->w);
+    b->x = select(flip, negate(b->x), b->x);
+    b->y = select(flip, negate(b->y), b->y);
+    b->z = select(flip, negate(b->z), b->z);
+    return select(flip, negate(cos_theta), cos_theta);
+}
+
+inline quat4 weighted_sum(float4_t wa, const quat4& a, float4_t wb, const quat4& b) {
+    using namespace v8::math::simd;
+    quat4 r;
+    r.w = add(mul(wa, a.w), mul(wb, b.w));
+    r.x = add(mul(wa, a.x), mul(wb, b.x));
+    r.y = add(mul(wa, a.y), mul(wb, b.y));
+    r.z = add(mul(wa, a.z), mul(wb, b.z));
+    return r;
+}
+
+inline void scale(quat4* q, float4_t s) {
+    using namespace v8::math::simd;
+    q->w = mul(q->w, s);
+    q->x = mul(q->x, s);
+    q->y = mul(q->y, s);
+    q->z = mul(q->z, s);
+}
+
+//
+// acos(x), x in [0, 1]. Abramowitz & Stegun 4.4.46, |error| <= 2e-8.
+inline float4_t acos_unit(float4_t x) {
+    using namespace v8::math::simd;
+    float4_t p = splat_float4(-0.0012624911f);
+    p = add(mul(p, x), splat_float4(0.0066700901f));
+    p = add(mul(p, x), splat_float4(-0.0170881256f));
+    p = add(mul(p, x), splat_float4(0.0308918810f));
+    p = add(mul(p, x), splat_float4(-0.0501743046f));
+    p = add(mul(p, x), splat_float4(0.0889789874f));
+    p = add(mul(p, x), splat_float4(-0.2145988016f));
+    p = add(mul(p, x), splat_float4(1.5707963050f));
+
+    const float4_t one_minus_x = maximum(sub(splat_float4(1.0f), x), zero_float4());
+    return mul(square_root(one_minus_x), p);
+}
+
+//
+// sin(x), x in [0, pi/2]. Taylor series up to x^11, |error| <= 6e-8.
+inline float4_t sin_half_pi(float4_t x) {
+    using namespace v8::math::simd;
+    const float4_t x2 = mul(x, x);
+    const float4_t one = splat_float4(1.0f);
+
+    float4_t p = sub(one, mul(x2, splat_float4(1.0f / 110.0f)));
+    p = sub(one, mul(mul(x2, splat_float4(1.0f / 72.0f)), p));
+    p = sub(one, mul(mul(x2, splat_float4(1.0f / 42.0f)), p));
+    p = sub(one, mul(mul(x2, splat_float4(1.0f / 20.0f)), p));
+    p = sub(one, mul(mul(x2, splat_float4(1.0f / 6.0f)), p));
+    return mul(x, p);
+}
+
+quat4 nlerp4(const quat4& a, quat4 b, float4_t t) {
+    using namespace v8::math::simd;
+    shortest_arc(a, &b);
+
+    quat4 r = weighted_sum(sub(splat_float4(1.0f), t), a, t, b);
+    scale(&r, div(splat_float4(1.0f), square_root(dot(r, r))));
+    return r;
+}
+
+quat4 slerp_exact4(const quat4& a, quat4 b, float4_t t) {
+    using namespace v8::math::simd;
+    const float4_t cos_theta = shortest_arc(a, &b);
+    const float4_t near_parallel =
+        cmp_gt(cos_theta, splat_float4(k_slerp_nlerp_threshold));
+    const float4_t one = splat_float4(1.0f);
+    const float4_t s = sub(one, t);
+
+    const float4_t theta = acos_unit(cos_theta);
+    const float4_t inv_sin_theta = div(one, sin_half_pi(theta));
+    const float4_t wa = select(
+        near_parallel, s, mul(sin_half_pi(mul(s, theta)), inv_sin_theta));
+    const float4_t wb = select(
+        near_parallel, t, mul(sin_half_pi(mul(t, theta)), inv_sin_theta));
+
+    quat4 r = weighted_sum(wa, a, wb, b);
+    scale(&r, select(
+        near_parallel, div(one, square_root(dot(r, r))), one));
+    return r;
+}
+
+quat4 slerp_fast4(const quat4& a, quat4 b, float4_t t) {
+    using namespace v8::math::simd;
+    const float4_t x_minus_1 = sub(shortest_arc(a, &b), splat_float4(1.0f));
+    const float4_t one = splat_float4(1.0f);
+    const float4_t s = sub(one, t);
+    const float4_t t2 = mul(t, t);
+    const float4_t s2 = mul(s, s);
+
+    float4_t ct = one;
+    float4_t cs = one;
+    for (int i = 7; i >= 0; --i) {
+        const float4_t u = splat_float4(k_slerp_u[i]);
+        const float4_t v = splat_float4(k_slerp_v[i]);
+        const float4_t bt = mul(sub(mul(u, t2), v), x_minus_1);
+        const float4_t bs = mul(sub(mul(u, s2), v), x_minus_1);
+        ct = add(one, mul(bt, ct));
+        cs = add(one, mul(bs, cs));
+    }
+
+    return weighted_sum(mul(s, cs), a, mul(t, ct), b);
+}
+
+//
+// Interpolation parameter : one per element, or the same for all elements.
+struct param_array {
+    const float*    pa_values;
+
+    explicit param_array(const float* values) : pa_values(values) {}
+
+    float4_t load(v8_size_t idx, v8_size_t lanes) const {
+        return load_lanes(pa_values + idx, lanes);
+    }
+};
+
+struct param_uniform {
+    float4_t    pu_value;
+
+    explicit param_uniform(float value)
+        : pu_value(v8::math::simd::splat_float4(value)) {}
+
+    float4_t load(v8_size_t, v8_size_t) const {
+        return pu_value;
+    }
+};
+
+typedef quat4 (*interpolator)(const quat4&, quat4, float4_t);
+
+//
+// The interpolator is a template argument so that it gets inlined.
+template<interpolator interpolate, typename param_source>
+void interpolate_batch(
+    const v8::math::const_quaternion_soa_t& a,
+    const v8::math::const_quaternion_soa_t& b,
+    const param_source&                     t,
+    const v8::math::quaternion_soa_t&       out,
+    v8_size_t                               count
+    ) {
+    for (v8_size_t i = 0; i < count; i += 4) {
+        const v8_size_t lanes = std::min<v8_size_t>(4, count - i);
+        quat4 qa, qb;
+        qa.load(a, i, lanes);
+        qb.load(b, i, lanes);
+
+        interpolate(qa, qb, t.load(i, lanes)).store(out, i, lanes);
+    }
+}
+
+template<typename param_source>
+void slerp_batch(
+    const v8::math::const_quaternion_soa_t& a,
+    const v8::math::const_quaternion_soa_t& b,
+    const param_source&                     t,
+    const v8::math::quaternion_soa_t&       out,
+    v8_size_t                               count,
+    v8::math::Slerp_Mode                    mode
+    ) {
+    if (mode == v8::math::Slerp_Mode_Fast)
+        interpolate_batch<slerp_fast4>(a, b, t, out, count);
+    else
+        interpolate_batch<slerp_exact4>(a, b, t, out, count);
+}
+
+} // anonymous namespace
+
+void v8::math::quaternion_nlerp_batch(
+    const const_quaternion_soa_t&   a,
+    const const_quaternion_soa_t&   b,
+    const float*                    t,
+    const quaternion_soa_t&         out,
+    v8_size_t                       count
+    ) {
+    interpolate_batch<nlerp4>(a, b, param_array(t), out, count);
+}
+
+void v8::math::quaternion_nlerp_batch(
+    const const_quaternion_soa_t&   a,
+    const const_quaternion_soa_t&   b,
+    float                           t,
+    const quaternion_soa_t&         out,
+    v8_size_t                       count
+    ) {
+    interpolate_batch<nlerp4>(a, b, param_uniform(t), out, count);
+}
+
+void v8::math::quaternion_slerp_batch(
+    const const_quaternion_soa_t&   a,
+    const const_quaternion_soa_t&   b,
+    const float*                    t,
+    const quaternion_soa_t&         out,
+    v8_size_t                       count,
+    Slerp_Mode                      mode
+    ) {
+    slerp_batch(a, b, param_array(t), out, count, mode);
+}
+
+void v8::math::quaternion_slerp_batch(
+    const const_quaternion_soa_t&   a,
+    const const_quaternion_soa_t&   b,
+    float                           t,
+    const quaternion_soa_t&         out,
+    v8_size_t                       count,
+    Slerp_Mode                      mode
+    ) {
+    slerp_batch(a, b, param_uniform(t), out, count, mode);
+}
+
+void v8::math::quaternion_multiply_batch(
+    const const_quaternion_soa_t&   a,
+    const const_quaternion_soa_t&   b,
+    const quaternion_soa_t&         out,
+    v8_size_t                       count
+    ) {
+    using namespace v8::math::simd;
+
+    for (v8_size_t i = 0; i < count; i += 4) {
+        const v8_size_t lanes = std::min<v8_size_t>(4, count - i);
+        quat4 l, r;
+        l.load(a, i, lanes);
+        r.load(b, i, lanes);
+
+        quat4 p;
+        p.w = sub(sub(mul(l.w, r.w), mul(l.x, r.x)),
+                  add(mul(l.y, r.y), mul(l.z, r.z)));
+        p.x = add(add(mul(l.w, r.x), mul(r.w, l.x)),
+                  sub(mul(l.y, r.z), mul(l.z, r.y)));
+        p.y = add(add(mul(l.w, r.y), mul(r.w, l.y)),
+                  sub(mul(l.z, r.x), mul(l.x, r.z)));
+        p.z = add(add(mul(l.w, r.z), mul(r.w, l.z)),
+                  sub(mul(l.x, r.y), mul(l.y, r.x)));
+        p.store(out, i, lanes);
+    }
+}
+
+void v8::math::quaternion_rotate_batch(
+    const const_quaternion_soa_t&   q,
+    const const_vector3_soa_t&      v,
+    const vector3_soa_t&            out,
+    v8_size_t                       count
+    ) {
+    using namespace v8::math::simd;
+
+    for (v8_size_t i = 0; i < count; i += 4) {
+        const v8_size_t lanes = std::min<v8_size_t>(4, count - i);
+        quat4 r;
+        r.load(q, i, lanes);
+
+        const float4_t vx = load_lanes(v.vs_x + i, lanes);
+        const float4_t vy = load_lanes(v.vs_y + i, lanes);
+        const float4_t vz = load_lanes(v.vs_z + i, lanes);
+
+        //
+        // v' = (2w^2 - 1)v + 2(q.v)q + 2w(q x v)
+        const float4_t two = splat_float4(2.0f);
+        const float4_t dotp = mul(two,
+            add(add(mul(r.x, vx), mul(r.y, vy)), mul(r.z, vz)));
+        const float4_t cross_mul = mul(two, r.w);
+        const float4_t vmul = sub(mul(cross_mul, r.w), splat_float4(1.0f));
+
+        const float4_t ox = add(add(mul(vmul, vx), mul(dotp, r.x)),
+            mul(cross_mul, sub(mul(r.y, vz), mul(r.z, vy))));
+        const float4_t oy = add(add(mul(vmul, vy), mul(dotp, r.y)),
+            mul(cross_mul, sub(mul(r.z, vx), mul(r.x, vz))));
+        const float4_t oz = add(add(mul(vmul, vz), mul(dotp, r.z)),
+            mul(cross_mul, sub(mul(r.x, vy), mul(r.y, vx))));
+
+        store_lanes(out.vs_x + i, ox, lanes);
+        store_lanes(out.vs_y + i, oy, lanes);
+        store_lanes(out.vs_z + i, oz, lanes);
+    }
+}
+
+void v8::math::quaternion_to_matrix_batch(
+    const const_quaternion_soa_t&   q,
+    matrix_3X3F*                    out,
+    v8_size_t                       count
+    ) {
+    using namespace v8::math::simd;
+
+    for (v8_size_t i = 0; i < count; i += 4) {
+        const v8_size_t lanes = std::min<v8_size_t>(4, count - i);
+        quat4 r;
+        r.load(q, i, lanes);
+
+        const float4_t one = splat_float4(1.0f);
+        const float4_t s = div(splat_float4(2.0f), dot(r, r));
+        const float4_t xs = mul(r.x, s);
+        const float4_t ys = mul(r.y, s);
+        const float4_t zs = mul(r.z, s);
+        const float4_t wx = mul(r.w, xs);
+        const float4_t wy = mul(r.w, ys);
+        const float4_t wz = mul(r.w, zs);
+        const float4_t xx = mul(r.x, xs);
+        const float4_t xy = mul(r.x, ys);
+        const float4_t xz = mul(r.x, zs);
+        const float4_t yy = mul(r.y, ys);
+        const float4_t yz = mul(r.y, zs);
+        const float4_t zz = mul(r.z, zs);
+
+        //
+        // Elements a11 - a21 and a22 - a32 of the four matrices, transposed
+        // so that each register holds 4 consecutive elements of one matrix.
+        float4_t r0 = sub(one, add(yy, zz));
+        float4_t r1 = sub(xy, wz);
+        float4_t r2 = add(xz, wy);
+        float4_t r3 = add(xy, wz);
+        transpose(r0, r1, r2, r3);
+
+        float4_t r4 = sub(one, add(xx, zz));
+        float4_t r5 = sub(yz, wx);
+        float4_t r6 = sub(xz, wy);
+        float4_t r7 = add(yz, wx);
+        transpose(r4, r5, r6, r7);
+
+        float a33[4];
+        store_float4(a33, sub(one, add(xx, yy)));
+
+        const float4_t lo[4] = { r0, r1, r2, r3 };
+        const float4_t hi[4] = { r4, r5, r6, r7 };
+        for (v8_size_t m = 0; m < lanes; ++m) {
+            float* dst = out[i + m].elements_;
+            store_float4(dst, lo[m]);
+            store_float4(dst + 4, hi[m]);
+            dst[8] = a33[m];
+        }
+    }
+}
+
+#else /* V8_MATH_SIMD_ENABLED */
+
+//
+// Without SIMD, the float4 emulation is slower than plain per element loops.
+namespace {
+
+using v8::math::quaternionF;
+
+inline quaternionF load_quaternion(
+    const v8::math::const_quaternion_soa_t& q, v8_size_t idx
+    ) {
+    return quaternionF(q.qs_w[idx], q.qs_x[idx], q.qs_y[idx], q.qs_z[idx]);
+}
+
+inline void store_quaternion(
+    const v8::math::quaternion_soa_t& q, v8_size_t idx, const quaternionF& val
+    ) {
+    q.qs_w[idx] = val.w_;
+    q.qs_x[idx] = val.x_;
+    q.qs_y[idx] = val.y_;
+    q.qs_z[idx] = val.z_;
+}
+
+quaternionF slerp_fast_scalar(const quaternionF& a, const quaternionF& b, float t) {
+    const float cos_theta = v8::math::dot_product(a, b);
+    const float sign = cos_theta < 0.0f ? -1.0f : 1.0f;
+    const float x_minus_1 = sign * cos_theta - 1.0f;
+    const float s = 1.0f - t;
+
+    float ct = 1.0f;
+    float cs = 1.0f;
+    for (int i = 7; i >= 0; --i) {
+        ct = 1.0f + (k_slerp_u[i] * t * t - k_slerp_v[i]) * x_minus_1 * ct;
+        cs = 1.0f + (k_slerp_u[i] * s * s - k_slerp_v[i]) * x_minus_1 * cs;
+    }
+
+    const float wa = s * cs;
+    const float wb = sign * t * ct;
+    return quaternionF(wa * a.w_ + wb * b.w_, wa * a.x_ + wb * b.x_,
+                       wa * a.y_ + wb * b.y_, wa * a.z_ + wb * b.z_);
+}
+
+quaternionF slerp_exact_scalar(const quaternionF& a, const quaternionF& b, float t) {
+    return v8::math::slerp(a, b, t);
+}
+
+quaternionF nlerp_scalar(const quaternionF& a, const quaternionF& b, float t) {
+    return v8::math::nlerp(a, b, t);
+}
+
+struct param_array {
+    const float*    pa_values;
+
+    explicit param_array(const float* values) : pa_values(values) {}
+
+    float operator[](v8_size_t idx) const {
+        return pa_values[idx];
+    }
+};
+
+struct param_uniform {
+    float   pu_value;
+
+    explicit param_uniform(float value) : pu_value(value) {}
+
+    float operator[](v8_size_t) const {
+        return pu_value;
+    }
+};
+
+typedef quaternionF (*interpolator)(const quaternionF&, const quaternionF&, float);
+
+template<interpolator interpolate, typename param_source>
+void interpolate_batch(
+    const v8::math::const_quaternion_soa_t& a,
+    const v8::math::const_quaternion_soa_t& b,
+    const param_source&                     t,
+    const v8::math::quaternion_soa_t&       out,
+    v8_size_t                               count
+    ) {
+    for (v8_size_t i = 0; i < count; ++i) {
+        store_quaternion(out, i, interpolate(
+            load_quaternion(a, i), load_quaternion(b, i), t[i]));
+    }
+}
+
+template<typename param_source>
+void slerp_batch(
+    const v8::math::const_quaternion_soa_t& a,
+    const v8::math::const_quaternion_soa_t& b,
+    const param_source&                     t,
+    const v8::math::quaternion_soa_t&       out,
+    v8_size_t                               count,
+    v8::math::Slerp_Mode                    mode
+    ) {
+    if (mode == v8::math::Slerp_Mode_Fast)
+        interpolate_batch<slerp_fast_scalar>(a, b, t, out, count);
+    else
+        interpolate_batch<slerp_exact_scalar>(a, b, t, out, count);
+}
+
+} // anonymous namespace
+
+void v8::math::quaternion_nlerp_batch(
+    const const_quaternion_soa_t&   a,
+    const const_quaternion_soa_t&   b,
+    const float*                    t,
+    const quaternion_soa_t&         out,
+    v8_size_t                       count
+    ) {
+    interpolate_batch<nlerp_scalar>(a, b, param_array(t), out, count);
+}
+
+void v8::math::quaternion_nlerp_batch(
+    const const_quaternion_soa_t&   a,
+    const const_quaternion_soa_t&   b,
+    float                           t,
+    const quaternion_soa_t&         out,
+    v8_size_t                       count
+    ) {
+    interpolate_batch<nlerp_scalar>(a, b, param_uniform(t), out, count);
+}
+
+void v8::math::quaternion_slerp_batch(
+    const const_quaternion_soa_t&   a,
+    const const_quaternion_soa_t&   b,
+    const float*                    t,
+    const quaternion_soa_t&         out,
+    v8_size_t                       count,
+    Slerp_Mode                      mode
+    ) {
+    slerp_batch(a, b, param_array(t), out, count, mode);
+}
+
+void v8::math::quaternion_slerp_batch(
+    const const_quaternion_soa_t&   a,
+    const const_quaternion_soa_t&   b,
+    float                           t,
+    const quaternion_soa_t&         out,
+    v8_size_t                       count,
+    Slerp_Mode                      mode
+    ) {
+    slerp_batch(a, b, param_uniform(t), out, count, mode);
+}
+
+void v8::math::quaternion_multiply_batch(
+    const const_quaternion_soa_t&   a,
+    const const_quaternion_soa_t&   b,
+    const quaternion_soa_t&         out,
+    v8_size_t                       count
+    ) {
+    for (v8_size_t i = 0; i < count; ++i)
+        store_quaternion(out, i, load_quaternion(a, i) * load_quaternion(b, i));
+}
+
+void v8::math::quaternion_rotate_batch(
+    const const_quaternion_soa_t&   q,
+    const const_vector3_soa_t&      v,
+    const vector3_soa_t&            out,
+    v8_size_t                       count
+    ) {
+    for (v8_size_t i = 0; i < count; ++i) {
+        const quaternionF r(load_quaternion(q, i));
+        const float vx = v.vs_x[i];
+        const float vy = v.vs_y[i];
+        const float vz = v.vs_z[i];
+
+        const float dotp = 2.0f * (r.x_ * vx + r.y_ * vy + r.z_ * vz);
+        const float cross_mul = 2.0f * r.w_;
+        const float vmul = cross_mul * r.w_ - 1.0f;
+
+        out.vs_x[i] = vmul * vx + dotp * r.x_ + cross_mul * (r.y_ * vz - r.z_ * vy);
+        out.vs_y[i] = vmul * vy + dotp * r.y_ + cross_mul * (r.z_ * vx - r.x_ * vz);
+        out.vs_z[i] = vmul * vz + dotp * r.z_ + cross_mul * (r.x_ * vy - r.y_ * vx);
+    }
+}
+
+void v8::math::quaternion_to_matrix_batch(
+    const const_quaternion_soa_t&   q,
+    matrix_3X3F*                    out,
+    v8_size_t                       count
+    ) {
+    for (v8_size_t i = 0; i < count; ++i) {
+        const quaternionF r(load_quaternion(q, i));
+        const float s = 2.0f / r.length_squared();
+        const float xs = r.x_ * s;
+        const float ys = r.y_ * s;
+        const float zs = r.z_ * s;
+        const float wx = r.w_ * xs;
+        const float wy = r.w_ * ys;
+        const float wz = r.w_ * zs;
+        const float xx = r.x_ * xs;
+        const float xy = r.x_ * ys;
+        const float xz = r.x_ * zs;
+        const float yy = r.y_ * ys;
+        const float yz = r.y_ * zs;
+        const float zz = r.z_ * zs;
+
+        matrix_3X3F& m = out[i];
+        m.a11_ = 1.0f - (yy + zz);
+        m.a12_ = xy - wz;
+        m.a13_ = xz + wy;
+        m.a21_ = xy + wz;
+        m.a22_ = 1.0f - (xx + zz);
+        m.a23_ = yz - wx;
+        m.a31_ = xz - wy;
+        m.a32_ = yz + wx;
+        m.a33_ = 1.0f - (xx + yy);
+    }
+}
+
+#endif /* V8_MATH_SIMD_ENABLED */
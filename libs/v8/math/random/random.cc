@@ -0,0 +1,8 @@
+#include <atomic>
+#include "v8/math/random/random.hpp"
+
+v8_uint64_t v8::math::internals::next_default_seed() {
+    static std::atomic<v8_uint64_t> seed_sequence(5489ULL);
+    v8_uint64_t sm_state = seed_sequence.fetch_add(1);
+    return splitmix64_next(&sm_state);
+}
@@ -0,0 +1,570 @@
+#include "pch_hdr.hpp"
+
+#include <v8/math/simd/float4.hpp>
+#include <v8/math/spatial/sweep_and_prune.hpp>
+
+namespace {
+
+//
+// Radix sort digits; 64 bit keys take at most six passes.
+const v8_uint32_t k_radix_bits = 11;
+const v8_uint32_t k_radix_buckets = 1U << k_radix_bits;
+
+//
+// The pairs are collected in a grid of cells on the y/z plane, each swept
+// along x. Cells are about k_cell_size_factor times the average box size,
+// with at most k_max_grid_cells per axis; sets with fewer than
+// k_min_grid_boxes boxes use a single cell.
+const float k_cell_size_factor = 8.0f;
+const v8_uint32_t k_max_grid_cells = 64;
+const v8_size_t k_min_grid_boxes = 1024;
+
+//
+// Moves allowed to the insertion sort of the sweep order, per box, before
+// the order is sorted from scratch.
+const v8_size_t k_sweep_order_moves = 8;
+
+//
+// Float bits mapped to an unsigned integer with the same order.
+inline v8_uint32_t sortable_bits(float val) {
+    v8_uint32_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    return (bits & 0x80000000U) ? ~bits : (bits | 0x80000000U);
+}
+
+//
+// Stable LSD radix sort on bits [first_bit, 64) of the keys. Passes whose
+// digit is the same for all the keys are skipped, so keys that only use
+// their low bits are cheap to sort.
+void radix_sort(
+    std::vector<v8_uint64_t>*   keys,
+    std::vector<v8_uint64_t>*   scratch,
+    v8_uint32_t                 first_bit
+    ) {
+    const v8_size_t count = keys->size();
+    if (count < 2)
+        return;
+
+    const v8_uint32_t passes = (64 - first_bit + k_radix_bits - 1) / k_radix_bits;
+    std::vector<v8_uint32_t> histograms(passes * k_radix_buckets, 0);
+    for (v8_size_t i = 0; i < count; ++i) {
+        const v8_uint64_t key = (*keys)[i] >> first_bit;
+        for (v8_uint32_t pass = 0; pass < passes; ++pass) {
+            const v8_uint32_t digit = static_cast<v8_uint32_t>(
+                (key >> (pass * k_radix_bits)) & (k_radix_buckets - 1));
+            ++histograms[pass * k_radix_buckets + digit];
+        }
+    }
+
+    scratch->resize(count);
+    v8_uint64_t* src = &(*keys)[0];
+    v8_uint64_t* dst = &(*scratch)[0];
+
+    for (v8_uint32_t pass = 0; pass < passes; ++pass) {
+        v8_uint32_t* histogram = &histograms[pass * k_radix_buckets];
+        const v8_uint32_t shift = first_bit + pass * k_radix_bits;
+        const v8_uint32_t first_digit = static_cast<v8_uint32_t>(
+            (src[0] >> shift) & (k_radix_buckets - 1));
+        if (histogram[first_digit] == count)
+            continue;
+
+        v8_uint32_t offset = 0;
+        for (v8_uint32_t bucket = 0; bucket < k_radix_buckets; ++bucket) {
+            const v8_uint32_t bucket_size = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucket_size;
+        }
+
+        for (v8_size_t i = 0; i < count; ++i) {
+            const v8_uint32_t digit = static_cast<v8_uint32_t>(
+                (src[i] >> shift) & (k_radix_buckets - 1));
+            dst[histogram[digit]++] = src[i];
+        }
+
+        std::swap(src, dst);
+    }
+
+    if (src != &(*keys)[0])
+        keys->swap(*scratch);
+}
+
+//
+// Insertion sort of keys on their high 32 bits, stable. Gives up, leaving
+// the keys partially sorted, once it has moved keys more than max_moves
+// times.
+bool insertion_sort_keys(
+    v8_uint64_t*    keys,
+    v8_size_t       count,
+    v8_size_t       max_moves,
+    v8_size_t*      move_count
+    ) {
+    v8_size_t moves = 0;
+    for (v8_size_t i = 1; i < count; ++i) {
+        const v8_uint64_t key = keys[i];
+        const v8_uint32_t value = static_cast<v8_uint32_t>(key >> 32);
+        if (value >= static_cast<v8_uint32_t>(keys[i - 1] >> 32))
+            continue;
+
+        v8_size_t j = i;
+        do {
+            keys[j] = keys[j - 1];
+            --j;
+        } while (j > 0 && value < static_cast<v8_uint32_t>(keys[j - 1] >> 32));
+
+        keys[j] = key;
+        moves += i - j;
+        if (moves > max_moves)
+            break;
+    }
+
+    *move_count = moves;
+    return moves <= max_moves;
+}
+
+//
+// The boxes of a grid cell, in increasing min order on the sweep axis (x
+// below, y and z being the grid axes), as a structure of arrays. The boxes
+// are followed by four padding boxes that overlap nothing, so that four
+// boxes can always be loaded.
+struct cell_boxes_t {
+    const float*        cb_x_min;
+    const float*        cb_x_max;
+    const float*        cb_y_min;
+    const float*        cb_y_max;
+    const float*        cb_z_min;
+    const float*        cb_z_max;
+    const v8_uint32_t*  cb_ids;
+    v8_size_t           cb_count;
+};
+
+//
+// Uniform grid on the plane of the two axes other than the sweep axis.
+struct sweep_grid_t {
+    float       sg_origin[2];
+    float       sg_inv_cell_size[2];
+    v8_int32_t  sg_cells[2];
+
+    v8_int32_t cell_of(int dim, float val) const {
+        const float cell = (val - sg_origin[dim]) * sg_inv_cell_size[dim];
+        if (!(cell > 0.0f))
+            return 0;
+        return std::min(static_cast<v8_int32_t>(cell), sg_cells[dim] - 1);
+    }
+};
+
+//
+// Tests box i against the boxes that follow it in its cell, until their
+// min x passes its max x.
+template<typename pair_fn>
+inline void sweep_box(
+    const cell_boxes_t&     boxes,
+    v8_size_t               i,
+    pair_fn&                on_pair
+    ) {
+    const v8_size_t cell_last = boxes.cb_count;
+    const float* x_min = boxes.cb_x_min;
+    const float* y_min = boxes.cb_y_min;
+    const float* y_max = boxes.cb_y_max;
+    const float* z_min = boxes.cb_z_min;
+    const float* z_max = boxes.cb_z_max;
+    const float x_hi = boxes.cb_x_max[i];
+
+#if defined(V8_MATH_SIMD_ENABLED)
+    using namespace v8::math::simd;
+
+    const float4_t box_x_max = splat_float4(x_hi);
+    const float4_t box_y_min = splat_float4(y_min[i]);
+    const float4_t box_y_max = splat_float4(y_max[i]);
+    const float4_t box_z_min = splat_float4(z_min[i]);
+    const float4_t box_z_max = splat_float4(z_max[i]);
+
+    //
+    // Boxes past the end of the x interval fail the x test and the padding
+    // fails all of them, so the last group needs no special case.
+    for (v8_size_t j = i + 1; j < cell_last && x_min[j] <= x_hi; j += 4) {
+        const float4_t overlap = bit_and(bit_and(
+            bit_and(cmp_le(load_float4(x_min + j), box_x_max),
+                    cmp_le(load_float4(y_min + j), box_y_max)),
+            bit_and(cmp_le(box_y_min, load_float4(y_max + j)),
+                    cmp_le(load_float4(z_min + j), box_z_max))),
+            cmp_le(box_z_min, load_float4(z_max + j)));
+
+        const v8_int_t bits = move_mask(overlap);
+        if (!bits)
+            continue;
+
+        for (int lane = 0; lane < 4; ++lane) {
+            if (bits & (1 << lane))
+                on_pair(i, j + lane);
+        }
+    }
+#else /* V8_MATH_SIMD_ENABLED */
+    for (v8_size_t j = i + 1; j < cell_last && x_min[j] <= x_hi; ++j) {
+        if (y_min[j] <= y_max[i] && y_min[i] <= y_max[j]
+            && z_min[j] <= z_max[i] && z_min[i] <= z_max[j]) {
+            on_pair(i, j);
+        }
+    }
+#endif /* V8_MATH_SIMD_ENABLED */
+}
+
+} // anonymous namespace
+
+v8::math::sweep_and_prune::sweep_and_prune()
+    :       proxy_count_(0)
+        ,   sweep_order_valid_(false)
+        ,   sweep_axis_(0)
+        ,   sorted_from_scratch_(false)
+{}
+
+void v8::math::sweep_and_prune::clear() {
+    proxies_.clear();
+    bounds_.clear();
+    free_ids_.clear();
+    removed_ids_.clear();
+    pairs_.clear();
+    added_pairs_.clear();
+    removed_pairs_.clear();
+    sweep_ids_.clear();
+    proxy_count_ = 0;
+    sweep_order_valid_ = false;
+    sorted_from_scratch_ = false;
+}
+
+v8_int32_t v8::math::sweep_and_prune::insert_proxy(
+    const aabb3F&   box,
+    void*           user_data
+    ) {
+    v8_int32_t proxy_id;
+    if (!free_ids_.empty()) {
+        proxy_id = free_ids_.back();
+        free_ids_.pop_back();
+    } else {
+        proxy_id = static_cast<v8_int32_t>(proxies_.size());
+        proxies_.push_back(proxy_t());
+        bounds_.push_back(box);
+    }
+
+    proxy_t& proxy = proxies_[proxy_id];
+    proxy.px_user_data = user_data;
+    proxy.px_state = Proxy_State_Active;
+    bounds_[proxy_id] = box;
+    ++proxy_count_;
+    sweep_order_valid_ = false;
+
+    return proxy_id;
+}
+
+void v8::math::sweep_and_prune::remove_proxy(v8_int32_t proxy_id) {
+    assert(is_valid_proxy(proxy_id));
+    proxies_[proxy_id].px_state = Proxy_State_Removed;
+    removed_ids_.push_back(proxy_id);
+    --proxy_count_;
+}
+
+void v8::math::sweep_and_prune::move_proxy(
+    v8_int32_t      proxy_id,
+    const aabb3F&   box
+    ) {
+    assert(is_valid_proxy(proxy_id));
+    assert(box.min_point_.x_ <= box.max_point_.x_);
+    assert(box.min_point_.y_ <= box.max_point_.y_);
+    assert(box.min_point_.z_ <= box.max_point_.z_);
+    bounds_[proxy_id] = box;
+}
+
+void v8::math::sweep_and_prune::update() {
+    added_pairs_.clear();
+    removed_pairs_.clear();
+
+    std::vector<v8_uint64_t> removed;
+    remove_pending_proxies(&removed);
+
+    std::vector<v8_uint64_t> current;
+    sorted_from_scratch_ =
+        collect_pairs(&current) == std::numeric_limits<v8_size_t>::max();
+
+    std::vector<v8_uint64_t> added;
+    std::vector<v8_uint64_t> changed_removed;
+    std::set_difference(
+        current.begin(), current.end(), pairs_.begin(), pairs_.end(),
+        std::back_inserter(added));
+    std::set_difference(
+        pairs_.begin(), pairs_.end(), current.begin(), current.end(),
+        std::back_inserter(changed_removed));
+
+    apply_pair_changes(added, changed_removed);
+
+    const v8_size_t dropped_count = removed.size();
+    removed.insert(removed.end(), changed_removed.begin(), changed_removed.end());
+    std::inplace_merge(
+        removed.begin(), removed.begin() + dropped_count, removed.end());
+
+    added_pairs_.reserve(added.size());
+    for (v8_size_t i = 0; i < added.size(); ++i)
+        added_pairs_.push_back(pair_from_key(added[i]));
+
+    removed_pairs_.reserve(removed.size());
+    for (v8_size_t i = 0; i < removed.size(); ++i)
+        removed_pairs_.push_back(pair_from_key(removed[i]));
+}
+
+void v8::math::sweep_and_prune::remove_pending_proxies(
+    std::vector<v8_uint64_t>* dropped_pairs
+    ) {
+    if (removed_ids_.empty())
+        return;
+
+    v8_size_t write = 0;
+    for (v8_size_t read = 0; read < pairs_.size(); ++read) {
+        const v8_uint64_t key = pairs_[read];
+        if (proxies_[key >> 32].px_state == Proxy_State_Removed
+            || proxies_[key & 0xFFFFFFFFU].px_state == Proxy_State_Removed) {
+            dropped_pairs->push_back(key);
+            continue;
+        }
+        pairs_[write++] = key;
+    }
+    pairs_.resize(write);
+
+    if (sweep_order_valid_) {
+        sweep_ids_.erase(std::remove_if(sweep_ids_.begin(), sweep_ids_.end(),
+            [this](v8_uint32_t id) {
+            return proxies_[id].px_state == Proxy_State_Removed;
+        }), sweep_ids_.end());
+    }
+
+    for (v8_size_t i = 0; i < removed_ids_.size(); ++i) {
+        proxies_[removed_ids_[i]].px_state = Proxy_State_Free;
+        free_ids_.push_back(removed_ids_[i]);
+    }
+    removed_ids_.clear();
+}
+
+v8_size_t v8::math::sweep_and_prune::update_sweep_order() {
+    //
+    // The boxes are gathered in the order of the previous update (in id
+    // order after insertions), so that the insertion sort only has to fix
+    // what moved since then.
+    sweep_boxes_.resize(proxy_count_);
+    sweep_keys_.resize(proxy_count_);
+
+    for (int axis = 0; axis < 3; ++axis) {
+        sweep_lo_[axis] = std::numeric_limits<float>::max();
+        sweep_hi_[axis] = -std::numeric_limits<float>::max();
+        sweep_size_sum_[axis] = 0.0;
+    }
+
+    const v8_size_t gather_count =
+        sweep_order_valid_ ? sweep_ids_.size() : proxies_.size();
+    v8_size_t count = 0;
+
+    for (v8_size_t i = 0; i < gather_count; ++i) {
+        const v8_uint32_t id = sweep_order_valid_
+            ? sweep_ids_[i] : static_cast<v8_uint32_t>(i);
+        if (!sweep_order_valid_ && proxies_[id].px_state != Proxy_State_Active)
+            continue;
+
+        const aabb3F& box = bounds_[id];
+        sweep_box_t& rec = sweep_boxes_[count];
+        for (int axis = 0; axis < 3; ++axis) {
+            const float lo = box.min_point_.elements_[axis];
+            const float hi = box.max_point_.elements_[axis];
+            rec.sb_min[axis] = lo;
+            rec.sb_max[axis] = hi;
+            sweep_lo_[axis] = std::min(sweep_lo_[axis], lo);
+            sweep_hi_[axis] = std::max(sweep_hi_[axis], hi);
+            sweep_size_sum_[axis] += hi - lo;
+        }
+        rec.sb_id = id;
+
+        sweep_keys_[count] =
+            (static_cast<v8_uint64_t>(sortable_bits(rec.sb_min[sweep_axis_])) << 32)
+            | count;
+        ++count;
+    }
+
+    assert(count == proxy_count_);
+    v8_size_t moves = 0;
+    if (sweep_order_valid_ && insertion_sort_keys(
+            &sweep_keys_[0], count, k_sweep_order_moves * count, &moves))
+        return moves;
+
+    //
+    // Sorted from scratch, along the axis where the projections of the
+    // boxes are the sparsest (fewest boxes over a point, on average).
+    int sparsest_axis = 0;
+    double min_density = std::numeric_limits<double>::max();
+    for (int axis = 0; axis < 3; ++axis) {
+        const double range = static_cast<double>(sweep_hi_[axis])
+                             - static_cast<double>(sweep_lo_[axis]);
+        const double density = range > 0.0
+            ? sweep_size_sum_[axis] / range : std::numeric_limits<double>::max();
+        if (density < min_density) {
+            min_density = density;
+            sparsest_axis = axis;
+        }
+    }
+
+    if (sparsest_axis != sweep_axis_) {
+        sweep_axis_ = sparsest_axis;
+        for (v8_size_t i = 0; i < count; ++i) {
+            sweep_keys_[i] = (static_cast<v8_uint64_t>(
+                sortable_bits(sweep_boxes_[i].sb_min[sweep_axis_])) << 32) | i;
+        }
+    }
+
+    radix_sort(&sweep_keys_, &sort_scratch_, 32);
+    sweep_order_valid_ = true;
+    return std::numeric_limits<v8_size_t>::max();
+}
+
+v8_size_t v8::math::sweep_and_prune::collect_pairs(
+    std::vector<v8_uint64_t>* pairs
+    ) {
+    pairs->clear();
+
+    const v8_size_t count = proxy_count_;
+    if (!count) {
+        sweep_ids_.clear();
+        return 0;
+    }
+
+    const v8_size_t sweep_moves = update_sweep_order();
+
+    //
+    // Grid on the two other axes.
+    const int grid_axes[2] = { (sweep_axis_ + 1) % 3, (sweep_axis_ + 2) % 3 };
+    sweep_grid_t grid;
+    for (int dim = 0; dim < 2; ++dim) {
+        const int axis = grid_axes[dim];
+        const float range = sweep_hi_[axis] - sweep_lo_[axis];
+        const float cell_size = k_cell_size_factor
+            * static_cast<float>(sweep_size_sum_[axis] / static_cast<double>(count));
+
+        v8_int32_t cells = 1;
+        if (count >= k_min_grid_boxes && cell_size > 0.0f && range > cell_size) {
+            cells = static_cast<v8_int32_t>(std::min(
+                static_cast<float>(k_max_grid_cells), range / cell_size));
+        }
+
+        grid.sg_origin[dim] = sweep_lo_[axis];
+        grid.sg_cells[dim] = std::max(cells, 1);
+        grid.sg_inv_cell_size[dim] =
+            range > 0.0f ? static_cast<float>(grid.sg_cells[dim]) / range : 0.0f;
+    }
+
+    //
+    // The boxes are appended to the cells they overlap in the sweep order,
+    // which leaves each cell sorted. The ids are saved in that order, for
+    // the next update.
+    const v8_size_t cell_count =
+        static_cast<v8_size_t>(grid.sg_cells[0]) * grid.sg_cells[1];
+    if (cells_.size() < cell_count)
+        cells_.resize(cell_count);
+    for (v8_size_t cell = 0; cell < cell_count; ++cell)
+        cells_[cell].clear();
+
+    sweep_ids_.resize(count);
+    for (v8_size_t i = 0; i < count; ++i) {
+        const sweep_box_t& rec = sweep_boxes_[sweep_keys_[i] & 0xFFFFFFFFU];
+        sweep_ids_[i] = rec.sb_id;
+
+        const v8_int32_t y0 = grid.cell_of(0, rec.sb_min[grid_axes[0]]);
+        const v8_int32_t y1 = grid.cell_of(0, rec.sb_max[grid_axes[0]]);
+        const v8_int32_t z0 = grid.cell_of(1, rec.sb_min[grid_axes[1]]);
+        const v8_int32_t z1 = grid.cell_of(1, rec.sb_max[grid_axes[1]]);
+        for (v8_int32_t cy = y0; cy <= y1; ++cy) {
+            for (v8_int32_t cz = z0; cz <= z1; ++cz)
+                cells_[cy * grid.sg_cells[1] + cz].push_back(rec);
+        }
+    }
+
+    v8_size_t max_cell_count = 0;
+    for (v8_size_t cell = 0; cell < cell_count; ++cell)
+        max_cell_count = std::max(max_cell_count, cells_[cell].size());
+
+    //
+    // Each cell is copied to a structure of arrays (min and max on the
+    // sweep axis, then on the grid axes), followed by four padding boxes;
+    // comparisons with NaN are false.
+    for (int i = 0; i < 6; ++i)
+        cell_bounds_[i].resize(max_cell_count + 4);
+    cell_ids_.resize(max_cell_count + 4);
+
+    float* const bounds[6] = {
+        &cell_bounds_[0][0], &cell_bounds_[1][0], &cell_bounds_[2][0],
+        &cell_bounds_[3][0], &cell_bounds_[4][0], &cell_bounds_[5][0]
+    };
+    const int bound_axes[3] = { sweep_axis_, grid_axes[0], grid_axes[1] };
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    const bool single_cell = cell_count == 1;
+
+    //
+    // A pair that spans several cells is reported only by the cell that
+    // holds the min corner of the intersection of the two boxes.
+    for (v8_size_t cell = 0; cell < cell_count; ++cell) {
+        const v8_size_t cell_size = cells_[cell].size();
+        if (cell_size < 2)
+            continue;
+
+        for (v8_size_t i = 0; i < cell_size; ++i) {
+            const sweep_box_t& rec = cells_[cell][i];
+            for (int b = 0; b < 3; ++b) {
+                bounds[2 * b][i] = rec.sb_min[bound_axes[b]];
+                bounds[2 * b + 1][i] = rec.sb_max[bound_axes[b]];
+            }
+            cell_ids_[i] = rec.sb_id;
+        }
+
+        for (v8_size_t i = cell_size; i < cell_size + 4; ++i) {
+            bounds[0][i] = std::numeric_limits<float>::infinity();
+            for (int b = 1; b < 6; ++b)
+                bounds[b][i] = nan;
+        }
+
+        const cell_boxes_t boxes = {
+            bounds[0], bounds[1], bounds[2], bounds[3], bounds[4], bounds[5],
+            &cell_ids_[0], cell_size
+        };
+
+        const v8_int32_t cell_y = static_cast<v8_int32_t>(cell) / grid.sg_cells[1];
+        const v8_int32_t cell_z = static_cast<v8_int32_t>(cell) % grid.sg_cells[1];
+
+        auto on_pair = [&](v8_size_t i, v8_size_t j) {
+            if (!single_cell) {
+                const float y = std::max(boxes.cb_y_min[i], boxes.cb_y_min[j]);
+                const float z = std::max(boxes.cb_z_min[i], boxes.cb_z_min[j]);
+                if (grid.cell_of(0, y) != cell_y || grid.cell_of(1, z) != cell_z)
+                    return;
+            }
+            pairs->push_back(pair_key(boxes.cb_ids[i], boxes.cb_ids[j]));
+        };
+
+        for (v8_size_t i = 0; i < cell_size; ++i)
+            sweep_box(boxes, i, on_pair);
+    }
+
+    radix_sort(pairs, &sort_scratch_, 0);
+    return sweep_moves;
+}
+
+void v8::math::sweep_and_prune::apply_pair_changes(
+    const std::vector<v8_uint64_t>& added,
+    const std::vector<v8_uint64_t>& removed
+    ) {
+    if (added.empty() && removed.empty())
+        return;
+
+    std::vector<v8_uint64_t> kept;
+    kept.reserve(pairs_.size() - removed.size());
+    std::set_difference(
+        pairs_.begin(), pairs_.end(), removed.begin(), removed.end(),
+        std::back_inserter(kept));
+
+    pairs_.clear();
+    pairs_.reserve(kept.size() + added.size());
+    std::merge(
+        kept.begin(), kept.end(), added.begin(), added.end(),
+        std::back_inserter(pairs_));
+}
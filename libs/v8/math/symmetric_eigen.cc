@@ -0,0 +1,194 @@
+#include "pch_hdr.hpp"
+
+#include <v8/base/job_system.hpp>
+#include <v8/math/simd/float4.hpp>
+#include <v8/math/numerical_analysis/symmetric_eigen.hpp>
+
+namespace {
+
+//
+// Matrices per job; below two grains the batch runs on the calling thread.
+const size_t k_batch_grain = 512;
+
+#if defined(V8_MATH_SIMD_ENABLED)
+
+using v8::math::simd::float4_t;
+
+//
+// Four symmetric matrices, one per lane : the upper triangle of a and the
+// accumulated rotations v (row major).
+struct jacobi_lanes {
+    float4_t    jl_a[3][3];
+    float4_t    jl_v[3][3];
+};
+
+inline float4_t absolute(float4_t val) {
+    return v8::math::simd::maximum(val, v8::math::simd::negate(val));
+}
+
+//
+// Annihilates a[p][q] in all four lanes; r is the remaining index. Lanes
+// where a[p][q] is already zero get the identity rotation (c = 1, s = 0),
+// so no lane needs a branch.
+inline void rotate_lanes(jacobi_lanes* jl, int p, int q, int r) {
+    using namespace v8::math::simd;
+
+    const float4_t zero = zero_float4();
+    const float4_t one = splat_float4(1.0f);
+
+    float4_t (&a)[3][3] = jl->jl_a;
+    const float4_t apq = a[p][q];
+    const float4_t active = cmp_gt(absolute(apq), zero);
+
+    const float4_t theta = div(
+        sub(a[q][q], a[p][p]), mul(splat_float4(2.0f), select(active, apq, one)));
+    float4_t t = div(one,
+        add(absolute(theta), square_root(add(mul(theta, theta), one))));
+    t = select(cmp_lt(theta, zero), negate(t), t);
+    t = select(active, t, zero);
+
+    const float4_t c = div(one, square_root(add(mul(t, t), one)));
+    const float4_t s = mul(t, c);
+
+    //
+    // Only the upper triangle is kept : a[min(i, j)][max(i, j)].
+    float4_t& arp = r < p ? a[r][p] : a[p][r];
+    float4_t& arq = r < q ? a[r][q] : a[q][r];
+    const float4_t old_rp = arp;
+    const float4_t old_rq = arq;
+    arp = sub(mul(c, old_rp), mul(s, old_rq));
+    arq = add(mul(s, old_rp), mul(c, old_rq));
+
+    a[p][p] = sub(a[p][p], mul(t, apq));
+    a[q][q] = add(a[q][q], mul(t, apq));
+    a[p][q] = zero;
+
+    for (int k = 0; k < 3; ++k) {
+        const float4_t vkp = jl->jl_v[k][p];
+        const float4_t vkq = jl->jl_v[k][q];
+        jl->jl_v[k][p] = sub(mul(c, vkp), mul(s, vkq));
+        jl->jl_v[k][q] = add(mul(s, vkp), mul(c, vkq));
+    }
+}
+
+//
+// Decomposes four matrices; sweeps continue until every lane has converged.
+void decompose_four(
+    const v8::math::matrix_3X3F*    matrices,
+    v8::math::vector3F*             eigenvalues,
+    v8::math::matrix_3X3F*          eigenvectors
+    ) {
+    using namespace v8::math;
+    using namespace v8::math::simd;
+
+    jacobi_lanes jl;
+    for (int i = 0; i < 3; ++i) {
+        for (int j = i; j < 3; ++j) {
+            const int idx = i * 3 + j;
+            jl.jl_a[i][j] = set_float4(
+                matrices[0].elements_[idx], matrices[1].elements_[idx],
+                matrices[2].elements_[idx], matrices[3].elements_[idx]);
+        }
+
+        for (int j = 0; j < 3; ++j)
+            jl.jl_v[i][j] = splat_float4(i == j ? 1.0f : 0.0f);
+    }
+
+    const float epsilon = std::numeric_limits<float>::epsilon();
+    const float4_t tolerance = splat_float4(epsilon * epsilon);
+
+    for (int sweep = 0; sweep < C_Jacobi_Max_Sweeps; ++sweep) {
+        const float4_t off_diagonal = add(add(
+            mul(jl.jl_a[0][1], jl.jl_a[0][1]), mul(jl.jl_a[0][2], jl.jl_a[0][2])),
+            mul(jl.jl_a[1][2], jl.jl_a[1][2]));
+        const float4_t diagonal = add(add(
+            mul(jl.jl_a[0][0], jl.jl_a[0][0]), mul(jl.jl_a[1][1], jl.jl_a[1][1])),
+            mul(jl.jl_a[2][2], jl.jl_a[2][2]));
+
+        if (!move_mask(cmp_gt(off_diagonal, mul(tolerance, diagonal))))
+            break;
+
+        rotate_lanes(&jl, 0, 1, 2);
+        rotate_lanes(&jl, 0, 2, 1);
+        rotate_lanes(&jl, 1, 2, 0);
+    }
+
+    float diag[3][4];
+    float vecs[3][3][4];
+    for (int i = 0; i < 3; ++i) {
+        store_float4(diag[i], jl.jl_a[i][i]);
+        for (int j = 0; j < 3; ++j)
+            store_float4(vecs[i][j], jl.jl_v[i][j]);
+    }
+
+    for (int lane = 0; lane < 4; ++lane) {
+        float values[3] = { diag[0][lane], diag[1][lane], diag[2][lane] };
+        float v[3][3];
+        for (int i = 0; i < 3; ++i) {
+            for (int j = 0; j < 3; ++j)
+                v[i][j] = vecs[i][j][lane];
+        }
+
+        internals::sort_eigen_pairs(values, v);
+
+        for (int i = 0; i < 3; ++i) {
+            eigenvalues[lane].elements_[i] = values[i];
+            for (int j = 0; j < 3; ++j)
+                eigenvectors[lane].elements_[i * 3 + j] = v[i][j];
+        }
+    }
+}
+
+void decompose_range(
+    const v8::math::matrix_3X3F*    matrices,
+    v8::math::vector3F*             eigenvalues,
+    v8::math::matrix_3X3F*          eigenvectors,
+    size_t                          first,
+    size_t                          last
+    ) {
+    size_t i = first;
+    for (; i + 4 <= last; i += 4)
+        decompose_four(matrices + i, eigenvalues + i, eigenvectors + i);
+
+    for (; i < last; ++i) {
+        v8::math::eigen_decompose_symmetric(
+            matrices[i], eigenvalues + i, eigenvectors + i);
+    }
+}
+
+#else /* V8_MATH_SIMD_ENABLED */
+
+void decompose_range(
+    const v8::math::matrix_3X3F*    matrices,
+    v8::math::vector3F*             eigenvalues,
+    v8::math::matrix_3X3F*          eigenvectors,
+    size_t                          first,
+    size_t                          last
+    ) {
+    for (size_t i = first; i < last; ++i) {
+        v8::math::eigen_decompose_symmetric(
+            matrices[i], eigenvalues + i, eigenvectors + i);
+    }
+}
+
+#endif /* V8_MATH_SIMD_ENABLED */
+
+} // anonymous namespace
+
+void v8::math::eigen_decompose_symmetric_batch(
+    const matrix_3X3<float>*    matrices,
+    size_t                      count,
+    vector3<float>*             eigenvalues,
+    matrix_3X3<float>*          eigenvectors,
+    base::job_system*           jobs
+    ) {
+    if (!jobs || jobs->get_thread_count() < 2 || count < 2 * k_batch_grain) {
+        decompose_range(matrices, eigenvalues, eigenvectors, 0, count);
+        return;
+    }
+
+    jobs->parallel_for(0, count, k_batch_grain,
+        [=](size_t first, size_t last) {
+        decompose_range(matrices, eigenvalues, eigenvectors, first, last);
+    });
+}
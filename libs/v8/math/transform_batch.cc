@@ -0,0 +1,274 @@
+#include "pch_hdr.hpp"
+
+#include <v8/math/simd/float4.hpp>
+#include <v8/math/transform_batch.hpp>
+
+namespace {
+
+using v8::math::simd::float4_t;
+
+//
+// How the transform is applied; decided once per batch, not per element.
+enum batch_kind {
+    batch_kind_copy,
+    batch_kind_translate,
+    batch_kind_affine
+};
+
+batch_kind classify(
+    const v8::math::matrix_3X3F& linear, const v8::math::vector3F& translation
+    ) {
+    const bool is_identity =
+        linear.a11_ == 1.0f && linear.a12_ == 0.0f && linear.a13_ == 0.0f &&
+        linear.a21_ == 0.0f && linear.a22_ == 1.0f && linear.a23_ == 0.0f &&
+        linear.a31_ == 0.0f && linear.a32_ == 0.0f && linear.a33_ == 1.0f;
+
+    if (!is_identity)
+        return batch_kind_affine;
+
+    if (translation.x_ == 0.0f && translation.y_ == 0.0f && translation.z_ == 0.0f)
+        return batch_kind_copy;
+
+    return batch_kind_translate;
+}
+
+//
+// Matrix and translation, each element splatted to a register.
+struct affine_registers {
+    float4_t    ar_m[9];
+    float4_t    ar_t[3];
+
+    affine_registers(
+        const v8::math::matrix_3X3F& linear, const v8::math::vector3F& translation
+        ) {
+        using namespace v8::math::simd;
+        for (int i = 0; i < 9; ++i)
+            ar_m[i] = splat_float4(linear.elements_[i]);
+
+        ar_t[0] = splat_float4(translation.x_);
+        ar_t[1] = splat_float4(translation.y_);
+        ar_t[2] = splat_float4(translation.z_);
+    }
+
+    void apply(float4_t* x, float4_t* y, float4_t* z) const {
+        using namespace v8::math::simd;
+        const float4_t ox = add(add(add(
+            mul(ar_m[0], *x), mul(ar_m[1], *y)), mul(ar_m[2], *z)), ar_t[0]);
+        const float4_t oy = add(add(add(
+            mul(ar_m[3], *x), mul(ar_m[4], *y)), mul(ar_m[5], *z)), ar_t[1]);
+        const float4_t oz = add(add(add(
+            mul(ar_m[6], *x), mul(ar_m[7], *y)), mul(ar_m[8], *z)), ar_t[2]);
+        *x = ox;
+        *y = oy;
+        *z = oz;
+    }
+};
+
+//
+// Tightly packed vector3F arrays : four points per iteration.
+void affine_transform_packed_range(
+    const v8::math::matrix_3X3F&    linear,
+    const v8::math::vector3F&       translation,
+    const v8::math::vector3F*       src,
+    v8::math::vector3F*             dst,
+    v8_size_t                       first,
+    v8_size_t                       last
+    ) {
+    using namespace v8::math;
+    using namespace v8::math::simd;
+
+    const affine_registers regs(linear, translation);
+    const float* in = &src[0].x_;
+    float* out = &dst[0].x_;
+
+    v8_size_t i = first;
+    for (; i + 4 <= last; i += 4) {
+        float4_t x, y, z;
+        load_xyz4(in + i * 3, &x, &y, &z);
+
+        regs.apply(&x, &y, &z);
+
+        float4_t a, b, c;
+        interleave_xyz(x, y, z, &a, &b, &c);
+        store_float4(out + i * 3, a);
+        store_float4(out + i * 3 + 4, b);
+        store_float4(out + i * 3 + 8, c);
+    }
+
+    internals::affine_transform_strided_range(
+        linear, translation, src, sizeof(vector3F), dst, sizeof(vector3F),
+        i, last);
+}
+
+void affine_transform_soa_simd_range(
+    const v8::math::matrix_3X3F&    linear,
+    const v8::math::vector3F&       translation,
+    const float*                    src_x,
+    const float*                    src_y,
+    const float*                    src_z,
+    float*                          dst_x,
+    float*                          dst_y,
+    float*                          dst_z,
+    v8_size_t                       first,
+    v8_size_t                       last
+    ) {
+    using namespace v8::math;
+    using namespace v8::math::simd;
+
+    const affine_registers regs(linear, translation);
+
+    v8_size_t i = first;
+    for (; i + 4 <= last; i += 4) {
+        float4_t x = load_float4(src_x + i);
+        float4_t y = load_float4(src_y + i);
+        float4_t z = load_float4(src_z + i);
+
+        regs.apply(&x, &y, &z);
+
+        store_float4(dst_x + i, x);
+        store_float4(dst_y + i, y);
+        store_float4(dst_z + i, z);
+    }
+
+    internals::affine_transform_soa_range(
+        linear, translation, src_x, src_y, src_z, dst_x, dst_y, dst_z, i, last);
+}
+
+void translate_strided_range(
+    const v8::math::vector3F&   translation,
+    const v8::math::vector3F*   src,
+    v8_size_t                   src_stride,
+    v8::math::vector3F*         dst,
+    v8_size_t                   dst_stride,
+    v8_size_t                   first,
+    v8_size_t                   last
+    ) {
+    const char* src_bytes = reinterpret_cast<const char*>(src);
+    char* dst_bytes = reinterpret_cast<char*>(dst);
+
+    for (v8_size_t i = first; i < last; ++i) {
+        const v8::math::vector3F& in =
+            *reinterpret_cast<const v8::math::vector3F*>(src_bytes + i * src_stride);
+        v8::math::vector3F& out =
+            *reinterpret_cast<v8::math::vector3F*>(dst_bytes + i * dst_stride);
+
+        out.x_ = in.x_ + translation.x_;
+        out.y_ = in.y_ + translation.y_;
+        out.z_ = in.z_ + translation.z_;
+    }
+}
+
+void copy_strided_range(
+    const v8::math::vector3F*   src,
+    v8_size_t                   src_stride,
+    v8::math::vector3F*         dst,
+    v8_size_t                   dst_stride,
+    v8_size_t                   first,
+    v8_size_t                   last
+    ) {
+    if (src == dst && src_stride == dst_stride)
+        return;
+
+    const char* src_bytes = reinterpret_cast<const char*>(src);
+    char* dst_bytes = reinterpret_cast<char*>(dst);
+
+    if (src_stride == sizeof(v8::math::vector3F) &&
+        dst_stride == sizeof(v8::math::vector3F)) {
+        memcpy(dst_bytes + first * dst_stride, src_bytes + first * src_stride,
+               (last - first) * sizeof(v8::math::vector3F));
+        return;
+    }
+
+    for (v8_size_t i = first; i < last; ++i) {
+        *reinterpret_cast<v8::math::vector3F*>(dst_bytes + i * dst_stride) =
+            *reinterpret_cast<const v8::math::vector3F*>(src_bytes + i * src_stride);
+    }
+}
+
+void translate_soa_range(
+    float               offset,
+    const float*        src,
+    float*              dst,
+    v8_size_t           first,
+    v8_size_t           last
+    ) {
+    if (offset == 0.0f) {
+        if (src != dst)
+            memcpy(dst + first, src + first, (last - first) * sizeof(float));
+        return;
+    }
+
+    for (v8_size_t i = first; i < last; ++i)
+        dst[i] = src[i] + offset;
+}
+
+} // anonymous namespace
+
+void v8::math::affine_transform_strided(
+    const matrix_3X3<float>&    linear,
+    const vector3<float>&       translation,
+    const vector3<float>*       src,
+    v8_size_t                   src_stride,
+    vector3<float>*             dst,
+    v8_size_t                   dst_stride,
+    v8_size_t                   count,
+    base::job_system*           jobs
+    ) {
+    const batch_kind kind = classify(linear, translation);
+    const bool packed =
+        src_stride == sizeof(vector3F) && dst_stride == sizeof(vector3F);
+
+    internals::run_transform_batch(jobs, count,
+        [&](v8_size_t first, v8_size_t last) {
+        switch (kind) {
+        case batch_kind_copy :
+            copy_strided_range(src, src_stride, dst, dst_stride, first, last);
+            break;
+
+        case batch_kind_translate :
+            translate_strided_range(
+                translation, src, src_stride, dst, dst_stride, first, last);
+            break;
+
+        default :
+            if (packed) {
+                affine_transform_packed_range(
+                    linear, translation, src, dst, first, last);
+            } else {
+                internals::affine_transform_strided_range(
+                    linear, translation, src, src_stride, dst, dst_stride,
+                    first, last);
+            }
+            break;
+        }
+    });
+}
+
+void v8::math::affine_transform_soa(
+    const matrix_3X3<float>&    linear,
+    const vector3<float>&       translation,
+    const float*                src_x,
+    const float*                src_y,
+    const float*                src_z,
+    float*                      dst_x,
+    float*                      dst_y,
+    float*                      dst_z,
+    v8_size_t                   count,
+    base::job_system*           jobs
+    ) {
+    const batch_kind kind = classify(linear, translation);
+
+    internals::run_transform_batch(jobs, count,
+        [&](v8_size_t first, v8_size_t last) {
+        if (kind == batch_kind_affine) {
+            affine_transform_soa_simd_range(
+                linear, translation, src_x, src_y, src_z,
+                dst_x, dst_y, dst_z, first, last);
+            return;
+        }
+
+        translate_soa_range(translation.x_, src_x, dst_x, first, last);
+        translate_soa_range(translation.y_, src_y, dst_y, first, last);
+        translate_soa_range(translation.z_, src_z, dst_z, first, last);
+    });
+}
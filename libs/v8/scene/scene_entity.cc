@@ -1,4 +1,6 @@
+#include <cmath>
 #include "v8/rendering/effect.hpp"
+#include "v8/math/math_utils.hpp"
 #include "v8/scene/scene_entity.hpp"
 
 void v8::scene::scene_entity::attach_effect(
@@ -18,4 +20,46 @@ void v8::scene::scene_entity::set_active_technique(
     assert(technique_name);
     /*technique_ = attached_effect_->get_technique_by_name(technique_name);*/
     assert(technique_);
-}
\ No newline at end of file
+}
+
+v8::math::sphereF v8::scene::scene_entity::get_world_bound() const {
+    assert(has_local_bound_);
+
+    const math::matrix_3X3F& mtx = world_transform_.get_matrix_component();
+    const float scale = std::fabs(world_transform_.get_scale_component());
+
+    //
+    // C' = R * S * C + T
+    math::vector3F center(mtx * local_bound_.center_);
+    center *= world_transform_.get_scale_component();
+    center += world_transform_.get_translation_component();
+
+    //
+    // A rotation or reflection preserves lengths. For a general matrix the
+    // radius stretches by at most the spectral norm of M, the square root of
+    // the largest eigenvalue of G = M^T * M. Both the largest absolute row sum
+    // of G and its trace (the squared Frobenius norm of M) bound that
+    // eigenvalue from above; the smaller of the two is used.
+    float stretch = 1.0f;
+    if (!world_transform_.is_rotation_or_reflection()) {
+        const float g11 = mtx.a11_ * mtx.a11_ + mtx.a21_ * mtx.a21_ 
+                          + mtx.a31_ * mtx.a31_;
+        const float g22 = mtx.a12_ * mtx.a12_ + mtx.a22_ * mtx.a22_ 
+                          + mtx.a32_ * mtx.a32_;
+        const float g33 = mtx.a13_ * mtx.a13_ + mtx.a23_ * mtx.a23_ 
+                          + mtx.a33_ * mtx.a33_;
+        const float g12 = std::fabs(mtx.a11_ * mtx.a12_ + mtx.a21_ * mtx.a22_ 
+                                    + mtx.a31_ * mtx.a32_);
+        const float g13 = std::fabs(mtx.a11_ * mtx.a13_ + mtx.a21_ * mtx.a23_ 
+                                    + mtx.a31_ * mtx.a33_);
+        const float g23 = std::fabs(mtx.a12_ * mtx.a13_ + mtx.a22_ * mtx.a23_ 
+                                    + mtx.a32_ * mtx.a33_);
+
+        const float max_row_sum = math::max(g11 + g12 + g13, 
+                                            math::max(g12 + g22 + g23, 
+                                                      g13 + g23 + g33));
+        stretch = std::sqrt(math::min(max_row_sum, g11 + g22 + g33));
+    }
+
+    return math::sphereF(center, local_bound_.radius_ * scale * stretch);
+}
@@ -1,27 +1,285 @@
+#include <cmath>
+#include <limits>
 #include "v8/base/debug_helpers.hpp"
+#include "v8/base/radix_sort.hpp"
+#include "v8/scene/draw_key.hpp"
 #include "v8/scene/camera_controller.hpp"
 #include "v8/scene/scene_entity.hpp"
 
 #include "v8/scene/scene_system.hpp"
 
+namespace {
+
+inline v8::math::aabb3F aabb_from_sphere(const v8::math::sphereF& sph) {
+    const v8::math::vector3F extents(sph.radius_, sph.radius_, sph.radius_);
+    return v8::math::aabb3F(sph.center_ - extents, sph.center_ + extents);
+}
+
+/**
+ * \brief Appends the entities reported by the spatial index to a list.
+ */
+struct visible_entity_collector {
+    std::vector<v8::scene::scene_entity*>*  vec_list;
+
+    void operator()(v8_int32_t, void* user_data) {
+        vec_list->push_back(static_cast<v8::scene::scene_entity*>(user_data));
+    }
+};
+
+/**
+ * \brief Tests a ray against the bounding spheres of the entities reported
+ *        by the spatial index and keeps the closest one.
+ */
+struct entity_picker {
+    const v8::math::ray3F*      ep_ray;
+    v8::scene::scene_entity*    ep_entity;
+    float                       ep_distance;
+
+    float operator()(v8_int32_t, void* user_data, float max_distance) {
+        v8::scene::scene_entity* s_ent = 
+            static_cast<v8::scene::scene_entity*>(user_data);
+        const v8::math::sphereF bound(s_ent->get_world_bound());
+
+        //
+        // Solve |O + t * D - C|^2 = r^2, with D unit length.
+        const v8::math::vector3F m(ep_ray->origin_ - bound.center_);
+        const float b = v8::math::dot_product(m, ep_ray->direction_);
+        const float c = v8::math::dot_product(m, m) 
+                        - bound.radius_ * bound.radius_;
+
+        if (c > 0.0f && b > 0.0f)
+            return max_distance;
+
+        const float discr = b * b - c;
+        if (discr < 0.0f)
+            return max_distance;
+
+        const float t = v8::math::max(-b - std::sqrt(discr), 0.0f);
+        if (t >= max_distance)
+            return max_distance;
+
+        ep_entity = s_ent;
+        ep_distance = t;
+        return t;
+    }
+};
+
+} // anonymous namespace
+
 v8::scene::scene_system::scene_system()
     :       m_light_count(0)
         ,   m_active_light_count(0)
         ,   m_active_list(0)
-{}
+        ,   m_unindexed_count(0)
+        ,   m_job_system(nullptr)
+{
+    m_frame_stats.entities_tested = 0;
+    m_frame_stats.nodes_visited = 0;
+    m_frame_stats.entities_culled = 0;
+    m_frame_stats.entities_drawn = 0;
+}
 
 v8::scene::scene_system::~scene_system() {}
 
+void
+v8::scene::scene_system::add_entity(scene_entity* new_entity) {
+    assert(new_entity);
+
+    //
+    // The entity is indexed on the next update or draw, so that the 
+    // entities of a scene being loaded are indexed together.
+    if (new_entity->has_local_bound()) {
+        ++m_unindexed_count;
+    } else {
+        m_unbounded_ents.push_back(new_entity);
+    }
+
+    m_entity_list.push_back(new_entity);
+    m_entity_proxies.push_back(v8::math::aabb_tree::C_Null_Node);
+}
+
+void
+v8::scene::scene_system::remove_entity(scene_entity* entity) {
+    using namespace std;
+
+    auto itr_entity = find(begin(m_entity_list), end(m_entity_list), entity);
+    if (itr_entity == end(m_entity_list)) {
+        return;
+    }
+
+    const v8_size_t ent_idx = static_cast<v8_size_t>(
+        itr_entity - begin(m_entity_list));
+
+    if (m_entity_proxies[ent_idx] != v8::math::aabb_tree::C_Null_Node) {
+        m_entity_tree.remove_proxy(m_entity_proxies[ent_idx]);
+    } else if (entity->has_local_bound() && m_unindexed_count) {
+        --m_unindexed_count;
+    }
+
+    m_unbounded_ents.erase(
+        remove(begin(m_unbounded_ents), end(m_unbounded_ents), entity),
+        end(m_unbounded_ents));
+    m_entity_proxies.erase(begin(m_entity_proxies) + ent_idx);
+
+    delete entity;
+    m_entity_list.erase(itr_entity);
+}
+
+v8::scene::scene_entity*
+v8::scene::scene_system::pick_entity(
+    const v8::math::ray3F& ray,
+    float* hit_distance
+    ) const {
+    entity_picker picker = { &ray, nullptr, 0.0f };
+    m_entity_tree.query_ray(ray, std::numeric_limits<float>::max(), picker);
+
+    if (picker.ep_entity && hit_distance) {
+        *hit_distance = picker.ep_distance;
+    }
+    return picker.ep_entity;
+}
+
+void
+v8::scene::scene_system::rebuild_spatial_index() {
+    m_unbounded_ents.clear();
+    m_build_boxes.clear();
+    m_build_entities.clear();
+
+    for (v8_size_t idx = 0; idx < m_entity_list.size(); ++idx) {
+        scene_entity* s_ent = m_entity_list[idx];
+        m_entity_proxies[idx] = v8::math::aabb_tree::C_Null_Node;
+
+        if (!s_ent->has_local_bound()) {
+            m_unbounded_ents.push_back(s_ent);
+            continue;
+        }
+
+        m_build_boxes.push_back(aabb_from_sphere(s_ent->get_world_bound()));
+        m_build_entities.push_back(s_ent);
+    }
+
+    m_build_proxies.resize(m_build_boxes.size());
+    m_entity_tree.build(
+        m_build_boxes.empty() ? nullptr : &m_build_boxes[0],
+        m_build_entities.empty() ? nullptr : &m_build_entities[0],
+        m_build_boxes.size(),
+        m_build_proxies.empty() ? nullptr : &m_build_proxies[0]);
+
+    v8_size_t built = 0;
+    for (v8_size_t idx = 0; idx < m_entity_list.size(); ++idx) {
+        if (m_entity_list[idx]->has_local_bound()) {
+            m_entity_proxies[idx] = m_build_proxies[built++];
+        }
+    }
+
+    m_unindexed_count = 0;
+}
+
+void
+v8::scene::scene_system::index_new_entities() {
+    if (!m_unindexed_count) {
+        return;
+    }
+
+    if (m_unindexed_count >= m_entity_tree.get_proxy_count()) {
+        rebuild_spatial_index();
+        return;
+    }
+
+    for (v8_size_t idx = 0; idx < m_entity_list.size(); ++idx) {
+        scene_entity* s_ent = m_entity_list[idx];
+
+        if (s_ent->has_local_bound() 
+            && m_entity_proxies[idx] == v8::math::aabb_tree::C_Null_Node) {
+            m_entity_proxies[idx] = m_entity_tree.insert_proxy(
+                aabb_from_sphere(s_ent->get_world_bound()), s_ent);
+        }
+    }
+
+    m_unindexed_count = 0;
+}
+
+void
+v8::scene::scene_system::update_spatial_index() {
+    index_new_entities();
+    m_unbounded_ents.clear();
+
+    for (v8_size_t idx = 0; idx < m_entity_list.size(); ++idx) {
+        scene_entity* s_ent = m_entity_list[idx];
+
+        if (!s_ent->has_local_bound()) {
+            m_unbounded_ents.push_back(s_ent);
+            continue;
+        }
+
+        //
+        // Leaves are stored with a margin, so small movements do not 
+        // touch the tree.
+        const v8::math::aabb3F world_box(
+            aabb_from_sphere(s_ent->get_world_bound()));
+
+        if (m_entity_proxies[idx] == v8::math::aabb_tree::C_Null_Node) {
+            m_entity_proxies[idx] = m_entity_tree.insert_proxy(world_box, s_ent);
+        } else {
+            m_entity_tree.move_proxy(m_entity_proxies[idx], world_box);
+        }
+    }
+}
+
+void
+v8::scene::scene_system::update_entity_transforms() {
+    m_transform_hierarchy.update_world_transforms();
+
+    for (v8_size_t idx = 0; idx < m_entity_list.size(); ++idx) {
+        scene_entity* s_ent = m_entity_list[idx];
+        const transform_hierarchy::node_handle node = 
+            s_ent->get_transform_node();
+
+        if (node != transform_hierarchy::C_Null_Node) {
+            s_ent->world_transform() = 
+                m_transform_hierarchy.get_world_transform(node);
+        }
+    }
+}
+
 void 
 v8::scene::scene_system::update(float delta_ms) {
     assert(check_valid());
 
     m_cam_controller->update(delta_ms);
 
-    using namespace std;
-    for_each(begin(m_entity_list), end(m_entity_list), [delta_ms](scene_entity* s_ent) {
-        s_ent->update(delta_ms);
-    });
+    if (!m_job_system) {
+        using namespace std;
+        for_each(begin(m_entity_list), end(m_entity_list), [delta_ms](scene_entity* s_ent) {
+            s_ent->update(delta_ms);
+        });
+    } else {
+        //
+        // Entities that did not declare their update thread safe are 
+        // updated on this thread, before the others.
+        m_parallel_update_ents.clear();
+        for (v8_size_t idx = 0; idx < m_entity_list.size(); ++idx) {
+            scene_entity* s_ent = m_entity_list[idx];
+            if (s_ent->is_update_thread_safe()) {
+                m_parallel_update_ents.push_back(s_ent);
+            } else {
+                s_ent->update(delta_ms);
+            }
+        }
+
+        const v8_size_t k_update_grain_size = 64;
+        std::vector<scene_entity*>& parallel_ents = m_parallel_update_ents;
+        m_job_system->parallel_for(
+            0, parallel_ents.size(), k_update_grain_size,
+            [&parallel_ents, delta_ms](v8_size_t first, v8_size_t last) {
+                for (v8_size_t idx = first; idx < last; ++idx) {
+                    parallel_ents[idx]->update(delta_ms);
+                }
+        });
+    }
+
+    update_entity_transforms();
+    update_spatial_index();
 }
 
 void 
@@ -32,6 +290,48 @@ v8::scene::scene_system::pre_draw(v8::rendering::renderer*) {
             m_active_lights[m_active_light_count++] = m_scene_ligths[light_idx];
         }
     }
+
+    build_visible_list();
+    depth_sort_all();
+}
+
+void
+v8::scene::scene_system::build_visible_list() {
+    m_visible_ent_list.clear();
+    index_new_entities();
+
+    const v8_size_t entity_count = m_entity_list.size();
+    m_frame_stats.entities_tested = 0;
+    m_frame_stats.nodes_visited = 0;
+    m_frame_stats.entities_culled = 0;
+    m_frame_stats.entities_drawn = 0;
+
+    if (!entity_count) {
+        return;
+    }
+
+    //
+    // Subtrees outside the frustrum are skipped entirely, subtrees inside
+    // it are accepted without testing their leaves.
+    m_culler.set_camera(&m_camera);
+
+    v8::math::plane3F cull_planes[v8::math::aabb_tree::C_Max_Query_Planes];
+    const v8_uint32_t plane_count = m_culler.get_active_planes(cull_planes);
+
+    visible_entity_collector collector = { &m_visible_ent_list };
+    v8::math::aabb_tree::query_stats_t query_stats;
+    m_entity_tree.query_planes(cull_planes, plane_count, collector, 
+                               &query_stats);
+
+    m_frame_stats.entities_tested = query_stats.qs_leaves_tested;
+    m_frame_stats.nodes_visited = query_stats.qs_nodes_visited;
+
+    m_visible_ent_list.insert(m_visible_ent_list.end(), 
+                              m_unbounded_ents.begin(), 
+                              m_unbounded_ents.end());
+
+    m_frame_stats.entities_culled = static_cast<v8_uint32_t>(
+        entity_count - m_visible_ent_list.size());
 }
 
 void 
@@ -46,18 +346,74 @@ v8::scene::scene_system::draw(v8::rendering::renderer* render_sys) {
     using namespace std;
     scene_system* scene_sys = this;
     for_each(
-        begin(m_entity_list),
-        end(m_entity_list),
+        begin(m_visible_ent_list),
+        end(m_visible_ent_list),
         [scene_sys, render_sys](scene_entity* s_ent) {
             s_ent->pre_draw(scene_sys, render_sys);
             s_ent->draw(scene_sys, render_sys);
             s_ent->post_draw(scene_sys, render_sys);
     });
 
+    m_frame_stats.entities_drawn = 
+        static_cast<v8_uint32_t>(m_visible_ent_list.size());
+
     post_draw(render_sys);
 }
 
 void 
 v8::scene::scene_system::depth_sort_all() {
     assert(check_valid());
+
+    const v8_size_t visible_count = m_visible_ent_list.size();
+    if (visible_count < 2) {
+        return;
+    }
+
+    const v8::math::vector3F& eye_pos = m_camera.get_origin();
+    const v8::math::vector3F& eye_dir = m_camera.get_direction_vector();
+    const float near_plane = m_camera.get_dmin();
+    const float far_plane = m_camera.get_dmax();
+
+    m_draw_items.resize(visible_count);
+    m_draw_items_scratch.resize(visible_count);
+
+    for (v8_size_t idx = 0; idx < visible_count; ++idx) {
+        scene_entity* s_ent = m_visible_ent_list[idx];
+
+        //
+        // Techniques get an id the first time they are seen. Ids past the
+        // key's range wrap, which only costs some extra state changes.
+        const void* technique = s_ent->get_active_technique();
+        auto itr_id = m_technique_ids.find(technique);
+        if (itr_id == m_technique_ids.end()) {
+            itr_id = m_technique_ids.insert(std::make_pair(
+                technique, static_cast<v8_uint32_t>(m_technique_ids.size())
+                )).first;
+        }
+
+        const v8::math::vector3F ent_pos = s_ent->has_local_bound()
+            ? s_ent->get_world_bound().center_ 
+            : s_ent->get_world_transform().get_translation_component();
+        const v8_uint32_t depth = draw_key::quantize_depth(
+            v8::math::dot_product(ent_pos - eye_pos, eye_dir), 
+            near_plane, far_plane);
+
+        draw_item_t& item = m_draw_items[idx];
+        item.di_entity = s_ent;
+        item.di_key = s_ent->is_translucent()
+            ? draw_key::make_translucent(
+                itr_id->second, s_ent->get_sort_material_id(), depth)
+            : draw_key::make_opaque(
+                itr_id->second, s_ent->get_sort_material_id(), depth);
+    }
+
+    v8::base::radix_sort(&m_draw_items[0], &m_draw_items[0] + visible_count,
+                         &m_draw_items_scratch[0], 
+                         [](const draw_item_t& item) {
+        return item.di_key;
+    });
+
+    for (v8_size_t idx = 0; idx < visible_count; ++idx) {
+        m_visible_ent_list[idx] = m_draw_items[idx].di_entity;
+    }
 }
@@ -0,0 +1,260 @@
+#include <algorithm>
+#include "v8/scene/transform_hierarchy.hpp"
+
+namespace {
+
+//
+// Rearranges data so that the element in slot new_order[i] ends in slot i.
+template<typename T>
+void apply_order(const std::vector<v8_int32_t>& new_order, std::vector<T>* data) {
+    std::vector<T> reordered;
+    reordered.reserve(data->size());
+
+    for (v8_size_t i = 0; i < new_order.size(); ++i)
+        reordered.push_back((*data)[new_order[i]]);
+
+    data->swap(reordered);
+}
+
+} // anonymous namespace
+
+const v8::scene::transform_hierarchy::node_handle
+v8::scene::transform_hierarchy::C_Null_Node;
+
+v8::scene::transform_hierarchy::transform_hierarchy()
+    : order_valid_(true) {
+}
+
+void v8::scene::transform_hierarchy::reserve(v8_size_t node_count) {
+    parent_slot_.reserve(node_count);
+    slot_handles_.reserve(node_count);
+    local_transforms_.reserve(node_count);
+    world_transforms_.reserve(node_count);
+    local_dirty_.reserve(node_count);
+    world_changed_.reserve(node_count);
+    handle_slots_.reserve(node_count);
+}
+
+bool v8::scene::transform_hierarchy::is_valid_node(node_handle node) const {
+    return node >= 0 
+        && static_cast<v8_size_t>(node) < handle_slots_.size()
+        && handle_slots_[node] != -1;
+}
+
+v8::scene::transform_hierarchy::node_handle
+v8::scene::transform_hierarchy::add_node(
+    node_handle parent, 
+    const v8::math::transformF& local_transform
+    ) {
+    assert((parent == C_Null_Node || is_valid_node(parent)) 
+           && "Invalid parent node!");
+
+    const v8_int32_t slot = static_cast<v8_int32_t>(parent_slot_.size());
+
+    node_handle node;
+    if (!free_handles_.empty()) {
+        node = free_handles_.back();
+        free_handles_.pop_back();
+        handle_slots_[node] = slot;
+    } else {
+        node = static_cast<node_handle>(handle_slots_.size());
+        handle_slots_.push_back(slot);
+    }
+
+    //
+    // Appending keeps the parent before child order, since the parent is
+    // already stored.
+    parent_slot_.push_back(parent == C_Null_Node ? -1 : slot_of(parent));
+    slot_handles_.push_back(node);
+    local_transforms_.push_back(local_transform);
+    world_transforms_.push_back(local_transform);
+    local_dirty_.push_back(1);
+    world_changed_.push_back(0);
+    return node;
+}
+
+void v8::scene::transform_hierarchy::remove_node(node_handle node) {
+    if (!order_valid_)
+        restore_order();
+
+    const v8_int32_t first_removed = slot_of(node);
+    const v8_int32_t node_count = static_cast<v8_int32_t>(parent_slot_.size());
+
+    //
+    // Descendants come after their parents, so the subtree is found in a 
+    // single pass. The slots are compacted in the same pass, which keeps 
+    // the relative order (and thus the invariant) of the remaining nodes.
+    // world_changed_ is used to flag the removed nodes.
+    std::fill(world_changed_.begin() + first_removed, world_changed_.end(), 0);
+    world_changed_[first_removed] = 1;
+
+    std::vector<v8_int32_t> new_slots(node_count - first_removed, -1);
+    v8_int32_t dst = first_removed;
+
+    for (v8_int32_t src = first_removed; src < node_count; ++src) {
+        const v8_int32_t parent = parent_slot_[src];
+
+        if (src != first_removed && parent >= first_removed 
+            && world_changed_[parent]) {
+            world_changed_[src] = 1;
+        }
+
+        if (world_changed_[src]) {
+            handle_slots_[slot_handles_[src]] = -1;
+            free_handles_.push_back(slot_handles_[src]);
+            continue;
+        }
+
+        new_slots[src - first_removed] = dst;
+        parent_slot_[dst] = parent < first_removed ? 
+            parent : new_slots[parent - first_removed];
+        slot_handles_[dst] = slot_handles_[src];
+        handle_slots_[slot_handles_[dst]] = dst;
+        local_transforms_[dst] = local_transforms_[src];
+        world_transforms_[dst] = world_transforms_[src];
+        local_dirty_[dst] = local_dirty_[src];
+        ++dst;
+    }
+
+    parent_slot_.resize(dst);
+    slot_handles_.resize(dst);
+    local_transforms_.resize(dst);
+    world_transforms_.resize(dst);
+    local_dirty_.resize(dst);
+    world_changed_.resize(dst);
+}
+
+void v8::scene::transform_hierarchy::set_parent(
+    node_handle node, 
+    node_handle parent
+    ) {
+    const v8_int32_t slot = slot_of(node);
+    v8_int32_t parent_slot = -1;
+
+    if (parent != C_Null_Node) {
+        parent_slot = slot_of(parent);
+
+        for (v8_int32_t ancestor = parent_slot; ancestor != -1; 
+             ancestor = parent_slot_[ancestor]) {
+            assert((ancestor != slot) && "Parent is a descendant of the node!");
+        }
+    }
+
+    parent_slot_[slot] = parent_slot;
+    local_dirty_[slot] = 1;
+
+    if (parent_slot > slot)
+        order_valid_ = false;
+}
+
+v8::scene::transform_hierarchy::node_handle
+v8::scene::transform_hierarchy::get_parent(node_handle node) const {
+    const v8_int32_t parent = parent_slot_[slot_of(node)];
+    return parent == -1 ? C_Null_Node : slot_handles_[parent];
+}
+
+void v8::scene::transform_hierarchy::clear() {
+    parent_slot_.clear();
+    slot_handles_.clear();
+    local_transforms_.clear();
+    world_transforms_.clear();
+    local_dirty_.clear();
+    world_changed_.clear();
+    handle_slots_.clear();
+    free_handles_.clear();
+    order_valid_ = true;
+}
+
+void v8::scene::transform_hierarchy::set_local_transform(
+    node_handle node, 
+    const v8::math::transformF& local_transform
+    ) {
+    const v8_int32_t slot = slot_of(node);
+    local_transforms_[slot] = local_transform;
+    local_dirty_[slot] = 1;
+}
+
+v8_size_t v8::scene::transform_hierarchy::update_world_transforms() {
+    if (!order_valid_)
+        restore_order();
+
+    const v8_size_t node_count = parent_slot_.size();
+    v8_size_t updated_count = 0;
+
+    for (v8_size_t slot = 0; slot < node_count; ++slot) {
+        const v8_int32_t parent = parent_slot_[slot];
+        const v8_uint8_t changed = local_dirty_[slot] 
+            | (parent == -1 ? 0 : world_changed_[parent]);
+
+        world_changed_[slot] = changed;
+        if (!changed)
+            continue;
+
+        local_dirty_[slot] = 0;
+        world_transforms_[slot] = local_transforms_[slot];
+        if (parent != -1)
+            world_transforms_[slot] *= world_transforms_[parent];
+
+        ++updated_count;
+    }
+
+    return updated_count;
+}
+
+void v8::scene::transform_hierarchy::restore_order() {
+    //
+    // Sorting the nodes by depth (stable, so siblings keep their relative 
+    // order) puts every parent before its children.
+    const v8_int32_t node_count = static_cast<v8_int32_t>(parent_slot_.size());
+    std::vector<v8_int32_t> depth(node_count, -1);
+    std::vector<v8_int32_t> path;
+    v8_int32_t max_depth = 0;
+
+    for (v8_int32_t slot = 0; slot < node_count; ++slot) {
+        v8_int32_t current = slot;
+        while (current != -1 && depth[current] == -1) {
+            path.push_back(current);
+            current = parent_slot_[current];
+        }
+
+        v8_int32_t current_depth = current == -1 ? -1 : depth[current];
+        while (!path.empty()) {
+            depth[path.back()] = ++current_depth;
+            path.pop_back();
+        }
+
+        max_depth = std::max(max_depth, depth[slot]);
+    }
+
+    std::vector<v8_int32_t> level_start(max_depth + 2, 0);
+    for (v8_int32_t slot = 0; slot < node_count; ++slot)
+        ++level_start[depth[slot] + 1];
+
+    for (v8_size_t level = 1; level < level_start.size(); ++level)
+        level_start[level] += level_start[level - 1];
+
+    std::vector<v8_int32_t> new_order(node_count);
+    std::vector<v8_int32_t> new_slots(node_count);
+    for (v8_int32_t slot = 0; slot < node_count; ++slot) {
+        const v8_int32_t new_slot = level_start[depth[slot]]++;
+        new_order[new_slot] = slot;
+        new_slots[slot] = new_slot;
+    }
+
+    apply_order(new_order, &parent_slot_);
+    for (v8_int32_t slot = 0; slot < node_count; ++slot) {
+        if (parent_slot_[slot] != -1)
+            parent_slot_[slot] = new_slots[parent_slot_[slot]];
+    }
+
+    apply_order(new_order, &slot_handles_);
+    apply_order(new_order, &local_transforms_);
+    apply_order(new_order, &world_transforms_);
+    apply_order(new_order, &local_dirty_);
+    apply_order(new_order, &world_changed_);
+
+    for (v8_int32_t slot = 0; slot < node_count; ++slot)
+        handle_slots_[slot_handles_[slot]] = slot;
+
+    order_valid_ = true;
+}
@@ -1,167 +1,208 @@
-#include <Windows.h>
-#include <v8/base/handle_traits/win32_file.hpp>
-#include <v8/base/scoped_handle.hpp>
-#include <v8/base/shims/scoped_handle.hpp>
+#include <cstring>
+#include <exception>
+
+#include <v8/base/memory_mapped_file.hpp>
+#include <v8/math/mesh_normals.hpp>
+#include <v8/math/mesh_streams.hpp>
 
 #include "v8/utility/ifs_loader.hpp"
 
-v8_bool_t
-v8::utility::ifs_loader::readStringData(HANDLE                      fptr, 
-                                        std::vector<v8_uint8_t>*    str) {
-    unsigned int strLen;
-    DWORD bytesOut;
-    if (!::ReadFile(fptr, &strLen, sizeof(strLen), &bytesOut, 0)) {
-        return false;
-    }
+namespace {
 
-    str->resize(strLen);
-    return ::ReadFile(fptr, &(*str)[0], strLen, &bytesOut, 0);
-}
+//
+// Bounds checked forward reader over the mapped file. IFS data is tightly
+// packed, so multi byte values are read with memcpy and make no alignment
+// assumptions.
+class ifs_stream {
+public :
+    ifs_stream(const void* data, v8_size_t size)
+        :   pos_(static_cast<const v8_uint8_t*>(data)),
+            end_(static_cast<const v8_uint8_t*>(data) + size) {}
 
-v8_bool_t
-v8::utility::ifs_loader::readFloat(HANDLE           fptr, 
-                                   float*           outVal) {
-    DWORD bytesRead;
-    return ::ReadFile(fptr, outVal, sizeof(float), &bytesRead, 0) == TRUE;
-}
+    v8_size_t remaining() const {
+        return static_cast<v8_size_t>(end_ - pos_);
+    }
 
-v8_bool_t
-v8::utility::ifs_loader::readUint(HANDLE        fptr, 
-                                  v8_uint_t*    outVal) {
-    DWORD bytesRead;
-    return ::ReadFile(fptr, outVal, sizeof(*outVal), &bytesRead, 0);
-}
+    const v8_uint8_t* current() const {
+        return pos_;
+    }
 
-v8_bool_t
-v8::utility::ifs_loader::readElementCount(HANDLE            fptr, 
-                                          v8_uint_t*        vertexCnt, 
-                                          const char*       hdrString) {
-    std::vector<v8_uint8_t> headerStr;
-    if (!readStringData(fptr, &headerStr))
-        return false;
+    v8_bool_t skip(v8_size_t bytes) {
+        if (bytes > remaining())
+            return false;
 
-    std::string vertexHDRStr((const char*)&headerStr[0]);
-    if (vertexHDRStr.compare(hdrString))
-        return false;
+        pos_ += bytes;
+        return true;
+    }
 
-    return readUint(fptr, vertexCnt);
-}
+    template<typename T>
+    v8_bool_t read(T* out_val) {
+        if (sizeof(T) > remaining())
+            return false;
 
-v8_bool_t
-v8::utility::ifs_loader::readVertices(HANDLE            fptr, 
-                                      v8_uint_t         howMany) {
-    vertexData_.reserve(howMany);
-    v8_bool_t failed = true;
-    for (unsigned int i = 0; (i < howMany) && failed; ++i) {
-        rendering::vertex_pn currentVertex;
-        failed = readFloat(fptr, &currentVertex.position.x_);
-        failed = readFloat(fptr, &currentVertex.position.y_);
-        failed = readFloat(fptr, &currentVertex.position.z_);
-
-        if (invert_z_) {
-            currentVertex.position.z_ *= -1.0f;
-        }
-        currentVertex.normal = v8::math::vector3F::zero;
-        vertexData_.push_back(currentVertex);
+        memcpy(out_val, pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
     }
-    return failed;
-}
 
-v8_bool_t
-v8::utility::ifs_loader::readFaces(HANDLE       fptr, 
-                                   v8_uint_t    howMany) {
-    indexData_.reserve(howMany);
-    v8_bool_t succeeded = true;
-    v8_uint_t currentIndex;
-    for (v8_uint_t i = 0; (i < howMany) && succeeded; ++i) {
-        succeeded = readUint(fptr, &currentIndex);
-        indexData_.push_back(currentIndex);
-        succeeded = readUint(fptr, &currentIndex);
-        indexData_.push_back(currentIndex);
-        succeeded = readUint(fptr, &currentIndex);
-        indexData_.push_back(currentIndex);
+    //
+    // Strings are stored as a 32 bit length followed by that many bytes,
+    // usually including a terminating null.
+    v8_bool_t read_string(std::string* str) {
+        v8_uint32_t str_len;
+        if (!read(&str_len) || str_len > remaining())
+            return false;
+
+        const char* str_data = reinterpret_cast<const char*>(pos_);
+        const void* terminator = memchr(str_data, 0, str_len);
+        str->assign(str_data, terminator ? 
+            static_cast<const char*>(terminator) - str_data : str_len);
+
+        pos_ += str_len;
+        return true;
     }
 
-    return succeeded;
-}
+    v8_bool_t read_element_count(const char* hdr_string, v8_uint_t* count) {
+        std::string hdr;
+        return read_string(&hdr) && !hdr.compare(hdr_string) && read(count);
+    }
 
-v8_bool_t
-v8::utility::ifs_loader::readIFSHeader(HANDLE   fptr) {
-    std::vector<v8_uint8_t> strBuff;
-    if (!readStringData(fptr, &strBuff))
-        return false;
+private :
+    const v8_uint8_t*   pos_;
+    const v8_uint8_t*   end_;
+};
 
-    std::string readStr((const char*) &strBuff[0]);
-    if (readStr.compare("IFS"))
-        return false;
+const v8_size_t k_ifs_vertex_bytes  = 3 * sizeof(float);
+const v8_size_t k_ifs_face_bytes    = 3 * sizeof(v8_uint32_t);
 
-    if (!readFloat(fptr, &ifsVersion_))
-        return false;
+} // anonymous namespace
 
-    if (!readStringData(fptr, &strBuff))
-        return false;
+v8_bool_t
+v8::utility::ifs_loader::readVertices(const v8_uint8_t*     src, 
+                                      v8_uint_t             howMany) {
+    using rendering::vertex_pn;
+
+    vertexData_.resize(howMany);
+    if (!howMany)
+        return true;
+
+    //
+    // Single pass over the packed positions. Inversion is a multiply by
+    // +1/-1 rather than a branch, so the loop stays straight line code.
+    const float z_sign = invert_z_ ? -1.0f : 1.0f;
+    vertex_pn* dst = &vertexData_[0];
+
+    for (v8_uint_t i = 0; i < howMany; ++i) {
+        float pos[3];
+        memcpy(pos, src + i * k_ifs_vertex_bytes, sizeof(pos));
+
+        dst[i].position.x_ = pos[0];
+        dst[i].position.y_ = pos[1];
+        dst[i].position.z_ = pos[2] * z_sign;
+        dst[i].normal = v8::math::vector3F::zero;
+    }
 
-    modelName_.assign((const char*) &strBuff[0]);
     return true;
 }
 
-void v8::utility::ifs_loader::compute_mesh_normals() {
-    using rendering::vertex_pn;
+v8_bool_t
+v8::utility::ifs_loader::readFaces(const v8_uint8_t*    src, 
+                                   v8_uint_t            howMany) {
+    indexData_.resize(static_cast<v8_size_t>(howMany) * 3);
+    if (!howMany)
+        return true;
 
-    for (v8_uint_t i = 0; i < numFaces_; ++i) {
-        vertex_pn& v0 = vertexData_[indexData_[i * 3 + 0]];
-        vertex_pn& v1 = vertexData_[indexData_[i * 3 + 1]];
-        vertex_pn& v2 = vertexData_[indexData_[i * 3 + 2]];
+    memcpy(&indexData_[0], src, indexData_.size() * sizeof(indexData_[0]));
 
-        const auto e0 = v1.position - v0.position;
-        const auto e1 = v2.position - v0.position;
+    //
+    // Reject out of range indices here, compute_mesh_normals() indexes the
+    // vertex array with them unchecked.
+    const v8_uint32_t num_vertices = static_cast<v8_uint32_t>(vertexData_.size());
+    v8_uint32_t out_of_range = 0;
+    for (v8_size_t i = 0; i < indexData_.size(); ++i)
+        out_of_range |= static_cast<v8_uint32_t>(indexData_[i]) >= num_vertices;
+
+    return !out_of_range;
+}
 
-        const auto normal = v8::math::cross_product(e0, e1);
+void v8::utility::ifs_loader::compute_mesh_normals(base::job_system* jobs) {
+    using rendering::vertex_pn;
 
-        v0.normal += normal;
-        v1.normal += normal;
-        v2.normal += normal;
-    }
+    if (indexData_.empty())
+        return;
 
-    for (v8_size_t i = 0; i < vertexData_.size(); ++i) {
-        vertexData_[i].normal.normalize();
-    }
+    //
+    // Indices were validated in readFaces(), so they are non negative.
+    math::compute_vertex_normals(
+        &vertexData_[0], vertexData_.size(),
+        reinterpret_cast<const v8_uint32_t*>(&indexData_[0]), numFaces_,
+        &vertex_pn::position, &vertex_pn::normal, 
+        math::Normal_Weight_Area, jobs);
 }
 
 v8_bool_t
-v8::utility::ifs_loader::loadModel(const char*      modelFile,
-                                   v8_bool_t        invert_z) {
+v8::utility::ifs_loader::loadModel(const char*          modelFile,
+                                   v8_bool_t            invert_z,
+                                   base::job_system*    jobs) {
     isValid_    = false;
     invert_z_   = invert_z;
+    numFaces_   = 0;
+    vertexData_.clear();
+    indexData_.clear();
 
-    base::scoped_handle<base::win32_file> fileFD(
-        CreateFileA(modelFile, GENERIC_READ, 0, 0, OPEN_EXISTING, 
-                    FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, 0));
+    try {
+        base::memory_mapped_file mmfile(modelFile);
+        if (!mmfile.memory())
+            return false;
 
-    if (!fileFD)
-        return false;
+        ifs_stream ifs_data(mmfile.memory(), mmfile.size());
 
-    if (!readIFSHeader(raw_handle(fileFD)))
-        return false;
+        std::string read_str;
+        if (!ifs_data.read_string(&read_str) || read_str.compare("IFS"))
+            return false;
 
-    //
-    // read vertex count
-    v8_uint_t elements;
-    if (!readElementCount(raw_handle(fileFD), &elements, "VERTICES"))
-        return false;
+        if (!ifs_data.read(&ifsVersion_) || !ifs_data.read_string(&modelName_))
+            return false;
 
-    if (!readVertices(raw_handle(fileFD), elements))
-        return false;
+        //
+        // Vertex block.
+        v8_uint_t elements;
+        if (!ifs_data.read_element_count("VERTICES", &elements))
+            return false;
 
-    //
-    // read face count
-    if (!readElementCount(raw_handle(fileFD), &numFaces_, "TRIANGLES"))
-        return false;
+        if (elements > ifs_data.remaining() / k_ifs_vertex_bytes)
+            return false;
+
+        const v8_uint8_t* vertex_block = ifs_data.current();
+        ifs_data.skip(elements * k_ifs_vertex_bytes);
+
+        //
+        // Face block.
+        if (!ifs_data.read_element_count("TRIANGLES", &numFaces_))
+            return false;
 
-    if (!readFaces(raw_handle(fileFD), numFaces_))
+        if (numFaces_ > ifs_data.remaining() / k_ifs_face_bytes)
+            return false;
+
+        if (!readVertices(vertex_block, elements) ||
+            !readFaces(ifs_data.current(), numFaces_))
+            return false;
+    }
+    catch (const std::exception&) {
         return false;
+    }
 
-    compute_mesh_normals();
+    compute_mesh_normals(jobs);
     isValid_ = true;
     return true;
 }
+
+void v8::utility::ifs_loader::getVertexStreams(math::mesh_streams* streams) const {
+    using rendering::vertex_pn;
+
+    assert(isValid_);
+    streams->deinterleave(
+        vertexData_.data(), 
+        math::make_vertex_layout(&vertex_pn::position, &vertex_pn::normal),
+        vertexData_.size());
+}
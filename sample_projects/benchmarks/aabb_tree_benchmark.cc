@@ -0,0 +1,179 @@
+///
+/// \file   aabb_tree_benchmark.cc
+/// \brief  Builds aabb_trees over 10k, 100k and 1M boxes, both with the SAH
+///         build and with incremental insertions, and times view frustrum
+///         queries against a test of every box.
+///         Usage : aabb_tree_benchmark [max_box_count]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/math/culling/cull_aabb.hpp>
+#include <v8/math/objects/axis_aligned_bounding_box3.hpp>
+#include <v8/math/objects/plane.hpp>
+#include <v8/math/spatial/aabb_tree.hpp>
+
+namespace {
+
+using v8::math::aabb3F;
+using v8::math::aabb_tree;
+using v8::math::plane3F;
+using v8::math::vector3F;
+
+const v8_uint32_t C_Frustrum_Planes = 6;
+const int C_Query_Runs = 10;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+///
+/// \brief  Boxes of 1 to 4 units, scattered with a constant density in a
+///         cube that grows with the count.
+std::vector<aabb3F> make_boxes(v8_size_t count, float* world_size) {
+    *world_size = 200.0f * std::cbrt(static_cast<float>(count) / 10000.0f);
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<float> coord(0.0f, *world_size);
+    std::uniform_real_distribution<float> half_size(0.5f, 2.0f);
+
+    std::vector<aabb3F> boxes(count);
+    for (v8_size_t i = 0; i < count; ++i) {
+        const vector3F center(coord(rng), coord(rng), coord(rng));
+        const float r = half_size(rng);
+        const vector3F extents(r, r, r);
+        boxes[i] = aabb3F(center - extents, center + extents);
+    }
+
+    return boxes;
+}
+
+///
+/// \brief  Inward facing planes of a 60 degrees frustrum that looks along +z
+///         from the middle of the front face of the world, down to a third
+///         of its depth.
+void make_frustrum(float world_size, plane3F* planes) {
+    const vector3F eye(world_size * 0.5f, world_size * 0.5f, -1.0f);
+    const float s = std::sin(3.14159265f / 6.0f);
+    const float c = std::cos(3.14159265f / 6.0f);
+
+    planes[0] = plane3F(vector3F(0.0f, 0.0f, 1.0f), eye);
+    planes[1] = plane3F(vector3F(0.0f, 0.0f, -1.0f),
+                        eye + vector3F(0.0f, 0.0f, world_size / 3.0f));
+    planes[2] = plane3F(vector3F(c, 0.0f, s), eye);
+    planes[3] = plane3F(vector3F(-c, 0.0f, s), eye);
+    planes[4] = plane3F(vector3F(0.0f, c, s), eye);
+    planes[5] = plane3F(vector3F(0.0f, -c, s), eye);
+}
+
+struct visible_counter {
+    v8_size_t   vc_count;
+
+    void operator()(v8_int32_t, void*) {
+        ++vc_count;
+    }
+};
+
+struct query_result_t {
+    double                      qr_ms;
+    v8_size_t                   qr_visible;
+    aabb_tree::query_stats_t    qr_stats;
+};
+
+query_result_t time_query(const aabb_tree& tree, const plane3F* planes) {
+    query_result_t result;
+    result.qr_ms = 1.0e30;
+
+    for (int run = 0; run < C_Query_Runs; ++run) {
+        visible_counter counter = { 0 };
+        const auto start = std::chrono::steady_clock::now();
+        tree.query_planes(planes, C_Frustrum_Planes, counter, &result.qr_stats);
+        result.qr_ms = std::min(result.qr_ms, elapsed_ms(start));
+        result.qr_visible = counter.vc_count;
+    }
+
+    return result;
+}
+
+bool run_benchmark(v8_size_t count) {
+    float world_size = 0.0f;
+    const std::vector<aabb3F> boxes = make_boxes(count, &world_size);
+
+    plane3F planes[C_Frustrum_Planes];
+    make_frustrum(world_size, planes);
+
+    //
+    // Reference : every box against every plane.
+    double brute_ms = 1.0e30;
+    v8_size_t brute_visible = 0;
+    for (int run = 0; run < C_Query_Runs; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        v8_size_t visible = 0;
+        for (v8_size_t i = 0; i < count; ++i) {
+            bool culled = false;
+            for (v8_uint32_t p = 0; p < C_Frustrum_Planes && !culled; ++p) {
+                culled = v8::math::classify_object(planes[p], boxes[i])
+                         == plane3F::Plane_Negative_Side;
+            }
+            visible += !culled;
+        }
+        brute_ms = std::min(brute_ms, elapsed_ms(start));
+        brute_visible = visible;
+    }
+
+    std::vector<v8_int32_t> proxies(count);
+    aabb_tree built_tree;
+    auto start = std::chrono::steady_clock::now();
+    built_tree.build(&boxes[0], nullptr, count, &proxies[0]);
+    const double build_ms = elapsed_ms(start);
+
+    //
+    // Without margin the leaves hold the same boxes as the built tree.
+    aabb_tree grown_tree;
+    grown_tree.set_fat_margin(0.0f);
+    start = std::chrono::steady_clock::now();
+    for (v8_size_t i = 0; i < count; ++i)
+        grown_tree.insert_proxy(boxes[i], nullptr);
+    const double insert_ms = elapsed_ms(start);
+
+    const query_result_t built = time_query(built_tree, planes);
+    const query_result_t grown = time_query(grown_tree, planes);
+
+    printf("%8zu boxes, %zu visible, test of every box %.3f ms\n",
+           count, brute_visible, brute_ms);
+    printf("    SAH build    %8.2f ms, height %3d, query %.3f ms, "
+           "%u nodes visited, %u leaves tested\n",
+           build_ms, built_tree.get_height(), built.qr_ms,
+           built.qr_stats.qs_nodes_visited, built.qr_stats.qs_leaves_tested);
+    printf("    insertions   %8.2f ms, height %3d, query %.3f ms, "
+           "%u nodes visited, %u leaves tested\n",
+           insert_ms, grown_tree.get_height(), grown.qr_ms,
+           grown.qr_stats.qs_nodes_visited, grown.qr_stats.qs_leaves_tested);
+
+    if (built.qr_visible != brute_visible || grown.qr_visible != brute_visible) {
+        printf("    MISMATCH : %zu (built) and %zu (inserted) visible boxes\n",
+               built.qr_visible, grown.qr_visible);
+        return false;
+    }
+
+    return true;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const v8_size_t max_count = argc > 1
+        ? static_cast<v8_size_t>(std::strtoul(argv[1], nullptr, 10)) : 1000000;
+
+    bool passed = true;
+    for (v8_size_t count = 10000; count <= max_count; count *= 10)
+        passed = run_benchmark(count) && passed;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
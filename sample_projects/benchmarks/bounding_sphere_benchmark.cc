@@ -0,0 +1,358 @@
+///
+/// \file   bounding_sphere_benchmark.cc
+/// \brief  Computes the bounding spheres of point sets with several
+///         distributions (aabb, average, Ritter, minimal), checks that every
+///         sphere encloses all the points and that the minimal sphere is
+///         not larger than the others and matches a brute force search on
+///         small sets, then reports the radii and the times. The generic
+///         aabb and average templates are timed as the old code.
+///         Usage : bounding_sphere_benchmark [point_count] [run_count]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/math/vector3.hpp>
+#include <v8/math/objects/sphere.hpp>
+#include <v8/math/containment/containment_sphere.hpp>
+
+namespace {
+
+using v8::math::sphereF;
+using v8::math::vector3F;
+
+//
+// Tolerances, relative to the radius, for the enclosure test and the
+// comparisons between radii.
+const double C_Enclosure_Tolerance = 1.0e-5;
+const double C_Radius_Tolerance = 1.0e-5;
+
+const int C_Small_Set_Count = 300;
+const v8_size_t C_Small_Set_Size = 12;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+enum Distribution {
+    Distribution_Cube,
+    Distribution_Gaussian,
+    Distribution_Shell,
+    Distribution_Clusters,
+    Distribution_Count
+};
+
+const char* const C_Distribution_Names[Distribution_Count] = {
+    "uniform cube", "gaussian", "ellipsoid shell", "5 clusters"
+};
+
+std::vector<vector3F> make_points(Distribution distribution, v8_size_t count,
+                                  std::mt19937& rng) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::normal_distribution<float> gauss(0.0f, 1.0f);
+    std::vector<vector3F> points(count);
+
+    vector3F cluster_centers[5];
+    for (vector3F& center : cluster_centers)
+        center = vector3F(unit(rng), unit(rng), unit(rng)) * 6.0f;
+
+    for (v8_size_t i = 0; i < count; ++i) {
+        switch (distribution) {
+        case Distribution_Cube :
+            points[i] = vector3F(unit(rng), unit(rng), unit(rng));
+            break;
+
+        case Distribution_Gaussian :
+            points[i] = vector3F(gauss(rng), gauss(rng), gauss(rng));
+            break;
+
+        case Distribution_Shell : {
+            vector3F dir(gauss(rng), gauss(rng), gauss(rng));
+            dir.normalize();
+            points[i] = vector3F(3.0f * dir.x_, 2.0f * dir.y_, dir.z_);
+        }
+            break;
+
+        default :
+            points[i] = cluster_centers[i % 5]
+                + vector3F(gauss(rng), gauss(rng), gauss(rng)) * 0.5f;
+            break;
+        }
+    }
+
+    return points;
+}
+
+///
+/// \brief  Largest distance of a point outside the sphere, relative to
+///         the radius (negative if all points are strictly inside).
+double max_excess(const std::vector<vector3F>& points, const sphereF& sph) {
+    double excess = -1.0e300;
+    for (const vector3F& p : points) {
+        const double dx = double(p.x_) - sph.center_.x_;
+        const double dy = double(p.y_) - sph.center_.y_;
+        const double dz = double(p.z_) - sph.center_.z_;
+        excess = std::max(excess, std::sqrt(dx * dx + dy * dy + dz * dz) - sph.radius_);
+    }
+    return excess / std::max(1.0e-30, double(sph.radius_));
+}
+
+struct dsphere {
+    double c[3];
+    double r;
+};
+
+bool encloses(const dsphere& s, const std::vector<vector3F>& points) {
+    for (const vector3F& p : points) {
+        const double d[3] = { p.x_ - s.c[0], p.y_ - s.c[1], p.z_ - s.c[2] };
+        if (std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]) > s.r * (1.0 + 1.0e-9) + 1.0e-12)
+            return false;
+    }
+    return true;
+}
+
+///
+/// \brief  Sphere through up to four points, with its center in their
+///         affine hull. False for degenerate configurations.
+bool sphere_through(const vector3F* const* pts, int count, dsphere* s) {
+    const double p0[3] = { pts[0]->x_, pts[0]->y_, pts[0]->z_ };
+    double a[3][3];
+    double rhs[3];
+    for (int i = 1; i < count; ++i) {
+        a[i - 1][0] = pts[i]->x_ - p0[0];
+        a[i - 1][1] = pts[i]->y_ - p0[1];
+        a[i - 1][2] = pts[i]->z_ - p0[2];
+        rhs[i - 1] = 0.5 * (a[i - 1][0] * a[i - 1][0] + a[i - 1][1] * a[i - 1][1]
+                            + a[i - 1][2] * a[i - 1][2]);
+    }
+
+    double x[3] = { 0.0, 0.0, 0.0 };
+    if (count == 2) {
+        for (int k = 0; k < 3; ++k)
+            x[k] = 0.5 * a[0][k];
+    } else if (count == 3) {
+        //
+        // x = s * a0 + t * a1, with a_i . x = rhs_i.
+        const double g00 = a[0][0] * a[0][0] + a[0][1] * a[0][1] + a[0][2] * a[0][2];
+        const double g01 = a[0][0] * a[1][0] + a[0][1] * a[1][1] + a[0][2] * a[1][2];
+        const double g11 = a[1][0] * a[1][0] + a[1][1] * a[1][1] + a[1][2] * a[1][2];
+        const double det = g00 * g11 - g01 * g01;
+        if (std::fabs(det) < 1.0e-12 * g00 * g11)
+            return false;
+        const double s0 = (rhs[0] * g11 - rhs[1] * g01) / det;
+        const double s1 = (rhs[1] * g00 - rhs[0] * g01) / det;
+        for (int k = 0; k < 3; ++k)
+            x[k] = s0 * a[0][k] + s1 * a[1][k];
+    } else {
+        const double det =
+            a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1])
+            - a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0])
+            + a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+        if (std::fabs(det) < 1.0e-12)
+            return false;
+        for (int k = 0; k < 3; ++k) {
+            double m[3][3];
+            for (int i = 0; i < 3; ++i) {
+                for (int j = 0; j < 3; ++j)
+                    m[i][j] = (j == k) ? rhs[i] : a[i][j];
+            }
+            x[k] = (m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+                    - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+                    + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0])) / det;
+        }
+    }
+
+    for (int k = 0; k < 3; ++k)
+        s->c[k] = p0[k] + x[k];
+    s->r = std::sqrt(x[0] * x[0] + x[1] * x[1] + x[2] * x[2]);
+    return true;
+}
+
+///
+/// \brief  Minimum enclosing sphere by trying every sphere through 2, 3 or
+///         4 of the points.
+double brute_force_minimal_radius(const std::vector<vector3F>& points) {
+    const v8_size_t n = points.size();
+    double best = 1.0e300;
+    const vector3F* pts[4];
+
+    for (v8_size_t i = 0; i < n; ++i) {
+        for (v8_size_t j = i + 1; j < n; ++j) {
+            pts[0] = &points[i];
+            pts[1] = &points[j];
+            dsphere s;
+            if (sphere_through(pts, 2, &s) && s.r < best && encloses(s, points))
+                best = s.r;
+
+            for (v8_size_t k = j + 1; k < n; ++k) {
+                pts[2] = &points[k];
+                if (sphere_through(pts, 3, &s) && s.r < best && encloses(s, points))
+                    best = s.r;
+
+                for (v8_size_t l = k + 1; l < n; ++l) {
+                    pts[3] = &points[l];
+                    if (sphere_through(pts, 4, &s) && s.r < best && encloses(s, points))
+                        best = s.r;
+                }
+            }
+        }
+    }
+
+    return best;
+}
+
+///
+/// \brief  Small sets, some of them almost flat, against the brute force
+///         minimum.
+bool check_small_sets(std::mt19937& rng, double* worst_error) {
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    bool passed = true;
+    *worst_error = 0.0;
+
+    for (int set = 0; set < C_Small_Set_Count; ++set) {
+        const float flatness = (set % 3 == 0) ? 1.0e-3f : 1.0f;
+        std::vector<vector3F> points(C_Small_Set_Size);
+        for (vector3F& p : points)
+            p = vector3F(unit(rng), unit(rng), unit(rng) * flatness);
+
+        sphereF minimal;
+        v8::math::sphere_from_points_minimal(&points[0], points.size(),
+                                             sizeof(vector3F), &minimal);
+
+        const double expected = brute_force_minimal_radius(points);
+        const double error = std::fabs(minimal.radius_ - expected) / expected;
+        *worst_error = std::max(*worst_error, error);
+        passed = passed && error <= C_Radius_Tolerance
+            && max_excess(points, minimal) <= C_Enclosure_Tolerance;
+    }
+
+    return passed;
+}
+
+///
+/// \brief  Points at the start of 32 byte vertices.
+struct vertex_pn {
+    vector3F    vt_position;
+    float       vt_padding[5];
+};
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const v8_size_t point_count = argc > 1
+        ? static_cast<v8_size_t>(std::strtoul(argv[1], nullptr, 10)) : 1000000;
+    const int run_count = argc > 2
+        ? static_cast<int>(std::strtoul(argv[2], nullptr, 10)) : 5;
+
+    if (point_count < 1 || run_count < 1) {
+        printf("point count and run count must be at least 1\n");
+        return EXIT_FAILURE;
+    }
+
+    std::mt19937 rng(18);
+    bool passed = true;
+
+    double small_set_error = 0.0;
+    const bool small_sets_passed = check_small_sets(rng, &small_set_error);
+    passed = passed && small_sets_passed;
+    printf("%d sets of %zu points, minimal radius vs brute force : max error %.2e%s\n",
+           C_Small_Set_Count, C_Small_Set_Size, small_set_error,
+           small_sets_passed ? "" : "  MISMATCH");
+
+    printf("%zu points, best of %d runs, radius / ms\n", point_count, run_count);
+    printf("    %-16s %-19s %-19s %-15s %-15s %s\n", "points", "aabb old / new",
+           "average old / new", "ritter", "minimal", "minimal 32B");
+
+    for (int d = 0; d < Distribution_Count; ++d) {
+        const std::vector<vector3F> points =
+            make_points(static_cast<Distribution>(d), point_count, rng);
+        std::vector<vertex_pn> vertices(point_count);
+        for (v8_size_t i = 0; i < point_count; ++i)
+            vertices[i].vt_position = points[i];
+
+        enum {
+            k_aabb_old, k_aabb, k_average_old, k_average, k_ritter, k_minimal,
+            k_minimal_strided, k_method_count
+        };
+        sphereF spheres[k_method_count];
+        double times[k_method_count];
+        std::fill(times, times + k_method_count, 1.0e30);
+
+        const vector3F* pts = &points[0];
+        const size_t stride = sizeof(vector3F);
+        for (int run = 0; run < run_count; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            v8::math::sphere_from_points_by_aabb<float>(
+                pts, point_count, stride, &spheres[k_aabb_old]);
+            times[k_aabb_old] = std::min(times[k_aabb_old], elapsed_ms(start));
+
+            start = std::chrono::steady_clock::now();
+            v8::math::sphere_from_points_by_aabb(pts, point_count, stride, &spheres[k_aabb]);
+            times[k_aabb] = std::min(times[k_aabb], elapsed_ms(start));
+
+            start = std::chrono::steady_clock::now();
+            v8::math::sphere_from_points_by_average<float>(
+                pts, point_count, stride, &spheres[k_average_old]);
+            times[k_average_old] = std::min(times[k_average_old], elapsed_ms(start));
+
+            start = std::chrono::steady_clock::now();
+            v8::math::sphere_from_points_by_average(pts, point_count, stride,
+                                                    &spheres[k_average]);
+            times[k_average] = std::min(times[k_average], elapsed_ms(start));
+
+            start = std::chrono::steady_clock::now();
+            v8::math::sphere_from_points_ritter(pts, point_count, stride,
+                                                &spheres[k_ritter]);
+            times[k_ritter] = std::min(times[k_ritter], elapsed_ms(start));
+
+            start = std::chrono::steady_clock::now();
+            v8::math::sphere_from_points_minimal(pts, point_count, stride,
+                                                 &spheres[k_minimal]);
+            times[k_minimal] = std::min(times[k_minimal], elapsed_ms(start));
+
+            start = std::chrono::steady_clock::now();
+            v8::math::sphere_from_points_minimal(
+                &vertices[0].vt_position, point_count, sizeof(vertex_pn),
+                &spheres[k_minimal_strided]);
+            times[k_minimal_strided] = std::min(times[k_minimal_strided],
+                                                elapsed_ms(start));
+        }
+
+        //
+        // Every sphere must enclose the points; the minimal one must not be
+        // larger than any other, and not depend on the stride.
+        bool distribution_passed = true;
+        const double minimal_radius = spheres[k_minimal].radius_;
+        for (int m = 0; m < k_method_count; ++m) {
+            distribution_passed = distribution_passed
+                && max_excess(points, spheres[m]) <= C_Enclosure_Tolerance
+                && minimal_radius <= spheres[m].radius_ * (1.0 + C_Radius_Tolerance);
+        }
+        distribution_passed = distribution_passed
+            && std::fabs(spheres[k_minimal_strided].radius_ - minimal_radius)
+               <= C_Radius_Tolerance * minimal_radius;
+        passed = passed && distribution_passed;
+
+        printf("    %-16s %6.3f %5.2f / %5.2f  %6.3f %5.2f / %5.2f  %6.3f %6.2f  "
+               "%6.3f %6.2f  %6.2f%s\n",
+               C_Distribution_Names[d],
+               spheres[k_aabb].radius_, times[k_aabb_old], times[k_aabb],
+               spheres[k_average].radius_, times[k_average_old], times[k_average],
+               spheres[k_ritter].radius_, times[k_ritter],
+               spheres[k_minimal].radius_, times[k_minimal],
+               times[k_minimal_strided], distribution_passed ? "" : "  MISMATCH");
+    }
+
+    if (!passed) {
+        printf("    MISMATCH in the enclosure or minimality checks\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,333 @@
+///
+/// \file   color_batch_benchmark.cc
+/// \brief  Converts random colors between Rgb and Hsv, Hls, Xyz and Lab with
+///         convert_colors, and checks the results against the scalar
+///         functions in color.hpp, the job system path against the serial
+///         one and 8 bit round trips through Lab and Hsv. Times the batch
+///         conversions against the scalar functions.
+///         Usage : color_batch_benchmark [color_count] [run_count]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/base/job_system.hpp>
+#include <v8/math/color.hpp>
+#include <v8/math/color_batch.hpp>
+
+namespace {
+
+using v8::math::rgb_color;
+using v8::math::color_hsv;
+using v8::math::color_hls;
+using v8::math::color_xyz;
+using v8::math::color_lab;
+
+//
+// Largest absolute difference allowed against the scalar functions, a bit
+// above the values documented in color_batch.hpp.
+const float C_Max_Hue_Error = 1.0e-4f;
+const float C_Max_Hsv_Hls_Error = 1.0e-6f;
+const float C_Max_Xyz_Error = 1.0e-6f;
+const float C_Max_Lab_Error = 4.0e-6f;
+
+const float C_Undefined_Hue = std::numeric_limits<float>::max();
+
+//
+// Width of the images used for the 8 bit round trips.
+const v8_size_t C_Image_Width = 1024;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+///
+/// \brief  Random colors, one in 16 an opaque gray so that the undefined hue is
+///         exercised as well.
+std::vector<rgb_color> make_colors(v8_size_t count) {
+    std::mt19937 rng(21);
+    std::uniform_real_distribution<float> value(0.0f, 1.0f);
+
+    std::vector<rgb_color> colors(count);
+    for (v8_size_t i = 0; i < count; ++i) {
+        const float red = value(rng);
+        if (i % 16 == 0)
+            colors[i] = rgb_color(red, red, red, 1.0f);
+        else
+            colors[i] = rgb_color(red, value(rng), value(rng), value(rng));
+    }
+    return colors;
+}
+
+///
+/// \brief  Scalar conversion of one color from Rgb to space, and back.
+void scalar_forward(v8::math::Color_Space space, const rgb_color& rgb,
+                    float* out) {
+    switch (space) {
+    case v8::math::Color_Space_Hsv : {
+        color_hsv hsv;
+        v8::math::rgb_to_hsv(&rgb, &hsv);
+        out[0] = hsv.Hue; out[1] = hsv.Saturation; out[2] = hsv.Value;
+    }
+        break;
+
+    case v8::math::Color_Space_Hls : {
+        color_hls hls;
+        v8::math::rgb_to_hls(rgb, &hls);
+        out[0] = hls.Hue; out[1] = hls.Lightness; out[2] = hls.Saturation;
+    }
+        break;
+
+    case v8::math::Color_Space_Xyz : {
+        color_xyz xyz;
+        v8::math::rgb_to_xyz(&rgb, &xyz);
+        out[0] = xyz.X; out[1] = xyz.Y; out[2] = xyz.Z;
+    }
+        break;
+
+    default : {
+        color_lab lab;
+        v8::math::rgb_to_lab(&rgb, &lab);
+        out[0] = lab.L; out[1] = lab.A; out[2] = lab.B;
+    }
+        break;
+    }
+    out[3] = rgb.Alpha;
+}
+
+void scalar_back(v8::math::Color_Space space, const float* in, float* out) {
+    rgb_color rgb;
+    switch (space) {
+    case v8::math::Color_Space_Hsv : {
+        const color_hsv hsv(in[0], in[1], in[2]);
+        v8::math::hsv_to_rgb(&hsv, &rgb);
+    }
+        break;
+
+    case v8::math::Color_Space_Hls :
+        v8::math::hls_to_rgb(color_hls(in[0], in[1], in[2]), &rgb);
+        break;
+
+    case v8::math::Color_Space_Xyz :
+        v8::math::xyz_to_rgb(color_xyz(in[0], in[1], in[2]), &rgb);
+        break;
+
+    default :
+        v8::math::lab_to_rgb(color_lab(in[0], in[1], in[2]), &rgb);
+        break;
+    }
+    out[0] = rgb.Red; out[1] = rgb.Green; out[2] = rgb.Blue; out[3] = in[3];
+}
+
+///
+/// \brief  Largest absolute difference between two buffers of colors. When
+///         has_hue is set, component 0 is a hue in degrees : both values
+///         must agree on it being undefined and the difference is taken
+///         around the circle, into hue_error.
+float max_difference(const float* lhs, const float* rhs, v8_size_t count,
+                     bool has_hue, float* hue_error) {
+    float max_error = 0.0f;
+    for (v8_size_t i = 0; i < count * 4; i += 4) {
+        v8_size_t first = 0;
+        if (has_hue) {
+            first = 1;
+            const bool lhs_undefined = lhs[i] == C_Undefined_Hue;
+            const bool rhs_undefined = rhs[i] == C_Undefined_Hue;
+            if (lhs_undefined != rhs_undefined) {
+                *hue_error = std::numeric_limits<float>::infinity();
+            } else if (!lhs_undefined) {
+                const float diff = std::fabs(lhs[i] - rhs[i]);
+                *hue_error = std::max(*hue_error, std::min(diff, 360.0f - diff));
+            }
+        }
+        for (v8_size_t c = first; c < 4; ++c)
+            max_error = std::max(max_error, std::fabs(lhs[i + c] - rhs[i + c]));
+    }
+    return max_error;
+}
+
+struct space_info {
+    v8::math::Color_Space   space;
+    const char*             name;
+    bool                    has_hue;
+    float                   max_error;
+};
+
+const space_info C_Spaces[] = {
+    { v8::math::Color_Space_Hsv, "Hsv", true, C_Max_Hsv_Hls_Error },
+    { v8::math::Color_Space_Hls, "Hls", true, C_Max_Hsv_Hls_Error },
+    { v8::math::Color_Space_Xyz, "Xyz", false, C_Max_Xyz_Error },
+    { v8::math::Color_Space_Lab, "Lab", false, C_Max_Lab_Error }
+};
+
+bool check_space(const space_info& info, const std::vector<rgb_color>& colors,
+                 v8::base::job_system* jobs) {
+    const v8_size_t count = colors.size();
+    const float* rgb = colors[0].Elements;
+
+    std::vector<float> expected(count * 4);
+    std::vector<float> expected_back(count * 4);
+    for (v8_size_t i = 0; i < count; ++i) {
+        scalar_forward(info.space, colors[i], &expected[i * 4]);
+        scalar_back(info.space, &expected[i * 4], &expected_back[i * 4]);
+    }
+
+    std::vector<float> forward(count * 4);
+    v8::math::convert_colors(v8::math::Color_Space_Rgb, rgb, info.space,
+                             &forward[0], count);
+    //
+    // Back from the scalar results, so both sides start from the same input.
+    std::vector<float> back(count * 4);
+    v8::math::convert_colors(info.space, &expected[0], v8::math::Color_Space_Rgb,
+                             &back[0], count);
+
+    float hue_error = 0.0f;
+    const float forward_error = max_difference(
+        &forward[0], &expected[0], count, info.has_hue, &hue_error);
+    const float back_error = max_difference(
+        &back[0], &expected_back[0], count, false, nullptr);
+
+    std::vector<float> forward_jobs(count * 4);
+    v8::math::convert_colors(v8::math::Color_Space_Rgb, rgb, info.space,
+                             &forward_jobs[0], count, jobs);
+    const bool identical = std::memcmp(&forward[0], &forward_jobs[0],
+                                       count * 4 * sizeof(float)) == 0;
+
+    //
+    // The planar layout goes through the same kernels.
+    std::vector<float> planes(count * 6);
+    for (v8_size_t i = 0; i < count; ++i) {
+        for (v8_size_t c = 0; c < 3; ++c)
+            planes[c * count + i] = rgb[i * 4 + c];
+    }
+    const float* const src_planes[3] = { &planes[0], &planes[count], &planes[count * 2] };
+    float* const dst_planes[3] = { &planes[count * 3], &planes[count * 4], &planes[count * 5] };
+    v8::math::convert_colors_planar(v8::math::Color_Space_Rgb, src_planes,
+                                    info.space, dst_planes, count);
+    bool planar_identical = true;
+    for (v8_size_t i = 0; i < count; ++i) {
+        for (v8_size_t c = 0; c < 3; ++c)
+            planar_identical = planar_identical
+                && dst_planes[c][i] == forward[i * 4 + c];
+    }
+
+    const bool passed = forward_error <= info.max_error
+        && back_error <= info.max_error && hue_error <= C_Max_Hue_Error
+        && identical && planar_identical;
+
+    printf("    Rgb -> %s %.2e   %s -> Rgb %.2e", info.name, forward_error,
+           info.name, back_error);
+    if (info.has_hue)
+        printf("   hue %.2e", hue_error);
+    printf("%s%s%s\n", identical ? "" : ", job system differs",
+           planar_identical ? "" : ", planar differs", passed ? "" : "  MISMATCH");
+    return passed;
+}
+
+///
+/// \brief  rgba8 -> space -> rgba8 must give back every byte.
+bool check_rgba8_round_trip(v8::math::Color_Space space, const char* name,
+                            v8_size_t height, v8::base::job_system* jobs) {
+    std::mt19937 rng(8);
+    std::uniform_int_distribution<int> byte(0, 255);
+
+    const v8_size_t pixel_count = C_Image_Width * height;
+    std::vector<v8_uint8_t> pixels(pixel_count * 4);
+    for (v8_uint8_t& value : pixels)
+        value = static_cast<v8_uint8_t>(byte(rng));
+
+    const v8_size_t float_pitch = C_Image_Width * 4 * sizeof(float);
+    std::vector<float> colors(pixel_count * 4);
+    std::vector<v8_uint8_t> round_trip(pixel_count * 4);
+    v8::math::convert_colors_from_rgba8(&pixels[0], C_Image_Width * 4, space,
+                                        &colors[0], float_pitch,
+                                        C_Image_Width, height, jobs);
+    v8::math::convert_colors_to_rgba8(space, &colors[0], float_pitch,
+                                      &round_trip[0], C_Image_Width * 4,
+                                      C_Image_Width, height, jobs);
+
+    v8_size_t differences = 0;
+    for (v8_size_t i = 0; i < pixels.size(); ++i)
+        differences += pixels[i] != round_trip[i];
+
+    printf("    rgba8 -> %s -> rgba8, %zu pixels   %zu bytes differ%s\n",
+           name, pixel_count, differences, differences ? "  MISMATCH" : "");
+    return differences == 0;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const v8_size_t color_count = argc > 1
+        ? static_cast<v8_size_t>(std::strtoul(argv[1], nullptr, 10)) : 1 << 20;
+    const int run_count = argc > 2
+        ? static_cast<int>(std::strtoul(argv[2], nullptr, 10)) : 5;
+
+    if (color_count < 1 || run_count < 1) {
+        printf("color count and run count must be at least 1\n");
+        return EXIT_FAILURE;
+    }
+
+    v8::base::job_system jobs(3);
+    bool passed = true;
+
+    //
+    // Odd counts exercise the scalar tails, the job check needs more than
+    // one chunk.
+    const v8_size_t check_count = std::max<v8_size_t>(
+        color_count, 3 * v8::math::C_Color_Batch_Grain + 5);
+    printf("max absolute difference against the scalar functions\n");
+    const v8_size_t tail_counts[] = { 1, 3, 7 };
+    for (v8_size_t count : tail_counts) {
+        printf("    %zu colors\n", count);
+        const std::vector<rgb_color> colors = make_colors(count);
+        for (const space_info& info : C_Spaces)
+            passed = check_space(info, colors, nullptr) && passed;
+    }
+    printf("    %zu colors\n", check_count);
+    const std::vector<rgb_color> colors = make_colors(check_count);
+    for (const space_info& info : C_Spaces)
+        passed = check_space(info, colors, &jobs) && passed;
+
+    const v8_size_t image_height = std::max<v8_size_t>(1, color_count / C_Image_Width);
+    passed = check_rgba8_round_trip(v8::math::Color_Space_Lab, "Lab",
+                                    image_height, &jobs) && passed;
+    passed = check_rgba8_round_trip(v8::math::Color_Space_Hsv, "Hsv",
+                                    image_height, nullptr) && passed;
+
+    printf("%zu colors, best of %d runs, ms\n", color_count, run_count);
+    const float* rgb = colors[0].Elements;
+    std::vector<float> dst(color_count * 4);
+    for (const space_info& info : C_Spaces) {
+        double scalar_ms = 1.0e30;
+        double batch_ms = 1.0e30;
+        for (int run = 0; run < run_count; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            for (v8_size_t i = 0; i < color_count; ++i)
+                scalar_forward(info.space, colors[i], &dst[i * 4]);
+            scalar_ms = std::min(scalar_ms, elapsed_ms(start));
+
+            start = std::chrono::steady_clock::now();
+            v8::math::convert_colors(v8::math::Color_Space_Rgb, rgb, info.space,
+                                     &dst[0], color_count);
+            batch_ms = std::min(batch_ms, elapsed_ms(start));
+        }
+        printf("    Rgb -> %s   scalar %8.2f   convert_colors %8.2f\n",
+               info.name, scalar_ms, batch_ms);
+    }
+
+    if (!passed) {
+        printf("    MISMATCH against the scalar color functions\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,336 @@
+///
+/// \file   color_quantizer_benchmark.cc
+/// \brief  Quantizes a noisy gradient image with build_color_palette and
+///         map_colors_to_palette, and checks that the job system gives the
+///         same palette and indices as the serial path, that every palette
+///         slot is used, that k-means lowers the error of the median cut and
+///         that the lookup table stays close to an exact nearest search.
+///         Times the palette, the mapping and the dithering.
+///         Usage : color_quantizer_benchmark [width] [height] [run_count]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/base/job_system.hpp>
+#include <v8/math/color.hpp>
+#include <v8/math/color_quantizer.hpp>
+
+namespace {
+
+using v8::math::rgb_color;
+using v8::math::color_lab;
+
+//
+// The error sums visit one pixel in this many.
+const v8_size_t C_Error_Sample_Step = 13;
+
+//
+// The lookup table may cost this much rms error against an exact nearest
+// entry search.
+const double C_Max_Table_Error_Ratio = 1.05;
+
+//
+// Largest difference, in levels, between the mean of a dithered flat gray
+// and the gray itself.
+const double C_Max_Dither_Mean_Error = 1.0;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+///
+/// \brief  Diagonal gradients of the three channels with noise on top.
+std::vector<v8_uint8_t> make_image(v8_size_t width, v8_size_t height) {
+    std::mt19937 rng(25);
+    std::uniform_int_distribution<int> noise(-12, 12);
+
+    std::vector<v8_uint8_t> pixels(width * height * 4);
+    for (v8_size_t y = 0; y < height; ++y) {
+        for (v8_size_t x = 0; x < width; ++x) {
+            const float u = static_cast<float>(x) / static_cast<float>(width);
+            const float v = static_cast<float>(y) / static_cast<float>(height);
+            const float base[3] = {
+                255.0f * u, 255.0f * v, 255.0f * (1.0f - 0.5f * (u + v))
+            };
+
+            v8_uint8_t* pixel = &pixels[(y * width + x) * 4];
+            for (int c = 0; c < 3; ++c) {
+                const int value = static_cast<int>(base[c]) + noise(rng);
+                pixel[c] = static_cast<v8_uint8_t>(std::min(std::max(value, 0), 255));
+            }
+            pixel[3] = 255;
+        }
+    }
+    return pixels;
+}
+
+color_lab to_lab(const v8_uint8_t* pixel) {
+    const rgb_color rgb(pixel[0] / 255.0f, pixel[1] / 255.0f, pixel[2] / 255.0f);
+    color_lab lab;
+    v8::math::rgb_to_lab(&rgb, &lab);
+    return lab;
+}
+
+double squared_distance(const color_lab& lhs, const color_lab& rhs) {
+    const double dl = lhs.L - rhs.L;
+    const double da = lhs.A - rhs.A;
+    const double db = lhs.B - rhs.B;
+    return dl * dl + da * da + db * db;
+}
+
+///
+/// \brief  L*a*b* rms error of the mapped image and of the exact nearest
+///         palette entries, over one pixel in C_Error_Sample_Step.
+void mapping_error(const std::vector<v8_uint8_t>& pixels,
+                   const std::vector<v8_uint8_t>& indices,
+                   const rgb_color* palette, v8_size_t palette_size,
+                   double* mapped_rms, double* nearest_rms) {
+    std::vector<color_lab> palette_lab(palette_size);
+    for (v8_size_t i = 0; i < palette_size; ++i)
+        v8::math::rgb_to_lab(&palette[i], &palette_lab[i]);
+
+    double mapped_sum = 0.0;
+    double nearest_sum = 0.0;
+    v8_size_t samples = 0;
+    for (v8_size_t i = 0; i < indices.size(); i += C_Error_Sample_Step) {
+        const color_lab lab = to_lab(&pixels[i * 4]);
+        mapped_sum += squared_distance(lab, palette_lab[indices[i]]);
+
+        double nearest = 1.0e30;
+        for (const color_lab& entry : palette_lab)
+            nearest = std::min(nearest, squared_distance(lab, entry));
+        nearest_sum += nearest;
+        ++samples;
+    }
+
+    *mapped_rms = std::sqrt(mapped_sum / samples);
+    *nearest_rms = std::sqrt(nearest_sum / samples);
+}
+
+///
+/// \brief  Serial and threaded runs must agree; the palette must have
+///         max_colors entries.
+bool check_palette_size(const std::vector<v8_uint8_t>& pixels, v8_size_t width,
+                        v8_size_t height, v8_size_t max_colors,
+                        v8::base::job_system* jobs) {
+    rgb_color palette[v8::math::C_Quantizer_Max_Colors];
+    rgb_color palette_jobs[v8::math::C_Quantizer_Max_Colors];
+    std::vector<v8_uint8_t> indices(width * height);
+    std::vector<v8_uint8_t> indices_jobs(width * height);
+
+    bool identical = true;
+    v8_size_t count = 0;
+    const v8::math::Dither_Mode modes[] = {
+        v8::math::Dither_Mode_None, v8::math::Dither_Mode_Floyd_Steinberg
+    };
+    for (v8::math::Dither_Mode mode : modes) {
+        count = v8::math::quantize_colors(&pixels[0], width * 4, width, height,
+                                          max_colors, mode, palette,
+                                          &indices[0], width);
+        const v8_size_t count_jobs = v8::math::quantize_colors(
+            &pixels[0], width * 4, width, height, max_colors, mode,
+            palette_jobs, &indices_jobs[0], width, jobs);
+
+        identical = identical && count == count_jobs
+            && std::memcmp(palette, palette_jobs, count * sizeof(rgb_color)) == 0
+            && indices == indices_jobs;
+    }
+
+    const bool passed = identical && count == max_colors;
+    printf("    %3zu colors   %3zu entries%s%s\n", max_colors, count,
+           identical ? "" : ", job system differs", passed ? "" : "  MISMATCH");
+    return passed;
+}
+
+///
+/// \brief  An image of a few flat colors gets one entry per color, and maps
+///         every pixel to its own color.
+bool check_flat_colors(v8::base::job_system* jobs) {
+    const v8_uint8_t colors[][3] = {
+        { 0, 0, 0 }, { 255, 255, 255 }, { 200, 30, 40 }, { 20, 180, 60 },
+        { 40, 60, 220 }
+    };
+    const v8_size_t color_count = sizeof(colors) / sizeof(colors[0]);
+    const v8_size_t width = 97;
+    const v8_size_t height = 61;
+
+    std::vector<v8_uint8_t> pixels(width * height * 4);
+    for (v8_size_t i = 0; i < width * height; ++i) {
+        std::memcpy(&pixels[i * 4], colors[(i / 7) % color_count], 3);
+        pixels[i * 4 + 3] = 255;
+    }
+
+    rgb_color palette[16];
+    std::vector<v8_uint8_t> indices(width * height);
+    const v8_size_t count = v8::math::quantize_colors(
+        &pixels[0], width * 4, width, height, 16, v8::math::Dither_Mode_None,
+        palette, &indices[0], width, jobs);
+
+    v8_size_t wrong = 0;
+    for (v8_size_t i = 0; i < width * height; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            const float value = palette[indices[i]].Elements[c] * 255.0f;
+            wrong += std::fabs(value - pixels[i * 4 + c]) > 0.5f;
+        }
+    }
+
+    const bool passed = count == color_count && wrong == 0;
+    printf("    %zu flat colors   %zu entries, %zu components off%s\n",
+           color_count, count, wrong, passed ? "" : "  MISMATCH");
+    return passed;
+}
+
+///
+/// \brief  Dithered flat grays keep their mean. The palette is built from a
+///         gray ramp, so every gray between its darkest and lightest entry
+///         can be reached.
+bool check_dither_mean(v8::base::job_system* jobs) {
+    const v8_size_t width = 256;
+    const v8_size_t height = 256;
+
+    std::vector<v8_uint8_t> pixels(width * height * 4);
+    for (v8_size_t i = 0; i < width * height; ++i) {
+        std::memset(&pixels[i * 4], static_cast<int>(i % width), 3);
+        pixels[i * 4 + 3] = 255;
+    }
+
+    rgb_color palette[8];
+    const v8_size_t palette_size = v8::math::build_color_palette(
+        &pixels[0], width * 4, width, height, 8, palette,
+        v8::math::C_Quantizer_Refine_Passes, jobs);
+
+    const int grays[] = { 37, 101, 190 };
+    double max_error = 0.0;
+    std::vector<v8_uint8_t> indices(width * height);
+    for (int gray : grays) {
+        for (v8_size_t i = 0; i < width * height; ++i)
+            std::memset(&pixels[i * 4], gray, 3);
+
+        v8::math::map_colors_to_palette(&pixels[0], width * 4, width, height,
+                                        palette, palette_size,
+                                        v8::math::Dither_Mode_Floyd_Steinberg,
+                                        &indices[0], width, jobs);
+
+        for (int c = 0; c < 3; ++c) {
+            double sum = 0.0;
+            for (v8_uint8_t index : indices)
+                sum += palette[index].Elements[c] * 255.0;
+            max_error = std::max(max_error, std::fabs(sum / indices.size() - gray));
+        }
+    }
+
+    const bool passed = max_error <= C_Max_Dither_Mean_Error;
+    printf("    dithered flat grays, %zu colors   mean off by %.3f levels%s\n",
+           palette_size, max_error, passed ? "" : "  MISMATCH");
+    return passed;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const v8_size_t width = argc > 1
+        ? static_cast<v8_size_t>(std::strtoul(argv[1], nullptr, 10)) : 3840;
+    const v8_size_t height = argc > 2
+        ? static_cast<v8_size_t>(std::strtoul(argv[2], nullptr, 10)) : 2160;
+    const int run_count = argc > 3
+        ? static_cast<int>(std::strtoul(argv[3], nullptr, 10)) : 3;
+
+    //
+    // The image must hold more histogram bins than the largest palette.
+    if (width < 64 || height < 64 || run_count < 1) {
+        printf("width and height must be at least 64, run count at least 1\n");
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<v8_uint8_t> pixels = make_image(width, height);
+    v8::base::job_system jobs(3);
+    bool passed = true;
+
+    printf("palette sizes, serial against the job system\n");
+    const v8_size_t small_width = std::min<v8_size_t>(width, 517);
+    const v8_size_t small_height = std::min<v8_size_t>(height, 301);
+    const std::vector<v8_uint8_t> small_pixels = make_image(small_width, small_height);
+    const v8_size_t sizes[] = { 2, 5, 16, 63, 128, 249, 256 };
+    for (v8_size_t size : sizes) {
+        passed = check_palette_size(small_pixels, small_width, small_height,
+                                    size, &jobs) && passed;
+    }
+    passed = check_flat_colors(&jobs) && passed;
+
+    printf("%zux%zu, 256 colors, L*a*b* rms error\n", width, height);
+    rgb_color seeded[v8::math::C_Quantizer_Max_Colors];
+    rgb_color palette[v8::math::C_Quantizer_Max_Colors];
+    const v8_size_t seeded_size = v8::math::build_color_palette(
+        &pixels[0], width * 4, width, height, 256, seeded, 0, &jobs);
+    const v8_size_t palette_size = v8::math::build_color_palette(
+        &pixels[0], width * 4, width, height, 256, palette,
+        v8::math::C_Quantizer_Refine_Passes, &jobs);
+
+    std::vector<v8_uint8_t> indices(width * height);
+    double seeded_rms = 0.0;
+    double palette_rms = 0.0;
+    double nearest_rms = 0.0;
+    v8::math::map_colors_to_palette(&pixels[0], width * 4, width, height, seeded,
+                                    seeded_size, v8::math::Dither_Mode_None,
+                                    &indices[0], width, &jobs);
+    mapping_error(pixels, indices, seeded, seeded_size, &seeded_rms, &nearest_rms);
+    v8::math::map_colors_to_palette(&pixels[0], width * 4, width, height, palette,
+                                    palette_size, v8::math::Dither_Mode_None,
+                                    &indices[0], width, &jobs);
+    mapping_error(pixels, indices, palette, palette_size, &palette_rms, &nearest_rms);
+
+    const bool refined = palette_rms <= seeded_rms;
+    const bool table_close = palette_rms <= nearest_rms * C_Max_Table_Error_Ratio;
+    passed = passed && refined && table_close;
+    printf("    median cut %.4f   k-means %.4f%s\n", seeded_rms, palette_rms,
+           refined ? "" : "  MISMATCH");
+    printf("    lookup table %.4f   exact nearest %.4f   +%.1f%%%s\n",
+           palette_rms, nearest_rms, 100.0 * (palette_rms / nearest_rms - 1.0),
+           table_close ? "" : "  MISMATCH");
+
+    passed = check_dither_mean(&jobs) && passed;
+
+    double palette_ms = 1.0e30;
+    double map_ms = 1.0e30;
+    double dither_ms = 1.0e30;
+    for (int run = 0; run < run_count; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        v8::math::build_color_palette(&pixels[0], width * 4, width, height, 256,
+                                      palette);
+        palette_ms = std::min(palette_ms, elapsed_ms(start));
+
+        start = std::chrono::steady_clock::now();
+        v8::math::map_colors_to_palette(&pixels[0], width * 4, width, height,
+                                        palette, palette_size,
+                                        v8::math::Dither_Mode_None,
+                                        &indices[0], width);
+        map_ms = std::min(map_ms, elapsed_ms(start));
+
+        start = std::chrono::steady_clock::now();
+        v8::math::map_colors_to_palette(&pixels[0], width * 4, width, height,
+                                        palette, palette_size,
+                                        v8::math::Dither_Mode_Floyd_Steinberg,
+                                        &indices[0], width);
+        dither_ms = std::min(dither_ms, elapsed_ms(start));
+    }
+
+    printf("%zux%zu, 256 colors, best of %d runs, ms\n", width, height, run_count);
+    printf("    build_color_palette      %8.2f\n", palette_ms);
+    printf("    map_colors_to_palette    %8.2f\n", map_ms);
+    printf("      Floyd-Steinberg        %8.2f\n", dither_ms);
+
+    if (!passed) {
+        printf("    MISMATCH in the quantized results\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
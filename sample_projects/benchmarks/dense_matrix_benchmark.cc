@@ -0,0 +1,244 @@
+///
+/// \file   dense_matrix_benchmark.cc
+/// \brief  Multiplies matrix_NxM<float> matrices and vectors, and evaluates
+///         an element wise expression, checking the results against a
+///         double precision reference (odd shapes included) and the job
+///         system path against the serial one. Times the blocked products
+///         against the naive triple loop and the expression against a hand
+///         written loop.
+///         Usage : dense_matrix_benchmark [max_size] [run_count]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/base/job_system.hpp>
+#include <v8/math/matrix_NxM.hpp>
+#include <v8/math/vector_N.hpp>
+
+namespace {
+
+typedef v8::math::matrix_NxM<float> matrixF;
+typedef v8::math::vector_N<float>   vectorF;
+
+//
+// Relative to sum(|a_ik| * |b_kj|), the bound for a float dot product of
+// a few thousand terms.
+const double C_Max_Relative_Error = 1.0e-5;
+
+//
+// The naive product is only timed up to this size, it takes seconds above.
+const size_t C_Max_Naive_Size = 512;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+matrixF random_matrix(size_t rows, size_t columns, std::mt19937& rng) {
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    matrixF mtx(rows, columns);
+    float* data = mtx.get_data();
+    for (size_t i = 0; i < rows * columns; ++i)
+        data[i] = value(rng);
+    return mtx;
+}
+
+vectorF random_vector(size_t dimension, std::mt19937& rng) {
+    std::uniform_real_distribution<float> value(-1.0f, 1.0f);
+    vectorF vec(dimension);
+    for (size_t i = 0; i < dimension; ++i)
+        vec.get_data()[i] = value(rng);
+    return vec;
+}
+
+///
+/// \brief  The product as it was computed before the blocked kernels : one
+///         dot product per element, walking down the columns of b.
+void naive_product(const float* a, const float* b, float* c,
+                   size_t rows, size_t inner, size_t columns) {
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < columns; ++j) {
+            float sum = 0.0f;
+            for (size_t k = 0; k < inner; ++k)
+                sum += a[i * inner + k] * b[k * columns + j];
+            c[i * columns + j] = sum;
+        }
+    }
+}
+
+///
+/// \brief  Largest error of c = a * b relative to sum(|a_ik| * |b_kj|),
+///         with the reference accumulated in double precision.
+double product_error(const float* a, const float* b, const float* c,
+                     size_t rows, size_t inner, size_t columns) {
+    double max_error = 0.0;
+    for (size_t i = 0; i < rows; ++i) {
+        for (size_t j = 0; j < columns; ++j) {
+            double sum = 0.0;
+            double magnitude = 0.0;
+            for (size_t k = 0; k < inner; ++k) {
+                const double term = double(a[i * inner + k]) * b[k * columns + j];
+                sum += term;
+                magnitude += std::fabs(term);
+            }
+            if (magnitude > 0.0) {
+                max_error = std::max(
+                    max_error, std::fabs(c[i * columns + j] - sum) / magnitude);
+            }
+        }
+    }
+    return max_error;
+}
+
+bool check_shape(size_t rows, size_t inner, size_t columns,
+                 v8::base::job_system* jobs, std::mt19937& rng) {
+    const matrixF a = random_matrix(rows, inner, rng);
+    const matrixF b = random_matrix(inner, columns, rng);
+    const vectorF x = random_vector(inner, rng);
+
+    matrixF c;
+    v8::math::matrix_product(a, b, &c);
+    vectorF y(rows);
+    v8::math::matrix_vector_product(a, x, &y);
+
+    const double gemm_error = product_error(
+        a.get_data(), b.get_data(), c.get_data(), rows, inner, columns);
+    const double gemv_error = product_error(
+        a.get_data(), x.get_data(), y.get_data(), rows, inner, 1);
+
+    matrixF c_jobs;
+    v8::math::matrix_product(a, b, &c_jobs, jobs);
+    vectorF y_jobs(rows);
+    v8::math::matrix_vector_product(a, x, &y_jobs, jobs);
+
+    const bool identical =
+        std::memcmp(c.get_data(), c_jobs.get_data(), rows * columns * sizeof(float)) == 0
+        && std::memcmp(y.get_data(), y_jobs.get_data(), rows * sizeof(float)) == 0;
+
+    const bool passed = gemm_error <= C_Max_Relative_Error
+        && gemv_error <= C_Max_Relative_Error && identical;
+
+    printf("    %4zu x %4zu x %4zu   gemm error %.2e, gemv error %.2e%s%s\n",
+           rows, inner, columns, gemm_error, gemv_error,
+           identical ? "" : ", job system differs",
+           passed ? "" : "  MISMATCH");
+    return passed;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const size_t max_size = argc > 1
+        ? static_cast<size_t>(std::strtoul(argv[1], nullptr, 10)) : 1024;
+    const int run_count = argc > 2
+        ? static_cast<int>(std::strtoul(argv[2], nullptr, 10)) : 5;
+
+    if (max_size < 4 || run_count < 1) {
+        printf("max size must be at least 4, run count at least 1\n");
+        return EXIT_FAILURE;
+    }
+
+    std::mt19937 rng(15);
+    v8::base::job_system jobs(3);
+    bool passed = true;
+
+    printf("accuracy against a double precision reference\n");
+    const size_t shapes[][3] = {
+        { 1, 1, 1 }, { 3, 5, 7 }, { 37, 91, 53 }, { 129, 257, 65 },
+        { 300, 200, 500 }, { max_size, max_size, max_size }
+    };
+    for (const size_t (&shape)[3] : shapes)
+        passed = check_shape(shape[0], shape[1], shape[2], &jobs, rng) && passed;
+
+    printf("gemm / gemv, best of %d runs\n", run_count);
+    for (size_t n = 64; n <= max_size; n *= 4) {
+        const matrixF a = random_matrix(n, n, rng);
+        const matrixF b = random_matrix(n, n, rng);
+        const vectorF x = random_vector(n, rng);
+        matrixF c;
+        vectorF y(n);
+        std::vector<float> naive(n * n);
+
+        double gemm_ms = 1.0e30;
+        double gemv_ms = 1.0e30;
+        double naive_gemm_ms = 1.0e30;
+        double naive_gemv_ms = 1.0e30;
+        for (int run = 0; run < run_count; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            v8::math::matrix_product(a, b, &c);
+            gemm_ms = std::min(gemm_ms, elapsed_ms(start));
+
+            start = std::chrono::steady_clock::now();
+            v8::math::matrix_vector_product(a, x, &y);
+            gemv_ms = std::min(gemv_ms, elapsed_ms(start));
+
+            start = std::chrono::steady_clock::now();
+            naive_product(a.get_data(), x.get_data(), &naive[0], n, n, 1);
+            naive_gemv_ms = std::min(naive_gemv_ms, elapsed_ms(start));
+
+            if (n <= C_Max_Naive_Size) {
+                start = std::chrono::steady_clock::now();
+                naive_product(a.get_data(), b.get_data(), &naive[0], n, n, n);
+                naive_gemm_ms = std::min(naive_gemm_ms, elapsed_ms(start));
+            }
+        }
+
+        const double gflops = 2.0 * n * n * n / (gemm_ms * 1.0e6);
+        if (n <= C_Max_Naive_Size) {
+            printf("    gemm %4zu   naive %10.3f ms   blocked %9.3f ms  %6.2f GFLOPS\n",
+                   n, naive_gemm_ms, gemm_ms, gflops);
+        } else {
+            printf("    gemm %4zu   naive          -      blocked %9.3f ms  %6.2f GFLOPS\n",
+                   n, gemm_ms, gflops);
+        }
+        printf("    gemv %4zu   naive %10.3f ms   blocked %9.3f ms\n",
+               n, naive_gemv_ms, gemv_ms);
+    }
+
+    //
+    // D = A + B * 2 - C, as an expression and as a hand written loop.
+    {
+        const size_t n = max_size;
+        const matrixF a = random_matrix(n, n, rng);
+        const matrixF b = random_matrix(n, n, rng);
+        const matrixF c = random_matrix(n, n, rng);
+        matrixF d(n, n);
+        std::vector<float> expected(n * n);
+
+        double expr_ms = 1.0e30;
+        double loop_ms = 1.0e30;
+        for (int run = 0; run < run_count; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            d = a + b * 2.0f - c;
+            expr_ms = std::min(expr_ms, elapsed_ms(start));
+
+            start = std::chrono::steady_clock::now();
+            const float* pa = a.get_data();
+            const float* pb = b.get_data();
+            const float* pc = c.get_data();
+            for (size_t i = 0; i < n * n; ++i)
+                expected[i] = pa[i] + pb[i] * 2.0f - pc[i];
+            loop_ms = std::min(loop_ms, elapsed_ms(start));
+        }
+
+        const bool identical =
+            std::memcmp(d.get_data(), &expected[0], n * n * sizeof(float)) == 0;
+        passed = passed && identical;
+        printf("    D = A + B * 2 - C, %zu^2   loop %8.3f ms   expression %8.3f ms%s\n",
+               n, loop_ms, expr_ms, identical ? "" : "  MISMATCH");
+    }
+
+    if (!passed) {
+        printf("    MISMATCH against the reference results\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,218 @@
+///
+/// \file   fractal_cpu_benchmark.cc
+/// \brief  Renders Julia and Mandelbrot views with fractal_cpu_renderer and
+///         checks the smooth iteration counts against a plain scalar escape
+///         time loop, the job system path against the serial one and
+///         render() against compute_iterations() + colorize(). Times the
+///         renderer against the scalar loop.
+///         Usage : fractal_cpu_benchmark [width] [height] [run_count]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/base/array_proxy.hpp>
+#include <v8/base/job_system.hpp>
+#include <v8/math/color.hpp>
+
+#include "../julia_fractal/fractal_cpu_renderer.hpp"
+
+namespace {
+
+//
+// Size of the images checked against the scalar loop.
+const v8_int32_t C_Check_Width = 200;
+const v8_int32_t C_Check_Height = 150;
+
+//
+// Largest difference allowed between smooth iteration counts; the renderer
+// takes log2 with a polynomial approximation.
+const float C_Max_Smooth_Error = 1.0e-4f;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+fractal_params_t make_params(bool mandelbrot, v8_int32_t width, v8_int32_t height,
+                             v8_int32_t max_iterations) {
+    fractal_params_t params;
+    params.is_mandelbrot = mandelbrot;
+    params.use_color_table = false;
+    params.width = width;
+    params.height = height;
+    params.max_iterations = max_iterations;
+    params.zoom_factor = 1.0f;
+    params.offset_x = mandelbrot ? -0.5f : 0.0f;
+    params.offset_y = 0.0f;
+    params.C_real = -0.835f;
+    params.C_imag = -0.2321f;
+    params.C_origin = v8::math::vector2<v8_int_t>(0, 0);
+    return params;
+}
+
+///
+/// \brief  The escape time loop of the ps_julia shader, one point at a time,
+///         without the cardioid and cycle shortcuts.
+void scalar_iterations(const fractal_params_t& params, float* values) {
+    const float width = static_cast<float>(params.width);
+    const float height = static_cast<float>(params.height);
+    const float scale_x = 1.5f / (0.5f * params.zoom_factor * width);
+    const float scale_y = 1.0f / (0.5f * params.zoom_factor * height);
+    const float origin_x = params.offset_x - 0.5f * width * scale_x;
+    const float origin_y = params.offset_y - 0.5f * height * scale_y;
+    const float bailout = fractal_cpu_renderer::C_Bailout_Radius
+        * fractal_cpu_renderer::C_Bailout_Radius;
+
+    for (v8_int32_t y = 0; y < params.height; ++y) {
+        for (v8_int32_t x = 0; x < params.width; ++x) {
+            const float px = origin_x + static_cast<float>(x) * scale_x;
+            const float py = origin_y + static_cast<float>(y) * scale_y;
+
+            float zr = params.is_mandelbrot ? 0.0f : px;
+            float zi = params.is_mandelbrot ? 0.0f : py;
+            const float cr = params.is_mandelbrot ? px : params.C_real;
+            const float ci = params.is_mandelbrot ? py : params.C_imag;
+
+            v8_int32_t count = 0;
+            while (count < params.max_iterations && zr * zr + zi * zi <= bailout) {
+                const float new_zi = (zr + zr) * zi + ci;
+                zr = zr * zr - zi * zi + cr;
+                zi = new_zi;
+                ++count;
+            }
+
+            const float magnitude = zr * zr + zi * zi;
+            float mu = fractal_cpu_renderer::C_Inside;
+            if (magnitude > bailout) {
+                mu = std::max(static_cast<float>(count) + 1.0f
+                              - std::log2(0.5f * std::log2(magnitude)), 0.0f);
+            }
+            values[y * params.width + x] = mu;
+        }
+    }
+}
+
+bool check_view(const fractal_cpu_renderer& renderer, const char* name,
+                const fractal_params_t& params, v8::base::job_system* jobs) {
+    const v8_size_t pixel_count = params.width * params.height;
+    std::vector<float> expected(pixel_count);
+    scalar_iterations(params, &expected[0]);
+
+    std::vector<float> values(pixel_count);
+    renderer.compute_iterations(params, 0, 0, params.width, params.height,
+                                &values[0], params.width);
+
+    v8_size_t misclassified = 0;
+    float max_error = 0.0f;
+    for (v8_size_t i = 0; i < pixel_count; ++i) {
+        const bool inside = values[i] == fractal_cpu_renderer::C_Inside;
+        if (inside != (expected[i] == fractal_cpu_renderer::C_Inside))
+            ++misclassified;
+        else if (!inside)
+            max_error = std::max(max_error, std::fabs(values[i] - expected[i]));
+    }
+
+    std::vector<float> values_jobs(pixel_count);
+    renderer.compute_iterations(params, 0, 0, params.width, params.height,
+                                &values_jobs[0], params.width, jobs);
+    const bool identical = std::memcmp(&values[0], &values_jobs[0],
+                                       pixel_count * sizeof(float)) == 0;
+
+    const v8_size_t pitch = params.width * 4;
+    std::vector<v8_uint8_t> colorized(pixel_count * 4);
+    std::vector<v8_uint8_t> rendered(pixel_count * 4);
+    renderer.colorize(params, &values[0], params.width, &colorized[0], pitch);
+    renderer.render(params, &rendered[0], pitch, jobs);
+    const bool same_pixels = colorized == rendered;
+
+    const bool passed = misclassified == 0 && max_error <= C_Max_Smooth_Error
+        && identical && same_pixels;
+    printf("    %-10s %5d iterations   misclassified %zu, smooth error %.2e%s%s%s\n",
+           name, params.max_iterations, misclassified, max_error,
+           identical ? "" : ", job system differs",
+           same_pixels ? "" : ", render differs from colorize",
+           passed ? "" : "  MISMATCH");
+    return passed;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const v8_int32_t width = argc > 1
+        ? static_cast<v8_int32_t>(std::strtoul(argv[1], nullptr, 10)) : 1920;
+    const v8_int32_t height = argc > 2
+        ? static_cast<v8_int32_t>(std::strtoul(argv[2], nullptr, 10)) : 1080;
+    const int run_count = argc > 3
+        ? static_cast<int>(std::strtoul(argv[3], nullptr, 10)) : 3;
+
+    if (width < 1 || height < 1 || run_count < 1) {
+        printf("width, height and run count must be at least 1\n");
+        return EXIT_FAILURE;
+    }
+
+    fractal_cpu_renderer renderer;
+    std::vector<v8::math::rgb_color> palette(128);
+    v8::base::array_proxy<v8::math::rgb_color> palette_proxy(
+        &palette[0], &palette[0] + palette.size());
+    make_fractal_color_table(palette_proxy);
+    renderer.set_color_table(&palette[0], palette.size());
+
+    v8::base::job_system jobs(3);
+    bool passed = true;
+
+    printf("%dx%d views against the scalar escape time loop\n",
+           C_Check_Width, C_Check_Height);
+    const v8_int32_t check_iterations[] = { 64, 256, 1024 };
+    for (v8_int32_t iterations : check_iterations) {
+        passed = check_view(renderer, "Julia",
+                            make_params(false, C_Check_Width, C_Check_Height,
+                                        iterations), &jobs) && passed;
+        passed = check_view(renderer, "Mandelbrot",
+                            make_params(true, C_Check_Width, C_Check_Height,
+                                        iterations), &jobs) && passed;
+    }
+
+    printf("%dx%d, render best of %d runs, Mpixel/s\n", width, height, run_count);
+    const v8_size_t pixel_count = static_cast<v8_size_t>(width) * height;
+    std::vector<float> values(pixel_count);
+    std::vector<v8_uint8_t> pixels(pixel_count * 4);
+    const v8_int32_t time_iterations[] = { 256, 4096 };
+    for (int mandelbrot = 0; mandelbrot < 2; ++mandelbrot) {
+        for (v8_int32_t iterations : time_iterations) {
+            fractal_params_t params = make_params(mandelbrot != 0, width, height,
+                                                  iterations);
+            params.use_color_table = true;
+
+            //
+            // The scalar loop runs once, deep Mandelbrot views take seconds.
+            auto start = std::chrono::steady_clock::now();
+            scalar_iterations(params, &values[0]);
+            const double scalar_ms = elapsed_ms(start);
+
+            double render_ms = 1.0e30;
+            for (int run = 0; run < run_count; ++run) {
+                start = std::chrono::steady_clock::now();
+                renderer.render(params, &pixels[0], width * 4);
+                render_ms = std::min(render_ms, elapsed_ms(start));
+            }
+
+            printf("    %-10s %5d iterations   scalar loop %7.2f   render %7.2f\n",
+                   mandelbrot ? "Mandelbrot" : "Julia", iterations,
+                   pixel_count / (scalar_ms * 1000.0),
+                   pixel_count / (render_ms * 1000.0));
+        }
+    }
+
+    if (!passed) {
+        printf("    MISMATCH against the scalar escape time loop\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+///
+/// \file   geosphere_benchmark.cc
+/// \brief  Builds geospheres for every subdivision level up to the given
+///         one, with both create_geosphere() overloads. Checks the vertex
+///         and index counts (10 * 4^n + 2 and 60 * 4^n), that every vertex
+///         lies on the sphere with its normal pointing outwards, and that
+///         the mesh is closed (every edge shared by exactly two triangles,
+///         in opposite directions), with every triangle facing outwards.
+///         Usage : geosphere_benchmark [max_subdivisions] [run_count]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/math/geometry_generators.hpp>
+#include <v8/math/vector3.hpp>
+
+namespace {
+
+using v8::math::vector3F;
+using v8::math::geometry_gen::mesh_data_t;
+using v8::math::geometry_gen::mesh_streams_data_t;
+
+const float C_Radius = 2.5f;
+const float C_Tolerance = 1.0e-5f;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+bool check_vertex(const vector3F& position, const vector3F& normal) {
+    const float length = std::sqrt(position.length_squared());
+    if (std::fabs(length - C_Radius) > C_Tolerance * C_Radius)
+        return false;
+
+    const vector3F expected_normal = position / length;
+    return (expected_normal - normal).length_squared()
+        <= C_Tolerance * C_Tolerance;
+}
+
+///
+/// \brief  Every directed edge (a, b) must appear once, and its twin (b, a)
+///         once, so the sorted list of directed edges has no duplicates and
+///         each edge has a twin. Triangles must all face outwards.
+bool check_topology(const vector3F* positions, v8_size_t vertex_count,
+                    const std::vector<uint32_t>& indices) {
+    std::vector<v8_uint64_t> edges;
+    edges.reserve(indices.size());
+
+    for (v8_size_t tri = 0; tri < indices.size(); tri += 3) {
+        const uint32_t v[3] = { indices[tri], indices[tri + 1], indices[tri + 2] };
+        if (v[0] >= vertex_count || v[1] >= vertex_count || v[2] >= vertex_count)
+            return false;
+
+        const vector3F& p0 = positions[v[0]];
+        const vector3F face_normal = cross_product(
+            positions[v[1]] - p0, positions[v[2]] - p0);
+        if (dot_product(face_normal, p0) <= 0.0f)
+            return false;
+
+        for (int e = 0; e < 3; ++e) {
+            edges.push_back((static_cast<v8_uint64_t>(v[e]) << 32) | v[(e + 1) % 3]);
+        }
+    }
+
+    std::sort(edges.begin(), edges.end());
+    if (std::adjacent_find(edges.begin(), edges.end()) != edges.end())
+        return false;
+
+    for (v8_size_t i = 0; i < edges.size(); ++i) {
+        const v8_uint64_t twin = (edges[i] << 32) | (edges[i] >> 32);
+        if (!std::binary_search(edges.begin(), edges.end(), twin))
+            return false;
+    }
+
+    return true;
+}
+
+bool check_mesh(const mesh_data_t& mesh, v8_size_t level) {
+    const v8_size_t tris = static_cast<v8_size_t>(20) << (2 * level);
+    if (mesh.md_vertices.size() != tris / 2 + 2 || mesh.md_indices.size() != tris * 3)
+        return false;
+
+    std::vector<vector3F> positions(mesh.md_vertices.size());
+    for (v8_size_t i = 0; i < mesh.md_vertices.size(); ++i) {
+        if (!check_vertex(mesh.md_vertices[i].vt_position, mesh.md_vertices[i].vt_normal))
+            return false;
+        positions[i] = mesh.md_vertices[i].vt_position;
+    }
+
+    return check_topology(&positions[0], positions.size(), mesh.md_indices);
+}
+
+bool check_streams(const mesh_streams_data_t& mesh, const mesh_data_t& reference) {
+    const v8_size_t vertex_count = mesh.msd_vertices.get_vertex_count();
+    if (vertex_count != reference.md_vertices.size()
+        || mesh.msd_indices != reference.md_indices)
+        return false;
+
+    const vector3F* positions = mesh.msd_vertices.positions();
+    const vector3F* normals = mesh.msd_vertices.normals();
+    for (v8_size_t i = 0; i < vertex_count; ++i) {
+        if (positions[i] != reference.md_vertices[i].vt_position
+            || normals[i] != reference.md_vertices[i].vt_normal)
+            return false;
+    }
+
+    return true;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const v8_size_t max_level = argc > 1
+        ? static_cast<v8_size_t>(std::strtoul(argv[1], nullptr, 10)) : 8;
+    const int run_count = argc > 2
+        ? static_cast<int>(std::strtoul(argv[2], nullptr, 10)) : 5;
+
+    if (max_level > v8::math::geometry_gen::C_Max_Geosphere_Subdivisions
+        || run_count < 1) {
+        printf("max subdivisions must be at most %zu, run count at least 1\n",
+               v8::math::geometry_gen::C_Max_Geosphere_Subdivisions);
+        return EXIT_FAILURE;
+    }
+
+    printf("radius %.2f, best of %d runs\n", C_Radius, run_count);
+    printf("    level   vertices    triangles  mesh_data ms  streams ms\n");
+
+    bool passed = true;
+    for (v8_size_t level = 0; level <= max_level; ++level) {
+        mesh_data_t mesh;
+        double mesh_ms = 1.0e30;
+        double streams_ms = 1.0e30;
+
+        for (int run = 0; run < run_count; ++run) {
+            mesh = mesh_data_t();
+            auto start = std::chrono::steady_clock::now();
+            v8::math::geometry_gen::create_geosphere(C_Radius, level, &mesh);
+            mesh_ms = std::min(mesh_ms, elapsed_ms(start));
+
+            mesh_streams_data_t run_streams;
+            start = std::chrono::steady_clock::now();
+            v8::math::geometry_gen::create_geosphere(C_Radius, level, &run_streams);
+            streams_ms = std::min(streams_ms, elapsed_ms(start));
+        }
+
+        mesh_streams_data_t streams;
+        v8::math::geometry_gen::create_geosphere(C_Radius, level, &streams);
+
+        const bool level_passed = check_mesh(mesh, level)
+            && check_streams(streams, mesh);
+        passed = passed && level_passed;
+
+        printf("    %5zu %10zu %12zu %13.3f %11.3f%s\n",
+               level, mesh.md_vertices.size(), mesh.md_indices.size() / 3,
+               mesh_ms, streams_ms, level_passed ? "" : "  MISMATCH");
+    }
+
+    if (!passed) {
+        printf("    MISMATCH in the geosphere counts, vertices or topology\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,232 @@
+///
+/// \file   ifs_load_benchmark.cc
+/// \brief  Writes a flat grid mesh as an IFS file, loads it with ifs_loader
+///         (serial and with a job system) and times the load against
+///         reading the file with fread() and copying the blocks out.
+///         Usage : ifs_load_benchmark [grid_size] [file_name]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/base/job_system.hpp>
+#include <v8/utility/ifs_loader.hpp>
+
+namespace {
+
+const int C_Load_Runs = 5;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+void append_bytes(std::vector<v8_uint8_t>* buff, const void* src,
+                  v8_size_t bytes) {
+    const v8_uint8_t* first = static_cast<const v8_uint8_t*>(src);
+    buff->insert(buff->end(), first, first + bytes);
+}
+
+void append_string(std::vector<v8_uint8_t>* buff, const char* str) {
+    const v8_uint32_t len = static_cast<v8_uint32_t>(strlen(str) + 1);
+    append_bytes(buff, &len, sizeof(len));
+    append_bytes(buff, str, len);
+}
+
+///
+/// \brief  Grid of grid_size x grid_size vertices in the z = 0 plane, two
+///         triangles per cell.
+void make_grid(v8_uint32_t grid_size, std::vector<float>* positions,
+               std::vector<v8_uint32_t>* indices) {
+    positions->clear();
+    indices->clear();
+
+    for (v8_uint32_t y = 0; y < grid_size; ++y) {
+        for (v8_uint32_t x = 0; x < grid_size; ++x) {
+            positions->push_back(static_cast<float>(x));
+            positions->push_back(static_cast<float>(y));
+            positions->push_back(0.0f);
+        }
+    }
+
+    for (v8_uint32_t y = 0; y + 1 < grid_size; ++y) {
+        for (v8_uint32_t x = 0; x + 1 < grid_size; ++x) {
+            const v8_uint32_t v0 = y * grid_size + x;
+            const v8_uint32_t quad[] = {
+                v0, v0 + 1, v0 + grid_size,
+                v0 + 1, v0 + grid_size + 1, v0 + grid_size
+            };
+            indices->insert(indices->end(), quad, quad + 6);
+        }
+    }
+}
+
+bool write_ifs_file(const char* file_name,
+                    const std::vector<float>& positions,
+                    const std::vector<v8_uint32_t>& indices) {
+    std::vector<v8_uint8_t> buff;
+    const float version = 1.0f;
+    const v8_uint32_t num_vertices =
+        static_cast<v8_uint32_t>(positions.size() / 3);
+    const v8_uint32_t num_faces = static_cast<v8_uint32_t>(indices.size() / 3);
+
+    append_string(&buff, "IFS");
+    append_bytes(&buff, &version, sizeof(version));
+    append_string(&buff, "grid");
+    append_string(&buff, "VERTICES");
+    append_bytes(&buff, &num_vertices, sizeof(num_vertices));
+    append_bytes(&buff, &positions[0], positions.size() * sizeof(float));
+    append_string(&buff, "TRIANGLES");
+    append_bytes(&buff, &num_faces, sizeof(num_faces));
+    append_bytes(&buff, &indices[0], indices.size() * sizeof(v8_uint32_t));
+
+    FILE* fp = fopen(file_name, "wb");
+    if (!fp)
+        return false;
+
+    const bool written = fwrite(&buff[0], 1, buff.size(), fp) == buff.size();
+    return (fclose(fp) == 0) && written;
+}
+
+///
+/// \brief  Reference : the whole file read with fread() and the two blocks
+///         copied out at the offsets the writer used.
+bool read_reference(const char* file_name, v8_size_t vertex_offset,
+                    std::vector<float>* positions,
+                    std::vector<v8_uint32_t>* indices) {
+    FILE* fp = fopen(file_name, "rb");
+    if (!fp)
+        return false;
+
+    std::vector<v8_uint8_t> buff;
+    v8_uint8_t chunk[1 << 16];
+    v8_size_t bytes_read;
+    while ((bytes_read = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+        buff.insert(buff.end(), chunk, chunk + bytes_read);
+    fclose(fp);
+
+    const v8_size_t face_offset = vertex_offset
+        + positions->size() * sizeof(float) + sizeof(v8_uint32_t)
+        + sizeof("TRIANGLES") + sizeof(v8_uint32_t);
+    if (buff.size() < face_offset + indices->size() * sizeof(v8_uint32_t))
+        return false;
+
+    memcpy(&(*positions)[0], &buff[vertex_offset],
+           positions->size() * sizeof(float));
+    memcpy(&(*indices)[0], &buff[face_offset],
+           indices->size() * sizeof(v8_uint32_t));
+    return true;
+}
+
+bool check_model(const v8::utility::ifs_loader& loader,
+                 const std::vector<float>& positions,
+                 const std::vector<v8_uint32_t>& indices) {
+    if (!loader.isValid_ || loader.getFaceCount() != indices.size() / 3 ||
+        loader.vertexData_.size() * 3 != positions.size() ||
+        loader.indexData_.size() != indices.size())
+        return false;
+
+    for (v8_size_t i = 0; i < loader.vertexData_.size(); ++i) {
+        const v8::rendering::vertex_pn& v = loader.vertexData_[i];
+        if (v.position.x_ != positions[i * 3] ||
+            v.position.y_ != positions[i * 3 + 1] ||
+            v.position.z_ != positions[i * 3 + 2])
+            return false;
+
+        //
+        // Every face of the grid lies in the z = 0 plane.
+        if (std::fabs(std::fabs(v.normal.z_) - 1.0f) > 1.0e-4f)
+            return false;
+    }
+
+    for (v8_size_t i = 0; i < indices.size(); ++i) {
+        if (static_cast<v8_uint32_t>(loader.indexData_[i]) != indices[i])
+            return false;
+    }
+
+    return true;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const v8_uint32_t grid_size = argc > 1
+        ? static_cast<v8_uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 1000;
+    const char* file_name = argc > 2 ? argv[2] : "ifs_load_benchmark.ifs";
+
+    if (grid_size < 2) {
+        printf("grid size must be at least 2\n");
+        return EXIT_FAILURE;
+    }
+
+    std::vector<float> positions;
+    std::vector<v8_uint32_t> indices;
+    make_grid(grid_size, &positions, &indices);
+
+    if (!write_ifs_file(file_name, positions, indices)) {
+        printf("failed to write %s\n", file_name);
+        return EXIT_FAILURE;
+    }
+
+    //
+    // "IFS" string, version, "grid" string, "VERTICES" string and count.
+    const v8_size_t vertex_offset =
+        sizeof(v8_uint32_t) + sizeof("IFS") + sizeof(float) +
+        sizeof(v8_uint32_t) + sizeof("grid") +
+        sizeof(v8_uint32_t) + sizeof("VERTICES") + sizeof(v8_uint32_t);
+
+    v8::base::job_system jobs;
+    double reference_ms = 1.0e30;
+    double load_ms = 1.0e30;
+    double parallel_load_ms = 1.0e30;
+    bool passed = true;
+
+    for (int run = 0; run < C_Load_Runs && passed; ++run) {
+        std::vector<float> ref_positions(positions.size());
+        std::vector<v8_uint32_t> ref_indices(indices.size());
+        auto start = std::chrono::steady_clock::now();
+        passed = read_reference(file_name, vertex_offset,
+                                &ref_positions, &ref_indices);
+        reference_ms = std::min(reference_ms, elapsed_ms(start));
+        passed = passed && ref_positions == positions && ref_indices == indices;
+
+        v8::utility::ifs_loader loader;
+        start = std::chrono::steady_clock::now();
+        loader.loadModel(file_name);
+        load_ms = std::min(load_ms, elapsed_ms(start));
+        passed = passed && check_model(loader, positions, indices);
+
+        v8::utility::ifs_loader parallel_loader;
+        start = std::chrono::steady_clock::now();
+        parallel_loader.loadModel(file_name, false, &jobs);
+        parallel_load_ms = std::min(parallel_load_ms, elapsed_ms(start));
+        passed = passed && check_model(parallel_loader, positions, indices);
+    }
+
+    remove(file_name);
+
+    const double file_mb = static_cast<double>(
+        vertex_offset + positions.size() * sizeof(float) +
+        sizeof(v8_uint32_t) + sizeof("TRIANGLES") + sizeof(v8_uint32_t) +
+        indices.size() * sizeof(v8_uint32_t)) / (1024.0 * 1024.0);
+
+    printf("%u vertices, %zu faces, %.1f MB\n",
+           grid_size * grid_size, indices.size() / 3, file_mb);
+    printf("    fread and copy          %8.2f ms\n", reference_ms);
+    printf("    ifs_loader::loadModel   %8.2f ms (with normals)\n", load_ms);
+    printf("    with %2u threads         %8.2f ms\n",
+           jobs.get_thread_count(), parallel_load_ms);
+
+    if (!passed) {
+        printf("    MISMATCH between the loaded model and the written mesh\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,198 @@
+///
+/// \file   job_system_benchmark.cc
+/// \brief  Updates a set of synthetic entities with base::job_system's
+///         parallel_for, for 1, 2, 4, 8 and 16 threads, and checks that every
+///         entity was updated exactly once and matches a serial update. Also
+///         checks that jobs with dependencies run after their prerequisites.
+///         The speedup is bounded by the number of hardware threads.
+///         Usage : job_system_benchmark [entity_count] [run_count]
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/base/job_system.hpp>
+
+namespace {
+
+const v8_size_t C_Grain_Size = 64;
+const int C_Integration_Steps = 16;
+const v8_uint32_t C_Thread_Counts[] = { 1, 2, 4, 8, 16 };
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+///
+/// \brief  Entity state, about what scene_entity::update touches.
+struct entity_t {
+    float en_pos[3];
+    float en_vel[3];
+    float en_angle;
+    v8_uint32_t en_update_count;
+};
+
+std::vector<entity_t> make_entities(v8_size_t count) {
+    std::vector<entity_t> entities(count);
+    for (v8_size_t i = 0; i < count; ++i) {
+        const float f = static_cast<float>(i);
+        entities[i].en_pos[0] = f * 0.5f;
+        entities[i].en_pos[1] = 0.0f;
+        entities[i].en_pos[2] = -f * 0.25f;
+        entities[i].en_vel[0] = std::sin(f);
+        entities[i].en_vel[1] = std::cos(f);
+        entities[i].en_vel[2] = 1.0f;
+        entities[i].en_angle = f * 0.01f;
+        entities[i].en_update_count = 0;
+    }
+    return entities;
+}
+
+void update_entity(entity_t& ent, float delta) {
+    for (int step = 0; step < C_Integration_Steps; ++step) {
+        ent.en_angle += delta;
+        const float s = std::sin(ent.en_angle);
+        const float c = std::cos(ent.en_angle);
+        const float vx = c * ent.en_vel[0] - s * ent.en_vel[2];
+        const float vz = s * ent.en_vel[0] + c * ent.en_vel[2];
+        ent.en_vel[0] = vx;
+        ent.en_vel[2] = vz;
+        ent.en_vel[1] -= 9.8f * delta;
+        ent.en_pos[0] += ent.en_vel[0] * delta;
+        ent.en_pos[1] += ent.en_vel[1] * delta;
+        ent.en_pos[2] += ent.en_vel[2] * delta;
+    }
+    ++ent.en_update_count;
+}
+
+bool same_state(const std::vector<entity_t>& lhs,
+                const std::vector<entity_t>& rhs) {
+    for (v8_size_t i = 0; i < lhs.size(); ++i) {
+        if (std::memcmp(&lhs[i], &rhs[i], sizeof(entity_t)) != 0)
+            return false;
+    }
+    return true;
+}
+
+///
+/// \brief  Builds a diamond (a -> b, a -> c, b + c -> d) and a parent job
+///         whose children must finish before it does. Every job records the
+///         order it ran in.
+bool check_dependencies(v8::base::job_system& jobs) {
+    std::atomic<int> sequence(0);
+    int order[5] = { -1, -1, -1, -1, -1 };
+
+    auto record = [&sequence, &order](int slot) {
+        return [&sequence, &order, slot]() {
+            order[slot] = sequence.fetch_add(1);
+        };
+    };
+
+    auto a = jobs.create_job(record(0));
+    auto b = jobs.create_job(record(1));
+    auto c = jobs.create_job(record(2));
+    auto d = jobs.create_job(record(3));
+    jobs.add_dependency(b, a);
+    jobs.add_dependency(c, a);
+    jobs.add_dependency(d, b);
+    jobs.add_dependency(d, c);
+
+    //
+    // Submitted in reverse, so the order can only come from the dependencies.
+    jobs.submit(d);
+    jobs.submit(c);
+    jobs.submit(b);
+    jobs.submit(a);
+    jobs.wait(d);
+
+    std::atomic<int> children_done(0);
+    auto parent = jobs.create_job([]() {});
+    for (int i = 0; i < 32; ++i) {
+        auto child = jobs.create_job([&children_done]() {
+            children_done.fetch_add(1);
+        }, parent);
+        jobs.submit(child);
+    }
+    jobs.submit(parent);
+    jobs.wait(parent);
+    order[4] = children_done.load();
+
+    return order[0] < order[1] && order[0] < order[2]
+        && order[1] < order[3] && order[2] < order[3]
+        && order[4] == 32 && v8::base::job_system::is_finished(parent);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const v8_size_t entity_count = argc > 1
+        ? static_cast<v8_size_t>(std::strtoul(argv[1], nullptr, 10)) : 100000;
+    const int run_count = argc > 2
+        ? static_cast<int>(std::strtoul(argv[2], nullptr, 10)) : 10;
+
+    if (entity_count < 1 || run_count < 1) {
+        printf("entity count and run count must be at least 1\n");
+        return EXIT_FAILURE;
+    }
+
+    const float delta = 1.0f / 60.0f;
+    const std::vector<entity_t> initial = make_entities(entity_count);
+
+    std::vector<entity_t> reference(initial);
+    double serial_ms = 1.0e30;
+    for (int run = 0; run < run_count; ++run) {
+        reference = initial;
+        const auto start = std::chrono::steady_clock::now();
+        for (v8_size_t i = 0; i < entity_count; ++i)
+            update_entity(reference[i], delta);
+        serial_ms = std::min(serial_ms, elapsed_ms(start));
+    }
+
+    printf("%zu entities, grain %zu, %u hardware threads, best of %d runs\n",
+           entity_count, C_Grain_Size, std::thread::hardware_concurrency(),
+           run_count);
+    printf("    serial loop          %8.3f ms\n", serial_ms);
+
+    bool passed = true;
+    for (v8_uint32_t thread_count : C_Thread_Counts) {
+        v8::base::job_system jobs(thread_count - 1);
+
+        double parallel_ms = 1.0e30;
+        bool run_passed = true;
+        for (int run = 0; run < run_count; ++run) {
+            std::vector<entity_t> entities(initial);
+            const auto start = std::chrono::steady_clock::now();
+            jobs.parallel_for(
+                0, entity_count, C_Grain_Size,
+                [&entities, delta](v8_size_t first, v8_size_t last) {
+                    for (v8_size_t idx = first; idx < last; ++idx)
+                        update_entity(entities[idx], delta);
+            });
+            parallel_ms = std::min(parallel_ms, elapsed_ms(start));
+
+            run_passed = run_passed && same_state(entities, reference);
+        }
+
+        run_passed = run_passed && check_dependencies(jobs);
+        passed = passed && run_passed;
+
+        printf("    %2u threads           %8.3f ms  x%.2f%s\n",
+               jobs.get_thread_count(), parallel_ms, serial_ms / parallel_ms,
+               run_passed ? "" : "  MISMATCH");
+    }
+
+    if (!passed) {
+        printf("    MISMATCH between the parallel and the serial update\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,421 @@
+///
+/// \file   matrix4X4_simd_benchmark.cc
+/// \brief  Checks the matrix_4X4<float> and vector4<float> kernels against
+///         the generic (scalar) templates, bit for bit, and times both.
+///         The scalar code is instantiated on a float wrapper, which the
+///         float specializations of matrix4X4_simd.inl and vector4_simd.inl
+///         do not match. Without V8_MATH_ENABLE_SIMD both sides run the
+///         scalar code.
+///         Usage : matrix4X4_simd_benchmark [matrix_count] [repeat_count]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/math/matrix4X4.hpp>
+#include <v8/math/vector4.hpp>
+
+namespace {
+
+///
+/// \brief  A float that is not a float, as far as template specialization
+///         goes : every operation rounds to float, as in the scalar code.
+struct scalar_float {
+    float   sf_value;
+
+    scalar_float() = default;
+
+    scalar_float(float value) : sf_value(value) {}
+};
+
+inline scalar_float operator+(scalar_float lhs, scalar_float rhs) {
+    return scalar_float(lhs.sf_value + rhs.sf_value);
+}
+
+inline scalar_float operator-(scalar_float lhs, scalar_float rhs) {
+    return scalar_float(lhs.sf_value - rhs.sf_value);
+}
+
+inline scalar_float operator*(scalar_float lhs, scalar_float rhs) {
+    return scalar_float(lhs.sf_value * rhs.sf_value);
+}
+
+inline scalar_float operator/(scalar_float lhs, scalar_float rhs) {
+    return scalar_float(lhs.sf_value / rhs.sf_value);
+}
+
+inline scalar_float operator-(scalar_float val) {
+    return scalar_float(-val.sf_value);
+}
+
+inline scalar_float& operator+=(scalar_float& lhs, scalar_float rhs) {
+    lhs.sf_value += rhs.sf_value;
+    return lhs;
+}
+
+inline scalar_float& operator-=(scalar_float& lhs, scalar_float rhs) {
+    lhs.sf_value -= rhs.sf_value;
+    return lhs;
+}
+
+inline scalar_float& operator*=(scalar_float& lhs, scalar_float rhs) {
+    lhs.sf_value *= rhs.sf_value;
+    return lhs;
+}
+
+inline bool operator==(scalar_float lhs, scalar_float rhs) {
+    return lhs.sf_value == rhs.sf_value;
+}
+
+} // anonymous namespace
+
+namespace v8 { namespace math { namespace internals {
+
+//
+// The scalar code divides floats by multiplying with the reciprocal.
+template<>
+struct div_wrap_t<scalar_float> {
+    typedef div_helper<scalar_float, true>  div_helper_t;
+};
+
+} // namespace internals
+} // namespace math
+} // namespace v8
+
+namespace {
+
+using v8::math::matrix_4X4;
+using v8::math::vector4;
+
+typedef matrix_4X4<float>           matrix_simd;
+typedef matrix_4X4<scalar_float>    matrix_scalar;
+typedef vector4<float>              vector_simd;
+typedef vector4<scalar_float>       vector_scalar;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+//
+// Both sides hold floats with the same layout; compared as bytes, so that
+// -0.0f differs from 0.0f and NaNs compare by their bits.
+template<typename simd_type, typename scalar_type>
+bool same_bits(const simd_type& lhs, const scalar_type& rhs) {
+    static_assert(sizeof(simd_type) == sizeof(scalar_type), "layout");
+    return memcmp(&lhs, &rhs, sizeof(lhs)) == 0;
+}
+
+template<typename real_t>
+matrix_4X4<real_t> convert_matrix(const matrix_simd& src) {
+    matrix_4X4<real_t> mtx;
+    for (int i = 0; i < 16; ++i)
+        mtx.elements_[i] = src.elements_[i];
+    return mtx;
+}
+
+struct operands_t {
+    std::vector<matrix_simd>    op_matrices;
+    std::vector<vector_simd>    op_vectors;
+    std::vector<float>          op_scalars;
+};
+
+//
+// Elements in [-2, 2]; the matrices are invertible almost surely, and
+// the ones that are too close to singular are replaced.
+operands_t make_operands(v8_size_t count) {
+    std::mt19937 rng(20120303);
+    std::uniform_real_distribution<float> element(-2.0f, 2.0f);
+    std::uniform_real_distribution<float> scale(0.25f, 4.0f);
+
+    operands_t ops;
+    ops.op_matrices.resize(count);
+    ops.op_vectors.resize(count);
+    ops.op_scalars.resize(count);
+
+    for (v8_size_t i = 0; i < count; ++i) {
+        matrix_simd& mtx = ops.op_matrices[i];
+        do {
+            for (int j = 0; j < 16; ++j)
+                mtx.elements_[j] = element(rng);
+        } while (std::abs(mtx.determinant()) < 1.0e-2f);
+
+        for (int j = 0; j < 4; ++j)
+            ops.op_vectors[i].elements_[j] = element(rng);
+        ops.op_scalars[i] = scale(rng);
+    }
+
+    return ops;
+}
+
+template<typename matrix_type, typename vector_type>
+struct kernel_results {
+    std::vector<matrix_type>    kr_matrices;
+    std::vector<vector_type>    kr_vectors;
+    std::vector<float>          kr_scalars;
+};
+
+//
+// Every kernel of the two headers, applied to each operand and its
+// neighbour. The results are appended in the same order for both types.
+template<typename real_t>
+void run_kernels(
+    const operands_t&                                       ops,
+    kernel_results<matrix_4X4<real_t>, vector4<real_t> >*   res
+    ) {
+    typedef matrix_4X4<real_t>  matrix_t;
+    typedef vector4<real_t>     vector_t;
+
+    const v8_size_t count = ops.op_matrices.size();
+    for (v8_size_t i = 0; i < count; ++i) {
+        const v8_size_t next = (i + 1) % count;
+        const matrix_t lhs(convert_matrix<real_t>(ops.op_matrices[i]));
+        const matrix_t rhs(convert_matrix<real_t>(ops.op_matrices[next]));
+        const vector_t vec(ops.op_vectors[i]);
+        const vector_t vec2(ops.op_vectors[next]);
+        const real_t k = ops.op_scalars[i];
+
+        matrix_t mtx(lhs);
+        mtx += rhs;
+        res->kr_matrices.push_back(mtx);
+        mtx = lhs;
+        mtx -= rhs;
+        res->kr_matrices.push_back(mtx);
+        mtx = lhs;
+        mtx *= k;
+        res->kr_matrices.push_back(mtx);
+        mtx = lhs;
+        mtx /= k;
+        res->kr_matrices.push_back(mtx);
+        res->kr_matrices.push_back(lhs * rhs);
+
+        mtx = lhs;
+        mtx.transpose();
+        res->kr_matrices.push_back(mtx);
+        lhs.get_transpose(&mtx);
+        res->kr_matrices.push_back(mtx);
+        lhs.get_adjoint(&mtx);
+        res->kr_matrices.push_back(mtx);
+        lhs.get_inverse(&mtx);
+        res->kr_matrices.push_back(mtx);
+
+        const real_t det = lhs.determinant();
+        float det_value;
+        memcpy(&det_value, &det, sizeof(det_value));
+        res->kr_scalars.push_back(det_value);
+
+        res->kr_vectors.push_back(lhs * vec);
+
+        vector_t v(vec);
+        v += vec2;
+        res->kr_vectors.push_back(v);
+        v = vec;
+        v -= vec2;
+        res->kr_vectors.push_back(v);
+        v = vec;
+        v *= k;
+        res->kr_vectors.push_back(v);
+        v = vec;
+        v /= k;
+        res->kr_vectors.push_back(v);
+        res->kr_vectors.push_back(-vec);
+        res->kr_vectors.push_back(vec + vec2);
+        res->kr_vectors.push_back(vec - vec2);
+    }
+}
+
+template<typename simd_type, typename scalar_type>
+v8_size_t count_mismatches(
+    const std::vector<simd_type>&   simd_res,
+    const std::vector<scalar_type>& scalar_res
+    ) {
+    v8_size_t mismatches = 0;
+    for (v8_size_t i = 0; i < simd_res.size(); ++i)
+        mismatches += !same_bits(simd_res[i], scalar_res[i]);
+    return mismatches;
+}
+
+bool check_parity(const operands_t& ops) {
+    kernel_results<matrix_simd, vector_simd> simd_res;
+    kernel_results<matrix_scalar, vector_scalar> scalar_res;
+    run_kernels(ops, &simd_res);
+    run_kernels(ops, &scalar_res);
+
+    const v8_size_t matrix_mismatches =
+        count_mismatches(simd_res.kr_matrices, scalar_res.kr_matrices);
+    const v8_size_t vector_mismatches =
+        count_mismatches(simd_res.kr_vectors, scalar_res.kr_vectors);
+    const v8_size_t determinant_mismatches = memcmp(
+        &simd_res.kr_scalars[0], &scalar_res.kr_scalars[0],
+        simd_res.kr_scalars.size() * sizeof(float)) != 0;
+
+    printf("parity : %zu matrices, %zu vectors, %zu determinants compared\n",
+           simd_res.kr_matrices.size(), simd_res.kr_vectors.size(),
+           simd_res.kr_scalars.size());
+
+    if (matrix_mismatches || vector_mismatches || determinant_mismatches) {
+        printf("    MISMATCH : %zu matrices, %zu vectors differ%s\n",
+               matrix_mismatches, vector_mismatches,
+               determinant_mismatches ? ", determinants differ" : "");
+        return false;
+    }
+
+    return true;
+}
+
+//
+// Sums a component of every result, so that the work is not optimized out.
+template<typename real_t>
+struct timed_kernels {
+    typedef matrix_4X4<real_t>  matrix_t;
+    typedef vector4<real_t>     vector_t;
+
+    std::vector<matrix_t>   tk_matrices;
+    std::vector<vector_t>   tk_vectors;
+    std::vector<matrix_t>   tk_out;
+    std::vector<vector_t>   tk_vectors_out;
+
+    explicit timed_kernels(const operands_t& ops)
+        :       tk_vectors(ops.op_vectors.begin(), ops.op_vectors.end())
+            ,   tk_vectors_out(tk_vectors)
+    {
+        for (v8_size_t i = 0; i < ops.op_matrices.size(); ++i)
+            tk_matrices.push_back(convert_matrix<real_t>(ops.op_matrices[i]));
+        tk_out = tk_matrices;
+    }
+
+    void product() {
+        const v8_size_t count = tk_matrices.size();
+        for (v8_size_t i = 0; i < count; ++i)
+            tk_out[i] = tk_matrices[i] * tk_matrices[(i + 1) % count];
+    }
+
+    void inverse() {
+        for (v8_size_t i = 0; i < tk_matrices.size(); ++i)
+            tk_matrices[i].get_inverse(&tk_out[i]);
+    }
+
+    void determinant() {
+        for (v8_size_t i = 0; i < tk_matrices.size(); ++i)
+            tk_out[i].a11_ = tk_matrices[i].determinant();
+    }
+
+    void transpose() {
+        for (v8_size_t i = 0; i < tk_matrices.size(); ++i)
+            tk_matrices[i].get_transpose(&tk_out[i]);
+    }
+
+    void transform() {
+        for (v8_size_t i = 0; i < tk_matrices.size(); ++i)
+            tk_vectors_out[i] = tk_matrices[i] * tk_vectors[i];
+    }
+
+    void vector_add() {
+        const v8_size_t count = tk_vectors.size();
+        for (v8_size_t i = 0; i < count; ++i)
+            tk_vectors_out[i] = tk_vectors[i] + tk_vectors[(i + 1) % count];
+    }
+
+    float checksum() const {
+        float sum = 0.0f;
+        for (v8_size_t i = 0; i < tk_out.size(); ++i) {
+            float val;
+            memcpy(&val, &tk_out[i].a11_, sizeof(val));
+            sum += val;
+            memcpy(&val, &tk_vectors_out[i].x_, sizeof(val));
+            sum += val;
+        }
+        return sum;
+    }
+};
+
+template<typename real_t>
+double time_kernel(
+    timed_kernels<real_t>*                  kernels,
+    void (timed_kernels<real_t>::*kernel)(),
+    v8_size_t                               repeat_count,
+    float*                                  checksum
+    ) {
+    const auto start = std::chrono::steady_clock::now();
+    for (v8_size_t i = 0; i < repeat_count; ++i)
+        (kernels->*kernel)();
+    const double ms = elapsed_ms(start);
+    *checksum += kernels->checksum();
+    return ms;
+}
+
+struct kernel_entry_t {
+    const char*                             ke_name;
+    void (timed_kernels<float>::*ke_simd)();
+    void (timed_kernels<scalar_float>::*ke_scalar)();
+};
+
+void run_timings(const operands_t& ops, v8_size_t repeat_count) {
+    timed_kernels<float> simd_kernels(ops);
+    timed_kernels<scalar_float> scalar_kernels(ops);
+
+    const kernel_entry_t entries[] = {
+        { "matrix * matrix", &timed_kernels<float>::product,
+          &timed_kernels<scalar_float>::product },
+        { "get_inverse", &timed_kernels<float>::inverse,
+          &timed_kernels<scalar_float>::inverse },
+        { "determinant", &timed_kernels<float>::determinant,
+          &timed_kernels<scalar_float>::determinant },
+        { "get_transpose", &timed_kernels<float>::transpose,
+          &timed_kernels<scalar_float>::transpose },
+        { "matrix * vector4", &timed_kernels<float>::transform,
+          &timed_kernels<scalar_float>::transform },
+        { "vector4 + vector4", &timed_kernels<float>::vector_add,
+          &timed_kernels<scalar_float>::vector_add }
+    };
+
+    float checksum = 0.0f;
+    const double op_count =
+        static_cast<double>(ops.op_matrices.size() * repeat_count);
+
+    for (v8_size_t i = 0; i < sizeof(entries) / sizeof(entries[0]); ++i) {
+        const double scalar_ms = time_kernel(
+            &scalar_kernels, entries[i].ke_scalar, repeat_count, &checksum);
+        const double simd_ms = time_kernel(
+            &simd_kernels, entries[i].ke_simd, repeat_count, &checksum);
+
+        printf("    %-18s %8.2f ns/op (scalar %8.2f ns/op), x%.2f\n",
+               entries[i].ke_name, simd_ms * 1.0e6 / op_count,
+               scalar_ms * 1.0e6 / op_count, scalar_ms / simd_ms);
+    }
+
+    printf("    (checksum %g)\n", checksum);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const v8_size_t matrix_count = argc > 1
+        ? static_cast<v8_size_t>(std::strtoul(argv[1], nullptr, 10)) : 4096;
+    const v8_size_t repeat_count = argc > 2
+        ? static_cast<v8_size_t>(std::strtoul(argv[2], nullptr, 10)) : 200;
+
+    if (!matrix_count || !repeat_count) {
+        printf("matrix and repeat counts must not be zero\n");
+        return EXIT_FAILURE;
+    }
+
+#if defined(V8_MATH_SIMD_ENABLED)
+    printf("float kernels : %s\n", V8_MATH_SIMD_STRING);
+#else
+    printf("float kernels : scalar (built without V8_MATH_ENABLE_SIMD)\n");
+#endif
+
+    const operands_t ops = make_operands(matrix_count);
+    if (!check_parity(ops))
+        return EXIT_FAILURE;
+
+    printf("timings : %zu matrices, %zu passes\n", matrix_count, repeat_count);
+    run_timings(ops, repeat_count);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,293 @@
+///
+/// \file   mesh_bvh_ray_benchmark.cc
+/// \brief  Builds a mesh_bvh over a noisy terrain grid and traces camera
+///         rays against it, one at a time and in packets of 4 and 8, for
+///         closest hits and occlusion. A sample of the rays is checked
+///         against a brute force intersection in double precision, and all
+///         the query paths (and the parallel build) must agree with the
+///         single ray query. Reports the build time and Mrays/s.
+///         Usage : mesh_bvh_ray_benchmark [grid_size] [image_size]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/base/job_system.hpp>
+#include <v8/math/vector3.hpp>
+#include <v8/math/objects/ray3.hpp>
+#include <v8/math/spatial/mesh_bvh.hpp>
+
+namespace {
+
+using v8::math::mesh_bvh;
+using v8::math::mesh_ray_hit_t;
+using v8::math::ray3F;
+using v8::math::vector3F;
+
+const float C_Max_Distance = 1.0e4f;
+
+//
+// One ray in this many is checked against the brute force intersection.
+const v8_size_t C_Brute_Force_Stride = 97;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+///
+/// \brief  grid_size x grid_size quads of unit size, two triangles each,
+///         with random heights in [0, 2).
+void make_terrain(v8_size_t grid_size, std::vector<vector3F>* positions,
+                  std::vector<v8_uint32_t>* indices) {
+    std::mt19937 rng(16);
+    std::uniform_real_distribution<float> height(0.0f, 2.0f);
+
+    const v8_size_t row = grid_size + 1;
+    positions->resize(row * row);
+    for (v8_size_t z = 0; z < row; ++z) {
+        for (v8_size_t x = 0; x < row; ++x) {
+            (*positions)[z * row + x] = vector3F(
+                static_cast<float>(x), height(rng), static_cast<float>(z));
+        }
+    }
+
+    indices->clear();
+    for (v8_size_t z = 0; z < grid_size; ++z) {
+        for (v8_size_t x = 0; x < grid_size; ++x) {
+            const v8_uint32_t v00 = static_cast<v8_uint32_t>(z * row + x);
+            const v8_uint32_t v01 = v00 + 1;
+            const v8_uint32_t v10 = static_cast<v8_uint32_t>(v00 + row);
+            const v8_uint32_t v11 = v10 + 1;
+            const v8_uint32_t quad[] = { v00, v10, v01, v01, v10, v11 };
+            indices->insert(indices->end(), quad, quad + 6);
+        }
+    }
+}
+
+///
+/// \brief  Rays of a camera above one corner of the terrain, looking at
+///         the far corner. Rays are ordered in 4 x 2 pixel tiles, so every
+///         8 consecutive rays form a coherent packet.
+std::vector<ray3F> make_camera_rays(v8_size_t grid_size, v8_size_t image_size) {
+    const float extent = static_cast<float>(grid_size);
+    const vector3F eye(-0.1f * extent, 0.3f * extent, -0.1f * extent);
+    vector3F forward = vector3F(0.6f * extent, 0.0f, 0.6f * extent) - eye;
+    forward.normalize();
+    vector3F right = cross_product(vector3F(0.0f, 1.0f, 0.0f), forward);
+    right.normalize();
+    const vector3F up = cross_product(forward, right);
+
+    std::vector<ray3F> rays;
+    rays.reserve(image_size * image_size);
+    const float inv_size = 1.0f / static_cast<float>(image_size);
+
+    for (v8_size_t ty = 0; ty < image_size; ty += 2) {
+        for (v8_size_t tx = 0; tx < image_size; tx += 4) {
+            for (v8_size_t y = ty; y < std::min(ty + 2, image_size); ++y) {
+                for (v8_size_t x = tx; x < std::min(tx + 4, image_size); ++x) {
+                    const float u = (2.0f * x + 1.0f) * inv_size - 1.0f;
+                    const float v = 1.0f - (2.0f * y + 1.0f) * inv_size;
+                    vector3F dir = forward + right * (0.7f * u) + up * (0.7f * v);
+                    dir.normalize();
+                    rays.push_back(ray3F(eye, dir));
+                }
+            }
+        }
+    }
+
+    return rays;
+}
+
+///
+/// \brief  Closest hit distance over all triangles (Moller-Trumbore, both
+///         sides), in double precision. Negative if there is no hit.
+double brute_force_distance(const ray3F& r, const std::vector<vector3F>& positions,
+                            const std::vector<v8_uint32_t>& indices) {
+    const double o[3] = { r.origin_.x_, r.origin_.y_, r.origin_.z_ };
+    const double d[3] = { r.direction_.x_, r.direction_.y_, r.direction_.z_ };
+    double best = -1.0;
+
+    for (v8_size_t i = 0; i < indices.size(); i += 3) {
+        const vector3F& a = positions[indices[i]];
+        const vector3F& b = positions[indices[i + 1]];
+        const vector3F& c = positions[indices[i + 2]];
+        const double e1[3] = { double(b.x_) - a.x_, double(b.y_) - a.y_,
+                               double(b.z_) - a.z_ };
+        const double e2[3] = { double(c.x_) - a.x_, double(c.y_) - a.y_,
+                               double(c.z_) - a.z_ };
+        const double p[3] = { d[1] * e2[2] - d[2] * e2[1],
+                              d[2] * e2[0] - d[0] * e2[2],
+                              d[0] * e2[1] - d[1] * e2[0] };
+        const double det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+        if (std::fabs(det) < 1.0e-12)
+            continue;
+
+        const double inv_det = 1.0 / det;
+        const double s[3] = { o[0] - a.x_, o[1] - a.y_, o[2] - a.z_ };
+        const double u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) * inv_det;
+        if (u < 0.0 || u > 1.0)
+            continue;
+
+        const double q[3] = { s[1] * e1[2] - s[2] * e1[1],
+                              s[2] * e1[0] - s[0] * e1[2],
+                              s[0] * e1[1] - s[1] * e1[0] };
+        const double v = (d[0] * q[0] + d[1] * q[1] + d[2] * q[2]) * inv_det;
+        if (v < 0.0 || u + v > 1.0)
+            continue;
+
+        const double t = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) * inv_det;
+        if (t >= 0.0 && t <= C_Max_Distance && (best < 0.0 || t < best))
+            best = t;
+    }
+
+    return best;
+}
+
+bool same_hit(const mesh_ray_hit_t& lhs, const mesh_ray_hit_t& rhs) {
+    if (lhs.rh_triangle == mesh_bvh::C_No_Triangle
+        || rhs.rh_triangle == mesh_bvh::C_No_Triangle)
+        return lhs.rh_triangle == rhs.rh_triangle;
+
+    return std::fabs(lhs.rh_distance - rhs.rh_distance)
+        <= 1.0e-5f * std::max(1.0f, lhs.rh_distance);
+}
+
+double mrays_per_second(v8_size_t count, double ms) {
+    return static_cast<double>(count) / (ms * 1000.0);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const v8_size_t grid_size = argc > 1
+        ? static_cast<v8_size_t>(std::strtoul(argv[1], nullptr, 10)) : 224;
+    const v8_size_t image_size = argc > 2
+        ? static_cast<v8_size_t>(std::strtoul(argv[2], nullptr, 10)) : 512;
+
+    if (grid_size < 1 || image_size < 4 || image_size % 4) {
+        printf("grid size must be at least 1, image size a multiple of 4\n");
+        return EXIT_FAILURE;
+    }
+
+    std::vector<vector3F> positions;
+    std::vector<v8_uint32_t> indices;
+    make_terrain(grid_size, &positions, &indices);
+    const v8_size_t triangle_count = indices.size() / 3;
+
+    const std::vector<ray3F> rays = make_camera_rays(grid_size, image_size);
+    const v8_size_t ray_count = rays.size();
+    const std::vector<float> max_distances(ray_count, C_Max_Distance);
+
+    v8::base::job_system jobs(3);
+
+    mesh_bvh bvh;
+    auto start = std::chrono::steady_clock::now();
+    bvh.build(&positions[0], sizeof(vector3F), &indices[0], triangle_count);
+    const double build_ms = elapsed_ms(start);
+
+    mesh_bvh parallel_bvh;
+    start = std::chrono::steady_clock::now();
+    parallel_bvh.build(&positions[0], sizeof(vector3F), &indices[0],
+                       triangle_count, &jobs);
+    const double parallel_build_ms = elapsed_ms(start);
+
+    //
+    // Closest hits : single rays, packets of 4 and 8, the batch function.
+    std::vector<mesh_ray_hit_t> single(ray_count);
+    start = std::chrono::steady_clock::now();
+    for (v8_size_t i = 0; i < ray_count; ++i)
+        bvh.intersect(rays[i], C_Max_Distance, &single[i]);
+    const double single_ms = elapsed_ms(start);
+
+    std::vector<mesh_ray_hit_t> packet4(ray_count);
+    start = std::chrono::steady_clock::now();
+    for (v8_size_t i = 0; i < ray_count; i += 4)
+        bvh.intersect_packet4(&rays[i], &max_distances[i], &packet4[i]);
+    const double packet4_ms = elapsed_ms(start);
+
+    std::vector<mesh_ray_hit_t> packet8(ray_count);
+    start = std::chrono::steady_clock::now();
+    for (v8_size_t i = 0; i < ray_count; i += 8)
+        bvh.intersect_packet8(&rays[i], &max_distances[i], &packet8[i]);
+    const double packet8_ms = elapsed_ms(start);
+
+    std::vector<mesh_ray_hit_t> batch(ray_count);
+    start = std::chrono::steady_clock::now();
+    bvh.intersect_rays(&rays[0], ray_count, C_Max_Distance, &batch[0], &jobs);
+    const double batch_ms = elapsed_ms(start);
+
+    std::vector<mesh_ray_hit_t> parallel_built(ray_count);
+    parallel_bvh.intersect_rays(&rays[0], ray_count, C_Max_Distance,
+                                &parallel_built[0]);
+
+    //
+    // Occlusion, single rays and packets of 8.
+    std::vector<bool> occluded(ray_count);
+    start = std::chrono::steady_clock::now();
+    for (v8_size_t i = 0; i < ray_count; ++i)
+        occluded[i] = bvh.occluded(rays[i], C_Max_Distance);
+    const double occluded_ms = elapsed_ms(start);
+
+    std::vector<v8_uint32_t> occluded8(ray_count / 8 + 1);
+    start = std::chrono::steady_clock::now();
+    for (v8_size_t i = 0; i < ray_count; i += 8)
+        occluded8[i / 8] = bvh.occluded_packet8(&rays[i], &max_distances[i]);
+    const double occluded8_ms = elapsed_ms(start);
+
+    v8_size_t path_mismatches = 0;
+    v8_size_t hit_count = 0;
+    for (v8_size_t i = 0; i < ray_count; ++i) {
+        const bool hit = single[i].rh_triangle != mesh_bvh::C_No_Triangle;
+        const bool hit8 = ((occluded8[i / 8] >> (i % 8)) & 1) != 0;
+        hit_count += hit;
+        path_mismatches += !same_hit(single[i], packet4[i])
+            || !same_hit(single[i], packet8[i]) || !same_hit(single[i], batch[i])
+            || !same_hit(single[i], parallel_built[i])
+            || occluded[i] != hit || hit8 != hit;
+    }
+
+    v8_size_t brute_mismatches = 0;
+    v8_size_t brute_count = 0;
+    for (v8_size_t i = 0; i < ray_count; i += C_Brute_Force_Stride) {
+        const double expected = brute_force_distance(rays[i], positions, indices);
+        const bool hit = single[i].rh_triangle != mesh_bvh::C_No_Triangle;
+        ++brute_count;
+        if (hit != (expected >= 0.0)
+            || (hit && std::fabs(single[i].rh_distance - expected)
+                       > 1.0e-4 * std::max(1.0, expected)))
+            ++brute_mismatches;
+    }
+
+    printf("%zu triangles, %zu rays (%zu hit), %zu bytes of tree\n",
+           triangle_count, ray_count, hit_count, bvh.get_memory_size());
+    printf("    build                  %9.3f ms\n", build_ms);
+    printf("    build, %u threads       %9.3f ms\n", jobs.get_thread_count(),
+           parallel_build_ms);
+    printf("    closest, single        %9.2f Mrays/s\n",
+           mrays_per_second(ray_count, single_ms));
+    printf("    closest, packet4       %9.2f Mrays/s\n",
+           mrays_per_second(ray_count, packet4_ms));
+    printf("    closest, packet8       %9.2f Mrays/s\n",
+           mrays_per_second(ray_count, packet8_ms));
+    printf("    intersect_rays, %u thr  %9.2f Mrays/s\n", jobs.get_thread_count(),
+           mrays_per_second(ray_count, batch_ms));
+    printf("    any hit, single        %9.2f Mrays/s\n",
+           mrays_per_second(ray_count, occluded_ms));
+    printf("    any hit, packet8       %9.2f Mrays/s\n",
+           mrays_per_second(ray_count, occluded8_ms));
+    printf("    %zu rays checked against brute force\n", brute_count);
+
+    if (path_mismatches || brute_mismatches) {
+        printf("    MISMATCH : %zu rays differ between the query paths, "
+               "%zu from brute force\n", path_mismatches, brute_mismatches);
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,237 @@
+///
+/// \file   mesh_closest_point_benchmark.cc
+/// \brief  Builds a mesh_bvh over scattered triangles at several scales
+///         (down to triangles a thousandth of a unit across) and checks
+///         closest_point() against a brute force search in double
+///         precision, then times the queries against the brute force.
+///         Usage : mesh_closest_point_benchmark [triangle_count] [query_count]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/math/vector3.hpp>
+#include <v8/math/spatial/mesh_bvh.hpp>
+
+namespace {
+
+using v8::math::mesh_bvh;
+using v8::math::mesh_closest_point_t;
+using v8::math::vector3F;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+struct point3d {
+    double  x;
+    double  y;
+    double  z;
+};
+
+point3d make_point(const vector3F& v) {
+    const point3d p = { v.x_, v.y_, v.z_ };
+    return p;
+}
+
+point3d sub(const point3d& a, const point3d& b) {
+    const point3d p = { a.x - b.x, a.y - b.y, a.z - b.z };
+    return p;
+}
+
+double dot(const point3d& a, const point3d& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+///
+/// \brief  Reference : squared distance from p to the triangle (a, b, c),
+///         by the Voronoi regions of its vertices and edges (Ericson,
+///         Real-Time Collision Detection, 5.1.5), in double precision.
+double reference_distance_squared(const point3d& p, const point3d& a,
+                                  const point3d& b, const point3d& c) {
+    const point3d ab = sub(b, a);
+    const point3d ac = sub(c, a);
+    const point3d ap = sub(p, a);
+
+    const double d1 = dot(ab, ap);
+    const double d2 = dot(ac, ap);
+    if (d1 <= 0.0 && d2 <= 0.0)
+        return dot(ap, ap);
+
+    const point3d bp = sub(p, b);
+    const double d3 = dot(ab, bp);
+    const double d4 = dot(ac, bp);
+    if (d3 >= 0.0 && d4 <= d3)
+        return dot(bp, bp);
+
+    const point3d cp = sub(p, c);
+    const double d5 = dot(ab, cp);
+    const double d6 = dot(ac, cp);
+    if (d6 >= 0.0 && d5 <= d6)
+        return dot(cp, cp);
+
+    double u;
+    double v;
+    const double vc = d1 * d4 - d3 * d2;
+    const double vb = d5 * d2 - d1 * d6;
+    const double va = d3 * d6 - d5 * d4;
+
+    if (vc <= 0.0 && d1 >= 0.0 && d3 <= 0.0) {
+        u = d1 / (d1 - d3);
+        v = 0.0;
+    } else if (vb <= 0.0 && d2 >= 0.0 && d6 <= 0.0) {
+        u = 0.0;
+        v = d2 / (d2 - d6);
+    } else if (va <= 0.0 && (d4 - d3) >= 0.0 && (d5 - d6) >= 0.0) {
+        v = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+        u = 1.0 - v;
+    } else {
+        const double denom = 1.0 / (va + vb + vc);
+        u = vb * denom;
+        v = vc * denom;
+    }
+
+    const point3d q = {
+        a.x + ab.x * u + ac.x * v,
+        a.y + ab.y * u + ac.y * v,
+        a.z + ab.z * u + ac.z * v
+    };
+    const point3d d = sub(p, q);
+    return dot(d, d);
+}
+
+///
+/// \brief  Triangles with edges of about triangle_size, scattered in a cube
+///         of 100 triangle sizes, and query points in a slightly larger
+///         cube.
+void make_scene(v8_size_t triangle_count, v8_size_t query_count,
+                float triangle_size, std::vector<vector3F>* positions,
+                std::vector<v8_uint32_t>* indices,
+                std::vector<vector3F>* queries) {
+    std::mt19937 rng(2468);
+    const float world_size = 100.0f * triangle_size;
+    std::uniform_real_distribution<float> coord(0.0f, world_size);
+    std::uniform_real_distribution<float> offset(-triangle_size, triangle_size);
+    std::uniform_real_distribution<float> query_coord(-0.1f * world_size,
+                                                      1.1f * world_size);
+
+    positions->clear();
+    indices->clear();
+    for (v8_size_t i = 0; i < triangle_count; ++i) {
+        const vector3F center(coord(rng), coord(rng), coord(rng));
+        for (v8_uint32_t v = 0; v < 3; ++v) {
+            indices->push_back(static_cast<v8_uint32_t>(positions->size()));
+            positions->push_back(
+                center + vector3F(offset(rng), offset(rng), offset(rng)));
+        }
+    }
+
+    queries->resize(query_count);
+    for (v8_size_t i = 0; i < query_count; ++i)
+        (*queries)[i] = vector3F(query_coord(rng), query_coord(rng),
+                                 query_coord(rng));
+}
+
+bool run_benchmark(v8_size_t triangle_count, v8_size_t query_count,
+                   float triangle_size) {
+    std::vector<vector3F> positions;
+    std::vector<v8_uint32_t> indices;
+    std::vector<vector3F> queries;
+    make_scene(triangle_count, query_count, triangle_size,
+               &positions, &indices, &queries);
+
+    mesh_bvh bvh;
+    bvh.build(&positions[0], sizeof(vector3F), &indices[0], triangle_count);
+
+    const float max_distance = 1000.0f * triangle_size;
+    std::vector<mesh_closest_point_t> results(query_count);
+    auto start = std::chrono::steady_clock::now();
+    for (v8_size_t i = 0; i < query_count; ++i)
+        bvh.closest_point(queries[i], max_distance, &results[i]);
+    const double bvh_ms = elapsed_ms(start);
+
+    std::vector<double> reference(query_count);
+    start = std::chrono::steady_clock::now();
+    for (v8_size_t i = 0; i < query_count; ++i) {
+        const point3d p = make_point(queries[i]);
+        double best = 1.0e300;
+        for (v8_size_t tri = 0; tri < triangle_count; ++tri) {
+            best = std::min(best, reference_distance_squared(
+                p, make_point(positions[indices[tri * 3]]),
+                make_point(positions[indices[tri * 3 + 1]]),
+                make_point(positions[indices[tri * 3 + 2]])));
+        }
+        reference[i] = best;
+    }
+    const double brute_ms = elapsed_ms(start);
+
+    //
+    // Distances are compared with a tolerance relative to the size of the
+    // world (single precision coordinates); the closest point must lie on
+    // the reported triangle.
+    const double tolerance = 1.0e-5 * 100.0 * triangle_size;
+    const float param_epsilon = 1.0e-4f;
+    v8_size_t mismatches = 0;
+    double worst_error = 0.0;
+
+    for (v8_size_t i = 0; i < query_count; ++i) {
+        const mesh_closest_point_t& r = results[i];
+        if (r.cp_triangle == mesh_bvh::C_No_Triangle) {
+            ++mismatches;
+            continue;
+        }
+
+        const double error = std::fabs(
+            std::sqrt(static_cast<double>(r.cp_distance_squared))
+            - std::sqrt(reference[i]));
+        worst_error = std::max(worst_error, error);
+
+        const bool on_triangle = r.cp_u >= -param_epsilon
+            && r.cp_v >= -param_epsilon
+            && r.cp_u + r.cp_v <= 1.0f + param_epsilon;
+        mismatches += (error > tolerance) || !on_triangle;
+    }
+
+    printf("%zu triangles of size %g, %zu queries\n",
+           triangle_count, triangle_size, query_count);
+    printf("    mesh_bvh::closest_point  %8.3f ms\n", bvh_ms);
+    printf("    brute force (double)     %8.3f ms\n", brute_ms);
+    printf("    largest distance error   %g\n", worst_error);
+
+    if (mismatches) {
+        printf("    MISMATCH : %zu queries differ from the reference\n",
+               mismatches);
+        return false;
+    }
+
+    return true;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const v8_size_t triangle_count = argc > 1
+        ? static_cast<v8_size_t>(std::strtoul(argv[1], nullptr, 10)) : 10000;
+    const v8_size_t query_count = argc > 2
+        ? static_cast<v8_size_t>(std::strtoul(argv[2], nullptr, 10)) : 1000;
+
+    if (!triangle_count || !query_count) {
+        printf("triangle and query counts must not be zero\n");
+        return EXIT_FAILURE;
+    }
+
+    bool passed = true;
+    const float triangle_sizes[] = { 1.0f, 1.0e-2f, 1.0e-3f };
+    for (v8_size_t i = 0; i < sizeof(triangle_sizes) / sizeof(triangle_sizes[0]);
+         ++i)
+        passed = run_benchmark(triangle_count, query_count, triangle_sizes[i])
+                 && passed;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
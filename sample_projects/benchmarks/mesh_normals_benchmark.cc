@@ -0,0 +1,304 @@
+///
+/// \file   mesh_normals_benchmark.cc
+/// \brief  Computes the vertex normals (area and angle weighted) and the
+///         tangents of a geosphere with randomly displaced vertices, and
+///         compares them against a plain scatter loop in double precision.
+///         The job system (4 threads, the partitioned path) must give the
+///         same bits as the serial path. Times both, and a plain float
+///         scatter loop.
+///         Usage : mesh_normals_benchmark [subdivisions] [run_count]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/base/job_system.hpp>
+#include <v8/math/geometry_generators.hpp>
+#include <v8/math/mesh_normals.hpp>
+
+namespace {
+
+using v8::math::vector3F;
+using v8::math::geometry_gen::mesh_data_t;
+using v8::math::geometry_gen::vertex_pntt;
+
+const double C_Max_Normal_Error = 1.0e-5;
+const double C_Max_Tangent_Error = 1.0e-5;
+const v8_uint32_t C_Job_Threads = 4;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+struct dvec3 {
+    double x, y, z;
+};
+
+dvec3 to_dvec3(const vector3F& v) {
+    const dvec3 d = { v.x_, v.y_, v.z_ };
+    return d;
+}
+
+dvec3 sub(const dvec3& a, const dvec3& b) {
+    const dvec3 d = { a.x - b.x, a.y - b.y, a.z - b.z };
+    return d;
+}
+
+dvec3 cross(const dvec3& a, const dvec3& b) {
+    const dvec3 d = { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z,
+                      a.x * b.y - a.y * b.x };
+    return d;
+}
+
+double dot(const dvec3& a, const dvec3& b) {
+    return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+dvec3 normalized(const dvec3& v) {
+    const double len = std::sqrt(dot(v, v));
+    const double inv = len > 0.0 ? 1.0 / len : 0.0;
+    const dvec3 d = { v.x * inv, v.y * inv, v.z * inv };
+    return d;
+}
+
+void add_to(dvec3* dst, const dvec3& v, double weight) {
+    dst->x += v.x * weight;
+    dst->y += v.y * weight;
+    dst->z += v.z * weight;
+}
+
+///
+/// \brief  Geosphere with every vertex moved in or out by up to a quarter of
+///         the edge length, so area and angle weighting give different
+///         normals but the surface does not fold over.
+void make_mesh(v8_size_t subdivisions, mesh_data_t* mesh) {
+    v8::math::geometry_gen::create_geosphere(1.0f, subdivisions, mesh);
+
+    const float amplitude = 0.25f / static_cast<float>(1 << subdivisions);
+    std::mt19937 rng(10);
+    std::uniform_real_distribution<float> bump(1.0f - amplitude, 1.0f + amplitude);
+    for (vertex_pntt& vertex : mesh->md_vertices) {
+        vertex.vt_position *= bump(rng);
+        vertex.vt_normal = vector3F(0.0f, 0.0f, 0.0f);
+        vertex.vt_tangent = vector3F(0.0f, 0.0f, 0.0f);
+    }
+}
+
+std::vector<dvec3> reference_normals(const mesh_data_t& mesh, bool by_angle) {
+    const dvec3 zero = { 0.0, 0.0, 0.0 };
+    std::vector<dvec3> normals(mesh.md_vertices.size(), zero);
+
+    for (v8_size_t i = 0; i < mesh.md_indices.size(); i += 3) {
+        const v8_uint32_t* face = &mesh.md_indices[i];
+        dvec3 p[3];
+        for (int c = 0; c < 3; ++c)
+            p[c] = to_dvec3(mesh.md_vertices[face[c]].vt_position);
+
+        const dvec3 face_normal = cross(sub(p[1], p[0]), sub(p[2], p[0]));
+        for (int c = 0; c < 3; ++c) {
+            double weight = 1.0;
+            dvec3 n = face_normal;
+            if (by_angle) {
+                const dvec3 e1 = normalized(sub(p[(c + 1) % 3], p[c]));
+                const dvec3 e2 = normalized(sub(p[(c + 2) % 3], p[c]));
+                weight = std::acos(std::max(-1.0, std::min(1.0, dot(e1, e2))));
+                n = normalized(face_normal);
+            }
+            add_to(&normals[face[c]], n, weight);
+        }
+    }
+
+    for (dvec3& n : normals)
+        n = normalized(n);
+    return normals;
+}
+
+std::vector<dvec3> reference_tangents(const mesh_data_t& mesh,
+                                      const std::vector<dvec3>& normals) {
+    const dvec3 zero = { 0.0, 0.0, 0.0 };
+    std::vector<dvec3> tangents(mesh.md_vertices.size(), zero);
+
+    for (v8_size_t i = 0; i < mesh.md_indices.size(); i += 3) {
+        const v8_uint32_t* face = &mesh.md_indices[i];
+        const vertex_pntt& v0 = mesh.md_vertices[face[0]];
+        const vertex_pntt& v1 = mesh.md_vertices[face[1]];
+        const vertex_pntt& v2 = mesh.md_vertices[face[2]];
+
+        const double du1 = double(v1.vt_texcoord.x_) - v0.vt_texcoord.x_;
+        const double dv1 = double(v1.vt_texcoord.y_) - v0.vt_texcoord.y_;
+        const double du2 = double(v2.vt_texcoord.x_) - v0.vt_texcoord.x_;
+        const double dv2 = double(v2.vt_texcoord.y_) - v0.vt_texcoord.y_;
+        const double det = du1 * dv2 - du2 * dv1;
+        if (std::fabs(det) <= 1.0e-20)
+            continue;
+
+        const dvec3 e1 = sub(to_dvec3(v1.vt_position), to_dvec3(v0.vt_position));
+        const dvec3 e2 = sub(to_dvec3(v2.vt_position), to_dvec3(v0.vt_position));
+        const dvec3 t = { (e1.x * dv2 - e2.x * dv1) / det,
+                          (e1.y * dv2 - e2.y * dv1) / det,
+                          (e1.z * dv2 - e2.z * dv1) / det };
+        for (int c = 0; c < 3; ++c)
+            add_to(&tangents[face[c]], t, 1.0);
+    }
+
+    for (v8_size_t i = 0; i < tangents.size(); ++i) {
+        add_to(&tangents[i], normals[i], -dot(normals[i], tangents[i]));
+        tangents[i] = normalized(tangents[i]);
+    }
+    return tangents;
+}
+
+///
+/// \brief  Largest distance between a computed vector and the reference.
+double max_error(const mesh_data_t& mesh, vector3F vertex_pntt::* member,
+                 const std::vector<dvec3>& reference) {
+    double error = 0.0;
+    for (v8_size_t i = 0; i < reference.size(); ++i) {
+        const dvec3 d = sub(to_dvec3(mesh.md_vertices[i].*member), reference[i]);
+        error = std::max(error, std::sqrt(dot(d, d)));
+    }
+    return error;
+}
+
+bool same_bits(const mesh_data_t& lhs, const mesh_data_t& rhs) {
+    return std::memcmp(&lhs.md_vertices[0], &rhs.md_vertices[0],
+                       lhs.md_vertices.size() * sizeof(vertex_pntt)) == 0;
+}
+
+///
+/// \brief  Area weighted normals, the way they were computed before
+///         compute_vertex_normals() : scatter the face normals, normalize.
+void plain_scatter_normals(mesh_data_t* mesh) {
+    std::vector<vertex_pntt>& vertices = mesh->md_vertices;
+    for (vertex_pntt& vertex : vertices)
+        vertex.vt_normal = vector3F(0.0f, 0.0f, 0.0f);
+
+    for (v8_size_t i = 0; i < mesh->md_indices.size(); i += 3) {
+        const v8_uint32_t* face = &mesh->md_indices[i];
+        const vector3F& p0 = vertices[face[0]].vt_position;
+        const vector3F n = cross_product(vertices[face[1]].vt_position - p0,
+                                         vertices[face[2]].vt_position - p0);
+        vertices[face[0]].vt_normal += n;
+        vertices[face[1]].vt_normal += n;
+        vertices[face[2]].vt_normal += n;
+    }
+
+    for (vertex_pntt& vertex : vertices)
+        vertex.vt_normal.normalize();
+}
+
+void compute_normals(mesh_data_t* mesh, v8::math::Normal_Weight weighting,
+                     v8::base::job_system* jobs) {
+    v8::math::compute_vertex_normals(
+        &mesh->md_vertices[0], mesh->md_vertices.size(), &mesh->md_indices[0],
+        mesh->md_indices.size() / 3, &vertex_pntt::vt_position,
+        &vertex_pntt::vt_normal, weighting, jobs);
+}
+
+void compute_tangents(mesh_data_t* mesh, v8::base::job_system* jobs) {
+    v8::math::compute_vertex_tangents(
+        &mesh->md_vertices[0], mesh->md_vertices.size(), &mesh->md_indices[0],
+        mesh->md_indices.size() / 3, &vertex_pntt::vt_position,
+        &vertex_pntt::vt_normal, &vertex_pntt::vt_texcoord,
+        &vertex_pntt::vt_tangent, jobs);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const v8_size_t subdivisions = argc > 1
+        ? static_cast<v8_size_t>(std::strtoul(argv[1], nullptr, 10)) : 8;
+    const int run_count = argc > 2
+        ? static_cast<int>(std::strtoul(argv[2], nullptr, 10)) : 5;
+
+    if (subdivisions > v8::math::geometry_gen::C_Max_Geosphere_Subdivisions
+        || run_count < 1) {
+        printf("subdivisions must be at most %zu, run count at least 1\n",
+               v8::math::geometry_gen::C_Max_Geosphere_Subdivisions);
+        return EXIT_FAILURE;
+    }
+
+    mesh_data_t initial;
+    make_mesh(subdivisions, &initial);
+
+    v8::base::job_system jobs(C_Job_Threads - 1);
+
+    const v8::math::Normal_Weight weightings[] = {
+        v8::math::Normal_Weight_Area, v8::math::Normal_Weight_Angle
+    };
+    const char* weighting_names[] = { "area", "angle" };
+
+    printf("%zu vertices, %zu faces, best of %d runs\n",
+           initial.md_vertices.size(), initial.md_indices.size() / 3, run_count);
+
+    bool passed = true;
+
+    mesh_data_t scatter(initial);
+    double scatter_ms = 1.0e30;
+    for (int run = 0; run < run_count; ++run) {
+        const auto start = std::chrono::steady_clock::now();
+        plain_scatter_normals(&scatter);
+        scatter_ms = std::min(scatter_ms, elapsed_ms(start));
+    }
+    printf("    plain scatter loop (area)  %9.3f ms\n", scatter_ms);
+
+    for (int w = 0; w < 2; ++w) {
+        mesh_data_t serial(initial);
+        mesh_data_t parallel(initial);
+        double serial_ms = 1.0e30;
+        double parallel_ms = 1.0e30;
+        double tangent_serial_ms = 1.0e30;
+        double tangent_parallel_ms = 1.0e30;
+
+        for (int run = 0; run < run_count; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            compute_normals(&serial, weightings[w], nullptr);
+            serial_ms = std::min(serial_ms, elapsed_ms(start));
+
+            start = std::chrono::steady_clock::now();
+            compute_normals(&parallel, weightings[w], &jobs);
+            parallel_ms = std::min(parallel_ms, elapsed_ms(start));
+
+            start = std::chrono::steady_clock::now();
+            compute_tangents(&serial, nullptr);
+            tangent_serial_ms = std::min(tangent_serial_ms, elapsed_ms(start));
+
+            start = std::chrono::steady_clock::now();
+            compute_tangents(&parallel, &jobs);
+            tangent_parallel_ms = std::min(tangent_parallel_ms, elapsed_ms(start));
+        }
+
+        const std::vector<dvec3> ref_normals =
+            reference_normals(initial, weightings[w] == v8::math::Normal_Weight_Angle);
+        const std::vector<dvec3> ref_tangents = reference_tangents(initial, ref_normals);
+        const double normal_error = max_error(serial, &vertex_pntt::vt_normal, ref_normals);
+        const double tangent_error = max_error(serial, &vertex_pntt::vt_tangent, ref_tangents);
+        const bool identical = same_bits(serial, parallel);
+
+        printf("    %-5s normals   serial  %9.3f ms, %u threads %9.3f ms, "
+               "max error %.2e\n", weighting_names[w], serial_ms,
+               jobs.get_thread_count(), parallel_ms, normal_error);
+        printf("    %-5s tangents  serial  %9.3f ms, %u threads %9.3f ms, "
+               "max error %.2e\n", weighting_names[w], tangent_serial_ms,
+               jobs.get_thread_count(), tangent_parallel_ms, tangent_error);
+
+        if (normal_error > C_Max_Normal_Error || tangent_error > C_Max_Tangent_Error) {
+            printf("    MISMATCH against the double precision reference\n");
+            passed = false;
+        }
+        if (!identical) {
+            printf("    MISMATCH between the serial and the %u thread results\n",
+                   jobs.get_thread_count());
+            passed = false;
+        }
+    }
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
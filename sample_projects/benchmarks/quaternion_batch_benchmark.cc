@@ -0,0 +1,327 @@
+///
+/// \file   quaternion_batch_benchmark.cc
+/// \brief  Runs the SoA quaternion kernels (slerp exact and fast, nlerp,
+///         multiply, rotate, to matrix) on random unit quaternions and
+///         checks them against the scalar quaternion code, with slerp and
+///         nlerp evaluated in double precision. Times the kernels against an
+///         AoS loop over the scalar code.
+///         Usage : quaternion_batch_benchmark [element_count] [run_count]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/math/matrix3X3.hpp>
+#include <v8/math/matrix4X4.hpp>
+#include <v8/math/quaternion.hpp>
+#include <v8/math/quaternion_batch.hpp>
+#include <v8/math/vector3.hpp>
+
+namespace {
+
+using v8::math::matrix_3X3F;
+using v8::math::matrix_4X4F;
+using v8::math::quaternionD;
+using v8::math::quaternionF;
+using v8::math::vector3F;
+
+//
+// Error bounds documented in quaternion_batch.hpp, with some headroom.
+const double C_Max_Slerp_Exact_Error = 1.0e-6;
+const double C_Max_Slerp_Fast_Error = 5.0e-5;
+const double C_Max_Float_Error = 2.0e-6;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+///
+/// \brief  Quaternion arrays, in both layouts.
+struct quaternion_arrays {
+    std::vector<quaternionF>    qa_aos;
+    std::vector<float>          qa_w;
+    std::vector<float>          qa_x;
+    std::vector<float>          qa_y;
+    std::vector<float>          qa_z;
+
+    explicit quaternion_arrays(v8_size_t count)
+        : qa_aos(count), qa_w(count), qa_x(count), qa_y(count), qa_z(count) {}
+
+    void set(v8_size_t i, const quaternionF& q) {
+        qa_aos[i] = q;
+        qa_w[i] = q.w_;
+        qa_x[i] = q.x_;
+        qa_y[i] = q.y_;
+        qa_z[i] = q.z_;
+    }
+
+    quaternionF soa_at(v8_size_t i) const {
+        return quaternionF(qa_w[i], qa_x[i], qa_y[i], qa_z[i]);
+    }
+
+    v8::math::const_quaternion_soa_t in() const {
+        return v8::math::const_quaternion_soa_t(
+            &qa_w[0], &qa_x[0], &qa_y[0], &qa_z[0]);
+    }
+
+    v8::math::quaternion_soa_t out() {
+        const v8::math::quaternion_soa_t soa = {
+            &qa_w[0], &qa_x[0], &qa_y[0], &qa_z[0]
+        };
+        return soa;
+    }
+};
+
+quaternionF random_unit_quaternion(std::mt19937& rng) {
+    std::normal_distribution<float> gauss(0.0f, 1.0f);
+    quaternionF q(gauss(rng), gauss(rng), gauss(rng), gauss(rng));
+    return q.normalize();
+}
+
+///
+/// \brief  Pairs of unit quaternions. One pair in four is almost parallel,
+///         one in eight points to opposite hemispheres, so the nlerp
+///         fallback and the shortest arc flip are both exercised.
+void make_pairs(v8_size_t count, quaternion_arrays* a, quaternion_arrays* b,
+                std::vector<float>* t) {
+    std::mt19937 rng(14);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::uniform_real_distribution<float> nudge(-0.02f, 0.02f);
+
+    for (v8_size_t i = 0; i < count; ++i) {
+        const quaternionF qa = random_unit_quaternion(rng);
+        quaternionF qb = random_unit_quaternion(rng);
+        if (i % 4 == 0) {
+            qb = quaternionF(qa.w_ + nudge(rng), qa.x_ + nudge(rng),
+                             qa.y_ + nudge(rng), qa.z_ + nudge(rng));
+            qb.normalize();
+        }
+        if (i % 8 == 1)
+            qb = -qb;
+
+        a->set(i, qa);
+        b->set(i, qb);
+        (*t)[i] = unit(rng);
+    }
+}
+
+quaternionD to_double(const quaternionF& q) {
+    return quaternionD(q.w_, q.x_, q.y_, q.z_);
+}
+
+double distance(const quaternionF& q, const quaternionD& reference) {
+    return std::max(
+        std::max(std::fabs(q.w_ - reference.w_), std::fabs(q.x_ - reference.x_)),
+        std::max(std::fabs(q.y_ - reference.y_), std::fabs(q.z_ - reference.z_)));
+}
+
+double distance(const quaternionF& q, const quaternionF& reference) {
+    return distance(q, to_double(reference));
+}
+
+void print_timing(const char* name, double scalar_ms, double batch_ms,
+                  v8_size_t count) {
+    const double to_ns = 1.0e6 / static_cast<double>(count);
+    printf("    %-20s %8.2f ns  %8.2f ns   x%.2f\n", name, scalar_ms * to_ns,
+           batch_ms * to_ns, scalar_ms / batch_ms);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const v8_size_t count = argc > 1
+        ? static_cast<v8_size_t>(std::strtoul(argv[1], nullptr, 10)) : 1000000;
+    const int run_count = argc > 2
+        ? static_cast<int>(std::strtoul(argv[2], nullptr, 10)) : 10;
+
+    if (count < 1 || run_count < 1) {
+        printf("element count and run count must be at least 1\n");
+        return EXIT_FAILURE;
+    }
+
+    quaternion_arrays a(count);
+    quaternion_arrays b(count);
+    std::vector<float> t(count);
+    make_pairs(count, &a, &b, &t);
+
+    std::vector<float> vx(count), vy(count), vz(count);
+    std::vector<vector3F> vectors(count);
+    {
+        std::mt19937 rng(15);
+        std::uniform_real_distribution<float> coord(-1.0f, 1.0f);
+        for (v8_size_t i = 0; i < count; ++i) {
+            vectors[i] = vector3F(coord(rng), coord(rng), coord(rng));
+            vx[i] = vectors[i].x_;
+            vy[i] = vectors[i].y_;
+            vz[i] = vectors[i].z_;
+        }
+    }
+
+    quaternion_arrays scalar_out(count);
+    quaternion_arrays batch_out(count);
+    std::vector<matrix_4X4F> scalar_matrices(count);
+    std::vector<matrix_3X3F> batch_matrices(count);
+    std::vector<vector3F> scalar_vectors(count);
+    std::vector<float> rx(count), ry(count), rz(count);
+    const v8::math::const_vector3_soa_t v_in(&vx[0], &vy[0], &vz[0]);
+    const v8::math::vector3_soa_t v_out = { &rx[0], &ry[0], &rz[0] };
+
+    enum {
+        k_slerp_exact, k_slerp_fast, k_nlerp, k_multiply, k_rotate, k_to_matrix,
+        k_kernel_count
+    };
+    const char* names[k_kernel_count] = {
+        "slerp (exact)", "slerp (fast)", "nlerp", "multiply", "rotate vector",
+        "to matrix"
+    };
+    double scalar_ms[k_kernel_count];
+    double batch_ms[k_kernel_count];
+    double max_error[k_kernel_count];
+    std::fill(scalar_ms, scalar_ms + k_kernel_count, 1.0e30);
+    std::fill(batch_ms, batch_ms + k_kernel_count, 1.0e30);
+    std::fill(max_error, max_error + k_kernel_count, 0.0);
+
+    for (int run = 0; run < run_count; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (v8_size_t i = 0; i < count; ++i)
+            scalar_out.qa_aos[i] = v8::math::slerp(a.qa_aos[i], b.qa_aos[i], t[i]);
+        scalar_ms[k_slerp_exact] = std::min(scalar_ms[k_slerp_exact], elapsed_ms(start));
+        scalar_ms[k_slerp_fast] = scalar_ms[k_slerp_exact];
+
+        start = std::chrono::steady_clock::now();
+        v8::math::quaternion_slerp_batch(a.in(), b.in(), &t[0], batch_out.out(),
+                                         count, v8::math::Slerp_Mode_Exact);
+        batch_ms[k_slerp_exact] = std::min(batch_ms[k_slerp_exact], elapsed_ms(start));
+
+        if (run == 0) {
+            for (v8_size_t i = 0; i < count; ++i) {
+                const quaternionD expected = v8::math::slerp(
+                    to_double(a.qa_aos[i]), to_double(b.qa_aos[i]),
+                    static_cast<double>(t[i]));
+                max_error[k_slerp_exact] = std::max(
+                    max_error[k_slerp_exact], distance(batch_out.soa_at(i), expected));
+            }
+        }
+
+        start = std::chrono::steady_clock::now();
+        v8::math::quaternion_slerp_batch(a.in(), b.in(), &t[0], batch_out.out(),
+                                         count, v8::math::Slerp_Mode_Fast);
+        batch_ms[k_slerp_fast] = std::min(batch_ms[k_slerp_fast], elapsed_ms(start));
+
+        if (run == 0) {
+            for (v8_size_t i = 0; i < count; ++i) {
+                const quaternionD expected = v8::math::slerp(
+                    to_double(a.qa_aos[i]), to_double(b.qa_aos[i]),
+                    static_cast<double>(t[i]));
+                max_error[k_slerp_fast] = std::max(
+                    max_error[k_slerp_fast], distance(batch_out.soa_at(i), expected));
+            }
+        }
+
+        start = std::chrono::steady_clock::now();
+        for (v8_size_t i = 0; i < count; ++i)
+            scalar_out.qa_aos[i] = v8::math::nlerp(a.qa_aos[i], b.qa_aos[i], t[i]);
+        scalar_ms[k_nlerp] = std::min(scalar_ms[k_nlerp], elapsed_ms(start));
+
+        start = std::chrono::steady_clock::now();
+        v8::math::quaternion_nlerp_batch(a.in(), b.in(), &t[0], batch_out.out(), count);
+        batch_ms[k_nlerp] = std::min(batch_ms[k_nlerp], elapsed_ms(start));
+
+        if (run == 0) {
+            for (v8_size_t i = 0; i < count; ++i) {
+                const quaternionD expected = v8::math::nlerp(
+                    to_double(a.qa_aos[i]), to_double(b.qa_aos[i]),
+                    static_cast<double>(t[i]));
+                max_error[k_nlerp] = std::max(
+                    max_error[k_nlerp], distance(batch_out.soa_at(i), expected));
+            }
+        }
+
+        start = std::chrono::steady_clock::now();
+        for (v8_size_t i = 0; i < count; ++i)
+            scalar_out.qa_aos[i] = a.qa_aos[i] * b.qa_aos[i];
+        scalar_ms[k_multiply] = std::min(scalar_ms[k_multiply], elapsed_ms(start));
+
+        start = std::chrono::steady_clock::now();
+        v8::math::quaternion_multiply_batch(a.in(), b.in(), batch_out.out(), count);
+        batch_ms[k_multiply] = std::min(batch_ms[k_multiply], elapsed_ms(start));
+
+        if (run == 0) {
+            for (v8_size_t i = 0; i < count; ++i) {
+                max_error[k_multiply] = std::max(
+                    max_error[k_multiply],
+                    distance(batch_out.soa_at(i), scalar_out.qa_aos[i]));
+            }
+        }
+
+        start = std::chrono::steady_clock::now();
+        for (v8_size_t i = 0; i < count; ++i) {
+            scalar_vectors[i] = vectors[i];
+            a.qa_aos[i].rotate_vector(&scalar_vectors[i]);
+        }
+        scalar_ms[k_rotate] = std::min(scalar_ms[k_rotate], elapsed_ms(start));
+
+        start = std::chrono::steady_clock::now();
+        v8::math::quaternion_rotate_batch(a.in(), v_in, v_out, count);
+        batch_ms[k_rotate] = std::min(batch_ms[k_rotate], elapsed_ms(start));
+
+        if (run == 0) {
+            for (v8_size_t i = 0; i < count; ++i) {
+                const double error = std::max(
+                    std::max(std::fabs(rx[i] - scalar_vectors[i].x_),
+                             std::fabs(ry[i] - scalar_vectors[i].y_)),
+                    std::fabs(rz[i] - scalar_vectors[i].z_));
+                max_error[k_rotate] = std::max(max_error[k_rotate], error);
+            }
+        }
+
+        start = std::chrono::steady_clock::now();
+        for (v8_size_t i = 0; i < count; ++i)
+            a.qa_aos[i].extract_rotation_matrix(&scalar_matrices[i]);
+        scalar_ms[k_to_matrix] = std::min(scalar_ms[k_to_matrix], elapsed_ms(start));
+
+        start = std::chrono::steady_clock::now();
+        v8::math::quaternion_to_matrix_batch(a.in(), &batch_matrices[0], count);
+        batch_ms[k_to_matrix] = std::min(batch_ms[k_to_matrix], elapsed_ms(start));
+
+        if (run == 0) {
+            for (v8_size_t i = 0; i < count; ++i) {
+                for (int row = 0; row < 3; ++row) {
+                    for (int col = 0; col < 3; ++col) {
+                        const double error = std::fabs(
+                            batch_matrices[i].elements_[row * 3 + col]
+                            - scalar_matrices[i].elements_[row * 4 + col]);
+                        max_error[k_to_matrix] = std::max(max_error[k_to_matrix], error);
+                    }
+                }
+            }
+        }
+    }
+
+    printf("%zu elements, best of %d runs, per element\n", count, run_count);
+    printf("    kernel               scalar AoS     batch SoA\n");
+    for (int k = 0; k < k_kernel_count; ++k)
+        print_timing(names[k], scalar_ms[k], batch_ms[k], count);
+
+    const double limits[k_kernel_count] = {
+        C_Max_Slerp_Exact_Error, C_Max_Slerp_Fast_Error, C_Max_Float_Error,
+        C_Max_Float_Error, C_Max_Float_Error, C_Max_Float_Error
+    };
+
+    bool passed = true;
+    printf("    max error per component\n");
+    for (int k = 0; k < k_kernel_count; ++k) {
+        const bool kernel_passed = max_error[k] <= limits[k];
+        passed = passed && kernel_passed;
+        printf("    %-20s %.2e (limit %.1e)%s\n", names[k], max_error[k], limits[k],
+               kernel_passed ? "" : "  MISMATCH");
+    }
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,131 @@
+///
+/// \file   radix_sort_benchmark.cc
+/// \brief  Sorts draw keys (a few techniques and materials, random depths,
+///         one object in five translucent) with base::radix_sort and checks
+///         the order against std::stable_sort, then times both and
+///         std::sort.
+///         Usage : radix_sort_benchmark [key_count] [run_count]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/base/radix_sort.hpp>
+#include <v8/scene/draw_key.hpp>
+
+namespace {
+
+using v8::scene::draw_key;
+
+const v8_uint32_t C_Technique_Count = 24;
+const v8_uint32_t C_Material_Count = 400;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+///
+/// \brief  A visible entity, as sorted by scene_system::depth_sort_all.
+struct draw_item_t {
+    v8_uint64_t di_key;
+    v8_uint32_t di_entity;
+};
+
+struct key_of {
+    v8_uint64_t operator()(const draw_item_t& item) const {
+        return item.di_key;
+    }
+};
+
+bool key_less(const draw_item_t& lhs, const draw_item_t& rhs) {
+    return lhs.di_key < rhs.di_key;
+}
+
+std::vector<draw_item_t> make_items(v8_size_t count) {
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<v8_uint32_t> technique(0, C_Technique_Count - 1);
+    std::uniform_int_distribution<v8_uint32_t> material(0, C_Material_Count - 1);
+    std::uniform_real_distribution<float> depth(1.0f, 1000.0f);
+    std::uniform_int_distribution<v8_uint32_t> translucent(0, 4);
+
+    std::vector<draw_item_t> items(count);
+    for (v8_size_t i = 0; i < count; ++i) {
+        const v8_uint32_t quantized =
+            draw_key::quantize_depth(depth(rng), 1.0f, 1000.0f);
+        items[i].di_key = translucent(rng)
+            ? draw_key::make_opaque(technique(rng), material(rng), quantized)
+            : draw_key::make_translucent(technique(rng), material(rng), quantized);
+        items[i].di_entity = static_cast<v8_uint32_t>(i);
+    }
+
+    return items;
+}
+
+bool same_order(const std::vector<draw_item_t>& lhs,
+                const std::vector<draw_item_t>& rhs) {
+    for (v8_size_t i = 0; i < lhs.size(); ++i) {
+        if (lhs[i].di_key != rhs[i].di_key || lhs[i].di_entity != rhs[i].di_entity)
+            return false;
+    }
+    return true;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const v8_size_t key_count = argc > 1
+        ? static_cast<v8_size_t>(std::strtoul(argv[1], nullptr, 10)) : 100000;
+    const int run_count = argc > 2
+        ? static_cast<int>(std::strtoul(argv[2], nullptr, 10)) : 20;
+
+    if (key_count < 2 || run_count < 1) {
+        printf("key count must be at least 2, run count at least 1\n");
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<draw_item_t> items = make_items(key_count);
+    std::vector<draw_item_t> scratch(key_count);
+
+    double radix_ms = 1.0e30;
+    double sort_ms = 1.0e30;
+    double stable_sort_ms = 1.0e30;
+    bool passed = true;
+
+    for (int run = 0; run < run_count; ++run) {
+        std::vector<draw_item_t> reference(items);
+        auto start = std::chrono::steady_clock::now();
+        std::stable_sort(reference.begin(), reference.end(), key_less);
+        stable_sort_ms = std::min(stable_sort_ms, elapsed_ms(start));
+
+        std::vector<draw_item_t> unstable(items);
+        start = std::chrono::steady_clock::now();
+        std::sort(unstable.begin(), unstable.end(), key_less);
+        sort_ms = std::min(sort_ms, elapsed_ms(start));
+
+        std::vector<draw_item_t> radix(items);
+        start = std::chrono::steady_clock::now();
+        v8::base::radix_sort(&radix[0], &radix[0] + key_count, &scratch[0],
+                             key_of());
+        radix_ms = std::min(radix_ms, elapsed_ms(start));
+
+        passed = passed && same_order(radix, reference);
+    }
+
+    printf("%zu draw keys, %u techniques, %u materials, best of %d runs\n",
+           key_count, C_Technique_Count, C_Material_Count, run_count);
+    printf("    base::radix_sort     %8.3f ms\n", radix_ms);
+    printf("    std::sort            %8.3f ms\n", sort_ms);
+    printf("    std::stable_sort     %8.3f ms\n", stable_sort_ms);
+
+    if (!passed) {
+        printf("    MISMATCH between radix_sort and std::stable_sort\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,154 @@
+///
+/// \file   random_benchmark.cc
+/// \brief  Checks the random engines against published outputs (MT19937
+///         seeded with 5489, PCG32 seeded with 42 on stream 54), checks that
+///         pcg32 advance() matches stepping and that fill() matches
+///         next_float(), then reports the throughput of each engine.
+///         Usage : random_benchmark [number_count] [run_count]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/math/random/random.hpp>
+
+namespace {
+
+const v8_uint32_t C_Pcg32_Reference[] = {
+    0xA15C02B7U, 0x7B47F409U, 0xBA1D3330U, 0x83D2F293U, 0xBFA4784BU, 0xCBED606EU
+};
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+///
+/// \brief  MTRand_int32 against std::mt19937, which the standard requires
+///         to return 4123659995 as its 10000th number.
+bool check_mt19937() {
+    MTRand_int32 mt(5489UL);
+    std::mt19937 reference;
+
+    for (int i = 0; i < 10000; ++i) {
+        if (static_cast<v8_uint32_t>(mt()) != reference())
+            return false;
+    }
+
+    MTRand_int32 first(5489UL);
+    return static_cast<v8_uint32_t>(first()) == 3499211612U;
+}
+
+bool check_pcg32() {
+    v8::math::pcg32_engine pcg(42, 54);
+    for (v8_uint32_t expected : C_Pcg32_Reference) {
+        if (pcg.next_uint32() != expected)
+            return false;
+    }
+
+    const v8_uint64_t steps[] = { 0, 1, 7, 1000, 123457 };
+    for (v8_uint64_t step_count : steps) {
+        v8::math::pcg32_engine stepped(42, 54);
+        for (v8_uint64_t i = 0; i < step_count; ++i)
+            stepped.next_uint32();
+
+        v8::math::pcg32_engine advanced(42, 54);
+        advanced.advance(step_count);
+
+        for (int i = 0; i < 16; ++i) {
+            if (stepped.next_uint32() != advanced.next_uint32())
+                return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename generator_type>
+bool check_fill(const char* name) {
+    //
+    // Odd count, so the scalar tail of fill() runs too.
+    const v8_size_t count = 1001;
+    std::vector<float> filled(count);
+
+    generator_type fill_rng(7);
+    fill_rng.fill(&filled[0], count);
+
+    generator_type step_rng(7);
+    for (v8_size_t i = 0; i < count; ++i) {
+        const float expected = step_rng.next_float();
+        if (filled[i] != expected || expected >= 1.0f) {
+            printf("    MISMATCH %s fill()[%zu] %.9g != next_float() %.9g\n",
+                   name, i, filled[i], expected);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename generator_type>
+void time_generator(const char* name, v8_size_t count, int run_count) {
+    std::vector<v8_uint32_t> bits(count);
+    std::vector<float> floats(count);
+    generator_type rng(11);
+
+    double next_ms = 1.0e30;
+    double fill_ms = 1.0e30;
+    v8_uint32_t sink = 0;
+
+    for (int run = 0; run < run_count; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (v8_size_t i = 0; i < count; ++i)
+            bits[i] = rng.next();
+        next_ms = std::min(next_ms, elapsed_ms(start));
+        sink ^= bits[count - 1];
+
+        start = std::chrono::steady_clock::now();
+        rng.fill(&floats[0], count);
+        fill_ms = std::min(fill_ms, elapsed_ms(start));
+        sink ^= static_cast<v8_uint32_t>(floats[count - 1] * 1024.0f);
+    }
+
+    printf("    %-16s next() %8.1f M/s    fill(float) %8.1f M/s  (%08x)\n",
+           name, count / (next_ms * 1000.0), count / (fill_ms * 1000.0), sink);
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const v8_size_t number_count = argc > 1
+        ? static_cast<v8_size_t>(std::strtoul(argv[1], nullptr, 10)) : 1000000;
+    const int run_count = argc > 2
+        ? static_cast<int>(std::strtoul(argv[2], nullptr, 10)) : 20;
+
+    if (number_count < 1 || run_count < 1) {
+        printf("number count and run count must be at least 1\n");
+        return EXIT_FAILURE;
+    }
+
+    bool passed = true;
+    if (!check_mt19937()) {
+        printf("    MISMATCH MTRand_int32 against the MT19937 reference\n");
+        passed = false;
+    }
+    if (!check_pcg32()) {
+        printf("    MISMATCH pcg32_engine against the PCG32 reference\n");
+        passed = false;
+    }
+    passed = check_fill<v8::math::random>("random") && passed;
+    passed = check_fill<v8::math::random_xoshiro>("random_xoshiro") && passed;
+    passed = check_fill<v8::math::random_pcg>("random_pcg") && passed;
+
+    printf("%zu numbers, best of %d runs\n", number_count, run_count);
+    time_generator<v8::math::random>("mt19937", number_count, run_count);
+    time_generator<v8::math::random_xoshiro>("xoshiro256**", number_count,
+                                             run_count);
+    time_generator<v8::math::random_pcg>("pcg32", number_count, run_count);
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,257 @@
+///
+/// \file   sweep_and_prune_benchmark.cc
+/// \brief  Moves 10k and 100k boxes through a sweep_and_prune broadphase,
+///         coherently (all of them at two speeds, then one box in ten) and
+///         randomly (every box teleported each frame), and times update().
+///         The pairs tracked through the added/removed lists are checked
+///         against a sort and sweep reference.
+///         Usage : sweep_and_prune_benchmark [max_box_count] [frame_count]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <set>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/math/objects/axis_aligned_bounding_box3.hpp>
+#include <v8/math/spatial/sweep_and_prune.hpp>
+
+namespace {
+
+using v8::math::aabb3F;
+using v8::math::proxy_pair_t;
+using v8::math::sweep_and_prune;
+using v8::math::vector3F;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+v8_uint64_t make_key(v8_int32_t proxy1, v8_int32_t proxy2) {
+    return (static_cast<v8_uint64_t>(proxy1) << 32)
+           | static_cast<v8_uint32_t>(proxy2);
+}
+
+///
+/// \brief  Boxes of 1 to 4 units, scattered with a constant density in a
+///         cube that grows with the count (as in aabb_tree_benchmark).
+struct scene_t {
+    std::vector<vector3F>   sc_centers;
+    std::vector<vector3F>   sc_velocities;
+    std::vector<float>      sc_half_sizes;
+    float                   sc_world_size;
+
+    aabb3F get_box(v8_size_t i) const {
+        const vector3F extents(sc_half_sizes[i], sc_half_sizes[i],
+                               sc_half_sizes[i]);
+        return aabb3F(sc_centers[i] - extents, sc_centers[i] + extents);
+    }
+};
+
+void make_scene(v8_size_t count, float speed, std::mt19937* rng,
+                scene_t* scene) {
+    scene->sc_world_size =
+        200.0f * std::cbrt(static_cast<float>(count) / 10000.0f);
+
+    std::uniform_real_distribution<float> coord(0.0f, scene->sc_world_size);
+    std::uniform_real_distribution<float> half_size(0.5f, 2.0f);
+    std::normal_distribution<float> direction(0.0f, 1.0f);
+
+    scene->sc_centers.resize(count);
+    scene->sc_velocities.resize(count);
+    scene->sc_half_sizes.resize(count);
+
+    for (v8_size_t i = 0; i < count; ++i) {
+        scene->sc_centers[i] = vector3F(coord(*rng), coord(*rng), coord(*rng));
+        scene->sc_half_sizes[i] = half_size(*rng);
+
+        vector3F dir(direction(*rng), direction(*rng), direction(*rng));
+        dir.normalize();
+        scene->sc_velocities[i] = dir * speed;
+    }
+}
+
+///
+/// \brief  Coherent motion : every moving_every-th box moves along its
+///         direction and bounces off the sides of the world.
+void move_coherent(scene_t* scene, v8_size_t moving_every) {
+    for (v8_size_t i = 0; i < scene->sc_centers.size(); i += moving_every) {
+        vector3F& center = scene->sc_centers[i];
+        vector3F& velocity = scene->sc_velocities[i];
+        center += velocity;
+
+        for (int axis = 0; axis < 3; ++axis) {
+            if (center.elements_[axis] < 0.0f
+                || center.elements_[axis] > scene->sc_world_size)
+                velocity.elements_[axis] = -velocity.elements_[axis];
+        }
+    }
+}
+
+void move_random(scene_t* scene, std::mt19937* rng) {
+    std::uniform_real_distribution<float> coord(0.0f, scene->sc_world_size);
+    for (v8_size_t i = 0; i < scene->sc_centers.size(); ++i)
+        scene->sc_centers[i] = vector3F(coord(*rng), coord(*rng), coord(*rng));
+}
+
+///
+/// \brief  Reference : boxes sorted on min x, each tested against the
+///         following boxes until their min x passes its max x.
+std::vector<v8_uint64_t> reference_pairs(const scene_t& scene,
+                                         const std::vector<v8_int32_t>& ids) {
+    const v8_size_t count = scene.sc_centers.size();
+    std::vector<aabb3F> boxes(count);
+    std::vector<v8_size_t> order(count);
+    for (v8_size_t i = 0; i < count; ++i) {
+        boxes[i] = scene.get_box(i);
+        order[i] = i;
+    }
+
+    std::sort(order.begin(), order.end(), [&](v8_size_t lhs, v8_size_t rhs) {
+        return boxes[lhs].min_point_.x_ < boxes[rhs].min_point_.x_;
+    });
+
+    std::vector<v8_uint64_t> pairs;
+    for (v8_size_t i = 0; i < count; ++i) {
+        const aabb3F& a = boxes[order[i]];
+        for (v8_size_t j = i + 1; j < count; ++j) {
+            const aabb3F& b = boxes[order[j]];
+            if (b.min_point_.x_ > a.max_point_.x_)
+                break;
+
+            if (b.min_point_.y_ <= a.max_point_.y_
+                && a.min_point_.y_ <= b.max_point_.y_
+                && b.min_point_.z_ <= a.max_point_.z_
+                && a.min_point_.z_ <= b.max_point_.z_) {
+                const v8_int32_t id1 = ids[order[i]];
+                const v8_int32_t id2 = ids[order[j]];
+                pairs.push_back(id1 < id2
+                    ? make_key(id1, id2) : make_key(id2, id1));
+            }
+        }
+    }
+
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+enum Motion_Type {
+    Motion_Coherent,
+    Motion_Random
+};
+
+bool run_benchmark(v8_size_t count, v8_size_t frame_count,
+                   Motion_Type motion, float speed, v8_size_t moving_every) {
+    std::mt19937 rng(1357);
+    scene_t scene;
+    make_scene(count, speed, &rng, &scene);
+
+    sweep_and_prune broadphase;
+    std::vector<v8_int32_t> ids(count);
+    for (v8_size_t i = 0; i < count; ++i)
+        ids[i] = broadphase.insert_proxy(scene.get_box(i), nullptr);
+    broadphase.update();
+
+    //
+    // Pairs tracked from the added and removed lists.
+    std::set<v8_uint64_t> tracked;
+    const std::vector<proxy_pair_t>& initial = broadphase.get_added_pairs();
+    for (v8_size_t i = 0; i < initial.size(); ++i)
+        tracked.insert(make_key(initial[i].pp_proxy1, initial[i].pp_proxy2));
+
+    double update_ms = 0.0;
+    double worst_ms = 0.0;
+    v8_size_t resorted = 0;
+    bool lists_valid = true;
+
+    for (v8_size_t frame = 0; frame < frame_count; ++frame) {
+        if (motion == Motion_Coherent)
+            move_coherent(&scene, moving_every);
+        else
+            move_random(&scene, &rng);
+
+        for (v8_size_t i = 0; i < count; i += moving_every)
+            broadphase.move_proxy(ids[i], scene.get_box(i));
+
+        const auto start = std::chrono::steady_clock::now();
+        broadphase.update();
+        const double frame_ms = elapsed_ms(start);
+        update_ms += frame_ms;
+        worst_ms = std::max(worst_ms, frame_ms);
+        resorted += broadphase.was_sorted_from_scratch();
+
+        const std::vector<proxy_pair_t>& removed =
+            broadphase.get_removed_pairs();
+        for (v8_size_t i = 0; i < removed.size(); ++i) {
+            lists_valid = tracked.erase(
+                make_key(removed[i].pp_proxy1, removed[i].pp_proxy2))
+                && lists_valid;
+        }
+
+        const std::vector<proxy_pair_t>& added = broadphase.get_added_pairs();
+        for (v8_size_t i = 0; i < added.size(); ++i) {
+            lists_valid = tracked.insert(
+                make_key(added[i].pp_proxy1, added[i].pp_proxy2)).second
+                && lists_valid;
+        }
+    }
+
+    const std::vector<v8_uint64_t> reference = reference_pairs(scene, ids);
+    const bool pairs_match = lists_valid
+        && broadphase.get_pair_count() == reference.size()
+        && std::equal(reference.begin(), reference.end(), tracked.begin())
+        && tracked.size() == reference.size();
+
+    if (motion == Motion_Coherent) {
+        printf("%8zu boxes, coherent motion, %.3f units per frame, "
+               "one box in %zu moving\n", count, speed, moving_every);
+    } else {
+        printf("%8zu boxes, random motion\n", count);
+    }
+    printf("    update  %8.3f ms/frame (worst %.3f ms), %zu of %zu updates "
+           "sorted the boxes from scratch, %zu pairs\n",
+           update_ms / static_cast<double>(frame_count), worst_ms,
+           resorted, frame_count, reference.size());
+
+    if (!pairs_match) {
+        printf("    MISMATCH : %zu pairs tracked, %zu reported, %zu in the "
+               "reference\n", tracked.size(), broadphase.get_pair_count(),
+               reference.size());
+        return false;
+    }
+
+    return true;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const v8_size_t max_count = argc > 1
+        ? static_cast<v8_size_t>(std::strtoul(argv[1], nullptr, 10)) : 100000;
+    const v8_size_t frame_count = argc > 2
+        ? static_cast<v8_size_t>(std::strtoul(argv[2], nullptr, 10)) : 100;
+
+    if (!frame_count) {
+        printf("frame count must not be zero\n");
+        return EXIT_FAILURE;
+    }
+
+    bool passed = true;
+    for (v8_size_t count = 10000; count <= max_count; count *= 10) {
+        passed = run_benchmark(count, frame_count, Motion_Coherent, 0.01f, 1)
+                 && passed;
+        passed = run_benchmark(count, frame_count, Motion_Coherent, 0.002f, 1)
+                 && passed;
+        passed = run_benchmark(count, frame_count, Motion_Coherent, 0.01f, 10)
+                 && passed;
+        passed = run_benchmark(count, frame_count, Motion_Random, 0.0f, 1)
+                 && passed;
+    }
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,264 @@
+///
+/// \file   transform_batch_benchmark.cc
+/// \brief  Transforms points with affine_transform_strided (packed, inside
+///         a vertex buffer, translation only) and affine_transform_soa, and
+///         checks that every result is bit identical to a plain scalar loop,
+///         with and without a job system. Times the batch functions against
+///         the plain loops.
+///         Usage : transform_batch_benchmark [point_count] [run_count]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/base/job_system.hpp>
+#include <v8/math/geometry_generators.hpp>
+#include <v8/math/matrix3X3.hpp>
+#include <v8/math/transform_batch.hpp>
+#include <v8/math/vector3.hpp>
+
+namespace {
+
+using v8::math::matrix_3X3F;
+using v8::math::vector3F;
+using v8::math::geometry_gen::vertex_pntt;
+
+//
+// Every timing transforms at least this many points, repeating the batch.
+const v8_size_t C_Points_Per_Sample = 1 << 20;
+
+//
+// Batch used to check the job system path, above C_Transform_Batch_Grain.
+const v8_size_t C_Job_Check_Count = 4 * v8::math::C_Transform_Batch_Grain + 17;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+///
+/// \brief  Rotation about an oblique axis with a non uniform scale.
+matrix_3X3F make_linear() {
+    return matrix_3X3F(
+         0.8660f, -0.2500f,  0.4330f,
+         0.5000f,  0.4330f, -0.7500f,
+         0.0000f,  1.3000f,  0.6500f);
+}
+
+std::vector<vector3F> make_points(v8_size_t count) {
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<float> coord(-100.0f, 100.0f);
+
+    std::vector<vector3F> points(count);
+    for (vector3F& point : points)
+        point = vector3F(coord(rng), coord(rng), coord(rng));
+    return points;
+}
+
+void plain_loop(const matrix_3X3F& m, const vector3F& t,
+                const vector3F* src, vector3F* dst, v8_size_t count) {
+    for (v8_size_t i = 0; i < count; ++i) {
+        const float x = src[i].x_;
+        const float y = src[i].y_;
+        const float z = src[i].z_;
+        dst[i].x_ = m.a11_ * x + m.a12_ * y + m.a13_ * z + t.x_;
+        dst[i].y_ = m.a21_ * x + m.a22_ * y + m.a23_ * z + t.y_;
+        dst[i].z_ = m.a31_ * x + m.a32_ * y + m.a33_ * z + t.z_;
+    }
+}
+
+void plain_loop_soa(const matrix_3X3F& m, const vector3F& t,
+                    const float* sx, const float* sy, const float* sz,
+                    float* dx, float* dy, float* dz, v8_size_t count) {
+    for (v8_size_t i = 0; i < count; ++i) {
+        const float x = sx[i];
+        const float y = sy[i];
+        const float z = sz[i];
+        dx[i] = m.a11_ * x + m.a12_ * y + m.a13_ * z + t.x_;
+        dy[i] = m.a21_ * x + m.a22_ * y + m.a23_ * z + t.y_;
+        dz[i] = m.a31_ * x + m.a32_ * y + m.a33_ * z + t.z_;
+    }
+}
+
+bool same_bits(const void* lhs, const void* rhs, v8_size_t bytes) {
+    return std::memcmp(lhs, rhs, bytes) == 0;
+}
+
+///
+/// \brief  Runs every batch variant on count points and compares it with
+///         the plain loop.
+bool check_batch(const matrix_3X3F& m, const vector3F& t,
+                 v8_size_t count, v8::base::job_system* jobs) {
+    const std::vector<vector3F> src = make_points(count);
+    std::vector<vector3F> expected(count);
+    plain_loop(m, t, &src[0], &expected[0], count);
+
+    bool passed = true;
+
+    std::vector<vector3F> packed(count);
+    v8::math::affine_transform_strided(m, t, &src[0], sizeof(vector3F),
+                                       &packed[0], sizeof(vector3F), count, jobs);
+    passed = passed && same_bits(&packed[0], &expected[0], count * sizeof(vector3F));
+
+    //
+    // In place, inside a vertex buffer.
+    std::vector<vertex_pntt> vertices(count);
+    for (v8_size_t i = 0; i < count; ++i)
+        vertices[i].vt_position = src[i];
+    v8::math::affine_transform_strided(
+        m, t, &vertices[0].vt_position, sizeof(vertex_pntt),
+        &vertices[0].vt_position, sizeof(vertex_pntt), count, jobs);
+    for (v8_size_t i = 0; i < count; ++i) {
+        passed = passed && same_bits(&vertices[i].vt_position, &expected[i],
+                                     sizeof(vector3F));
+    }
+
+    std::vector<float> sx(count), sy(count), sz(count);
+    for (v8_size_t i = 0; i < count; ++i) {
+        sx[i] = src[i].x_;
+        sy[i] = src[i].y_;
+        sz[i] = src[i].z_;
+    }
+    std::vector<float> dx(count), dy(count), dz(count);
+    v8::math::affine_transform_soa(m, t, &sx[0], &sy[0], &sz[0],
+                                   &dx[0], &dy[0], &dz[0], count, jobs);
+    for (v8_size_t i = 0; i < count; ++i) {
+        passed = passed && dx[i] == expected[i].x_ && dy[i] == expected[i].y_
+            && dz[i] == expected[i].z_;
+    }
+
+    //
+    // Translation only and identity take their own paths.
+    matrix_3X3F identity;
+    identity.make_identity();
+    std::vector<vector3F> translated(count);
+    std::vector<vector3F> expected_translated(count);
+    plain_loop(identity, t, &src[0], &expected_translated[0], count);
+    v8::math::affine_transform_strided(identity, t, &src[0], sizeof(vector3F),
+                                       &translated[0], sizeof(vector3F), count, jobs);
+    passed = passed && same_bits(&translated[0], &expected_translated[0],
+                                 count * sizeof(vector3F));
+
+    std::vector<vector3F> copied(count);
+    v8::math::affine_transform_strided(identity, vector3F(0.0f, 0.0f, 0.0f),
+                                       &src[0], sizeof(vector3F), &copied[0],
+                                       sizeof(vector3F), count, jobs);
+    passed = passed && same_bits(&copied[0], &src[0], count * sizeof(vector3F));
+
+    return passed;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const v8_size_t point_count = argc > 1
+        ? static_cast<v8_size_t>(std::strtoul(argv[1], nullptr, 10)) : 8192;
+    const int run_count = argc > 2
+        ? static_cast<int>(std::strtoul(argv[2], nullptr, 10)) : 20;
+
+    if (point_count < 1 || run_count < 1) {
+        printf("point count and run count must be at least 1\n");
+        return EXIT_FAILURE;
+    }
+
+    const matrix_3X3F m = make_linear();
+    const vector3F t(10.0f, -20.0f, 5.5f);
+    v8::base::job_system jobs(3);
+
+    bool passed = true;
+    //
+    // Odd counts exercise the scalar tails.
+    const v8_size_t check_counts[] = { 1, 3, 5, 7, 4099, point_count };
+    for (v8_size_t count : check_counts)
+        passed = check_batch(m, t, count, nullptr) && passed;
+    passed = check_batch(m, t, C_Job_Check_Count, &jobs) && passed;
+
+    const v8_size_t repeat = std::max<v8_size_t>(1, C_Points_Per_Sample / point_count);
+    const std::vector<vector3F> src = make_points(point_count);
+    std::vector<vector3F> dst(point_count);
+    std::vector<vertex_pntt> vertices(point_count);
+    std::vector<vertex_pntt> out_vertices(point_count);
+    std::vector<float> sx(point_count), sy(point_count), sz(point_count);
+    std::vector<float> dx(point_count), dy(point_count), dz(point_count);
+    for (v8_size_t i = 0; i < point_count; ++i) {
+        vertices[i].vt_position = src[i];
+        sx[i] = src[i].x_;
+        sy[i] = src[i].y_;
+        sz[i] = src[i].z_;
+    }
+
+    double plain_ms = 1.0e30;
+    double packed_ms = 1.0e30;
+    double translate_ms = 1.0e30;
+    double vertex_ms = 1.0e30;
+    double plain_soa_ms = 1.0e30;
+    double soa_ms = 1.0e30;
+
+    matrix_3X3F identity;
+    identity.make_identity();
+
+    for (int run = 0; run < run_count; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        for (v8_size_t r = 0; r < repeat; ++r)
+            plain_loop(m, t, &src[0], &dst[0], point_count);
+        plain_ms = std::min(plain_ms, elapsed_ms(start));
+
+        start = std::chrono::steady_clock::now();
+        for (v8_size_t r = 0; r < repeat; ++r) {
+            v8::math::affine_transform_strided(m, t, &src[0], sizeof(vector3F),
+                                               &dst[0], sizeof(vector3F), point_count);
+        }
+        packed_ms = std::min(packed_ms, elapsed_ms(start));
+
+        start = std::chrono::steady_clock::now();
+        for (v8_size_t r = 0; r < repeat; ++r) {
+            v8::math::affine_transform_strided(identity, t, &src[0], sizeof(vector3F),
+                                               &dst[0], sizeof(vector3F), point_count);
+        }
+        translate_ms = std::min(translate_ms, elapsed_ms(start));
+
+        start = std::chrono::steady_clock::now();
+        for (v8_size_t r = 0; r < repeat; ++r) {
+            v8::math::affine_transform_strided(
+                m, t, &vertices[0].vt_position, sizeof(vertex_pntt),
+                &out_vertices[0].vt_position, sizeof(vertex_pntt), point_count);
+        }
+        vertex_ms = std::min(vertex_ms, elapsed_ms(start));
+
+        start = std::chrono::steady_clock::now();
+        for (v8_size_t r = 0; r < repeat; ++r) {
+            plain_loop_soa(m, t, &sx[0], &sy[0], &sz[0], &dx[0], &dy[0], &dz[0],
+                           point_count);
+        }
+        plain_soa_ms = std::min(plain_soa_ms, elapsed_ms(start));
+
+        start = std::chrono::steady_clock::now();
+        for (v8_size_t r = 0; r < repeat; ++r) {
+            v8::math::affine_transform_soa(m, t, &sx[0], &sy[0], &sz[0],
+                                           &dx[0], &dy[0], &dz[0], point_count);
+        }
+        soa_ms = std::min(soa_ms, elapsed_ms(start));
+    }
+
+    const double points = static_cast<double>(point_count * repeat);
+    printf("%zu points x %zu batches, best of %d runs, M points/s\n",
+           point_count, repeat, run_count);
+    printf("    plain loop (packed)            %8.1f\n", points / (plain_ms * 1000.0));
+    printf("    affine_transform_strided       %8.1f\n", points / (packed_ms * 1000.0));
+    printf("      translation only             %8.1f\n", points / (translate_ms * 1000.0));
+    printf("      vertex_pntt stride           %8.1f\n", points / (vertex_ms * 1000.0));
+    printf("    plain loop (SoA)               %8.1f\n", points / (plain_soa_ms * 1000.0));
+    printf("    affine_transform_soa           %8.1f\n", points / (soa_ms * 1000.0));
+
+    if (!passed) {
+        printf("    MISMATCH between the batch transforms and the plain loop\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
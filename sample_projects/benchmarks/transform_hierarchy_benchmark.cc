@@ -0,0 +1,198 @@
+///
+/// \file   transform_hierarchy_benchmark.cc
+/// \brief  Updates the world transforms of a 100k node transform_hierarchy
+///         (a 4-ary tree) with 1% and with 100% of the nodes animated per
+///         frame, and compares against recomposing every node by walking a
+///         pointer based tree, the way group_node hierarchies were updated.
+///         Usage : transform_hierarchy_benchmark [node_count] [frame_count]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/math/matrix3X3.hpp>
+#include <v8/math/matrix4X4.hpp>
+#include <v8/math/transform.hpp>
+#include <v8/scene/transform_hierarchy.hpp>
+
+namespace {
+
+using v8::math::matrix_3X3F;
+using v8::math::matrix_4X4F;
+using v8::math::transformF;
+using v8::math::vector3F;
+using v8::scene::transform_hierarchy;
+
+const v8_size_t C_Children_Per_Node = 4;
+
+double elapsed_ms(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count();
+}
+
+transformF make_local_transform(float angle, const vector3F& offset,
+                                float scale) {
+    matrix_3X3F rotation;
+    rotation.make_rotation_xyz(angle, angle * 0.5f, angle * 0.25f);
+
+    transformF local(rotation);
+    local.set_translation_component(offset);
+    local.set_scale_component(scale);
+    return local;
+}
+
+///
+/// \brief  Pointer based node, as in a group_node tree.
+struct tree_node {
+    transformF                  tn_local;
+    transformF                  tn_world;
+    std::vector<tree_node*>     tn_children;
+};
+
+void compose_subtree(tree_node* node, const transformF* parent_world) {
+    node->tn_world = node->tn_local;
+    if (parent_world)
+        node->tn_world *= *parent_world;
+
+    for (v8_size_t i = 0; i < node->tn_children.size(); ++i)
+        compose_subtree(node->tn_children[i], &node->tn_world);
+}
+
+bool matrices_match(const matrix_4X4F& lhs, const matrix_4X4F& rhs) {
+    for (int i = 0; i < 16; ++i) {
+        const float diff = std::fabs(lhs.elements_[i] - rhs.elements_[i]);
+        if (diff > 1.0e-3f * (1.0f + std::fabs(rhs.elements_[i])))
+            return false;
+    }
+
+    return true;
+}
+
+struct animation_state {
+    std::vector<float>      as_angles;
+    std::vector<vector3F>   as_offsets;
+    std::vector<float>      as_scales;
+};
+
+bool run_benchmark(v8_size_t node_count, v8_size_t frame_count,
+                   v8_size_t animate_every) {
+    std::mt19937 rng(4321);
+    std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> scale(0.95f, 1.05f);
+
+    animation_state anim;
+    anim.as_angles.resize(node_count);
+    anim.as_offsets.resize(node_count);
+    anim.as_scales.resize(node_count);
+
+    for (v8_size_t i = 0; i < node_count; ++i) {
+        anim.as_angles[i] = unit(rng) * 3.14159265f;
+        anim.as_offsets[i] = vector3F(unit(rng), unit(rng), unit(rng));
+        anim.as_scales[i] = scale(rng);
+    }
+
+    //
+    // Node i is the child of node (i - 1) / C_Children_Per_Node, in both
+    // representations.
+    transform_hierarchy hierarchy;
+    hierarchy.reserve(node_count);
+    std::vector<transform_hierarchy::node_handle> handles(node_count);
+    std::vector<tree_node> tree(node_count);
+
+    for (v8_size_t i = 0; i < node_count; ++i) {
+        const transformF local(make_local_transform(
+            anim.as_angles[i], anim.as_offsets[i], anim.as_scales[i]));
+        const v8_size_t parent = (i - 1) / C_Children_Per_Node;
+
+        handles[i] = hierarchy.add_node(
+            i ? handles[parent] : transform_hierarchy::C_Null_Node, local);
+        tree[i].tn_local = local;
+        if (i)
+            tree[parent].tn_children.push_back(&tree[i]);
+    }
+
+    hierarchy.update_world_transforms();
+    compose_subtree(&tree[0], nullptr);
+
+    double hierarchy_ms = 0.0;
+    double tree_ms = 0.0;
+    v8_size_t recomputed = 0;
+
+    for (v8_size_t frame = 0; frame < frame_count; ++frame) {
+        //
+        // Both representations get the same new local transforms.
+        for (v8_size_t i = frame % animate_every; i < node_count;
+             i += animate_every) {
+            anim.as_angles[i] += 0.01f;
+            const transformF local(make_local_transform(
+                anim.as_angles[i], anim.as_offsets[i], anim.as_scales[i]));
+
+            hierarchy.set_local_transform(handles[i], local);
+            tree[i].tn_local = local;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        recomputed += hierarchy.update_world_transforms();
+        hierarchy_ms += elapsed_ms(start);
+
+        start = std::chrono::steady_clock::now();
+        compose_subtree(&tree[0], nullptr);
+        tree_ms += elapsed_ms(start);
+    }
+
+    //
+    // Reference : product of the 4x4 matrices along the parent chain.
+    std::vector<matrix_4X4F> reference(node_count);
+    v8_size_t mismatches = 0;
+
+    for (v8_size_t i = 0; i < node_count; ++i) {
+        const matrix_4X4F& local = tree[i].tn_local.get_transform_matrix();
+        reference[i] = i
+            ? reference[(i - 1) / C_Children_Per_Node] * local : local;
+
+        const matrix_4X4F& world =
+            hierarchy.get_world_transform(handles[i]).get_transform_matrix();
+        mismatches += !matrices_match(world, reference[i]);
+    }
+
+    printf("%zu nodes, %.0f%% animated per frame\n",
+           node_count, 100.0 / static_cast<double>(animate_every));
+    printf("    transform_hierarchy   %8.3f ms/frame, %zu world transforms "
+           "recomputed per frame\n",
+           hierarchy_ms / static_cast<double>(frame_count),
+           recomputed / frame_count);
+    printf("    pointer tree walk     %8.3f ms/frame, every node recomputed\n",
+           tree_ms / static_cast<double>(frame_count));
+
+    if (mismatches) {
+        printf("    MISMATCH : %zu world transforms differ from the "
+               "reference\n", mismatches);
+        return false;
+    }
+
+    return true;
+}
+
+} // anonymous namespace
+
+int main(int argc, char** argv) {
+    const v8_size_t node_count = argc > 1
+        ? static_cast<v8_size_t>(std::strtoul(argv[1], nullptr, 10)) : 100000;
+    const v8_size_t frame_count = argc > 2
+        ? static_cast<v8_size_t>(std::strtoul(argv[2], nullptr, 10)) : 100;
+
+    if (!node_count || !frame_count) {
+        printf("node and frame counts must not be zero\n");
+        return EXIT_FAILURE;
+    }
+
+    bool passed = run_benchmark(node_count, frame_count, 100);
+    passed = run_benchmark(node_count, frame_count, 1) && passed;
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
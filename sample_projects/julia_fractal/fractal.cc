@@ -31,6 +31,9 @@
 #include <v8/input/key_syms.hpp>
 
 #include "fractal.hpp"
+#include "fractal_cpu_renderer.hpp"
+#include "fractal_view_cache.hpp"
+#include "fractal_params.hpp"
 
 using namespace std;
 using namespace v8::math;
@@ -58,27 +61,6 @@ const fractal::complex_type C_shape_constants[] = {
     ,   fractal::complex_type(+0.32f, +0.043f)
 };
 
-///
-/// \brief Fractal parameters passed to the pixel shader.
-struct fractal_params_t {
-    v8_int32_t                                                      is_mandelbrot;
-    v8_int32_t                                                      use_color_table;
-    v8_int32_t                                                      width;
-    v8_int32_t                                                      height;
-    v8_int32_t                                                      max_iterations;
-    float                                                           zoom_factor;
-    float                                                           offset_x;
-    float                                                           offset_y;
-    ///< Shape constant, real part.
-    float                                                           C_real;
-    ///< Shape constant, imaginary part.
-    float                                                           C_imag;
-    v8::math::vector2<v8_int_t>                                     C_origin;
-
-    ~fractal_params_t() {
-    }
-};
-
 } // anonymous namespace
 
 struct fractal::implementation {
@@ -100,6 +82,9 @@ struct fractal::implementation {
     v8::rendering::vertex_shader                            vert_shader;
     v8::rendering::texture_shader_binding                   color_table;
     v8::rendering::sampler_state                            sampler;
+    fractal_cpu_renderer                                    cpu_renderer;
+    fractal_view_cache                                      cpu_view_cache;
+    v8_bool_t                                               cpu_color_table_valid;
 };
 
 fractal::implementation::implementation(
@@ -113,6 +98,8 @@ fractal::implementation::implementation(
         ,   solution_is_current(false)
         ,   shape_idx(0)
         ,   origin(v8::math::vector2<v8_int_t>::zero) 
+        ,   cpu_view_cache(cpu_renderer)
+        ,   cpu_color_table_valid(false)
 {
     frac_params.use_color_table = false;
     frac_params.width = width;
@@ -219,25 +206,13 @@ v8_bool_t fractal::create_color_table(fractal_app_context& app_context) {
 
     vector<rgb_color> color_palette(num_colors);
 
-    auto color_check_fn = [](const rgb_color& rgb) -> bool {
-        color_hcl hcl(rgb);
-
-        return hcl.Elements[0] >= 20.0f && hcl.Elements[0] <= 60.0f
-            && hcl.Elements[1] >= 0.3f && hcl.Elements[1] <= 1.6f
-            && hcl.Elements[2] >= 0.5f && hcl.Elements[2] <= 1.5f;
-    };
-
     v8::base::array_proxy<rgb_color> arr_proxy(&color_palette [0],
                                                &color_palette[0] + color_palette.size());
 
     //procedural_palette::gen_colors_luminance(0.9f, 1.f, arr_proxy);
     
     for (v8_int_t idx = 0; idx < 5; ++idx) {
-        procedural_palette::generate_color_palette(color_check_fn,
-                                                   true,
-                                                   50,
-                                                   true,
-                                                   arr_proxy);
+        make_fractal_color_table(arr_proxy);
 
         textureDescriptor_t tex_desc(num_colors, 
                                      1, 
@@ -263,11 +238,7 @@ v8_bool_t fractal::create_color_table(fractal_app_context& app_context) {
         lookup_tex.write_to_file(fname, *app_context.Renderer);
     }
 
-    procedural_palette::generate_color_palette(color_check_fn,
-                                                true,
-                                                50,
-                                                true,
-                                                arr_proxy);
+    make_fractal_color_table(arr_proxy);
 
     textureDescriptor_t tex_desc(num_colors, 
                                  1, 
@@ -392,6 +363,27 @@ void fractal::evaluate(const float delta_ms) {
     impl_->solution_is_current = true;
 }
 
+v8_bool_t fractal::render_to_memory(
+    v8_uint8_t*                 pixels,
+    v8_size_t                   pitch,
+    v8::base::job_system*       jobs,
+    const float                 budget_ms
+    ) {
+    if (impl_->frac_params.use_color_table && !impl_->cpu_color_table_valid) {
+        vector<rgb_color> color_palette(128);
+        v8::base::array_proxy<rgb_color> arr_proxy(
+            &color_palette[0], &color_palette[0] + color_palette.size());
+
+        make_fractal_color_table(arr_proxy);
+        impl_->cpu_renderer.set_color_table(&color_palette[0], color_palette.size());
+        impl_->cpu_view_cache.invalidate_colors();
+        impl_->cpu_color_table_valid = true;
+    }
+
+    return impl_->cpu_view_cache.render(impl_->frac_params, budget_ms,
+                                        pixels, pitch, jobs);
+}
+
 void fractal::draw(v8::rendering::renderer* draw_context) {
     const wchar_t* const key_settings = 
         L"Keys :\n"
@@ -9,6 +9,11 @@
 #include <v8/base/scoped_pointer.hpp>
 #include "application_context.hpp"
 
+namespace v8 { namespace base {
+class job_system;
+} // namespace base
+} // namespace v8
+
 class fractal {
 
 public :
@@ -84,6 +89,23 @@ public :
 
     void draw(v8::rendering::renderer* draw_context);
 
+    ///
+    /// \brief Renders the current view on the CPU (see fractal_cpu_renderer),
+    ///        as get_width() x get_height() pixels (bytes R, G, B, A).
+    ///        Iteration counts are cached between calls; pans and zooms
+    ///        reuse them (see fractal_view_cache).
+    /// \param pitch Distance in bytes between two rows of pixels.
+    /// \param jobs Optional job system that renders the tiles in parallel.
+    /// \param budget_ms Time budget of the call, in milliseconds. When not
+    ///        zero, the image may be a preview that later calls refine.
+    /// \returns True when the image is complete.
+    v8_bool_t render_to_memory(
+        v8_uint8_t*                 pixels,
+        v8_size_t                   pitch,
+        v8::base::job_system*       jobs = nullptr,
+        const float                 budget_ms = 0.0f
+        );
+
     //! @}
 
 public :
@@ -0,0 +1,444 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <v8/base/job_system.hpp>
+#include <v8/math/color_palette_generator.hpp>
+#include <v8/math/simd/float4.hpp>
+#include <v8/math/simd/float4_math.hpp>
+
+#include "fractal_cpu_renderer.hpp"
+#include "fractal_tiles.hpp"
+
+using namespace v8::math;
+
+const float fractal_cpu_renderer::C_Inside = -1.0f;
+
+const float fractal_cpu_renderer::C_Bailout_Radius = 256.0f;
+
+namespace {
+
+using v8::math::simd::float4_t;
+
+//
+// Two iterates closer than this (on both axes) are taken as a cycle.
+const float C_Period_Tolerance = 1.0e-6f;
+
+//
+// Iterations run before looking for cycles.
+const v8_int32_t C_Period_Check_Start = 64;
+
+///
+/// \brief Maps pixels to points of the complex plane (see fractal_params_t).
+struct view_mapping_t {
+    float   vm_origin_x;
+    float   vm_origin_y;
+    float   vm_scale_x;
+    float   vm_scale_y;
+
+    explicit view_mapping_t(const fractal_params_t& params) {
+        const float width = static_cast<float>(params.width);
+        const float height = static_cast<float>(params.height);
+
+        vm_scale_x = 1.5f / (0.5f * params.zoom_factor * width);
+        vm_scale_y = 1.0f / (0.5f * params.zoom_factor * height);
+        vm_origin_x = params.offset_x - 0.5f * width * vm_scale_x;
+        vm_origin_y = params.offset_y - 0.5f * height * vm_scale_y;
+    }
+};
+
+///
+/// \brief Smooth iteration counts of eight points, iterated as two groups of
+///        four lanes.
+void iterate_points(
+    const fractal_params_t&     params,
+    const float*                re,
+    const float*                im,
+    float*                      values
+    ) {
+    using namespace v8::math::simd;
+
+    const float4_t one = splat_float4(1.0f);
+    const float radius = fractal_cpu_renderer::C_Bailout_Radius;
+    const float4_t bailout = splat_float4(radius * radius);
+
+    float4_t zr[2], zi[2], cr[2], ci[2], count[2], active[2];
+    for (int g = 0; g < 2; ++g) {
+        const float4_t x = load_float4(re + g * 4);
+        const float4_t y = load_float4(im + g * 4);
+
+        count[g] = zero_float4();
+        active[g] = cmp_le(zero_float4(), one);
+
+        if (params.is_mandelbrot) {
+            zr[g] = zero_float4();
+            zi[g] = zero_float4();
+            cr[g] = x;
+            ci[g] = y;
+
+            //
+            // Points of the main cardioid and of the period 2 bulb never
+            // escape; they are not iterated.
+            const float4_t y2 = mul(y, y);
+            const float4_t xq = sub(x, splat_float4(0.25f));
+            const float4_t q = add(mul(xq, xq), y2);
+            const float4_t in_cardioid = cmp_le(
+                mul(q, add(q, xq)), mul(y2, splat_float4(0.25f)));
+
+            const float4_t x1 = add(x, one);
+            const float4_t in_bulb = cmp_le(
+                add(mul(x1, x1), y2), splat_float4(1.0f / 16.0f));
+
+            active[g] = select(
+                bit_or(in_cardioid, in_bulb), zero_float4(), active[g]);
+        } else {
+            zr[g] = x;
+            zi[g] = y;
+            cr[g] = splat_float4(params.C_real);
+            ci[g] = splat_float4(params.C_imag);
+        }
+    }
+
+    //
+    // Escaped lanes keep their z (the first value past the bailout radius,
+    // needed for the smooth count) and stop counting. The loop ends when
+    // all eight lanes have escaped.
+    //
+    // Points of the set usually fall into a cycle. After the first
+    // C_Period_Check_Start iterations (most escaping points are done by
+    // then), z is compared with a value saved at doubling intervals
+    // (Brent's cycle detection) and lanes that repeat it stop as well.
+    const float4_t tolerance = splat_float4(C_Period_Tolerance);
+    float4_t saved_r[2] = { zr[0], zr[1] };
+    float4_t saved_i[2] = { zi[0], zi[1] };
+    v8_int32_t next_save = C_Period_Check_Start;
+
+    for (v8_int32_t it = 1; it <= params.max_iterations; ++it) {
+        const bool check_period = it > C_Period_Check_Start;
+
+        for (int g = 0; g < 2; ++g) {
+            const float4_t zr2 = mul(zr[g], zr[g]);
+            const float4_t zi2 = mul(zi[g], zi[g]);
+            const float4_t inside = bit_and(
+                active[g], cmp_le(add(zr2, zi2), bailout));
+
+            const float4_t new_zi = add(mul(add(zr[g], zr[g]), zi[g]), ci[g]);
+            const float4_t new_zr = add(sub(zr2, zi2), cr[g]);
+
+            zr[g] = select(inside, new_zr, zr[g]);
+            zi[g] = select(inside, new_zi, zi[g]);
+            count[g] = add(count[g], bit_and(inside, one));
+            active[g] = inside;
+
+            if (check_period) {
+                const float4_t dr = sub(zr[g], saved_r[g]);
+                const float4_t di = sub(zi[g], saved_i[g]);
+                const float4_t periodic = bit_and(
+                    cmp_lt(maximum(dr, negate(dr)), tolerance),
+                    cmp_lt(maximum(di, negate(di)), tolerance));
+                active[g] = select(periodic, zero_float4(), inside);
+            }
+        }
+
+        if (!(move_mask(active[0]) | move_mask(active[1]))) {
+            break;
+        }
+
+        if (it == next_save) {
+            next_save *= 2;
+            for (int g = 0; g < 2; ++g) {
+                saved_r[g] = zr[g];
+                saved_i[g] = zi[g];
+            }
+        }
+    }
+
+    //
+    // mu = n + 1 - log2(log2(|z_n|))
+    for (int g = 0; g < 2; ++g) {
+        const float4_t magnitude = add(mul(zr[g], zr[g]), mul(zi[g], zi[g]));
+        const float4_t escaped = cmp_gt(magnitude, bailout);
+
+        const float4_t log_z = mul(
+            log2_approx(maximum(magnitude, bailout)), splat_float4(0.5f));
+        const float4_t mu = maximum(
+            sub(add(count[g], one), log2_approx(log_z)), zero_float4());
+
+        store_float4(values + g * 4,
+            select(escaped, mu, splat_float4(fractal_cpu_renderer::C_Inside)));
+    }
+}
+
+} // anonymous namespace
+
+void make_fractal_color_table(v8::base::array_proxy<rgb_color>& colors) {
+    auto color_check_fn = [](const rgb_color& rgb) -> bool {
+        color_hcl hcl(rgb);
+
+        return hcl.Elements[0] >= 20.0f && hcl.Elements[0] <= 60.0f
+            && hcl.Elements[1] >= 0.3f && hcl.Elements[1] <= 1.6f
+            && hcl.Elements[2] >= 0.5f && hcl.Elements[2] <= 1.5f;
+    };
+
+    procedural_palette::generate_color_palette(color_check_fn,
+                                               true,
+                                               50,
+                                               true,
+                                               colors);
+}
+
+fractal_cpu_renderer::fractal_cpu_renderer() {}
+
+void fractal_cpu_renderer::set_color_table(
+    const rgb_color*    colors,
+    v8_size_t           count
+    ) {
+    color_table_.resize(count * 3);
+
+    for (v8_size_t i = 0; i < count; ++i) {
+        for (int c = 0; c < 3; ++c) {
+            const float val = std::min(std::max(colors[i].Elements[c], 0.0f), 1.0f);
+            color_table_[i * 3 + c] = val * 255.0f;
+        }
+    }
+}
+
+void fractal_cpu_renderer::render(
+    const fractal_params_t&     params,
+    v8_uint8_t*                 pixels,
+    v8_size_t                   pitch,
+    v8::base::job_system*       jobs
+    ) const {
+    for_each_tile(0, 0, params.width, params.height, jobs,
+        [&](v8_int32_t x0, v8_int32_t y0, v8_int32_t x1, v8_int32_t y1) {
+        float values[C_Fractal_Tile_Size * C_Fractal_Tile_Size];
+
+        compute_tile(params, x0, y0, x1, y1, 1, 1, values, C_Fractal_Tile_Size);
+        colorize_tile(params, values, C_Fractal_Tile_Size, x1 - x0, y1 - y0,
+                      pixels + y0 * pitch + x0 * 4, pitch);
+    });
+}
+
+void fractal_cpu_renderer::compute_iterations(
+    const fractal_params_t&     params,
+    v8_int32_t                  x0,
+    v8_int32_t                  y0,
+    v8_int32_t                  x1,
+    v8_int32_t                  y1,
+    float*                      values,
+    v8_size_t                   pitch,
+    v8::base::job_system*       jobs
+    ) const {
+    compute_samples(params, x0, y0, x1, y1, 1, 1, values, pitch, jobs);
+}
+
+void fractal_cpu_renderer::compute_samples(
+    const fractal_params_t&     params,
+    v8_int32_t                  x0,
+    v8_int32_t                  y0,
+    v8_int32_t                  x1,
+    v8_int32_t                  y1,
+    v8_int32_t                  step_x,
+    v8_int32_t                  step_y,
+    float*                      values,
+    v8_size_t                   pitch,
+    v8::base::job_system*       jobs
+    ) const {
+    for_each_tile(x0, y0, x1, y1, jobs,
+        [&](v8_int32_t tx0, v8_int32_t ty0, v8_int32_t tx1, v8_int32_t ty1) {
+        //
+        // First sample of the tile.
+        const v8_int32_t sx = x0 + (tx0 - x0 + step_x - 1) / step_x * step_x;
+        const v8_int32_t sy = y0 + (ty0 - y0 + step_y - 1) / step_y * step_y;
+
+        compute_tile(params, sx, sy, tx1, ty1, step_x, step_y,
+                     values + sy * pitch + sx, pitch);
+    });
+}
+
+void fractal_cpu_renderer::colorize(
+    const fractal_params_t&     params,
+    const float*                values,
+    v8_size_t                   values_pitch,
+    v8_uint8_t*                 pixels,
+    v8_size_t                   pitch,
+    v8::base::job_system*       jobs
+    ) const {
+    for_each_tile(0, 0, params.width, params.height, jobs,
+        [&](v8_int32_t x0, v8_int32_t y0, v8_int32_t x1, v8_int32_t y1) {
+        colorize_tile(params, values + y0 * values_pitch + x0, values_pitch,
+                      x1 - x0, y1 - y0, pixels + y0 * pitch + x0 * 4, pitch);
+    });
+}
+
+void fractal_cpu_renderer::colorize_samples(
+    const fractal_params_t&     params,
+    v8_int32_t                  x0,
+    v8_int32_t                  y0,
+    v8_int32_t                  x1,
+    v8_int32_t                  y1,
+    v8_int32_t                  step_x,
+    v8_int32_t                  step_y,
+    const float*                values,
+    v8_size_t                   values_pitch,
+    v8_uint8_t*                 pixels,
+    v8_size_t                   pitch,
+    v8::base::job_system*       jobs
+    ) const {
+    for_each_tile(x0, y0, x1, y1, jobs,
+        [&](v8_int32_t tx0, v8_int32_t ty0, v8_int32_t tx1, v8_int32_t ty1) {
+        const v8_int32_t sx = x0 + (tx0 - x0 + step_x - 1) / step_x * step_x;
+        const v8_int32_t sy = y0 + (ty0 - y0 + step_y - 1) / step_y * step_y;
+
+        if (step_x == 1 && step_y == 1) {
+            colorize_tile(params, values + sy * values_pitch + sx, values_pitch,
+                          tx1 - sx, ty1 - sy, pixels + sy * pitch + sx * 4, pitch);
+            return;
+        }
+
+        //
+        // The samples of a row are gathered, converted, then scattered back.
+        float row_values[C_Fractal_Tile_Size];
+        v8_uint8_t row_colors[C_Fractal_Tile_Size * 4];
+        const v8_int32_t count = (tx1 - sx + step_x - 1) / step_x;
+
+        for (v8_int32_t y = sy; y < ty1; y += step_y) {
+            const float* src = values + y * values_pitch + sx;
+            for (v8_int32_t i = 0; i < count; ++i) {
+                row_values[i] = src[i * step_x];
+            }
+
+            colorize_tile(params, row_values, C_Fractal_Tile_Size, count, 1,
+                          row_colors, sizeof(row_colors));
+
+            v8_uint8_t* dst = pixels + y * pitch + sx * 4;
+            for (v8_int32_t i = 0; i < count; ++i) {
+                memcpy(dst + i * step_x * 4, row_colors + i * 4, 4);
+            }
+        }
+    });
+}
+
+void fractal_cpu_renderer::compute_tile(
+    const fractal_params_t&     params,
+    v8_int32_t                  x0,
+    v8_int32_t                  y0,
+    v8_int32_t                  x1,
+    v8_int32_t                  y1,
+    v8_int32_t                  step_x,
+    v8_int32_t                  step_y,
+    float*                      values,
+    v8_size_t                   pitch
+    ) const {
+    const view_mapping_t view(params);
+
+    for (v8_int32_t y = y0; y < y1; y += step_y) {
+        float im[8];
+        std::fill(im, im + 8, view.vm_origin_y + static_cast<float>(y) * view.vm_scale_y);
+
+        float* row = values + (y - y0) * pitch;
+
+        for (v8_int32_t x = x0; x < x1; x += 8 * step_x) {
+            float re[8];
+            for (v8_int32_t lane = 0; lane < 8; ++lane) {
+                re[lane] = view.vm_origin_x
+                    + static_cast<float>(x + lane * step_x) * view.vm_scale_x;
+            }
+
+            float mu[8];
+            iterate_points(params, re, im, mu);
+
+            const v8_int32_t count = std::min(8, (x1 - x + step_x - 1) / step_x);
+            if (step_x == 1) {
+                memcpy(row + (x - x0), mu, count * sizeof(float));
+            } else {
+                for (v8_int32_t lane = 0; lane < count; ++lane) {
+                    row[x - x0 + lane * step_x] = mu[lane];
+                }
+            }
+        }
+    }
+}
+
+void fractal_cpu_renderer::colorize_tile(
+    const fractal_params_t&     params,
+    const float*                values,
+    v8_size_t                   values_pitch,
+    v8_int32_t                  width,
+    v8_int32_t                  height,
+    v8_uint8_t*                 pixels,
+    v8_size_t                   pitch
+    ) const {
+    const v8_size_t table_size = color_table_.size() / 3;
+    const bool use_table = params.use_color_table && table_size != 0;
+    const float gray_scale =
+        255.0f / std::log2(1.0f + static_cast<float>(params.max_iterations));
+
+    using namespace v8::math::simd;
+
+    for (v8_int32_t y = 0; y < height; ++y) {
+        const float* src = values + y * values_pitch;
+        v8_uint8_t* dst = pixels + y * pitch;
+        v8_int32_t x = 0;
+
+        //
+        // Gray levels of four pixels at a time; the table lookups below
+        // stay scalar. The end of the row is padded to four pixels, so a
+        // level only depends on the value (the cache colorizes samples
+        // that a direct render colorizes as whole rows).
+        for (; !use_table && x < width; x += 4) {
+            const v8_int32_t count = std::min(4, width - x);
+            float tail[4] = { C_Inside, C_Inside, C_Inside, C_Inside };
+            if (count < 4) {
+                std::copy(src + x, src + width, tail);
+            }
+
+            const float4_t mu = load_float4(count == 4 ? src + x : tail);
+            const float4_t gray = minimum(
+                mul(log2_approx(add(mu, splat_float4(1.0f))), splat_float4(gray_scale)),
+                splat_float4(255.0f));
+            const float4_t levels = convert_float_to_int(add(
+                bit_and(cmp_le(zero_float4(), mu), gray), splat_float4(0.5f)));
+
+            v8_int32_t lanes[4];
+            store_float4(reinterpret_cast<float*>(lanes), levels);
+
+            for (v8_int32_t lane = 0; lane < count; ++lane) {
+                v8_uint8_t* pixel = dst + (x + lane) * 4;
+                pixel[0] = pixel[1] = pixel[2] = static_cast<v8_uint8_t>(lanes[lane]);
+                pixel[3] = 255;
+            }
+        }
+
+        for (; x < width; ++x) {
+            const float mu = src[x];
+            float rgb[3] = { 0.0f, 0.0f, 0.0f };
+
+            if (mu >= 0.0f && use_table) {
+                //
+                // One table entry per iteration, linear interpolation
+                // between entries.
+                const float pos = std::fmod(mu, static_cast<float>(table_size));
+                const v8_size_t idx = std::min(
+                    static_cast<v8_size_t>(pos), table_size - 1);
+                const v8_size_t next = (idx + 1) % table_size;
+                const float t = pos - static_cast<float>(idx);
+
+                for (int c = 0; c < 3; ++c) {
+                    const float a = color_table_[idx * 3 + c];
+                    const float b = color_table_[next * 3 + c];
+                    rgb[c] = a + (b - a) * t;
+                }
+            } else if (mu >= 0.0f) {
+                const float gray = std::min(
+                    std::log2(1.0f + mu) * gray_scale, 255.0f);
+                rgb[0] = rgb[1] = rgb[2] = gray;
+            }
+
+            for (int c = 0; c < 3; ++c) {
+                dst[x * 4 + c] = static_cast<v8_uint8_t>(rgb[c] + 0.5f);
+            }
+            dst[x * 4 + 3] = 255;
+        }
+    }
+}
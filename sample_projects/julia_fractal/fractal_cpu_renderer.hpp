@@ -0,0 +1,166 @@
+#pragma once
+
+#include <vector>
+
+#include <v8/v8.hpp>
+#include <v8/base/array_proxy.hpp>
+#include <v8/math/color.hpp>
+
+#include "fractal_params.hpp"
+
+namespace v8 { namespace base {
+class job_system;
+} // namespace base
+} // namespace v8
+
+///
+/// \brief  Fills a color table with the palette used by the fractal sample
+///         (procedural_palette colors, constrained in HCL space).
+void make_fractal_color_table(v8::base::array_proxy<v8::math::rgb_color>& colors);
+
+///
+/// \brief  Evaluates the Julia/Mandelbrot sets on the CPU, with the same
+///         parameters as the ps_julia pixel shader, so the sample can run
+///         without a GPU.
+/// \remarks    Points are iterated eight at a time (two float4 registers),
+///             until all eight escape or the iteration cap is reached. The
+///             image is split in tiles (see fractal_tiles.hpp), that are
+///             distributed across the threads of a job system.
+class fractal_cpu_renderer {
+public :
+
+    ///
+    /// \brief Smooth iteration count of the points that do not escape.
+    static const float  C_Inside;
+
+    ///
+    /// \brief Bailout radius. A large radius makes the smooth iteration
+    ///        counts continuous.
+    static const float  C_Bailout_Radius;
+
+public :
+
+    fractal_cpu_renderer();
+
+    ///
+    /// \brief  Sets the color table used when params.use_color_table is
+    ///         true. Colors are picked by the smooth iteration count (one
+    ///         entry per iteration, repeated), with linear interpolation.
+    void set_color_table(const v8::math::rgb_color* colors, v8_size_t count);
+
+    ///
+    /// \brief  Renders a params.width x params.height image.
+    /// \param  pixels  Output pixels, as bytes R, G, B, A in memory order.
+    /// \param  pitch   Distance in bytes between two rows of pixels.
+    /// \param  jobs    Optional, when not null the tiles are rendered by the
+    ///                 threads of the job system.
+    void render(
+        const fractal_params_t&     params,
+        v8_uint8_t*                 pixels,
+        v8_size_t                   pitch,
+        v8::base::job_system*       jobs = nullptr
+        ) const;
+
+    ///
+    /// \brief  Computes the smooth iteration counts of the pixels in the
+    ///         [x0, x1) x [y0, y1) region of the image. Points that do not
+    ///         escape get C_Inside.
+    /// \param  values  Iteration counts of the whole image; value (x, y) is
+    ///                 stored at values[y * pitch + x].
+    void compute_iterations(
+        const fractal_params_t&     params,
+        v8_int32_t                  x0,
+        v8_int32_t                  y0,
+        v8_int32_t                  x1,
+        v8_int32_t                  y1,
+        float*                      values,
+        v8_size_t                   pitch,
+        v8::base::job_system*       jobs = nullptr
+        ) const;
+
+    ///
+    /// \brief  Computes the pixels (x0 + i * step_x, y0 + j * step_y) of the
+    ///         [x0, x1) x [y0, y1) region, for progressive refinement. Each
+    ///         value is stored at its pixel (values[y * pitch + x]), the
+    ///         pixels between the samples are left unchanged.
+    void compute_samples(
+        const fractal_params_t&     params,
+        v8_int32_t                  x0,
+        v8_int32_t                  y0,
+        v8_int32_t                  x1,
+        v8_int32_t                  y1,
+        v8_int32_t                  step_x,
+        v8_int32_t                  step_y,
+        float*                      values,
+        v8_size_t                   pitch,
+        v8::base::job_system*       jobs = nullptr
+        ) const;
+
+    ///
+    /// \brief  Converts smooth iteration counts (see compute_iterations) of
+    ///         a params.width x params.height image to colors.
+    /// \param  values_pitch    Distance in floats between two rows of values.
+    /// \param  pitch           Distance in bytes between two rows of pixels.
+    void colorize(
+        const fractal_params_t&     params,
+        const float*                values,
+        v8_size_t                   values_pitch,
+        v8_uint8_t*                 pixels,
+        v8_size_t                   pitch,
+        v8::base::job_system*       jobs = nullptr
+        ) const;
+
+    ///
+    /// \brief  Converts the values of the pixels (x0 + i * step_x,
+    ///         y0 + j * step_y) of the [x0, x1) x [y0, y1) region to colors
+    ///         (see compute_samples); the pixels between the samples are
+    ///         left unchanged. A pixel gets the same color as from colorize.
+    void colorize_samples(
+        const fractal_params_t&     params,
+        v8_int32_t                  x0,
+        v8_int32_t                  y0,
+        v8_int32_t                  x1,
+        v8_int32_t                  y1,
+        v8_int32_t                  step_x,
+        v8_int32_t                  step_y,
+        const float*                values,
+        v8_size_t                   values_pitch,
+        v8_uint8_t*                 pixels,
+        v8_size_t                   pitch,
+        v8::base::job_system*       jobs = nullptr
+        ) const;
+
+private :
+
+    ///
+    /// \brief Computes the pixels (x0 + i * step_x, y0 + j * step_y) of the
+    ///        [x0, x1) x [y0, y1) region; values points to the value of pixel
+    ///        (x0, y0).
+    void compute_tile(
+        const fractal_params_t&     params,
+        v8_int32_t                  x0,
+        v8_int32_t                  y0,
+        v8_int32_t                  x1,
+        v8_int32_t                  y1,
+        v8_int32_t                  step_x,
+        v8_int32_t                  step_y,
+        float*                      values,
+        v8_size_t                   pitch
+        ) const;
+
+    void colorize_tile(
+        const fractal_params_t&     params,
+        const float*                values,
+        v8_size_t                   values_pitch,
+        v8_int32_t                  width,
+        v8_int32_t                  height,
+        v8_uint8_t*                 pixels,
+        v8_size_t                   pitch
+        ) const;
+
+    //! Color table, as r, g, b triples in [0, 255].
+    std::vector<float>                                      color_table_;
+
+private :
+    NO_CC_ASSIGN(fractal_cpu_renderer);
+};
@@ -0,0 +1,619 @@
+#include <algorithm>
+#include <cmath>
+#include <complex>
+
+#include <v8/base/job_system.hpp>
+
+#include "fractal_cpu_renderer.hpp"
+#include "fractal_deep_zoom.hpp"
+#include "fractal_tiles.hpp"
+
+namespace {
+
+typedef std::complex<double> complex_t;
+
+//
+// Extra bits kept in the orbits beyond the pixel spacing.
+const v8_int32_t C_Guard_Bits = 48;
+
+//
+// The series is used while its cubic term stays below this fraction of the
+// linear term, at the image corners.
+const double C_Series_Tolerance = 1.0e-8;
+
+//
+// Largest relative difference allowed between the series and the probes
+// iterated explicitly.
+const double C_Probe_Tolerance = 1.0e-6;
+
+///
+/// \brief Orbit of z0 under z -> z^2 + c, computed in fixed point and stored
+///        as doubles, up to the first value past the bailout radius.
+void compute_orbit(
+    const deep_real&        z0_re,
+    const deep_real&        z0_im,
+    const deep_real&        c_re,
+    const deep_real&        c_im,
+    v8_int32_t              max_iterations,
+    v8_int32_t              fraction_limbs,
+    std::vector<double>*    orbit_re,
+    std::vector<double>*    orbit_im
+    ) {
+    const double radius = fractal_cpu_renderer::C_Bailout_Radius;
+    const double bailout = radius * radius;
+
+    deep_real zr(z0_re);
+    deep_real zi(z0_im);
+    zr.set_fraction_limbs(fraction_limbs);
+    zi.set_fraction_limbs(fraction_limbs);
+
+    orbit_re->clear();
+    orbit_im->clear();
+    orbit_re->push_back(zr.to_double());
+    orbit_im->push_back(zi.to_double());
+
+    for (v8_int32_t n = 0; n < max_iterations; ++n) {
+        const double xr = orbit_re->back();
+        const double xi = orbit_im->back();
+        if (xr * xr + xi * xi > bailout) {
+            break;
+        }
+
+        const deep_real zr2 = zr * zr;
+        const deep_real zi2 = zi * zi;
+        const deep_real zri = zr * zi;
+
+        zi = zri + zri + c_im;
+        zr = zr2 - zi2 + c_re;
+
+        orbit_re->push_back(zr.to_double());
+        orbit_im->push_back(zi.to_double());
+    }
+}
+
+///
+/// \brief Everything the per pixel loop reads.
+struct perturbation_setup_t {
+    const double*   ps_reference_re;
+    const double*   ps_reference_im;
+    v8_size_t       ps_reference_length;
+    const double*   ps_rebase_re;
+    const double*   ps_rebase_im;
+    v8_size_t       ps_rebase_length;
+    //! Series coefficients A, B, C as (re, im) pairs.
+    double          ps_series[6];
+    v8_int32_t      ps_skipped;
+    v8_int32_t      ps_max_iterations;
+    bool            ps_is_mandelbrot;
+    double          ps_scale_x;
+    double          ps_scale_y;
+    double          ps_half_width;
+    double          ps_half_height;
+};
+
+///
+/// \brief Smooth iteration count of the pixel at offset (dx, dy) from the
+///        view center.
+float iterate_pixel(const perturbation_setup_t& setup, double dx, double dy) {
+    const double radius = fractal_cpu_renderer::C_Bailout_Radius;
+    const double bailout = radius * radius;
+
+    //
+    // d(N) = A dc + B dc^2 + C dc^3
+    const double* s = setup.ps_series;
+    const double x2r = dx * dx - dy * dy;
+    const double x2i = 2.0 * dx * dy;
+    const double x3r = x2r * dx - x2i * dy;
+    const double x3i = x2r * dy + x2i * dx;
+
+    double dr = s[0] * dx - s[1] * dy + s[2] * x2r - s[3] * x2i + s[4] * x3r - s[5] * x3i;
+    double di = s[0] * dy + s[1] * dx + s[2] * x2i + s[3] * x2r + s[4] * x3i + s[5] * x3r;
+
+    const double dcr = setup.ps_is_mandelbrot ? dx : 0.0;
+    const double dci = setup.ps_is_mandelbrot ? dy : 0.0;
+
+    const double* ref_re = setup.ps_reference_re;
+    const double* ref_im = setup.ps_reference_im;
+    v8_size_t last = setup.ps_reference_length - 1;
+    v8_size_t m = static_cast<v8_size_t>(setup.ps_skipped);
+
+    for (v8_int32_t n = setup.ps_skipped; ; ++n) {
+        const double zr = ref_re[m] + dr;
+        const double zi = ref_im[m] + di;
+        const double magnitude = zr * zr + zi * zi;
+
+        if (magnitude > bailout) {
+            const double mu = n + 1 - std::log2(0.5 * std::log2(magnitude));
+            return static_cast<float>(std::max(mu, 0.0));
+        }
+
+        if (n == setup.ps_max_iterations) {
+            break;
+        }
+
+        //
+        // Rebase on the orbit of the critical point, that starts at 0 :
+        // the difference becomes z itself, with no loss of precision.
+        if (magnitude < dr * dr + di * di || m == last) {
+            dr = zr;
+            di = zi;
+            ref_re = setup.ps_rebase_re;
+            ref_im = setup.ps_rebase_im;
+            last = setup.ps_rebase_length - 1;
+            m = 0;
+        }
+
+        const double rr = ref_re[m];
+        const double ri = ref_im[m];
+        const double new_dr = 2.0 * (rr * dr - ri * di) + (dr * dr - di * di) + dcr;
+        const double new_di = 2.0 * (rr * di + ri * dr) + 2.0 * dr * di + dci;
+
+        dr = new_dr;
+        di = new_di;
+        ++m;
+    }
+
+    return fractal_cpu_renderer::C_Inside;
+}
+
+} // anonymous namespace
+
+deep_real::deep_real()
+    : negative_(false), limbs_(C_Default_Fraction_Limbs + 1, 0) {}
+
+deep_real::deep_real(double value, v8_int32_t fraction_limbs)
+    : negative_(value < 0.0), limbs_(fraction_limbs + 1, 0) {
+    double magnitude = std::fabs(value);
+
+    limbs_.back() = static_cast<v8_uint32_t>(std::floor(magnitude));
+    magnitude -= std::floor(magnitude);
+
+    //
+    // Scaling by 2^32 is exact, the conversion is exact while the limbs
+    // last.
+    for (v8_int32_t i = fraction_limbs - 1; i >= 0 && magnitude != 0.0; --i) {
+        magnitude = std::ldexp(magnitude, 32);
+        limbs_[i] = static_cast<v8_uint32_t>(std::floor(magnitude));
+        magnitude -= std::floor(magnitude);
+    }
+
+    negative_ = negative_ && !is_zero();
+}
+
+bool deep_real::parse(const char* str, v8_int32_t fraction_limbs) {
+    while (*str == ' ' || *str == '\t') {
+        ++str;
+    }
+
+    bool negative = false;
+    if (*str == '-' || *str == '+') {
+        negative = *str == '-';
+        ++str;
+    }
+
+    v8_uint64_t integer_part = 0;
+    v8_int32_t digits = 0;
+    for (; *str >= '0' && *str <= '9'; ++str, ++digits) {
+        integer_part = integer_part * 10 + static_cast<v8_uint64_t>(*str - '0');
+        if (integer_part > 0xFFFFFFFFu) {
+            return false;
+        }
+    }
+
+    const char* fraction = str;
+    v8_int32_t fraction_digits = 0;
+    if (*str == '.') {
+        fraction = ++str;
+        for (; *str >= '0' && *str <= '9'; ++str) {
+            ++fraction_digits;
+        }
+    }
+
+    if (*str != '\0' || digits + fraction_digits == 0) {
+        return false;
+    }
+
+    //
+    // The fraction digits are folded from the last one : f = (f + d) / 10.
+    std::vector<v8_uint32_t> limbs(fraction_limbs + 1, 0);
+    for (v8_int32_t i = fraction_digits - 1; i >= 0; --i) {
+        limbs.back() = static_cast<v8_uint32_t>(fraction[i] - '0');
+
+        v8_uint64_t remainder = 0;
+        for (v8_size_t j = limbs.size(); j-- > 0; ) {
+            const v8_uint64_t current = (remainder << 32) | limbs[j];
+            limbs[j] = static_cast<v8_uint32_t>(current / 10);
+            remainder = current % 10;
+        }
+    }
+
+    limbs.back() = static_cast<v8_uint32_t>(integer_part);
+    limbs_.swap(limbs);
+    negative_ = negative && !is_zero();
+    return true;
+}
+
+double deep_real::to_double() const {
+    double value = 0.0;
+
+    //
+    // Three limbs hold more than the 53 bits of a double.
+    const v8_size_t count = limbs_.size();
+    const v8_size_t first = count > 3 ? count - 4 : 0;
+    for (v8_size_t i = first; i < count; ++i) {
+        value += std::ldexp(static_cast<double>(limbs_[i]),
+                            -32 * static_cast<int>(count - 1 - i));
+    }
+
+    return negative_ ? -value : value;
+}
+
+void deep_real::set_fraction_limbs(v8_int32_t fraction_limbs) {
+    const v8_int32_t current = get_fraction_limbs();
+
+    if (fraction_limbs > current) {
+        limbs_.insert(limbs_.begin(), fraction_limbs - current, 0);
+    } else if (fraction_limbs < current) {
+        limbs_.erase(limbs_.begin(), limbs_.begin() + (current - fraction_limbs));
+        negative_ = negative_ && !is_zero();
+    }
+}
+
+deep_real& deep_real::operator+=(const deep_real& rhs) {
+    add(rhs, rhs.negative_);
+    return *this;
+}
+
+deep_real& deep_real::operator-=(const deep_real& rhs) {
+    add(rhs, !rhs.negative_);
+    return *this;
+}
+
+deep_real& deep_real::operator*=(const deep_real& rhs) {
+    if (rhs.get_fraction_limbs() > get_fraction_limbs()) {
+        set_fraction_limbs(rhs.get_fraction_limbs());
+    }
+
+    //
+    // Schoolbook product of the magnitudes, as integers scaled by
+    // 2^(32 n); the result drops the n lowest limbs.
+    const v8_size_t size = limbs_.size();
+    const v8_size_t n = size - 1;
+    std::vector<v8_uint32_t> product(size * 2, 0);
+
+    for (v8_size_t i = 0; i < size; ++i) {
+        const v8_uint64_t a = limbs_[i];
+        if (a == 0) {
+            continue;
+        }
+
+        v8_uint64_t carry = 0;
+        for (v8_size_t j = 0; j < size; ++j) {
+            const v8_uint64_t t =
+                a * aligned_limb(rhs, j) + product[i + j] + carry;
+            product[i + j] = static_cast<v8_uint32_t>(t);
+            carry = t >> 32;
+        }
+        product[i + size] = static_cast<v8_uint32_t>(carry);
+    }
+
+    std::copy(product.begin() + n, product.begin() + n + size, limbs_.begin());
+    negative_ = (negative_ != rhs.negative_) && !is_zero();
+    return *this;
+}
+
+deep_real deep_real::operator-() const {
+    deep_real result(*this);
+    result.negative_ = !negative_ && !is_zero();
+    return result;
+}
+
+bool deep_real::operator==(const deep_real& rhs) const {
+    if (rhs.get_fraction_limbs() > get_fraction_limbs()) {
+        return rhs == *this;
+    }
+
+    if (negative_ != rhs.negative_) {
+        return false;
+    }
+
+    for (v8_size_t i = 0; i < limbs_.size(); ++i) {
+        if (limbs_[i] != aligned_limb(rhs, i)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void deep_real::add(const deep_real& rhs, bool rhs_negative) {
+    if (rhs.get_fraction_limbs() > get_fraction_limbs()) {
+        set_fraction_limbs(rhs.get_fraction_limbs());
+    }
+
+    const v8_size_t size = limbs_.size();
+
+    if (negative_ == rhs_negative) {
+        v8_uint64_t carry = 0;
+        for (v8_size_t i = 0; i < size; ++i) {
+            const v8_uint64_t t =
+                static_cast<v8_uint64_t>(limbs_[i]) + aligned_limb(rhs, i) + carry;
+            limbs_[i] = static_cast<v8_uint32_t>(t);
+            carry = t >> 32;
+        }
+        return;
+    }
+
+    //
+    // Opposite signs : the smaller magnitude is subtracted from the larger
+    // one, that gives the sign of the result.
+    bool rhs_larger = false;
+    for (v8_size_t i = size; i-- > 0; ) {
+        const v8_uint32_t r = aligned_limb(rhs, i);
+        if (limbs_[i] != r) {
+            rhs_larger = r > limbs_[i];
+            break;
+        }
+    }
+
+    v8_int64_t borrow = 0;
+    for (v8_size_t i = 0; i < size; ++i) {
+        const v8_int64_t a = limbs_[i];
+        const v8_int64_t b = aligned_limb(rhs, i);
+        v8_int64_t t = rhs_larger ? b - a - borrow : a - b - borrow;
+
+        borrow = t < 0 ? 1 : 0;
+        t += borrow << 32;
+        limbs_[i] = static_cast<v8_uint32_t>(t);
+    }
+
+    negative_ = (rhs_larger ? rhs_negative : negative_) && !is_zero();
+}
+
+v8_uint32_t deep_real::aligned_limb(const deep_real& rhs, v8_size_t i) const {
+    const v8_size_t shift = limbs_.size() - rhs.limbs_.size();
+    return i >= shift ? rhs.limbs_[i - shift] : 0;
+}
+
+bool deep_real::is_zero() const {
+    for (v8_size_t i = 0; i < limbs_.size(); ++i) {
+        if (limbs_[i]) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+deep_zoom_view_t::deep_zoom_view_t(const fractal_params_t& params)
+    : dz_center_re(params.offset_x),
+      dz_center_im(params.offset_y),
+      dz_zoom(params.zoom_factor) {}
+
+v8_int32_t deep_zoom_view_t::required_fraction_limbs(
+    v8_int32_t  width,
+    v8_int32_t  height
+    ) const {
+    const double spacing = std::min(
+        3.0 / (dz_zoom * std::max(width, 1)), 2.0 / (dz_zoom * std::max(height, 1)));
+    const double bits = std::max(-std::log2(spacing), 0.0) + C_Guard_Bits;
+
+    return std::max(static_cast<v8_int32_t>(std::ceil(bits / 32.0)), 2);
+}
+
+fractal_deep_zoom_renderer::fractal_deep_zoom_renderer()
+    : orbit_c_real_(0.0f),
+      orbit_c_imag_(0.0f),
+      orbit_iterations_(0),
+      orbit_fraction_limbs_(0),
+      orbit_is_mandelbrot_(0),
+      orbit_valid_(false),
+      skipped_iterations_(0) {}
+
+void fractal_deep_zoom_renderer::compute_iterations(
+    const fractal_params_t&     params,
+    const deep_zoom_view_t&     view,
+    v8_int32_t                  x0,
+    v8_int32_t                  y0,
+    v8_int32_t                  x1,
+    v8_int32_t                  y1,
+    float*                      values,
+    v8_size_t                   pitch,
+    v8::base::job_system*       jobs
+    ) {
+    update_orbits(params, view);
+
+    perturbation_setup_t setup;
+    setup.ps_reference_re = &reference_re_[0];
+    setup.ps_reference_im = &reference_im_[0];
+    setup.ps_reference_length = reference_re_.size();
+
+    if (params.is_mandelbrot) {
+        setup.ps_rebase_re = setup.ps_reference_re;
+        setup.ps_rebase_im = setup.ps_reference_im;
+        setup.ps_rebase_length = setup.ps_reference_length;
+    } else {
+        setup.ps_rebase_re = &critical_re_[0];
+        setup.ps_rebase_im = &critical_im_[0];
+        setup.ps_rebase_length = critical_re_.size();
+    }
+
+    setup.ps_max_iterations = params.max_iterations;
+    setup.ps_is_mandelbrot = params.is_mandelbrot != 0;
+    setup.ps_scale_x = 1.5 / (0.5 * view.dz_zoom * params.width);
+    setup.ps_scale_y = 1.0 / (0.5 * view.dz_zoom * params.height);
+    setup.ps_half_width = 0.5 * params.width;
+    setup.ps_half_height = 0.5 * params.height;
+    setup.ps_skipped = approximate_series(
+        params, setup.ps_scale_x, setup.ps_scale_y, setup.ps_series);
+
+    skipped_iterations_ = setup.ps_skipped;
+
+    for_each_tile(x0, y0, x1, y1, jobs,
+        [&](v8_int32_t tx0, v8_int32_t ty0, v8_int32_t tx1, v8_int32_t ty1) {
+        for (v8_int32_t y = ty0; y < ty1; ++y) {
+            const double dy = (y - setup.ps_half_height) * setup.ps_scale_y;
+            float* row = values + y * pitch;
+
+            for (v8_int32_t x = tx0; x < tx1; ++x) {
+                const double dx = (x - setup.ps_half_width) * setup.ps_scale_x;
+                row[x] = iterate_pixel(setup, dx, dy);
+            }
+        }
+    });
+}
+
+void fractal_deep_zoom_renderer::update_orbits(
+    const fractal_params_t&     params,
+    const deep_zoom_view_t&     view
+    ) {
+    const v8_int32_t fraction_limbs = std::max(
+        view.required_fraction_limbs(params.width, params.height),
+        std::max(view.dz_center_re.get_fraction_limbs(),
+                 view.dz_center_im.get_fraction_limbs()));
+
+    if (orbit_valid_
+        && orbit_center_re_ == view.dz_center_re
+        && orbit_center_im_ == view.dz_center_im
+        && orbit_iterations_ == params.max_iterations
+        && orbit_is_mandelbrot_ == params.is_mandelbrot
+        && orbit_fraction_limbs_ >= fraction_limbs
+        && (params.is_mandelbrot
+            || (orbit_c_real_ == params.C_real && orbit_c_imag_ == params.C_imag))) {
+        return;
+    }
+
+    const deep_real zero;
+
+    if (params.is_mandelbrot) {
+        compute_orbit(zero, zero, view.dz_center_re, view.dz_center_im,
+                      params.max_iterations, fraction_limbs,
+                      &reference_re_, &reference_im_);
+        critical_re_.clear();
+        critical_im_.clear();
+    } else {
+        const deep_real c_re(params.C_real, fraction_limbs);
+        const deep_real c_im(params.C_imag, fraction_limbs);
+
+        compute_orbit(view.dz_center_re, view.dz_center_im, c_re, c_im,
+                      params.max_iterations, fraction_limbs,
+                      &reference_re_, &reference_im_);
+        compute_orbit(zero, zero, c_re, c_im,
+                      params.max_iterations, fraction_limbs,
+                      &critical_re_, &critical_im_);
+    }
+
+    orbit_center_re_ = view.dz_center_re;
+    orbit_center_im_ = view.dz_center_im;
+    orbit_c_real_ = params.C_real;
+    orbit_c_imag_ = params.C_imag;
+    orbit_iterations_ = params.max_iterations;
+    orbit_fraction_limbs_ = fraction_limbs;
+    orbit_is_mandelbrot_ = params.is_mandelbrot;
+    orbit_valid_ = true;
+}
+
+v8_int32_t fractal_deep_zoom_renderer::approximate_series(
+    const fractal_params_t&     params,
+    double                      scale_x,
+    double                      scale_y,
+    double*                     coefficients
+    ) const {
+    const bool is_mandelbrot = params.is_mandelbrot != 0;
+    const v8_int32_t limit = std::min(
+        params.max_iterations, static_cast<v8_int32_t>(reference_re_.size()) - 1);
+
+    //
+    // Probes : the corners and the middle of the edges.
+    const double half_w = 0.5 * params.width;
+    const double half_h = 0.5 * params.height;
+    const double probe_x[] = { -half_w, half_w, -half_w, half_w, 0.0, 0.0, -half_w, half_w };
+    const double probe_y[] = { -half_h, -half_h, half_h, half_h, -half_h, half_h, 0.0, 0.0 };
+    const v8_int32_t probe_count = 8;
+
+    double max_delta = 0.0;
+    complex_t probe_delta[probe_count];
+    for (v8_int32_t p = 0; p < probe_count; ++p) {
+        probe_delta[p] = complex_t(probe_x[p] * scale_x, probe_y[p] * scale_y);
+        max_delta = std::max(max_delta, std::abs(probe_delta[p]));
+    }
+
+    //
+    // d(n + 1) = 2 Z(n) d(n) + d(n)^2 + dc gives
+    //  A(n + 1) = 2 Z(n) A(n) + 1 (Mandelbrot) or 2 Z(n) A(n) (Julia)
+    //  B(n + 1) = 2 Z(n) B(n) + A(n)^2
+    //  C(n + 1) = 2 Z(n) C(n) + 2 A(n) B(n)
+    std::vector<complex_t> series_a(1, complex_t(is_mandelbrot ? 0.0 : 1.0, 0.0));
+    std::vector<complex_t> series_b(1, complex_t());
+    std::vector<complex_t> series_c(1, complex_t());
+
+    const double delta2 = max_delta * max_delta;
+    for (v8_int32_t n = 0; n < limit; ++n) {
+        const complex_t z2(2.0 * reference_re_[n], 2.0 * reference_im_[n]);
+        const complex_t a = series_a[n];
+        const complex_t b = series_b[n];
+
+        const complex_t next_a = z2 * a + complex_t(is_mandelbrot ? 1.0 : 0.0, 0.0);
+        const complex_t next_b = z2 * b + a * a;
+        const complex_t next_c = z2 * series_c[n] + 2.0 * a * b;
+
+        if (!(std::abs(next_c) * delta2 <= C_Series_Tolerance * std::abs(next_a))) {
+            break;
+        }
+
+        series_a.push_back(next_a);
+        series_b.push_back(next_b);
+        series_c.push_back(next_c);
+    }
+
+    v8_int32_t skip = static_cast<v8_int32_t>(series_a.size()) - 1;
+
+    //
+    // The probes are iterated explicitly up to the candidate skip count; a
+    // pixel must not skip past an escape or a rebase.
+    std::vector<complex_t> probe_orbit[probe_count];
+    for (v8_int32_t p = 0; p < probe_count; ++p) {
+        const complex_t dc = is_mandelbrot ? probe_delta[p] : complex_t();
+        complex_t d = is_mandelbrot ? complex_t() : probe_delta[p];
+
+        probe_orbit[p].push_back(d);
+        for (v8_int32_t n = 0; n < skip; ++n) {
+            const complex_t ref(reference_re_[n], reference_im_[n]);
+            const double radius = fractal_cpu_renderer::C_Bailout_Radius;
+            const double magnitude = std::norm(ref + d);
+
+            if (magnitude > radius * radius || magnitude < std::norm(d)) {
+                skip = n;
+                break;
+            }
+
+            d = 2.0 * ref * d + d * d + dc;
+            probe_orbit[p].push_back(d);
+        }
+    }
+
+    for (; skip > 0; skip /= 2) {
+        bool valid = true;
+
+        for (v8_int32_t p = 0; p < probe_count && valid; ++p) {
+            const complex_t x = probe_delta[p];
+            const complex_t approx =
+                x * (series_a[skip] + x * (series_b[skip] + x * series_c[skip]));
+            const complex_t exact = probe_orbit[p][skip];
+
+            valid = std::abs(approx - exact) <= C_Probe_Tolerance * std::abs(exact);
+        }
+
+        if (valid) {
+            break;
+        }
+    }
+
+    const complex_t* terms[] = { &series_a[skip], &series_b[skip], &series_c[skip] };
+    for (int i = 0; i < 3; ++i) {
+        coefficients[i * 2 + 0] = terms[i]->real();
+        coefficients[i * 2 + 1] = terms[i]->imag();
+    }
+
+    return skip;
+}
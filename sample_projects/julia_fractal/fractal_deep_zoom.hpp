@@ -0,0 +1,241 @@
+#pragma once
+
+#include <vector>
+
+#include <v8/v8.hpp>
+
+#include "fractal_params.hpp"
+
+namespace v8 { namespace base {
+class job_system;
+} // namespace base
+} // namespace v8
+
+///
+/// \brief  Signed fixed point real, with a 32 bits integer part and a
+///         configurable number of 32 bits fraction limbs. Used for the
+///         coordinates of deep zoom views, that need more precision than a
+///         double holds.
+/// \remarks    Products are truncated to the precision of the most precise
+///             operand. The integer part must stay below 2^32 in magnitude.
+class deep_real {
+public :
+
+    ///
+    /// \brief Fraction limbs of values created without an explicit precision.
+    static const v8_int32_t C_Default_Fraction_Limbs = 4;
+
+public :
+
+    deep_real();
+
+    explicit deep_real(
+        double      value,
+        v8_int32_t  fraction_limbs = C_Default_Fraction_Limbs
+        );
+
+    ///
+    /// \brief  Parses a decimal number ("-0.7436438870371587047521915").
+    /// \returns    False if the string is not a number, the value is left
+    ///             unchanged.
+    bool parse(const char* str, v8_int32_t fraction_limbs = C_Default_Fraction_Limbs);
+
+    double to_double() const;
+
+    v8_int32_t get_fraction_limbs() const {
+        return static_cast<v8_int32_t>(limbs_.size()) - 1;
+    }
+
+    ///
+    /// \brief Changes the precision (extra limbs are zero, dropped limbs
+    ///        truncate the value).
+    void set_fraction_limbs(v8_int32_t fraction_limbs);
+
+    bool is_negative() const {
+        return negative_;
+    }
+
+    deep_real& operator+=(const deep_real& rhs);
+
+    deep_real& operator-=(const deep_real& rhs);
+
+    deep_real& operator*=(const deep_real& rhs);
+
+    deep_real operator-() const;
+
+    bool operator==(const deep_real& rhs) const;
+
+    bool operator!=(const deep_real& rhs) const {
+        return !(*this == rhs);
+    }
+
+private :
+
+    //
+    // Adds rhs, with its sign replaced by rhs_negative.
+    void add(const deep_real& rhs, bool rhs_negative);
+
+    //
+    // Limb i of rhs, aligned on the precision of this value.
+    v8_uint32_t aligned_limb(const deep_real& rhs, v8_size_t i) const;
+
+    bool is_zero() const;
+
+    //! Sign of the value.
+    bool                                                    negative_;
+    //! Magnitude, least significant limb first; the last limb is the
+    //! integer part.
+    std::vector<v8_uint32_t>                                limbs_;
+};
+
+inline deep_real operator+(deep_real lhs, const deep_real& rhs) {
+    lhs += rhs;
+    return lhs;
+}
+
+inline deep_real operator-(deep_real lhs, const deep_real& rhs) {
+    lhs -= rhs;
+    return lhs;
+}
+
+inline deep_real operator*(deep_real lhs, const deep_real& rhs) {
+    lhs *= rhs;
+    return lhs;
+}
+
+///
+/// \brief  Deep zoom view : the center of the image, in fixed point, and the
+///         zoom factor, as a double (the pixel spacing stays far above the
+///         smallest double at any practical depth).
+/// \remarks    Pixel (x, y) maps to the same point as with fractal_params_t,
+///             with dz_center_re/dz_center_im in place of offset_x/offset_y
+///             and dz_zoom in place of zoom_factor.
+struct deep_zoom_view_t {
+    deep_real                                               dz_center_re;
+    deep_real                                               dz_center_im;
+    double                                                  dz_zoom;
+
+    deep_zoom_view_t() : dz_zoom(1.0) {}
+
+    ///
+    /// \brief Takes the center and zoom factor of params.
+    explicit deep_zoom_view_t(const fractal_params_t& params);
+
+    ///
+    /// \brief  Fraction limbs the center needs to address single pixels of a
+    ///         width x height image.
+    v8_int32_t required_fraction_limbs(v8_int32_t width, v8_int32_t height) const;
+};
+
+///
+/// \brief  Renders Julia/Mandelbrot views zoomed far past the precision of
+///         float or double coordinates (1e-30 and deeper), with perturbation.
+/// \remarks    The orbit of the view center is computed once, in fixed point.
+///             Every pixel then iterates, in double, its difference to that
+///             reference orbit :
+///                 d(n + 1) = 2 Z(n) d(n) + d(n)^2 + dc
+///             (dc is the offset of the pixel for the Mandelbrot set and
+///             zero for Julia sets, where the offset is d(0)).
+///
+///             The first iterations are skipped : d(n) is approximated by
+///             the series A(n) dc + B(n) dc^2 + C(n) dc^3 while its cubic
+///             term stays negligible, and the skip count is checked against
+///             pixels iterated explicitly at the corners and the edges of
+///             the image.
+///
+///             When |Z(m) + d| falls below |d|, the difference no longer
+///             holds enough precision (a glitch) and the pixel is rebased :
+///             d becomes the full value z and the pixel follows the orbit
+///             of the critical point 0 from its start. For the Mandelbrot
+///             set that orbit is the reference orbit itself, for Julia sets
+///             it is a second orbit computed alongside the first. Pixels
+///             that outlive the reference orbit are rebased the same way.
+///
+///             The orbits are kept between calls and recomputed only when
+///             the center, the shape constant, the iteration count or the
+///             needed precision changes; zooming in place only reruns the
+///             series approximation.
+///
+///             Values have the same meaning as with
+///             fractal_cpu_renderer::compute_iterations and can be colored
+///             with fractal_cpu_renderer::colorize.
+class fractal_deep_zoom_renderer {
+public :
+
+    fractal_deep_zoom_renderer();
+
+    ///
+    /// \brief  Computes the smooth iteration counts of the pixels in the
+    ///         [x0, x1) x [y0, y1) region of a params.width x params.height
+    ///         image centered on the view. params.zoom_factor and the
+    ///         offsets are ignored.
+    /// \param  values  Iteration counts of the whole image; value (x, y) is
+    ///                 stored at values[y * pitch + x].
+    void compute_iterations(
+        const fractal_params_t&     params,
+        const deep_zoom_view_t&     view,
+        v8_int32_t                  x0,
+        v8_int32_t                  y0,
+        v8_int32_t                  x1,
+        v8_int32_t                  y1,
+        float*                      values,
+        v8_size_t                   pitch,
+        v8::base::job_system*       jobs = nullptr
+        );
+
+    ///
+    /// \brief Iterations skipped by the series approximation in the last
+    ///        call to compute_iterations.
+    v8_int32_t get_skipped_iterations() const {
+        return skipped_iterations_;
+    }
+
+    ///
+    /// \brief Length of the reference orbit used by the last call to
+    ///        compute_iterations.
+    v8_size_t get_reference_length() const {
+        return reference_re_.size();
+    }
+
+private :
+
+    ///
+    /// \brief Recomputes the orbits if the view or the parameters they
+    ///        depend on changed.
+    void update_orbits(
+        const fractal_params_t&     params,
+        const deep_zoom_view_t&     view
+        );
+
+    ///
+    /// \brief  Series coefficients for the current view, returns the number
+    ///         of iterations they skip.
+    v8_int32_t approximate_series(
+        const fractal_params_t&     params,
+        double                      scale_x,
+        double                      scale_y,
+        double*                     coefficients
+        ) const;
+
+    //! Reference orbit (orbit of the view center), rounded to doubles.
+    std::vector<double>                                     reference_re_;
+    std::vector<double>                                     reference_im_;
+    //! Orbit of the critical point, that rebased Julia pixels follow.
+    std::vector<double>                                     critical_re_;
+    std::vector<double>                                     critical_im_;
+
+    //! View the orbits were computed for.
+    deep_real                                               orbit_center_re_;
+    deep_real                                               orbit_center_im_;
+    float                                                   orbit_c_real_;
+    float                                                   orbit_c_imag_;
+    v8_int32_t                                              orbit_iterations_;
+    v8_int32_t                                              orbit_fraction_limbs_;
+    v8_int32_t                                              orbit_is_mandelbrot_;
+    bool                                                    orbit_valid_;
+
+    v8_int32_t                                              skipped_iterations_;
+
+private :
+    NO_CC_ASSIGN(fractal_deep_zoom_renderer);
+};
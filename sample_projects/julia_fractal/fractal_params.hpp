@@ -0,0 +1,30 @@
+#pragma once
+
+#include <v8/v8.hpp>
+#include <v8/math/vector2.hpp>
+
+///
+/// \brief Fractal parameters, passed to the pixel shader and to the CPU
+///        renderer (see fractal_cpu_renderer).
+/// \remarks Pixel (x, y) maps to the point
+///          (1.5 * (x - width / 2) / (0.5 * zoom_factor * width) + offset_x,
+///           (y - height / 2) / (0.5 * zoom_factor * height) + offset_y)
+///          of the complex plane.
+struct fractal_params_t {
+    v8_int32_t                                                      is_mandelbrot;
+    v8_int32_t                                                      use_color_table;
+    v8_int32_t                                                      width;
+    v8_int32_t                                                      height;
+    v8_int32_t                                                      max_iterations;
+    float                                                           zoom_factor;
+    float                                                           offset_x;
+    float                                                           offset_y;
+    ///< Shape constant, real part.
+    float                                                           C_real;
+    ///< Shape constant, imaginary part.
+    float                                                           C_imag;
+    v8::math::vector2<v8_int_t>                                     C_origin;
+
+    ~fractal_params_t() {
+    }
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <algorithm>
+
+#include <v8/v8.hpp>
+#include <v8/base/job_system.hpp>
+
+///
+/// \brief Width and height, in pixels, of the tiles the CPU renderers
+///        distribute across threads.
+const v8_int32_t C_Fractal_Tile_Size = 64;
+
+///
+/// \brief Splits a region into tiles and runs fn(x0, y0, x1, y1) for every
+///        tile, on the threads of the job system when one is given.
+template<typename tile_function>
+inline void for_each_tile(
+    v8_int32_t              x0,
+    v8_int32_t              y0,
+    v8_int32_t              x1,
+    v8_int32_t              y1,
+    v8::base::job_system*   jobs,
+    tile_function           fn
+    ) {
+    const v8_int32_t tile = C_Fractal_Tile_Size;
+    const v8_int32_t tiles_x = (x1 - x0 + tile - 1) / tile;
+    const v8_int32_t tiles_y = (y1 - y0 + tile - 1) / tile;
+
+    if (tiles_x <= 0 || tiles_y <= 0) {
+        return;
+    }
+
+    auto run_tiles = [&](v8_size_t first, v8_size_t last) {
+        for (v8_size_t idx = first; idx < last; ++idx) {
+            const v8_int32_t tx = x0 + static_cast<v8_int32_t>(idx % tiles_x) * tile;
+            const v8_int32_t ty = y0 + static_cast<v8_int32_t>(idx / tiles_x) * tile;
+            fn(tx, ty, std::min(tx + tile, x1), std::min(ty + tile, y1));
+        }
+    };
+
+    const v8_size_t tile_count = static_cast<v8_size_t>(tiles_x) * tiles_y;
+
+    //
+    // One tile per task : the cost of a tile varies a lot (points inside
+    // the set run all the iterations), work stealing evens it out.
+    if (jobs && tile_count > 1) {
+        jobs->parallel_for(0, tile_count, 1, run_tiles);
+    } else {
+        run_tiles(0, tile_count);
+    }
+}
@@ -0,0 +1,491 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <v8/base/job_system.hpp>
+
+#include "fractal_cpu_renderer.hpp"
+#include "fractal_tiles.hpp"
+#include "fractal_view_cache.hpp"
+
+namespace {
+
+//
+// Sample rows computed between two checks of the time budget.
+const v8_int32_t C_Band_Rows = 8;
+
+//
+// Pixel spacing of a view, along x and y (see fractal_params_t).
+double view_scale_x(const fractal_params_t& params) {
+    return 1.5 / (0.5 * params.zoom_factor * params.width);
+}
+
+double view_scale_y(const fractal_params_t& params) {
+    return 1.0 / (0.5 * params.zoom_factor * params.height);
+}
+
+} // anonymous namespace
+
+const v8_int32_t fractal_view_cache::C_Coarse_Step;
+
+const v8_uint8_t fractal_view_cache::C_No_Sample;
+
+fractal_view_cache::fractal_view_cache(const fractal_cpu_renderer& renderer)
+    : renderer_(renderer),
+      view_(),
+      valid_(false),
+      pass_step_(0),
+      pass_is_first_(false),
+      pass_row_(0),
+      colors_valid_(false),
+      copy_ms_(0.0f) {}
+
+bool fractal_view_cache::update(
+    const fractal_params_t&     params,
+    float                       budget_ms,
+    v8::base::job_system*       jobs
+    ) {
+    typedef std::chrono::steady_clock clock_type;
+    const clock_type::time_point start = clock_type::now();
+
+    auto elapsed_ms = [&]() -> float {
+        const std::chrono::duration<float, std::milli> elapsed =
+            clock_type::now() - start;
+        return elapsed.count();
+    };
+
+    //
+    // A band is only started if it fits in what remains of the budget,
+    // assuming it takes as long as the slowest one so far.
+    bool in_band = false;
+    float band_start = 0.0f;
+    float band_ms = 0.0f;
+    auto out_of_time = [&]() -> bool {
+        const float now = elapsed_ms();
+        if (in_band) {
+            band_ms = std::max(band_ms, now - band_start);
+        }
+        in_band = true;
+        band_start = now;
+        return budget_ms > 0.0f && now + band_ms >= budget_ms;
+    };
+
+    if (!valid_
+        || params.width != view_.width
+        || params.height != view_.height
+        || params.max_iterations != view_.max_iterations
+        || params.is_mandelbrot != view_.is_mandelbrot
+        || params.C_real != view_.C_real
+        || params.C_imag != view_.C_imag) {
+        reset(params);
+    } else {
+        if (params.use_color_table != view_.use_color_table) {
+            colors_valid_ = false;
+        }
+
+        if (params.zoom_factor != view_.zoom_factor) {
+            reproject(params, jobs);
+        } else if (params.offset_x != view_.offset_x
+                   || params.offset_y != view_.offset_y) {
+            pan(params);
+        }
+    }
+
+    view_.use_color_table = params.use_color_table;
+    view_.C_origin = params.C_origin;
+
+    const v8_int32_t width = view_.width;
+
+    if (!colors_valid_) {
+        renderer_.colorize(view_, &values_[0], width,
+                           reinterpret_cast<v8_uint8_t*>(&colors_[0]),
+                           width * sizeof(v8_uint32_t), jobs);
+        colors_valid_ = true;
+    }
+
+    //
+    // Strips exposed by pans first, a band of rows at a time.
+    while (!strips_.empty()) {
+        if (out_of_time()) {
+            return false;
+        }
+
+        strip_t& strip = strips_.back();
+        const v8_int32_t y1 = std::min(strip.st_y0 + C_Band_Rows, strip.st_y1);
+
+        compute_samples(strip.st_x0, strip.st_y0, strip.st_x1, y1, 1, 1, jobs);
+        for (v8_int32_t y = strip.st_y0; y < y1; ++y) {
+            memset(&spacing_[y * width + strip.st_x0], 0, strip.st_x1 - strip.st_x0);
+        }
+
+        strip.st_y0 = y1;
+        if (strip.st_y0 == strip.st_y1) {
+            strips_.pop_back();
+        }
+    }
+
+    while (pass_step_ != 0) {
+        if (out_of_time()) {
+            return false;
+        }
+
+        //
+        // Rows of a pass come in groups of 2 * step (one group of step for
+        // the first pass), bands hold whole groups.
+        const v8_int32_t group = pass_is_first_ ? pass_step_ : pass_step_ * 2;
+        const v8_int32_t y1 = std::min(pass_row_ + C_Band_Rows * group, view_.height);
+
+        refine_rows(pass_row_, y1, jobs);
+        pass_row_ = y1;
+
+        if (pass_row_ == view_.height) {
+            pass_step_ /= 2;
+            pass_is_first_ = false;
+            pass_row_ = 0;
+        }
+    }
+
+    return true;
+}
+
+bool fractal_view_cache::render(
+    const fractal_params_t&     params,
+    float                       budget_ms,
+    v8_uint8_t*                 pixels,
+    v8_size_t                   pitch,
+    v8::base::job_system*       jobs
+    ) {
+    typedef std::chrono::steady_clock clock_type;
+
+    //
+    // The budget covers the copy too; the last one tells how long it takes.
+    const float update_budget = budget_ms > 0.0f
+        ? std::max(budget_ms - copy_ms_, std::numeric_limits<float>::min())
+        : 0.0f;
+    const bool complete = update(params, update_budget, jobs);
+
+    const clock_type::time_point start = clock_type::now();
+    const v8_size_t row_bytes = view_.width * sizeof(v8_uint32_t);
+    for (v8_int32_t y = 0; y < view_.height; ++y) {
+        memcpy(pixels + y * pitch, &colors_[y * view_.width], row_bytes);
+    }
+
+    const std::chrono::duration<float, std::milli> elapsed = clock_type::now() - start;
+    copy_ms_ = elapsed.count();
+    return complete;
+}
+
+void fractal_view_cache::compute_samples(
+    v8_int32_t              x0,
+    v8_int32_t              y0,
+    v8_int32_t              x1,
+    v8_int32_t              y1,
+    v8_int32_t              step_x,
+    v8_int32_t              step_y,
+    v8::base::job_system*   jobs
+    ) {
+    const v8_int32_t width = view_.width;
+    renderer_.compute_samples(view_, x0, y0, x1, y1, step_x, step_y,
+                              &values_[0], width, jobs);
+    renderer_.colorize_samples(view_, x0, y0, x1, y1, step_x, step_y,
+                               &values_[0], width,
+                               reinterpret_cast<v8_uint8_t*>(&colors_[0]),
+                               width * sizeof(v8_uint32_t), jobs);
+}
+
+v8_uint32_t fractal_view_cache::inside_color() const {
+    const float value = fractal_cpu_renderer::C_Inside;
+    v8_uint32_t color = 0;
+    renderer_.colorize_samples(view_, 0, 0, 1, 1, 1, 1, &value, 1,
+                               reinterpret_cast<v8_uint8_t*>(&color),
+                               sizeof(color));
+    return color;
+}
+
+void fractal_view_cache::reset(const fractal_params_t& params) {
+    view_ = params;
+    valid_ = true;
+
+    const v8_size_t count = static_cast<v8_size_t>(params.width) * params.height;
+    values_.assign(count, fractal_cpu_renderer::C_Inside);
+    spacing_.assign(count, C_No_Sample);
+    colors_.assign(count, inside_color());
+    colors_valid_ = true;
+    strips_.clear();
+
+    //
+    // The buffers of the reprojections are allocated (and their pages
+    // touched) now, not during the first zoom, that has a time budget.
+    old_values_.resize(count);
+    old_spacing_.resize(count);
+    old_colors_.resize(count);
+
+    pass_step_ = C_Coarse_Step;
+    pass_is_first_ = true;
+    pass_row_ = 0;
+}
+
+void fractal_view_cache::pan(const fractal_params_t& params) {
+    const double scale_x = view_scale_x(view_);
+    const double scale_y = view_scale_y(view_);
+    const v8_int32_t width = view_.width;
+    const v8_int32_t height = view_.height;
+
+    //
+    // Pixel (x, y) of the new view is pixel (x + dx, y + dy) of the cache.
+    const v8_int32_t dx = static_cast<v8_int32_t>(
+        std::floor((params.offset_x - view_.offset_x) / scale_x + 0.5));
+    const v8_int32_t dy = static_cast<v8_int32_t>(
+        std::floor((params.offset_y - view_.offset_y) / scale_y + 0.5));
+
+    if (dx == 0 && dy == 0) {
+        return;
+    }
+
+    if (std::abs(dx) >= width || std::abs(dy) >= height) {
+        reset(params);
+        return;
+    }
+
+    view_.offset_x = static_cast<float>(view_.offset_x + dx * scale_x);
+    view_.offset_y = static_cast<float>(view_.offset_y + dy * scale_y);
+
+    //
+    // Rows are moved in place, in the order that reads every row before
+    // it is overwritten.
+    const v8_int32_t dst_x = std::max(-dx, 0);
+    const v8_int32_t src_x = std::max(dx, 0);
+    const v8_int32_t run = width - std::abs(dx);
+    const v8_uint32_t inside = inside_color();
+
+    for (v8_int32_t i = 0; i < height; ++i) {
+        const v8_int32_t y = dy > 0 ? i : height - 1 - i;
+        const v8_int32_t src_y = y + dy;
+        float* values = &values_[y * width];
+        v8_uint8_t* spacing = &spacing_[y * width];
+        v8_uint32_t* colors = &colors_[y * width];
+
+        if (src_y < 0 || src_y >= height) {
+            std::fill(values, values + width, fractal_cpu_renderer::C_Inside);
+            memset(spacing, C_No_Sample, width);
+            std::fill(colors, colors + width, inside);
+            continue;
+        }
+
+        memmove(values + dst_x, &values_[src_y * width + src_x], run * sizeof(float));
+        memmove(spacing + dst_x, &spacing_[src_y * width + src_x], run);
+        memmove(colors + dst_x, &colors_[src_y * width + src_x],
+                run * sizeof(v8_uint32_t));
+
+        const v8_int32_t hole_x = dx > 0 ? run : 0;
+        std::fill(values + hole_x, values + hole_x + std::abs(dx),
+                  fractal_cpu_renderer::C_Inside);
+        memset(spacing + hole_x, C_No_Sample, std::abs(dx));
+        std::fill(colors + hole_x, colors + hole_x + std::abs(dx), inside);
+    }
+
+    //
+    // Pending strips move with the image.
+    std::vector<strip_t> strips;
+    for (v8_size_t i = 0; i < strips_.size(); ++i) {
+        strip_t strip = strips_[i];
+        strip.st_x0 = std::max(strip.st_x0 - dx, 0);
+        strip.st_x1 = std::min(strip.st_x1 - dx, width);
+        strip.st_y0 = std::max(strip.st_y0 - dy, 0);
+        strip.st_y1 = std::min(strip.st_y1 - dy, height);
+
+        if (strip.st_x0 < strip.st_x1 && strip.st_y0 < strip.st_y1) {
+            strips.push_back(strip);
+        }
+    }
+
+    //
+    // Exposed rows across the whole width, exposed columns between them.
+    const v8_int32_t rows_y0 = dy > 0 ? height - dy : 0;
+    const v8_int32_t rows_y1 = dy > 0 ? height : -dy;
+    if (dy != 0) {
+        const strip_t rows = { 0, rows_y0, width, rows_y1 };
+        strips.push_back(rows);
+    }
+
+    if (dx != 0) {
+        const strip_t columns = {
+            dx > 0 ? width - dx : 0,
+            dy > 0 ? 0 : rows_y1,
+            dx > 0 ? width : -dx,
+            dy > 0 ? rows_y0 : height
+        };
+        strips.push_back(columns);
+    }
+
+    strips_.swap(strips);
+}
+
+void fractal_view_cache::reproject(
+    const fractal_params_t&     params,
+    v8::base::job_system*       jobs
+    ) {
+    const fractal_params_t old_view = view_;
+    const double old_scale_x = view_scale_x(old_view);
+    const double old_scale_y = view_scale_y(old_view);
+
+    view_ = params;
+    const double scale_x = view_scale_x(view_);
+    const double scale_y = view_scale_y(view_);
+    const v8_int32_t width = view_.width;
+    const v8_int32_t height = view_.height;
+
+    //
+    // The mapping is separable : the old pixel nearest to each column and
+    // row, -1 outside the old image.
+    std::vector<v8_int32_t> old_x(width);
+    std::vector<v8_int32_t> old_y(height);
+
+    const double origin_x = view_.offset_x - 0.5 * width * scale_x;
+    const double old_origin_x = old_view.offset_x - 0.5 * width * old_scale_x;
+    for (v8_int32_t x = 0; x < width; ++x) {
+        const double pos = std::floor(
+            (origin_x + x * scale_x - old_origin_x) / old_scale_x + 0.5);
+        old_x[x] = pos >= 0.0 && pos < width ? static_cast<v8_int32_t>(pos) : -1;
+    }
+
+    const double origin_y = view_.offset_y - 0.5 * height * scale_y;
+    const double old_origin_y = old_view.offset_y - 0.5 * height * old_scale_y;
+    for (v8_int32_t y = 0; y < height; ++y) {
+        const double pos = std::floor(
+            (origin_y + y * scale_y - old_origin_y) / old_scale_y + 0.5);
+        old_y[y] = pos >= 0.0 && pos < height ? static_cast<v8_int32_t>(pos) : -1;
+    }
+
+    //
+    // A sample of the old view is ratio pixels of the new one apart from
+    // its neighbours; that is the spacing reprojected pixels get.
+    const double ratio = old_scale_x / scale_x;
+    v8_uint8_t spacing_of[256];
+    for (v8_int32_t s = 0; s < 256; ++s) {
+        const double spacing = std::ceil(std::max(s, 1) * ratio);
+        spacing_of[s] = s == C_No_Sample
+            ? C_No_Sample
+            : static_cast<v8_uint8_t>(std::min(std::max(spacing, 1.0),
+                                               static_cast<double>(C_No_Sample - 1)));
+    }
+
+    old_values_.swap(values_);
+    old_spacing_.swap(spacing_);
+    old_colors_.swap(colors_);
+    values_.resize(old_values_.size());
+    spacing_.resize(old_spacing_.size());
+    colors_.resize(old_colors_.size());
+
+    //
+    // Whole rows per task, row pointers kept in locals : the byte stores to
+    // the spacings would otherwise reload every vector's data at each pixel.
+    const v8_int32_t* columns = &old_x[0];
+    const v8_uint32_t inside = inside_color();
+
+    auto copy_rows = [&](v8_size_t first, v8_size_t last) {
+        for (v8_size_t y = first; y < last; ++y) {
+            float* dst_values = &values_[y * width];
+            v8_uint8_t* dst_spacing = &spacing_[y * width];
+            v8_uint32_t* dst_colors = &colors_[y * width];
+
+            if (old_y[y] < 0) {
+                std::fill(dst_values, dst_values + width, fractal_cpu_renderer::C_Inside);
+                memset(dst_spacing, C_No_Sample, width);
+                std::fill(dst_colors, dst_colors + width, inside);
+                continue;
+            }
+
+            const v8_size_t src_row = static_cast<v8_size_t>(old_y[y]) * width;
+            const float* src_values = &old_values_[src_row];
+            const v8_uint8_t* src_spacing = &old_spacing_[src_row];
+            const v8_uint32_t* src_colors = &old_colors_[src_row];
+
+            for (v8_int32_t x = 0; x < width; ++x) {
+                const v8_int32_t src = columns[x];
+
+                if (src < 0) {
+                    dst_values[x] = fractal_cpu_renderer::C_Inside;
+                    dst_spacing[x] = C_No_Sample;
+                    dst_colors[x] = inside;
+                } else {
+                    dst_values[x] = src_values[src];
+                    dst_spacing[x] = spacing_of[src_spacing[src]];
+                    dst_colors[x] = src_colors[src];
+                }
+            }
+        }
+    };
+
+    if (jobs) {
+        jobs->parallel_for(0, height, C_Band_Rows, copy_rows);
+    } else {
+        copy_rows(0, height);
+    }
+
+    strips_.clear();
+    pass_step_ = C_Coarse_Step;
+    pass_is_first_ = true;
+    pass_row_ = 0;
+}
+
+void fractal_view_cache::refine_rows(
+    v8_int32_t              y0,
+    v8_int32_t              y1,
+    v8::base::job_system*   jobs
+    ) {
+    const v8_int32_t step = pass_step_;
+    const v8_int32_t width = view_.width;
+
+    if (pass_is_first_) {
+        compute_samples(0, y0, width, y1, step, step, jobs);
+        fill_blocks(0, y0, y1, step, step, step);
+        return;
+    }
+
+    //
+    // The grid of spacing step adds, to the grid of spacing 2 * step, the
+    // odd rows and the odd columns of the even rows.
+    compute_samples(0, y0 + step, width, y1, step, step * 2, jobs);
+    fill_blocks(0, y0 + step, y1, step, step * 2, step);
+
+    compute_samples(step, y0, width, y1, step * 2, step * 2, jobs);
+    fill_blocks(step, y0, y1, step * 2, step * 2, step);
+}
+
+void fractal_view_cache::fill_blocks(
+    v8_int32_t  x0,
+    v8_int32_t  y0,
+    v8_int32_t  y1,
+    v8_int32_t  step_x,
+    v8_int32_t  step_y,
+    v8_int32_t  step
+    ) {
+    const v8_int32_t width = view_.width;
+    const v8_int32_t height = view_.height;
+
+    for (v8_int32_t y = y0; y < y1; y += step_y) {
+        for (v8_int32_t x = x0; x < width; x += step_x) {
+            const v8_size_t anchor = static_cast<v8_size_t>(y) * width + x;
+            const float value = values_[anchor];
+            const v8_uint32_t color = colors_[anchor];
+            spacing_[anchor] = 0;
+
+            const v8_int32_t block_y1 = std::min(y + step, height);
+            const v8_int32_t block_x1 = std::min(x + step, width);
+
+            for (v8_int32_t by = y; by < block_y1; ++by) {
+                for (v8_int32_t bx = x; bx < block_x1; ++bx) {
+                    const v8_size_t idx = static_cast<v8_size_t>(by) * width + bx;
+                    if (spacing_[idx] > step) {
+                        values_[idx] = value;
+                        colors_[idx] = color;
+                        spacing_[idx] = static_cast<v8_uint8_t>(step);
+                    }
+                }
+            }
+        }
+    }
+}
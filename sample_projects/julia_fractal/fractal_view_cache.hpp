@@ -0,0 +1,197 @@
+#pragma once
+
+#include <vector>
+
+#include <v8/v8.hpp>
+
+#include "fractal_params.hpp"
+
+namespace v8 { namespace base {
+class job_system;
+} // namespace base
+} // namespace v8
+
+class fractal_cpu_renderer;
+
+///
+/// \brief  Iteration counts of the last view rendered on the CPU, updated
+///         incrementally when the view moves.
+/// \remarks    Each pixel keeps, next to its smooth iteration count, the
+///             spacing of the sample it was taken from (0 once the pixel
+///             itself has been computed).
+///
+///             A pan shifts the buffer by whole pixels and computes only
+///             the strips that come into view; the offsets are snapped to
+///             the pixel grid of the cached image (see get_view).
+///
+///             A zoom reprojects the old counts as a preview, then refines
+///             the image in coarse to fine passes : the pixels on a grid of
+///             C_Coarse_Step pixels, then the pixels added by each halving
+///             of the grid. After every pass each pixel not computed yet
+///             shows the finest sample above and to its left, so the image
+///             sharpens progressively; no sample is computed twice.
+///
+///             Any other change (size, shape, iterations) restarts the
+///             passes from an empty buffer.
+///
+///             The colors are kept next to the counts and follow the same
+///             moves; only the samples computed by an update are converted,
+///             so a pass over coarse samples colorizes at its own resolution.
+///
+///             Work stops before a band of rows that would not fit in the
+///             time budget of an update (judging by the previous band) and
+///             resumes on the next update, so a view change always produces
+///             a frame within the budget.
+class fractal_view_cache {
+public :
+
+    ///
+    /// \brief Grid spacing, in pixels, of the first refinement pass.
+    static const v8_int32_t C_Coarse_Step = 8;
+
+    ///
+    /// \brief Spacing stored for pixels that hold no value yet.
+    static const v8_uint8_t C_No_Sample = 255;
+
+public :
+
+    explicit fractal_view_cache(const fractal_cpu_renderer& renderer);
+
+    ///
+    /// \brief  Moves the cached image to the view described by params and
+    ///         computes missing pixels until budget_ms milliseconds elapsed.
+    /// \param  budget_ms   Time budget, zero or negative to run until the
+    ///                     image is complete.
+    /// \returns    True when every pixel of the view has been computed.
+    bool update(
+        const fractal_params_t&     params,
+        float                       budget_ms,
+        v8::base::job_system*       jobs = nullptr
+        );
+
+    ///
+    /// \brief  Updates the cache (see update) and copies the colors of the
+    ///         view to pixels, within budget_ms milliseconds overall.
+    /// \param  pixels  Output pixels, as bytes R, G, B, A in memory order.
+    bool render(
+        const fractal_params_t&     params,
+        float                       budget_ms,
+        v8_uint8_t*                 pixels,
+        v8_size_t                   pitch,
+        v8::base::job_system*       jobs = nullptr
+        );
+
+    ///
+    /// \brief Drops the cached image, the next update starts over.
+    void invalidate() {
+        valid_ = false;
+    }
+
+    ///
+    /// \brief  Converts all the iteration counts to colors again on the next
+    ///         update, after the renderer's color table changed.
+    void invalidate_colors() {
+        colors_valid_ = false;
+    }
+
+    bool is_complete() const {
+        return valid_ && strips_.empty() && pass_step_ == 0;
+    }
+
+    ///
+    /// \brief  View of the cached image : the parameters of the last update,
+    ///         with the offsets snapped to whole pixels after a pan.
+    const fractal_params_t& get_view() const {
+        return view_;
+    }
+
+    ///
+    /// \brief  Smooth iteration counts, get_view().width values per row.
+    const float* get_values() const {
+        return values_.empty() ? nullptr : &values_[0];
+    }
+
+private :
+
+    struct strip_t {
+        v8_int32_t  st_x0;
+        v8_int32_t  st_y0;
+        v8_int32_t  st_x1;
+        v8_int32_t  st_y1;
+    };
+
+    //
+    // Empties the buffer and restarts the refinement passes.
+    void reset(const fractal_params_t& params);
+
+    //
+    // Shifts the buffer by whole pixels towards the offsets of params.
+    void pan(const fractal_params_t& params);
+
+    //
+    // Resamples the buffer for the zoom factor and offsets of params.
+    void reproject(const fractal_params_t& params, v8::base::job_system* jobs);
+
+    //
+    // Computes the samples (x0 + i * step_x, y0 + j * step_y) of the
+    // [x0, x1) x [y0, y1) region and their colors.
+    void compute_samples(
+        v8_int32_t              x0,
+        v8_int32_t              y0,
+        v8_int32_t              x1,
+        v8_int32_t              y1,
+        v8_int32_t              step_x,
+        v8_int32_t              step_y,
+        v8::base::job_system*   jobs
+        );
+
+    //
+    // Color of the pixels that hold no value yet.
+    v8_uint32_t inside_color() const;
+
+    //
+    // Runs the rows [y0, y1) of the current refinement pass.
+    void refine_rows(v8_int32_t y0, v8_int32_t y1, v8::base::job_system* jobs);
+
+    //
+    // Copies the samples of the grid (x0 + i * step_x, y0 + j * step_y),
+    // and their colors, to the pixels of the step x step blocks they anchor
+    // that hold coarser values.
+    void fill_blocks(
+        v8_int32_t  x0,
+        v8_int32_t  y0,
+        v8_int32_t  y1,
+        v8_int32_t  step_x,
+        v8_int32_t  step_y,
+        v8_int32_t  step
+        );
+
+    const fractal_cpu_renderer&                             renderer_;
+    fractal_params_t                                        view_;
+    bool                                                    valid_;
+    //! Smooth iteration counts.
+    std::vector<float>                                      values_;
+    //! Spacing of the sample each pixel was taken from, 0 if exact.
+    std::vector<v8_uint8_t>                                 spacing_;
+    //! Colors of the values, as bytes R, G, B, A in memory order.
+    std::vector<v8_uint32_t>                                colors_;
+    //! Previous buffers during a reprojection, kept to avoid reallocations.
+    std::vector<float>                                      old_values_;
+    std::vector<v8_uint8_t>                                 old_spacing_;
+    std::vector<v8_uint32_t>                                old_colors_;
+    //! Regions exposed by pans, computed before the refinement passes.
+    std::vector<strip_t>                                    strips_;
+    //! Grid spacing of the current pass, 0 when all passes are done.
+    v8_int32_t                                              pass_step_;
+    //! True for the first pass, that computes its whole grid.
+    bool                                                    pass_is_first_;
+    //! First row of the current pass not computed yet.
+    v8_int32_t                                              pass_row_;
+    //! False when the colors must all be converted again.
+    bool                                                    colors_valid_;
+    //! Duration of the last copy of the colors, in milliseconds.
+    float                                                   copy_ms_;
+
+private :
+    NO_CC_ASSIGN(fractal_view_cache);
+};